@@ -0,0 +1,75 @@
+/// Clustered light data (set = 1)
+/// The view frustum is divided into a grid of clusters, tiles on screen and logarithmic
+/// slices in depth. The light culling pass lists the local lights touching each cluster,
+/// so shading only loops over the lights near the pixel instead of all lights in the scene.
+///
+/// Included by every shader that reads lights, and by the culling pass which writes the
+/// cluster lists. It defines LIGHT_BUFFER_ACCESS before including to make them writable
+#ifndef CLUSTERED_LIGHTS_GLSL
+#define CLUSTERED_LIGHTS_GLSL
+
+#ifndef LIGHT_BUFFER_ACCESS
+#define LIGHT_BUFFER_ACCESS readonly
+#endif
+
+/// Light types, match LightType in light.h
+#define LIGHT_TYPE_DIRECTIONAL 0u
+#define LIGHT_TYPE_POINT 1u
+#define LIGHT_TYPE_SPOT 2u
+
+/// Light data structure matches our C++ LightData struct
+struct Light {
+	vec4 direction;         /// Direction for directional and spot lights (w unused)
+	vec4 colorAndIntensity; /// RGB color and intensity in w
+	vec4 ambient;           /// Ambient color (w unused)
+	vec4 positionAndRange;  /// World position and range of point and spot lights
+	vec4 typeAndCone;       /// Light type, cosine of inner and outer spot cone angle
+};
+
+/// Cluster grid parameters, matches ClusteredLighting::ClusterParams
+layout(set = 1, binding = 0) uniform ClusterParams {
+	mat4 view;
+	mat4 inverseProjection;
+	uvec4 gridSize;             /// Clusters in x, y and z, max lights per cluster in w
+	vec4 depthSlicing;          /// Near plane, far plane, scale and bias of the depth slices
+	vec2 renderExtent;          /// Size of the rendered area in pixels
+	uint directionalLightCount; /// Directional lights come first in the light buffer
+	uint lightCount;
+} clusterParams;
+
+/// All lights of the frame
+layout(std430, set = 1, binding = 1) readonly buffer LightBuffer {
+	Light lights[];
+} lightData;
+
+/// Number of lights in each cluster
+layout(std430, set = 1, binding = 2) LIGHT_BUFFER_ACCESS buffer ClusterBuffer {
+	uint lightCounts[];
+} clusters;
+
+/// Light indices of each cluster, gridSize.w entries per cluster
+layout(std430, set = 1, binding = 3) LIGHT_BUFFER_ACCESS buffer LightIndexBuffer {
+	uint lightIndices[];
+} clusterLights;
+
+/// Find the cluster a pixel belongs to
+/// @param pixel Pixel coordinate inside the rendered area
+/// @param viewDepth Distance from the camera plane, positive in front of the camera
+/// @return Index into the cluster buffers
+uint getClusterIndex(vec2 pixel, float viewDepth) {
+	uvec3 gridSize = clusterParams.gridSize.xyz;
+
+	/// Screen tiles are a fixed fraction of the rendered area, so the grid
+	/// stays valid when dynamic resolution changes the render extent
+	vec2 tile = clamp(floor(pixel / clusterParams.renderExtent * vec2(gridSize.xy)),
+		vec2(0.0), vec2(gridSize.xy) - 1.0);
+
+	/// Slices grow with distance, which keeps clusters roughly cubic in view space
+	float depth = max(viewDepth, clusterParams.depthSlicing.x);
+	float slice = clamp(floor(log(depth) * clusterParams.depthSlicing.z + clusterParams.depthSlicing.w),
+		0.0, float(gridSize.z) - 1.0);
+
+	return uint(tile.x) + uint(tile.y) * gridSize.x + uint(slice) * gridSize.x * gridSize.y;
+}
+
+#endif /// CLUSTERED_LIGHTS_GLSL
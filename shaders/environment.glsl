@@ -0,0 +1,41 @@
+/// Image based lighting from the environment (set = 1)
+/// Baked by EnvironmentLighting: diffuse irradiance as spherical harmonics, specular
+/// light as a cube map prefiltered by roughness and a split-sum BRDF lookup table
+#ifndef ENVIRONMENT_GLSL
+#define ENVIRONMENT_GLSL
+
+#include "sphericalharmonics.glsl"
+
+/// Environment parameters, matches EnvironmentLighting::EnvironmentParams
+layout(set = 1, binding = 6) uniform EnvironmentParams {
+	vec4 irradiance[9]; /// Cosine convolved SH coefficients, rgb
+	vec4 settings;      /// Max mip, intensity, enabled, unused
+} environmentParams;
+
+/// Specular environment, roughness rises linearly across the mips
+layout(set = 1, binding = 7) uniform samplerCube prefilteredEnvironment;
+
+/// Scale (r) and bias (g) of F0, by NdotV (u) and roughness (v)
+layout(set = 1, binding = 8) uniform sampler2D brdfLut;
+
+/// Check if an environment was loaded
+/// Without one, shading falls back to the constant ambient term of the lights
+bool isEnvironmentEnabled() {
+	return environmentParams.settings.z > 0.5;
+}
+
+/// Irradiance arriving at a surface from the whole environment
+/// @param normal Surface normal in world space
+/// @return Irradiance, evaluated from the spherical harmonics without any texture fetch
+vec3 evaluateIrradiance(vec3 normal) {
+	float basis[9];
+	evaluateSHBasis(normal, basis);
+
+	vec3 irradiance = vec3(0.0);
+	for (int i = 0; i < 9; ++i) {
+		irradiance += environmentParams.irradiance[i].rgb * basis[i];
+	}
+	return max(irradiance, vec3(0.0));
+}
+
+#endif /// ENVIRONMENT_GLSL
@@ -0,0 +1,80 @@
+/// Shared functions of the image based lighting bake shaders
+/// Baking runs once per environment in EnvironmentLighting, nothing here is used per frame
+#ifndef IBL_COMMON_GLSL
+#define IBL_COMMON_GLSL
+
+#define IBL_PI 3.14159265359
+
+/// Bake inputs and outputs, not every shader uses every binding
+layout(set = 0, binding = 0) uniform sampler2D sourceEnvironment;
+layout(set = 0, binding = 1, rgba16f) uniform writeonly image2DArray prefilteredMip;
+layout(set = 0, binding = 2, rgba16f) uniform writeonly image2D brdfLutImage;
+layout(std430, set = 0, binding = 3) writeonly buffer IrradianceBuffer {
+	vec4 coefficients[9];
+} irradianceOutput;
+
+/// Matches EnvironmentLighting::BakePushConstants
+layout(push_constant) uniform BakeParams {
+	float roughness;
+	uint outputSize;
+	uint sampleCount;
+	uint sourceWidth;
+} bakeParams;
+
+/// Map a direction to equirectangular coordinates
+/// The top row of the image looks straight up, u wraps around the y axis
+vec2 directionToEquirect(vec3 direction) {
+	float u = atan(direction.z, direction.x) / (2.0 * IBL_PI) + 0.5;
+	float v = acos(clamp(direction.y, -1.0, 1.0)) / IBL_PI;
+	return vec2(u, v);
+}
+
+/// Inverse of directionToEquirect
+vec3 equirectToDirection(vec2 uv) {
+	float phi = (uv.x - 0.5) * 2.0 * IBL_PI;
+	float theta = uv.y * IBL_PI;
+	return vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+}
+
+/// Direction through a texel of a cube map face, following the Vulkan face order and orientation
+vec3 cubeTexelDirection(uvec3 texel, uint faceSize) {
+	vec2 uv = (vec2(texel.xy) + 0.5) / float(faceSize) * 2.0 - 1.0;
+	vec3 direction;
+	switch (texel.z) {
+	case 0u: direction = vec3(1.0, -uv.y, -uv.x); break;
+	case 1u: direction = vec3(-1.0, -uv.y, uv.x); break;
+	case 2u: direction = vec3(uv.x, 1.0, uv.y); break;
+	case 3u: direction = vec3(uv.x, -1.0, -uv.y); break;
+	case 4u: direction = vec3(uv.x, -uv.y, 1.0); break;
+	default: direction = vec3(-uv.x, -uv.y, -1.0); break;
+	}
+	return normalize(direction);
+}
+
+/// Low discrepancy point set, covers the square more evenly than random samples
+vec2 hammersley(uint i, uint count) {
+	uint bits = i;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10);
+}
+
+/// Pick a halfway vector with the GGX distribution around a normal
+vec3 importanceSampleGGX(vec2 xi, vec3 normal, float roughness) {
+	float alpha = roughness * roughness;
+
+	float phi = 2.0 * IBL_PI * xi.x;
+	float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (alpha * alpha - 1.0) * xi.y));
+	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+	vec3 halfway = vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+
+	vec3 up = abs(normal.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+	vec3 tangent = normalize(cross(up, normal));
+	vec3 bitangent = cross(normal, tangent);
+	return normalize(tangent * halfway.x + bitangent * halfway.y + normal * halfway.z);
+}
+
+#endif /// IBL_COMMON_GLSL
@@ -1,13 +1,27 @@
 #version 450
 
+/// Layout of the vertex buffer, matches VertexFormat in C++
+/// 0: Vertex, floats. 1: QuantizedVertex, positions and texture coordinates arrive
+/// as whole numbers and are mapped with the dequantization in the push constants
+layout(constant_id = 1) const uint VertexFormat = 0u;
+
 /// Input vertex attributes
-/// These attributes match the Vertex structure in C++
+/// These attributes match the Vertex structure in C++, and QuantizedVertex after
+/// the fetch converted its integers to floats
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec3 inTangent;      /// Tangent vector for normal mapping
 layout(location = 3) in vec3 inColor;
 layout(location = 4) in vec2 inTexCoord;     /// Texture coordinate input
 
+#ifdef INSTANCED
+/// Per-instance transform relative to the model matrix, matches InstanceTransform in C++
+/// The rows of the upper 3x4 part, the last row is always (0, 0, 0, 1)
+layout(location = 5) in vec4 inInstanceRow0;
+layout(location = 6) in vec4 inInstanceRow1;
+layout(location = 7) in vec4 inInstanceRow2;
+#endif
+
 /// Output to fragment shader
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragNormal;    /// World-space normal
@@ -23,31 +37,37 @@ layout(set = 0, binding = 0) uniform CameraUBO {
 	vec3 cameraPos;        /// Added camera position for view direction calculation
 } camera;
 
-/// Light data structure matches our C++ LightData struct
-struct Light {
-	vec4 direction;         /// Direction vector (w unused)
-	vec4 colorAndIntensity; /// RGB color and intensity in w
-	vec4 ambient;           /// Ambient color (w unused)
-};
-
-/// Light buffer (set = 1)
-/// Separate set allows for efficient light updates
-layout(set = 1, binding = 0) uniform LightBuffer {
-	Light lights[16];  /// Array size matches LightManager::MaxLights
-} lightData;
-
 /// Push constant block for model matrix
 /// We use push constants for the model matrix because:
 /// 1. It changes frequently (per-object)
 /// 2. Small size (single 4x4 matrix)
 /// 3. Fastest way to update shader data
+/// Quantized meshes also push their dequantization, matches MaterialPushConstants in C++
 layout(push_constant) uniform PushConstants {
 	mat4 model;  /// World transform matrix
+	vec4 positionScale;
+	vec4 positionOffset;
+	vec4 texCoordScaleOffset;  /// Scale in xy, offset in zw
 } push;
 
 void main() {
+	/// Map quantized attributes back to object space
+	/// The branch is resolved when the pipeline is created, standard meshes never read
+	/// the dequantization members, so they only push the model matrix
+	vec3 position = inPosition;
+	vec2 texCoord = inTexCoord;
+	if (VertexFormat == 1u) {
+		position = inPosition * push.positionScale.xyz + push.positionOffset.xyz;
+		texCoord = inTexCoord * push.texCoordScaleOffset.xy + push.texCoordScaleOffset.zw;
+	}
+
+	mat4 model = push.model;
+#ifdef INSTANCED
+	model = model * transpose(mat4(inInstanceRow0, inInstanceRow1, inInstanceRow2, vec4(0.0, 0.0, 0.0, 1.0)));
+#endif
+
 	/// Calculate world-space position
-	vec4 worldPos = push.model * vec4(inPosition, 1.0);
+	vec4 worldPos = model * vec4(position, 1.0);
 
 	/// Pass world-space position to fragment shader
 	fragPosition = worldPos.xyz;
@@ -61,7 +81,7 @@ void main() {
 
 	/// Transform normal to world space
 	/// We use the inverse transpose of the model matrix to handle non-uniform scaling
-	mat3 normalMatrix = transpose(inverse(mat3(push.model)));
+	mat3 normalMatrix = transpose(inverse(mat3(model)));
 	vec3 worldNormal = normalize(normalMatrix * inNormal);
 	fragNormal = worldNormal;
 
@@ -89,7 +109,7 @@ void main() {
 	fragColor = inColor;
 
 	/// Pass texture coordinates to fragment shader
-	fragTexCoord = inTexCoord;
+	fragTexCoord = texCoord;
 
 	/// For Reverse-Z, we invert the Z component
 	/// This provides better depth precision
@@ -0,0 +1,305 @@
+/// Shared PBR lighting functions
+/// Included by the forward fragment shader and the visibility buffer compute shader,
+/// so both shading paths produce the same result for the same material
+#ifndef PBR_COMMON_GLSL
+#define PBR_COMMON_GLSL
+
+#include "clusteredlights.glsl"
+#include "shadows.glsl"
+#include "environment.glsl"
+
+/// Define constants used in PBR calculations
+#define PI 3.14159265359
+#define EPSILON 0.0001 /// Small value to prevent division by zero
+
+/// Calculate the Normal Distribution Function using GGX/Trowbridge-Reitz distribution
+/// This models the statistical distribution of microfacets on the surface
+/// @param normal The surface normal
+/// @param halfway The halfway vector between view and light
+/// @param roughness The surface roughness parameter [0,1]
+/// @return The NDF value representing microfacet alignment probability
+float distributionGGX(vec3 normal, vec3 halfway, float roughness) {
+	/// Square the roughness to provide more intuitive artist control
+	/// Linear roughness feels inconsistent at different values, squared provides better visual mapping
+	float alpha = roughness * roughness;
+	float alphaSqr = alpha * alpha;
+
+	/// Calculate how well the halfway vector aligns with the surface normal
+	float NdotH = max(dot(normal, halfway), 0.0);
+	float NdotH2 = NdotH * NdotH;
+
+	/// Compute the GGX distribution
+	/// This gives the statistical probability that microfacets are oriented along the halfway vector
+	/// The denominator creates the characteristic "long tail" of GGX highlights
+	float denominator = (NdotH2 * (alphaSqr - 1.0) + 1.0);
+	denominator = PI * denominator * denominator;
+
+	/// Return the normalized distribution value
+	/// We add an epsilon to prevent division by zero for perfectly smooth surfaces
+	return alphaSqr / max(denominator, EPSILON);
+}
+
+/// Calculate the Schlick-GGX Geometry Function for a single vector
+/// This computes self-shadowing from microfacets along one direction (view or light)
+/// @param NdotX Dot product between normal and the direction vector
+/// @param roughness The surface roughness parameter [0,1]
+/// @return Geometry term for the given direction
+float geometrySchlickGGX(float NdotX, float roughness) {
+	/// Remapping roughness for the geometry term
+	/// For direct lighting, we use this remapping to account for the different behavior
+	/// of geometry shadowing compared to the normal distribution function
+	float r = (roughness + 1.0);
+	float k = (r * r) / 8.0;
+
+	/// Calculate the shadowing term
+	/// This represents how much light is blocked by microfacets
+	/// Higher roughness values lead to more self-shadowing
+	float numerator = NdotX;
+	float denominator = NdotX * (1.0 - k) + k;
+
+	/// Return the geometry term
+	/// Clamped to prevent division by zero
+	return numerator / max(denominator, EPSILON);
+}
+
+/// Calculate the Smith model for combined geometry shadowing/masking
+/// The Smith model combines shadowing from both view and light directions
+/// @param normal The surface normal
+/// @param view The view direction
+/// @param light The light direction
+/// @param roughness The surface roughness parameter [0,1]
+/// @return Combined geometry term for both directions
+float geometrySmith(vec3 normal, vec3 view, vec3 light, float roughness) {
+	/// Calculate geometry term for both directions
+	/// We compute how much light is obscured for both the incoming and outgoing directions
+	float NdotV = max(dot(normal, view), 0.0);
+	float NdotL = max(dot(normal, light), 0.0);
+
+	/// Use Schlick-GGX approximation for each direction
+	float ggx1 = geometrySchlickGGX(NdotV, roughness);
+	float ggx2 = geometrySchlickGGX(NdotL, roughness);
+
+	/// Combine terms using Smith method
+	/// The combined term handles correlations between viewing and light directions
+	return ggx1 * ggx2;
+}
+
+/// Calculate Fresnel reflectance using Schlick's approximation
+/// This determines how much light is reflected vs. refracted based on view angle
+/// @param cosTheta Cosine of angle between halfway vector and view direction
+/// @param F0 Surface reflection at zero incidence (straight-on viewing angle)
+/// @return The Fresnel reflectance
+vec3 fresnelSchlick(float cosTheta, vec3 F0) {
+	/// Schlick's approximation to Fresnel equation
+	/// This is a simple but effective approximation to the full Fresnel equations
+	/// At grazing angles (cosTheta near 0), all surfaces approach 100% reflectivity
+	return F0 + (1.0 - F0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
+}
+
+/// Evaluate the Cook-Torrance BRDF for light arriving from one direction
+/// @param lightDir Normalized direction from the surface toward the light
+/// @param radiance Incoming light color scaled by intensity and attenuation
+/// @param normal Surface normal in world space
+/// @param albedo Surface base color
+/// @param viewDir View direction (normalized vector toward camera)
+/// @param roughness Surface roughness (controls microfacet distribution)
+/// @param metallic Surface metalness (controls specular response)
+/// @return Reflected light including diffuse and specular components
+vec3 evaluateBRDF(vec3 lightDir, vec3 radiance, vec3 normal, vec3 albedo, vec3 viewDir, float roughness, float metallic) {
+	/// Calculate essential dot products used throughout the BRDF
+	float NdotL = max(dot(normal, lightDir), 0.0);
+	float NdotV = max(dot(normal, viewDir), EPSILON); /// Using small epsilon to prevent divide-by-zero
+
+	/// Early exit for surfaces facing away from the light source
+	/// This optimization skips expensive calculations when the surface can't directly see the light
+	if (NdotL <= 0.0) {
+		return vec3(0.0);
+	}
+
+	/// Calculate the halfway vector between view and light directions
+	/// The halfway vector represents the surface normal that would perfectly reflect light to the viewer
+	vec3 halfwayVector = normalize(lightDir + viewDir);
+	float HdotV = max(dot(halfwayVector, viewDir), 0.0);
+
+	/// Define the surface's specular color (F0)
+	/// For dielectrics (non-metals), this is a constant 0.04
+	/// For metals, we use the albedo color itself, controlled by metallic parameter
+	vec3 F0 = vec3(0.04);
+	F0 = mix(F0, albedo, metallic);
+
+	/// Calculate the three components of the Cook-Torrance BRDF:
+	/// 1. Normal Distribution Function (D) - Statistical distribution of microfacets
+	float D = distributionGGX(normal, halfwayVector, roughness);
+
+	/// 2. Fresnel Term (F) - Reflectivity that varies with viewing angle
+	vec3 F = fresnelSchlick(HdotV, F0);
+
+	/// 3. Geometry Term (G) - Self-shadowing of microfacets
+	float G = geometrySmith(normal, viewDir, lightDir, roughness);
+
+	/// Calculate the Cook-Torrance specular BRDF
+	/// The complete specular BRDF consists of the distribution, fresnel, and geometry terms
+	/// divided by the normalization factor (4 * NdotV * NdotL)
+	vec3 specular = (D * G * F) / max(4.0 * NdotV * NdotL, EPSILON);
+
+	/// Calculate the diffuse component using Lambert
+	/// Lambert diffuse is simple but effective for most non-specialized materials
+	/// Normalized by PI to ensure energy conservation
+	vec3 diffuse = albedo / PI;
+
+	/// Apply energy conservation
+	/// As surfaces become more reflective (higher F) or more metallic,
+	/// the diffuse component should decrease to conserve energy
+	vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+
+	/// Combine diffuse and specular components, modulated by light properties
+	/// Scale by NdotL to account for light incident angle
+	return (kD * diffuse + specular) * radiance * NdotL;
+}
+
+/// Fresnel for light from all directions of the environment
+/// Rough surfaces reflect less at grazing angles, since their microfacets mostly don't face the viewer
+/// @param cosTheta Cosine of angle between normal and view direction
+/// @param F0 Surface reflection at zero incidence
+/// @param roughness Surface roughness
+/// @return The Fresnel reflectance
+vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
+	return F0 + (max(vec3(1.0 - roughness), F0) - F0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
+}
+
+/// Calculate the light reflected from the environment
+/// Diffuse light comes from the irradiance harmonics, specular light from the prefiltered
+/// environment and the split-sum lookup table, which are the only two texture fetches
+/// @param normal Surface normal in world space
+/// @param albedo Surface base color
+/// @param viewDir View direction (normalized vector toward camera)
+/// @param roughness Surface roughness
+/// @param metallic Surface metalness
+/// @return Environment light including diffuse and specular components
+vec3 evaluateEnvironment(vec3 normal, vec3 albedo, vec3 viewDir, float roughness, float metallic) {
+	float NdotV = max(dot(normal, viewDir), EPSILON);
+
+	vec3 F0 = mix(vec3(0.04), albedo, metallic);
+	vec3 F = fresnelSchlickRoughness(NdotV, F0, roughness);
+	vec3 kD = (vec3(1.0) - F) * (1.0 - metallic);
+
+	vec3 diffuse = evaluateIrradiance(normal) * albedo / PI;
+
+	vec3 reflection = reflect(-viewDir, normal);
+	float maxMip = environmentParams.settings.x;
+	vec3 prefiltered = textureLod(prefilteredEnvironment, reflection, roughness * maxMip).rgb;
+	/// Explicit lod, this also runs in the visibility buffer compute shader
+	vec2 brdf = textureLod(brdfLut, vec2(NdotV, roughness), 0.0).rg;
+	vec3 specular = prefiltered * (F0 * brdf.x + brdf.y);
+
+	return (kD * diffuse + specular) * environmentParams.settings.y;
+}
+
+/// Calculate contribution from a single directional light using Cook-Torrance BRDF
+/// This function implements physically-based lighting using the Cook-Torrance microfacet BRDF
+/// @param light The light source data (direction, color, intensity)
+/// @param normal Surface normal in world space
+/// @param albedo Surface base color
+/// @param viewDir View direction (normalized vector toward camera)
+/// @param roughness Surface roughness (controls microfacet distribution)
+/// @param metallic Surface metalness (controls specular response)
+/// @param shadow Fraction of the light reaching the surface
+/// @return Final lit color including diffuse and specular components
+vec3 calculateDirectionalLight(Light light, vec3 normal, vec3 albedo, vec3 viewDir, float roughness, float metallic,
+	float shadow) {
+	/// Extract light properties from the light structure
+	vec3 lightDir = -normalize(light.direction.xyz);
+	vec3 radiance = light.colorAndIntensity.rgb * light.colorAndIntensity.a * shadow;
+
+	/// Ambient light is added once for all directional lights in evaluateLights,
+	/// where image based lighting can replace it
+	return evaluateBRDF(lightDir, radiance, normal, albedo, viewDir, roughness, metallic);
+}
+
+/// Calculate contribution from a point or spot light
+/// @param light The light source data (position, range, color, cone)
+/// @param worldPos Surface position in world space
+/// @param normal Surface normal in world space
+/// @param albedo Surface base color
+/// @param viewDir View direction (normalized vector toward camera)
+/// @param roughness Surface roughness (controls microfacet distribution)
+/// @param metallic Surface metalness (controls specular response)
+/// @return Final lit color including diffuse and specular components
+vec3 calculateLocalLight(Light light, vec3 worldPos, vec3 normal, vec3 albedo, vec3 viewDir, float roughness, float metallic) {
+	vec3 toLight = light.positionAndRange.xyz - worldPos;
+	float lightDistance = length(toLight);
+	float range = light.positionAndRange.w;
+
+	/// The culling pass works with bounding volumes, so some lights in the list don't reach us
+	if (lightDistance >= range) {
+		return vec3(0.0);
+	}
+
+	vec3 lightDir = toLight / max(lightDistance, EPSILON);
+
+	/// Inverse square falloff, windowed so it reaches exactly zero at the range
+	/// Without the window, cutting the light off at its range would leave a visible edge
+	float ratio = lightDistance / range;
+	float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);
+	float attenuation = window * window / (lightDistance * lightDistance + 1.0);
+
+	/// Smooth fade between inner and outer cone
+	if (uint(light.typeAndCone.x + 0.5) == LIGHT_TYPE_SPOT) {
+		float cosAngle = dot(-lightDir, normalize(light.direction.xyz));
+		attenuation *= smoothstep(light.typeAndCone.z, light.typeAndCone.y, cosAngle);
+	}
+
+	vec3 radiance = light.colorAndIntensity.rgb * light.colorAndIntensity.a * attenuation;
+
+	return evaluateBRDF(lightDir, radiance, normal, albedo, viewDir, roughness, metallic)
+		+ albedo * light.ambient.rgb * attenuation;
+}
+
+/// Accumulate the lighting from all lights affecting a pixel
+/// Directional lights are evaluated everywhere, point and spot lights only
+/// if the culling pass listed them for the pixel's cluster
+/// @param pixel Pixel coordinate inside the rendered area
+/// @param worldPos Surface position in world space
+/// @param normal Surface normal in world space
+/// @param albedo Surface base color
+/// @param viewDir View direction (normalized vector toward camera)
+/// @param roughness Surface roughness
+/// @param metallic Surface metalness
+/// @return Sum of all light contributions
+vec3 evaluateLights(vec2 pixel, vec3 worldPos, vec3 normal, vec3 albedo, vec3 viewDir, float roughness, float metallic) {
+	vec3 color = vec3(0.0);
+	vec3 ambient = vec3(0.0);
+	float viewDepth = -(clusterParams.view * vec4(worldPos, 1.0)).z;
+
+	for (uint i = 0u; i < clusterParams.directionalLightCount; ++i) {
+		/// Only process lights with non-zero intensity
+		if (lightData.lights[i].colorAndIntensity.a > 0.0) {
+			/// Only the primary light casts shadows
+			float shadow = i == 0u ? calculateShadow(worldPos, normal, viewDepth) : 1.0;
+			color += calculateDirectionalLight(lightData.lights[i], normal, albedo, viewDir, roughness, metallic,
+				shadow);
+			ambient += lightData.lights[i].ambient.rgb;
+		}
+	}
+
+	/// The environment is the ambient light, if there is one
+	/// Otherwise a constant ambient term provides a base level of illumination
+	if (isEnvironmentEnabled()) {
+		color += evaluateEnvironment(normal, albedo, viewDir, roughness, metallic);
+	} else {
+		color += albedo * ambient;
+	}
+
+	uint clusterIndex = getClusterIndex(pixel, viewDepth);
+	uint lightCount = clusters.lightCounts[clusterIndex];
+	uint firstIndex = clusterIndex * clusterParams.gridSize.w;
+
+	for (uint i = 0u; i < lightCount; ++i) {
+		uint lightIndex = clusterLights.lightIndices[firstIndex + i];
+		color += calculateLocalLight(lightData.lights[lightIndex], worldPos, normal, albedo, viewDir, roughness, metallic);
+	}
+
+	return color;
+}
+
+#endif /// PBR_COMMON_GLSL
@@ -0,0 +1,42 @@
+#version 450
+
+/// Shadow map pass for the cascades of the primary directional light
+/// Depth only, there is no fragment shader. The binding still uses the full Vertex
+/// stride, so the regular vertex buffers work as-is
+
+/// Layout of the vertex buffer, matches VertexFormat in C++, 1 for QuantizedVertex
+layout(constant_id = 1) const uint VertexFormat = 0u;
+
+layout(location = 0) in vec3 inPosition;
+
+#ifdef INSTANCED
+/// Per-instance transform rows, matches InstanceTransform in C++
+layout(location = 5) in vec4 inInstanceRow0;
+layout(location = 6) in vec4 inInstanceRow1;
+layout(location = 7) in vec4 inInstanceRow2;
+#endif
+
+/// Light view-projection premultiplied with the model matrix on the CPU
+/// Quantized meshes also push how their positions are dequantized
+layout(push_constant) uniform PushConstants {
+	mat4 lightModelViewProj;
+	vec4 positionScale;
+	vec4 positionOffset;
+} push;
+
+void main() {
+	vec3 position = inPosition;
+	if (VertexFormat == 1u) {
+		position = inPosition * push.positionScale.xyz + push.positionOffset.xyz;
+	}
+
+	vec4 modelPosition = vec4(position, 1.0);
+#ifdef INSTANCED
+	/// Instances are placed relative to the model, inside the premultiplied matrix
+	modelPosition = transpose(mat4(inInstanceRow0, inInstanceRow1, inInstanceRow2, vec4(0.0, 0.0, 0.0, 1.0)))
+		* modelPosition;
+#endif
+
+	/// Shadow maps use regular [0,1] depth, the orthographic projection already maps to it
+	gl_Position = push.lightModelViewProj * modelPosition;
+}
@@ -0,0 +1,64 @@
+/// Cascaded shadows of the primary directional light (set = 1)
+/// The first directional light in the light buffer casts shadows. Its cascades are
+/// rendered by ShadowCascades, each into one layer of the shadow map array
+#ifndef SHADOWS_GLSL
+#define SHADOWS_GLSL
+
+/// Number of cascades, matches ShadowCascades::CascadeCount
+#define SHADOW_CASCADE_COUNT 4
+
+/// Shadow parameters, matches ShadowCascades::ShadowParams
+layout(set = 1, binding = 4) uniform ShadowParams {
+	mat4 cascadeViewProj[SHADOW_CASCADE_COUNT];
+	vec4 cascadeSplits;     /// View depth where each cascade ends
+	vec4 cascadeTexelSizes; /// World size of one shadow map texel per cascade
+	vec4 settings;          /// 1 / resolution, normal offset in texels, fade start, enabled
+} shadowParams;
+
+/// Depth comparison sampler, returns how much of the footprint is lit
+layout(set = 1, binding = 5) uniform sampler2DArrayShadow shadowMap;
+
+/// Calculate how much of the primary light reaches a surface
+/// @param worldPos Surface position in world space
+/// @param normal Surface normal in world space
+/// @param viewDepth Distance from the camera plane, positive in front of the camera
+/// @return 1 for fully lit, 0 for fully shadowed
+float calculateShadow(vec3 worldPos, vec3 normal, float viewDepth) {
+	if (shadowParams.settings.w < 0.5 || viewDepth >= shadowParams.cascadeSplits[SHADOW_CASCADE_COUNT - 1]) {
+		return 1.0;
+	}
+
+	/// Pick the first cascade that reaches past this depth
+	int cascade = SHADOW_CASCADE_COUNT - 1;
+	for (int i = 0; i < SHADOW_CASCADE_COUNT - 1; ++i) {
+		if (viewDepth < shadowParams.cascadeSplits[i]) {
+			cascade = i;
+			break;
+		}
+	}
+
+	/// Offsetting along the normal by a few texels moves the lookup out of the surface,
+	/// which removes acne where the depth bias alone isn't enough
+	vec3 offsetPos = worldPos + normal * shadowParams.cascadeTexelSizes[cascade] * shadowParams.settings.y;
+	vec4 shadowCoord = shadowParams.cascadeViewProj[cascade] * vec4(offsetPos, 1.0);
+	shadowCoord.xyz /= shadowCoord.w;
+	vec2 uv = shadowCoord.xy * 0.5 + 0.5;
+
+	/// 3x3 PCF, every tap is already a bilinear blend of four comparisons
+	float texelSize = shadowParams.settings.x;
+	float lit = 0.0;
+	for (int y = -1; y <= 1; ++y) {
+		for (int x = -1; x <= 1; ++x) {
+			vec2 offset = vec2(x, y) * texelSize;
+			lit += texture(shadowMap, vec4(uv + offset, float(cascade), shadowCoord.z));
+		}
+	}
+	lit /= 9.0;
+
+	/// Fade out towards the shadow distance instead of ending at a visible line
+	float shadowDistance = shadowParams.cascadeSplits[SHADOW_CASCADE_COUNT - 1];
+	float fade = smoothstep(shadowDistance * shadowParams.settings.z, shadowDistance, viewDepth);
+	return mix(lit, 1.0, fade);
+}
+
+#endif /// SHADOWS_GLSL
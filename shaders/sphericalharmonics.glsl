@@ -0,0 +1,25 @@
+/// Real spherical harmonics up to band 2
+/// Shared by the irradiance bake and shading, which must agree on the basis
+#ifndef SPHERICAL_HARMONICS_GLSL
+#define SPHERICAL_HARMONICS_GLSL
+
+/// Evaluate the 9 basis functions for a direction
+/// @param direction Normalized direction
+/// @param basis Basis values, band 0 first
+void evaluateSHBasis(vec3 direction, out float basis[9]) {
+	float x = direction.x;
+	float y = direction.y;
+	float z = direction.z;
+
+	basis[0] = 0.282095;
+	basis[1] = 0.488603 * y;
+	basis[2] = 0.488603 * z;
+	basis[3] = 0.488603 * x;
+	basis[4] = 1.092548 * x * y;
+	basis[5] = 1.092548 * y * z;
+	basis[6] = 0.315392 * (3.0 * z * z - 1.0);
+	basis[7] = 1.092548 * x * z;
+	basis[8] = 0.546274 * (x * x - y * y);
+}
+
+#endif /// SPHERICAL_HARMONICS_GLSL
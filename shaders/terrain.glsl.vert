@@ -1,16 +1,21 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "terraincommon.glsl"
 
 /// Input vertex attributes that match our Vertex structure in C++
-/// The vertex data is already displaced by PlanetGenerator - we just pass it through
+/// Only the direction of the position is used, any sphere around the origin works.
+/// Elevation and normals come from the baked surface instead
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec3 inColor;    /// R channel contains height data (R8 format)
+layout(location = 2) in vec3 inColor;
 
 /// Output to fragment shader
 layout(location = 0) out vec3 fragPosition;  /// World-space position for later use
 layout(location = 1) out vec3 fragNormal;    /// World-space normal for lighting
 layout(location = 2) out float fragHeight;   /// Normalized height for biome selection
 layout(location = 3) out float fragSteepness; /// Terrain steepness (0 = flat, 1 = vertical)
+layout(location = 4) out vec3 fragDirection;  /// Object space direction for baked field lookups
 
 
 /// Camera uniform buffer (set = 0)
@@ -20,19 +25,6 @@ layout(set = 0, binding = 0) uniform CameraUBO {
 	mat4 proj;
 } camera;
 
-/// Light data structure matches our C++ LightData struct
-struct Light {
-	vec4 direction;         /// Direction vector (w unused)
-	vec4 colorAndIntensity; /// RGB color and intensity in w
-	vec4 ambient;          /// Ambient color (w unused)
-};
-
-/// Light buffer (set = 1)
-/// Separate set allows for efficient light updates
-layout(set = 1, binding = 0) uniform LightBuffer {
-	Light lights[16];       /// Array size matches LightManager::MaxLights
-} lightData;
-
 /// Push constant block for model matrix
 /// We use push constants for the model matrix because:
 /// 1. It changes frequently (per-object)
@@ -43,30 +35,35 @@ layout(push_constant) uniform PushConstants {
 } push;
 
 void main() {
+	/// Displace the sphere by the baked elevation
+	/// We sample the top mip, the mesh is coarser than the field anyway
+	vec3 direction = normalize(inPosition);
+	vec4 surface = textureLod(terrainSurface, direction, 0.0);
+	float radius = material.planetRadius * (1.0 + surface.a * material.heightScale);
+
 	/// Calculate world-space position
-	vec4 worldPos = push.model * vec4(inPosition, 1.0);
+	vec4 worldPos = push.model * vec4(direction * radius, 1.0);
 
 	/// Pass world-space position to fragment shader
 	fragPosition = worldPos.xyz;
+	fragDirection = direction;
 
-	/// Transform normal to world space and normalize
+	/// Transform the baked normal to world space and normalize
 	/// We use the inverse transpose of the model matrix to handle non-uniform scaling
 	mat3 normalMatrix = transpose(inverse(mat3(push.model)));
-	fragNormal = normalize(normalMatrix * inNormal);
+	vec3 normal = terrainNormal(surface, direction);
+	fragNormal = normalize(normalMatrix * normal);
 
 	/// Calculate steepness from the normal
-	/// We compare the normal to the "up" direction of the planet (normalized position)
+	/// We compare the normal to the "up" direction of the planet, both in object space
 	/// A dot product of 1 means flat terrain, 0 means vertical cliff
-	vec3 up = normalize(inPosition.xyz);
-	float alignment = abs(dot(fragNormal, up));
+	float alignment = abs(dot(normal, direction));
 	/// Convert alignment to steepness (1 - alignment gives us 0 for flat, 1 for vertical)
 	/// Tweaking factor in the end
 	fragSteepness = (1.0 - alignment) * 0.8;
 
-	/// Extract height from vertex color's red channel
-	/// For now, we use R8 format (0-255 mapped to 0-1)
-	/// TODO: Later upgrade to R16_SFLOAT for better precision
-	fragHeight = inColor.r;
+	/// Normalized elevation, the range the biome heights refer to
+	fragHeight = surface.a;
 
 	/// Transform vertex position to clip space
 	gl_Position = camera.proj * camera.view * worldPos;
@@ -74,4 +71,4 @@ void main() {
 	/// For Reverse-Z, we invert the Z component
 	/// This provides better depth precision
 	gl_Position.z = (gl_Position.z + gl_Position.w) / 2.0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,86 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "terraincommon.glsl"
+
+/// Quads along each edge of the shared patch, matches TerrainQuadtree::GridResolution
+const float GRID_RESOLUTION = 32.0;
+
+/// Grid coordinate of the patch vertex, 0 to 1 across the node
+layout(location = 0) in vec3 inGrid;
+
+/// Per-instance node parameters, see TerrainQuadtree::NodeInstance
+layout(location = 1) in vec4 inNode;   /// Face coordinates of the node's corner, size, face
+layout(location = 2) in vec4 inMorph;  /// Distance where morphing starts and ends
+
+/// Output to fragment shader, the same as terrain.glsl.vert
+layout(location = 0) out vec3 fragPosition;
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out float fragHeight;
+layout(location = 3) out float fragSteepness;
+layout(location = 4) out vec3 fragDirection;
+
+layout(set = 0, binding = 0) uniform CameraUBO {
+	mat4 view;
+	mat4 proj;
+	vec3 position;
+} camera;
+
+layout(push_constant) uniform PushConstants {
+	mat4 model;
+} push;
+
+/// Direction through a point of a cube face, matches TerrainBaker::cubeFaceDirection
+vec3 cubeFaceDirection(uint face, vec2 uv) {
+	switch (face) {
+	case 0u: return vec3(1.0, -uv.y, -uv.x);
+	case 1u: return vec3(-1.0, -uv.y, uv.x);
+	case 2u: return vec3(uv.x, 1.0, uv.y);
+	case 3u: return vec3(uv.x, -1.0, -uv.y);
+	case 4u: return vec3(uv.x, -uv.y, 1.0);
+	default: return vec3(-uv.x, -uv.y, -1.0);
+	}
+}
+
+/// Object space direction of a grid coordinate of this node
+vec3 gridDirection(vec2 grid) {
+	vec2 uv = inNode.xy + grid * inNode.z;
+	return normalize(cubeFaceDirection(uint(inNode.w), uv));
+}
+
+void main() {
+	/// Distance of the unmorphed vertex decides how far it morphs
+	/// Vertices shared with a neighbouring node see the same distance and end up in the same place
+	vec3 direction = gridDirection(inGrid.xy);
+	vec4 surface = textureLod(terrainSurface, direction, 0.0);
+	vec3 position = direction * material.planetRadius * (1.0 + surface.a * material.heightScale);
+	float distanceToCamera = distance((push.model * vec4(position, 1.0)).xyz, camera.position);
+	float morph = clamp((distanceToCamera - inMorph.x) / (inMorph.y - inMorph.x), 0.0, 1.0);
+
+	/// Move odd vertices onto their even neighbour, fully morphed the patch has half resolution
+	/// and matches its parent and any coarser neighbour along the shared edge
+	vec2 gridPosition = inGrid.xy * GRID_RESOLUTION;
+	vec2 morphedGrid = (gridPosition - fract(gridPosition * 0.5) * 2.0 * morph) / GRID_RESOLUTION;
+
+	direction = gridDirection(morphedGrid);
+	surface = textureLod(terrainSurface, direction, 0.0);
+	float radius = material.planetRadius * (1.0 + surface.a * material.heightScale);
+
+	vec4 worldPos = push.model * vec4(direction * radius, 1.0);
+	fragPosition = worldPos.xyz;
+	fragDirection = direction;
+
+	mat3 normalMatrix = transpose(inverse(mat3(push.model)));
+	vec3 normal = terrainNormal(surface, direction);
+	fragNormal = normalize(normalMatrix * normal);
+
+	/// Steepness and height as in terrain.glsl.vert
+	float alignment = abs(dot(normal, direction));
+	fragSteepness = (1.0 - alignment) * 0.8;
+	fragHeight = surface.a;
+
+	gl_Position = camera.proj * camera.view * worldPos;
+
+	/// Reverse-Z, as in the other scene vertex shaders
+	gl_Position.z = (gl_Position.z + gl_Position.w) / 2.0;
+}
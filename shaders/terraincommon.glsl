@@ -0,0 +1,67 @@
+/// Terrain material declarations shared by the terrain vertex and fragment shaders (set = 2)
+/// Layouts match TerrainMaterial::Properties (std140)
+#ifndef TERRAINCOMMON_GLSL
+#define TERRAINCOMMON_GLSL
+
+/// Noise parameters for controlling noise generation
+/// These match the CPU-side NoiseParameters structure
+struct NoiseParams {
+	float baseFrequency;       /// Base frequency for noise sampling
+	float amplitude;           /// Overall strength of noise effect
+	uint octaves;             /// Number of noise layers to combine
+	float persistence;        /// How quickly amplitude decreases per octave
+	float lacunarity;         /// How quickly frequency increases per octave
+	float padding1;
+	float padding2;
+	float padding3;
+};
+
+/// Parameters controlling the transition between biomes
+struct TransitionParams {
+	uint type;           /// Type of transition function to use (simplex, Worley)
+	float scale;         /// Scale of the noise pattern
+	float transitionSharpness;  /// Controls edge sharpness of noise boundaries (0: soft blend, 1: sharp cutoff)
+	NoiseParams noise;   /// Base noise parameters for the transition
+};
+
+/// Update biome parameters structure to match C++ definition
+struct BiomeParameters {
+	vec4 color;           /// Base color of the biome
+	vec4 cliffColor;      /// Color for steep areas
+	float minHeight;      /// Height where biome starts
+	float maxHeight;      /// Height where biome ends
+	float maxSteepness;   /// Maximum steepness where biome appears
+	float cliffThreshold; /// When to start blending cliff material
+	float roughness;      /// Base surface roughness
+	float cliffRoughness; /// Roughness for cliff areas
+	float metallic;       /// Base metallic value
+	float cliffMetallic;  /// Metallic value for cliff areas
+	NoiseParams noise;    /// Noise settings for this biome
+	uint biomeId;         /// Unique number to identify each biome
+	float padding0;
+	float padding1;
+	float padding2;
+	TransitionParams transition;
+};
+
+/// Terrain material properties buffer matches CPU struct
+layout(set = 2, binding = 0) uniform TerrainMaterialUBO {
+	BiomeParameters biomes[4];  /// Array of biome definitions
+	float planetRadius;         /// Base radius for calculations
+	uint numBiomes;             /// Number of active biomes
+	uint debugMode;             /// Current debug visualization mode
+	float heightScale;          /// Highest elevation as a fraction of the radius
+} material;
+
+/// Surface baked by TerrainBaker, sampled by direction from the planet center
+/// Object space normal in rgb, normalized elevation in a
+layout(set = 2, binding = 1) uniform samplerCube terrainSurface;
+
+/// Normal of a surface sample
+/// Chunks that haven't been streamed in yet hold a zero normal, there we fall back
+/// to the sphere's. Filtering across the edge of such a chunk shortens the normal
+vec3 terrainNormal(vec4 surface, vec3 direction) {
+	return dot(surface.xyz, surface.xyz) > 0.25 ? normalize(surface.xyz) : direction;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#version 450
+
+/// Input from vertex shader
+layout(location = 0) in vec2 fragUV;
+
+/// Output color
+layout(location = 0) out vec4 outColor;
+
+/// Scene image rendered at reduced resolution (set = 0)
+layout(set = 0, binding = 0) uniform sampler2D sceneColor;
+
+/// Push constants describing which part of the scene image holds the frame
+layout(push_constant) uniform PushConstants {
+	vec2 uvScale;          /// Rendered part of the source relative to its full size
+	vec2 sourceTexelSize;  /// Size of one source texel in UV units
+	vec2 maxUv;            /// Upper clamp, half a texel inside the rendered part
+	float sharpness;       /// 0 = bilinear only, 1 = strongest sharpening
+	float padding;
+} push;
+
+/// Sample the scene without leaving the rendered part of the image
+vec3 sampleScene(vec2 uv) {
+	return texture(sceneColor, clamp(uv, push.sourceTexelSize * 0.5, push.maxUv)).rgb;
+}
+
+void main() {
+	/// Bilinear upscale of the center sample
+	vec2 uv = fragUV * push.uvScale;
+	vec3 center = sampleScene(uv);
+
+	/// Cross-shaped neighborhood one source texel away
+	vec3 north = sampleScene(uv - vec2(0.0, push.sourceTexelSize.y));
+	vec3 south = sampleScene(uv + vec2(0.0, push.sourceTexelSize.y));
+	vec3 west = sampleScene(uv - vec2(push.sourceTexelSize.x, 0.0));
+	vec3 east = sampleScene(uv + vec2(push.sourceTexelSize.x, 0.0));
+
+	/// Contrast-adaptive sharpening
+	/// We measure how close the neighborhood gets to black or white. Low-contrast areas
+	/// have plenty of room and get the full sharpening, while high-contrast edges get
+	/// almost none, so they don't overshoot into visible halos
+	vec3 minRGB = min(center, min(min(north, south), min(west, east)));
+	vec3 maxRGB = max(center, max(max(north, south), max(west, east)));
+	vec3 amplitude = clamp(min(minRGB, 1.0 - maxRGB) / max(maxRGB, vec3(1e-5)), 0.0, 1.0);
+	amplitude = sqrt(amplitude);
+
+	/// Negative lobe weight, between -1/8 (soft) and -1/5 (strong)
+	float peak = -1.0 / mix(8.0, 5.0, push.sharpness);
+	vec3 weight = amplitude * peak * step(0.001, push.sharpness);
+
+	vec3 sharpened = (center + (north + south + west + east) * weight) / (1.0 + 4.0 * weight);
+	outColor = vec4(clamp(sharpened, 0.0, 1.0), 1.0);
+}
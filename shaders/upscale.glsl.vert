@@ -0,0 +1,14 @@
+#version 450
+
+/// Output to fragment shader
+/// UV across the swap chain image, [0,1] in both directions
+layout(location = 0) out vec2 fragUV;
+
+void main() {
+	/// Generate one triangle that covers the whole screen from the vertex index
+	/// Vertices 0, 1, 2 map to UVs (0,0), (2,0), (0,2); the parts outside
+	/// the screen get clipped, which is cheaper than two triangles meeting on the diagonal
+	vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	fragUV = uv;
+	gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,19 @@
+#version 450
+
+/// Visibility buffer resources (set = 0), bindings match visibilitycommon.glsl
+layout(set = 0, binding = 0, rg32ui) uniform readonly uimage2D visibilityImage;
+layout(set = 0, binding = 1, rgba16f) uniform readonly image2D shadedImage;
+
+/// Color for pixels no visibility buffer geometry covers
+layout(push_constant) uniform PushConstants {
+	vec4 clearColor;
+} push;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+	/// The targets share the scene's pixel grid, so we read them 1:1 without a sampler
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	uint drawId = imageLoad(visibilityImage, pixel).x;
+	outColor = drawId == 0u ? push.clearColor : imageLoad(shadedImage, pixel);
+}
@@ -0,0 +1,15 @@
+#version 450
+
+/// Push constants shared with the vertex shader
+layout(push_constant) uniform PushConstants {
+	mat4 model;
+	uint drawIndex;
+} push;
+
+/// Visibility ID: draw index + 1 (0 means no geometry) and triangle index
+layout(location = 0) out uvec2 outVisibility;
+
+void main() {
+	/// No attributes, no textures, no lighting: overdraw only costs this write
+	outVisibility = uvec2(push.drawIndex + 1u, uint(gl_PrimitiveID));
+}
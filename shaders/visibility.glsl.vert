@@ -0,0 +1,28 @@
+#version 450
+
+/// Only the position is needed to rasterize triangle IDs
+/// The binding still uses the full Vertex stride, so the regular vertex buffers work as-is
+layout(location = 0) in vec3 inPosition;
+
+/// Camera uniform buffer (set = 0)
+layout(set = 0, binding = 0) uniform CameraUBO {
+	mat4 view;
+	mat4 proj;
+	vec3 cameraPos;
+} camera;
+
+/// Push constants shared with the fragment shader
+/// drawIndex points into the draw table the compute passes read
+layout(push_constant) uniform PushConstants {
+	mat4 model;
+	uint drawIndex;
+} push;
+
+void main() {
+	/// Same transform order as pbr.glsl.vert, so depth matches the forward path
+	vec4 worldPos = push.model * vec4(inPosition, 1.0);
+	gl_Position = camera.proj * camera.view * worldPos;
+
+	/// Reverse-Z, see pbr.glsl.vert
+	gl_Position.z = (gl_Position.z + gl_Position.w) / 2.0;
+}
@@ -0,0 +1,87 @@
+/// Shared declarations of the visibility buffer compute passes
+/// The including shader picks the descriptor set index by defining VISIBILITY_SET first.
+/// Bindings match VisibilityBuffer::createDescriptorResources
+#ifndef VISIBILITY_COMMON_GLSL
+#define VISIBILITY_COMMON_GLSL
+
+#ifndef VISIBILITY_SET
+#define VISIBILITY_SET 0
+#endif
+
+/// Matches VisibilityBuffer::MaxMaterialBins
+const uint MaxMaterialBins = 256u;
+
+/// Matches VisibilityBuffer::ShadeGroupSize
+const uint ShadeGroupSize = 64u;
+
+/// Size of a Vertex in floats: position, normal, tangent, color (3 each) and texCoord (2)
+const uint VertexFloatStride = 14u;
+const uint PositionOffset = 0u;
+const uint NormalOffset = 3u;
+const uint TangentOffset = 6u;
+const uint ColorOffset = 9u;
+const uint TexCoordOffset = 12u;
+
+/// Per draw data, matches VisibilityBuffer::DrawData
+struct DrawData {
+	mat4 model;
+	mat4 normalMatrix;   /// Inverse transpose of the model matrix
+	uint vertexOffset;   /// First vertex of the mesh in the vertex pool
+	uint firstIndex;     /// First index of the mesh in the index pool
+	uint materialBin;    /// Bin of the material this draw is shaded with
+	uint padding;
+};
+
+/// Per material bin counters, matches VisibilityBuffer::BinData
+struct BinData {
+	uint count;   /// Pixels covered by the bin's material
+	uint offset;  /// First entry of the bin in the pixel list
+	uint cursor;  /// Entries written by the scatter pass so far
+	uint padding;
+};
+
+layout(set = VISIBILITY_SET, binding = 0, rg32ui) uniform readonly uimage2D visibilityImage;
+layout(set = VISIBILITY_SET, binding = 1, rgba16f) uniform writeonly image2D shadedImage;
+
+layout(std430, set = VISIBILITY_SET, binding = 2) readonly buffer DrawTable {
+	DrawData draws[];
+} drawTable;
+
+layout(std430, set = VISIBILITY_SET, binding = 3) readonly buffer VertexPool {
+	float vertices[];
+} vertexPool;
+
+layout(std430, set = VISIBILITY_SET, binding = 4) readonly buffer IndexPool {
+	uint indices[];
+} indexPool;
+
+layout(std430, set = VISIBILITY_SET, binding = 5) buffer BinBuffer {
+	BinData bins[];
+} binBuffer;
+
+/// VkDispatchIndirectCommand per bin, three uints each
+layout(std430, set = VISIBILITY_SET, binding = 6) buffer DispatchBuffer {
+	uint args[];
+} dispatchBuffer;
+
+/// Pixel coordinates sorted by bin, x in the low and y in the high 16 bits
+layout(std430, set = VISIBILITY_SET, binding = 7) buffer PixelList {
+	uint pixels[];
+} pixelList;
+
+/// Push constants of all visibility compute passes
+layout(push_constant) uniform PushConstants {
+	uvec2 renderExtent;  /// Part of the targets rendered this frame
+	uint binIndex;       /// Bin shaded by the current dispatch
+	uint binCount;       /// Number of bins used this frame
+} push;
+
+uint packPixel(uvec2 pixel) {
+	return pixel.x | (pixel.y << 16u);
+}
+
+ivec2 unpackPixel(uint packed) {
+	return ivec2(packed & 0xFFFFu, packed >> 16u);
+}
+
+#endif /// VISIBILITY_COMMON_GLSL
@@ -1,4 +1,5 @@
 #include "application.h"
+#include "vulkan/vulkanformatters.h"
 
 #include <spdlog/spdlog.h>
 #include <SDL3/SDL_vulkan.h>
@@ -47,6 +48,10 @@ bool Application::initialize() {
 		return false;
 	}
 
+	/// Dynamic resolution aims to finish GPU work within one display refresh,
+	/// leaving some headroom for composition and timing noise
+	this->renderer->setTargetGpuTime(0.9f * 1000.0f / this->getDisplayRefreshRate());
+
 	this->isRunning = true;
 	this->framebufferResized = false;
 	return true;
@@ -56,7 +61,15 @@ void Application::run() {
 	/// Initialize time tracking with current time
 	this->lastFrameTime = std::chrono::steady_clock::now();
 
+	/// Recording and presenting happen on the render thread from here on
+	/// This thread keeps input and simulation, and publishes a snapshot per frame
+	this->renderer->startRenderThread();
+
 	while (this->isRunning) {
+		/// Start the frame on the pacer's cadence
+		/// In low-latency mode this waits, so the input we sample next is as fresh as possible
+		this->framePacer.beginFrame();
+
 		/// Update time first to provide accurate timing to all systems
 		this->updateTime();
 
@@ -71,7 +84,18 @@ void Application::run() {
 
 		/// Render the frame
 		this->render();
+
+		/// Wait out the rest of the frame if a frame rate limit is set
+		this->framePacer.endFrame();
+
+		/// A render thread that stopped on an error can't show anything anymore
+		if (!this->renderer->isRenderThreadRunning()) {
+			spdlog::error("Render thread stopped unexpectedly, shutting down");
+			this->isRunning = false;
+		}
 	}
+
+	this->renderer->stopRenderThread();
 }
 
 void Application::handleEvents() {
@@ -89,6 +113,35 @@ void Application::handleEvents() {
 				if (event.key.key == SDLK_F12) {
 					this->takeScreenshot();
 				}
+				/// Move the displaced sphere through its noise to see another surface
+				else if (event.key.key == SDLK_F5) {
+					auto parameters = this->renderer->getSphereDisplacement();
+					parameters.offset += glm::vec3(1.7f, 0.0f, 0.9f);
+					this->renderer->setSphereDisplacement(parameters);
+				}
+				else if (event.key.key == SDLK_F6) {
+					this->renderer->setTerrainEnabled(!this->renderer->isTerrainEnabled());
+				}
+				/// Switch between the visibility buffer and the forward path
+				else if (event.key.key == SDLK_F7) {
+					this->renderer->setVisibilityBufferEnabled(
+						!this->renderer->isVisibilityBufferEnabled());
+				}
+				/// Toggle dynamic resolution, to compare against rendering at full size
+				else if (event.key.key == SDLK_F8) {
+					this->renderer->setDynamicResolutionEnabled(
+						!this->renderer->isDynamicResolutionEnabled());
+				}
+				/// Frame pacing controls
+				else if (event.key.key == SDLK_F9) {
+					this->cyclePresentMode();
+				}
+				else if (event.key.key == SDLK_F10) {
+					this->toggleFrameRateLimit();
+				}
+				else if (event.key.key == SDLK_F11) {
+					this->setLowLatencyMode(!this->framePacer.isLowLatencyMode());
+				}
 			case SDL_EVENT_KEY_DOWN:
 			case SDL_EVENT_MOUSE_MOTION:
 			case SDL_EVENT_MOUSE_BUTTON_DOWN:
@@ -106,24 +159,21 @@ void Application::handleEvents() {
 
 void Application::render() {
 	if (this->framebufferResized) {
+		/// The render thread owns the swap chain, so we only pass the new size on
 		int w, h;
 		SDL_GetWindowSizeInPixels(this->window, &w, &h);
-		if (this->renderer->recreateSwapChain(static_cast<uint32_t>(w),
-			static_cast<uint32_t>(h))) {
-				/// TODO: Swapchain recreation successful
-			} else {
-				/// TODO: Handle recreation failure
-			}
+		this->renderer->requestSwapChainRecreation(static_cast<uint32_t>(w),
+			static_cast<uint32_t>(h));
 		this->framebufferResized = false;
-		return;
 	}
 
-	/// Update renderer state before drawing
+	/// Update renderer state and publish the frame snapshot
 	/// This ensures all rendering state is current with game time
 	this->renderer->update(this->gameTime.deltaTime);
 
-	/// Perform actual frame rendering
-	this->renderer->drawFrame();
+	/// Wait until the render thread has picked up this snapshot
+	/// The render thread then draws this frame while we simulate the next one
+	this->renderer->waitForFrameSlot();
 }
 
 void Application::cleanup() {
@@ -174,6 +224,13 @@ void Application::updateTime() {
 
 		if (currentInterval > lastInterval) {
 			spdlog::info("Game time: {:.2f} seconds", this->gameTime.totalTime);
+
+			/// Frame time variance tells us more about smoothness than the average alone
+			const FrameTimeStats stats = this->framePacer.getStats();
+			spdlog::info("Frame time: avg {:.2f} ms, std dev {:.2f} ms, min {:.2f} ms, max {:.2f} ms ({} frames)",
+				stats.averageMs, stats.standardDeviationMs, stats.minMs, stats.maxMs, stats.sampleCount);
+			spdlog::info("GPU time: {:.2f} ms, render scale {:.2f}",
+				this->renderer->getGpuFrameTime(), this->renderer->getRenderScale());
 		}
 
 		/// Accumulate time for fixed updates
@@ -217,7 +274,60 @@ void Application::takeScreenshot() const {
 	std::stringstream ss;
 	ss << std::put_time(std::localtime(&current_time), "LillUgsi_%Y-%m-%d_%H.%M.%S.png");
 	const std::string filename = ss.str();
-	this->renderer->captureScreenshot(filename);
+	this->renderer->requestScreenshot(filename);
+}
+
+void Application::setPresentMode(VkPresentModeKHR mode) {
+	if (this->renderer) {
+		this->renderer->requestPresentMode(mode);
+	}
+}
+
+void Application::cyclePresentMode() {
+	/// The order goes from most to least latency
+	static constexpr VkPresentModeKHR PresentModes[] = {
+		VK_PRESENT_MODE_FIFO_KHR,
+		VK_PRESENT_MODE_FIFO_RELAXED_KHR,
+		VK_PRESENT_MODE_MAILBOX_KHR,
+		VK_PRESENT_MODE_IMMEDIATE_KHR
+	};
+	constexpr size_t modeCount = sizeof(PresentModes) / sizeof(PresentModes[0]);
+
+	const VkPresentModeKHR current = this->renderer->getPresentMode();
+	size_t currentIndex = 0;
+	for (size_t i = 0; i < modeCount; ++i) {
+		if (PresentModes[i] == current) {
+			currentIndex = i;
+			break;
+		}
+	}
+
+	/// Skip modes the display doesn't offer, FIFO is always there
+	for (size_t step = 1; step <= modeCount; ++step) {
+		const VkPresentModeKHR candidate = PresentModes[(currentIndex + step) % modeCount];
+		if (this->renderer->isPresentModeSupported(candidate)) {
+			spdlog::info("Switching present mode from {} to {}", current, candidate);
+			this->setPresentMode(candidate);
+			return;
+		}
+	}
+}
+
+void Application::toggleFrameRateLimit() {
+	if (this->framePacer.getTargetFrameRate() > 0.0f) {
+		this->setFrameRateLimit(0.0f);
+	} else {
+		this->setFrameRateLimit(this->getDisplayRefreshRate());
+	}
+}
+
+float Application::getDisplayRefreshRate() const {
+	const SDL_DisplayMode* mode = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(this->window));
+	if (mode && mode->refresh_rate > 0.0f) {
+		return mode->refresh_rate;
+	}
+
+	return 60.0f;
 }
 
 }
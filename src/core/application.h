@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/framepacer.h"
 #include "rendering/renderer.h"
 #include <SDL3/SDL.h>
 #include <string>
@@ -46,6 +47,23 @@ public:
 	/// @param maxDelta Maximum time step in seconds
 	void setMaxDeltaTime(float maxDelta) { this->maxDeltaTime = maxDelta; }
 
+	/// Limit the frame rate of the main loop
+	/// @param framesPerSecond Target frame rate, 0 for unlimited
+	void setFrameRateLimit(float framesPerSecond) { this->framePacer.setTargetFrameRate(framesPerSecond); }
+
+	/// Enable waiting before input sampling instead of after the frame
+	/// This reduces input latency when a frame rate limit is set
+	/// @param enabled True to enable low-latency pacing
+	void setLowLatencyMode(bool enabled) { this->framePacer.setLowLatencyMode(enabled); }
+
+	/// Switch the swap chain present mode at runtime
+	/// @param mode FIFO, FIFO_RELAXED, MAILBOX or IMMEDIATE, if supported by the display
+	void setPresentMode(VkPresentModeKHR mode);
+
+	/// Get the frame pacer for statistics and settings
+	/// @return Reference to the frame pacer
+	[[nodiscard]] const FramePacer& getFramePacer() const { return this->framePacer; }
+
 protected:
 	/// Handle input events
 	/// This method processes SDL events and updates the application state accordingly
@@ -74,6 +92,16 @@ protected:
 	/// Take a screenshot and save it to a file with the current date
 	void takeScreenshot() const;
 
+	/// Switch to the next present mode the display supports
+	void cyclePresentMode();
+
+	/// Toggle the frame limiter between off and the display refresh rate
+	void toggleFrameRateLimit();
+
+	/// Get the refresh rate of the display showing the window
+	/// @return Refresh rate in Hz, or 60 if SDL can't tell
+	[[nodiscard]] float getDisplayRefreshRate() const;
+
 	std::string appName;
 	uint32_t width;
 	uint32_t height;
@@ -90,5 +118,8 @@ protected:
 	float fixedTimeAccumulator{0.0f}; /// Tracks leftover time for fixed updates
 	float logInterval{5.0f};
 	float maxDeltaTime{0.1f};
+
+	/// Frame limiter, low-latency pacing and frame time statistics
+	FramePacer framePacer;
 };
 }
@@ -0,0 +1,145 @@
+#include "framepacer.h"
+
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace lillugsi::core {
+
+namespace {
+/// Extra time we start a low-latency frame early, on top of the predicted work
+/// This absorbs small variations in work time without missing the deadline
+constexpr std::chrono::microseconds LowLatencySafetyMargin{1000};
+
+/// Decay factor of the work time prediction
+/// The prediction jumps up to slow frames immediately and only decays slowly,
+/// so a single spike doesn't make the following frames miss their deadline
+constexpr float PredictionDecay = 0.95f;
+}
+
+FramePacer::FramePacer()
+	: nextDeadline(Clock::now())
+	, frameStart(Clock::now()) {
+}
+
+void FramePacer::setTargetFrameRate(float framesPerSecond) {
+	if (framesPerSecond <= 0.0f) {
+		this->targetFrameRate = 0.0f;
+		this->framePeriod = Clock::duration::zero();
+		spdlog::info("Frame limiter disabled");
+		return;
+	}
+
+	this->targetFrameRate = framesPerSecond;
+	this->framePeriod = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<double>(1.0 / static_cast<double>(framesPerSecond)));
+
+	/// Start the new cadence from now instead of catching up on old deadlines
+	this->nextDeadline = Clock::now() + this->framePeriod;
+
+	spdlog::info("Frame limiter set to {:.1f} fps", framesPerSecond);
+}
+
+void FramePacer::setLowLatencyMode(bool enabled) {
+	this->lowLatencyMode = enabled;
+	spdlog::info("Low-latency frame pacing {}", enabled ? "enabled" : "disabled");
+}
+
+void FramePacer::beginFrame() {
+	/// In low-latency mode we wait here, so input is sampled as late as possible
+	/// while the frame still finishes by its deadline
+	if (this->lowLatencyMode && this->framePeriod > Clock::duration::zero() && this->hasPreviousFrame) {
+		const auto predictedWork = std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<float>(this->predictedWorkSeconds));
+		this->waitUntil(this->nextDeadline - predictedWork - LowLatencySafetyMargin);
+	}
+
+	const auto now = Clock::now();
+	if (this->hasPreviousFrame) {
+		this->recordFrameTime(now - this->frameStart);
+	}
+	this->frameStart = now;
+	this->hasPreviousFrame = true;
+}
+
+void FramePacer::endFrame() {
+	/// Track how long the frame's CPU work took
+	const float workSeconds = std::chrono::duration<float>(Clock::now() - this->frameStart).count();
+	this->predictedWorkSeconds = std::max(workSeconds,
+		this->predictedWorkSeconds * PredictionDecay + workSeconds * (1.0f - PredictionDecay));
+
+	if (this->framePeriod == Clock::duration::zero()) {
+		return;
+	}
+
+	/// With the regular limiter we wait after the work is done
+	if (!this->lowLatencyMode) {
+		this->waitUntil(this->nextDeadline);
+	}
+
+	/// Advance to the next deadline
+	/// If we fell behind by more than a frame, we resynchronize instead of
+	/// running several frames back to back to catch up
+	const auto now = Clock::now();
+	this->nextDeadline += this->framePeriod;
+	if (this->nextDeadline < now) {
+		this->nextDeadline = now + this->framePeriod;
+	}
+}
+
+FrameTimeStats FramePacer::getStats() const {
+	FrameTimeStats stats;
+	stats.sampleCount = this->frameTimeCount;
+	if (this->frameTimeCount == 0) {
+		return stats;
+	}
+
+	/// The window is small, so two passes over it are cheaper than keeping running sums
+	/// and avoid the precision loss of the sum-of-squares formula
+	double sum = 0.0;
+	stats.minMs = std::numeric_limits<float>::max();
+	stats.maxMs = 0.0f;
+	for (size_t i = 0; i < this->frameTimeCount; ++i) {
+		const float frameTime = this->frameTimes[i];
+		sum += frameTime;
+		stats.minMs = std::min(stats.minMs, frameTime);
+		stats.maxMs = std::max(stats.maxMs, frameTime);
+	}
+	const double mean = sum / static_cast<double>(this->frameTimeCount);
+
+	double squaredDeviations = 0.0;
+	for (size_t i = 0; i < this->frameTimeCount; ++i) {
+		const double deviation = this->frameTimes[i] - mean;
+		squaredDeviations += deviation * deviation;
+	}
+
+	stats.averageMs = static_cast<float>(mean);
+	stats.varianceMs2 = static_cast<float>(squaredDeviations / static_cast<double>(this->frameTimeCount));
+	stats.standardDeviationMs = std::sqrt(stats.varianceMs2);
+	return stats;
+}
+
+void FramePacer::waitUntil(Clock::time_point deadline) const {
+	/// Sleep through most of the wait, the OS scheduler is too coarse for the rest
+	const auto remaining = deadline - Clock::now();
+	if (remaining > this->spinThreshold) {
+		std::this_thread::sleep_for(remaining - this->spinThreshold);
+	}
+
+	/// Spin for the last part to hit the deadline precisely
+	/// Yielding keeps other threads, like the render thread, responsive meanwhile
+	while (Clock::now() < deadline) {
+		std::this_thread::yield();
+	}
+}
+
+void FramePacer::recordFrameTime(Clock::duration frameTime) {
+	this->frameTimes[this->nextFrameTimeIndex] =
+		std::chrono::duration<float, std::milli>(frameTime).count();
+	this->nextFrameTimeIndex = (this->nextFrameTimeIndex + 1) % SampleWindow;
+	this->frameTimeCount = std::min(this->frameTimeCount + 1, SampleWindow);
+}
+
+} /// namespace lillugsi::core
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace lillugsi::core {
+
+/// Summary of recent frame times
+/// The variance matters as much as the average: a steady 30 ms feels smoother
+/// than frames alternating between 10 ms and 40 ms, even though the latter is faster
+struct FrameTimeStats {
+	float averageMs{0.0f};            /// Mean frame time
+	float varianceMs2{0.0f};          /// Variance of the frame time in ms²
+	float standardDeviationMs{0.0f};  /// Square root of the variance, in ms
+	float minMs{0.0f};                /// Fastest frame in the window
+	float maxMs{0.0f};                /// Slowest frame in the window
+	size_t sampleCount{0};            /// Number of frames the stats are based on
+};
+
+/// FramePacer keeps the simulation loop on an even cadence
+/// It provides:
+/// - A CPU frame limiter for a target frame rate. We sleep for most of the remaining
+///   frame time and spin for the last bit, because OS sleeps routinely overshoot
+///   by a millisecond or more, which shows up as jitter
+/// - A low-latency mode that moves the wait in front of input sampling. Instead of
+///   sampling input, finishing early and then idling, we idle first and sample input
+///   just late enough that the frame's work still finishes by its deadline
+/// - Frame-time statistics over a rolling window, including variance
+///
+/// The application calls beginFrame() before handling input and endFrame()
+/// after the frame snapshot has been handed to the renderer
+class FramePacer {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/// Number of frames in the statistics window
+	static constexpr size_t SampleWindow = 240;
+
+	FramePacer();
+
+	/// Set the frame rate to pace to
+	/// @param framesPerSecond Target frame rate, 0 disables the limiter
+	void setTargetFrameRate(float framesPerSecond);
+
+	/// Get the frame rate we pace to
+	/// @return Target frame rate, 0 if the limiter is disabled
+	[[nodiscard]] float getTargetFrameRate() const { return this->targetFrameRate; }
+
+	/// Enable or disable waiting before input sampling
+	/// This only has an effect while a target frame rate is set,
+	/// since without a deadline there is nothing to delay towards
+	/// @param enabled True to wait before input sampling instead of after the frame
+	void setLowLatencyMode(bool enabled);
+
+	/// Check if low-latency mode is enabled
+	/// @return True if the wait happens before input sampling
+	[[nodiscard]] bool isLowLatencyMode() const { return this->lowLatencyMode; }
+
+	/// Set how long before a deadline we stop sleeping and start spinning
+	/// Larger values cost more CPU but hit deadlines more precisely
+	/// @param threshold Time reserved for spinning
+	void setSpinThreshold(std::chrono::microseconds threshold) { this->spinThreshold = threshold; }
+
+	/// Mark the start of a frame, right before input is sampled
+	/// In low-latency mode this is where we wait
+	void beginFrame();
+
+	/// Mark the end of the frame's CPU work
+	/// With the regular limiter this is where we wait
+	void endFrame();
+
+	/// Compute statistics over the recent frame times
+	/// @return Frame time statistics of the last SampleWindow frames
+	[[nodiscard]] FrameTimeStats getStats() const;
+
+private:
+	/// Wait until the given time point using sleep followed by a short spin
+	/// @param deadline Time point to wait for
+	void waitUntil(Clock::time_point deadline) const;
+
+	/// Record the time between two consecutive frame starts
+	/// @param frameTime Duration of the last frame
+	void recordFrameTime(Clock::duration frameTime);
+
+	/// Target frame rate and resulting frame period, 0 when unlimited
+	float targetFrameRate{0.0f};
+	Clock::duration framePeriod{Clock::duration::zero()};
+
+	bool lowLatencyMode{false};
+
+	/// Time reserved for spinning at the end of a wait
+	/// About 2 ms covers typical sleep overshoot on desktop operating systems
+	std::chrono::microseconds spinThreshold{2000};
+
+	/// Point in time by which the current frame's work should be done
+	Clock::time_point nextDeadline;
+
+	/// Start time of the current frame, used for frame and work durations
+	Clock::time_point frameStart;
+	bool hasPreviousFrame{false};
+
+	/// Smoothed duration of the CPU work between beginFrame() and endFrame()
+	/// Low-latency mode uses this to predict how early it has to start a frame
+	float predictedWorkSeconds{0.0f};
+
+	/// Ring buffer of recent frame times in milliseconds
+	std::array<float, SampleWindow> frameTimes{};
+	size_t frameTimeCount{0};
+	size_t nextFrameTimeIndex{0};
+};
+
+} /// namespace lillugsi::core
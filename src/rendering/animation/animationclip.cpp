@@ -0,0 +1,197 @@
+#include "animationclip.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LILLUGSI_ANIMATION_SSE 1
+#endif
+
+namespace lillugsi::rendering::animation {
+
+namespace {
+
+/// Component index of the first value a path animates
+uint32_t getFirstComponent(AnimationClip::Path path) {
+	switch (path) {
+		case AnimationClip::Path::Translation: return Pose::TranslationX;
+		case AnimationClip::Path::Rotation: return Pose::RotationX;
+		case AnimationClip::Path::Scale: return Pose::ScaleX;
+	}
+	return Pose::TranslationX;
+}
+
+} /// namespace
+
+AnimationClip::AnimationClip(std::string name, const Pose& restPose, float duration)
+	: name(std::move(name))
+	, duration(std::max(duration, 0.0f))
+	, frameCount(static_cast<uint32_t>(std::ceil(this->duration * SampleRate)) + 1)
+	, laneCount(restPose.laneCount)
+	, frameStride(restPose.values.size())
+	, frames(this->frameStride * this->frameCount) {
+	for (uint32_t frame = 0; frame < this->frameCount; ++frame) {
+		std::copy(restPose.values.begin(), restPose.values.end(), this->getFrame(frame));
+	}
+}
+
+void AnimationClip::setTrack(uint32_t joint,
+	Path path,
+	const std::vector<float>& times,
+	const std::vector<float>& values,
+	Interpolation interpolation) {
+	const uint32_t components = path == Path::Rotation ? 4 : 3;
+	const bool cubic = interpolation == Interpolation::CubicSpline;
+	const size_t keyStride = cubic ? components * 3 : components;
+	const size_t keyCount = std::min(times.size(), values.size() / keyStride);
+	if (keyCount == 0 || joint >= this->laneCount) {
+		spdlog::warn("Ignoring empty or invalid track of joint {} in animation '{}'", joint, this->name);
+		return;
+	}
+
+	/// Cubic spline keys store the value between its in and out tangent
+	const size_t valueOffset = cubic ? components : 0;
+	const auto keyValue = [&](size_t key, uint32_t component) {
+		return values[key * keyStride + valueOffset + component];
+	};
+
+	const uint32_t firstComponent = getFirstComponent(path);
+	size_t key = 0;
+	for (uint32_t frame = 0; frame < this->frameCount; ++frame) {
+		const float time = std::min(static_cast<float>(frame) / SampleRate, this->duration);
+		while (key + 1 < keyCount && times[key + 1] <= time) {
+			++key;
+		}
+
+		glm::vec4 value(0.0f);
+		if (interpolation == Interpolation::Step || key + 1 >= keyCount || time <= times[key]) {
+			for (uint32_t c = 0; c < components; ++c) {
+				value[c] = keyValue(key, c);
+			}
+		} else {
+			const float keyDelta = times[key + 1] - times[key];
+			const float t = keyDelta > 0.0f ? (time - times[key]) / keyDelta : 0.0f;
+
+			if (cubic) {
+				/// Hermite spline, tangents are scaled by the time between the keys
+				const float t2 = t * t;
+				const float t3 = t2 * t;
+				for (uint32_t c = 0; c < components; ++c) {
+					const float outTangent = values[key * keyStride + 2 * components + c];
+					const float inTangent = values[(key + 1) * keyStride + c];
+					value[c] = (2.0f * t3 - 3.0f * t2 + 1.0f) * keyValue(key, c)
+						+ (t3 - 2.0f * t2 + t) * keyDelta * outTangent
+						+ (-2.0f * t3 + 3.0f * t2) * keyValue(key + 1, c)
+						+ (t3 - t2) * keyDelta * inTangent;
+				}
+			} else if (path == Path::Rotation) {
+				const glm::quat from(keyValue(key, 3), keyValue(key, 0), keyValue(key, 1), keyValue(key, 2));
+				const glm::quat to(keyValue(key + 1, 3), keyValue(key + 1, 0), keyValue(key + 1, 1), keyValue(key + 1, 2));
+				const glm::quat rotation = glm::slerp(from, to, t);
+				value = glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w);
+			} else {
+				for (uint32_t c = 0; c < components; ++c) {
+					value[c] = keyValue(key, c) + (keyValue(key + 1, c) - keyValue(key, c)) * t;
+				}
+			}
+		}
+
+		/// Quantized and spline rotations aren't unit length
+		if (path == Path::Rotation) {
+			const float length = glm::length(value);
+			value = length > 0.0f ? value / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+
+		float* frameValues = this->getFrame(frame);
+		for (uint32_t c = 0; c < components; ++c) {
+			frameValues[static_cast<size_t>(firstComponent + c) * this->laneCount + joint] = value[c];
+		}
+	}
+}
+
+void AnimationClip::finalize() {
+	/// q and -q are the same rotation, but blending them linearly passes through zero.
+	/// Flipping every rotation into the hemisphere of the one before it makes the
+	/// blend between frames take the short way around
+	for (uint32_t frame = 1; frame < this->frameCount; ++frame) {
+		const float* previous = this->getFrame(frame - 1) + Pose::RotationX * this->laneCount;
+		float* current = this->getFrame(frame) + Pose::RotationX * this->laneCount;
+		for (uint32_t lane = 0; lane < this->laneCount; ++lane) {
+			float dot = 0.0f;
+			for (uint32_t c = 0; c < 4; ++c) {
+				dot += previous[c * this->laneCount + lane] * current[c * this->laneCount + lane];
+			}
+			if (dot < 0.0f) {
+				for (uint32_t c = 0; c < 4; ++c) {
+					current[c * this->laneCount + lane] = -current[c * this->laneCount + lane];
+				}
+			}
+		}
+	}
+
+	spdlog::debug("Resampled animation '{}' into {} frames of {} joints",
+		this->name, this->frameCount, this->laneCount);
+}
+
+void AnimationClip::sample(float time, Pose& pose) const {
+	const float position = std::clamp(time, 0.0f, this->duration) * SampleRate;
+	const uint32_t frame = std::min(static_cast<uint32_t>(position), this->frameCount - 1);
+	const float* from = this->frames.data() + static_cast<size_t>(frame) * this->frameStride;
+	float* out = pose.values.data();
+
+	if (frame + 1 >= this->frameCount) {
+		std::copy(from, from + this->frameStride, out);
+		return;
+	}
+
+	/// Blend every component of every joint in one pass
+	/// Frames are whole numbers of four lanes, so no scalar tail remains
+	const float* to = from + this->frameStride;
+	const float t = position - static_cast<float>(frame);
+#ifdef LILLUGSI_ANIMATION_SSE
+	const __m128 weight = _mm_set1_ps(t);
+	for (size_t i = 0; i < this->frameStride; i += Pose::LaneWidth) {
+		const __m128 a = _mm_loadu_ps(from + i);
+		const __m128 b = _mm_loadu_ps(to + i);
+		_mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), weight)));
+	}
+#else
+	for (size_t i = 0; i < this->frameStride; ++i) {
+		out[i] = from[i] + (to[i] - from[i]) * t;
+	}
+#endif
+
+	/// Blended rotations are shorter than unit length, normalize four joints at a time
+	float* x = pose.component(Pose::RotationX);
+	float* y = pose.component(Pose::RotationY);
+	float* z = pose.component(Pose::RotationZ);
+	float* w = pose.component(Pose::RotationW);
+#ifdef LILLUGSI_ANIMATION_SSE
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (uint32_t lane = 0; lane < this->laneCount; lane += Pose::LaneWidth) {
+		const __m128 qx = _mm_loadu_ps(x + lane);
+		const __m128 qy = _mm_loadu_ps(y + lane);
+		const __m128 qz = _mm_loadu_ps(z + lane);
+		const __m128 qw = _mm_loadu_ps(w + lane);
+		const __m128 lengthSquared = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+			_mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw)));
+		const __m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+		_mm_storeu_ps(x + lane, _mm_mul_ps(qx, inverseLength));
+		_mm_storeu_ps(y + lane, _mm_mul_ps(qy, inverseLength));
+		_mm_storeu_ps(z + lane, _mm_mul_ps(qz, inverseLength));
+		_mm_storeu_ps(w + lane, _mm_mul_ps(qw, inverseLength));
+	}
+#else
+	for (uint32_t lane = 0; lane < this->laneCount; ++lane) {
+		const float inverseLength = 1.0f / std::sqrt(x[lane] * x[lane] + y[lane] * y[lane]
+			+ z[lane] * z[lane] + w[lane] * w[lane]);
+		x[lane] *= inverseLength;
+		y[lane] *= inverseLength;
+		z[lane] *= inverseLength;
+		w[lane] *= inverseLength;
+	}
+#endif
+}
+
+} /// namespace lillugsi::rendering::animation
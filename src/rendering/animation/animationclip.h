@@ -0,0 +1,93 @@
+#pragma once
+
+#include "pose.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lillugsi::rendering::animation {
+
+/// AnimationClip is one animation of a skeleton, resampled into evenly spaced poses
+/// glTF stores an animation as channels, each with its own key times and interpolation.
+/// Sampling them as they are means a key search and an interpolation per channel and
+/// joint, with branches that differ per channel. We resample all channels into whole
+/// poses at SampleRate once, when the clip is loaded. Sampling at any time is then the
+/// same for every clip: find the two frames around it and blend all their floats in
+/// one pass, which runs four joints per instruction.
+///
+/// Joints without a channel keep their rest transform in every frame. Between frames
+/// rotations are blended linearly and normalized, finalize makes neighbouring frames
+/// lie in the same hemisphere so this takes the short way
+class AnimationClip {
+public:
+	/// Poses per second
+	/// Blending frames this close is indistinguishable from sampling the channels
+	/// for the motion characters make, and keeps a clip at a few kilobytes per second
+	static constexpr float SampleRate = 30.0f;
+
+	/// Part of a joint transform a channel animates
+	enum class Path {
+		Translation,
+		Rotation,
+		Scale
+	};
+
+	/// How a channel's values change between its keys
+	enum class Interpolation {
+		Step,
+		Linear,
+		CubicSpline
+	};
+
+	/// Create a clip with every frame in the rest pose
+	/// @param name Name of the animation
+	/// @param restPose Pose of the skeleton without animation
+	/// @param duration Length of the clip in seconds
+	AnimationClip(std::string name, const Pose& restPose, float duration);
+
+	/// Resample a channel into the frames
+	/// @param joint Joint the channel animates
+	/// @param path Component of the joint's transform
+	/// @param times Key times in seconds, ascending
+	/// @param values Key values, 3 floats per key for translation and scale and 4 for
+	///        rotations (x, y, z, w). Cubic splines store an in tangent, the value and an
+	///        out tangent per key
+	/// @param interpolation How values change between keys
+	void setTrack(uint32_t joint,
+		Path path,
+		const std::vector<float>& times,
+		const std::vector<float>& values,
+		Interpolation interpolation);
+
+	/// Prepare the frames for sampling, after all tracks are set
+	void finalize();
+
+	/// Sample the clip
+	/// @param time Time in seconds, clamped to the clip
+	/// @param pose Pose of the same skeleton to write into
+	void sample(float time, Pose& pose) const;
+
+	/// Get the name of the animation
+	[[nodiscard]] const std::string& getName() const { return this->name; }
+
+	/// Get the length of the clip in seconds
+	[[nodiscard]] float getDuration() const { return this->duration; }
+
+	/// Get the number of resampled poses
+	[[nodiscard]] uint32_t getFrameCount() const { return this->frameCount; }
+
+private:
+	/// Get the values of a frame, ComponentCount arrays of laneCount floats like a Pose
+	[[nodiscard]] float* getFrame(uint32_t frame) {
+		return this->frames.data() + static_cast<size_t>(frame) * this->frameStride;
+	}
+
+	std::string name;
+	float duration{0.0f};
+	uint32_t frameCount{0};
+	uint32_t laneCount{0};
+	size_t frameStride{0};      /// Floats per frame
+	std::vector<float> frames;  /// frameCount frames, one after the other
+};
+
+} /// namespace lillugsi::rendering::animation
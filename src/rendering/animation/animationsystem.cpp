@@ -0,0 +1,126 @@
+#include "animationsystem.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+namespace lillugsi::rendering::animation {
+
+void AnimationSystem::addMesh(const std::shared_ptr<SkinnedMesh>& mesh) {
+	if (!mesh || !mesh->getAnimator()) {
+		return;
+	}
+	const auto& animator = mesh->getAnimator();
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	animator->meshes.push_back(mesh);
+	if (!animator->registered) {
+		animator->registered = true;
+		this->animators.push_back(animator);
+	}
+}
+
+void AnimationSystem::update(float deltaTime) {
+	const auto start = std::chrono::steady_clock::now();
+
+	/// Take the animators that are still alive, dropping the others
+	/// Their meshes hold them, so they stay alive until the next update even if the
+	/// meshes are released meanwhile. Suspended ones stay registered but sit out
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->active.clear();
+		this->active.reserve(this->animators.size());
+		auto it = std::remove_if(this->animators.begin(), this->animators.end(),
+			[this](const std::weak_ptr<Animator>& weak) {
+				auto animator = weak.lock();
+				if (!animator) {
+					return true;
+				}
+				if (!animator->isSuspended()) {
+					this->active.push_back(std::move(animator));
+				}
+				return false;
+			});
+		this->animators.erase(it, this->animators.end());
+	}
+
+	if (this->active.empty()) {
+		this->lastUpdateTime = std::chrono::microseconds(0);
+		return;
+	}
+
+	/// Batches of animators take turns from a shared counter
+	std::atomic<size_t> nextBatch{0};
+	const size_t count = this->active.size();
+	const auto updateAnimators = [this, count, deltaTime, &nextBatch]() {
+		for (size_t first = nextBatch.fetch_add(BatchSize); first < count; first = nextBatch.fetch_add(BatchSize)) {
+			const size_t last = std::min(first + BatchSize, count);
+			for (size_t i = first; i < last; ++i) {
+				this->active[i]->advance(deltaTime);
+				this->active[i]->evaluate();
+			}
+		}
+	};
+
+	if (count < ParallelThreshold) {
+		updateAnimators();
+	} else {
+		const size_t batchCount = (count + BatchSize - 1) / BatchSize;
+		const size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, batchCount);
+		std::vector<std::future<void>> workers;
+		workers.reserve(workerCount);
+		for (size_t i = 0; i < workerCount; ++i) {
+			workers.push_back(std::async(std::launch::async, updateAnimators));
+		}
+		for (auto& worker : workers) {
+			worker.get();
+		}
+	}
+
+	this->lastUpdateTime = std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - start);
+	spdlog::trace("Updated {} animators in {} us", count, this->lastUpdateTime.count());
+}
+
+void AnimationSystem::collectSkinning(std::vector<InstanceTransform>& palettes,
+	std::vector<SkinningDispatch>& dispatches,
+	size_t maxJoints) {
+	palettes.clear();
+	dispatches.clear();
+
+	bool full = false;
+	std::lock_guard<std::mutex> lock(this->mutex);
+	for (const auto& animator : this->active) {
+		const auto& palette = animator->getPalette();
+		if (palettes.size() + palette.size() > maxJoints) {
+			full = true;
+			break;
+		}
+
+		/// Animators whose meshes are gone have nothing to skin
+		const auto paletteOffset = static_cast<uint32_t>(palettes.size());
+		auto& meshes = animator->meshes;
+		const size_t dispatchCount = dispatches.size();
+		meshes.erase(std::remove_if(meshes.begin(), meshes.end(),
+			[&](const std::weak_ptr<SkinnedMesh>& weak) {
+				const auto mesh = weak.lock();
+				if (!mesh) {
+					return true;
+				}
+				dispatches.push_back(SkinningDispatch{mesh->getSkinGeometry(), mesh->getVertexBuffer(), paletteOffset});
+				return false;
+			}), meshes.end());
+
+		if (dispatches.size() > dispatchCount) {
+			palettes.insert(palettes.end(), palette.begin(), palette.end());
+		}
+	}
+
+	if (full && !this->paletteFull) {
+		spdlog::warn("Joint palette buffer is full at {} joints, further characters keep their last pose", maxJoints);
+	}
+	this->paletteFull = full;
+}
+
+} /// namespace lillugsi::rendering::animation
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "animator.h"
+#include "rendering/skinnedmesh.h"
+#include "rendering/vertex.h"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lillugsi::rendering::animation {
+
+/// AnimationSystem updates the animators of all skinned meshes once per frame
+/// Each animator samples its clip and builds its joint palette independently of every
+/// other, so we spread them over worker threads taking batches from a shared counter,
+/// like faces in icosphere subdivision. Sampling is SIMD across joints, the threads
+/// are parallel across characters.
+///
+/// Meshes are added when they are created and tracked with weak references: a
+/// character is animated for as long as one of its meshes exists and its animator isn't
+/// suspended. The palettes of all characters are packed into one array for the skinning pass
+class AnimationSystem {
+public:
+	/// Animators updated on the calling thread below this count
+	/// A worker costs more to start than a few dozen characters take to evaluate
+	static constexpr size_t ParallelThreshold = 64;
+
+	/// Animators a worker takes from the counter at once
+	static constexpr size_t BatchSize = 16;
+
+	/// Start animating a skinned mesh
+	/// Safe to call from loader threads
+	/// @param mesh Mesh with an animator
+	void addMesh(const std::shared_ptr<SkinnedMesh>& mesh);
+
+	/// Advance and evaluate all animators
+	/// Called on the thread that updates the scene, before the frame's snapshot is built
+	/// @param deltaTime Time step in seconds
+	void update(float deltaTime);
+
+	/// Collect the palettes and skinning work of the last update
+	/// @param palettes Joint matrices of every animator with live meshes, replaced
+	/// @param dispatches One entry per live skinned mesh, replaced
+	/// @param maxJoints Joints the palette buffer holds, characters beyond it aren't skinned
+	void collectSkinning(std::vector<InstanceTransform>& palettes,
+		std::vector<SkinningDispatch>& dispatches,
+		size_t maxJoints);
+
+	/// Get the number of animators updated in the last update
+	[[nodiscard]] size_t getAnimatorCount() const { return this->active.size(); }
+
+	/// Get the time the last update took on the CPU
+	[[nodiscard]] std::chrono::microseconds getLastUpdateTime() const { return this->lastUpdateTime; }
+
+private:
+	/// Animators of added meshes, guarded by mutex together with their mesh lists
+	std::vector<std::weak_ptr<Animator>> animators;
+	std::mutex mutex;
+
+	/// Animators alive at the last update, only used on the updating thread
+	std::vector<std::shared_ptr<Animator>> active;
+
+	std::chrono::microseconds lastUpdateTime{0};
+
+	/// Whether the palette buffer overflowed in the last collection, to warn once
+	bool paletteFull{false};
+};
+
+} /// namespace lillugsi::rendering::animation
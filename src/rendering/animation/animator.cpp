@@ -0,0 +1,135 @@
+#include "animator.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+namespace lillugsi::rendering::animation {
+
+Animator::Animator(std::shared_ptr<const Skeleton> skeleton,
+	std::vector<std::shared_ptr<const AnimationClip>> clips,
+	const glm::mat4& skinSpace)
+	: skeleton(std::move(skeleton))
+	, clips(std::move(clips))
+	, skinSpace(skinSpace)
+	, pose(this->skeleton->restPose) {
+	this->evaluate();
+}
+
+std::shared_ptr<Animator> Animator::clone() const {
+	auto copy = std::make_shared<Animator>(this->skeleton, this->clips, this->skinSpace);
+	copy->currentClip = this->currentClip;
+	copy->time = this->time;
+	copy->speed = this->speed;
+	copy->looping = this->looping;
+	copy->evaluate();
+	return copy;
+}
+
+void Animator::play(size_t clipIndex, bool loop) {
+	if (clipIndex >= this->clips.size()) {
+		spdlog::warn("Animator has no clip {}, it has {}", clipIndex, this->clips.size());
+		return;
+	}
+	this->currentClip = static_cast<int>(clipIndex);
+	this->time = 0.0f;
+	this->looping = loop;
+}
+
+bool Animator::play(const std::string& name, bool loop) {
+	for (size_t i = 0; i < this->clips.size(); ++i) {
+		if (this->clips[i]->getName() == name) {
+			this->play(i, loop);
+			return true;
+		}
+	}
+	return false;
+}
+
+void Animator::stop() {
+	this->currentClip = -1;
+	this->time = 0.0f;
+}
+
+void Animator::advance(float deltaTime) {
+	if (this->currentClip < 0) {
+		return;
+	}
+
+	const float duration = this->clips[this->currentClip]->getDuration();
+	this->time += deltaTime * this->speed;
+	if (this->looping && duration > 0.0f) {
+		/// fmod keeps the sign of the time, playing backwards wraps to the end
+		this->time = std::fmod(this->time, duration);
+		if (this->time < 0.0f) {
+			this->time += duration;
+		}
+	} else {
+		this->time = std::clamp(this->time, 0.0f, duration);
+	}
+}
+
+void Animator::evaluate() {
+	if (this->currentClip >= 0) {
+		this->clips[this->currentClip]->sample(this->time, this->pose);
+	} else {
+		this->pose = this->skeleton->restPose;
+	}
+
+	this->computeSkinMatrices(this->pose, this->jointModels, this->skinMatrices);
+
+	/// The palette drops the last row, joints move affinely
+	this->palette.resize(this->skinMatrices.size());
+	for (size_t i = 0; i < this->skinMatrices.size(); ++i) {
+		this->palette[i] = InstanceTransform::fromMatrix(this->skinMatrices[i]);
+	}
+}
+
+scene::BoundingBox Animator::computeBounds(const std::vector<scene::BoundingBox>& jointBounds) const {
+	scene::BoundingBox bounds;
+	std::vector<glm::mat4> models;
+	std::vector<glm::mat4> matrices;
+
+	const auto addPose = [&](const Pose& pose) {
+		this->computeSkinMatrices(pose, models, matrices);
+		for (size_t joint = 0; joint < jointBounds.size() && joint < matrices.size(); ++joint) {
+			if (!jointBounds[joint].isValid()) {
+				continue;
+			}
+			const scene::BoundingBox moved = jointBounds[joint].transform(matrices[joint]);
+			bounds.addPoint(moved.getMin());
+			bounds.addPoint(moved.getMax());
+		}
+	};
+
+	addPose(this->skeleton->restPose);
+	Pose pose = this->skeleton->restPose;
+	for (const auto& clip : this->clips) {
+		for (uint32_t frame = 0; frame < clip->getFrameCount(); ++frame) {
+			clip->sample(static_cast<float>(frame) / AnimationClip::SampleRate, pose);
+			addPose(pose);
+		}
+	}
+	return bounds;
+}
+
+void Animator::computeSkinMatrices(const Pose& pose,
+	std::vector<glm::mat4>& jointModels,
+	std::vector<glm::mat4>& skinMatrices) const {
+	const Skeleton& skeleton = *this->skeleton;
+	const uint32_t jointCount = skeleton.getJointCount();
+	jointModels.resize(jointCount);
+	skinMatrices.resize(jointCount);
+
+	/// Parents come first, so each joint's parent is done when the joint is reached
+	for (const uint32_t joint : skeleton.evaluationOrder) {
+		const int32_t parent = skeleton.parents[joint];
+		const glm::mat4& parentModel = parent >= 0 ? jointModels[parent] : skeleton.rootTransforms[joint];
+		jointModels[joint] = parentModel * pose.getJointMatrix(joint);
+	}
+
+	for (uint32_t joint = 0; joint < jointCount; ++joint) {
+		skinMatrices[joint] = this->skinSpace * jointModels[joint] * skeleton.bindMatrices[joint];
+	}
+}
+
+} /// namespace lillugsi::rendering::animation
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "animationclip.h"
+#include "pose.h"
+#include "skeleton.h"
+#include "rendering/vertex.h"
+#include "scene/boundingbox.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lillugsi::rendering {
+class SkinnedMesh;
+}
+
+namespace lillugsi::rendering::animation {
+
+class AnimationSystem;
+
+/// Animator plays the clips of a skeleton for one character
+/// Skeletons and clips are loaded once and shared by every character using them, the
+/// animator only holds what differs per character: the playing clip, its time, and
+/// the joint palette evaluated from them. The palette is what the skinning pass reads,
+/// one matrix per joint moving rest pose vertices to their animated position in the
+/// space of the mesh's node.
+///
+/// All primitives of a skinned node share the node's animator, so its palette is
+/// evaluated once no matter how many meshes it moves. Animators are updated by the
+/// AnimationSystem, in parallel with those of other characters, and must only be
+/// changed on the thread that updates the scene
+class Animator {
+	/// The animation system tracks the meshes an animator moves
+	friend class AnimationSystem;
+
+public:
+	/// Create an animator in the rest pose
+	/// @param skeleton Joints and bind matrices of the skin
+	/// @param clips Animations of the skeleton, may be empty
+	/// @param skinSpace Maps the skeleton's model space to the space of the mesh's node,
+	///        with the vertices' flipped Y axis
+	Animator(std::shared_ptr<const Skeleton> skeleton,
+		std::vector<std::shared_ptr<const AnimationClip>> clips,
+		const glm::mat4& skinSpace);
+
+	/// Create an animator for another character with the same skeleton
+	/// The copy starts where this one is, but moves no meshes yet
+	/// @return The new animator
+	[[nodiscard]] std::shared_ptr<Animator> clone() const;
+
+	/// Play a clip
+	/// @param clipIndex Index of the clip
+	/// @param loop Start over at the end instead of holding the last pose
+	void play(size_t clipIndex, bool loop = true);
+
+	/// Play a clip by name
+	/// @param name Name of the animation in the model file
+	/// @param loop Start over at the end instead of holding the last pose
+	/// @return False if the skeleton has no clip of that name
+	bool play(const std::string& name, bool loop = true);
+
+	/// Stop playing and return to the rest pose
+	void stop();
+
+	/// Set how fast time passes for the clip, 1 is the speed it was made for
+	void setSpeed(float speed) { this->speed = speed; }
+	[[nodiscard]] float getSpeed() const { return this->speed; }
+
+	/// Set the time within the playing clip
+	void setTime(float time) { this->time = time; }
+	[[nodiscard]] float getTime() const { return this->time; }
+
+	/// Suspend or resume the animator
+	/// Suspended animators are neither evaluated nor skinned, their meshes keep the
+	/// last pose. Safe to call from any thread, it takes effect with the next update
+	void setSuspended(bool suspended) { this->suspended.store(suspended); }
+	[[nodiscard]] bool isSuspended() const { return this->suspended.load(); }
+
+	/// Get the clips the animator can play
+	[[nodiscard]] const std::vector<std::shared_ptr<const AnimationClip>>& getClips() const { return this->clips; }
+
+	/// Get the index of the playing clip, or -1 in the rest pose
+	[[nodiscard]] int getCurrentClip() const { return this->currentClip; }
+
+	/// Get the number of joints, and so of palette entries
+	[[nodiscard]] uint32_t getJointCount() const { return this->skeleton->getJointCount(); }
+
+	/// Move the playing clip's time forward
+	/// @param deltaTime Time step in seconds
+	void advance(float deltaTime);
+
+	/// Evaluate the joint palette for the current time
+	void evaluate();
+
+	/// Get the palette of the last evaluation, one 3x4 matrix per joint
+	[[nodiscard]] const std::vector<InstanceTransform>& getPalette() const { return this->palette; }
+
+	/// Get bounds that enclose a mesh in every pose of every clip
+	/// Skinned vertices lie between the positions their joints move them to, so each
+	/// joint's rest space bounds moved by the joint enclose the vertices it influences.
+	/// We take these over all frames, once: bounds never change while playing
+	/// @param jointBounds Bounds of the rest vertices each joint influences, per joint
+	/// @return The bounds in the space of the mesh's node
+	[[nodiscard]] scene::BoundingBox computeBounds(const std::vector<scene::BoundingBox>& jointBounds) const;
+
+private:
+	/// Compute each joint's skinning matrix for a pose
+	/// @param pose Local joint transforms
+	/// @param jointModels Scratch space for the joints' model transforms
+	/// @param skinMatrices One matrix per joint, written
+	void computeSkinMatrices(const Pose& pose,
+		std::vector<glm::mat4>& jointModels,
+		std::vector<glm::mat4>& skinMatrices) const;
+
+	std::shared_ptr<const Skeleton> skeleton;
+	std::vector<std::shared_ptr<const AnimationClip>> clips;
+	glm::mat4 skinSpace;
+
+	int currentClip{-1};
+	float time{0.0f};
+	float speed{1.0f};
+	bool looping{true};
+	std::atomic<bool> suspended{false};
+
+	/// Scratch state reused every evaluation
+	Pose pose;
+	std::vector<glm::mat4> jointModels;
+	std::vector<glm::mat4> skinMatrices;
+	std::vector<InstanceTransform> palette;
+
+	/// Meshes this animator moves, maintained by the AnimationSystem
+	std::vector<std::weak_ptr<SkinnedMesh>> meshes;
+	bool registered{false};
+};
+
+} /// namespace lillugsi::rendering::animation
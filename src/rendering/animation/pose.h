@@ -0,0 +1,94 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace lillugsi::rendering::animation {
+
+/// Pose holds the local transforms of all joints of a skeleton, component by component
+/// Sampling a clip blends every component of every joint the same way, so instead of
+/// one translation, rotation and scale per joint we store one array per component:
+/// all translation x values, then all translation y values, and so on. Four neighbouring
+/// joints of a component are then one SIMD register, and sampling is a single blend
+/// over a flat array of floats.
+///
+/// Arrays are padded to a multiple of four joints, padding lanes hold the identity
+/// transform so normalizing their rotations never divides by zero
+struct Pose {
+	/// Components of a joint transform, the index of each component's array
+	enum Component : uint32_t {
+		TranslationX, TranslationY, TranslationZ,
+		RotationX, RotationY, RotationZ, RotationW,
+		ScaleX, ScaleY, ScaleZ,
+		ComponentCount
+	};
+
+	/// Joints processed together, the width of an SSE register
+	static constexpr uint32_t LaneWidth = 4;
+
+	Pose() = default;
+
+	/// Create the identity pose of a skeleton
+	/// @param jointCount Number of joints in the skeleton
+	explicit Pose(uint32_t jointCount)
+		: jointCount(jointCount)
+		, laneCount((jointCount + LaneWidth - 1) / LaneWidth * LaneWidth)
+		, values(static_cast<size_t>(ComponentCount) * laneCount, 0.0f) {
+		for (uint32_t lane = 0; lane < this->laneCount; ++lane) {
+			this->component(RotationW)[lane] = 1.0f;
+			this->component(ScaleX)[lane] = 1.0f;
+			this->component(ScaleY)[lane] = 1.0f;
+			this->component(ScaleZ)[lane] = 1.0f;
+		}
+	}
+
+	/// Get the values of one component for all joints
+	[[nodiscard]] float* component(uint32_t index) {
+		return this->values.data() + static_cast<size_t>(index) * this->laneCount;
+	}
+	[[nodiscard]] const float* component(uint32_t index) const {
+		return this->values.data() + static_cast<size_t>(index) * this->laneCount;
+	}
+
+	/// Set the transform of a joint
+	void setJoint(uint32_t joint, const glm::vec3& translation, const glm::quat& rotation, const glm::vec3& scale) {
+		this->component(TranslationX)[joint] = translation.x;
+		this->component(TranslationY)[joint] = translation.y;
+		this->component(TranslationZ)[joint] = translation.z;
+		this->component(RotationX)[joint] = rotation.x;
+		this->component(RotationY)[joint] = rotation.y;
+		this->component(RotationZ)[joint] = rotation.z;
+		this->component(RotationW)[joint] = rotation.w;
+		this->component(ScaleX)[joint] = scale.x;
+		this->component(ScaleY)[joint] = scale.y;
+		this->component(ScaleZ)[joint] = scale.z;
+	}
+
+	/// Get the local transform matrix of a joint
+	/// Translation, rotation and scale combine like glTF node transforms: T * R * S
+	[[nodiscard]] glm::mat4 getJointMatrix(uint32_t joint) const {
+		const glm::quat rotation(
+			this->component(RotationW)[joint],
+			this->component(RotationX)[joint],
+			this->component(RotationY)[joint],
+			this->component(RotationZ)[joint]);
+		glm::mat4 matrix = glm::mat4_cast(rotation);
+		matrix[0] *= this->component(ScaleX)[joint];
+		matrix[1] *= this->component(ScaleY)[joint];
+		matrix[2] *= this->component(ScaleZ)[joint];
+		matrix[3] = glm::vec4(
+			this->component(TranslationX)[joint],
+			this->component(TranslationY)[joint],
+			this->component(TranslationZ)[joint],
+			1.0f);
+		return matrix;
+	}
+
+	uint32_t jointCount{0};
+	uint32_t laneCount{0};     /// jointCount rounded up to LaneWidth
+	std::vector<float> values; /// ComponentCount arrays of laneCount floats
+};
+
+} /// namespace lillugsi::rendering::animation
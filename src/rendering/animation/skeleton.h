@@ -0,0 +1,46 @@
+#pragma once
+
+#include "pose.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lillugsi::rendering::animation {
+
+/// Skeleton describes the joints of a skin and how they are bound to its vertices
+/// Joints are nodes of the model, but animating them as scene nodes would mean a
+/// transform update and a bounds update per joint and frame, for thousands of
+/// characters. The skeleton instead keeps the joint hierarchy apart from the scene:
+/// animators evaluate it into a flat array of matrices and never touch scene nodes.
+///
+/// Joint indices are those of the skin, which the vertices' joint indices refer to.
+/// Transforms are in the space of the model file, which the loader flips for its
+/// vertices, see Animator
+struct Skeleton {
+	/// Name of each joint, for lookups and logs
+	std::vector<std::string> names;
+
+	/// Parent of each joint, or -1 if its parent isn't a joint of the skin
+	std::vector<int32_t> parents;
+
+	/// Joints with every parent before its children, the order they are evaluated in
+	std::vector<uint32_t> evaluationOrder;
+
+	/// Model space transform above each joint whose parent isn't a joint, identity otherwise
+	/// Nodes between the model root and the skeleton don't move, so their transform is
+	/// multiplied in once per root joint
+	std::vector<glm::mat4> rootTransforms;
+
+	/// Inverse bind matrix of each joint, with the vertices' flipped Y axis folded in
+	/// Moves a vertex as the loader stores it into the joint's space at bind time
+	std::vector<glm::mat4> bindMatrices;
+
+	/// Local transform of each joint when no clip animates it
+	Pose restPose;
+
+	/// Get the number of joints
+	[[nodiscard]] uint32_t getJointCount() const { return static_cast<uint32_t>(this->parents.size()); }
+};
+
+} /// namespace lillugsi::rendering::animation
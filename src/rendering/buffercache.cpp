@@ -41,11 +41,13 @@ std::shared_ptr<vulkan::VertexBuffer> BufferCache::getOrCreateVertexBuffer(VkDev
 
 	/// Create the device-local buffer
 	/// Using VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
-	/// because this buffer will be the destination of a transfer and used as a vertex buffer
+	/// because this buffer will be the destination of a transfer and used as a vertex buffer.
+	/// TRANSFER_SRC lets the visibility buffer copy it into its geometry pool
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = bucketSize;  /// Use bucketed size for potential reuse
-	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+		| VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 	spdlog::debug("Creating device buffer - Create Info size: {}", bufferInfo.size);
@@ -160,10 +162,12 @@ std::shared_ptr<vulkan::IndexBuffer> BufferCache::getOrCreateIndexBuffer(VkDevic
 	spdlog::debug("Created staging index buffer - Handle: {}", (void*)stagingBuffer);
 
 	/// Create the device-local buffer
+	/// TRANSFER_SRC lets the visibility buffer copy it into its geometry pool
 	VkBufferCreateInfo bufferInfo{};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	bufferInfo.size = bucketSize;
-	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+		| VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
 	spdlog::debug("Creating device buffer - Create Info size: {}", bufferInfo.size);
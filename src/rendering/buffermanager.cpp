@@ -86,6 +86,156 @@ std::shared_ptr<vulkan::VertexBuffer> BufferManager::createVertexBuffer(
 	return vertexBuffer;
 }
 
+std::shared_ptr<vulkan::VertexBuffer> BufferManager::createVertexBuffer(
+	const std::vector<QuantizedVertex> &vertices) {
+	if (vertices.empty()) {
+		throw vulkan::VulkanException(
+			VK_ERROR_INITIALIZATION_FAILED,
+			"Cannot create vertex buffer with empty vertex list",
+			__FUNCTION__,
+			__FILE__,
+			__LINE__);
+	}
+
+	const VkDeviceSize bufferSize = vertices.size() * sizeof(QuantizedVertex);
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = bufferSize;
+	bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer;
+	VK_CHECK(vkCreateBuffer(this->device, &bufferInfo, nullptr, &buffer));
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(this->device, buffer, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = this->findMemoryType(
+		memRequirements.memoryTypeBits,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDeviceMemory bufferMemory;
+	VK_CHECK(vkAllocateMemory(this->device, &allocInfo, nullptr, &bufferMemory));
+	VK_CHECK(vkBindBufferMemory(this->device, buffer, bufferMemory, 0));
+
+	auto bufferHandle = vulkan::VulkanBufferHandle(
+		buffer,
+		[this](VkBuffer b) {
+			spdlog::debug("Destroying quantized vertex buffer - Handle: {}", (void*)b);
+			vkDestroyBuffer(this->device, b, nullptr);
+		});
+
+	auto vertexBuffer = std::make_shared<vulkan::VertexBuffer>(
+		this->device,
+		bufferMemory,
+		std::move(bufferHandle),
+		bufferSize,
+		static_cast<uint32_t>(vertices.size()),
+		sizeof(QuantizedVertex));
+
+	auto stagingBuffer = this->createStagingBuffer(bufferSize);
+	void *mapped = stagingBuffer->map(0, bufferSize);
+	memcpy(mapped, vertices.data(), bufferSize);
+	stagingBuffer->unmap();
+	this->copyBuffer(stagingBuffer->get(), vertexBuffer->get(), bufferSize);
+
+	spdlog::debug("Created quantized vertex buffer with {} vertices ({} bytes)", vertices.size(), bufferSize);
+
+	return vertexBuffer;
+}
+
+std::shared_ptr<vulkan::VertexBuffer> BufferManager::createStorageVertexBuffer(
+	const std::vector<Vertex> &vertices) {
+	if (vertices.empty()) {
+		throw vulkan::VulkanException(
+			VK_ERROR_INITIALIZATION_FAILED,
+			"Cannot create vertex buffer with empty vertex list",
+			__FUNCTION__,
+			__FILE__,
+			__LINE__);
+	}
+
+	auto vertexBuffer = this->allocateStorageVertexBuffer(static_cast<uint32_t>(vertices.size()));
+	const VkDeviceSize bufferSize = vertexBuffer->getSize();
+
+	/// Upload the initial vertices
+	auto stagingBuffer = this->createStagingBuffer(bufferSize);
+	void *mapped = stagingBuffer->map(0, bufferSize);
+	memcpy(mapped, vertices.data(), bufferSize);
+	stagingBuffer->unmap();
+	this->copyBuffer(stagingBuffer->get(), vertexBuffer->get(), bufferSize);
+
+	spdlog::debug("Created storage vertex buffer with {} vertices ({} bytes)", vertices.size(), bufferSize);
+
+	return vertexBuffer;
+}
+
+std::shared_ptr<vulkan::VertexBuffer> BufferManager::createStorageVertexBuffer(
+	const vulkan::VertexBuffer &source) {
+	auto vertexBuffer = this->allocateStorageVertexBuffer(source.getVertexCount());
+
+	/// The vertices are on the GPU already, so they never pass through host memory
+	this->copyBuffer(source.get(), vertexBuffer->get(), vertexBuffer->getSize());
+
+	spdlog::debug("Created storage vertex buffer copying {} vertices", source.getVertexCount());
+
+	return vertexBuffer;
+}
+
+std::shared_ptr<vulkan::VertexBuffer> BufferManager::allocateStorageVertexBuffer(uint32_t vertexCount) {
+	const VkDeviceSize bufferSize = static_cast<VkDeviceSize>(vertexCount) * sizeof(Vertex);
+
+	/// Transfer source as well, so other passes can copy the generated vertices
+	const VkBufferUsageFlags usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
+		| VK_BUFFER_USAGE_STORAGE_BUFFER_BIT
+		| VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		| VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = bufferSize;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer;
+	VK_CHECK(vkCreateBuffer(this->device, &bufferInfo, nullptr, &buffer));
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(this->device, buffer, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = this->findMemoryType(
+		memRequirements.memoryTypeBits,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDeviceMemory bufferMemory;
+	VK_CHECK(vkAllocateMemory(this->device, &allocInfo, nullptr, &bufferMemory));
+	VK_CHECK(vkBindBufferMemory(this->device, buffer, bufferMemory, 0));
+
+	auto bufferHandle = vulkan::VulkanBufferHandle(
+		buffer,
+		[this](VkBuffer b) {
+			spdlog::debug("Destroying storage vertex buffer - Handle: {}", (void*)b);
+			vkDestroyBuffer(this->device, b, nullptr);
+		});
+
+	auto vertexBuffer = std::make_shared<vulkan::VertexBuffer>(
+		this->device,
+		bufferMemory,
+		std::move(bufferHandle),
+		bufferSize,
+		vertexCount,
+		sizeof(Vertex));
+
+	return vertexBuffer;
+}
+
 std::shared_ptr<vulkan::IndexBuffer> BufferManager::createIndexBuffer(
 	const std::vector<uint32_t> &indices) {
 	if (indices.empty()) {
@@ -165,6 +315,61 @@ std::shared_ptr<vulkan::Buffer> BufferManager::createStorageBuffer(
 	return buffer;
 }
 
+std::shared_ptr<vulkan::Buffer> BufferManager::createDeviceStorageBuffer(
+	VkDeviceSize size, const void *data) {
+	/// Never mapped, so device local memory is the fastest choice
+	/// Initial data arrives through a staging copy, which needs transfer usage
+	auto buffer = this->createBuffer(
+		size,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	if (data) {
+		this->updateBuffer(buffer, data, size, 0);
+	}
+
+	/// Generate a unique key for tracking based on buffer handle
+	std::string key = "storage_" + std::to_string(reinterpret_cast<uint64_t>(buffer->get()));
+	this->uniformBuffers[key] = buffer;
+
+	spdlog::debug("Created device storage buffer of size {} bytes", size);
+
+	return buffer;
+}
+
+std::shared_ptr<vulkan::Buffer> BufferManager::createInstanceBuffer(VkDeviceSize size) {
+	auto buffer = this->createBuffer(
+		size,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	/// Generate a unique key for tracking based on buffer handle
+	std::string key = "instance_" + std::to_string(reinterpret_cast<uint64_t>(buffer->get()));
+	this->uniformBuffers[key] = buffer;
+
+	spdlog::debug("Created instance buffer of size {} bytes", size);
+
+	return buffer;
+}
+
+std::shared_ptr<vulkan::Buffer> BufferManager::createInstanceBuffer(
+	VkDeviceSize size, const void *data) {
+	auto buffer = this->createBuffer(
+		size,
+		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	this->updateBuffer(buffer, data, size, 0);
+
+	/// Generate a unique key for tracking based on buffer handle
+	std::string key = "instance_" + std::to_string(reinterpret_cast<uint64_t>(buffer->get()));
+	this->uniformBuffers[key] = buffer;
+
+	spdlog::debug("Created static instance buffer of size {} bytes", size);
+
+	return buffer;
+}
+
 std::shared_ptr<vulkan::Buffer> BufferManager::createStagingBuffer(
 	VkDeviceSize size) {
 
@@ -210,6 +415,46 @@ std::shared_ptr<vulkan::Buffer> BufferManager::createStagingBuffer(
 		VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
 }
 
+std::shared_ptr<vulkan::Buffer> BufferManager::createReadbackBuffer(VkDeviceSize size) {
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer;
+	VK_CHECK(vkCreateBuffer(this->device, &bufferInfo, nullptr, &buffer));
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(this->device, buffer, &memRequirements);
+
+	/// Host coherent so the copied data is visible without invalidating ranges
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = this->findMemoryType(
+		memRequirements.memoryTypeBits,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	VkDeviceMemory bufferMemory;
+	VK_CHECK(vkAllocateMemory(this->device, &allocInfo, nullptr, &bufferMemory));
+	VK_CHECK(vkBindBufferMemory(this->device, buffer, bufferMemory, 0));
+
+	auto bufferHandle = vulkan::VulkanBufferHandle(
+		buffer,
+		[this](VkBuffer b) {
+			spdlog::debug("Destroying readback buffer - Handle: {}", (void*)b);
+			vkDestroyBuffer(this->device, b, nullptr);
+		});
+
+	return std::make_shared<vulkan::Buffer>(
+		this->device,
+		bufferMemory,
+		std::move(bufferHandle),
+		size,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+}
+
 void BufferManager::updateBuffer(
 	std::shared_ptr<vulkan::Buffer> buffer,
 	const void* data,
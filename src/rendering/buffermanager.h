@@ -80,6 +80,26 @@ public:
 	/// @return A shared pointer to the created vertex buffer
 	std::shared_ptr<vulkan::VertexBuffer> createVertexBuffer(const std::vector<Vertex> &vertices);
 
+	/// Create a vertex buffer of quantized vertices
+	/// The buffer cache assumes the Vertex stride for the buffers it hands out,
+	/// so quantized buffers are allocated on their own
+	/// @param vertices The compact vertex data to upload to the buffer
+	/// @return A shared pointer to the created vertex buffer, with the QuantizedVertex stride
+	std::shared_ptr<vulkan::VertexBuffer> createVertexBuffer(const std::vector<QuantizedVertex> &vertices);
+
+	/// Create a vertex buffer compute shaders can write
+	/// Cached vertex buffers are shared between meshes of the same size, so a mesh whose
+	/// vertices are generated on the GPU needs a buffer of its own with storage usage
+	/// @param vertices The initial vertex data
+	/// @return A shared pointer to the created vertex buffer
+	std::shared_ptr<vulkan::VertexBuffer> createStorageVertexBuffer(const std::vector<Vertex> &vertices);
+
+	/// Create a vertex buffer compute shaders can write, starting as a copy of another
+	/// For meshes that each transform the same source vertices into a buffer of their own
+	/// @param source Vertex buffer with the Vertex stride to copy on the GPU
+	/// @return A shared pointer to the created vertex buffer
+	std::shared_ptr<vulkan::VertexBuffer> createStorageVertexBuffer(const vulkan::VertexBuffer &source);
+
 	/// Create an index buffer with the given data
 	/// @param indices The index data to upload to the buffer
 	/// @return A shared pointer to the created index buffer
@@ -99,11 +119,39 @@ public:
 	std::shared_ptr<vulkan::Buffer> createStorageBuffer(
 		VkDeviceSize size, const void *data = nullptr);
 
+	/// Create a device local storage buffer
+	/// For data that is written and read by the GPU only, like the results of compute passes,
+	/// or uploaded once and then only read by shaders
+	/// @param size The size of the buffer in bytes
+	/// @param data Optional pointer to initial data, uploaded through a staging buffer
+	/// @return A shared pointer to the created buffer
+	std::shared_ptr<vulkan::Buffer> createDeviceStorageBuffer(VkDeviceSize size, const void *data = nullptr);
+
+	/// Create a host visible buffer of per-instance vertex attributes
+	/// Instance data is usually rewritten every frame, so it stays mappable
+	/// @param size The size of the buffer in bytes
+	/// @return A shared pointer to the created buffer
+	std::shared_ptr<vulkan::Buffer> createInstanceBuffer(VkDeviceSize size);
+
+	/// Create a device local buffer of per-instance vertex attributes that never change
+	/// Static instances are read every frame but written once, so they belong in
+	/// device local memory like vertex buffers
+	/// @param size The size of the buffer in bytes
+	/// @param data The instance data, uploaded through a staging buffer
+	/// @return A shared pointer to the created buffer
+	std::shared_ptr<vulkan::Buffer> createInstanceBuffer(VkDeviceSize size, const void *data);
+
 	/// Create a staging buffer for temporary transfers
 	/// @param size The size of the buffer in bytes
 	/// @return A shared pointer to the created buffer
 	std::shared_ptr<vulkan::Buffer> createStagingBuffer(VkDeviceSize size);
 
+	/// Create a host visible buffer the GPU copies results into
+	/// The counterpart of a staging buffer, for reading images and buffers back
+	/// @param size The size of the buffer in bytes
+	/// @return A shared pointer to the created buffer
+	std::shared_ptr<vulkan::Buffer> createReadbackBuffer(VkDeviceSize size);
+
 	/// Update a buffer with new data
 	/// Uses staging buffer for device-local buffers
 	/// @param buffer The buffer to update
@@ -159,6 +207,11 @@ private:
 	std::shared_ptr<vulkan::Buffer> createBuffer(
 		VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
 
+	/// Allocate a device local vertex buffer with storage usage, without contents
+	/// @param vertexCount Number of vertices with the Vertex stride
+	/// @return A shared pointer to the created vertex buffer
+	std::shared_ptr<vulkan::VertexBuffer> allocateStorageVertexBuffer(uint32_t vertexCount);
+
 	/// Create a command pool for transfer operations
 	/// @param graphicsQueueFamilyIndex The queue family index for the command pool
 	/// @return True if creation was successful
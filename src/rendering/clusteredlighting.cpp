@@ -0,0 +1,181 @@
+#include "clusteredlighting.h"
+#include "lightmanager.h"
+#include "vulkan/shadermodule.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace lillugsi::rendering {
+
+ClusteredLighting::ClusteredLighting(VkDevice device, std::shared_ptr<BufferManager> bufferManager)
+	: device(device)
+	, bufferManager(std::move(bufferManager)) {
+}
+
+ClusteredLighting::~ClusteredLighting() {
+	this->cleanup();
+}
+
+void ClusteredLighting::initialize(VkDescriptorSetLayout cameraLayout, VkDescriptorSetLayout lightLayout) {
+	this->createBuffers();
+	this->createPipeline(cameraLayout, lightLayout);
+
+	spdlog::info("Clustered lighting initialized with {}x{}x{} clusters",
+		ClusterCountX, ClusterCountY, ClusterCountZ);
+}
+
+void ClusteredLighting::cleanup() {
+	this->pipeline.reset();
+	this->pipelineLayout.reset();
+
+	if (this->mappedLights) {
+		this->lightBuffer->unmap();
+		this->mappedLights = nullptr;
+	}
+	if (this->mappedParams) {
+		this->paramsBuffer->unmap();
+		this->mappedParams = nullptr;
+	}
+
+	this->lightIndexBuffer.reset();
+	this->clusterBuffer.reset();
+	this->lightBuffer.reset();
+	this->paramsBuffer.reset();
+}
+
+void ClusteredLighting::createBuffers() {
+	ClusterParams initialParams{};
+	initialParams.view = glm::mat4(1.0f);
+	initialParams.inverseProjection = glm::mat4(1.0f);
+	initialParams.gridSize = glm::uvec4(ClusterCountX, ClusterCountY, ClusterCountZ, MaxLightsPerCluster);
+	initialParams.depthSlicing = glm::vec4(0.1f, 100.0f, 0.0f, 0.0f);
+	initialParams.renderExtent = glm::vec2(1.0f);
+
+	this->paramsBuffer = this->bufferManager->createUniformBuffer(sizeof(ClusterParams), &initialParams);
+	this->lightBuffer = this->bufferManager->createStorageBuffer(sizeof(LightData) * LightManager::MaxLights);
+
+	/// Both are rewritten every frame, mapping once saves a map/unmap pair per update
+	this->mappedParams = static_cast<ClusterParams*>(this->paramsBuffer->map(0, sizeof(ClusterParams)));
+	this->mappedLights = static_cast<LightData*>(
+		this->lightBuffer->map(0, sizeof(LightData) * LightManager::MaxLights));
+
+	this->clusterBuffer = this->bufferManager->createDeviceStorageBuffer(sizeof(uint32_t) * ClusterCount);
+	this->lightIndexBuffer = this->bufferManager->createDeviceStorageBuffer(
+		sizeof(uint32_t) * ClusterCount * MaxLightsPerCluster);
+
+	spdlog::info("Light buffers created for up to {} lights", LightManager::MaxLights);
+}
+
+void ClusteredLighting::createPipeline(VkDescriptorSetLayout cameraLayout, VkDescriptorSetLayout lightLayout) {
+	/// The culling shader only uses set 1, but we keep the camera layout at set 0
+	/// so the light set has the same index in every shader
+	std::array<VkDescriptorSetLayout, 2> setLayouts = {cameraLayout, lightLayout};
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	layoutInfo.pSetLayouts = setLayouts.data();
+
+	VkPipelineLayout layout;
+	VK_CHECK(vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &layout));
+
+	this->pipelineLayout = vulkan::VulkanPipelineLayoutHandle(layout, [device = this->device](VkPipelineLayout l) {
+		vkDestroyPipelineLayout(device, l, nullptr);
+	});
+
+	auto shaderModule = vulkan::ShaderModule::fromSpirV(this->device, CullShaderPath, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shaderModule.getStageCreateInfo();
+	pipelineInfo.layout = layout;
+
+	VkPipeline rawPipeline;
+	VK_CHECK(vkCreateComputePipelines(this->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &rawPipeline));
+
+	this->pipeline = vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+}
+
+void ClusteredLighting::writeDescriptorSet(VkDescriptorSet descriptorSet) const {
+	std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+	bufferInfos[0] = {this->paramsBuffer->get(), 0, sizeof(ClusterParams)};
+	bufferInfos[1] = {this->lightBuffer->get(), 0, VK_WHOLE_SIZE};
+	bufferInfos[2] = {this->clusterBuffer->get(), 0, VK_WHOLE_SIZE};
+	bufferInfos[3] = {this->lightIndexBuffer->get(), 0, VK_WHOLE_SIZE};
+
+	std::array<VkWriteDescriptorSet, 4> writes{};
+	for (uint32_t i = 0; i < writes.size(); ++i) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = descriptorSet;
+		writes[i].dstBinding = i;
+		writes[i].dstArrayElement = 0;
+		writes[i].descriptorType = i == 0
+			? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+			: VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].descriptorCount = 1;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+
+	vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void ClusteredLighting::update(const FrameSnapshot& snapshot) {
+	/// LightManager caps the light count, but a snapshot is plain data, so we clamp again
+	this->lightCount = static_cast<uint32_t>(std::min<size_t>(snapshot.lights.size(), LightManager::MaxLights));
+	if (this->lightCount > 0) {
+		std::memcpy(this->mappedLights, snapshot.lights.data(), sizeof(LightData) * this->lightCount);
+	}
+
+	/// Slices are spaced logarithmically between the clip planes:
+	/// slice = log(depth) * scale + bias maps near to 0 and far to ClusterCountZ
+	const float nearPlane = snapshot.nearPlane;
+	const float farPlane = std::max(snapshot.farPlane, nearPlane * 1.001f);
+	const float logRange = std::log(farPlane / nearPlane);
+
+	ClusterParams& params = *this->mappedParams;
+	params.view = snapshot.view;
+	params.inverseProjection = glm::inverse(snapshot.projection);
+	params.gridSize = glm::uvec4(ClusterCountX, ClusterCountY, ClusterCountZ, MaxLightsPerCluster);
+	params.depthSlicing = glm::vec4(
+		nearPlane,
+		farPlane,
+		static_cast<float>(ClusterCountZ) / logRange,
+		-static_cast<float>(ClusterCountZ) * std::log(nearPlane) / logRange);
+	params.directionalLightCount = std::min(snapshot.directionalLightCount, this->lightCount);
+	params.lightCount = this->lightCount;
+}
+
+void ClusteredLighting::record(VkCommandBuffer commandBuffer, VkDescriptorSet lightSet, VkExtent2D renderExtent) {
+	/// The render extent is only known while recording, it still lands before the submit
+	this->mappedParams->renderExtent = glm::vec2(renderExtent.width, renderExtent.height);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline.get());
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		this->pipelineLayout.get(),
+		1, 1, &lightSet,
+		0, nullptr);
+
+	/// One workgroup per cluster
+	vkCmdDispatch(commandBuffer, ClusterCountX, ClusterCountY, ClusterCountZ);
+
+	/// Cluster lists are read by fragment shaders and the visibility buffer shading pass
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+}
+
+} /// namespace lillugsi::rendering
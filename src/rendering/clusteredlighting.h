@@ -0,0 +1,110 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include "vulkan/buffer.h"
+#include "buffermanager.h"
+#include "framesnapshot.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <memory>
+
+namespace lillugsi::rendering {
+
+/// ClusteredLighting owns the light buffers and the light culling pass
+/// Looping over every light for every pixel makes shading cost grow with the total
+/// number of lights. Point and spot lights only reach a limited range though, so we
+/// divide the view frustum into clusters (screen tiles times logarithmic depth slices)
+/// and let a compute pass list the local lights touching each cluster.
+/// Shaders then only evaluate the directional lights and the lights of their cluster,
+/// so the cost per pixel follows the local light density instead.
+///
+/// All buffers are bound through the global light descriptor set (set = 1):
+/// binding 0 cluster parameters, 1 lights, 2 light count per cluster, 3 light indices.
+/// The layout of these matches clusteredlights.glsl
+class ClusteredLighting {
+public:
+	static constexpr const char* CullShaderPath = "shaders/lightcull.comp.spv";
+
+	/// Cluster grid size
+	/// 16x9 tiles fit common aspect ratios, 24 depth slices keep clusters
+	/// roughly cubic for typical near/far ratios
+	static constexpr uint32_t ClusterCountX = 16;
+	static constexpr uint32_t ClusterCountY = 9;
+	static constexpr uint32_t ClusterCountZ = 24;
+	static constexpr uint32_t ClusterCount = ClusterCountX * ClusterCountY * ClusterCountZ;
+
+	/// Maximum number of local lights per cluster, further lights in a cluster are dropped
+	static constexpr uint32_t MaxLightsPerCluster = 256;
+
+	/// Constructor
+	/// @param device The logical device to create the pipeline on
+	/// @param bufferManager Buffer manager to allocate the light buffers from
+	ClusteredLighting(VkDevice device, std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor
+	~ClusteredLighting();
+
+	/// Create the buffers and the culling pipeline
+	/// @param cameraLayout Global camera descriptor set layout (set = 0)
+	/// @param lightLayout Global light descriptor set layout (set = 1)
+	void initialize(VkDescriptorSetLayout cameraLayout, VkDescriptorSetLayout lightLayout);
+
+	/// Release all Vulkan resources
+	void cleanup();
+
+	/// Point a light descriptor set at our buffers
+	/// @param descriptorSet Descriptor set allocated with the global light layout
+	void writeDescriptorSet(VkDescriptorSet descriptorSet) const;
+
+	/// Upload the lights and camera of a frame
+	/// The GPU must no longer read the buffers, which the in-flight fence guarantees
+	/// @param snapshot The frame's snapshot
+	void update(const FrameSnapshot& snapshot);
+
+	/// Record the light culling pass
+	/// Must be recorded outside of a render pass, before anything reads the lights
+	/// @param commandBuffer The command buffer being recorded
+	/// @param lightSet Light descriptor set of this frame
+	/// @param renderExtent Part of the targets rendered this frame
+	void record(VkCommandBuffer commandBuffer, VkDescriptorSet lightSet, VkExtent2D renderExtent);
+
+	/// Get the number of lights uploaded for the current frame
+	[[nodiscard]] uint32_t getLightCount() const { return this->lightCount; }
+
+private:
+	/// Cluster parameters uniform buffer
+	/// Layout matches ClusterParams in clusteredlights.glsl (std140)
+	struct ClusterParams {
+		glm::mat4 view;
+		glm::mat4 inverseProjection;
+		glm::uvec4 gridSize;        /// Clusters in x, y and z, max lights per cluster in w
+		glm::vec4 depthSlicing;     /// Near plane, far plane, scale and bias of the depth slices
+		glm::vec2 renderExtent;
+		uint32_t directionalLightCount;
+		uint32_t lightCount;
+	};
+
+	void createBuffers();
+	void createPipeline(VkDescriptorSetLayout cameraLayout, VkDescriptorSetLayout lightLayout);
+
+	VkDevice device;
+	std::shared_ptr<BufferManager> bufferManager;
+
+	/// Host visible, persistently mapped and rewritten every frame
+	std::shared_ptr<vulkan::Buffer> paramsBuffer;
+	std::shared_ptr<vulkan::Buffer> lightBuffer;
+	ClusterParams* mappedParams{nullptr};
+	LightData* mappedLights{nullptr};
+
+	/// Written by the culling pass, read by shading
+	std::shared_ptr<vulkan::Buffer> clusterBuffer;
+	std::shared_ptr<vulkan::Buffer> lightIndexBuffer;
+
+	vulkan::VulkanPipelineLayoutHandle pipelineLayout;
+	vulkan::VulkanPipelineHandle pipeline;
+
+	uint32_t lightCount{0};
+};
+
+} /// namespace lillugsi::rendering
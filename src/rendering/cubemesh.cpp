@@ -80,6 +80,7 @@ void CubeMesh::generateGeometry() {
 
 void CubeMesh::setFaceColors(const std::vector<glm::vec3>& colors) {
 	if (colors.size() == 6) {
+		this->detachSharedGeometry();
 		this->faceColors = colors;
 		this->generateGeometry();
 	}
@@ -14,7 +14,13 @@ public:
 
 	void generateGeometry() override;
 
+	/// Cubes of the same size share their geometry until their face colors change
+	[[nodiscard]] std::optional<GeometryKey> getGeometryKey() const override {
+		return GeometryKey{ProceduralGeometryType::Cube, 0, this->sideLength};
+	}
+
 	/// Set colors for each face of the cube
+	/// A cube sharing its geometry gets its own copy, the others keep the default colors
 	void setFaceColors(const std::vector<glm::vec3>& colors);
 
 private:
@@ -0,0 +1,92 @@
+#include "dynamicresolution.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+
+namespace lillugsi::rendering {
+
+namespace {
+/// Weight of a new sample in the smoothed GPU time
+constexpr float SmoothingFactor = 0.2f;
+
+/// We only scale up below this fraction of the target,
+/// otherwise the scale would oscillate around the budget
+constexpr float IncreaseThreshold = 0.85f;
+
+/// Largest change per frame, dropping faster than rising
+constexpr float MaxDecreasePerFrame = 0.1f;
+constexpr float MaxIncreasePerFrame = 0.02f;
+
+/// Scale granularity, changes smaller than this aren't worth a visible jump
+constexpr float ScaleStep = 1.0f / 32.0f;
+}
+
+float DynamicResolutionController::update(float gpuTimeMs) {
+	if (!this->enabled) {
+		this->scale = this->maxScale;
+		return this->scale;
+	}
+
+	/// Smooth the measurement, single slow frames shouldn't drop the resolution
+	if (!this->hasSample) {
+		this->smoothedGpuTimeMs = gpuTimeMs;
+		this->hasSample = true;
+	} else {
+		this->smoothedGpuTimeMs += (gpuTimeMs - this->smoothedGpuTimeMs) * SmoothingFactor;
+	}
+
+	if (this->smoothedGpuTimeMs <= 0.0f) {
+		return this->scale;
+	}
+
+	const float ratio = this->targetGpuTimeMs / this->smoothedGpuTimeMs;
+
+	/// Inside the dead band between threshold and target we keep the scale
+	if (ratio >= 1.0f && ratio * IncreaseThreshold < 1.0f) {
+		return this->scale;
+	}
+
+	/// Pixel count scales with scale², so the time ratio needs a square root
+	const float desired = this->scale * std::sqrt(ratio);
+	const float limited = std::clamp(desired,
+		this->scale - MaxDecreasePerFrame,
+		this->scale + MaxIncreasePerFrame);
+
+	const float newScale = this->snapScale(limited);
+	if (newScale != this->scale) {
+		spdlog::debug("Render scale {:.3f} -> {:.3f} (GPU {:.2f} ms, target {:.2f} ms)",
+			this->scale, newScale, this->smoothedGpuTimeMs, this->targetGpuTimeMs);
+		this->scale = newScale;
+	}
+
+	return this->scale;
+}
+
+void DynamicResolutionController::setTargetGpuTime(float milliseconds) {
+	this->targetGpuTimeMs = std::max(milliseconds, 0.1f);
+}
+
+void DynamicResolutionController::setScaleRange(float minScale, float maxScale) {
+	this->maxScale = std::clamp(maxScale, ScaleStep, 1.0f);
+	this->minScale = std::clamp(minScale, ScaleStep, this->maxScale);
+	this->scale = std::clamp(this->scale, this->minScale, this->maxScale);
+}
+
+void DynamicResolutionController::setEnabled(bool enabled) {
+	this->enabled = enabled;
+	if (!enabled) {
+		this->scale = this->maxScale;
+		this->hasSample = false;
+	}
+}
+
+float DynamicResolutionController::snapScale(float value) const {
+	/// Going down we always take at least one step, being over budget is what we want to fix.
+	/// Going up we round to the nearest step, so tiny headroom doesn't bump the scale
+	const float steps = value < this->scale
+		? std::floor(value / ScaleStep)
+		: std::round(value / ScaleStep);
+	return std::clamp(steps * ScaleStep, this->minScale, this->maxScale);
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,70 @@
+#pragma once
+
+namespace lillugsi::rendering {
+
+/// DynamicResolutionController picks the render scale from measured GPU frame times
+/// The scene is rendered at scale * swap chain extent and upscaled afterwards.
+/// Fragment cost grows with the pixel count, which is proportional to scale²,
+/// so we correct the scale by the square root of target / measured time.
+///
+/// To keep the image from visibly pumping we:
+/// - smooth the measured GPU time
+/// - react quickly when over budget but only scale up when clearly under budget
+/// - limit the change per frame and snap the scale to coarse steps
+class DynamicResolutionController {
+public:
+	/// Lowest scale we go down to by default
+	/// Below half resolution the upscaled image gets too blurry to be useful
+	static constexpr float DefaultMinScale = 0.5f;
+
+	/// Target GPU time for a 60 Hz display, with some room for presentation
+	static constexpr float DefaultTargetGpuTimeMs = 14.0f;
+
+	DynamicResolutionController() = default;
+
+	/// Feed the GPU time of the last frame and get the scale for the next one
+	/// @param gpuTimeMs Measured GPU time of the last frame in milliseconds
+	/// @return Render scale in [minScale, maxScale]
+	float update(float gpuTimeMs);
+
+	/// Set the GPU time we try to stay under
+	/// @param milliseconds Target GPU frame time
+	void setTargetGpuTime(float milliseconds);
+
+	/// Set the range the scale may move in
+	/// @param minScale Lowest allowed scale, > 0
+	/// @param maxScale Highest allowed scale, <= 1
+	void setScaleRange(float minScale, float maxScale);
+
+	/// Enable or disable the controller
+	/// When disabled, the scale returns to maxScale
+	/// @param enabled True to adapt the scale to the GPU time
+	void setEnabled(bool enabled);
+
+	/// Get the scale chosen by the last update
+	/// @return Current render scale
+	[[nodiscard]] float getScale() const { return this->scale; }
+
+	/// Get the smoothed GPU time the controller works with
+	/// @return Smoothed GPU time in milliseconds
+	[[nodiscard]] float getSmoothedGpuTime() const { return this->smoothedGpuTimeMs; }
+
+	[[nodiscard]] bool isEnabled() const { return this->enabled; }
+	[[nodiscard]] float getTargetGpuTime() const { return this->targetGpuTimeMs; }
+
+private:
+	/// Snap a scale to the step grid and clamp it to the allowed range
+	/// @param value Unsnapped scale
+	/// @return Snapped and clamped scale
+	[[nodiscard]] float snapScale(float value) const;
+
+	float scale{1.0f};
+	float minScale{DefaultMinScale};
+	float maxScale{1.0f};
+	float targetGpuTimeMs{DefaultTargetGpuTimeMs};
+	float smoothedGpuTimeMs{0.0f};
+	bool hasSample{false};
+	bool enabled{true};
+};
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,867 @@
+#include "environmentlighting.h"
+#include "vulkan/shadermodule.h"
+#include "vulkan/vulkanutils.h"
+#include <glm/gtc/packing.hpp>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace lillugsi::rendering {
+
+namespace {
+/// Both images are RGBA16F: storage writes to it need no optional device feature,
+/// which the two channel format would for the lookup table
+constexpr VkFormat ImageFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr VkDeviceSize PixelBytes = 8;
+
+constexpr uint32_t CubeFaceCount = 6;
+constexpr uint32_t SphericalHarmonicsCount = 9;
+
+/// Multiplier of the environment's radiance
+constexpr float Intensity = 1.0f;
+
+constexpr char CacheMagic[4] = {'L', 'I', 'B', 'L'};
+}
+
+EnvironmentLighting::EnvironmentLighting(VkDevice device,
+	VkPhysicalDevice physicalDevice,
+	VkQueue queue,
+	VkCommandPool commandPool,
+	std::shared_ptr<vulkan::CommandBufferManager> commandBufferManager,
+	std::shared_ptr<BufferManager> bufferManager)
+	: device(device)
+	, physicalDevice(physicalDevice)
+	, queue(queue)
+	, commandPool(commandPool)
+	, commandBufferManager(std::move(commandBufferManager))
+	, bufferManager(std::move(bufferManager)) {
+}
+
+EnvironmentLighting::~EnvironmentLighting() {
+	this->cleanup();
+}
+
+void EnvironmentLighting::initialize(const std::string& sourcePath, const std::string& cacheDirectory) {
+	this->createImages();
+	this->createSamplers();
+
+	std::vector<uint8_t> sourceBytes;
+	{
+		std::ifstream file(sourcePath, std::ios::binary | std::ios::ate);
+		if (file) {
+			sourceBytes.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(reinterpret_cast<char*>(sourceBytes.data()), static_cast<std::streamsize>(sourceBytes.size()));
+		}
+	}
+
+	if (sourceBytes.empty()) {
+		spdlog::warn("Environment map '{}' not found, using constant ambient light", sourcePath);
+		this->clearImages();
+	} else {
+		const uint64_t cacheKey = computeCacheKey(sourceBytes);
+		char fileName[32];
+		std::snprintf(fileName, sizeof(fileName), "%016llx.ibl", static_cast<unsigned long long>(cacheKey));
+		const std::string cachePath = (std::filesystem::path(cacheDirectory) / fileName).string();
+
+		if (this->loadCache(cachePath, cacheKey)) {
+			spdlog::info("Loaded baked environment '{}' from cache '{}'", sourcePath, cachePath);
+			this->enabled = true;
+		} else if (this->bake(sourceBytes, cachePath, cacheKey)) {
+			spdlog::info("Baked environment '{}' into cache '{}'", sourcePath, cachePath);
+			this->enabled = true;
+		} else {
+			this->clearImages();
+		}
+	}
+
+	this->params.settings = glm::vec4(
+		static_cast<float>(MipCount - 1),
+		Intensity,
+		this->enabled ? 1.0f : 0.0f,
+		0.0f);
+	this->paramsBuffer = this->bufferManager->createUniformBuffer(sizeof(EnvironmentParams), &this->params);
+}
+
+void EnvironmentLighting::cleanup() {
+	this->paramsBuffer.reset();
+
+	this->brdfPipeline.reset();
+	this->irradiancePipeline.reset();
+	this->prefilterPipeline.reset();
+	this->bakePipelineLayout.reset();
+	this->bakeSetLayout.reset();
+
+	this->lutSampler.reset();
+	this->cubeSampler.reset();
+
+	this->lutView.reset();
+	this->cubeView.reset();
+	this->lutImage.reset();
+	this->lutMemory.reset();
+	this->cubeImage.reset();
+	this->cubeMemory.reset();
+
+	this->enabled = false;
+}
+
+void EnvironmentLighting::createImages() {
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = ImageFormat;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	/// Written by the bake shaders or by uploading the cache, read back for the cache
+	imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT
+		| VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+	imageInfo.extent = {CubeSize, CubeSize, 1};
+	imageInfo.mipLevels = MipCount;
+	imageInfo.arrayLayers = CubeFaceCount;
+
+	VkImage image;
+	VK_CHECK(vkCreateImage(this->device, &imageInfo, nullptr, &image));
+	this->cubeImage = vulkan::VulkanImageHandle(image, [device = this->device](VkImage i) {
+		vkDestroyImage(device, i, nullptr);
+	});
+	this->cubeMemory = this->allocateImageMemory(image);
+
+	imageInfo.flags = 0;
+	imageInfo.extent = {BrdfLutSize, BrdfLutSize, 1};
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+
+	VK_CHECK(vkCreateImage(this->device, &imageInfo, nullptr, &image));
+	this->lutImage = vulkan::VulkanImageHandle(image, [device = this->device](VkImage i) {
+		vkDestroyImage(device, i, nullptr);
+	});
+	this->lutMemory = this->allocateImageMemory(image);
+
+	this->cubeView = this->createView(this->cubeImage.get(),
+		VK_IMAGE_VIEW_TYPE_CUBE, ImageFormat, 0, MipCount, CubeFaceCount);
+	this->lutView = this->createView(this->lutImage.get(),
+		VK_IMAGE_VIEW_TYPE_2D, ImageFormat, 0, 1, 1);
+}
+
+void EnvironmentLighting::createSamplers() {
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = static_cast<float>(MipCount - 1);
+
+	VkSampler rawSampler;
+	VK_CHECK(vkCreateSampler(this->device, &samplerInfo, nullptr, &rawSampler));
+	this->cubeSampler = vulkan::VulkanSamplerHandle(rawSampler, [device = this->device](VkSampler s) {
+		vkDestroySampler(device, s, nullptr);
+	});
+
+	/// The lookup table has a single mip, clamping keeps NdotV = 1 off the opposite edge
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.maxLod = 0.0f;
+
+	VK_CHECK(vkCreateSampler(this->device, &samplerInfo, nullptr, &rawSampler));
+	this->lutSampler = vulkan::VulkanSamplerHandle(rawSampler, [device = this->device](VkSampler s) {
+		vkDestroySampler(device, s, nullptr);
+	});
+}
+
+void EnvironmentLighting::createBakePipelines() {
+	/// One layout for all bake shaders, each uses the bindings it needs:
+	/// 0 source environment, 1 one mip of the cube map, 2 lookup table, 3 irradiance
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); ++i) {
+		bindings[i].binding = i;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	setLayoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout setLayout;
+	VK_CHECK(vkCreateDescriptorSetLayout(this->device, &setLayoutInfo, nullptr, &setLayout));
+	this->bakeSetLayout = vulkan::VulkanDescriptorSetLayoutHandle(setLayout,
+		[device = this->device](VkDescriptorSetLayout l) {
+			vkDestroyDescriptorSetLayout(device, l, nullptr);
+		});
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(BakePushConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout layout;
+	VK_CHECK(vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &layout));
+	this->bakePipelineLayout = vulkan::VulkanPipelineLayoutHandle(layout, [device = this->device](VkPipelineLayout l) {
+		vkDestroyPipelineLayout(device, l, nullptr);
+	});
+
+	auto createPipeline = [this, layout](const char* shaderPath) {
+		auto shaderModule = vulkan::ShaderModule::fromSpirV(this->device, shaderPath, VK_SHADER_STAGE_COMPUTE_BIT);
+
+		VkComputePipelineCreateInfo pipelineInfo{};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage = shaderModule.getStageCreateInfo();
+		pipelineInfo.layout = layout;
+
+		VkPipeline rawPipeline;
+		VK_CHECK(vkCreateComputePipelines(this->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &rawPipeline));
+
+		return vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+			vkDestroyPipeline(device, p, nullptr);
+		});
+	};
+
+	this->prefilterPipeline = createPipeline(PrefilterShaderPath);
+	this->irradiancePipeline = createPipeline(IrradianceShaderPath);
+	this->brdfPipeline = createPipeline(BrdfShaderPath);
+}
+
+vulkan::VulkanImageViewHandle EnvironmentLighting::createView(VkImage image,
+	VkImageViewType viewType,
+	VkFormat format,
+	uint32_t baseMip,
+	uint32_t mipCount,
+	uint32_t layerCount) const {
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = viewType;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = baseMip;
+	viewInfo.subresourceRange.levelCount = mipCount;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = layerCount;
+
+	VkImageView view;
+	VK_CHECK(vkCreateImageView(this->device, &viewInfo, nullptr, &view));
+
+	return vulkan::VulkanImageViewHandle(view, [device = this->device](VkImageView v) {
+		vkDestroyImageView(device, v, nullptr);
+	});
+}
+
+vulkan::VulkanDeviceMemoryHandle EnvironmentLighting::allocateImageMemory(VkImage image) const {
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(this->device, image, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = vulkan::utils::findMemoryType(
+		this->physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDeviceMemory memory;
+	VK_CHECK(vkAllocateMemory(this->device, &allocInfo, nullptr, &memory));
+	VK_CHECK(vkBindImageMemory(this->device, image, memory, 0));
+
+	return vulkan::VulkanDeviceMemoryHandle(memory, [device = this->device](VkDeviceMemory m) {
+		vkFreeMemory(device, m, nullptr);
+	});
+}
+
+std::vector<VkBufferImageCopy> EnvironmentLighting::getCubeRegions(VkDeviceSize offset) {
+	std::vector<VkBufferImageCopy> regions(MipCount);
+	for (uint32_t mip = 0; mip < MipCount; ++mip) {
+		const uint32_t size = CubeSize >> mip;
+
+		VkBufferImageCopy& region = regions[mip];
+		region.bufferOffset = offset;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = mip;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = CubeFaceCount;
+		region.imageOffset = {0, 0, 0};
+		region.imageExtent = {size, size, 1};
+
+		offset += static_cast<VkDeviceSize>(size) * size * CubeFaceCount * PixelBytes;
+	}
+	return regions;
+}
+
+VkDeviceSize EnvironmentLighting::getCubeBytes() {
+	VkDeviceSize bytes = 0;
+	for (uint32_t mip = 0; mip < MipCount; ++mip) {
+		const VkDeviceSize size = CubeSize >> mip;
+		bytes += size * size * CubeFaceCount * PixelBytes;
+	}
+	return bytes;
+}
+
+VkDeviceSize EnvironmentLighting::getLutBytes() {
+	return static_cast<VkDeviceSize>(BrdfLutSize) * BrdfLutSize * PixelBytes;
+}
+
+uint64_t EnvironmentLighting::computeCacheKey(const std::vector<uint8_t>& sourceBytes) {
+	/// FNV-1a over the file, then over the settings that change the baked result
+	constexpr uint64_t Prime = 0x100000001b3ull;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (uint8_t byte : sourceBytes) {
+		hash ^= byte;
+		hash *= Prime;
+	}
+
+	const std::array<uint32_t, 5> settings = {CacheVersion, CubeSize, MipCount, BrdfLutSize, PrefilterSampleCount};
+	for (uint32_t setting : settings) {
+		hash ^= setting;
+		hash *= Prime;
+	}
+	return hash;
+}
+
+bool EnvironmentLighting::loadCache(const std::string& cachePath, uint64_t cacheKey) {
+	std::ifstream file(cachePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	CacheHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	/// The file name already contains the key, but a mismatch in here means the file
+	/// was truncated or written by a different build, so we bake again
+	const bool matches = file
+		&& std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) == 0
+		&& header.version == CacheVersion
+		&& header.sourceHash == cacheKey
+		&& header.cubeSize == CubeSize
+		&& header.mipCount == MipCount
+		&& header.lutSize == BrdfLutSize
+		&& header.cubeBytes == getCubeBytes()
+		&& header.lutBytes == getLutBytes();
+	if (!matches) {
+		spdlog::warn("Ignoring stale environment cache '{}'", cachePath);
+		return false;
+	}
+
+	file.read(reinterpret_cast<char*>(this->params.irradiance.data()), sizeof(this->params.irradiance));
+
+	/// Read straight into the staging buffer, the file data needs no conversion
+	const VkDeviceSize cubeBytes = getCubeBytes();
+	const VkDeviceSize lutBytes = getLutBytes();
+	auto stagingBuffer = this->bufferManager->createStagingBuffer(cubeBytes + lutBytes);
+	auto* mapped = static_cast<char*>(stagingBuffer->map(0, cubeBytes + lutBytes));
+	file.read(mapped, static_cast<std::streamsize>(cubeBytes + lutBytes));
+	stagingBuffer->unmap();
+
+	if (!file) {
+		spdlog::warn("Environment cache '{}' is truncated", cachePath);
+		return false;
+	}
+
+	VkCommandBuffer commandBuffer = this->commandBufferManager->beginSingleTimeCommands(this->commandPool);
+
+	transitionImage(commandBuffer, this->cubeImage.get(), MipCount, CubeFaceCount,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	transitionImage(commandBuffer, this->lutImage.get(), 1, 1,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	const auto cubeRegions = getCubeRegions(0);
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer->get(), this->cubeImage.get(),
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(cubeRegions.size()), cubeRegions.data());
+
+	VkBufferImageCopy lutRegion{};
+	lutRegion.bufferOffset = cubeBytes;
+	lutRegion.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	lutRegion.imageExtent = {BrdfLutSize, BrdfLutSize, 1};
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer->get(), this->lutImage.get(),
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &lutRegion);
+
+	transitionImage(commandBuffer, this->cubeImage.get(), MipCount, CubeFaceCount,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	transitionImage(commandBuffer, this->lutImage.get(), 1, 1,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	this->commandBufferManager->endSingleTimeCommands(commandBuffer, this->commandPool, this->queue);
+	return true;
+}
+
+bool EnvironmentLighting::bake(const std::vector<uint8_t>& sourceBytes, const std::string& cachePath, uint64_t cacheKey) {
+	/// Row 0 is the top of the equirectangular image, which is what the bake shaders expect
+	stbi_set_flip_vertically_on_load(false);
+	int width = 0;
+	int height = 0;
+	int channels = 0;
+	float* pixels = stbi_loadf_from_memory(sourceBytes.data(), static_cast<int>(sourceBytes.size()),
+		&width, &height, &channels, 4);
+	if (!pixels) {
+		spdlog::error("Failed to decode environment map: {}", stbi_failure_reason());
+		return false;
+	}
+
+	/// Half floats keep the HDR range, and unlike 32 bit floats they can be filtered everywhere
+	const size_t valueCount = static_cast<size_t>(width) * height * 4;
+	const VkDeviceSize sourceBytesHalf = valueCount * sizeof(uint16_t);
+	auto stagingBuffer = this->bufferManager->createStagingBuffer(sourceBytesHalf);
+	auto* halfPixels = static_cast<uint16_t*>(stagingBuffer->map(0, sourceBytesHalf));
+	for (size_t i = 0; i < valueCount; ++i) {
+		/// Clamp to the largest half, bright suns would otherwise become infinity
+		halfPixels[i] = glm::packHalf1x16(std::min(pixels[i], 65504.0f));
+	}
+	stagingBuffer->unmap();
+	stbi_image_free(pixels);
+
+	/// The prefilter reads lower source mips for wide lobes, so the source needs a
+	/// full mip chain, generated by blitting
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(this->physicalDevice, ImageFormat, &formatProperties);
+	const bool canBlit = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)
+		&& (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+	const uint32_t sourceMipCount = canBlit
+		? static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1
+		: 1;
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = ImageFormat;
+	imageInfo.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+	imageInfo.mipLevels = sourceMipCount;
+	imageInfo.arrayLayers = 1;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkImage rawSourceImage;
+	VK_CHECK(vkCreateImage(this->device, &imageInfo, nullptr, &rawSourceImage));
+	vulkan::VulkanImageHandle sourceImage(rawSourceImage, [device = this->device](VkImage i) {
+		vkDestroyImage(device, i, nullptr);
+	});
+	vulkan::VulkanDeviceMemoryHandle sourceMemory = this->allocateImageMemory(rawSourceImage);
+	vulkan::VulkanImageViewHandle sourceView = this->createView(rawSourceImage,
+		VK_IMAGE_VIEW_TYPE_2D, ImageFormat, 0, sourceMipCount, 1);
+
+	/// Wraps around horizontally, where the equirectangular image wraps too
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = static_cast<float>(sourceMipCount - 1);
+
+	VkSampler rawSourceSampler;
+	VK_CHECK(vkCreateSampler(this->device, &samplerInfo, nullptr, &rawSourceSampler));
+	vulkan::VulkanSamplerHandle sourceSampler(rawSourceSampler, [device = this->device](VkSampler s) {
+		vkDestroySampler(device, s, nullptr);
+	});
+
+	this->createBakePipelines();
+
+	/// One set per cube map mip, the other bindings are the same in all of them
+	std::array<VkDescriptorPoolSize, 3> poolSizes{};
+	poolSizes[0] = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MipCount};
+	poolSizes[1] = {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MipCount * 2};
+	poolSizes[2] = {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MipCount};
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = MipCount;
+
+	VkDescriptorPool rawPool;
+	VK_CHECK(vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &rawPool));
+	vulkan::VulkanDescriptorPoolHandle descriptorPool(rawPool, [device = this->device](VkDescriptorPool p) {
+		vkDestroyDescriptorPool(device, p, nullptr);
+	});
+
+	std::vector<VkDescriptorSetLayout> setLayouts(MipCount, this->bakeSetLayout.get());
+	std::vector<VkDescriptorSet> descriptorSets(MipCount);
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = rawPool;
+	allocInfo.descriptorSetCount = MipCount;
+	allocInfo.pSetLayouts = setLayouts.data();
+	VK_CHECK(vkAllocateDescriptorSets(this->device, &allocInfo, descriptorSets.data()));
+
+	auto irradianceBuffer = this->bufferManager->createStorageBuffer(sizeof(glm::vec4) * SphericalHarmonicsCount);
+
+	/// The prefilter writes one mip at a time, the faces are the layers of a 2D array view
+	std::vector<vulkan::VulkanImageViewHandle> mipViews;
+	mipViews.reserve(MipCount);
+	for (uint32_t mip = 0; mip < MipCount; ++mip) {
+		mipViews.push_back(this->createView(this->cubeImage.get(),
+			VK_IMAGE_VIEW_TYPE_2D_ARRAY, ImageFormat, mip, 1, CubeFaceCount));
+
+		VkDescriptorImageInfo sourceInfo{sourceSampler.get(), sourceView.get(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+		VkDescriptorImageInfo mipInfo{VK_NULL_HANDLE, mipViews.back().get(), VK_IMAGE_LAYOUT_GENERAL};
+		VkDescriptorImageInfo lutInfo{VK_NULL_HANDLE, this->lutView.get(), VK_IMAGE_LAYOUT_GENERAL};
+		VkDescriptorBufferInfo bufferInfo{irradianceBuffer->get(), 0, VK_WHOLE_SIZE};
+
+		std::array<VkWriteDescriptorSet, 4> writes{};
+		for (uint32_t i = 0; i < writes.size(); ++i) {
+			writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			writes[i].dstSet = descriptorSets[mip];
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+		}
+		writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[0].pImageInfo = &sourceInfo;
+		writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[1].pImageInfo = &mipInfo;
+		writes[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[2].pImageInfo = &lutInfo;
+		writes[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[3].pBufferInfo = &bufferInfo;
+
+		vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	const VkDeviceSize cubeBytes = getCubeBytes();
+	const VkDeviceSize lutBytes = getLutBytes();
+	auto readbackBuffer = this->bufferManager->createReadbackBuffer(cubeBytes + lutBytes);
+
+	VkCommandBuffer commandBuffer = this->commandBufferManager->beginSingleTimeCommands(this->commandPool);
+
+	/// Upload the source and build its mip chain
+	transitionImage(commandBuffer, rawSourceImage, sourceMipCount, 1,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	VkBufferImageCopy sourceRegion{};
+	sourceRegion.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	sourceRegion.imageExtent = imageInfo.extent;
+	vkCmdCopyBufferToImage(commandBuffer, stagingBuffer->get(), rawSourceImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &sourceRegion);
+
+	int32_t mipWidth = width;
+	int32_t mipHeight = height;
+	for (uint32_t mip = 1; mip < sourceMipCount; ++mip) {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = rawSourceImage;
+		barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, mip - 1, 1, 0, 1};
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		const int32_t nextWidth = std::max(mipWidth / 2, 1);
+		const int32_t nextHeight = std::max(mipHeight / 2, 1);
+
+		VkImageBlit blit{};
+		blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip - 1, 0, 1};
+		blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+		blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1};
+		blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+		vkCmdBlitImage(commandBuffer,
+			rawSourceImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			rawSourceImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit, VK_FILTER_LINEAR);
+
+		mipWidth = nextWidth;
+		mipHeight = nextHeight;
+	}
+
+	/// All mips but the last are in TRANSFER_SRC now, bring every mip to the same layout first
+	if (sourceMipCount > 1) {
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = rawSourceImage;
+		barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, sourceMipCount - 1, 0, 1};
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+	transitionImage(commandBuffer, rawSourceImage, sourceMipCount, 1,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	transitionImage(commandBuffer, this->cubeImage.get(), MipCount, CubeFaceCount,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	transitionImage(commandBuffer, this->lutImage.get(), 1, 1,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+	BakePushConstants pushConstants{};
+	pushConstants.sampleCount = PrefilterSampleCount;
+	pushConstants.sourceWidth = static_cast<uint32_t>(width);
+
+	/// Specular: roughness rises with the mip, 8x8 threads per group, one face per group layer
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->prefilterPipeline.get());
+	for (uint32_t mip = 0; mip < MipCount; ++mip) {
+		pushConstants.roughness = static_cast<float>(mip) / static_cast<float>(MipCount - 1);
+		pushConstants.outputSize = CubeSize >> mip;
+
+		vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+			this->bakePipelineLayout.get(), 0, 1, &descriptorSets[mip], 0, nullptr);
+		vkCmdPushConstants(commandBuffer, this->bakePipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT,
+			0, sizeof(BakePushConstants), &pushConstants);
+
+		const uint32_t groups = (pushConstants.outputSize + 7) / 8;
+		vkCmdDispatch(commandBuffer, groups, groups, CubeFaceCount);
+	}
+
+	/// Diffuse: a single group projects the whole source onto the spherical harmonics
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->irradiancePipeline.get());
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+		this->bakePipelineLayout.get(), 0, 1, &descriptorSets[0], 0, nullptr);
+	vkCmdPushConstants(commandBuffer, this->bakePipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT,
+		0, sizeof(BakePushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+
+	/// The lookup table only depends on the BRDF, not on the environment
+	pushConstants.outputSize = BrdfLutSize;
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->brdfPipeline.get());
+	vkCmdPushConstants(commandBuffer, this->bakePipelineLayout.get(), VK_SHADER_STAGE_COMPUTE_BIT,
+		0, sizeof(BakePushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, BrdfLutSize / 8, BrdfLutSize / 8, 1);
+
+	/// Read everything back for the cache
+	transitionImage(commandBuffer, this->cubeImage.get(), MipCount, CubeFaceCount,
+		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	transitionImage(commandBuffer, this->lutImage.get(), 1, 1,
+		VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+	const auto cubeRegions = getCubeRegions(0);
+	vkCmdCopyImageToBuffer(commandBuffer, this->cubeImage.get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		readbackBuffer->get(), static_cast<uint32_t>(cubeRegions.size()), cubeRegions.data());
+
+	VkBufferImageCopy lutRegion{};
+	lutRegion.bufferOffset = cubeBytes;
+	lutRegion.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	lutRegion.imageExtent = {BrdfLutSize, BrdfLutSize, 1};
+	vkCmdCopyImageToBuffer(commandBuffer, this->lutImage.get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		readbackBuffer->get(), 1, &lutRegion);
+
+	transitionImage(commandBuffer, this->cubeImage.get(), MipCount, CubeFaceCount,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	transitionImage(commandBuffer, this->lutImage.get(), 1, 1,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	VkMemoryBarrier hostBarrier{};
+	hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	hostBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+	hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+		0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+	this->commandBufferManager->endSingleTimeCommands(commandBuffer, this->commandPool, this->queue);
+
+	const auto* irradiance = static_cast<const glm::vec4*>(
+		irradianceBuffer->map(0, sizeof(glm::vec4) * SphericalHarmonicsCount));
+	std::copy(irradiance, irradiance + SphericalHarmonicsCount, this->params.irradiance.begin());
+	irradianceBuffer->unmap();
+
+	const auto* readback = static_cast<const uint8_t*>(readbackBuffer->map(0, cubeBytes + lutBytes));
+	this->writeCache(cachePath, cacheKey, readback, readback + cubeBytes);
+	readbackBuffer->unmap();
+
+	/// Baking runs once per environment, the pipelines aren't needed afterwards
+	this->brdfPipeline.reset();
+	this->irradiancePipeline.reset();
+	this->prefilterPipeline.reset();
+	this->bakePipelineLayout.reset();
+	this->bakeSetLayout.reset();
+
+	return true;
+}
+
+void EnvironmentLighting::writeCache(const std::string& cachePath,
+	uint64_t cacheKey,
+	const uint8_t* cubeData,
+	const uint8_t* lutData) const {
+	const std::filesystem::path path(cachePath);
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	CacheHeader header{};
+	std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+	header.version = CacheVersion;
+	header.sourceHash = cacheKey;
+	header.cubeSize = CubeSize;
+	header.mipCount = MipCount;
+	header.lutSize = BrdfLutSize;
+	header.cubeBytes = getCubeBytes();
+	header.lutBytes = getLutBytes();
+
+	/// Write to a temporary file first, so an interrupted write never leaves a
+	/// cache file behind that looks valid
+	const std::filesystem::path temporaryPath = path.string() + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!file) {
+			spdlog::warn("Could not write environment cache '{}', it will be baked again next time", cachePath);
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(this->params.irradiance.data()), sizeof(this->params.irradiance));
+		file.write(reinterpret_cast<const char*>(cubeData), static_cast<std::streamsize>(header.cubeBytes));
+		file.write(reinterpret_cast<const char*>(lutData), static_cast<std::streamsize>(header.lutBytes));
+		if (!file) {
+			spdlog::warn("Could not write environment cache '{}', it will be baked again next time", cachePath);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error) {
+		spdlog::warn("Could not write environment cache '{}': {}", cachePath, error.message());
+	}
+}
+
+void EnvironmentLighting::clearImages() {
+	VkCommandBuffer commandBuffer = this->commandBufferManager->beginSingleTimeCommands(this->commandPool);
+
+	const VkClearColorValue black{};
+	const VkImageSubresourceRange cubeRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, MipCount, 0, CubeFaceCount};
+	const VkImageSubresourceRange lutRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+	transitionImage(commandBuffer, this->cubeImage.get(), MipCount, CubeFaceCount,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+	transitionImage(commandBuffer, this->lutImage.get(), 1, 1,
+		VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+	vkCmdClearColorImage(commandBuffer, this->cubeImage.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		&black, 1, &cubeRange);
+	vkCmdClearColorImage(commandBuffer, this->lutImage.get(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		&black, 1, &lutRange);
+
+	transitionImage(commandBuffer, this->cubeImage.get(), MipCount, CubeFaceCount,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	transitionImage(commandBuffer, this->lutImage.get(), 1, 1,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	this->commandBufferManager->endSingleTimeCommands(commandBuffer, this->commandPool, this->queue);
+
+	this->params.irradiance.fill(glm::vec4(0.0f));
+}
+
+void EnvironmentLighting::writeDescriptorSet(VkDescriptorSet descriptorSet) const {
+	VkDescriptorBufferInfo bufferInfo{this->paramsBuffer->get(), 0, sizeof(EnvironmentParams)};
+
+	std::array<VkDescriptorImageInfo, 2> imageInfos{};
+	imageInfos[0] = {this->cubeSampler.get(), this->cubeView.get(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	imageInfos[1] = {this->lutSampler.get(), this->lutView.get(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+
+	std::array<VkWriteDescriptorSet, 3> writes{};
+	for (uint32_t i = 0; i < writes.size(); ++i) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = descriptorSet;
+		writes[i].dstBinding = 6 + i;
+		writes[i].dstArrayElement = 0;
+		writes[i].descriptorCount = 1;
+	}
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	writes[0].pBufferInfo = &bufferInfo;
+	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writes[1].pImageInfo = &imageInfos[0];
+	writes[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writes[2].pImageInfo = &imageInfos[1];
+
+	vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+void EnvironmentLighting::transitionImage(VkCommandBuffer commandBuffer,
+	VkImage image,
+	uint32_t mipCount,
+	uint32_t layerCount,
+	VkImageLayout oldLayout,
+	VkImageLayout newLayout,
+	VkPipelineStageFlags srcStage,
+	VkAccessFlags srcAccess,
+	VkPipelineStageFlags dstStage,
+	VkAccessFlags dstAccess) {
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = mipCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = layerCount;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		srcStage, dstStage,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &barrier);
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include "vulkan/buffer.h"
+#include "vulkan/commandbuffermanager.h"
+#include "buffermanager.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// EnvironmentLighting provides image based lighting from an HDR environment map
+/// A constant ambient term lights every direction the same, so metals, which have
+/// almost no diffuse response, look flat. Image based lighting replaces it with
+/// the light arriving from the environment:
+/// - Diffuse light comes from the irradiance, stored as 9 spherical harmonics
+///   coefficients. Irradiance is very smooth, so these are enough and cost no fetch.
+/// - Specular light comes from a cube map prefiltered for increasing roughness
+///   along its mip chain, combined with a split-sum BRDF lookup table.
+/// Shading therefore pays two texture lookups per pixel.
+///
+/// The convolutions run once in compute shaders. Their results are read back and
+/// stored in a cache file named after a hash of the source image and bake settings,
+/// so later starts only upload the cached data.
+///
+/// Everything is bound through the global light descriptor set (set = 1):
+/// binding 6 parameters and irradiance, 7 prefiltered cube map, 8 BRDF lookup table.
+/// The layout matches environment.glsl
+class EnvironmentLighting {
+public:
+	static constexpr const char* PrefilterShaderPath = "shaders/iblprefilter.comp.spv";
+	static constexpr const char* IrradianceShaderPath = "shaders/iblirradiance.comp.spv";
+	static constexpr const char* BrdfShaderPath = "shaders/iblbrdf.comp.spv";
+
+	/// Face size of the prefiltered cube map's first mip
+	static constexpr uint32_t CubeSize = 256;
+
+	/// Mips of the prefiltered cube map, roughness rises linearly from 0 to 1 across them
+	/// The last mip is 8x8, which is still enough for fully rough reflections
+	static constexpr uint32_t MipCount = 6;
+
+	/// Size of the BRDF lookup table, indexed by NdotV and roughness
+	static constexpr uint32_t BrdfLutSize = 256;
+
+	/// Samples per texel when prefiltering
+	/// Filtered importance sampling reads lower source mips for rough lobes, so few are enough
+	static constexpr uint32_t PrefilterSampleCount = 128;
+
+	/// Bumped whenever the baked data or its file layout changes, invalidating old caches
+	static constexpr uint32_t CacheVersion = 1;
+
+	/// Constructor
+	/// @param device The logical device to create resources on
+	/// @param physicalDevice The physical device for memory allocation
+	/// @param queue Queue to submit the bake and upload commands to
+	/// @param commandPool Pool to allocate the one-time command buffers from
+	/// @param commandBufferManager Command buffer manager for one-time submissions
+	/// @param bufferManager Buffer manager to allocate buffers from
+	EnvironmentLighting(VkDevice device,
+		VkPhysicalDevice physicalDevice,
+		VkQueue queue,
+		VkCommandPool commandPool,
+		std::shared_ptr<vulkan::CommandBufferManager> commandBufferManager,
+		std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor
+	~EnvironmentLighting();
+
+	/// Load the environment, from the cache if possible, otherwise by baking the source
+	/// Without a readable source, image based lighting stays disabled and shading keeps
+	/// using the constant ambient term of the lights
+	/// @param sourcePath Path to an equirectangular HDR image
+	/// @param cacheDirectory Directory for baked environment files
+	void initialize(const std::string& sourcePath, const std::string& cacheDirectory);
+
+	/// Release all Vulkan resources
+	void cleanup();
+
+	/// Point a light descriptor set at the environment resources
+	/// @param descriptorSet Descriptor set allocated with the global light layout
+	void writeDescriptorSet(VkDescriptorSet descriptorSet) const;
+
+	/// Check if an environment was loaded
+	[[nodiscard]] bool isEnabled() const { return this->enabled; }
+
+private:
+	/// Environment parameters uniform buffer
+	/// Layout matches EnvironmentParams in environment.glsl (std140)
+	struct EnvironmentParams {
+		std::array<glm::vec4, 9> irradiance;  /// Cosine convolved SH coefficients, rgb
+		glm::vec4 settings;                   /// Max mip, intensity, enabled, unused
+	};
+
+	/// Start of a cache file, followed by the irradiance, the cube map and the lookup table
+	struct CacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		uint32_t cubeSize;
+		uint32_t mipCount;
+		uint32_t lutSize;
+		uint32_t reserved;
+		uint64_t cubeBytes;
+		uint64_t lutBytes;
+	};
+
+	/// Push constants of the bake shaders, matches iblcommon.glsl
+	struct BakePushConstants {
+		float roughness;
+		uint32_t outputSize;
+		uint32_t sampleCount;
+		uint32_t sourceWidth;
+	};
+
+	void createImages();
+	void createSamplers();
+	void createBakePipelines();
+
+	/// Create a view on the cube map or lookup table
+	[[nodiscard]] vulkan::VulkanImageViewHandle createView(VkImage image,
+		VkImageViewType viewType,
+		VkFormat format,
+		uint32_t baseMip,
+		uint32_t mipCount,
+		uint32_t layerCount) const;
+
+	/// Allocate and bind device local memory for an image
+	[[nodiscard]] vulkan::VulkanDeviceMemoryHandle allocateImageMemory(VkImage image) const;
+
+	/// Copy regions of the whole cube map mip chain, tightly packed starting at an offset
+	/// The same layout is used for reading back, the cache file and uploading
+	[[nodiscard]] static std::vector<VkBufferImageCopy> getCubeRegions(VkDeviceSize offset);
+
+	/// Bytes of the whole cube map mip chain in the packed layout
+	[[nodiscard]] static VkDeviceSize getCubeBytes();
+
+	/// Bytes of the lookup table
+	[[nodiscard]] static VkDeviceSize getLutBytes();
+
+	/// Hash the source file together with the bake settings
+	[[nodiscard]] static uint64_t computeCacheKey(const std::vector<uint8_t>& sourceBytes);
+
+	/// Upload a cache file, if it exists and matches
+	/// @return True if the environment was loaded from the cache
+	[[nodiscard]] bool loadCache(const std::string& cachePath, uint64_t cacheKey);
+
+	/// Run the convolutions on a decoded source and store the results in the cache
+	/// @return True if baking succeeded
+	[[nodiscard]] bool bake(const std::vector<uint8_t>& sourceBytes, const std::string& cachePath, uint64_t cacheKey);
+
+	/// Write baked data to a cache file
+	void writeCache(const std::string& cachePath, uint64_t cacheKey, const uint8_t* cubeData, const uint8_t* lutData) const;
+
+	/// Clear the images so the descriptors point at defined data when there is no environment
+	void clearImages();
+
+	/// Change the layout of mips of an image
+	static void transitionImage(VkCommandBuffer commandBuffer,
+		VkImage image,
+		uint32_t mipCount,
+		uint32_t layerCount,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		VkPipelineStageFlags srcStage,
+		VkAccessFlags srcAccess,
+		VkPipelineStageFlags dstStage,
+		VkAccessFlags dstAccess);
+
+	VkDevice device;
+	VkPhysicalDevice physicalDevice;
+	VkQueue queue;
+	VkCommandPool commandPool;
+	std::shared_ptr<vulkan::CommandBufferManager> commandBufferManager;
+	std::shared_ptr<BufferManager> bufferManager;
+
+	/// Specular environment, one roughness per mip
+	vulkan::VulkanImageHandle cubeImage;
+	vulkan::VulkanDeviceMemoryHandle cubeMemory;
+	vulkan::VulkanImageViewHandle cubeView;
+
+	/// Split-sum scale and bias of F0, by NdotV and roughness
+	vulkan::VulkanImageHandle lutImage;
+	vulkan::VulkanDeviceMemoryHandle lutMemory;
+	vulkan::VulkanImageViewHandle lutView;
+
+	vulkan::VulkanSamplerHandle cubeSampler;
+	vulkan::VulkanSamplerHandle lutSampler;
+
+	/// Only needed while baking
+	vulkan::VulkanDescriptorSetLayoutHandle bakeSetLayout;
+	vulkan::VulkanPipelineLayoutHandle bakePipelineLayout;
+	vulkan::VulkanPipelineHandle prefilterPipeline;
+	vulkan::VulkanPipelineHandle irradiancePipeline;
+	vulkan::VulkanPipelineHandle brdfPipeline;
+
+	/// Written once after loading, the environment doesn't change at runtime
+	std::shared_ptr<vulkan::Buffer> paramsBuffer;
+	EnvironmentParams params{};
+
+	bool enabled{false};
+};
+
+} /// namespace lillugsi::rendering
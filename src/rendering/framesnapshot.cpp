@@ -0,0 +1,86 @@
+#include "framesnapshot.h"
+#include <spdlog/spdlog.h>
+#include <utility>
+
+namespace lillugsi::rendering {
+
+FrameSnapshot& FrameSnapshotBuffer::beginWrite() {
+	/// The write index only changes inside publish(), which is called by the
+	/// producer itself, so no lock is needed to read it here
+	return this->slots[this->writeIndex];
+}
+
+void FrameSnapshotBuffer::publish() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		/// A pending snapshot that was never acquired gets replaced
+		/// We count these so frame pacing problems show up in the logs
+		if (this->hasPending) {
+			this->droppedSnapshots++;
+		}
+
+		std::swap(this->writeIndex, this->pendingIndex);
+		this->hasPending = true;
+	}
+
+	this->pendingCondition.notify_one();
+}
+
+const FrameSnapshot* FrameSnapshotBuffer::acquire(std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> lock(this->mutex);
+
+	this->pendingCondition.wait_for(lock, timeout, [this]() {
+		return this->hasPending || this->stopped;
+	});
+
+	if (!this->hasPending) {
+		return nullptr;
+	}
+
+	/// The previous read slot becomes the new pending slot and will be
+	/// handed to the producer with the next publish
+	std::swap(this->readIndex, this->pendingIndex);
+	this->hasPending = false;
+
+	lock.unlock();
+	this->consumedCondition.notify_one();
+
+	return &this->slots[this->readIndex];
+}
+
+void FrameSnapshotBuffer::waitUntilConsumed() {
+	std::unique_lock<std::mutex> lock(this->mutex);
+	this->consumedCondition.wait(lock, [this]() {
+		return !this->hasPending || this->stopped;
+	});
+}
+
+void FrameSnapshotBuffer::stop() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopped = true;
+	}
+
+	this->pendingCondition.notify_all();
+	this->consumedCondition.notify_all();
+}
+
+void FrameSnapshotBuffer::reset() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->stopped = false;
+	this->hasPending = false;
+
+	if (this->droppedSnapshots > 0) {
+		spdlog::debug("Frame snapshot buffer reset after {} dropped snapshots",
+			this->droppedSnapshots);
+	}
+	this->droppedSnapshots = 0;
+}
+
+uint64_t FrameSnapshotBuffer::getDroppedCount() const {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->droppedSnapshots;
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "mesh.h"
+#include "skinnedmesh.h"
+#include "vertex.h"
+#include "light.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// FrameSnapshot is an immutable copy of everything the render thread needs for one frame
+/// The update thread fills a snapshot after simulating, then hands it over as a whole.
+/// Once published, nothing in the snapshot refers back to mutable scene state:
+/// transforms are baked into the draw packets, and the packets hold shared references
+/// to buffers and materials so they stay alive while the GPU still uses them
+struct FrameSnapshot {
+	/// Monotonic index of the simulation step that produced this snapshot
+	uint64_t frameIndex{0};
+
+	/// Scaled time step the simulation used for this snapshot
+	float deltaTime{0.0f};
+
+	/// Camera state captured at the end of the simulation step
+	glm::mat4 view{1.0f};
+	glm::mat4 projection{1.0f};
+	glm::vec3 cameraPosition{0.0f};
+	float nearPlane{0.1f};   /// Clip plane distances, the light clusters are sliced between them
+	float farPlane{100.0f};
+
+	/// Visible draw packets after frustum culling, including world transforms
+	std::vector<Mesh::RenderData> drawPackets;
+
+	/// GPU-ready light data for the light buffer
+	/// The first directionalLightCount entries are directional lights
+	std::vector<LightData> lights;
+	uint32_t directionalLightCount{0};
+
+	/// Shadow casters of the primary directional light, culled against its caster volume
+	std::vector<ShadowCaster> shadowCasters;
+
+	/// Revision of the static geometry, cached shadow cascades stay valid until it changes
+	uint64_t staticRevision{0};
+
+	/// Joint palettes of all animated characters, evaluated for this simulation step
+	std::vector<InstanceTransform> jointPalettes;
+
+	/// Skinned meshes to move with the palettes before anything draws them
+	std::vector<SkinningDispatch> skinning;
+};
+
+/// FrameSnapshotBuffer hands snapshots from the update thread to the render thread
+/// We use three slots so neither side ever waits on the other while touching its slot:
+/// - the write slot is owned by the producer while it builds the next snapshot
+/// - the pending slot holds the latest published snapshot not yet picked up
+/// - the read slot is owned by the consumer while it records and submits the frame
+/// Publishing and acquiring only swap slot indices under a short lock.
+/// If the producer publishes twice before the consumer picks up, the older snapshot
+/// is dropped so the render thread always draws the most recent simulation state
+class FrameSnapshotBuffer {
+public:
+	/// Number of slots in the ring
+	static constexpr size_t SlotCount = 3;
+
+	FrameSnapshotBuffer() = default;
+
+	/// Snapshots contain synchronization state and large vectors, so we don't copy them
+	FrameSnapshotBuffer(const FrameSnapshotBuffer&) = delete;
+	FrameSnapshotBuffer& operator=(const FrameSnapshotBuffer&) = delete;
+
+	/// Get the slot the producer may fill
+	/// The returned snapshot still holds the data of an older frame, which lets
+	/// the producer reuse vector capacity instead of reallocating every frame
+	/// @return Reference to the producer-owned snapshot
+	[[nodiscard]] FrameSnapshot& beginWrite();
+
+	/// Publish the producer slot as the latest snapshot
+	/// This never blocks on the consumer
+	void publish();
+
+	/// Take the latest published snapshot for rendering
+	/// The returned snapshot stays valid and unchanged until the next acquire call
+	/// @param timeout Maximum time to wait for a new snapshot
+	/// @return Pointer to the snapshot, or nullptr on timeout or after stop()
+	[[nodiscard]] const FrameSnapshot* acquire(std::chrono::milliseconds timeout);
+
+	/// Block the producer until the consumer has picked up the pending snapshot
+	/// We use this to keep simulation at most one frame ahead of rendering,
+	/// which bounds input latency while still letting both overlap
+	void waitUntilConsumed();
+
+	/// Wake up all waiting threads and make further waits return immediately
+	/// Called when the render thread shuts down
+	void stop();
+
+	/// Clear the stopped state and drop any pending snapshot
+	/// Called before a render thread is (re)started
+	void reset();
+
+	/// Get the number of snapshots that were replaced before being rendered
+	/// @return Count of dropped snapshots since the last reset
+	[[nodiscard]] uint64_t getDroppedCount() const;
+
+private:
+	std::array<FrameSnapshot, SlotCount> slots;
+
+	/// Slot roles, always a permutation of {0, 1, 2}
+	size_t writeIndex{0};
+	size_t pendingIndex{1};
+	size_t readIndex{2};
+
+	bool hasPending{false};
+	bool stopped{false};
+	uint64_t droppedSnapshots{0};
+
+	mutable std::mutex mutex;
+	std::condition_variable pendingCondition;   /// Signaled when a snapshot is published
+	std::condition_variable consumedCondition;  /// Signaled when a snapshot is acquired
+};
+
+} /// namespace lillugsi::rendering
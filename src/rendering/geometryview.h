@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// Read-only view of contiguous elements owned by someone else
+/// We are on C++17, so this stands in for std::span<const T>. A view never
+/// allocates or copies, and is invalidated like an iterator of the storage it
+/// was taken from whenever that storage changes.
+template<typename T>
+class ArrayView {
+public:
+	using value_type = T;
+	using const_iterator = const T*;
+
+	ArrayView() = default;
+
+	ArrayView(const T* data, size_t size)
+		: elements(data)
+		, count(size) {
+	}
+
+	ArrayView(const std::vector<T>& vector)
+		: elements(vector.data())
+		, count(vector.size()) {
+	}
+
+	[[nodiscard]] const T* data() const { return this->elements; }
+	[[nodiscard]] size_t size() const { return this->count; }
+	[[nodiscard]] bool empty() const { return this->count == 0; }
+
+	[[nodiscard]] const T& operator[](size_t index) const { return this->elements[index]; }
+	[[nodiscard]] const T& front() const { return this->elements[0]; }
+	[[nodiscard]] const T& back() const { return this->elements[this->count - 1]; }
+
+	[[nodiscard]] const T* begin() const { return this->elements; }
+	[[nodiscard]] const T* end() const { return this->elements + this->count; }
+
+	/// Get a part of the view
+	/// @param first Index of the first element
+	/// @param size Number of elements, must fit into the view
+	[[nodiscard]] ArrayView subview(size_t first, size_t size) const {
+		return ArrayView(this->elements + first, size);
+	}
+
+	/// Get the viewed bytes, for uploads
+	[[nodiscard]] size_t sizeBytes() const { return this->count * sizeof(T); }
+
+private:
+	const T* elements{nullptr};
+	size_t count{0};
+};
+
+/// Read-only view of one member in every element of an array
+/// Positions are the first member of Vertex, so a view with the vertex size as stride
+/// walks all positions without copying them out. A compact array is the same view
+/// with a stride of sizeof(T), so consumers don't care how the geometry is stored.
+template<typename T>
+class StridedView {
+public:
+	using value_type = T;
+
+	class Iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const T*;
+		using reference = const T&;
+
+		Iterator(const uint8_t* position, size_t stride)
+			: position(position)
+			, stride(stride) {
+		}
+
+		reference operator*() const { return *reinterpret_cast<const T*>(this->position); }
+		pointer operator->() const { return reinterpret_cast<const T*>(this->position); }
+		reference operator[](difference_type offset) const { return *(*this + offset); }
+
+		Iterator& operator++() { this->position += this->stride; return *this; }
+		Iterator operator++(int) { Iterator previous = *this; ++(*this); return previous; }
+		Iterator& operator--() { this->position -= this->stride; return *this; }
+		Iterator operator--(int) { Iterator previous = *this; --(*this); return previous; }
+		Iterator& operator+=(difference_type offset) {
+			this->position += offset * static_cast<difference_type>(this->stride);
+			return *this;
+		}
+		Iterator& operator-=(difference_type offset) { return *this += -offset; }
+		Iterator operator+(difference_type offset) const { Iterator result = *this; return result += offset; }
+		Iterator operator-(difference_type offset) const { Iterator result = *this; return result -= offset; }
+		difference_type operator-(const Iterator& other) const {
+			return (this->position - other.position) / static_cast<difference_type>(this->stride);
+		}
+
+		bool operator==(const Iterator& other) const { return this->position == other.position; }
+		bool operator!=(const Iterator& other) const { return this->position != other.position; }
+		bool operator<(const Iterator& other) const { return this->position < other.position; }
+		bool operator>(const Iterator& other) const { return this->position > other.position; }
+		bool operator<=(const Iterator& other) const { return this->position <= other.position; }
+		bool operator>=(const Iterator& other) const { return this->position >= other.position; }
+
+	private:
+		const uint8_t* position;
+		size_t stride;
+	};
+
+	using const_iterator = Iterator;
+
+	StridedView() = default;
+
+	/// Create a view
+	/// @param first Address of the member in the first element
+	/// @param size Number of elements
+	/// @param stride Bytes from one element to the next
+	StridedView(const T* first, size_t size, size_t stride)
+		: first(reinterpret_cast<const uint8_t*>(first))
+		, count(size)
+		, stride(stride) {
+	}
+
+	/// Create a view of a compact array
+	StridedView(const std::vector<T>& vector)
+		: first(reinterpret_cast<const uint8_t*>(vector.data()))
+		, count(vector.size())
+		, stride(sizeof(T)) {
+	}
+
+	[[nodiscard]] size_t size() const { return this->count; }
+	[[nodiscard]] bool empty() const { return this->count == 0; }
+	[[nodiscard]] size_t getStride() const { return this->stride; }
+
+	[[nodiscard]] const T& operator[](size_t index) const {
+		return *reinterpret_cast<const T*>(this->first + index * this->stride);
+	}
+
+	[[nodiscard]] Iterator begin() const { return Iterator(this->first, this->stride); }
+	[[nodiscard]] Iterator end() const { return Iterator(this->first + this->count * this->stride, this->stride); }
+
+private:
+	const uint8_t* first{nullptr};
+	size_t count{0};
+	size_t stride{sizeof(T)};
+};
+
+} /// namespace lillugsi::rendering
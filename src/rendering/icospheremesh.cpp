@@ -1,8 +1,15 @@
 #include "icospheremesh.h"
 #include "vulkan/vulkanexception.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstddef>
+#include <functional>
+#include <future>
 #include <glm/gtx/dual_quaternion.hpp>
+#include <map>
 #include <spdlog/spdlog.h>
+#include <thread>
 
 bool compareVec3(const glm::vec3& v1, const glm::vec3& v2, float epsilon = 0.0001f) {
 	return std::abs(v1.x - v2.x) < epsilon &&
@@ -12,6 +19,27 @@ bool compareVec3(const glm::vec3& v1, const glm::vec3& v2, float epsilon = 0.000
 
 namespace lillugsi::rendering {
 
+namespace {
+constexpr uint32_t BaseVertexCount = 12;
+constexpr uint32_t BaseFaceCount = 20;
+
+/// Below this many vertices, starting threads costs more than generating the faces
+constexpr size_t ParallelVertexThreshold = 100000;
+
+/// Midpoint of two vertices on the sphere, projected back onto its surface
+glm::vec3 sphereMidpoint(const glm::vec3& p1, const glm::vec3& p2, float radius) {
+	return glm::normalize(p1 + p2) * radius;
+}
+
+Vertex createSphereVertex(const glm::vec3& position) {
+	Vertex vertex{};
+	vertex.position = position;
+	vertex.normal = glm::normalize(position);
+	vertex.color = glm::vec3(1.0f);
+	return vertex;
+}
+}
+
 IcosphereMesh::IcosphereMesh(float radius, uint32_t subdivisions)
 	: radius(radius)
 	, subdivisions(subdivisions) {
@@ -25,9 +53,7 @@ IcosphereMesh::IcosphereMesh(float radius, uint32_t subdivisions)
 	}
 
 	/// Cap subdivisions to prevent excessive geometry
-	/// Each subdivision level quadruples the number of triangles
-	/// At level 8, we'd have 327,680 triangles which is excessive for most uses
-	static constexpr uint32_t MaxSubdivisions = 7;
+	/// Beyond MaxSubdivisions the vertex data alone takes gigabytes
 	if (subdivisions > MaxSubdivisions) {
 		spdlog::warn("Capping icosphere subdivisions from {} to {}", 
 			subdivisions, MaxSubdivisions);
@@ -42,14 +68,15 @@ void IcosphereMesh::generateGeometry() {
 	/// Create base icosahedron
 	this->initializeBaseIcosahedron();
 
-	/// Perform requested number of subdivisions
-	for (uint32_t i = 0; i < this->subdivisions; ++i) {
-		spdlog::debug("Performing subdivision {}/{}", i + 1, this->subdivisions);
-		this->subdivide();
+	/// Subdivide all levels at once
+	if (this->subdivisions > 0) {
+		this->subdivideFaces();
 	}
 }
 
 void IcosphereMesh::applyVertexTransforms(const std::vector<VertexTransform>& transforms) {
+	this->detachSharedGeometry();
+
 	/// Verify transform count matches vertex count
 	if (transforms.size() != this->vertices.size()) {
 		throw vulkan::VulkanException(
@@ -60,6 +87,10 @@ void IcosphereMesh::applyVertexTransforms(const std::vector<VertexTransform>& tr
 	}
 
 	/// Apply each transform to its corresponding vertex
+	/// Only vertices that actually change are uploaded again, in runs of neighbours,
+	/// so tools that move a few vertices don't pay for the whole sphere
+	size_t runStart = 0;
+	size_t runLength = 0;
 	for (size_t i = 0; i < transforms.size(); ++i) {
 		const auto& transform = transforms[i];
 		auto& vertex = this->vertices[i];
@@ -68,39 +99,34 @@ void IcosphereMesh::applyVertexTransforms(const std::vector<VertexTransform>& tr
 			spdlog::warn("We are not the same!");
 		}
 
-		vertex.position = transform.position;
-		vertex.normal = transform.normal;
-		vertex.color = transform.color;
+		const bool changed = vertex.position != transform.position
+			|| vertex.normal != transform.normal
+			|| vertex.color != transform.color;
+		if (changed) {
+			vertex.position = transform.position;
+			vertex.normal = transform.normal;
+			vertex.color = transform.color;
+			if (runLength == 0) {
+				runStart = i;
+			}
+			++runLength;
+		} else if (runLength > 0) {
+			this->markVerticesDirty(static_cast<uint32_t>(runStart), static_cast<uint32_t>(runLength));
+			runLength = 0;
+		}
+	}
+	if (runLength > 0) {
+		this->markVerticesDirty(static_cast<uint32_t>(runStart), static_cast<uint32_t>(runLength));
 	}
 	// this->debugVertexOutliers();
-	// this->debugVertexOutliers();
-
-	/// Mark buffers as needing update since vertex data changed
-	/// This signals to the renderer that GPU buffers need rebuilding
-	this->markBuffersDirty();
-
 
 	spdlog::debug("Applied {} vertex transforms to icosphere", transforms.size());
 }
 
-std::vector<glm::vec3> IcosphereMesh::getVertexPositions() const {
-	/// Extract positions from vertices for external use
-	/// This allows transform calculations without exposing internal vertex format
-	std::vector<glm::vec3> positions;
-	positions.reserve(this->vertices.size());
-
-	for (const auto& vertex : this->vertices) {
-		positions.push_back(vertex.position);
-	}
-
-	return positions;
-}
-
 void IcosphereMesh::initializeBaseIcosahedron() {
 	/// Clear any existing geometry
 	this->vertices.clear();
 	this->indices.clear();
-	this->midpointCache.clear();
 
 	/// We construct the icosahedron using the golden ratio
 	/// phi φ is the golden ratio (≈ 1.618033988749895)
@@ -184,111 +210,187 @@ void IcosphereMesh::initializeBaseIcosahedron() {
 		this->vertices.size(), this->indices.size() / 3);
 }
 
-int64_t IcosphereMesh::generateEdgeKey(uint32_t index1, uint32_t index2) {
-	/// Always use the smaller index first for consistent key generation
-	/// This ensures (1,2) and (2,1) generate the same key
-	const uint32_t i1 = std::min(index1, index2);
-	const uint32_t i2 = std::max(index1, index2);
+void IcosphereMesh::subdivideFaces() {
+	/// The base icosahedron's faces become the patches
+	const std::vector<uint32_t> baseIndices = this->indices;
+	const uint32_t segments = 1u << this->subdivisions;
+
+	/// Collect the 30 edges in the order they first appear
+	std::array<BaseEdge, 30> edges{};
+	size_t edgeCount = 0;
+	for (size_t i = 0; i < baseIndices.size(); ++i) {
+		const uint32_t a = baseIndices[i];
+		const uint32_t b = baseIndices[i % 3 == 2 ? i - 2 : i + 1];
+		const BaseEdge edge{std::min(a, b), std::max(a, b)};
+		const auto end = edges.begin() + static_cast<std::ptrdiff_t>(edgeCount);
+		const bool known = std::any_of(edges.begin(), end, [&edge](const BaseEdge& other) {
+			return other.first == edge.first && other.second == edge.second;
+		});
+		if (!known) {
+			edges[edgeCount++] = edge;
+		}
+	}
 
-	/// Combine indices into a single 64-bit key
-	/// We use 32 bits for each index, allowing for up to 4 billion vertices
-	/// The shift by 32 puts the first index in the upper 32 bits
-	return (static_cast<int64_t>(i1) << 32) | static_cast<int64_t>(i2);
-}
+	/// Every vertex and index has a fixed place, so we size the output once
+	const size_t edgeVertexCount = edges.size() * (segments - 1);
+	const size_t faceVertexCount = BaseFaceCount * (segments - 1) * (segments - 2) / 2;
+	this->vertices.resize(BaseVertexCount + edgeVertexCount + faceVertexCount);
+	this->indices.resize(static_cast<size_t>(BaseFaceCount) * segments * segments * 3);
+
+	/// Edge vertices first, both faces along an edge read them
+	/// Halving the segment along the edge step by step gives the same positions
+	/// as splitting the triangles on both sides of it
+	std::vector<glm::vec3> edgePositions(segments + 1);
+	for (size_t edge = 0; edge < edges.size(); ++edge) {
+		edgePositions[0] = this->vertices[edges[edge].first].position;
+		edgePositions[segments] = this->vertices[edges[edge].second].position;
+		for (uint32_t step = segments; step >= 2; step /= 2) {
+			const uint32_t half = step / 2;
+			for (uint32_t k = half; k < segments; k += step) {
+				edgePositions[k] = sphereMidpoint(edgePositions[k - half], edgePositions[k + half], this->radius);
+			}
+		}
 
-uint32_t IcosphereMesh::getOrCreateMidpoint(uint32_t index1, uint32_t index2) {
-	/// Generate a unique key for this edge
-	const int64_t key = generateEdgeKey(index1, index2);
+		const size_t base = BaseVertexCount + edge * (segments - 1);
+		for (uint32_t k = 1; k < segments; ++k) {
+			this->vertices[base + k - 1] = createSphereVertex(edgePositions[k]);
+		}
+	}
 
-	/// Check if we already have a vertex for this edge
-	auto it = this->midpointCache.find(key);
-	if (it != this->midpointCache.end()) {
-		return it->second;
+	/// Faces take turns from a shared counter, each worker with its own scratch grid
+	const auto generateFaces = [this, &baseIndices, &edges](std::atomic<uint32_t>& nextFace) {
+		std::vector<glm::vec3> grid;
+		std::vector<uint32_t> gridIndices;
+		for (uint32_t face = nextFace++; face < BaseFaceCount; face = nextFace++) {
+			this->generateFacePatch(face, baseIndices, edges, grid, gridIndices);
+		}
+	};
+
+	std::atomic<uint32_t> nextFace{0};
+	if (this->vertices.size() < ParallelVertexThreshold) {
+		generateFaces(nextFace);
+	} else {
+		const uint32_t workerCount = std::clamp(std::thread::hardware_concurrency(), 1u, BaseFaceCount);
+		std::vector<std::future<void>> workers;
+		workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i) {
+			workers.push_back(std::async(std::launch::async, generateFaces, std::ref(nextFace)));
+		}
+		for (auto& worker : workers) {
+			worker.get();
+		}
 	}
 
-	/// No existing midpoint, so we need to create a new vertex
-	/// Get the positions of the two vertices we're interpolating between
-	const glm::vec3& p1 = this->vertices[index1].position;
-	const glm::vec3& p2 = this->vertices[index2].position;
-
-	/// Create the new vertex at the midpoint
-	Vertex newVertex;
-	/// Calculate midpoint and project onto sphere surface
-	/// We normalize to ensure the vertex lies exactly on the sphere
-	newVertex.position = glm::normalize(p1 + p2) * this->radius;
-
-	/// Average and normalize the normals of the two vertices
-	/// This creates smooth shading across the sphere
-	newVertex.normal = glm::normalize(
-		this->vertices[index1].normal +
-		this->vertices[index2].normal
-	);
-
-	/// Interpolate colors for smooth color transitions
-	newVertex.color = (
-		this->vertices[index1].color +
-		this->vertices[index2].color
-	) * 0.5f;
-
-	/// Add the new vertex to our mesh
-	const uint32_t newIndex = static_cast<uint32_t>(this->vertices.size());
-	this->vertices.push_back(newVertex);
-
-	/// Cache the midpoint for future lookups
-	this->midpointCache[key] = newIndex;
-
-	return newIndex;
+	spdlog::debug("Subdivision complete: {} vertices, {} triangles",
+		this->vertices.size(), this->indices.size() / 3);
 }
 
-void IcosphereMesh::subdivide() {
-	/// Each triangle is split into four new triangles:
-	///   v1        Original triangle: v1, v2, v3
-	///  /  \       After subdivision:
-	/// a -- b      - v1, a, b
-	///  \ /  \     - a, v2, c
-	///   c -- v2   - b, c, v3
-	///    \  /     - a, c, b
-	///     v3      where a, b, c are new vertices
-
-	/// Store original indices
-	/// We can't modify the index buffer while iterating through it
-	const std::vector<uint32_t> oldIndices = this->indices;
-
-	/// Clear index buffer for new triangles
-	/// Each triangle will become four new triangles
-	this->indices.clear();
-	this->indices.reserve(oldIndices.size() * 4);
-
-	/// Process each triangle
-	for (size_t i = 0; i < oldIndices.size(); i += 3) {
-		/// Get indices of original triangle vertices
-		const uint32_t v1 = oldIndices[i];
-		const uint32_t v2 = oldIndices[i + 1];
-		const uint32_t v3 = oldIndices[i + 2];
-
-		/// Get or create vertices at the midpoints of each edge
-		const uint32_t a = this->getOrCreateMidpoint(v1, v2);
-		const uint32_t b = this->getOrCreateMidpoint(v1, v3);
-		const uint32_t c = this->getOrCreateMidpoint(v2, v3);
-
-		/// Add four new triangles
-		/// Order is important to maintain consistent winding
-		this->indices.push_back(v1); this->indices.push_back(a); this->indices.push_back(b);
-		this->indices.push_back(a); this->indices.push_back(v2); this->indices.push_back(c);
-		this->indices.push_back(b); this->indices.push_back(c); this->indices.push_back(v3);
-		this->indices.push_back(a); this->indices.push_back(c); this->indices.push_back(b);
+void IcosphereMesh::generateFacePatch(uint32_t face,
+	const std::vector<uint32_t>& baseIndices,
+	const std::array<BaseEdge, 30>& edges,
+	std::vector<glm::vec3>& grid,
+	std::vector<uint32_t>& gridIndices) {
+	const uint32_t segments = 1u << this->subdivisions;
+
+	/// Grid point (i, j) lies i segments from corner a towards b and j segments towards c
+	/// Rows of constant i get shorter, so they are packed into a triangle
+	const auto gridIndex = [segments](uint32_t i, uint32_t j) -> size_t {
+		return static_cast<size_t>(i) * (segments + 1) - static_cast<size_t>(i) * (i - 1) / 2 + j;
+	};
+	const size_t gridSize = static_cast<size_t>(segments + 1) * (segments + 2) / 2;
+	grid.resize(gridSize);
+	gridIndices.resize(gridSize);
+
+	const uint32_t a = baseIndices[face * 3];
+	const uint32_t b = baseIndices[face * 3 + 1];
+	const uint32_t c = baseIndices[face * 3 + 2];
+
+	/// Index of the vertex a number of steps from one corner along a base edge
+	const auto edgeVertexIndex = [&edges, segments](uint32_t from, uint32_t to, uint32_t step) -> uint32_t {
+		const BaseEdge edge{std::min(from, to), std::max(from, to)};
+		const auto it = std::find_if(edges.begin(), edges.end(), [&edge](const BaseEdge& other) {
+			return other.first == edge.first && other.second == edge.second;
+		});
+		const uint32_t base = BaseVertexCount + static_cast<uint32_t>(it - edges.begin()) * (segments - 1);
+		return from == edge.first ? base + step - 1 : base + segments - step - 1;
+	};
+
+	/// The border comes from the corners and the shared edge vertices
+	const auto setBorder = [this, &grid, &gridIndices](size_t index, uint32_t vertexIndex) {
+		grid[index] = this->vertices[vertexIndex].position;
+		gridIndices[index] = vertexIndex;
+	};
+	setBorder(gridIndex(0, 0), a);
+	setBorder(gridIndex(segments, 0), b);
+	setBorder(gridIndex(0, segments), c);
+	for (uint32_t step = 1; step < segments; ++step) {
+		setBorder(gridIndex(step, 0), edgeVertexIndex(a, b, step));
+		setBorder(gridIndex(0, step), edgeVertexIndex(a, c, step));
+		setBorder(gridIndex(segments - step, step), edgeVertexIndex(b, c, step));
 	}
 
-	/// Clear midpoint cache after subdivision
-	/// This prevents memory growth when subdividing multiple times
-	this->midpointCache.clear();
+	/// Inner points in the order of their level, each is the midpoint of the edge it
+	/// splits, as if the triangles were subdivided one level at a time
+	for (uint32_t step = segments; step >= 2; step /= 2) {
+		const uint32_t half = step / 2;
+		for (uint32_t i = half; i < segments; i += half) {
+			for (uint32_t j = half; i + j < segments; j += half) {
+				const bool splitsI = i % step != 0;
+				const bool splitsJ = j % step != 0;
+				if (!splitsI && !splitsJ) {
+					continue;
+				}
+
+				size_t first;
+				size_t second;
+				if (splitsI && splitsJ) {
+					first = gridIndex(i - half, j + half);
+					second = gridIndex(i + half, j - half);
+				} else if (splitsI) {
+					first = gridIndex(i - half, j);
+					second = gridIndex(i + half, j);
+				} else {
+					first = gridIndex(i, j - half);
+					second = gridIndex(i, j + half);
+				}
+				grid[gridIndex(i, j)] = sphereMidpoint(grid[first], grid[second], this->radius);
+			}
+		}
+	}
 
-	spdlog::debug("Subdivision complete: {} vertices, {} triangles",
-		this->vertices.size(), this->indices.size() / 3);
+	/// Inner vertices of this face follow those of the faces before it
+	const size_t innerPerFace = static_cast<size_t>(segments - 1) * (segments - 2) / 2;
+	uint32_t vertexIndex = static_cast<uint32_t>(
+		BaseVertexCount + edges.size() * (segments - 1) + face * innerPerFace);
+	for (uint32_t i = 1; i < segments; ++i) {
+		for (uint32_t j = 1; i + j < segments; ++j) {
+			const size_t index = gridIndex(i, j);
+			gridIndices[index] = vertexIndex;
+			this->vertices[vertexIndex] = createSphereVertex(grid[index]);
+			++vertexIndex;
+		}
+	}
+
+	/// Each grid cell has an upright triangle with the face's winding, and all but the
+	/// last one in a row an inverted one, segments^2 triangles in total
+	uint32_t* output = this->indices.data() + static_cast<size_t>(face) * segments * segments * 3;
+	for (uint32_t i = 0; i < segments; ++i) {
+		for (uint32_t j = 0; i + j < segments; ++j) {
+			*output++ = gridIndices[gridIndex(i, j)];
+			*output++ = gridIndices[gridIndex(i + 1, j)];
+			*output++ = gridIndices[gridIndex(i, j + 1)];
+			if (i + j + 1 < segments) {
+				*output++ = gridIndices[gridIndex(i + 1, j)];
+				*output++ = gridIndices[gridIndex(i + 1, j + 1)];
+				*output++ = gridIndices[gridIndex(i, j + 1)];
+			}
+		}
+	}
 }
 
 void IcosphereMesh::debugVertexOutliers() {
 	spdlog::warn("debugVertexOutliers()");
+	this->detachSharedGeometry();
 	const auto& indices = this->getIndices();
 	const auto& vertices = this->getVertices();
 
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "mesh.h"
-#include <map>
+#include <array>
 #include <cstdint>
 
 namespace lillugsi::rendering {
@@ -14,6 +14,11 @@ namespace lillugsi::rendering {
 /// - Efficient memory use (no vertex clustering at poles)
 class IcosphereMesh : public Mesh {
 public:
+	/// Highest subdivision level
+	/// Each level quadruples the triangle count, at level 10 the sphere has
+	/// 10,485,762 vertices and about 590 MB of vertex data
+	static constexpr uint32_t MaxSubdivisions = 10;
+
 	/// Vertex transform data for mesh updates
 	/// This structure contains all data needed to update a vertex's properties
 	/// We use this interface to decouple mesh updates from specific data sources
@@ -33,20 +38,28 @@ public:
 	/// - 2: 162 vertices, 320 triangles
 	/// - 3: 642 vertices, 1280 triangles
 	/// - 4: 2562 vertices, 5120 triangles
+	/// - n: 10 * 4^n + 2 vertices, 20 * 4^n triangles
 	explicit IcosphereMesh(float radius = 1.0f, uint32_t subdivisions = 1);
 	~IcosphereMesh() override = default;
 
 	void generateGeometry() override;
 
+	/// Spheres of the same radius and subdivision level share their geometry
+	[[nodiscard]] std::optional<GeometryKey> getGeometryKey() const override {
+		return GeometryKey{ProceduralGeometryType::Icosphere, this->subdivisions, this->radius};
+	}
+
 	/// Apply transforms to update mesh vertices
+	/// A sphere sharing its geometry gets its own copy first, the others keep the original
 	/// @param transforms Vector of transforms matching vertex count
 	/// @throws VulkanException if transform count doesn't match vertex count
 	void applyVertexTransforms(const std::vector<VertexTransform>& transforms);
 
 	/// Get current vertex positions
-	/// Useful for computing transforms based on current mesh state
-	/// @return Vector of current vertex positions
-	[[nodiscard]] std::vector<glm::vec3> getVertexPositions() const;
+	/// Useful for computing transforms based on current mesh state.
+	/// The view is invalidated by applyVertexTransforms, copy it if it's needed afterwards
+	/// @return View of the current vertex positions
+	[[nodiscard]] StridedView<glm::vec3> getVertexPositions() const { return this->getPositionView(); }
 
 	/// Get the current radius of the icosphere
 	/// @return The sphere's base radius
@@ -64,37 +77,38 @@ private:
 	/// - It provides a good base for spherical approximation
 	void initializeBaseIcosahedron();
 
-	/// Subdivide the current geometry once
-	/// Each triangle is split into four smaller triangles while maintaining:
-	/// - Vertex sharing between triangles
-	/// - Proper face orientation
-	/// - Even distribution of vertices
-	void subdivide();
-
-	/// Get or create a vertex at the midpoint between two existing vertices
-	/// We cache midpoints to avoid duplicate vertices, which:
-	/// - Reduces memory usage
-	/// - Ensures proper vertex sharing for smooth shading
-	/// - Maintains mesh integrity during subdivision
-	/// @param index1 Index of first vertex
-	/// @param index2 Index of second vertex
-	/// @return Index of the midpoint vertex (either existing or newly created)
-	[[nodiscard]] uint32_t getOrCreateMidpoint(uint32_t index1, uint32_t index2);
-
-	/// Generate a unique key for edge midpoint caching
-	/// We need this to efficiently look up existing midpoints
-	/// @param index1 First vertex index
-	/// @param index2 Second vertex index
-	/// @return Unique key for this edge
-	[[nodiscard]] static int64_t generateEdgeKey(uint32_t index1, uint32_t index2);
+	/// Edge of the base icosahedron, the lower vertex index first
+	struct BaseEdge {
+		uint32_t first;
+		uint32_t second;
+	};
 
-	void debugVertexOutliers();
+	/// Replace the base icosahedron by its subdivided form in one pass
+	/// Subdividing a whole mesh level by level needs a lookup per edge to share
+	/// midpoints, which dominates at high levels. Every base face becomes a
+	/// triangular grid of 2^subdivisions segments per edge instead, with all
+	/// vertex indices known up front:
+	/// - 0 to 11 are the base vertices
+	/// - then the inner vertices of each base edge, shared by both faces on it
+	/// - then the inner vertices of each base face
+	/// Positions are the same as those of repeated midpoint subdivision.
+	void subdivideFaces();
+
+	/// Write the inner vertices and the triangles of one base face
+	/// Base edge vertices must already be in place. Faces only write their own
+	/// vertices and index range, so they can be generated in parallel
+	/// @param face Index of the base face
+	/// @param baseIndices Indices of the base icosahedron
+	/// @param edges Edges of the base icosahedron
+	/// @param grid Scratch memory for the face's grid positions, reused between faces
+	/// @param gridIndices Scratch memory for the face's grid vertex indices
+	void generateFacePatch(uint32_t face,
+		const std::vector<uint32_t>& baseIndices,
+		const std::array<BaseEdge, 30>& edges,
+		std::vector<glm::vec3>& grid,
+		std::vector<uint32_t>& gridIndices);
 
-	/// Cache for midpoint vertices during subdivision
-	/// The key is a 64-bit hash of the two vertex indices
-	/// The value is the index of the midpoint vertex
-	/// We use this to avoid creating duplicate vertices
-	std::map<int64_t, uint32_t> midpointCache;
+	void debugVertexOutliers();
 
 	float radius;                    /// Base radius of the sphere
 	uint32_t subdivisions;          /// Number of subdivision steps
@@ -1,5 +1,8 @@
 #include "light.h"
 #include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+#include <algorithm>
+#include <cmath>
 #include <spdlog/spdlog.h>
 
 namespace lillugsi::rendering {
@@ -54,6 +57,8 @@ LightData DirectionalLight::getLightData() const {
 	
 	/// Pack ambient color into vec4
 	data.ambient = glm::vec4(this->ambient, 0.0f);
+
+	data.typeAndCone.x = static_cast<float>(LightType::Directional);
 	
 	return data;
 }
@@ -93,4 +98,63 @@ glm::vec3 DirectionalLight::getAmbient() const {
 	return this->ambient;
 }
 
+PointLight::PointLight(const glm::vec3& position, float range)
+	: position(position) {
+	this->setRange(range);
+	spdlog::debug("Created point light at ({}, {}, {}) with range {}",
+		position.x, position.y, position.z, this->range);
+}
+
+void PointLight::setRange(float range) {
+	/// A zero range would divide by zero in the attenuation
+	this->range = std::max(range, 0.01f);
+}
+
+void PointLight::setIntensity(float intensity) {
+	/// Negative light intensities don't make physical sense
+	this->intensity = std::max(0.0f, intensity);
+}
+
+LightData PointLight::getLightData() const {
+	LightData data;
+	data.direction = glm::vec4(0.0f);
+	data.colorAndIntensity = glm::vec4(this->color * this->intensity, 1.0f);
+	data.ambient = glm::vec4(this->ambient, 0.0f);
+	data.positionAndRange = glm::vec4(this->position, this->range);
+	data.typeAndCone.x = static_cast<float>(LightType::Point);
+	return data;
+}
+
+SpotLight::SpotLight(const glm::vec3& position, const glm::vec3& direction, float range)
+	: PointLight(position, range) {
+	this->setDirection(direction);
+}
+
+void SpotLight::setDirection(const glm::vec3& direction) {
+	/// Same validation as for directional lights
+	if (glm::length(direction) < 1e-6f) {
+		spdlog::warn("Attempted to set zero direction vector for spot light");
+		return;
+	}
+	this->direction = glm::normalize(direction);
+}
+
+void SpotLight::setConeAngles(float innerAngle, float outerAngle) {
+	/// Keep the outer cone below a hemisphere and the inner cone strictly inside the outer one,
+	/// otherwise the smooth falloff between both would be undefined
+	this->outerAngle = std::clamp(outerAngle, 0.1f, 89.0f);
+	this->innerAngle = std::clamp(innerAngle, 0.0f, this->outerAngle - 0.1f);
+}
+
+LightData SpotLight::getLightData() const {
+	LightData data = PointLight::getLightData();
+	data.direction = glm::vec4(this->direction, 0.0f);
+	data.typeAndCone = glm::vec4(
+		static_cast<float>(LightType::Spot),
+		std::cos(glm::radians(this->innerAngle)),
+		std::cos(glm::radians(this->outerAngle)),
+		0.0f);
+	return data;
+}
+
 } /// namespace lillugsi::rendering
\ No newline at end of file
@@ -5,18 +5,27 @@
 
 namespace lillugsi::rendering {
 
+/// Light types as stored in LightData::typeAndCone.x
+/// Directional lights affect every pixel, point and spot lights only
+/// the pixels within their range and are binned into clusters for that
+enum class LightType : uint32_t {
+	Directional = 0,
+	Point = 1,
+	Spot = 2
+};
+
 /// LightData represents the GPU-side data structure for lights
-/// We align this structure to meet Vulkan's requirements for uniform buffers
+/// We align this structure to meet Vulkan's requirements for storage buffers (std430)
 /// The structure is designed to be efficiently packed and aligned for GPU access
 struct alignas(16) LightData {
-	/// Direction vector for the light
+	/// Direction vector for directional and spot lights
 	/// We use vec4 instead of vec3 for alignment purposes
 	/// The w component is unused but provides padding
 	glm::vec4 direction{0.0f, -1.0f, 0.0f, 0.0f};
 
 	/// Light color and intensity
 	/// RGB components represent color, w component stores intensity
-	/// This combines color and intensity in one vector to reduce uniform buffer size
+	/// This combines color and intensity in one vector to reduce buffer size
 	/// All lights with colorAndIntensity > 0 will be added to the light calculation
 	glm::vec4 colorAndIntensity{0.0f};
 
@@ -24,6 +33,14 @@ struct alignas(16) LightData {
 	/// We separate ambient from main color to allow for different ambient colors
 	/// The w component is unused but maintains alignment
 	glm::vec4 ambient{0.1f, 0.1f, 0.1f, 0.0f};
+
+	/// World position in xyz and range in w for point and spot lights
+	/// The light has no effect beyond its range, which is what makes clustering work
+	glm::vec4 positionAndRange{0.0f};
+
+	/// LightType in x, cosine of the inner and outer spot cone angle in y and z
+	/// We store the type as float to keep the struct a plain array of vec4
+	glm::vec4 typeAndCone{0.0f};
 };
 
 /// Base class for all light types
@@ -40,6 +57,10 @@ public:
 	/// @return The GPU-compatible light data structure
 	[[nodiscard]] virtual LightData getLightData() const = 0;
 
+	/// Get the type of this light
+	/// @return The light type
+	[[nodiscard]] virtual LightType getType() const = 0;
+
 	/// Set the light's color
 	/// @param color The RGB color of the light
 	virtual void setColor(const glm::vec3& color) = 0;
@@ -89,6 +110,7 @@ public:
 
 	/// Implementation of base class virtual methods
 	[[nodiscard]] LightData getLightData() const override;
+	[[nodiscard]] LightType getType() const override { return LightType::Directional; }
 	void setColor(const glm::vec3& color) override;
 	[[nodiscard]] glm::vec3 getColor() const override;
 	void setIntensity(float intensity) override;
@@ -103,4 +125,83 @@ private:
 	glm::vec3 ambient{0.1f};                 /// Ambient light color
 };
 
+/// PointLight emits light in all directions from a position
+/// Its contribution fades out smoothly and reaches zero at its range,
+/// so it only needs to be evaluated for pixels within that range
+class PointLight : public Light {
+public:
+	/// Constructor
+	/// @param position World position of the light
+	/// @param range Distance at which the light's contribution reaches zero
+	explicit PointLight(const glm::vec3& position = glm::vec3(0.0f), float range = 10.0f);
+
+	/// Set the light's position
+	/// @param position World position of the light
+	void setPosition(const glm::vec3& position) { this->position = position; }
+
+	/// Get the light's position
+	/// @return World position of the light
+	[[nodiscard]] glm::vec3 getPosition() const { return this->position; }
+
+	/// Set the light's range
+	/// @param range Distance at which the contribution reaches zero, clamped to be positive
+	void setRange(float range);
+
+	/// Get the light's range
+	/// @return Distance at which the contribution reaches zero
+	[[nodiscard]] float getRange() const { return this->range; }
+
+	/// Implementation of base class virtual methods
+	[[nodiscard]] LightData getLightData() const override;
+	[[nodiscard]] LightType getType() const override { return LightType::Point; }
+	void setColor(const glm::vec3& color) override { this->color = color; }
+	[[nodiscard]] glm::vec3 getColor() const override { return this->color; }
+	void setIntensity(float intensity) override;
+	[[nodiscard]] float getIntensity() const override { return this->intensity; }
+	void setAmbient(const glm::vec3& ambient) override { this->ambient = ambient; }
+	[[nodiscard]] glm::vec3 getAmbient() const override { return this->ambient; }
+
+protected:
+	glm::vec3 position{0.0f};  /// World position
+	float range{10.0f};        /// Distance of zero contribution
+	glm::vec3 color{1.0f};     /// Light color (RGB)
+	float intensity{1.0f};     /// Light intensity
+	glm::vec3 ambient{0.0f};   /// Local lights add no ambient light by default
+};
+
+/// SpotLight is a point light restricted to a cone
+/// Between the inner and outer cone angle the light fades out smoothly
+class SpotLight : public PointLight {
+public:
+	/// Constructor
+	/// @param position World position of the light
+	/// @param direction Direction the cone points to (will be normalized)
+	/// @param range Distance at which the light's contribution reaches zero
+	explicit SpotLight(const glm::vec3& position = glm::vec3(0.0f),
+		const glm::vec3& direction = glm::vec3(0.0f, -1.0f, 0.0f),
+		float range = 10.0f);
+
+	/// Set the cone direction
+	/// @param direction The direction vector (will be normalized)
+	void setDirection(const glm::vec3& direction);
+
+	/// Get the cone direction
+	/// @return The normalized direction vector
+	[[nodiscard]] glm::vec3 getDirection() const { return this->direction; }
+
+	/// Set the cone angles
+	/// @param innerAngle Half angle in degrees with full intensity
+	/// @param outerAngle Half angle in degrees where the light reaches zero
+	void setConeAngles(float innerAngle, float outerAngle);
+
+	/// Implementation of base class virtual methods
+	[[nodiscard]] LightData getLightData() const override;
+	[[nodiscard]] LightType getType() const override { return LightType::Spot; }
+
+private:
+	glm::vec3 direction{0.0f, -1.0f, 0.0f};  /// Cone direction (normalized)
+	float innerAngle{20.0f};                 /// Inner half angle in degrees
+	float outerAngle{30.0f};                 /// Outer half angle in degrees
+};
+
 } /// namespace lillugsi::rendering
\ No newline at end of file
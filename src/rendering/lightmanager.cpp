@@ -1,5 +1,6 @@
 #include "lightmanager.h"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 
 namespace lillugsi::rendering {
 
@@ -76,28 +77,33 @@ std::shared_ptr<Light> LightManager::getLight(uint32_t index) const {
 	return this->lights[index];
 }
 
-std::vector<LightData> LightManager::getLightData() const {
-	/// Create vector to hold GPU-formatted light data
+void LightManager::getLightData(std::vector<LightData>& lightData) const {
 	/// We prepare all light data at once for efficient GPU upload
-	std::vector<LightData> lightData;
+	lightData.clear();
 	lightData.reserve(this->lights.size());
 
-	/// Convert each light to its GPU format
+	/// Directional lights first, the shaders loop over them without culling
 	for (const auto& light : this->lights) {
-		lightData.push_back(light->getLightData());
+		if (light->getType() == LightType::Directional) {
+			lightData.push_back(light->getLightData());
+		}
 	}
 
-	/// Pad the buffer to MaxLights if necessary
-	/// This ensures consistent buffer size for the GPU
-	/// We fill unused slots with default-constructed LightData
-	while (lightData.size() < MaxLights) {
-		lightData.push_back(LightData{});
+	/// Then the local lights, which are culled per cluster
+	for (const auto& light : this->lights) {
+		if (light->getType() != LightType::Directional) {
+			lightData.push_back(light->getLightData());
+		}
 	}
 
-	spdlog::trace("Prepared GPU data for {} lights (buffer size: {})",
-		this->lights.size(), lightData.size());
+	spdlog::trace("Prepared GPU data for {} lights", lightData.size());
+}
 
-	return lightData;
+uint32_t LightManager::getDirectionalLightCount() const {
+	return static_cast<uint32_t>(std::count_if(this->lights.begin(), this->lights.end(),
+		[](const std::shared_ptr<Light>& light) {
+			return light->getType() == LightType::Directional;
+		}));
 }
 
 } /// namespace lillugsi::rendering
\ No newline at end of file
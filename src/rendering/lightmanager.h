@@ -12,13 +12,13 @@ namespace lillugsi::rendering {
 /// We separate light management to:
 /// 1. Centralize light-related operations
 /// 2. Efficiently batch light data updates
-/// 3. Prepare for future features like light culling
+/// 3. Hand lights to the GPU in the order clustered light culling expects
 class LightManager {
 public:
-	/// Current maximum number of supported lights
-	/// We use a fixed limit to simplify GPU buffer management
-	/// This could be made dynamic in the future if needed
-	static constexpr uint32_t MaxLights = 16;
+	/// Maximum number of supported lights
+	/// Lights live in a storage buffer of fixed capacity, and local lights are culled
+	/// per cluster, so the limit is about memory rather than shading cost
+	static constexpr uint32_t MaxLights = 16384;
 
 	LightManager() = default;
 
@@ -59,9 +59,15 @@ public:
 	}
 
 	/// Get GPU data for all lights
-	/// This prepares the light data in a format ready for GPU upload
-	/// @return Vector of GPU-formatted light data
-	[[nodiscard]] std::vector<LightData> getLightData() const;
+	/// Directional lights come first since they affect every pixel,
+	/// followed by the point and spot lights that get binned into clusters
+	/// @param lightData Receives the light data; cleared first, its capacity is reused
+	void getLightData(std::vector<LightData>& lightData) const;
+
+	/// Get the number of directional lights
+	/// These are the first entries of the light data
+	/// @return Number of directional lights
+	[[nodiscard]] uint32_t getDirectionalLightCount() const;
 
 	/// Check if adding another light is possible
 	/// @return true if another light can be added
@@ -4,10 +4,20 @@
 #include "vulkan/pipelineconfig.h"
 #include "materialtype.h"
 #include "shadertype.h"
+#include "vertex.h"
+#include <glm/glm.hpp>
 #include <string>
 
 namespace lillugsi::rendering {
 
+/// Push constants of material pipelines
+/// Standard meshes only push the model matrix, quantized meshes also push how
+/// their vertices are dequantized, which only the quantized pipelines read
+struct MaterialPushConstants {
+	glm::mat4 model;
+	VertexDequantization dequantization;
+};
+
 /// Base class for all materials in the rendering system
 /// We use a pure virtual interface to allow for different material types
 /// while maintaining a consistent interface for the renderer
@@ -34,6 +44,21 @@ public:
 	/// @return The pipeline configuration for this material
 	[[nodiscard]] virtual vulkan::PipelineConfig getPipelineConfig() const;
 
+	/// Get the number of LOD variants this material's shaders provide
+	/// Materials with a single level are drawn with the same pipeline at any distance
+	/// @return Number of levels, between 1 and MaterialLodCount
+	[[nodiscard]] virtual uint32_t getLodCount() const { return 1; }
+
+	/// Check whether the material's vertex shader can draw QuantizedVertex meshes
+	/// Materials that can get a second set of pipelines for them
+	/// @return True if the vertex shader reads the VertexFormatConstantId constant
+	[[nodiscard]] virtual bool supportsQuantizedVertices() const { return false; }
+
+	/// Get the vertex shader that places vertices with per-instance transforms
+	/// Materials that have one get a third set of pipelines for MeshInstances
+	/// @return Path of the instanced vertex shader, empty if instancing isn't supported
+	[[nodiscard]] virtual std::string getInstancedVertexShaderPath() const { return {}; }
+
 	/// Get the type of this material
 	/// This helps the renderer optimize drawing and state management
 	/// @return The material's type
@@ -69,6 +94,11 @@ public:
 	/// @return The descriptor set layout for this material
 	[[nodiscard]] virtual VkDescriptorSetLayout getDescriptorSetLayout() const;
 
+	/// Get the descriptor set holding this material's resources
+	/// bind() covers graphics pipelines, compute passes bind the set themselves
+	/// @return The material descriptor set (set = 2)
+	[[nodiscard]] VkDescriptorSet getDescriptorSet() const { return this->descriptorSet; }
+
 	/// Disable copying to prevent multiple materials sharing GPU resources
 	Material(const Material&) = delete;
 	Material& operator=(const Material&) = delete;
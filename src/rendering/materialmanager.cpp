@@ -22,6 +22,8 @@ MaterialManager::~MaterialManager() {
 std::shared_ptr<PBRMaterial> MaterialManager::createPBRMaterial(
 	const std::string& name
 ) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
 	/// Check if material already exists
 	auto it = this->materials.find(name);
 	if (it != this->materials.end()) {
@@ -68,6 +70,8 @@ std::shared_ptr<CustomMaterial> MaterialManager::createCustomMaterial(
 	const std::string& vertexShaderPath,
 	const std::string& fragmentShaderPath
 ) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
 	/// Validate material name before creation
 	this->validateMaterialName(name);
 
@@ -89,6 +93,8 @@ std::shared_ptr<CustomMaterial> MaterialManager::createCustomMaterial(
 }
 
 std::shared_ptr<WireframeMaterial> MaterialManager::createWireframeMaterial(const std::string &name) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
 	/// Check if material already exists
 	auto it = this->materials.find(name);
 	if (it != this->materials.end()) {
@@ -118,6 +124,8 @@ std::shared_ptr<WireframeMaterial> MaterialManager::createWireframeMaterial(cons
 	return material;
 }
 std::shared_ptr<TerrainMaterial> MaterialManager::createTerrainMaterial(const std::string &name) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
 	/// Check if material already exists
 	auto it = this->materials.find(name);
 	if (it != this->materials.end()) {
@@ -148,6 +156,8 @@ std::shared_ptr<TerrainMaterial> MaterialManager::createTerrainMaterial(const st
 }
 
 std::shared_ptr<DebugMaterial> MaterialManager::createDebugMaterial(const std::string& name) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
 	/// Check if material already exists
 	auto it = this->materials.find(name);
 	if (it != this->materials.end()) {
@@ -180,9 +190,15 @@ std::shared_ptr<DebugMaterial> MaterialManager::createDebugMaterial(const std::s
 	return material;
 }
 
+std::unordered_map<std::string, std::shared_ptr<Material>> MaterialManager::getMaterials() const {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->materials;
+}
+
 std::shared_ptr<Material> MaterialManager::getMaterial(
 	const std::string& name
 ) const {
+	std::lock_guard<std::mutex> lock(this->mutex);
 	auto it = this->materials.find(name);
 	if (it != this->materials.end()) {
 		return it->second;
@@ -193,6 +209,7 @@ std::shared_ptr<Material> MaterialManager::getMaterial(
 }
 
 bool MaterialManager::hasMaterial(const std::string& name) const {
+	std::lock_guard<std::mutex> lock(this->mutex);
 	return this->materials.find(name) != this->materials.end();
 }
 
@@ -200,6 +217,7 @@ void MaterialManager::cleanup() {
 	/// Clear the materials map
 	/// This will trigger destruction of all materials
 	/// thanks to shared_ptr reference counting
+	std::lock_guard<std::mutex> lock(this->mutex);
 	size_t count = this->materials.size();
 	this->materials.clear();
 	
@@ -218,8 +236,8 @@ void MaterialManager::validateMaterialName(const std::string& name) const {
 		);
 	}
 
-	/// Check for existing material
-	if (this->hasMaterial(name)) {
+	/// Check for existing material, the caller holds the mutex
+	if (this->materials.find(name) != this->materials.end()) {
 		throw vulkan::VulkanException(
 			VK_ERROR_VALIDATION_FAILED_EXT,
 			"Material '" + name + "' already exists",
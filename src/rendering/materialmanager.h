@@ -9,6 +9,7 @@
 #include "wireframematerial.h"
 #include "debugmaterial.h"
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -20,6 +21,9 @@ namespace lillugsi::rendering {
 /// 2. Enable material reuse through caching
 /// 3. Manage GPU resource lifecycle
 /// 4. Provide a single point of control for material system features
+///
+/// Loader and prefetch threads create materials while the update and render threads
+/// look them up, so all access to the material map goes through a mutex.
 class MaterialManager {
 public:
 	/// Create the material manager
@@ -80,9 +84,8 @@ public:
 
 	/// Get all managed materials
 	/// This can be useful for batch operations or debugging
-	/// @return Const reference to the material map
-	[[nodiscard]] const std::unordered_map<std::string, std::shared_ptr<Material>>&
-		getMaterials() const { return this->materials; }
+	/// @return Copy of the material map, other threads may add materials meanwhile
+	[[nodiscard]] std::unordered_map<std::string, std::shared_ptr<Material>> getMaterials() const;
 
 	/// Clean up all materials
 	/// This should be called before the Vulkan device is destroyed
@@ -90,6 +93,7 @@ public:
 
 private:
 	/// Validate material name and check for duplicates
+	/// Called with the mutex held
 	/// @param name The name to validate
 	/// @throws VulkanException if name is invalid or exists
 	void validateMaterialName(const std::string& name) const;
@@ -97,6 +101,9 @@ private:
 	VkDevice device;
 	VkPhysicalDevice physicalDevice;
 	std::shared_ptr<TextureManager> textureManager;
+
+	/// Guards materials
+	mutable std::mutex mutex;
 	std::unordered_map<std::string, std::shared_ptr<Material>> materials;
 };
 
@@ -48,6 +48,24 @@ enum class MaterialType : uint32_t {
 	}
 }
 
+/// MaterialLod selects a cheaper shader variant for draws that cover few pixels
+/// Distant objects don't show the detail of normal maps or extra texture layers,
+/// so we skip those fetches once an object gets small on screen.
+/// Each level is the same shader compiled with a different specialization constant,
+/// the compiler then removes the skipped work entirely instead of branching around it
+enum class MaterialLod : uint32_t {
+	Full = 0,     /// Every feature of the material
+	Reduced = 1,  /// No normal or occlusion maps, fewer noise octaves
+	Minimal = 2   /// Base color and constant surface parameters only
+};
+
+/// Number of material LOD levels
+inline constexpr uint32_t MaterialLodCount = 3;
+
+/// Specialization constant id shaders read the LOD level from
+/// Matches constant_id = 0 in the shaders supporting LODs
+inline constexpr uint32_t MaterialLodConstantId = 0;
+
 /// MaterialFeatureFlags defines optional features that can be enabled for materials
 /// We use flags to allow combinations of features to be enabled
 /// This helps optimize shader compilation by only including needed features
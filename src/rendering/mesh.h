@@ -1,15 +1,20 @@
 #pragma once
 
+#include "geometryview.h"
 #include "material.h"
+#include "meshgeometry.h"
 #include "vertex.h"
+#include <algorithm>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/glm.hpp>
 #include <memory>
+#include <optional>
 #include <spdlog/spdlog.h>
 #include <utility>
 #include <vector>
 
 namespace lillugsi::vulkan {
+class Buffer;
 class VertexBuffer;
 class IndexBuffer;
 }
@@ -37,11 +42,47 @@ public:
 		/// as long as any RenderData referring to it exists
 		std::shared_ptr<Material> material;
 
+		/// World space bounding sphere of the mesh, radius 0 if unknown
+		/// The renderer picks the material LOD from its size on screen
+		glm::vec3 boundsCenter{0.0f};
+		float boundsRadius{0.0f};
+
+		/// Material shader variant to draw with
+		MaterialLod materialLod{MaterialLod::Full};
+
+		/// Layout of the vertex buffer, and how quantized vertices map back to object space
+		VertexFormat vertexFormat{VertexFormat::Standard};
+		VertexDequantization dequantization;
+
+		/// Instances drawn with one instanced draw, relative to the model matrix
+		/// Without an instance buffer the mesh is drawn once at the model matrix
+		std::shared_ptr<vulkan::Buffer> instanceBuffer;
+		uint32_t firstInstance{0};
+		uint32_t instanceCount{1};
+
+		/// The vertex buffer is rewritten by the skinning pass every frame
+		bool skinned{false};
+
 		/// Future expansion fields:
 		/// bool isTransparent;     /// For render sorting
-		/// float distanceToCamera; /// For LOD/culling
 	};
 
+	/// Object space axis aligned bounds of the vertices
+	struct Bounds {
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	/// A run of changed vertices or indices
+	struct DirtyRange {
+		uint32_t first;
+		uint32_t count;
+	};
+
+	/// Dirty ranges kept per mesh before they are merged into one
+	/// Each range becomes a copy region, beyond this a single larger copy is cheaper
+	static constexpr size_t MaxDirtyRanges = 32;
+
 	Mesh() = default;
 	virtual ~Mesh() = default;
 
@@ -50,23 +91,195 @@ public:
 	/// to define their specific geometry
 	virtual void generateGeometry() = 0;
 
+	/// Get the parameters the geometry is generated from
+	/// Meshes with a key share their geometry with every other mesh of the same key
+	/// @return The key, or nothing if the geometry is unique to this mesh
+	[[nodiscard]] virtual std::optional<GeometryKey> getGeometryKey() const { return std::nullopt; }
+
 	/// Prepare render data for this mesh
 	/// This method populates a RenderData struct with everything needed to render the mesh
+	/// Placement comes from the scene node drawing the mesh, so the model matrix is left as identity
 	/// @param data Reference to RenderData struct to populate
 	virtual void prepareRenderData(RenderData& data) const {
-		data.modelMatrix = glm::translate(glm::mat4(1.0f), this->translation);
+		data.modelMatrix = glm::mat4(1.0f);
 		data.vertexBuffer = this->vertexBuffer;
 		data.indexBuffer = this->indexBuffer;
 		data.material = this->material;
+		data.vertexFormat = this->vertexFormat;
+		data.dequantization = this->dequantization;
 	}
 
 	/// Get vertex data (used during buffer creation)
-	/// @return A const reference to the vector of vertices
-	const std::vector<Vertex>& getVertices() const { return this->vertices; }
+	/// @return A const reference to the vector of vertices, shared ones if the mesh uses shared geometry
+	const std::vector<Vertex>& getVertices() const {
+		return this->sharedGeometry ? this->sharedGeometry->vertices : this->vertices;
+	}
 
 	/// Get index data (used during buffer creation)
-	/// @return A const reference to the vector of indices
-	const std::vector<uint32_t>& getIndices() const { return this->indices; }
+	/// @return A const reference to the vector of indices, shared ones if the mesh uses shared geometry
+	const std::vector<uint32_t>& getIndices() const {
+		return this->sharedGeometry ? this->sharedGeometry->indices : this->indices;
+	}
+
+	/// Get a view of the vertices, shared ones if the mesh uses shared geometry
+	/// Like the references above, the view is invalidated when the geometry changes
+	[[nodiscard]] ArrayView<Vertex> getVertexView() const {
+		return ArrayView<Vertex>(this->getVertices());
+	}
+
+	/// Get a view of the indices, shared ones if the mesh uses shared geometry
+	[[nodiscard]] ArrayView<uint32_t> getIndexView() const {
+		return ArrayView<uint32_t>(this->getIndices());
+	}
+
+	/// Get a view of the vertex positions
+	/// Bounds, picking and tools only need positions, this walks them in place.
+	/// Meshes that released their vertices provide the compact copy they kept, if any
+	[[nodiscard]] StridedView<glm::vec3> getPositionView() const {
+		const auto& source = this->getVertices();
+		if (source.empty()) {
+			return StridedView<glm::vec3>(this->retainedPositions);
+		}
+		return StridedView<glm::vec3>(&source.front().position, source.size(), sizeof(Vertex));
+	}
+
+	/// Draw from quantized vertices instead of the float ones
+	/// The vertex buffer is created from these, the float vertices only serve bounds,
+	/// tangents and tools. Edits to them aren't requantized, imported meshes aren't edited
+	/// @param quantized One compact vertex per float vertex
+	/// @param mapping How the integers map back to object space
+	void setQuantizedVertices(std::vector<QuantizedVertex> quantized, const VertexDequantization& mapping) {
+		this->quantizedVertices = std::move(quantized);
+		this->dequantization = mapping;
+		this->vertexFormat = this->quantizedVertices.empty() ? VertexFormat::Standard : VertexFormat::Quantized;
+		this->markBuffersDirty();
+	}
+
+	/// Get the layout of the mesh's vertex buffer
+	[[nodiscard]] VertexFormat getVertexFormat() const { return this->vertexFormat; }
+
+	/// Get the compact vertices the buffer of a quantized mesh is created from
+	[[nodiscard]] const std::vector<QuantizedVertex>& getQuantizedVertices() const {
+		return this->quantizedVertices;
+	}
+
+	/// Get how the quantized vertices map back to object space
+	[[nodiscard]] const VertexDequantization& getDequantization() const { return this->dequantization; }
+
+	/// Get the bounds of the vertices
+	/// Still known after the vertices were released
+	/// @return The bounds, or nothing if the mesh has no geometry
+	[[nodiscard]] std::optional<Bounds> getBounds() const {
+		if (this->displacedBounds) {
+			return this->displacedBounds;
+		}
+		if (this->getVertices().empty()) {
+			return this->releasedBounds;
+		}
+
+		const auto positions = this->getPositionView();
+		Bounds bounds{positions[0], positions[0]};
+		for (const auto& position : positions) {
+			bounds.min = glm::min(bounds.min, position);
+			bounds.max = glm::max(bounds.max, position);
+		}
+		return bounds;
+	}
+
+	/// Set bounds for vertices a GPU pass moves away from the host copies
+	/// The host vertices then no longer tell where the mesh is drawn
+	/// @param bounds Bounds of every position the pass can write, nothing to use the vertices again
+	void setDisplacedBounds(std::optional<Bounds> bounds) {
+		this->displacedBounds = std::move(bounds);
+	}
+
+	/// Get the number of vertices, also after they were released
+	[[nodiscard]] size_t getVertexCount() const {
+		const size_t count = this->getVertices().size();
+		return count > 0 ? count : this->releasedVertexCount;
+	}
+
+	/// Choose where the geometry lives after upload
+	/// GpuOnly meshes drop their host copies as soon as their buffers are up to date,
+	/// which may be right away. Geometry shared with other meshes is kept once for all
+	/// of them, since meshes created later start from it.
+	/// @param residency The policy
+	/// @param keepPositions Keep a compact copy of the positions for picking and tools
+	void setResidency(GeometryResidency residency, bool keepPositions = false) {
+		this->residency = residency;
+		this->keepPositions = keepPositions;
+		this->applyResidency();
+	}
+
+	/// Get the residency policy
+	[[nodiscard]] GeometryResidency getResidency() const { return this->residency; }
+
+	/// Release the host copies of a GpuOnly mesh whose buffers are up to date
+	/// Called by the MeshManager after each upload, does nothing otherwise
+	void applyResidency() {
+		if (this->residency != GeometryResidency::GpuOnly
+			|| this->sharedGeometry
+			|| this->buffersDirty
+			|| !this->vertexBuffer
+			|| this->vertices.empty()) {
+			return;
+		}
+
+		this->releasedBounds = this->getBounds();
+		this->releasedVertexCount = this->vertices.size();
+		if (this->keepPositions) {
+			const auto positions = this->getPositionView();
+			this->retainedPositions.assign(positions.begin(), positions.end());
+		} else {
+			this->retainedPositions = {};
+		}
+
+		/// Assigning empty vectors frees the storage, clear() would keep the capacity
+		this->vertices = {};
+		this->indices = {};
+		this->quantizedVertices = {};
+	}
+
+	/// Get the host memory the mesh's own geometry occupies
+	/// Geometry shared with other meshes is not included, it belongs to all of them
+	/// @return Bytes of vertices, indices and kept positions
+	[[nodiscard]] size_t getHostMemoryUsage() const {
+		return this->vertices.capacity() * sizeof(Vertex)
+			+ this->quantizedVertices.capacity() * sizeof(QuantizedVertex)
+			+ this->indices.capacity() * sizeof(uint32_t)
+			+ this->retainedPositions.capacity() * sizeof(glm::vec3);
+	}
+
+	/// Draw from geometry shared with other meshes instead of the mesh's own
+	/// The mesh's own data is released, the shared buffers are used as they are
+	/// @param geometry Geometry with its buffers already created
+	void setSharedGeometry(std::shared_ptr<const SharedGeometry> geometry) {
+		this->sharedGeometry = std::move(geometry);
+		this->vertexBuffer = this->sharedGeometry->vertexBuffer;
+		this->indexBuffer = this->sharedGeometry->indexBuffer;
+		this->vertices = {};
+		this->indices = {};
+		this->clearBuffersDirty();
+	}
+
+	/// Hand the mesh's own geometry and buffers over to a SharedGeometry
+	/// The mesh itself draws from the result afterwards, like any other mesh sharing it
+	/// @return The geometry, for other meshes to share
+	[[nodiscard]] std::shared_ptr<const SharedGeometry> shareGeometry() {
+		auto geometry = std::make_shared<SharedGeometry>();
+		geometry->vertices = std::move(this->vertices);
+		geometry->indices = std::move(this->indices);
+		geometry->vertexBuffer = this->vertexBuffer;
+		geometry->indexBuffer = this->indexBuffer;
+		this->setSharedGeometry(geometry);
+		return geometry;
+	}
+
+	/// Get the geometry this mesh shares with others
+	/// @return The shared geometry, or nullptr if the mesh has its own
+	[[nodiscard]] std::shared_ptr<const SharedGeometry> getSharedGeometry() const {
+		return this->sharedGeometry;
+	}
 
 	/// Set the mesh's GPU buffers
 	/// This is called by MeshManager after creating the buffers
@@ -78,12 +291,6 @@ public:
 		this->indexBuffer = std::move(iBuffer);
 	}
 
-	/// Set the translation of the mesh
-	void setTranslation(const glm::vec3& translation) {
-		this->translation = translation;
-		this->generateGeometry();
-	}
-
 	/// Set the material for this mesh
 	/// The material defines how the mesh is rendered
 	/// @param material Shared pointer to the material to use
@@ -99,21 +306,75 @@ public:
 
 	/// Mark mesh buffers as needing update
 	/// This signals to the rendering system that GPU buffers need to be rebuilt
+	/// Use it when the vertex or index count changes, otherwise the dirty ranges are cheaper
 	void markBuffersDirty() {
 		this->buffersDirty = true;
+		this->fullBufferUpdate = true;
+		this->dirtyVertexRanges.clear();
+		this->dirtyIndexRanges.clear();
 		spdlog::trace("Marked buffers dirty for mesh");
 	}
 
+	/// Mark a range of vertices as changed, the count stays the same
+	/// Only changed ranges are uploaded, into the existing buffers
+	/// @param first Index of the first changed vertex
+	/// @param count Number of changed vertices
+	void markVerticesDirty(uint32_t first, uint32_t count) {
+		this->buffersDirty = true;
+		if (!this->fullBufferUpdate) {
+			addDirtyRange(this->dirtyVertexRanges, first, count);
+		}
+	}
+
+	/// Mark a range of indices as changed, the count stays the same
+	/// @param first Position of the first changed index
+	/// @param count Number of changed indices
+	void markIndicesDirty(uint32_t first, uint32_t count) {
+		this->buffersDirty = true;
+		if (!this->fullBufferUpdate) {
+			addDirtyRange(this->dirtyIndexRanges, first, count);
+		}
+	}
+
 	/// Check if buffers need updating
 	/// @return true if buffers need to be rebuilt
 	[[nodiscard]] bool needsBufferUpdate() const {
 		return this->buffersDirty;
 	}
 
+	/// Check if the buffers must be rebuilt instead of updated in ranges
+	/// @return true if markBuffersDirty was called since the last update
+	[[nodiscard]] bool needsFullBufferUpdate() const {
+		return this->fullBufferUpdate;
+	}
+
+	/// Get the changed vertex ranges, sorted and without overlaps
+	[[nodiscard]] const std::vector<DirtyRange>& getDirtyVertexRanges() const {
+		return this->dirtyVertexRanges;
+	}
+
+	/// Get the changed index ranges, sorted and without overlaps
+	[[nodiscard]] const std::vector<DirtyRange>& getDirtyIndexRanges() const {
+		return this->dirtyIndexRanges;
+	}
+
+	/// Get the vertex buffer the mesh currently draws from
+	[[nodiscard]] std::shared_ptr<vulkan::VertexBuffer> getVertexBuffer() const {
+		return this->vertexBuffer;
+	}
+
+	/// Get the index buffer the mesh currently draws from
+	[[nodiscard]] std::shared_ptr<vulkan::IndexBuffer> getIndexBuffer() const {
+		return this->indexBuffer;
+	}
+
 	/// Reset dirty flag after buffer update
 	/// Called by buffer management system after update is complete
 	void clearBuffersDirty() {
 		this->buffersDirty = false;
+		this->fullBufferUpdate = false;
+		this->dirtyVertexRanges.clear();
+		this->dirtyIndexRanges.clear();
 		spdlog::trace("Cleared buffers dirty flag for mesh");
 	}
 
@@ -127,7 +388,9 @@ public:
 		this->textureTilingV = vTiling;
 
 		/// Regenerate geometry with new UV scaling
+		/// Tiling is specific to this mesh, so it stops sharing geometry with others
 		if (this->textureTilingU > 0.0f && this->textureTilingV > 0.0f) {
+			this->detachSharedGeometry();
 			this->markBuffersDirty();
 			this->generateGeometry();
 		}
@@ -142,6 +405,48 @@ public:
 	[[nodiscard]] float getTextureTilingV() const { return this->textureTilingV; }
 
 protected:
+	/// Copy shared geometry into the mesh's own data before changing it
+	/// Other meshes keep the shared geometry. The shared buffers stay in use until
+	/// the mesh's own buffers are created from the dirty data
+	void detachSharedGeometry() {
+		if (!this->sharedGeometry) {
+			return;
+		}
+		this->vertices = this->sharedGeometry->vertices;
+		this->indices = this->sharedGeometry->indices;
+		this->sharedGeometry.reset();
+		this->markBuffersDirty();
+	}
+
+	/// Add a range to a sorted list of ranges, merging it with those it overlaps or touches
+	static void addDirtyRange(std::vector<DirtyRange>& ranges, uint32_t first, uint32_t count) {
+		if (count == 0) {
+			return;
+		}
+
+		uint32_t begin = first;
+		uint32_t end = first + count;
+
+		/// First range that ends at or after the new one begins
+		auto it = std::lower_bound(ranges.begin(), ranges.end(), begin,
+			[](const DirtyRange& range, uint32_t value) { return range.first + range.count < value; });
+		auto last = it;
+		while (last != ranges.end() && last->first <= end) {
+			begin = std::min(begin, last->first);
+			end = std::max(end, last->first + last->count);
+			++last;
+		}
+		it = ranges.erase(it, last);
+		ranges.insert(it, DirtyRange{begin, end - begin});
+
+		/// Too scattered, one copy over all of them is cheaper than many small ones
+		if (ranges.size() > MaxDirtyRanges) {
+			const uint32_t spanBegin = ranges.front().first;
+			const uint32_t spanEnd = ranges.back().first + ranges.back().count;
+			ranges.assign(1, DirtyRange{spanBegin, spanEnd - spanBegin});
+		}
+	}
+
 	/// Apply texture tiling to a UV coordinate
 	/// This helper method ensures consistent tiling across mesh implementations
 	/// @param uv The original UV coordinate to scale
@@ -156,8 +461,24 @@ protected:
 	/// Index data stored in CPU memory
 	std::vector<uint32_t> indices;
 
-	/// Translation vector for positioning the mesh
-	glm::vec3 translation{0.0f};
+	/// Geometry shared with other meshes, replaces vertices and indices when set
+	std::shared_ptr<const SharedGeometry> sharedGeometry;
+
+	/// Compact vertices the GPU draws from, for meshes imported with quantized attributes
+	/// Shared geometry is always standard, procedural meshes don't quantize
+	VertexFormat vertexFormat{VertexFormat::Standard};
+	std::vector<QuantizedVertex> quantizedVertices;
+	VertexDequantization dequantization;
+
+	/// Residency policy and what a GpuOnly mesh keeps after releasing its vertices
+	GeometryResidency residency{GeometryResidency::CpuRetained};
+	bool keepPositions{false};
+	std::vector<glm::vec3> retainedPositions;
+	std::optional<Bounds> releasedBounds;
+	size_t releasedVertexCount{0};
+
+	/// Replaces the bounds of the vertices while set
+	std::optional<Bounds> displacedBounds;
 
 	/// GPU buffers
 	std::shared_ptr<vulkan::VertexBuffer> vertexBuffer;
@@ -167,6 +488,13 @@ protected:
 	/// Set when vertex data changes, cleared after buffer rebuild
 	bool buffersDirty{false};
 
+	/// Set by markBuffersDirty, the buffers are replaced instead of updated in ranges
+	bool fullBufferUpdate{false};
+
+	/// Changed ranges since the last update, used unless fullBufferUpdate is set
+	std::vector<DirtyRange> dirtyVertexRanges;
+	std::vector<DirtyRange> dirtyIndexRanges;
+
 	/// We use a shared_ptr to share materials between meshes and ensure proper lifecycle management
 	std::shared_ptr<Material> material;
 
@@ -177,4 +505,18 @@ protected:
 	float textureTilingV{1.0f};
 };
 
+/// A mesh that may cast shadows, collected separately from the visible draw packets
+/// Casters outside the view can still throw shadows into it, so they are culled
+/// against the volume the light sweeps through the view instead of the camera frustum
+struct ShadowCaster {
+	Mesh::RenderData data;
+
+	/// World space bounds of the mesh, used to cull casters per cascade
+	glm::vec3 boundsMin{0.0f};
+	glm::vec3 boundsMax{0.0f};
+
+	/// Static casters are cached in the far shadow cascades
+	bool isStatic{false};
+};
+
 } /// namespace lillugsi::rendering
\ No newline at end of file
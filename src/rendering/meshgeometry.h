@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vertex.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lillugsi::vulkan {
+class VertexBuffer;
+class IndexBuffer;
+}
+
+namespace lillugsi::rendering {
+
+/// Kinds of geometry that are generated from a few parameters
+enum class ProceduralGeometryType : uint32_t {
+	Cube,
+	Icosphere
+};
+
+/// Where a mesh keeps its geometry once it has been uploaded
+enum class GeometryResidency : uint32_t {
+	CpuRetained,  /// Vertices and indices stay in host memory, so the mesh can be edited
+	GpuOnly       /// Host copies are dropped after upload, bounds and optionally positions stay
+};
+
+/// Everything procedural geometry is generated from
+/// Two meshes with the same key have identical vertices and indices,
+/// so they can draw from the same buffers
+struct GeometryKey {
+	ProceduralGeometryType type;
+	uint32_t subdivisions{0};  /// Detail level, 0 for shapes without one
+	float size{1.0f};          /// Radius or side length
+
+	bool operator==(const GeometryKey& other) const {
+		return this->type == other.type
+			&& this->subdivisions == other.subdivisions
+			&& this->size == other.size;
+	}
+};
+
+struct GeometryKeyHash {
+	size_t operator()(const GeometryKey& key) const {
+		size_t hash = std::hash<uint32_t>()(static_cast<uint32_t>(key.type));
+		hash ^= std::hash<uint32_t>()(key.subdivisions) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash<float>()(key.size) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+};
+
+/// Immutable geometry and its GPU buffers, shared by any number of meshes
+/// Meshes only hold a reference, so the geometry lives as long as the last mesh using it
+struct SharedGeometry {
+	std::vector<Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::shared_ptr<vulkan::VertexBuffer> vertexBuffer;
+	std::shared_ptr<vulkan::IndexBuffer> indexBuffer;
+};
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,101 @@
+#include "meshinstances.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace lillugsi::rendering {
+
+namespace {
+
+/// Spread the lower 10 bits of a value to every third bit
+uint32_t spreadBits(uint32_t value) {
+	value &= 0x3ff;
+	value = (value | (value << 16)) & 0x030000ff;
+	value = (value | (value << 8)) & 0x0300f00f;
+	value = (value | (value << 4)) & 0x030c30c3;
+	value = (value | (value << 2)) & 0x09249249;
+	return value;
+}
+
+/// Morton code of a point in the unit cube, 10 bits per axis
+uint32_t mortonCode(const glm::vec3& point) {
+	const glm::uvec3 cell = glm::uvec3(glm::clamp(point, 0.0f, 1.0f) * 1023.0f);
+	return spreadBits(cell.x) | (spreadBits(cell.y) << 1) | (spreadBits(cell.z) << 2);
+}
+
+} /// namespace
+
+MeshInstances::MeshInstances(const std::vector<glm::mat4>& transforms, const scene::BoundingBox& meshBounds)
+	: count(static_cast<uint32_t>(transforms.size())) {
+	if (transforms.empty()) {
+		return;
+	}
+
+	/// Sort along a Morton curve of the instance positions
+	/// Instances close in the buffer are close in space, so clusters stay compact
+	scene::BoundingBox positionBounds;
+	for (const auto& transform : transforms) {
+		positionBounds.addPoint(glm::vec3(transform[3]));
+	}
+	const glm::vec3 extent = glm::max(positionBounds.getSize(), glm::vec3(1e-6f));
+
+	std::vector<std::pair<uint32_t, uint32_t>> order(transforms.size());
+	for (uint32_t i = 0; i < this->count; ++i) {
+		const glm::vec3 position = (glm::vec3(transforms[i][3]) - positionBounds.getMin()) / extent;
+		order[i] = {mortonCode(position), i};
+	}
+	std::sort(order.begin(), order.end());
+
+	/// Without mesh bounds, instances are bounded by their positions alone
+	const scene::BoundingBox instanceMeshBounds = meshBounds.isValid()
+		? meshBounds
+		: scene::BoundingBox(glm::vec3(0.0f), glm::vec3(0.0f));
+
+	this->instanceData.resize(this->count);
+	this->clusters.reserve((this->count + ClusterSize - 1) / ClusterSize);
+	for (uint32_t i = 0; i < this->count; ++i) {
+		const glm::mat4& transform = transforms[order[i].second];
+		this->instanceData[i] = InstanceTransform::fromMatrix(transform);
+
+		if (i % ClusterSize == 0) {
+			this->clusters.push_back(Cluster{i, 0, {}});
+		}
+		auto& cluster = this->clusters.back();
+		const scene::BoundingBox instanceBounds = instanceMeshBounds.transform(transform);
+		cluster.bounds.addPoint(instanceBounds.getMin());
+		cluster.bounds.addPoint(instanceBounds.getMax());
+		cluster.count++;
+	}
+
+	for (const auto& cluster : this->clusters) {
+		this->bounds.addPoint(cluster.bounds.getMin());
+		this->bounds.addPoint(cluster.bounds.getMax());
+	}
+
+	spdlog::debug("Created {} mesh instances in {} clusters", this->count, this->clusters.size());
+}
+
+void MeshInstances::cull(const scene::Frustum& frustum,
+	const glm::mat4& nodeTransform,
+	std::vector<Range>& outRanges) const {
+	/// Visible clusters directly after the previous one extend its range
+	bool extending = false;
+	for (const auto& cluster : this->clusters) {
+		const scene::BoundingBox worldBounds = cluster.bounds.transform(nodeTransform);
+		if (!frustum.intersectsBox(worldBounds)) {
+			extending = false;
+			continue;
+		}
+
+		if (extending) {
+			auto& range = outRanges.back();
+			range.count += cluster.count;
+			range.bounds.addPoint(worldBounds.getMin());
+			range.bounds.addPoint(worldBounds.getMax());
+		} else {
+			outRanges.push_back(Range{cluster.first, cluster.count, worldBounds});
+			extending = true;
+		}
+	}
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "vertex.h"
+#include "vulkan/buffer.h"
+#include "scene/boundingbox.h"
+#include "scene/frustum.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// MeshInstances places many copies of a mesh with one instanced draw
+/// Forests, rocks and props repeat a few meshes thousands of times. A scene node per
+/// copy would cost a draw, a transform update and a bounds test each, so a node
+/// instead carries the transforms of all its copies:
+/// - The transforms live in a device local instance buffer, uploaded once.
+/// - Instances are sorted along a Morton curve and grouped into clusters of
+///   ClusterSize. A cluster's bounds enclose the mesh bounds of its instances, so
+///   nearby instances share one frustum test.
+/// - Visible clusters next to each other in the buffer merge into one range, and
+///   each range is drawn with a single instanced draw.
+///
+/// Instances are immutable: the buffer and clusters are built from the transforms
+/// once, which keeps culling a linear pass over a few hundred clusters.
+class MeshInstances {
+public:
+	/// Instances per cluster
+	/// Large enough to keep the number of clusters to test low, small enough that
+	/// a cluster doesn't reach across half the model
+	static constexpr uint32_t ClusterSize = 64;
+
+	/// A run of instances drawn together
+	struct Range {
+		uint32_t first;             /// Index of the first instance in the buffer
+		uint32_t count;             /// Number of instances
+		scene::BoundingBox bounds;  /// World space bounds of the instances' meshes
+	};
+
+	/// Sort and cluster the instances
+	/// @param transforms Transform of each instance, relative to the node drawing them
+	/// @param meshBounds Local bounds of the mesh the instances place
+	MeshInstances(const std::vector<glm::mat4>& transforms, const scene::BoundingBox& meshBounds);
+
+	/// Set the buffer the instances are drawn from
+	/// @param buffer Instance buffer holding getInstanceData, created by the MeshManager
+	void setBuffer(std::shared_ptr<vulkan::Buffer> buffer) { this->buffer = std::move(buffer); }
+
+	/// Get the per-instance attributes in buffer order
+	/// Released with releaseInstanceData once they are uploaded
+	[[nodiscard]] const std::vector<InstanceTransform>& getInstanceData() const { return this->instanceData; }
+
+	/// Free the host copy of the instance attributes
+	void releaseInstanceData() { this->instanceData = {}; }
+
+	/// Get the instance buffer
+	[[nodiscard]] const std::shared_ptr<vulkan::Buffer>& getBuffer() const { return this->buffer; }
+
+	/// Get the number of instances
+	[[nodiscard]] uint32_t getCount() const { return this->count; }
+
+	/// Get the bounds of all instances together
+	/// @return Bounds in the space of the node drawing the instances
+	[[nodiscard]] const scene::BoundingBox& getBounds() const { return this->bounds; }
+
+	/// Collect the instances that can be seen
+	/// @param frustum Volume to test the clusters against, in world space
+	/// @param nodeTransform World transform of the node drawing the instances
+	/// @param outRanges Ranges of visible instances, appended to
+	void cull(const scene::Frustum& frustum,
+		const glm::mat4& nodeTransform,
+		std::vector<Range>& outRanges) const;
+
+private:
+	struct Cluster {
+		uint32_t first;
+		uint32_t count;
+		scene::BoundingBox bounds;  /// Local bounds of the instances' meshes
+	};
+
+	/// Instance attributes in Morton order, until they are uploaded
+	std::vector<InstanceTransform> instanceData;
+
+	std::vector<Cluster> clusters;
+	scene::BoundingBox bounds;
+	uint32_t count{0};
+
+	std::shared_ptr<vulkan::Buffer> buffer;
+};
+
+} /// namespace lillugsi::rendering
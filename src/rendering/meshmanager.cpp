@@ -18,6 +18,9 @@ MeshManager::MeshManager(
 	, physicalDevice(physicalDevice)
 	, graphicsQueue(graphicsQueue)
 	, bufferManager(std::move(bufferManager)) {
+	this->stagingRing = std::make_unique<StagingRing>(this->bufferManager);
+	this->stagingRing->initialize(StagingSegmentSize);
+	this->animationSystem = std::make_unique<animation::AnimationSystem>();
 	spdlog::info("MeshManager created");
 }
 
@@ -26,6 +29,15 @@ MeshManager::~MeshManager() {
 }
 
 void MeshManager::cleanup() {
+	if (this->stagingRing) {
+		this->stagingRing->cleanup();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->geometryCacheMutex);
+		this->geometryCache.clear();
+	}
+
 	/// We don't own the buffer manager, so no need to clean it up here
 	spdlog::info("MeshManager cleanup completed");
 }
@@ -33,7 +45,18 @@ void MeshManager::cleanup() {
 template<typename T, typename... Args>
 std::shared_ptr<Mesh> MeshManager::createMesh(Args &&...args) {
 	/// Create the mesh instance with provided parameters
-	auto mesh = std::make_unique<T>(std::forward<Args>(args)...);
+	auto mesh = std::make_shared<T>(std::forward<Args>(args)...);
+
+	/// Reuse geometry another mesh with the same parameters already generated
+	const std::optional<GeometryKey> key = mesh->getGeometryKey();
+	if (key) {
+		std::lock_guard<std::mutex> lock(this->geometryCacheMutex);
+		if (auto geometry = this->findSharedGeometry(*key)) {
+			mesh->setSharedGeometry(std::move(geometry));
+			spdlog::debug("Reusing shared geometry with {} vertices", mesh->getVertices().size());
+			return mesh;
+		}
+	}
 
 	/// Generate geometry and verify we have data
 	mesh->generateGeometry();
@@ -57,13 +80,21 @@ std::shared_ptr<Mesh> MeshManager::createMesh(Args &&...args) {
 		auto indexBuffer = this->bufferManager->createIndexBuffer(mesh->getIndices());
 
 		/// Assign buffers to the mesh
+		/// The buffers match the freshly generated data, so nothing is left to update
 		mesh->setBuffers(std::move(vertexBuffer), std::move(indexBuffer));
+		mesh->clearBuffersDirty();
 
 		spdlog::info(
 			"Successfully created mesh with {} vertices and {} indices",
 			mesh->getVertices().size(),
 			mesh->getIndices().size());
 
+		/// Offer the geometry to later meshes with the same parameters
+		if (key) {
+			std::lock_guard<std::mutex> lock(this->geometryCacheMutex);
+			this->geometryCache[*key] = mesh->shareGeometry();
+		}
+
 		return mesh;
 	} catch (const vulkan::VulkanException &e) {
 		spdlog::error("Failed to create mesh buffers: {}", e.what());
@@ -73,27 +104,35 @@ std::shared_ptr<Mesh> MeshManager::createMesh(Args &&...args) {
 
 template<typename T>
 [[nodiscard]] std::shared_ptr<Mesh> MeshManager::createMeshWithGeometry(
-	const std::vector<Vertex>& vertices,
-	const std::vector<uint32_t>& indices)
+	std::vector<Vertex> vertices,
+	std::vector<uint32_t> indices,
+	std::vector<QuantizedVertex> quantizedVertices,
+	const VertexDequantization& dequantization)
 {
 	/// Create the mesh instance using default constructor
 	auto mesh = std::make_shared<T>();
 
-	/// Cast to ModelMesh and set the geometry data directly
+	/// Cast to ModelMesh and hand the geometry over, the vectors are moved, not copied
 	auto modelMesh = std::static_pointer_cast<T>(mesh);
-	modelMesh->setGeometryData(vertices, indices);
+	modelMesh->setGeometryData(std::move(vertices), std::move(indices));
+	if (!quantizedVertices.empty()) {
+		modelMesh->setQuantizedVertices(std::move(quantizedVertices), dequantization);
+	}
 
 	try {
-		/// Create GPU buffers using BufferManager
-		auto vertexBuffer = this->bufferManager->createVertexBuffer(vertices);
-		auto indexBuffer = this->bufferManager->createIndexBuffer(indices);
+		/// Create GPU buffers from the mesh's own copy of the data, which is the only one
+		auto vertexBuffer = this->createVertexBuffer(*mesh);
+		auto indexBuffer = this->bufferManager->createIndexBuffer(mesh->getIndices());
 
 		/// Assign buffers to the mesh
+		/// The buffers match the data just set, so nothing is left to update
 		mesh->setBuffers(std::move(vertexBuffer), std::move(indexBuffer));
+		mesh->clearBuffersDirty();
 
 		spdlog::info(
-			"Successfully created mesh with {} vertices and {} indices",
-			vertices.size(), indices.size());
+			"Successfully created {}mesh with {} vertices and {} indices",
+			mesh->getVertexFormat() == VertexFormat::Quantized ? "quantized " : "",
+			mesh->getVertices().size(), mesh->getIndices().size());
 
 		return mesh;
 	} catch (const vulkan::VulkanException& e) {
@@ -102,6 +141,100 @@ template<typename T>
 	}
 }
 
+std::shared_ptr<const SharedGeometry> MeshManager::findSharedGeometry(const GeometryKey& key) {
+	auto it = this->geometryCache.find(key);
+	if (it == this->geometryCache.end()) {
+		return nullptr;
+	}
+
+	auto geometry = it->second.lock();
+	if (!geometry) {
+		/// The last mesh using it is gone, drop the stale entry
+		this->geometryCache.erase(it);
+	}
+	return geometry;
+}
+
+std::shared_ptr<MeshInstances> MeshManager::createInstances(
+	const std::vector<glm::mat4> &transforms, const scene::BoundingBox &meshBounds) {
+	auto instances = std::make_shared<MeshInstances>(transforms, meshBounds);
+	if (instances->getCount() == 0) {
+		return instances;
+	}
+
+	const auto& data = instances->getInstanceData();
+	instances->setBuffer(this->bufferManager->createInstanceBuffer(
+		data.size() * sizeof(InstanceTransform), data.data()));
+	instances->releaseInstanceData();
+
+	spdlog::info("Created {} mesh instances", instances->getCount());
+	return instances;
+}
+
+std::shared_ptr<SkinGeometry> MeshManager::createSkinGeometry(
+	const std::vector<Vertex> &vertices,
+	const std::vector<SkinInfluence> &influences,
+	const std::vector<uint32_t> &indices,
+	uint32_t jointCount) {
+	if (vertices.empty() || influences.size() != vertices.size() || indices.empty()) {
+		throw vulkan::VulkanException(
+			VK_ERROR_INITIALIZATION_FAILED,
+			"Skinned geometry needs vertices, one influence per vertex and indices",
+			__FUNCTION__, __FILE__, __LINE__
+		);
+	}
+
+	auto geometry = std::make_shared<SkinGeometry>();
+	geometry->restBuffer = this->bufferManager->createStorageVertexBuffer(vertices);
+	geometry->influenceBuffer = this->bufferManager->createDeviceStorageBuffer(
+		influences.size() * sizeof(SkinInfluence), influences.data());
+	geometry->indexBuffer = this->bufferManager->createIndexBuffer(indices);
+	geometry->vertexCount = static_cast<uint32_t>(vertices.size());
+
+	/// Bounds of the vertices each joint moves, for the animated bounds of the meshes
+	geometry->restBounds = Mesh::Bounds{vertices.front().position, vertices.front().position};
+	geometry->jointBounds.resize(jointCount);
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const glm::vec3& position = vertices[i].position;
+		geometry->restBounds.min = glm::min(geometry->restBounds.min, position);
+		geometry->restBounds.max = glm::max(geometry->restBounds.max, position);
+
+		const SkinInfluence& influence = influences[i];
+		for (uint32_t slot = 0; slot < 4; ++slot) {
+			const uint32_t joint = (influence.joints[slot / 2] >> (16 * (slot % 2))) & 0xffff;
+			const uint32_t weight = (influence.weights[slot / 2] >> (16 * (slot % 2))) & 0xffff;
+			if (weight > 0 && joint < jointCount) {
+				geometry->jointBounds[joint].addPoint(position);
+			}
+		}
+	}
+
+	spdlog::debug("Created skinned geometry with {} vertices and {} joints", vertices.size(), jointCount);
+	return geometry;
+}
+
+std::shared_ptr<SkinnedMesh> MeshManager::createSkinnedMesh(
+	std::shared_ptr<const SkinGeometry> geometry,
+	std::shared_ptr<animation::Animator> animator,
+	const std::optional<Mesh::Bounds>& animatedBounds) {
+	auto mesh = std::make_shared<SkinnedMesh>(geometry, animator);
+	if (!animator) {
+		mesh->setBuffers(geometry->restBuffer, geometry->indexBuffer);
+		return mesh;
+	}
+
+	/// Each character's animated vertices go into a buffer of its own. It starts as a
+	/// copy of the rest pose, the skinning pass only rewrites positions and directions
+	mesh->setBuffers(this->bufferManager->createStorageVertexBuffer(*geometry->restBuffer), geometry->indexBuffer);
+	if (animatedBounds) {
+		mesh->setAnimatedBounds(scene::BoundingBox(animatedBounds->min, animatedBounds->max));
+	} else {
+		mesh->setAnimatedBounds(animator->computeBounds(geometry->jointBounds));
+	}
+	this->animationSystem->addMesh(mesh);
+	return mesh;
+}
+
 void MeshManager::updateBuffers(const std::shared_ptr<Mesh> &mesh) {
 	if (!mesh) {
 		throw vulkan::VulkanException(
@@ -113,7 +246,7 @@ void MeshManager::updateBuffers(const std::shared_ptr<Mesh> &mesh) {
 	}
 
 	/// Create and update buffers using BufferManager
-	auto vertexBuffer = this->bufferManager->createVertexBuffer(mesh->getVertices());
+	auto vertexBuffer = this->createVertexBuffer(*mesh);
 	auto indexBuffer = this->bufferManager->createIndexBuffer(mesh->getIndices());
 
 	/// Update mesh with new buffers
@@ -131,16 +264,97 @@ void MeshManager::updateBuffersIfNeeded(const std::shared_ptr<Mesh> &mesh) {
 		return;
 	}
 
+	/// A GpuOnly mesh that released its vertices has nothing left to upload
+	if (mesh->getVertices().empty()) {
+		spdlog::warn("Ignoring buffer update of a mesh without host geometry");
+		mesh->clearBuffersDirty();
+		return;
+	}
+
+	/// Edits that keep the size only upload what changed, into the buffers already in use
+	if (!mesh->needsFullBufferUpdate() && this->uploadDirtyRanges(*mesh)) {
+		mesh->clearBuffersDirty();
+		mesh->applyResidency();
+		return;
+	}
+
 	this->updateBuffers(mesh);
 
 	/// Clear dirty flag now that buffers are updated
 	mesh->clearBuffersDirty();
+	mesh->applyResidency();
+}
+
+std::shared_ptr<vulkan::VertexBuffer> MeshManager::createVertexBuffer(const Mesh& mesh) {
+	if (mesh.getVertexFormat() == VertexFormat::Quantized) {
+		return this->bufferManager->createVertexBuffer(mesh.getQuantizedVertices());
+	}
+	return this->bufferManager->createVertexBuffer(mesh.getVertices());
+}
+
+bool MeshManager::uploadDirtyRanges(const Mesh& mesh) {
+	const auto vertexBuffer = mesh.getVertexBuffer();
+	const auto indexBuffer = mesh.getIndexBuffer();
+	if (!this->stagingRing || !vertexBuffer || !indexBuffer) {
+		return false;
+	}
+
+	/// Dirty ranges refer to the float vertices, quantized buffers are recreated whole
+	if (mesh.getVertexFormat() == VertexFormat::Quantized) {
+		return false;
+	}
+
+	const auto& vertices = mesh.getVertices();
+	const auto& indices = mesh.getIndices();
+	const auto& vertexRanges = mesh.getDirtyVertexRanges();
+	const auto& indexRanges = mesh.getDirtyIndexRanges();
+
+	/// Ranges outside the data or the buffers mean the size changed after all
+	for (const auto& range : vertexRanges) {
+		if (range.first + range.count > vertices.size()
+			|| (range.first + range.count) * sizeof(Vertex) > vertexBuffer->getSize()) {
+			return false;
+		}
+	}
+	for (const auto& range : indexRanges) {
+		if (range.first + range.count > indices.size()
+			|| (range.first + range.count) * sizeof(uint32_t) > indexBuffer->getSize()) {
+			return false;
+		}
+	}
+
+	/// If the ring fills up halfway, the copies already queued are harmless:
+	/// the fallback replaces the buffers they write to
+	for (const auto& range : vertexRanges) {
+		if (!this->stagingRing->enqueue(vertexBuffer,
+				range.first * sizeof(Vertex),
+				vertices.data() + range.first,
+				range.count * sizeof(Vertex))) {
+			return false;
+		}
+	}
+	for (const auto& range : indexRanges) {
+		if (!this->stagingRing->enqueue(indexBuffer,
+				range.first * sizeof(uint32_t),
+				indices.data() + range.first,
+				range.count * sizeof(uint32_t))) {
+			return false;
+		}
+	}
+
+	spdlog::trace("Queued {} vertex and {} index ranges for in-place upload",
+		vertexRanges.size(), indexRanges.size());
+	return true;
+}
+
+void MeshManager::recordBufferUploads(VkCommandBuffer commandBuffer) {
+	this->stagingRing->record(commandBuffer);
 }
 
 /// Explicit template instantiations for known mesh types
 template std::shared_ptr<Mesh> MeshManager::createMesh<CubeMesh>();
 template std::shared_ptr<Mesh> MeshManager::createMesh<IcosphereMesh, float, int>(float &&, int &&);
 template std::shared_ptr<Mesh> MeshManager::createMeshWithGeometry<ModelMesh>(
-	const std::vector<Vertex>&, const std::vector<uint32_t>&);
+	std::vector<Vertex>, std::vector<uint32_t>, std::vector<QuantizedVertex>, const VertexDequantization&);
 
 } /// namespace lillugsi::rendering
\ No newline at end of file
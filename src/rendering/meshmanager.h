@@ -2,14 +2,26 @@
 
 #include "buffermanager.h"
 #include "mesh.h"
+#include "meshgeometry.h"
+#include "meshinstances.h"
+#include "skinnedmesh.h"
+#include "animation/animationsystem.h"
+#include "stagingring.h"
 #include "vulkan/buffer.h"
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 namespace lillugsi::rendering {
 
 class MeshManager {
 public:
+	/// Bytes of mesh changes that can be uploaded in place per frame
+	/// Larger changes replace the buffers instead
+	static constexpr VkDeviceSize StagingSegmentSize = 4 * 1024 * 1024;
+
 	/// Constructor taking Vulkan device references and BufferManager
 	/// @param device The logical device for buffer operations
 	/// @param physicalDevice The physical device for memory allocation
@@ -28,6 +40,9 @@ public:
 	void cleanup();
 
 	/// Create a mesh of the specified type with constructor parameters
+	/// Procedural meshes with a geometry key are generated and uploaded once per key.
+	/// Every further mesh with the same key is a lightweight reference to that geometry
+	/// with its own material, placed through the scene node it is attached to
 	/// @tparam T The type of mesh to create (must derive from Mesh)
 	/// @tparam Args Parameter pack for mesh constructor arguments
 	/// @param args Constructor arguments forwarded to mesh creation
@@ -44,24 +59,98 @@ public:
 	/// for model loaders that extract geometry from files rather than
 	/// generating it procedurally.
 	///
+	/// The geometry is taken by value and moved into the mesh, so callers that
+	/// std::move their vectors in hand over the allocation instead of copying it.
+	/// Together with the residency policy, a vertex is written once by the loader,
+	/// once into staging memory, and then freed.
+	///
+	/// Meshes imported with quantized attributes also pass their compact vertices,
+	/// the vertex buffer is created from those instead.
+	///
 	/// @tparam T The mesh class type to create
 	/// @param vertices Pre-defined vertex data for the mesh
 	/// @param indices Pre-defined index data for the mesh
+	/// @param quantizedVertices Compact vertices to draw from, empty for standard meshes
+	/// @param dequantization How the compact vertices map back to object space
 	/// @return A shared pointer to the created mesh
 	template<typename T>
 	[[nodiscard]] std::shared_ptr<Mesh> createMeshWithGeometry(
+		std::vector<Vertex> vertices,
+		std::vector<uint32_t> indices,
+		std::vector<QuantizedVertex> quantizedVertices = {},
+		const VertexDequantization& dequantization = {});
+
+	/// Create the instances of an instanced mesh
+	/// The transforms are uploaded into a device local instance buffer right away,
+	/// the instances keep no host copy of them
+	/// @param transforms Transform of each instance, relative to the node drawing them
+	/// @param meshBounds Local bounds of the mesh the instances place
+	/// @return The instances, ready to be set on scene nodes
+	[[nodiscard]] std::shared_ptr<MeshInstances> createInstances(
+		const std::vector<glm::mat4>& transforms,
+		const scene::BoundingBox& meshBounds);
+
+	/// Upload the rest pose of a skinned primitive
+	/// The geometry is shared by every character drawing the primitive, the host
+	/// copies can be released once this returns
+	/// @param vertices Rest pose vertices
+	/// @param influences Joints and weights of each vertex
+	/// @param indices Index data
+	/// @param jointCount Number of joints in the skin
+	/// @return The geometry, with all its buffers created
+	[[nodiscard]] std::shared_ptr<SkinGeometry> createSkinGeometry(
 		const std::vector<Vertex>& vertices,
-		const std::vector<uint32_t>& indices);
+		const std::vector<SkinInfluence>& influences,
+		const std::vector<uint32_t>& indices,
+		uint32_t jointCount);
+
+	/// Create a mesh drawing skinned geometry
+	/// Animated meshes get a vertex buffer of their own and are animated from now on,
+	/// until the last reference to them is released
+	/// @param geometry The rest pose geometry
+	/// @param animator Animator moving the mesh, nullptr to draw the rest pose
+	/// @param animatedBounds Bounds over every pose the animator plays, computed from it
+	///        if not given. Clones pass their source's, computing them samples every clip
+	/// @return The mesh
+	[[nodiscard]] std::shared_ptr<SkinnedMesh> createSkinnedMesh(
+		std::shared_ptr<const SkinGeometry> geometry,
+		std::shared_ptr<animation::Animator> animator,
+		const std::optional<Mesh::Bounds>& animatedBounds = std::nullopt);
+
+	/// Get the system animating skinned meshes
+	[[nodiscard]] animation::AnimationSystem& getAnimationSystem() { return *this->animationSystem; }
 
 	/// Update GPU buffers for a mesh
 	/// @param mesh The mesh whose buffers need updating
 	void updateBuffers(const std::shared_ptr<Mesh>& mesh);
 
 	/// Update GPU buffers for a mesh if needed
+	/// Dirty ranges are written into the existing buffers through the staging ring,
+	/// the buffers are only replaced if their size changes or the ring is full
 	/// @param mesh The mesh whose buffers might need updating
 	void updateBuffersIfNeeded(const std::shared_ptr<Mesh>& mesh);
 
+	/// Record the in-place buffer updates queued since the last frame
+	/// Must be recorded before anything in the frame reads mesh buffers
+	/// @param commandBuffer The command buffer being recorded
+	void recordBufferUploads(VkCommandBuffer commandBuffer);
+
 private:
+	/// Look up geometry that is still in use, called with the cache mutex held
+	/// @param key Parameters of the geometry
+	/// @return The geometry, or nullptr if no mesh uses it anymore
+	[[nodiscard]] std::shared_ptr<const SharedGeometry> findSharedGeometry(const GeometryKey& key);
+
+	/// Create the vertex buffer of a mesh in the mesh's vertex format
+	/// @param mesh The mesh with its geometry set
+	/// @return The vertex buffer
+	[[nodiscard]] std::shared_ptr<vulkan::VertexBuffer> createVertexBuffer(const Mesh& mesh);
+
+	/// Queue a mesh's dirty ranges for upload into its existing buffers
+	/// @param mesh The mesh with dirty ranges
+	/// @return False if the ranges can't be updated in place
+	[[nodiscard]] bool uploadDirtyRanges(const Mesh& mesh);
+
 	/// Vulkan device references
 	VkDevice device;
 	VkPhysicalDevice physicalDevice;
@@ -69,6 +158,18 @@ private:
 
 	/// Buffer manager for creating and updating buffers
 	std::shared_ptr<BufferManager> bufferManager;
+
+	/// Uploads dirty ranges into existing buffers
+	std::unique_ptr<StagingRing> stagingRing;
+
+	/// Animates the skinned meshes created here
+	std::unique_ptr<animation::AnimationSystem> animationSystem;
+
+	/// Procedural geometry by its generation parameters
+	/// We only keep weak references, the meshes own the geometry, so it is
+	/// released together with the last mesh using it
+	std::unordered_map<GeometryKey, std::weak_ptr<const SharedGeometry>, GeometryKeyHash> geometryCache;
+	std::mutex geometryCacheMutex;
 };
 
 } /// namespace lillugsi::rendering
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "assetmanifest.h"
+#include <spdlog/spdlog.h>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace lillugsi::rendering {
+
+namespace {
+/// Parse a texture format name
+/// @return True if the name is known
+bool parseTextureFormat(const std::string& name, TextureLoader::Format& format) {
+	if (name == "rgba") {
+		format = TextureLoader::Format::RGBA;
+	} else if (name == "rgb") {
+		format = TextureLoader::Format::RGB;
+	} else if (name == "r") {
+		format = TextureLoader::Format::R;
+	} else if (name == "normal") {
+		format = TextureLoader::Format::NormalMap;
+	} else if (name == "keep") {
+		format = TextureLoader::Format::Keep;
+	} else {
+		return false;
+	}
+	return true;
+}
+}
+
+std::optional<AssetManifest> AssetManifest::load(const std::string& filePath) {
+	std::ifstream file(filePath);
+	if (!file) {
+		spdlog::error("Failed to open asset manifest: {}", filePath);
+		return std::nullopt;
+	}
+
+	AssetManifest manifest;
+	Region level;
+	level.name = "level";
+	level.radius = std::numeric_limits<float>::infinity();
+	manifest.regions.push_back(std::move(level));
+
+	std::string line;
+	size_t lineNumber = 0;
+	while (std::getline(file, line)) {
+		++lineNumber;
+		const size_t comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+
+		std::istringstream tokens(line);
+		std::string keyword;
+		if (!(tokens >> keyword)) {
+			continue;
+		}
+
+		auto& region = manifest.regions.back();
+		bool valid = false;
+		if (keyword == "model") {
+			std::string path;
+			valid = static_cast<bool>(tokens >> path);
+			if (valid) {
+				region.models.push_back(std::move(path));
+			}
+		} else if (keyword == "texture") {
+			TextureEntry texture;
+			std::string formatName;
+			valid = static_cast<bool>(tokens >> texture.path);
+			if (valid && tokens >> formatName) {
+				valid = parseTextureFormat(formatName, texture.format);
+			}
+			if (valid) {
+				region.textures.push_back(std::move(texture));
+			}
+		} else if (keyword == "region") {
+			Region next;
+			valid = static_cast<bool>(tokens >> next.name >> next.center.x >> next.center.y
+				>> next.center.z >> next.radius) && next.radius >= 0.0f;
+			if (valid) {
+				manifest.regions.push_back(std::move(next));
+			}
+		}
+
+		if (!valid) {
+			spdlog::warn("Skipping invalid line {} of asset manifest {}", lineNumber, filePath);
+		}
+	}
+
+	size_t modelCount = 0;
+	size_t textureCount = 0;
+	for (const auto& region : manifest.regions) {
+		modelCount += region.models.size();
+		textureCount += region.textures.size();
+	}
+	spdlog::info("Loaded asset manifest {} with {} regions, {} models and {} textures",
+		filePath, manifest.regions.size() - 1, modelCount, textureCount);
+	return manifest;
+}
+
+} /// namespace lillugsi::rendering
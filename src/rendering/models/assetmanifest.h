@@ -0,0 +1,47 @@
+#pragma once
+
+#include "rendering/textureloader.h"
+#include <glm/glm.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// AssetManifest lists the models and textures a level needs, grouped by where the
+/// camera is when it needs them. It is what AssetPrefetcher loads ahead of use.
+///
+/// Manifests are plain text, one entry per line, '#' starts a comment:
+///   model <path>
+///   texture <path> [rgba|rgb|r|normal|keep]
+///   region <name> <x> <y> <z> <radius>
+/// Assets before the first region line belong to the whole level. Every other asset
+/// belongs to the region above it, a sphere in world space. Paths are written the way
+/// the code requesting the asset writes them and can't contain spaces
+struct AssetManifest {
+	/// A texture and the format it is loaded in
+	struct TextureEntry {
+		std::string path;
+		TextureLoader::Format format{TextureLoader::Format::RGBA};
+	};
+
+	/// Assets needed while the camera is in or near a sphere
+	struct Region {
+		std::string name;
+		glm::vec3 center{0.0f};
+		float radius{0.0f};
+		std::vector<std::string> models;
+		std::vector<TextureEntry> textures;
+	};
+
+	/// The level wide region comes first, with an infinite radius
+	std::vector<Region> regions;
+
+	/// Read a manifest file
+	/// Malformed lines are skipped with a warning, the rest of the file still counts
+	/// @param filePath Path to the manifest
+	/// @return The manifest, or nothing if the file can't be read
+	[[nodiscard]] static std::optional<AssetManifest> load(const std::string& filePath);
+};
+
+} /// namespace lillugsi::rendering
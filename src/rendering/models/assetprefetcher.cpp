@@ -0,0 +1,184 @@
+#include "assetprefetcher.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <limits>
+
+namespace lillugsi::rendering {
+
+AssetPrefetcher::AssetPrefetcher(ModelManager& modelManager, std::shared_ptr<TextureManager> textureManager)
+	: modelManager(modelManager)
+	, textureManager(std::move(textureManager)) {
+	this->worker = std::thread(&AssetPrefetcher::workerLoop, this);
+}
+
+AssetPrefetcher::~AssetPrefetcher() {
+	this->cleanup();
+}
+
+void AssetPrefetcher::cleanup() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+		this->pendingAssets.clear();
+	}
+	this->workAvailable.notify_all();
+	if (this->worker.joinable()) {
+		this->worker.join();
+	}
+}
+
+void AssetPrefetcher::addManifest(const AssetManifest& manifest) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+
+	for (const auto& manifestRegion : manifest.regions) {
+		Region region;
+		region.center = manifestRegion.center;
+		region.radius = manifestRegion.radius;
+		for (const auto& path : manifestRegion.models) {
+			region.assets.push_back(this->addAsset(true, path, TextureLoader::Format::RGBA));
+		}
+		for (const auto& texture : manifestRegion.textures) {
+			region.assets.push_back(this->addAsset(false, texture.path, texture.format));
+		}
+		this->regions.push_back(std::move(region));
+	}
+
+	spdlog::info("Asset prefetcher tracks {} assets in {} regions", this->assets.size(), this->regions.size());
+}
+
+void AssetPrefetcher::clear() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->assets.clear();
+	this->regions.clear();
+	this->pendingAssets.clear();
+
+	/// The asset being loaded has no index anymore, its result is simply dropped
+	this->loadingAsset = NoAsset;
+}
+
+void AssetPrefetcher::setLookahead(float distance) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->lookahead = std::max(0.0f, distance);
+}
+
+size_t AssetPrefetcher::addAsset(bool isModel, const std::string& path, TextureLoader::Format format) {
+	for (size_t i = 0; i < this->assets.size(); ++i) {
+		if (this->assets[i].isModel == isModel && this->assets[i].path == path) {
+			return i;
+		}
+	}
+
+	Asset asset;
+	asset.isModel = isModel;
+	asset.path = path;
+	asset.format = format;
+	this->assets.push_back(std::move(asset));
+	return this->assets.size() - 1;
+}
+
+void AssetPrefetcher::update(const glm::vec3& cameraPosition) {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (this->stopping) {
+			return;
+		}
+
+		for (auto& asset : this->assets) {
+			asset.distance = std::numeric_limits<float>::infinity();
+		}
+
+		/// The level wide region has an infinite radius and is always at distance 0
+		for (const auto& region : this->regions) {
+			const float distance = std::max(0.0f, glm::length(cameraPosition - region.center) - region.radius);
+			if (distance > this->lookahead) {
+				continue;
+			}
+			for (size_t index : region.assets) {
+				auto& asset = this->assets[index];
+				asset.distance = std::min(asset.distance, distance);
+			}
+		}
+
+		/// A linear pass over the assets is cheap next to loading one of them,
+		/// and rebuilding drops what went out of range before it was loaded
+		this->pendingAssets.clear();
+		for (size_t i = 0; i < this->assets.size(); ++i) {
+			auto& asset = this->assets[i];
+			if (asset.distance > this->lookahead) {
+				if (i != this->loadingAsset) {
+					asset.taken = false;
+				}
+				continue;
+			}
+			if (!asset.taken) {
+				this->pendingAssets.push_back(i);
+			}
+		}
+
+		if (this->pendingAssets.empty()) {
+			return;
+		}
+	}
+
+	this->workAvailable.notify_one();
+}
+
+size_t AssetPrefetcher::getPendingCount() const {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->pendingAssets.size();
+}
+
+size_t AssetPrefetcher::takeNextAsset() {
+	size_t best = 0;
+	for (size_t i = 1; i < this->pendingAssets.size(); ++i) {
+		if (this->assets[this->pendingAssets[i]].distance < this->assets[this->pendingAssets[best]].distance) {
+			best = i;
+		}
+	}
+
+	const size_t index = this->pendingAssets[best];
+	this->pendingAssets[best] = this->pendingAssets.back();
+	this->pendingAssets.pop_back();
+	return index;
+}
+
+void AssetPrefetcher::workerLoop() {
+	for (;;) {
+		Asset asset;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->loadingAsset = NoAsset;
+			this->workAvailable.wait(lock, [this]() {
+				return this->stopping || !this->pendingAssets.empty();
+			});
+			if (this->stopping) {
+				return;
+			}
+
+			this->loadingAsset = this->takeNextAsset();
+			this->assets[this->loadingAsset].taken = true;
+			asset = this->assets[this->loadingAsset];
+		}
+
+		try {
+			if (!this->loadAsset(asset)) {
+				spdlog::warn("Failed to prefetch {}: {}", asset.isModel ? "model" : "texture", asset.path);
+			}
+		} catch (const std::exception& e) {
+			spdlog::error("Failed to prefetch {}: {}", asset.path, e.what());
+		}
+	}
+}
+
+bool AssetPrefetcher::loadAsset(const Asset& asset) {
+	if (asset.isModel) {
+		return this->modelManager.prefetchModel(asset.path);
+	}
+
+	/// Loaded the way the renderer loads textures, with mipmaps.
+	/// Failed loads come back as the default texture and aren't cached under the path
+	const auto texture = this->textureManager->getOrLoadTexture(asset.path, true, asset.format);
+	return texture && this->textureManager->isTextureLoaded(asset.path);
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "assetmanifest.h"
+#include "modelmanager.h"
+#include "rendering/texturemanager.h"
+#include <glm/glm.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// AssetPrefetcher loads the assets of manifest regions before the camera gets there
+/// A model loaded on first request reads, decodes and uploads its file while the frame
+/// waits, which shows up as pop-in. We load what the manifests list for the camera's
+/// surroundings in the background instead, so the request finds it resident:
+/// - Level wide assets are loaded first, then those of regions within the lookahead
+///   distance, closest region first. The order is re-evaluated whenever the worker
+///   takes the next asset, so moving the camera changes what is loaded next.
+/// - A single worker loads one asset at a time, keeping prefetching to one core next
+///   to the update and render threads. Assets nobody asked for yet can wait.
+/// - Models are prefetched into the model cache as released models and textures into
+///   the texture manager's cache, loadModel and getOrLoadTexture then find them there.
+///   Prefetched models count towards the model cache budget like any released model.
+///
+/// An asset is loaded once while any of its regions stays in range. Once all of them
+/// are out of range it is checked again on the way back, in case it was evicted.
+class AssetPrefetcher {
+public:
+	/// Distance beyond a region's sphere at which its assets start loading
+	static constexpr float DefaultLookahead = 50.0f;
+
+	/// Constructor, starts the worker
+	/// @param modelManager Manager to prefetch models into, must outlive the prefetcher
+	/// @param textureManager Manager to prefetch textures into
+	AssetPrefetcher(ModelManager& modelManager, std::shared_ptr<TextureManager> textureManager);
+
+	/// Destructor, stops the worker
+	~AssetPrefetcher();
+
+	/// Stop the worker
+	/// The asset being loaded is finished first
+	void cleanup();
+
+	/// Add the assets of a manifest
+	/// Assets listed in several regions or manifests are loaded once
+	/// @param manifest The manifest to add
+	void addManifest(const AssetManifest& manifest);
+
+	/// Drop all manifests and the assets not loaded yet
+	/// Loaded assets stay in their caches
+	void clear();
+
+	/// Set how far ahead of a region its assets are loaded
+	/// @param distance Distance to the region's sphere in world units
+	void setLookahead(float distance);
+
+	/// Queue the assets needed around the camera
+	/// @param cameraPosition Camera position in world space
+	void update(const glm::vec3& cameraPosition);
+
+	/// Get the number of assets in range that aren't loaded yet
+	[[nodiscard]] size_t getPendingCount() const;
+
+private:
+	/// A model or texture listed in any manifest
+	struct Asset {
+		bool isModel{true};
+		std::string path;
+		TextureLoader::Format format{TextureLoader::Format::RGBA};
+
+		/// Distance to the closest region listing it, updated by update
+		float distance{0.0f};
+
+		/// Set once the worker took it, cleared when it goes out of range
+		bool taken{false};
+	};
+
+	/// A manifest region, referring to its assets by index
+	struct Region {
+		glm::vec3 center{0.0f};
+		float radius{0.0f};
+		std::vector<size_t> assets;
+	};
+
+	/// Find or add an asset, called with the mutex held
+	[[nodiscard]] size_t addAsset(bool isModel, const std::string& path, TextureLoader::Format format);
+
+	void workerLoop();
+
+	/// Take the pending asset closest to the camera, called with the mutex held
+	[[nodiscard]] size_t takeNextAsset();
+
+	/// Load an asset into its cache
+	/// @return True if the asset is resident
+	[[nodiscard]] bool loadAsset(const Asset& asset);
+
+	ModelManager& modelManager;
+	std::shared_ptr<TextureManager> textureManager;
+
+	/// Shared with the worker, guarded by mutex
+	mutable std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::vector<Asset> assets;
+	std::vector<Region> regions;
+	std::vector<size_t> pendingAssets;
+	float lookahead{DefaultLookahead};
+	bool stopping{false};
+
+	/// Index of the asset the worker is loading, it isn't taken again meanwhile
+	static constexpr size_t NoAsset = static_cast<size_t>(-1);
+	size_t loadingAsset{NoAsset};
+
+	std::thread worker;
+};
+
+} /// namespace lillugsi::rendering
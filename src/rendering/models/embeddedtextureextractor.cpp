@@ -2,6 +2,7 @@
 #include <tiny_gltf.h>
 #include <spdlog/spdlog.h>
 #include <filesystem>
+#include <iterator>
 
 namespace lillugsi::rendering::models {
 
@@ -15,15 +16,40 @@ size_t EmbeddedTextureExtractor::extractTextures(
 	const std::string& modelName,
 	bool generateMipmaps) {
 
-	/// Clear previous texture mappings
-	/// This ensures we start with a clean state for each model
-	this->textureMap.clear();
+	/// Log the starting extraction process
+	spdlog::info("Extracting embedded textures from model '{}'", modelName);
+
+	/// Name every texture first, then decode all embedded images right away
+	this->registerTextures(gltfModel, modelName);
 
 	/// Track successful extractions for return value and logging
 	size_t extractedCount = 0;
+	const auto pending = this->pendingImages;
+	for (const auto& [textureName, imageIndex] : pending) {
+		if (this->extractRegisteredTexture(gltfModel, textureName, generateMipmaps)) {
+			extractedCount++;
+			continue;
+		}
 
-	/// Log the starting extraction process
-	spdlog::info("Extracting embedded textures from model '{}'", modelName);
+		/// Textures of images that failed are left without a name, so materials
+		/// fall back to their factors instead of referencing a missing texture
+		for (auto it = this->textureMap.begin(); it != this->textureMap.end();) {
+			it = it->second == textureName ? this->textureMap.erase(it) : std::next(it);
+		}
+	}
+
+	spdlog::info("Extracted {} embedded textures from model '{}'", extractedCount, modelName);
+	return extractedCount;
+}
+
+size_t EmbeddedTextureExtractor::registerTextures(
+	const tinygltf::Model& gltfModel,
+	const std::string& modelName) {
+
+	/// Clear previous texture mappings
+	/// This ensures we start with a clean state for each model
+	this->textureMap.clear();
+	this->pendingImages.clear();
 
 	/// First, scan all textures to build a mapping from texture to image indices
 	/// This is important because glTF separates textures and images - a texture
@@ -50,24 +76,14 @@ size_t EmbeddedTextureExtractor::extractTextures(
 				static_cast<int>(i), 
 				image.name
 			);
-			
-			/// Extract the image from the buffer view
-			bool success = this->extractImage(
-				gltfModel,
-				static_cast<int>(i),
-				textureName,
-				generateMipmaps
-			);
-			
-			if (success) {
-				/// For each texture that uses this image, add it to our texture map
-				for (const auto& [textureIndex, imageIndex] : textureToImageMap) {
-					if (imageIndex == static_cast<int>(i)) {
-						this->textureMap[textureIndex] = textureName;
-						spdlog::debug("Registered texture {} with name '{}'", textureIndex, textureName);
-					}
+			this->pendingImages[textureName] = static_cast<int>(i);
+
+			/// For each texture that uses this image, add it to our texture map
+			for (const auto& [textureIndex, imageIndex] : textureToImageMap) {
+				if (imageIndex == static_cast<int>(i)) {
+					this->textureMap[textureIndex] = textureName;
+					spdlog::debug("Registered texture {} with name '{}'", textureIndex, textureName);
 				}
-				extractedCount++;
 			}
 		}
 		else if (!image.uri.empty()) {
@@ -83,8 +99,23 @@ size_t EmbeddedTextureExtractor::extractTextures(
 		}
 	}
 
-	spdlog::info("Extracted {} embedded textures from model '{}'", extractedCount, modelName);
-	return extractedCount;
+	return this->pendingImages.size();
+}
+
+bool EmbeddedTextureExtractor::extractRegisteredTexture(
+	const tinygltf::Model& gltfModel,
+	const std::string& textureName,
+	bool generateMipmaps) {
+
+	auto it = this->pendingImages.find(textureName);
+	if (it == this->pendingImages.end()) {
+		return false;
+	}
+
+	/// Decoding is only tried once, a failed image would fail again
+	const int imageIndex = it->second;
+	this->pendingImages.erase(it);
+	return this->extractImage(gltfModel, imageIndex, textureName, generateMipmaps);
 }
 
 bool EmbeddedTextureExtractor::extractImage(
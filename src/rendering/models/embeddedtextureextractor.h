@@ -34,6 +34,27 @@ public:
 		const std::string& modelName,
 		bool generateMipmaps = true);
 
+	/// Name all textures of a glTF model without decoding any image
+	/// Material extraction only needs the names. Embedded images are decoded later with
+	/// extractRegisteredTexture, which lets progressive loads decode them one at a time
+	///
+	/// @param gltfModel The parsed glTF model containing embedded textures
+	/// @param modelName Base name for generating unique texture identifiers
+	/// @return Number of embedded images waiting to be decoded
+	size_t registerTextures(
+		const tinygltf::Model& gltfModel,
+		const std::string& modelName);
+
+	/// Decode a registered embedded texture and register it with the texture manager
+	/// @param gltfModel The parsed glTF model containing the image
+	/// @param textureName Engine name of the texture, as returned by getTextureName
+	/// @param generateMipmaps Whether to generate mipmaps for the texture
+	/// @return True if the texture was waiting to be decoded and now is
+	bool extractRegisteredTexture(
+		const tinygltf::Model& gltfModel,
+		const std::string& textureName,
+		bool generateMipmaps = true);
+
 	/// Get the cached texture name for a given texture index
 	/// This provides the mapping between glTF texture indices and
 	/// our engine's unique texture identifiers
@@ -87,6 +108,9 @@ private:
 	/// for a given glTF material reference
 	std::unordered_map<int, std::string> textureMap;
 
+	/// Embedded images not decoded yet, by engine texture name
+	std::unordered_map<std::string, int> pendingImages;
+
 	/// The texture manager to register extracted textures with
 	std::shared_ptr<TextureManager> textureManager;
 };
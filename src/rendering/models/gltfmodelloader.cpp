@@ -1,6 +1,12 @@
 #include "gltfmodelloader.h"
 #include "embeddedtextureextractor.h"
+#include "gltfprogressivemodel.h"
+#include "meshoptdecoder.h"
+#include <algorithm>
 #include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
@@ -11,6 +17,229 @@
 
 namespace lillugsi::rendering {
 
+namespace {
+
+/// Image loader that leaves images encoded
+/// Embedded images are decoded from their buffer views and external ones from their
+/// files by the texture loaders, so the pixels tinygltf would decode are never used
+bool skipImageDecoding(tinygltf::Image *, const int, std::string *, std::string *,
+	int, int, const unsigned char *, int, void *) {
+	return true;
+}
+
+/// Elements of a vertex attribute, wherever its buffer view puts them
+struct AccessorElements {
+	const unsigned char* data{nullptr};
+	size_t stride{0};
+	int componentType{TINYGLTF_COMPONENT_TYPE_FLOAT};
+	bool normalized{false};
+};
+
+/// Read a component of an integer attribute as it is stored
+int32_t readInteger(const AccessorElements& elements, size_t index, int component) {
+	const unsigned char* element = elements.data + index * elements.stride;
+	switch (elements.componentType) {
+		case TINYGLTF_COMPONENT_TYPE_BYTE:
+			return reinterpret_cast<const int8_t*>(element)[component];
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			return reinterpret_cast<const uint8_t*>(element)[component];
+		case TINYGLTF_COMPONENT_TYPE_SHORT:
+			return reinterpret_cast<const int16_t*>(element)[component];
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			return reinterpret_cast<const uint16_t*>(element)[component];
+		default:
+			return 0;
+	}
+}
+
+/// Get the factor that turns a normalized integer into its float value
+/// Signed values are divided by their largest positive value, so -128 and -127 both
+/// end up close to -1. Integers that aren't normalized keep their value
+float getNormalizationFactor(int componentType, bool normalized) {
+	if (!normalized) {
+		return 1.0f;
+	}
+	switch (componentType) {
+		case TINYGLTF_COMPONENT_TYPE_BYTE: return 1.0f / 127.0f;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return 1.0f / 255.0f;
+		case TINYGLTF_COMPONENT_TYPE_SHORT: return 1.0f / 32767.0f;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return 1.0f / 65535.0f;
+		default: return 1.0f;
+	}
+}
+
+/// Read a component as a float, the way glTF defines it for the component type
+float readFloat(const AccessorElements& elements, size_t index, int component) {
+	if (elements.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
+		const unsigned char* element = elements.data + index * elements.stride;
+		return reinterpret_cast<const float*>(element)[component];
+	}
+
+	const float value = static_cast<float>(readInteger(elements, index, component))
+		* getNormalizationFactor(elements.componentType, elements.normalized);
+	return elements.normalized ? std::max(value, -1.0f) : value;
+}
+
+/// Offset that moves an integer component type into the signed 16 bit range
+/// Only unsigned shorts don't fit as they are
+int32_t getQuantizationBias(int componentType) {
+	return componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT ? 32768 : 0;
+}
+
+/// Pack a direction into normalized 8 bit components
+/// The extracted directions aren't necessarily unit length, the shaders normalize
+/// them anyway, so we only keep where they point
+glm::i8vec4 packDirection(const glm::vec3& direction) {
+	const float length = glm::length(direction);
+	const glm::vec3 unit = length > 0.0f ? direction / length : glm::vec3(0.0f);
+	return glm::i8vec4(glm::i8vec3(glm::round(unit * 127.0f)), 0);
+}
+
+/// Build the compact vertices of a primitive with quantized positions
+/// Positions and integer texture coordinates are kept as the file stores them, only
+/// moved into the signed 16 bit range, and the dequantization maps them to what the
+/// float vertices hold, flipped Y axis and V coordinate included. Float texture
+/// coordinates are quantized to 16 bits over their range. Directions and colors come
+/// from the float vertices, 8 bits are all the precision lighting needs for them
+void packQuantizedVertices(ModelMeshData& meshData,
+	const AccessorElements& positions,
+	const AccessorElements& texCoords) {
+	auto& dequantization = meshData.dequantization;
+
+	const int32_t positionBias = getQuantizationBias(positions.componentType);
+	const float positionScale = getNormalizationFactor(positions.componentType, positions.normalized);
+	const float positionOffset = static_cast<float>(positionBias) * positionScale;
+	dequantization.positionScale = glm::vec4(positionScale, -positionScale, positionScale, 0.0f);
+	dequantization.positionOffset = glm::vec4(positionOffset, -positionOffset, positionOffset, 0.0f);
+
+	/// Texture coordinates are either integers from the file, floats we quantize or
+	/// missing, in which case the float vertices have zeros and so do we
+	const bool integerTexCoords = texCoords.data
+		&& texCoords.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT;
+	const int32_t texCoordBias = integerTexCoords ? getQuantizationBias(texCoords.componentType) : 0;
+	glm::vec2 texCoordMin(0.0f);
+	glm::vec2 texCoordStep(0.0f);
+	if (integerTexCoords) {
+		const float scale = getNormalizationFactor(texCoords.componentType, texCoords.normalized);
+		const float offset = static_cast<float>(texCoordBias) * scale;
+		dequantization.texCoordScaleOffset = glm::vec4(scale, -scale, offset, 1.0f - offset);
+	} else if (texCoords.data) {
+		glm::vec2 texCoordMax(std::numeric_limits<float>::lowest());
+		texCoordMin = glm::vec2(std::numeric_limits<float>::max());
+		for (const auto& vertex : meshData.vertices) {
+			texCoordMin = glm::min(texCoordMin, vertex.texCoord);
+			texCoordMax = glm::max(texCoordMax, vertex.texCoord);
+		}
+		texCoordStep = (texCoordMax - texCoordMin) / 65535.0f;
+		dequantization.texCoordScaleOffset = glm::vec4(
+			texCoordStep, texCoordMin + 32768.0f * texCoordStep);
+	} else {
+		dequantization.texCoordScaleOffset = glm::vec4(0.0f);
+	}
+
+	meshData.quantizedVertices.resize(meshData.vertices.size());
+	for (size_t i = 0; i < meshData.vertices.size(); ++i) {
+		const auto& vertex = meshData.vertices[i];
+		auto& quantized = meshData.quantizedVertices[i];
+
+		quantized.position = glm::i16vec4(
+			readInteger(positions, i, 0) - positionBias,
+			readInteger(positions, i, 1) - positionBias,
+			readInteger(positions, i, 2) - positionBias,
+			0);
+		quantized.normal = packDirection(vertex.normal);
+		quantized.tangent = packDirection(vertex.tangent);
+		quantized.color = glm::u8vec4(
+			glm::u8vec3(glm::round(glm::clamp(vertex.color, 0.0f, 1.0f) * 255.0f)), 255);
+
+		if (integerTexCoords) {
+			quantized.texCoord = glm::i16vec2(
+				readInteger(texCoords, i, 0) - texCoordBias,
+				readInteger(texCoords, i, 1) - texCoordBias);
+		} else if (texCoords.data) {
+			/// A zero step means all coordinates are the minimum
+			const glm::vec2 steps = glm::vec2(
+				texCoordStep.x > 0.0f ? (vertex.texCoord.x - texCoordMin.x) / texCoordStep.x : 0.0f,
+				texCoordStep.y > 0.0f ? (vertex.texCoord.y - texCoordMin.y) / texCoordStep.y : 0.0f);
+			quantized.texCoord = glm::i16vec2(glm::round(steps) - 32768.0f);
+		} else {
+			quantized.texCoord = glm::i16vec2(0);
+		}
+	}
+}
+
+/// Get the local transform of a node as translation, rotation and scale
+/// Nodes with a matrix are decomposed, glTF only allows matrices without skew there
+void getNodeTransform(const tinygltf::Node& node, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale) {
+	translation = glm::vec3(0.0f);
+	rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	scale = glm::vec3(1.0f);
+
+	if (!node.matrix.empty()) {
+		glm::vec3 skew;
+		glm::vec4 perspective;
+		glm::decompose(glm::mat4(glm::make_mat4(node.matrix.data())), scale, rotation, translation, skew, perspective);
+		return;
+	}
+	if (node.translation.size() == 3) {
+		translation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+	}
+	if (node.rotation.size() == 4) {
+		rotation = glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
+	}
+	if (node.scale.size() == 3) {
+		scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+	}
+}
+
+/// Get the parent of every node, -1 for nodes no other node lists as a child
+std::vector<int> getNodeParents(const tinygltf::Model& gltfModel) {
+	std::vector<int> parents(gltfModel.nodes.size(), -1);
+	for (size_t i = 0; i < gltfModel.nodes.size(); ++i) {
+		for (const int child : gltfModel.nodes[i].children) {
+			if (child >= 0 && child < static_cast<int>(parents.size())) {
+				parents[child] = static_cast<int>(i);
+			}
+		}
+	}
+	return parents;
+}
+
+/// Get the transform of every node relative to the model's root, as the file defines it
+/// Skeletons and their clips work in this space, without our global scale or flipped axis
+std::vector<glm::mat4> getNodeModelTransforms(const tinygltf::Model& gltfModel, const std::vector<int>& parents) {
+	const size_t nodeCount = gltfModel.nodes.size();
+	std::vector<glm::mat4> locals(nodeCount);
+	for (size_t i = 0; i < nodeCount; ++i) {
+		glm::vec3 translation;
+		glm::quat rotation;
+		glm::vec3 scale;
+		getNodeTransform(gltfModel.nodes[i], translation, rotation, scale);
+		locals[i] = glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation)
+			* glm::scale(glm::mat4(1.0f), scale);
+	}
+
+	/// Walk up to the first node that is done, then fill in the way back down
+	/// A hierarchy deeper than the node count has a cycle, which the file mustn't have
+	std::vector<glm::mat4> models(nodeCount);
+	std::vector<bool> done(nodeCount, false);
+	std::vector<int> chain;
+	for (size_t i = 0; i < nodeCount; ++i) {
+		chain.clear();
+		for (int node = static_cast<int>(i); node >= 0 && !done[node] && chain.size() <= nodeCount; node = parents[node]) {
+			chain.push_back(node);
+		}
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+			const int parent = parents[*it];
+			models[*it] = parent >= 0 && done[parent] ? models[parent] * locals[*it] : locals[*it];
+			done[*it] = true;
+		}
+	}
+	return models;
+}
+
+} /// namespace
+
 GltfModelLoader::GltfModelLoader(
 	std::shared_ptr<MeshManager> meshManager,
 	std::shared_ptr<MaterialManager> materialManager,
@@ -53,26 +282,7 @@ std::shared_ptr<scene::SceneNode> GltfModelLoader::loadModel(
 
 	/// Parse the glTF file using tinygltf
 	tinygltf::Model gltfModel;
-	tinygltf::TinyGLTF loader;
-	std::string err, warn;
-
-	bool success = false;
-
-	/// Load the appropriate format based on file extension
-	if (path.extension() == ".glb") {
-		success = loader.LoadBinaryFromFile(&gltfModel, &err, &warn, filePath);
-	} else {
-		success = loader.LoadASCIIFromFile(&gltfModel, &err, &warn, filePath);
-	}
-
-	/// Log any warnings - these aren't fatal but might indicate issues
-	if (!warn.empty()) {
-		spdlog::warn("glTF warning while loading '{}': {}", filePath, warn);
-	}
-
-	/// Check if loading was successful
-	if (!success) {
-		spdlog::error("Failed to load glTF model '{}': {}", filePath, err);
+	if (!this->parseFile(filePath, gltfModel)) {
 		/// Remove the model root node since loading failed
 		scene.removeNode(modelRootNode);
 		return nullptr;
@@ -118,10 +328,21 @@ std::shared_ptr<scene::SceneNode> GltfModelLoader::loadModel(
 	auto materials = this->createMaterials(modelData, baseDir, materialMapper.get());
 
 	/// Create meshes from the model data
-	auto meshes = this->createMeshes(modelData, materials);
+	auto meshes = this->createMeshes(modelData, materials, options);
+
+	/// Upload the instances of instanced nodes, each node's are shared by its primitives
+	std::unordered_map<int, std::shared_ptr<const MeshInstances>> nodeInstances;
+	for (size_t i = 0; i < modelData.nodes.size(); ++i) {
+		if (!modelData.nodes[i].instanceTransforms.empty() && modelData.nodes[i].meshIndex >= 0) {
+			nodeInstances[static_cast<int>(i)] = this->createNodeInstances(gltfModel, modelData.nodes[i]);
+		}
+	}
 
 	/// Build the scene hierarchy using our dedicated constructor
+	/// Skinned nodes get their animator there, it moves the meshes the node draws
 	SceneGraphConstructor sceneConstructor(gltfModel, modelData, meshes);
+	sceneConstructor.setNodeInstances(std::move(nodeInstances));
+	sceneConstructor.setNodeAnimators(this->createNodeAnimators(gltfModel, options), this->meshManager);
 	auto rootNode = sceneConstructor.buildSceneGraph(scene, modelRootNode, options);
 
 	normalizeModelTransform(modelRootNode);
@@ -133,6 +354,78 @@ std::shared_ptr<scene::SceneNode> GltfModelLoader::loadModel(
 	return modelRootNode;
 }
 
+std::shared_ptr<ProgressiveModel> GltfModelLoader::beginProgressiveLoad(
+	const std::string &filePath,
+	scene::Scene &scene,
+	std::shared_ptr<scene::SceneNode> parentNode,
+	const ModelLoadOptions &options) {
+	/// Ensure we have a valid parent node, defaulting to scene root if none provided
+	if (!parentNode) {
+		parentNode = scene.getRoot();
+	}
+
+	/// Parsing reads the file and its buffers, which can't be avoided, but leaves
+	/// geometry and images encoded until they are streamed
+	auto gltfModel = std::make_unique<tinygltf::Model>();
+	if (!this->parseFile(filePath, *gltfModel)) {
+		return nullptr;
+	}
+
+	return std::make_shared<GltfProgressiveModel>(
+		this->shared_from_this(), std::move(gltfModel), filePath, scene, parentNode, options);
+}
+
+bool GltfModelLoader::parseFile(const std::string &filePath, tinygltf::Model &gltfModel) {
+	tinygltf::TinyGLTF loader;
+	std::string err, warn;
+
+	/// Leave images encoded, tinygltf would otherwise decode every image while parsing
+	loader.SetImageLoader(skipImageDecoding, nullptr);
+
+	/// We read the file ourselves, meshopt fallback buffers must be replaced before
+	/// tinygltf validates the buffers
+	std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+	if (!file.is_open()) {
+		spdlog::error("Failed to open glTF model '{}'", filePath);
+		return false;
+	}
+	std::vector<unsigned char> fileData(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(fileData.data()), static_cast<std::streamsize>(fileData.size()));
+	file.close();
+
+	/// Load the appropriate format based on file extension
+	/// External buffers and images are resolved relative to the file, as tinygltf does
+	/// when it opens the file itself
+	const std::filesystem::path path(filePath);
+	const bool isBinary = path.extension() == ".glb";
+	const std::string baseDir = path.parent_path().string();
+	models::MeshoptDecoder::replaceFallbackBuffers(fileData, isBinary, filePath);
+
+	bool success = false;
+	if (isBinary) {
+		success = loader.LoadBinaryFromMemory(&gltfModel, &err, &warn,
+			fileData.data(), static_cast<unsigned int>(fileData.size()), baseDir);
+	} else {
+		success = loader.LoadASCIIFromString(&gltfModel, &err, &warn,
+			reinterpret_cast<const char*>(fileData.data()), static_cast<unsigned int>(fileData.size()), baseDir);
+	}
+
+	/// Log any warnings - these aren't fatal but might indicate issues
+	if (!warn.empty()) {
+		spdlog::warn("glTF warning while loading '{}': {}", filePath, warn);
+	}
+
+	/// Check if loading was successful
+	if (!success) {
+		spdlog::error("Failed to load glTF model '{}': {}", filePath, err);
+		return false;
+	}
+
+	/// Decompress EXT_meshopt_compression views, everything after reads plain accessors
+	return models::MeshoptDecoder::decodeBufferViews(gltfModel, filePath);
+}
+
 ModelData GltfModelLoader::parseGltfModel(
 	const tinygltf::Model &gltfModel, const ModelLoadOptions &options, const std::string &baseDir) {
 	ModelData modelData;
@@ -166,7 +459,8 @@ ModelData GltfModelLoader::parseGltfModel(
 				gltfModel,
 				static_cast<int>(meshIndex),
 				static_cast<int>(primitiveIndex),
-				options.calculateTangents);
+				options.calculateTangents,
+				options.keepQuantized);
 
 			/// Generate a name for the mesh if not already set during extraction
 			if (meshData.name.empty()) {
@@ -183,12 +477,28 @@ ModelData GltfModelLoader::parseGltfModel(
 
 	/// Parse node hierarchy
 	/// We build a representation of the scene graph structure
+	modelData.nodes = this->parseNodes(gltfModel, options);
+
+	/// Determine if the model has animations
+	modelData.hasAnimations = !gltfModel.animations.empty();
+	if (modelData.hasAnimations) {
+		spdlog::info("Model contains {} animations", gltfModel.animations.size());
+	}
+
+	spdlog::debug("Parsed glTF model with {} meshes, {} materials, and {} nodes",
+		modelData.meshes.size(), modelData.materials.size(), modelData.nodes.size());
+
+	return modelData;
+}
+
+std::vector<ModelData::NodeInfo> GltfModelLoader::parseNodes(
+	const tinygltf::Model &gltfModel, const ModelLoadOptions &options) {
 	spdlog::debug("Parsing {} nodes", gltfModel.nodes.size());
-	modelData.nodes.resize(gltfModel.nodes.size());
+	std::vector<ModelData::NodeInfo> nodes(gltfModel.nodes.size());
 
 	for (size_t i = 0; i < gltfModel.nodes.size(); ++i) {
 		const auto& gltfNode = gltfModel.nodes[i];
-		auto& node = modelData.nodes[i];
+		auto& node = nodes[i];
 
 		/// Set node name
 		node.name = gltfNode.name.empty() ? "node_" + std::to_string(i) : gltfNode.name;
@@ -242,25 +552,143 @@ ModelData GltfModelLoader::parseGltfModel(
 
 		/// Store child indices
 		node.children = gltfNode.children;
+
+		node.instanceTransforms = this->readInstanceTransforms(gltfModel, gltfNode);
 	}
 
-	/// Determine if the model has animations
-	modelData.hasAnimations = !gltfModel.animations.empty();
-	if (modelData.hasAnimations) {
-		spdlog::info("Model contains {} animations", gltfModel.animations.size());
+	return nodes;
+}
+
+std::vector<glm::mat4> GltfModelLoader::readInstanceTransforms(
+	const tinygltf::Model &gltfModel, const tinygltf::Node &gltfNode) {
+	const auto extension = gltfNode.extensions.find(InstancingExtensionName);
+	if (extension == gltfNode.extensions.end() || !extension->second.Has("attributes")) {
+		return {};
 	}
+	const auto& attributes = extension->second.Get("attributes");
+
+	/// Every attribute holds one element per instance, missing ones keep their default
+	size_t instanceCount = 0;
+	const auto getAttribute = [&](const char* name) {
+		AccessorElements elements;
+		if (!attributes.Has(name) || !attributes.Get(name).IsNumber()) {
+			return elements;
+		}
 
-	spdlog::debug("Parsed glTF model with {} meshes, {} materials, and {} nodes",
-		modelData.meshes.size(), modelData.materials.size(), modelData.nodes.size());
+		const int accessorIndex = attributes.Get(name).GetNumberAsInt();
+		auto [data, count] = this->getAccessorData(gltfModel, accessorIndex);
+		if (!data) {
+			return elements;
+		}
 
-	return modelData;
+		const auto& accessor = gltfModel.accessors[accessorIndex];
+		const int stride = accessor.ByteStride(gltfModel.bufferViews[accessor.bufferView]);
+		if (stride <= 0 || (instanceCount != 0 && count != instanceCount)) {
+			spdlog::warn("Ignoring instance attribute {} of node '{}'", name, gltfNode.name);
+			return elements;
+		}
+
+		elements.data = data;
+		elements.stride = static_cast<size_t>(stride);
+		elements.componentType = accessor.componentType;
+		elements.normalized = accessor.normalized;
+		instanceCount = count;
+		return elements;
+	};
+
+	const AccessorElements translations = getAttribute("TRANSLATION");
+	const AccessorElements rotations = getAttribute("ROTATION");
+	const AccessorElements scales = getAttribute("SCALE");
+	if (instanceCount == 0) {
+		return {};
+	}
+
+	/// Vertices are extracted with Y negated, so every instance is conjugated with
+	/// the same flip: flipping back, placing the instance, and flipping again
+	const glm::mat4 flipY = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+
+	std::vector<glm::mat4> transforms(instanceCount);
+	for (size_t i = 0; i < instanceCount; ++i) {
+		glm::mat4 transform(1.0f);
+		if (translations.data) {
+			transform = glm::translate(transform, glm::vec3(
+				readFloat(translations, i, 0),
+				readFloat(translations, i, 1),
+				readFloat(translations, i, 2)));
+		}
+		if (rotations.data) {
+			/// Quantized rotations lose their unit length, w comes last like node rotations
+			transform *= glm::mat4_cast(glm::normalize(glm::quat(
+				readFloat(rotations, i, 3),
+				readFloat(rotations, i, 0),
+				readFloat(rotations, i, 1),
+				readFloat(rotations, i, 2))));
+		}
+		if (scales.data) {
+			transform = glm::scale(transform, glm::vec3(
+				readFloat(scales, i, 0),
+				readFloat(scales, i, 1),
+				readFloat(scales, i, 2)));
+		}
+		transforms[i] = flipY * transform * flipY;
+	}
+
+	spdlog::debug("Read {} instances of node '{}'", instanceCount, gltfNode.name);
+	return transforms;
+}
+
+std::shared_ptr<const MeshInstances> GltfModelLoader::createNodeInstances(
+	const tinygltf::Model &gltfModel, const ModelData::NodeInfo &nodeInfo) const {
+	scene::BoundingBox meshBounds;
+	if (nodeInfo.meshIndex >= 0 && nodeInfo.meshIndex < static_cast<int>(gltfModel.meshes.size())) {
+		const auto& primitives = gltfModel.meshes[nodeInfo.meshIndex].primitives;
+		for (size_t i = 0; i < primitives.size(); ++i) {
+			const auto bounds = this->getPrimitiveBounds(gltfModel, nodeInfo.meshIndex, static_cast<int>(i));
+			if (bounds.isValid()) {
+				meshBounds.addPoint(bounds.getMin());
+				meshBounds.addPoint(bounds.getMax());
+			}
+		}
+	}
+
+	return this->meshManager->createInstances(nodeInfo.instanceTransforms, meshBounds);
+}
+
+scene::BoundingBox GltfModelLoader::getPrimitiveBounds(
+	const tinygltf::Model &gltfModel, int meshIndex, int primitiveIndex) const {
+	const auto &primitive = gltfModel.meshes[meshIndex].primitives[primitiveIndex];
+	const auto it = primitive.attributes.find("POSITION");
+	if (it == primitive.attributes.end()
+		|| it->second < 0 || it->second >= static_cast<int>(gltfModel.accessors.size())) {
+		return {};
+	}
+
+	const auto &accessor = gltfModel.accessors[it->second];
+	if (accessor.minValues.size() < 3 || accessor.maxValues.size() < 3) {
+		return {};
+	}
+
+	/// Quantized accessors keep their minimum and maximum in the stored integers
+	const float factor = accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT
+		? 1.0f
+		: getNormalizationFactor(accessor.componentType, accessor.normalized);
+	const glm::vec3 minimum = glm::vec3(
+		accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]) * factor;
+	const glm::vec3 maximum = glm::vec3(
+		accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]) * factor;
+
+	/// Positions are extracted with Y negated, which swaps its minimum and maximum
+	return scene::BoundingBox(
+		glm::vec3(minimum.x, -maximum.y, minimum.z),
+		glm::vec3(maximum.x, -minimum.y, maximum.z));
 }
 
 ModelMeshData GltfModelLoader::extractMeshData(
 	const tinygltf::Model& gltfModel,
 	int meshIndex,
 	int primitiveIndex,
-	bool calculateTangents) {
+	bool calculateTangents,
+	bool keepQuantized) {
 
 	ModelMeshData meshData;
 
@@ -325,9 +753,7 @@ ModelMeshData GltfModelLoader::extractMeshData(
 				case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
 					/// 32-bit indices - direct copy
 					const uint32_t* indices = reinterpret_cast<const uint32_t*>(data);
-					for (size_t i = 0; i < count; ++i) {
-						meshData.indices.push_back(indices[i]);
-					}
+					meshData.indices.assign(indices, indices + count);
 					break;
 				}
 				default:
@@ -351,114 +777,81 @@ ModelMeshData GltfModelLoader::extractMeshData(
 	meshData.vertices.resize(vertexCount);
 
 	/// glTF stores vertex attributes in separate accessors
-	/// We need to extract each attribute separately and combine them
+	/// We need to extract each attribute separately and combine them. With
+	/// KHR_mesh_quantization any attribute may be stored as integers and interleaved,
+	/// so every read goes through the accessor's component type and stride
+	const auto getAttribute = [&](const char* name) {
+		AccessorElements elements;
+		const auto it = primitive.attributes.find(name);
+		if (it == primitive.attributes.end()) {
+			return elements;
+		}
 
-	/// Extract positions
-	if (primitive.attributes.find("POSITION") != primitive.attributes.end()) {
-		int accessorIndex = primitive.attributes.at("POSITION");
-		auto [data, count] = this->getAccessorData(gltfModel, accessorIndex);
+		auto [data, count] = this->getAccessorData(gltfModel, it->second);
+		if (!data || count != vertexCount) {
+			return elements;
+		}
 
-		if (data && count == vertexCount) {
-			const float* positions = reinterpret_cast<const float*>(data);
-			for (size_t i = 0; i < count; ++i) {
-				meshData.vertices[i].position = glm::vec3(
-					positions[i * 3],     /// X
-					-1.0 * positions[i * 3 + 1], /// Y
-					positions[i * 3 + 2]  /// Z
-				);
-			}
+		const auto& accessor = gltfModel.accessors[it->second];
+		const int stride = accessor.ByteStride(gltfModel.bufferViews[accessor.bufferView]);
+		if (stride <= 0) {
+			spdlog::error("Invalid stride for attribute {} of primitive {}:{}", name, meshIndex, primitiveIndex);
+			return elements;
+		}
+
+		elements.data = data;
+		elements.stride = static_cast<size_t>(stride);
+		elements.componentType = accessor.componentType;
+		elements.normalized = accessor.normalized;
+		return elements;
+	};
+
+	/// Extract positions
+	const AccessorElements positions = getAttribute("POSITION");
+	if (positions.data) {
+		for (size_t i = 0; i < vertexCount; ++i) {
+			meshData.vertices[i].position = glm::vec3(
+				readFloat(positions, i, 0),         /// X
+				-1.0f * readFloat(positions, i, 1), /// Y
+				readFloat(positions, i, 2)          /// Z
+			);
 		}
 	}
 
 	/// Extract normals
-	if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-		int accessorIndex = primitive.attributes.at("NORMAL");
-		auto [data, count] = this->getAccessorData(gltfModel, accessorIndex);
-
-		if (data && count == vertexCount) {
-			const float* normals = reinterpret_cast<const float*>(data);
-			for (size_t i = 0; i < count; ++i) {
-				meshData.vertices[i].normal = glm::vec3(
-					-1.0 - normals[i * 3],     /// X
-					-1.0 - normals[i * 3 + 1], /// Y
-					-1.0 - normals[i * 3 + 2]  /// Z
-				);
-			}
+	const AccessorElements normals = getAttribute("NORMAL");
+	if (normals.data) {
+		for (size_t i = 0; i < vertexCount; ++i) {
+			meshData.vertices[i].normal = glm::vec3(
+				-1.0f - readFloat(normals, i, 0), /// X
+				-1.0f - readFloat(normals, i, 1), /// Y
+				-1.0f - readFloat(normals, i, 2)  /// Z
+			);
 		}
 	}
 
 	/// Extract texture coordinates
-	if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-		int accessorIndex = primitive.attributes.at("TEXCOORD_0");
-		auto [data, count] = this->getAccessorData(gltfModel, accessorIndex);
-
-		if (data && count == vertexCount) {
-			const float* texCoords = reinterpret_cast<const float*>(data);
-			for (size_t i = 0; i < count; ++i) {
-				meshData.vertices[i].texCoord = glm::vec2(
-					texCoords[i * 2],     /// U
-					1.0 - texCoords[i * 2 + 1]  /// V
-				);
-			}
+	const AccessorElements texCoords = getAttribute("TEXCOORD_0");
+	if (texCoords.data) {
+		for (size_t i = 0; i < vertexCount; ++i) {
+			meshData.vertices[i].texCoord = glm::vec2(
+				readFloat(texCoords, i, 0),       /// U
+				1.0f - readFloat(texCoords, i, 1) /// V
+			);
 		}
 	}
 
 	/// Extract colors
-	if (primitive.attributes.find("COLOR_0") != primitive.attributes.end()) {
-		int accessorIndex = primitive.attributes.at("COLOR_0");
-		auto [data, count] = this->getAccessorData(gltfModel, accessorIndex);
-
-		if (data && count == vertexCount) {
-			const auto& accessor = gltfModel.accessors[accessorIndex];
-
-			/// Color data can be encoded in different ways in glTF
-			if (accessor.type == TINYGLTF_TYPE_VEC3) {
-				/// RGB colors
-				if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-					/// Float RGB
-					const float* colors = reinterpret_cast<const float*>(data);
-					for (size_t i = 0; i < count; ++i) {
-						meshData.vertices[i].color = glm::vec3(
-							colors[i * 3],     /// R
-							colors[i * 3 + 1], /// G
-							colors[i * 3 + 2]  /// B
-						);
-					}
-				} else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-					/// 8-bit RGB (normalize to 0-1 range)
-					const uint8_t* colors = reinterpret_cast<const uint8_t*>(data);
-					for (size_t i = 0; i < count; ++i) {
-						meshData.vertices[i].color = glm::vec3(
-							colors[i * 3] / 255.0f,     /// R
-							colors[i * 3 + 1] / 255.0f, /// G
-							colors[i * 3 + 2] / 255.0f  /// B
-						);
-					}
-				}
-			} else if (accessor.type == TINYGLTF_TYPE_VEC4) {
-				/// RGBA colors (we ignore alpha)
-				if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_FLOAT) {
-					/// Float RGBA
-					const float* colors = reinterpret_cast<const float*>(data);
-					for (size_t i = 0; i < count; ++i) {
-						meshData.vertices[i].color = glm::vec3(
-							colors[i * 4],     /// R
-							colors[i * 4 + 1], /// G
-							colors[i * 4 + 2]  /// B
-						);
-					}
-				} else if (accessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE) {
-					/// 8-bit RGBA (normalize to 0-1 range)
-					const uint8_t* colors = reinterpret_cast<const uint8_t*>(data);
-					for (size_t i = 0; i < count; ++i) {
-						meshData.vertices[i].color = glm::vec3(
-							colors[i * 4] / 255.0f,     /// R
-							colors[i * 4 + 1] / 255.0f, /// G
-							colors[i * 4 + 2] / 255.0f  /// B
-						);
-					}
-				}
-			}
+	/// RGB and RGBA colors start the same, we ignore alpha. Integer colors are
+	/// always normalized, readFloat maps them to the 0-1 range
+	const AccessorElements colors = getAttribute("COLOR_0");
+	if (colors.data) {
+		for (size_t i = 0; i < vertexCount; ++i) {
+			meshData.vertices[i].color = glm::vec3(
+				readFloat(colors, i, 0), /// R
+				readFloat(colors, i, 1), /// G
+				readFloat(colors, i, 2)  /// B
+			);
 		}
 	} else {
 		/// If no vertex colors are provided, set default white
@@ -469,21 +862,16 @@ ModelMeshData GltfModelLoader::extractMeshData(
 	}
 
 	/// Extract tangents if available
-	if (primitive.attributes.find("TANGENT") != primitive.attributes.end()) {
-		int accessorIndex = primitive.attributes.at("TANGENT");
-		auto [data, count] = this->getAccessorData(gltfModel, accessorIndex);
-
-		if (data && count == vertexCount) {
-			const float* tangents = reinterpret_cast<const float*>(data);
-			for (size_t i = 0; i < count; ++i) {
-				meshData.vertices[i].tangent = glm::vec3(
-					tangents[i * 4],     /// X
-					tangents[i * 4 + 1], /// Y
-					tangents[i * 4 + 2]  /// Z
-				);
-				/// Note: we ignore tangent.w which is the handedness
-				/// Our engine doesn't currently use this information
-			}
+	const AccessorElements tangents = getAttribute("TANGENT");
+	if (tangents.data) {
+		for (size_t i = 0; i < vertexCount; ++i) {
+			meshData.vertices[i].tangent = glm::vec3(
+				readFloat(tangents, i, 0), /// X
+				readFloat(tangents, i, 1), /// Y
+				readFloat(tangents, i, 2)  /// Z
+			);
+			/// Note: we ignore tangent.w which is the handedness
+			/// Our engine doesn't currently use this information
 		}
 	} else if (calculateTangents) {
 		/// Calculate tangents if not provided and requested
@@ -492,6 +880,41 @@ ModelMeshData GltfModelLoader::extractMeshData(
 		TangentCalculator::calculateTangents(meshData.vertices, meshData.indices);
 	}
 
+	/// Extract skinning influences
+	/// Weights should add up to one but often only nearly do after quantization, so we
+	/// normalize them. Vertices without any weight stay with the first joint
+	const AccessorElements joints = getAttribute("JOINTS_0");
+	const AccessorElements weights = getAttribute("WEIGHTS_0");
+	if (joints.data && weights.data) {
+		meshData.influences.resize(vertexCount);
+		for (size_t i = 0; i < vertexCount; ++i) {
+			glm::uvec4 vertexJoints(0);
+			glm::vec4 vertexWeights(0.0f);
+			for (int component = 0; component < 4; ++component) {
+				vertexJoints[component] = static_cast<uint32_t>(std::max(readInteger(joints, i, component), 0));
+				vertexWeights[component] = std::max(readFloat(weights, i, component), 0.0f);
+			}
+
+			const float weightSum = vertexWeights.x + vertexWeights.y + vertexWeights.z + vertexWeights.w;
+			vertexWeights = weightSum > 0.0f ? vertexWeights / weightSum : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+			for (int component = 0; component < 4; ++component) {
+				if (vertexWeights[component] > 0.0f) {
+					meshData.jointCount = std::max(meshData.jointCount, vertexJoints[component] + 1);
+				}
+			}
+			meshData.influences[i] = SkinInfluence::pack(vertexJoints, vertexWeights);
+		}
+	}
+
+	/// Keep quantized positions compact on the GPU
+	/// The float vertices stay, they are what bounds, tangents and the CPU side of the
+	/// mesh work with. GpuOnly residency frees them after the upload. Skinned vertices
+	/// are rewritten as floats every frame, so they stay floats
+	if (keepQuantized && meshData.influences.empty()
+		&& positions.data && positions.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
+		packQuantizedVertices(meshData, positions, texCoords);
+	}
+
 	spdlog::debug(
 		"Extracted mesh data for primitive {}:{} with {} vertices and {} indices",
 		meshIndex,
@@ -544,13 +967,19 @@ std::unordered_map<std::string, std::shared_ptr<PBRMaterial>> GltfModelLoader::c
 }
 
 std::vector<std::shared_ptr<Mesh>> GltfModelLoader::createMeshes(
-	const ModelData &modelData,
-	const std::unordered_map<std::string, std::shared_ptr<PBRMaterial>> &materials) {
+	ModelData &modelData,
+	const std::unordered_map<std::string, std::shared_ptr<PBRMaterial>> &materials,
+	const ModelLoadOptions &options) {
 	std::vector<std::shared_ptr<Mesh>> meshes;
 	meshes.reserve(modelData.meshes.size());
 
+	/// Host memory of the geometry before and after applying the residency policy
+	size_t vertexCount = 0;
+	size_t bytesBefore = 0;
+	size_t bytesAfter = 0;
+
 	/// Process each mesh in the model data
-	for (const auto &meshData : modelData.meshes) {
+	for (auto &meshData : modelData.meshes) {
 		/// Skip meshes with no geometry
 		if (meshData.vertices.empty()) {
 			spdlog::warn("Skipping mesh '{}' with no vertices", meshData.name);
@@ -558,20 +987,44 @@ std::vector<std::shared_ptr<Mesh>> GltfModelLoader::createMeshes(
 		}
 
 		/// Generate sequential indices if none exist
-		std::vector<uint32_t> indices = meshData.indices;
-		if (indices.empty()) {
-			indices.reserve(meshData.vertices.size());
-			for (size_t i = 0; i < meshData.vertices.size(); i++) {
-				indices.push_back(static_cast<uint32_t>(i));
-			}
+		if (meshData.indices.empty()) {
+			meshData.indices.resize(meshData.vertices.size());
+			std::iota(meshData.indices.begin(), meshData.indices.end(), 0u);
 			spdlog::debug(
 				"Generated {} sequential indices for non-indexed mesh '{}'",
-				indices.size(),
+				meshData.indices.size(),
 				meshData.name);
 		}
 
-		/// Create a mesh with the extracted geometry
-		auto mesh = this->meshManager->createMeshWithGeometry<ModelMesh>(meshData.vertices, indices);
+		std::shared_ptr<Mesh> mesh;
+		if (!meshData.influences.empty()) {
+			/// Skinned primitives live on the GPU only, the skinning pass moves them there.
+			/// They draw their rest pose until the scene graph gives their node an animator
+			auto geometry = this->meshManager->createSkinGeometry(
+				meshData.vertices, meshData.influences, meshData.indices, meshData.jointCount);
+			mesh = this->meshManager->createSkinnedMesh(std::move(geometry), nullptr);
+			meshData.vertices = {};
+			meshData.indices = {};
+			meshData.influences = {};
+		} else {
+			/// Create a mesh with the extracted geometry
+			/// The vectors move into the mesh, so the extracted geometry is never copied and
+			/// the model data only keeps names and hierarchy, which is all the scene graph
+			/// constructor reads. With GpuOnly residency the vertices are freed right after
+			/// their upload, so host memory holds at most the not yet created meshes
+			mesh = this->meshManager->createMeshWithGeometry<ModelMesh>(
+				std::move(meshData.vertices), std::move(meshData.indices),
+				std::move(meshData.quantizedVertices), meshData.dequantization);
+			meshData.vertices = {};
+			meshData.indices = {};
+			meshData.quantizedVertices = {};
+
+			/// The buffers are up to date, so GpuOnly meshes release their vertices right here
+			vertexCount += mesh->getVertexCount();
+			bytesBefore += mesh->getHostMemoryUsage();
+			mesh->setResidency(options.geometryResidency, options.keepPositions);
+			bytesAfter += mesh->getHostMemoryUsage();
+		}
 
 		/// Assign material
 		if (!meshData.materialName.empty()
@@ -587,9 +1040,273 @@ std::vector<std::shared_ptr<Mesh>> GltfModelLoader::createMeshes(
 	}
 
 	spdlog::info("Created {} meshes from model data", meshes.size());
+	if (vertexCount > 0) {
+		const double perMillion = 1000000.0 / static_cast<double>(vertexCount) / (1024.0 * 1024.0);
+		spdlog::info("Mesh geometry in host memory: {:.1f} MB per million vertices before upload, {:.1f} MB after",
+			static_cast<double>(bytesBefore) * perMillion,
+			static_cast<double>(bytesAfter) * perMillion);
+	}
 	return meshes;
 }
 
+std::unordered_map<int, std::shared_ptr<animation::Animator>> GltfModelLoader::createNodeAnimators(
+	const tinygltf::Model &gltfModel, const ModelLoadOptions &options) {
+	std::unordered_map<int, std::shared_ptr<animation::Animator>> animators;
+	if (gltfModel.skins.empty()) {
+		return animators;
+	}
+
+	const std::vector<int> nodeParents = getNodeParents(gltfModel);
+	const std::vector<glm::mat4> nodeModels = getNodeModelTransforms(gltfModel, nodeParents);
+
+	/// Skeletons and clips are extracted once per skin, on first use
+	struct SkinData {
+		std::shared_ptr<const animation::Skeleton> skeleton;
+		std::vector<std::shared_ptr<const animation::AnimationClip>> clips;
+	};
+	std::unordered_map<int, SkinData> skins;
+
+	/// Vertices are extracted with Y negated, the palette has to move them in that space
+	const glm::mat4 flipY = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+
+	for (size_t i = 0; i < gltfModel.nodes.size(); ++i) {
+		const auto& gltfNode = gltfModel.nodes[i];
+		if (gltfNode.skin < 0 || gltfNode.skin >= static_cast<int>(gltfModel.skins.size()) || gltfNode.mesh < 0) {
+			continue;
+		}
+
+		auto skinIt = skins.find(gltfNode.skin);
+		if (skinIt == skins.end()) {
+			const auto& skin = gltfModel.skins[gltfNode.skin];
+			SkinData data;
+			auto skeleton = this->extractSkeleton(gltfModel, skin, nodeParents, nodeModels);
+			if (skeleton && options.loadAnimations) {
+				data.clips = this->extractClips(gltfModel, skin, *skeleton);
+			}
+			data.skeleton = std::move(skeleton);
+			skinIt = skins.emplace(gltfNode.skin, std::move(data)).first;
+		}
+		if (!skinIt->second.skeleton) {
+			continue;
+		}
+
+		/// glTF ignores the transform of a skinned mesh's node, the joints place the
+		/// vertices. Our scene still applies it, so the palette moves vertices into its space
+		const glm::mat4 skinSpace = flipY * glm::inverse(nodeModels[i]);
+		auto animator = std::make_shared<animation::Animator>(
+			skinIt->second.skeleton, skinIt->second.clips, skinSpace);
+		if (!skinIt->second.clips.empty()) {
+			animator->play(0);
+		}
+		animators[static_cast<int>(i)] = std::move(animator);
+	}
+
+	spdlog::info("Created {} animators for {} skins", animators.size(), skins.size());
+	return animators;
+}
+
+std::shared_ptr<animation::Skeleton> GltfModelLoader::extractSkeleton(
+	const tinygltf::Model &gltfModel,
+	const tinygltf::Skin &skin,
+	const std::vector<int> &nodeParents,
+	const std::vector<glm::mat4> &nodeModels) {
+	const auto jointCount = static_cast<uint32_t>(skin.joints.size());
+	if (jointCount == 0) {
+		spdlog::warn("Skin '{}' has no joints", skin.name);
+		return nullptr;
+	}
+
+	std::unordered_map<int, uint32_t> jointOfNode;
+	for (uint32_t joint = 0; joint < jointCount; ++joint) {
+		const int node = skin.joints[joint];
+		if (node < 0 || node >= static_cast<int>(gltfModel.nodes.size())) {
+			spdlog::warn("Skin '{}' has an invalid joint node {}", skin.name, node);
+			return nullptr;
+		}
+		jointOfNode[node] = joint;
+	}
+
+	/// Without inverse bind matrices the joints are bound at their identity
+	std::vector<float> inverseBindMatrices;
+	if (skin.inverseBindMatrices >= 0) {
+		inverseBindMatrices = this->readFloats(gltfModel, skin.inverseBindMatrices, 16);
+		if (inverseBindMatrices.size() < static_cast<size_t>(jointCount) * 16) {
+			spdlog::warn("Skin '{}' has too few inverse bind matrices, binding at identity", skin.name);
+			inverseBindMatrices.clear();
+		}
+	}
+
+	const glm::mat4 flipY = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+
+	auto skeleton = std::make_shared<animation::Skeleton>();
+	skeleton->names.resize(jointCount);
+	skeleton->parents.resize(jointCount, -1);
+	skeleton->rootTransforms.resize(jointCount, glm::mat4(1.0f));
+	skeleton->bindMatrices.resize(jointCount, flipY);
+	skeleton->restPose = animation::Pose(jointCount);
+
+	for (uint32_t joint = 0; joint < jointCount; ++joint) {
+		const int node = skin.joints[joint];
+		const auto& gltfNode = gltfModel.nodes[node];
+		skeleton->names[joint] = gltfNode.name.empty() ? "joint_" + std::to_string(joint) : gltfNode.name;
+
+		const int parentNode = nodeParents[node];
+		const auto parentJoint = jointOfNode.find(parentNode);
+		if (parentJoint != jointOfNode.end()) {
+			skeleton->parents[joint] = static_cast<int32_t>(parentJoint->second);
+		} else if (parentNode >= 0) {
+			skeleton->rootTransforms[joint] = nodeModels[parentNode];
+		}
+
+		if (!inverseBindMatrices.empty()) {
+			skeleton->bindMatrices[joint] = glm::make_mat4(&inverseBindMatrices[joint * 16]) * flipY;
+		}
+
+		glm::vec3 translation;
+		glm::quat rotation;
+		glm::vec3 scale;
+		getNodeTransform(gltfNode, translation, rotation, scale);
+		skeleton->restPose.setJoint(joint, translation, rotation, scale);
+	}
+
+	/// Sort joints by depth so parents come first. Joints whose parents aren't joints
+	/// start the chains, a chain longer than the joint count would be a cycle
+	std::vector<uint32_t> depths(jointCount, 0);
+	for (uint32_t joint = 0; joint < jointCount; ++joint) {
+		for (int32_t parent = skeleton->parents[joint]; parent >= 0 && depths[joint] <= jointCount;
+			parent = skeleton->parents[parent]) {
+			++depths[joint];
+		}
+	}
+	skeleton->evaluationOrder.resize(jointCount);
+	std::iota(skeleton->evaluationOrder.begin(), skeleton->evaluationOrder.end(), 0u);
+	std::stable_sort(skeleton->evaluationOrder.begin(), skeleton->evaluationOrder.end(),
+		[&depths](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+	spdlog::debug("Extracted skeleton of skin '{}' with {} joints", skin.name, jointCount);
+	return skeleton;
+}
+
+std::vector<std::shared_ptr<const animation::AnimationClip>> GltfModelLoader::extractClips(
+	const tinygltf::Model &gltfModel,
+	const tinygltf::Skin &skin,
+	const animation::Skeleton &skeleton) {
+	std::unordered_map<int, uint32_t> jointOfNode;
+	for (uint32_t joint = 0; joint < skin.joints.size(); ++joint) {
+		jointOfNode[skin.joints[joint]] = joint;
+	}
+
+	std::vector<std::shared_ptr<const animation::AnimationClip>> clips;
+	for (size_t animationIndex = 0; animationIndex < gltfModel.animations.size(); ++animationIndex) {
+		const auto& gltfAnimation = gltfModel.animations[animationIndex];
+
+		/// Read the channels moving joints first, the clip's length depends on all of them
+		struct Track {
+			uint32_t joint;
+			animation::AnimationClip::Path path;
+			animation::AnimationClip::Interpolation interpolation;
+			std::vector<float> times;
+			std::vector<float> values;
+		};
+		std::vector<Track> tracks;
+		float duration = 0.0f;
+
+		for (const auto& channel : gltfAnimation.channels) {
+			const auto joint = jointOfNode.find(channel.target_node);
+			if (joint == jointOfNode.end()
+				|| channel.sampler < 0 || channel.sampler >= static_cast<int>(gltfAnimation.samplers.size())) {
+				continue;
+			}
+
+			/// Morph target weights have no joint to move
+			Track track;
+			int components = 3;
+			if (channel.target_path == "translation") {
+				track.path = animation::AnimationClip::Path::Translation;
+			} else if (channel.target_path == "rotation") {
+				track.path = animation::AnimationClip::Path::Rotation;
+				components = 4;
+			} else if (channel.target_path == "scale") {
+				track.path = animation::AnimationClip::Path::Scale;
+			} else {
+				continue;
+			}
+
+			const auto& sampler = gltfAnimation.samplers[channel.sampler];
+			if (sampler.interpolation == "STEP") {
+				track.interpolation = animation::AnimationClip::Interpolation::Step;
+			} else if (sampler.interpolation == "CUBICSPLINE") {
+				track.interpolation = animation::AnimationClip::Interpolation::CubicSpline;
+			} else {
+				track.interpolation = animation::AnimationClip::Interpolation::Linear;
+			}
+
+			track.joint = joint->second;
+			track.times = this->readFloats(gltfModel, sampler.input, 1);
+			track.values = this->readFloats(gltfModel, sampler.output, components);
+
+			const size_t valuesPerKey = components
+				* (track.interpolation == animation::AnimationClip::Interpolation::CubicSpline ? 3 : 1);
+			if (track.times.empty() || track.values.size() != track.times.size() * valuesPerKey) {
+				spdlog::warn("Ignoring channel of joint '{}' in animation {} with mismatched keys",
+					skeleton.names[track.joint], animationIndex);
+				continue;
+			}
+
+			duration = std::max(duration, track.times.back());
+			tracks.push_back(std::move(track));
+		}
+
+		if (tracks.empty()) {
+			continue;
+		}
+
+		const std::string name = gltfAnimation.name.empty()
+			? "animation_" + std::to_string(animationIndex)
+			: gltfAnimation.name;
+		auto clip = std::make_shared<animation::AnimationClip>(name, skeleton.restPose, duration);
+		for (const auto& track : tracks) {
+			clip->setTrack(track.joint, track.path, track.times, track.values, track.interpolation);
+		}
+		clip->finalize();
+
+		spdlog::debug("Extracted animation '{}' of {:.2f} s with {} channels, {} frames",
+			name, duration, tracks.size(), clip->getFrameCount());
+		clips.push_back(std::move(clip));
+	}
+
+	return clips;
+}
+
+std::vector<float> GltfModelLoader::readFloats(
+	const tinygltf::Model &gltfModel, int accessorIndex, int components) {
+	auto [data, count] = this->getAccessorData(gltfModel, accessorIndex);
+	if (!data) {
+		return {};
+	}
+
+	const auto& accessor = gltfModel.accessors[accessorIndex];
+	const int stride = accessor.ByteStride(gltfModel.bufferViews[accessor.bufferView]);
+	if (stride <= 0) {
+		spdlog::error("Invalid stride for accessor {}", accessorIndex);
+		return {};
+	}
+
+	AccessorElements elements;
+	elements.data = data;
+	elements.stride = static_cast<size_t>(stride);
+	elements.componentType = accessor.componentType;
+	elements.normalized = accessor.normalized;
+
+	std::vector<float> values(count * components);
+	for (size_t i = 0; i < count; ++i) {
+		for (int component = 0; component < components; ++component) {
+			values[i * components + component] = readFloat(elements, i, component);
+		}
+	}
+	return values;
+}
+
 std::pair<const unsigned char*, size_t> GltfModelLoader::getAccessorData(
 	const tinygltf::Model& gltfModel,
 	int accessorIndex) {
@@ -721,20 +1438,20 @@ void GltfModelLoader::collectNodeBounds(
 	glm::mat4 worldTransform = parentTransform * localTransform;
 
 	/// If this node has a mesh, add its bounds
-	if (auto mesh = node->getMesh()) {
-		// Calculate bounds from vertices
-		scene::BoundingBox meshBounds;
-		for (const auto& vertex : mesh->getVertices()) {
-			// Transform vertex to world space
-			glm::vec4 worldPos = worldTransform * glm::vec4(vertex.position, 1.0f);
-			meshBounds.addPoint(glm::vec3(worldPos));
-		}
-
-		/// Add to overall bounds
-		if (meshBounds.isValid()) {
-			for (const auto& corner : meshBounds.getCorners()) {
-				bounds.addPoint(corner);
-			}
+	/// The vertices may have been released, the mesh still knows their bounds.
+	/// Nodes of progressively loaded models may still wait for their mesh
+	const auto mesh = node->getMesh();
+	scene::BoundingBox meshBounds;
+	if (const auto localBounds = mesh ? mesh->getBounds() : std::nullopt) {
+		meshBounds = scene::BoundingBox(localBounds->min, localBounds->max).transform(worldTransform);
+	} else if (node->getPendingBounds().isValid()) {
+		meshBounds = node->getPendingBounds().transform(worldTransform);
+	}
+
+	/// Add to overall bounds
+	if (meshBounds.isValid()) {
+		for (const auto& corner : meshBounds.getCorners()) {
+			bounds.addPoint(corner);
 		}
 	}
 
@@ -4,6 +4,8 @@
 #include "materialparametermapper.h"
 #include "modeldata.h"
 #include "modelloader.h"
+#include "progressivemodel.h"
+#include "rendering/animation/animator.h"
 #include "rendering/materialmanager.h"
 #include "rendering/meshmanager.h"
 #include "rendering/modelmesh.h"
@@ -22,6 +24,7 @@ namespace tinygltf {
 	class Material;
 	class Texture;
 	class Image;
+	struct Skin;
 }
 
 namespace lillugsi::rendering {
@@ -29,7 +32,10 @@ namespace lillugsi::rendering {
 /// GltfModelLoader provides loading and processing of glTF format models
 /// We use the tinygltf library to parse glTF files and convert them to our
 /// internal scene structure. This supports both .gltf (JSON) and .glb (binary) formats
-class GltfModelLoader : public ModelLoader {
+class GltfModelLoader : public ModelLoader, public std::enable_shared_from_this<GltfModelLoader> {
+	/// Progressive models stream their meshes with the loader's extraction helpers
+	friend class GltfProgressiveModel;
+
 public:
 	/// Create a glTF model loader
 	/// @param meshManager Manager to create and manage meshes
@@ -54,12 +60,40 @@ public:
 		std::shared_ptr<scene::SceneNode> parentNode = nullptr,
 		const ModelLoadOptions& options = ModelLoadOptions()) override;
 		
+	/// Begin loading a glTF model progressively
+	/// Parses the file and attaches the node hierarchy with bounds from the accessors'
+	/// min and max values, no geometry or image is decoded yet
+	/// @param filePath Path to the glTF (.gltf or .glb) file
+	/// @param scene Scene to load the model into
+	/// @param parentNode Parent node to attach the model to (optional)
+	/// @param options Options controlling loading behavior
+	/// @return The model to stream, or nullptr if the file could not be parsed
+	[[nodiscard]] std::shared_ptr<ProgressiveModel> beginProgressiveLoad(
+		const std::string& filePath,
+		scene::Scene& scene,
+		std::shared_ptr<scene::SceneNode> parentNode = nullptr,
+		const ModelLoadOptions& options = ModelLoadOptions()) override;
+
 	/// Check if this loader supports the given file format
 	/// @param fileExtension The file extension to check (.gltf or .glb)
 	/// @return True if this loader supports the format
 	[[nodiscard]] bool supportsFormat(const std::string& fileExtension) const override;
 
 private:
+	/// Name of the instancing extension in the glTF file
+	static constexpr const char* InstancingExtensionName = "EXT_mesh_gpu_instancing";
+
+	/// Parse a glTF file
+	/// Images are not decoded here: our texture loaders decode them from the file or
+	/// buffer view they reference, decoding in tinygltf as well would be wasted work
+	/// Geometry compressed with EXT_meshopt_compression is decoded here though, so
+	/// extraction never has to know about the extension. Its fallback buffers are
+	/// replaced before tinygltf parses the file, which would reject them otherwise
+	/// @param filePath Path to the glTF (.gltf or .glb) file
+	/// @param gltfModel The model to parse into
+	/// @return True if the file was parsed
+	[[nodiscard]] bool parseFile(const std::string& filePath, tinygltf::Model& gltfModel);
+
 	/// Parse a glTF Model into our internal ModelData structure
 	/// This extracts the node hierarchy, meshes, and materials
 	/// @param gltfModel The parsed tinygltf model
@@ -71,18 +105,61 @@ private:
 		const ModelLoadOptions& options,
 		const std::string& baseDir);
 	
+	/// Parse the node hierarchy
+	/// @param gltfModel The parsed tinygltf model
+	/// @param options Loading options, for the global scale
+	/// @return One entry per glTF node, in the same order
+	[[nodiscard]] std::vector<ModelData::NodeInfo> parseNodes(
+		const tinygltf::Model& gltfModel,
+		const ModelLoadOptions& options);
+
+	/// Read the instances of a node with EXT_mesh_gpu_instancing
+	/// The instances are moved into our flipped Y axis like the vertices they place
+	/// @param gltfModel The parsed tinygltf model
+	/// @param gltfNode The node to read the instances of
+	/// @return Transform of each instance relative to the node, empty without instances
+	[[nodiscard]] std::vector<glm::mat4> readInstanceTransforms(
+		const tinygltf::Model& gltfModel,
+		const tinygltf::Node& gltfNode);
+
+	/// Upload the instances of a node
+	/// The instances are shared by all primitives of the node's mesh, so their
+	/// clusters are bounded by the bounds of all primitives
+	/// @param gltfModel The parsed tinygltf model
+	/// @param nodeInfo The node with instance transforms and a mesh
+	/// @return The uploaded instances
+	[[nodiscard]] std::shared_ptr<const MeshInstances> createNodeInstances(
+		const tinygltf::Model& gltfModel,
+		const ModelData::NodeInfo& nodeInfo) const;
+
+	/// Get the bounds of a mesh primitive without extracting it
+	/// glTF requires min and max on position accessors, so this is cheap. Matches the
+	/// positions extractMeshData produces, including the flipped Y axis
+	/// @param gltfModel The parsed tinygltf model
+	/// @param meshIndex Index of the mesh in the model
+	/// @param primitiveIndex Index of the primitive in the mesh
+	/// @return Bounds in mesh space, invalid if the accessor has no min and max
+	[[nodiscard]] scene::BoundingBox getPrimitiveBounds(
+		const tinygltf::Model& gltfModel,
+		int meshIndex,
+		int primitiveIndex) const;
+
 	/// Extract mesh data from a glTF mesh primitive
-	/// This handles vertex attributes and indices
+	/// This handles vertex attributes and indices. Attributes may use any component
+	/// type KHR_mesh_quantization allows, they are dequantized into the float vertices.
+	/// Primitives with quantized positions also get compact vertices if requested
 	/// @param gltfModel The parsed tinygltf model
 	/// @param meshIndex Index of the mesh in the model
 	/// @param primitiveIndex Index of the primitive in the mesh
 	/// @param calculateTangents Whether to calculate tangent vectors
+	/// @param keepQuantized Whether to keep quantized positions and texture coordinates as they are
 	/// @return Extracted mesh data ready for creating engine mesh
 	[[nodiscard]] ModelMeshData extractMeshData(
 		const tinygltf::Model& gltfModel,
 		int meshIndex,
 		int primitiveIndex,
-		bool calculateTangents);
+		bool calculateTangents,
+		bool keepQuantized = false);
 	
 	/// Extract material properties from a glTF material
 	/// This maps glTF PBR properties to our material system
@@ -105,13 +182,59 @@ private:
 		models::MaterialParameterMapper* materialMapper = nullptr);
 	
 	/// Create engine meshes from extracted mesh data
-	/// @param modelData Our internal model data with mesh info
+	/// The vertices and indices of every mesh are moved out of the model data
+	/// @param modelData Our internal model data with mesh info, keeps names and hierarchy
 	/// @param materials Map of material names to created materials
+	/// @param options Loading options, the meshes get their residency from them
 	/// @return Vector of created meshes
 	[[nodiscard]] std::vector<std::shared_ptr<Mesh>> createMeshes(
-		const ModelData& modelData,
-		const std::unordered_map<std::string, std::shared_ptr<PBRMaterial>>& materials);
+		ModelData& modelData,
+		const std::unordered_map<std::string, std::shared_ptr<PBRMaterial>>& materials,
+		const ModelLoadOptions& options);
 	
+	/// Create an animator for every node drawing a skinned mesh
+	/// Nodes sharing a skin share its skeleton and clips, every node gets its own
+	/// animator. Nodes start playing their skin's first clip
+	/// @param gltfModel The parsed tinygltf model
+	/// @param options Loading options, clips are only extracted with loadAnimations
+	/// @return Animators by glTF node index
+	[[nodiscard]] std::unordered_map<int, std::shared_ptr<animation::Animator>> createNodeAnimators(
+		const tinygltf::Model& gltfModel,
+		const ModelLoadOptions& options);
+
+	/// Extract the skeleton of a skin
+	/// @param gltfModel The parsed tinygltf model
+	/// @param skin The skin to extract
+	/// @param nodeParents Parent of each glTF node, -1 for roots
+	/// @param nodeModels Model space transform of each glTF node
+	/// @return The skeleton, or nullptr if the skin has no valid joints
+	[[nodiscard]] std::shared_ptr<animation::Skeleton> extractSkeleton(
+		const tinygltf::Model& gltfModel,
+		const tinygltf::Skin& skin,
+		const std::vector<int>& nodeParents,
+		const std::vector<glm::mat4>& nodeModels);
+
+	/// Extract the animations that move joints of a skin
+	/// Channels of nodes outside the skin are ignored, our scene nodes aren't animated
+	/// @param gltfModel The parsed tinygltf model
+	/// @param skin The skin whose joints the clips animate
+	/// @param skeleton The skeleton extracted from the skin
+	/// @return One clip per animation that moves at least one joint
+	[[nodiscard]] std::vector<std::shared_ptr<const animation::AnimationClip>> extractClips(
+		const tinygltf::Model& gltfModel,
+		const tinygltf::Skin& skin,
+		const animation::Skeleton& skeleton);
+
+	/// Read all elements of an accessor as floats
+	/// @param gltfModel The parsed tinygltf model
+	/// @param accessorIndex Index of the accessor
+	/// @param components Components to read per element
+	/// @return The components of all elements one after another, empty if unreadable
+	[[nodiscard]] std::vector<float> readFloats(
+		const tinygltf::Model& gltfModel,
+		int accessorIndex,
+		int components);
+
 	/// Get accessor data from a glTF buffer
 	/// Helper to extract raw data from glTF buffer structures
 	/// @param gltfModel The parsed tinygltf model
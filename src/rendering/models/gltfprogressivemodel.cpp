@@ -0,0 +1,360 @@
+#include "gltfprogressivemodel.h"
+#include "gltfmodelloader.h"
+#include "materialextractor.h"
+#include "rendering/modelmesh.h"
+#include <tiny_gltf.h>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+
+namespace lillugsi::rendering {
+
+GltfProgressiveModel::GltfProgressiveModel(
+	std::shared_ptr<GltfModelLoader> loader,
+	std::unique_ptr<tinygltf::Model> gltfModel,
+	const std::string& filePath,
+	scene::Scene& scene,
+	std::shared_ptr<scene::SceneNode> parentNode,
+	const ModelLoadOptions& options)
+	: loader(std::move(loader))
+	, gltfModel(std::move(gltfModel))
+	, filePath(filePath)
+	, options(options) {
+
+	std::filesystem::path path(filePath);
+	const std::string baseName = path.stem().string();
+	this->baseDir = path.parent_path().string();
+
+	this->rootNode = scene.createNode(baseName, parentNode);
+
+	/// Materials only need the texture names, the images are decoded when streamed
+	this->textureExtractor = std::make_shared<models::EmbeddedTextureExtractor>(this->loader->textureManager);
+	const size_t embeddedCount = this->textureExtractor->registerTextures(*this->gltfModel, baseName);
+
+	models::MaterialExtractor materialExtractor(*this->gltfModel);
+	materialExtractor.setEmbeddedTextureExtractor(this->textureExtractor);
+	this->materialInfos = materialExtractor.extractAllMaterials(this->baseDir);
+	this->materialMapper = std::make_unique<models::MaterialParameterMapper>(this->loader->textureManager);
+
+	/// Build the hierarchy of the default scene, or of all nodes if there is none
+	const auto nodes = this->loader->parseNodes(*this->gltfModel, options);
+	const int sceneIndex = this->gltfModel->defaultScene >= 0 ? this->gltfModel->defaultScene : 0;
+	if (sceneIndex < static_cast<int>(this->gltfModel->scenes.size())) {
+		for (int nodeIndex : this->gltfModel->scenes[sceneIndex].nodes) {
+			this->buildNode(nodeIndex, nodes, scene, this->rootNode);
+		}
+	} else {
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			this->buildNode(static_cast<int>(i), nodes, scene, this->rootNode);
+		}
+	}
+	this->pendingMeshIndices.clear();
+
+	/// The expected bounds are final, so the model doesn't move while it streams in
+	this->loader->normalizeModelTransform(this->rootNode);
+	this->rootNode->updateBoundsIfNeeded();
+
+	spdlog::info("Attached hierarchy of '{}', streaming {} mesh primitives and {} embedded images",
+		filePath, this->pendingMeshes.size(), embeddedCount);
+}
+
+GltfProgressiveModel::~GltfProgressiveModel() = default;
+
+void GltfProgressiveModel::buildNode(
+	int nodeIndex,
+	const std::vector<ModelData::NodeInfo>& nodes,
+	scene::Scene& scene,
+	const std::shared_ptr<scene::SceneNode>& parentNode) {
+
+	if (nodeIndex < 0 || nodeIndex >= static_cast<int>(nodes.size())) {
+		spdlog::warn("Invalid node index: {}", nodeIndex);
+		return;
+	}
+
+	const auto& nodeInfo = nodes[nodeIndex];
+	auto sceneNode = scene.createNode(nodeInfo.name, parentNode);
+
+	scene::Transform transform;
+	transform.position = nodeInfo.translation;
+	transform.rotation = nodeInfo.rotation;
+	transform.scale = nodeInfo.scale;
+	sceneNode->setLocalTransform(transform);
+
+	/// Like the scene graph constructor, the first primitive goes on the node itself
+	/// and further primitives on child nodes
+	const int meshIndex = nodeInfo.meshIndex;
+	if (meshIndex >= 0 && meshIndex < static_cast<int>(this->gltfModel->meshes.size())) {
+		const int lodMeshIndex = this->getLowestLodMesh(nodeIndex);
+		const auto& primitives = this->gltfModel->meshes[meshIndex].primitives;
+
+		/// Instances are uploaded right away, they bound the node until its meshes arrive
+		std::shared_ptr<const MeshInstances> instances;
+		if (!nodeInfo.instanceTransforms.empty()) {
+			instances = this->loader->createNodeInstances(*this->gltfModel, nodeInfo);
+		}
+
+		for (size_t primitiveIndex = 0; primitiveIndex < primitives.size(); ++primitiveIndex) {
+			auto primitiveNode = primitiveIndex == 0
+				? sceneNode
+				: scene.createNode(nodeInfo.name + "_primitive_" + std::to_string(primitiveIndex), sceneNode);
+			const int primitive = static_cast<int>(primitiveIndex);
+			primitiveNode->setPendingBounds(this->loader->getPrimitiveBounds(*this->gltfModel, meshIndex, primitive));
+			primitiveNode->setInstances(instances);
+
+			/// Primitives without a coarser level are coarse themselves,
+			/// they are all a node will ever show
+			const bool hasLod = lodMeshIndex >= 0
+				&& primitiveIndex < this->gltfModel->meshes[lodMeshIndex].primitives.size();
+			if (hasLod) {
+				this->addPendingMesh(lodMeshIndex, primitive, true, primitiveNode);
+			}
+			this->addPendingMesh(meshIndex, primitive, !hasLod, primitiveNode);
+		}
+	}
+
+	for (int childIndex : nodeInfo.children) {
+		this->buildNode(childIndex, nodes, scene, sceneNode);
+	}
+}
+
+void GltfProgressiveModel::addPendingMesh(int meshIndex, int primitiveIndex, bool coarse,
+	const std::shared_ptr<scene::SceneNode>& node) {
+	/// Nodes sharing a mesh share one entry, the mesh is uploaded once for all of them
+	const auto key = std::make_tuple(meshIndex, primitiveIndex, coarse);
+	auto it = this->pendingMeshIndices.find(key);
+	if (it == this->pendingMeshIndices.end()) {
+		it = this->pendingMeshIndices.emplace(key, this->pendingMeshes.size()).first;
+		this->pendingMeshes.push_back(PendingMesh{meshIndex, primitiveIndex, coarse, {}});
+	}
+	this->pendingMeshes[it->second].nodes.push_back(node);
+}
+
+int GltfProgressiveModel::getLowestLodMesh(int nodeIndex) const {
+	/// MSFT_lod lists nodes with progressively coarser meshes, the last is the coarsest
+	const auto& gltfNode = this->gltfModel->nodes[nodeIndex];
+	const auto extension = gltfNode.extensions.find("MSFT_lod");
+	if (extension == gltfNode.extensions.end()) {
+		return -1;
+	}
+
+	const auto& ids = extension->second.Get("ids");
+	if (!ids.IsArray() || ids.ArrayLen() == 0) {
+		return -1;
+	}
+
+	const int lodNode = ids.Get(static_cast<int>(ids.ArrayLen() - 1)).GetNumberAsInt();
+	if (lodNode < 0 || lodNode >= static_cast<int>(this->gltfModel->nodes.size())) {
+		return -1;
+	}
+
+	const int lodMesh = this->gltfModel->nodes[lodNode].mesh;
+	if (lodMesh < 0 || lodMesh >= static_cast<int>(this->gltfModel->meshes.size())
+		|| lodMesh == gltfNode.mesh) {
+		return -1;
+	}
+	return lodMesh;
+}
+
+float GltfProgressiveModel::getCoverage(
+	const std::vector<std::weak_ptr<scene::SceneNode>>& nodes,
+	const View& view) {
+	/// Same measure the renderer picks material LODs with: the bounding sphere's
+	/// projected radius relative to half the screen height
+	float coverage = 0.0f;
+	for (const auto& weakNode : nodes) {
+		const auto node = weakNode.lock();
+		if (!node || !node->getWorldBounds().isValid()) {
+			continue;
+		}
+
+		const auto& bounds = node->getWorldBounds();
+		const float radius = glm::length(bounds.getSize()) * 0.5f;
+		const float distance = glm::length(bounds.getCenter() - view.cameraPosition);
+		if (distance <= radius) {
+			/// The camera is inside, nothing can be more important
+			return std::numeric_limits<float>::max();
+		}
+		coverage = std::max(coverage, radius * view.projectionScale / distance);
+	}
+	return coverage;
+}
+
+bool GltfProgressiveModel::streamNext(const View& view) {
+	if (this->isComplete()) {
+		return false;
+	}
+
+	/// Pick the group first, then the largest piece on screen within it
+	const bool coarsePending = std::any_of(this->pendingMeshes.begin(), this->pendingMeshes.end(),
+		[](const PendingMesh& pending) { return pending.coarse; });
+
+	if (coarsePending || this->pendingMaterials.empty()) {
+		auto best = this->pendingMeshes.end();
+		float bestCoverage = -1.0f;
+		for (auto it = this->pendingMeshes.begin(); it != this->pendingMeshes.end(); ++it) {
+			if (it->coarse != coarsePending) {
+				continue;
+			}
+			const float coverage = getCoverage(it->nodes, view);
+			if (coverage > bestCoverage) {
+				bestCoverage = coverage;
+				best = it;
+			}
+		}
+
+		const PendingMesh pending = std::move(*best);
+		this->pendingMeshes.erase(best);
+		this->streamMesh(pending);
+	} else {
+		auto best = this->pendingMaterials.begin();
+		float bestCoverage = -1.0f;
+		for (auto it = this->pendingMaterials.begin(); it != this->pendingMaterials.end(); ++it) {
+			const float coverage = getCoverage(it->nodes, view);
+			if (coverage > bestCoverage) {
+				bestCoverage = coverage;
+				best = it;
+			}
+		}
+
+		const PendingMaterial pending = std::move(*best);
+		this->pendingMaterials.erase(best);
+		this->streamMaterial(pending);
+	}
+
+	this->completedSteps++;
+	if (this->isComplete()) {
+		this->finish();
+		return false;
+	}
+	return true;
+}
+
+void GltfProgressiveModel::streamMesh(const PendingMesh& pending) {
+	const auto key = std::make_pair(pending.meshIndex, pending.primitiveIndex);
+	std::shared_ptr<Mesh> mesh = this->streamedMeshes[key].lock();
+
+	if (!mesh) {
+		ModelMeshData meshData = this->loader->extractMeshData(
+			*this->gltfModel, pending.meshIndex, pending.primitiveIndex,
+			this->options.calculateTangents, this->options.keepQuantized);
+		if (meshData.vertices.empty()) {
+			spdlog::warn("Skipping mesh '{}' with no vertices", meshData.name);
+			return;
+		}
+
+		/// Generate sequential indices if none exist
+		if (meshData.indices.empty()) {
+			meshData.indices.resize(meshData.vertices.size());
+			std::iota(meshData.indices.begin(), meshData.indices.end(), 0u);
+		}
+
+		mesh = this->loader->meshManager->createMeshWithGeometry<ModelMesh>(
+			std::move(meshData.vertices), std::move(meshData.indices),
+			std::move(meshData.quantizedVertices), meshData.dequantization);
+		mesh->setResidency(this->options.geometryResidency, this->options.keepPositions);
+		mesh->setMaterial(this->getMaterial(meshData.materialName));
+		this->streamedMeshes[key] = mesh;
+	}
+
+	for (const auto& weakNode : pending.nodes) {
+		const auto node = weakNode.lock();
+		if (!node) {
+			continue;
+		}
+		node->setMesh(mesh);
+		this->trackPlaceholder(mesh->getMaterial(), node);
+	}
+
+	spdlog::debug("Streamed {} mesh {}:{} of '{}' to {} nodes",
+		pending.coarse ? "coarse" : "detail",
+		pending.meshIndex, pending.primitiveIndex, this->filePath, pending.nodes.size());
+}
+
+void GltfProgressiveModel::streamMaterial(const PendingMaterial& pending) {
+	const auto& materialInfo = this->materialInfos.at(pending.name);
+
+	/// Embedded images referenced by the material are decoded now, file textures
+	/// are loaded by the parameter mapper
+	for (const std::string* texturePath : {
+			&materialInfo.albedoTexturePath, &materialInfo.normalTexturePath,
+			&materialInfo.roughnessTexturePath, &materialInfo.metallicTexturePath,
+			&materialInfo.occlusionTexturePath, &materialInfo.emissiveTexturePath}) {
+		if (!texturePath->empty()) {
+			this->textureExtractor->extractRegisteredTexture(
+				*this->gltfModel, *texturePath, this->options.generateMips);
+		}
+	}
+
+	auto material = this->loader->materialManager->createPBRMaterial(pending.name);
+	if (!this->materialMapper->applyParameters(material, materialInfo, this->baseDir)) {
+		spdlog::warn("Some parameters for material '{}' could not be applied", pending.name);
+	}
+	this->materials[pending.name] = material;
+
+	/// Meshes shared by several nodes are seen more than once, they are swapped once
+	for (const auto& weakNode : pending.nodes) {
+		const auto node = weakNode.lock();
+		const auto mesh = node ? node->getMesh() : nullptr;
+		if (mesh && mesh->getMaterial() == pending.placeholder) {
+			mesh->setMaterial(material);
+		}
+	}
+
+	spdlog::debug("Streamed textures of material '{}' for '{}'", pending.name, this->filePath);
+}
+
+std::shared_ptr<Material> GltfProgressiveModel::getMaterial(const std::string& name) {
+	const auto infoIt = this->materialInfos.find(name);
+	if (infoIt == this->materialInfos.end()) {
+		return this->loader->materialManager->getMaterial("default");
+	}
+
+	auto it = this->materials.find(name);
+	if (it != this->materials.end()) {
+		return it->second;
+	}
+
+	/// First use of the material: show its factors until the textures are decoded
+	auto placeholder = this->loader->materialManager->createPBRMaterial(name + "_placeholder");
+	if (!this->materialMapper->applyScalarParameters(placeholder, infoIt->second)) {
+		spdlog::warn("Could not apply parameters to placeholder of material '{}'", name);
+	}
+	this->materials[name] = placeholder;
+	this->pendingMaterials.push_back(PendingMaterial{name, placeholder, {}});
+	return placeholder;
+}
+
+void GltfProgressiveModel::trackPlaceholder(const std::shared_ptr<Material>& material,
+	const std::shared_ptr<scene::SceneNode>& node) {
+	for (auto& pending : this->pendingMaterials) {
+		if (pending.placeholder == material) {
+			pending.nodes.push_back(node);
+			return;
+		}
+	}
+}
+
+bool GltfProgressiveModel::isComplete() const {
+	return this->pendingMeshes.empty() && this->pendingMaterials.empty();
+}
+
+float GltfProgressiveModel::getProgress() const {
+	/// Materials are only queued once a mesh uses them, so the total can still grow
+	const size_t total = this->completedSteps + this->pendingMeshes.size() + this->pendingMaterials.size();
+	return total > 0 ? static_cast<float>(this->completedSteps) / static_cast<float>(total) : 1.0f;
+}
+
+void GltfProgressiveModel::finish() {
+	/// The file's buffers can be large, they aren't needed anymore
+	this->gltfModel.reset();
+	this->textureExtractor.reset();
+	this->materialMapper.reset();
+	this->streamedMeshes.clear();
+
+	this->rootNode->updateBoundsIfNeeded();
+	spdlog::info("Finished streaming '{}' in {} steps", this->filePath, this->completedSteps);
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "progressivemodel.h"
+#include "modeldata.h"
+#include "modelloader.h"
+#include "embeddedtextureextractor.h"
+#include "materialparametermapper.h"
+#include "rendering/mesh.h"
+#include "rendering/pbrmaterial.h"
+#include "scene/scene.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace tinygltf {
+	class Model;
+}
+
+namespace lillugsi::rendering {
+
+class GltfModelLoader;
+
+/// GltfProgressiveModel streams a glTF model into the scene piece by piece
+/// The node hierarchy is built up front, each node with a mesh gets the bounds of
+/// its primitives from the position accessors' min and max values. After that every
+/// streaming step does one piece of work, picked in this order:
+/// 1. Coarse meshes: the lowest level of MSFT_lod for nodes that have one, the only
+///    mesh for nodes that don't. Once these are done every node shows something.
+/// 2. Textures: materials start as untextured placeholders with the material's
+///    factors, one material at a time gets its textures decoded and replaces them.
+/// 3. Detail meshes replacing the coarse levels of MSFT_lod nodes.
+/// Within each group, what covers the most of the screen comes first.
+class GltfProgressiveModel : public ProgressiveModel {
+public:
+	/// Create the model and attach its hierarchy to the scene
+	/// @param loader The loader that parsed the file, does the extraction
+	/// @param gltfModel The parsed file, kept until streaming is complete
+	/// @param filePath Path to the model file
+	/// @param scene Scene to load the model into
+	/// @param parentNode Parent node to attach the model to
+	/// @param options Options controlling loading behavior
+	GltfProgressiveModel(
+		std::shared_ptr<GltfModelLoader> loader,
+		std::unique_ptr<tinygltf::Model> gltfModel,
+		const std::string& filePath,
+		scene::Scene& scene,
+		std::shared_ptr<scene::SceneNode> parentNode,
+		const ModelLoadOptions& options);
+
+	~GltfProgressiveModel() override;
+
+	bool streamNext(const View& view) override;
+	[[nodiscard]] bool isComplete() const override;
+	[[nodiscard]] std::shared_ptr<scene::SceneNode> getRootNode() const override { return this->rootNode; }
+	[[nodiscard]] float getProgress() const override;
+
+private:
+	/// A mesh primitive waiting for its geometry
+	struct PendingMesh {
+		int meshIndex;
+		int primitiveIndex;
+		bool coarse;                                        /// Streamed before textures and detail
+		std::vector<std::weak_ptr<scene::SceneNode>> nodes; /// Nodes showing the primitive
+	};
+
+	/// A material whose meshes show its placeholder until the textures are decoded
+	struct PendingMaterial {
+		std::string name;
+		std::shared_ptr<PBRMaterial> placeholder;
+		std::vector<std::weak_ptr<scene::SceneNode>> nodes; /// Nodes whose mesh uses the placeholder
+	};
+
+	/// Create the scene node for a glTF node and its subtree
+	void buildNode(
+		int nodeIndex,
+		const std::vector<ModelData::NodeInfo>& nodes,
+		scene::Scene& scene,
+		const std::shared_ptr<scene::SceneNode>& parentNode);
+
+	/// Queue a primitive for a node
+	void addPendingMesh(int meshIndex, int primitiveIndex, bool coarse,
+		const std::shared_ptr<scene::SceneNode>& node);
+
+	/// Get the mesh index of the lowest MSFT_lod level of a node
+	/// @return The mesh index, or -1 if the node has no coarser level
+	[[nodiscard]] int getLowestLodMesh(int nodeIndex) const;
+
+	/// Fraction of the screen height the largest of the nodes covers
+	[[nodiscard]] static float getCoverage(
+		const std::vector<std::weak_ptr<scene::SceneNode>>& nodes,
+		const View& view);
+
+	/// Extract and upload a primitive, then show it on its nodes
+	void streamMesh(const PendingMesh& pending);
+
+	/// Decode a material's textures and replace its placeholder
+	void streamMaterial(const PendingMaterial& pending);
+
+	/// Get the material for a primitive, its placeholder while textures are pending
+	[[nodiscard]] std::shared_ptr<Material> getMaterial(const std::string& name);
+
+	/// Remember that a node's mesh uses a placeholder, to swap it later
+	void trackPlaceholder(const std::shared_ptr<Material>& material,
+		const std::shared_ptr<scene::SceneNode>& node);
+
+	/// Release everything only needed while streaming
+	void finish();
+
+	std::shared_ptr<GltfModelLoader> loader;
+	std::unique_ptr<tinygltf::Model> gltfModel;
+	std::string filePath;
+	std::string baseDir;
+	ModelLoadOptions options;
+
+	std::shared_ptr<scene::SceneNode> rootNode;
+
+	std::shared_ptr<models::EmbeddedTextureExtractor> textureExtractor;
+	std::unique_ptr<models::MaterialParameterMapper> materialMapper;
+
+	/// Material descriptions from the file and the materials created so far,
+	/// placeholders until streamMaterial replaces them
+	std::unordered_map<std::string, ModelData::MaterialInfo> materialInfos;
+	std::unordered_map<std::string, std::shared_ptr<PBRMaterial>> materials;
+
+	std::vector<PendingMesh> pendingMeshes;
+	std::vector<PendingMaterial> pendingMaterials;
+
+	/// Position of each primitive and level in pendingMeshes while building the hierarchy
+	std::map<std::tuple<int, int, bool>, size_t> pendingMeshIndices;
+
+	/// Meshes already created, so primitives shared by several nodes are uploaded once
+	std::map<std::pair<int, int>, std::weak_ptr<Mesh>> streamedMeshes;
+
+	size_t completedSteps{0};
+};
+
+} /// namespace lillugsi::rendering
@@ -32,9 +32,9 @@ public:
 		const ModelData::MaterialInfo& materialInfo,
 		const std::string& basePath = "");
 
-private:
 	/// Apply the basic scalar parameters to the material
-	/// These are the core PBR parameters like base color, metallic, roughness
+	/// These are the core PBR parameters like base color, metallic, roughness.
+	/// On their own they make an untextured stand-in while textures are loading
 	/// @param material The target material to configure
 	/// @param materialInfo The source material data from the model
 	/// @return True if parameters were successfully applied
@@ -42,6 +42,8 @@ private:
 		std::shared_ptr<PBRMaterial> material,
 		const ModelData::MaterialInfo& materialInfo);
 
+private:
+
 	/// Load and apply textures to the material
 	/// This handles all texture-related parameters including maps for:
 	/// albedo, normal, roughness, metallic, occlusion, etc.
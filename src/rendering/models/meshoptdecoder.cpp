@@ -0,0 +1,289 @@
+#include "meshoptdecoder.h"
+#include <tiny_gltf.h>
+#include <meshoptimizer.h>
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace lillugsi::rendering::models {
+
+namespace {
+
+/// A compressed buffer view and where its decoded bytes go
+struct DecodeJob {
+	int bufferViewIndex;
+	const unsigned char* source;  /// Compressed bytes in the source buffer
+	size_t sourceSize;
+	size_t count;                 /// Number of elements
+	size_t stride;                /// Bytes per element
+	std::string mode;             /// ATTRIBUTES, TRIANGLES or INDICES
+	std::string filter;           /// NONE, OCTAHEDRAL, QUATERNION or EXPONENTIAL
+	std::vector<unsigned char>* destination;
+	bool decoded{false};
+};
+
+/// Get an integer member of an extension object
+/// @return The value, or fallback if the member is missing
+int getInt(const tinygltf::Value& object, const char* key, int fallback) {
+	if (!object.Has(key) || !object.Get(key).IsNumber()) {
+		return fallback;
+	}
+	return object.Get(key).GetNumberAsInt();
+}
+
+/// Get a string member of an extension object
+std::string getString(const tinygltf::Value& object, const char* key, const char* fallback) {
+	if (!object.Has(key) || !object.Get(key).IsString()) {
+		return fallback;
+	}
+	return object.Get(key).Get<std::string>();
+}
+
+/// Decode one view into its destination
+/// meshoptimizer returns 0 on success and a negative value for malformed data
+bool decode(DecodeJob& job) {
+	job.destination->resize(job.count * job.stride);
+	void* destination = job.destination->data();
+
+	int result = -1;
+	if (job.mode == "ATTRIBUTES") {
+		result = meshopt_decodeVertexBuffer(
+			destination, job.count, job.stride, job.source, job.sourceSize);
+	} else if (job.mode == "TRIANGLES") {
+		result = meshopt_decodeIndexBuffer(
+			destination, job.count, job.stride, job.source, job.sourceSize);
+	} else if (job.mode == "INDICES") {
+		result = meshopt_decodeIndexSequence(
+			destination, job.count, job.stride, job.source, job.sourceSize);
+	}
+	if (result != 0) {
+		return false;
+	}
+
+	/// Filters undo the attribute specific encodings, in place after decoding
+	if (job.filter == "OCTAHEDRAL") {
+		meshopt_decodeFilterOct(destination, job.count, job.stride);
+	} else if (job.filter == "QUATERNION") {
+		meshopt_decodeFilterQuat(destination, job.count, job.stride);
+	} else if (job.filter == "EXPONENTIAL") {
+		meshopt_decodeFilterExp(destination, job.count, job.stride);
+	}
+	return true;
+}
+
+/// GLB container layout, see the glTF specification's binary format section
+constexpr uint32_t GlbMagic = 0x46546C67;       /// "glTF"
+constexpr uint32_t GlbJsonChunkType = 0x4E4F534A; /// "JSON"
+constexpr size_t GlbHeaderSize = 12;
+constexpr size_t GlbChunkHeaderSize = 8;
+
+/// Read a little endian 32 bit value, tinygltf assumes a little endian host as well
+uint32_t readUint32(const unsigned char* data) {
+	uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+void writeUint32(unsigned char* data, uint32_t value) {
+	std::memcpy(data, &value, sizeof(value));
+}
+
+/// Replace the fallback buffers in a glTF document
+/// @return The rewritten document, or nothing if it has no fallback buffers
+std::optional<std::string> replaceFallbackBuffersInJson(std::string_view json, const std::string& filePath) {
+	/// Parsing every file twice would be wasted work, most don't use the extension
+	if (json.find(MeshoptDecoder::ExtensionName) == std::string_view::npos) {
+		return std::nullopt;
+	}
+
+	auto document = nlohmann::json::parse(json.begin(), json.end(), nullptr, false);
+	if (document.is_discarded() || !document.is_object()) {
+		return std::nullopt;
+	}
+
+	const auto buffers = document.find("buffers");
+	if (buffers == document.end() || !buffers->is_array()) {
+		return std::nullopt;
+	}
+
+	size_t replaced = 0;
+	for (auto& buffer : *buffers) {
+		if (!buffer.is_object() || !buffer.contains("extensions")) {
+			continue;
+		}
+		const auto& extensions = buffer["extensions"];
+		if (!extensions.is_object() || !extensions.contains(MeshoptDecoder::ExtensionName)) {
+			continue;
+		}
+		const auto& extension = extensions[MeshoptDecoder::ExtensionName];
+		if (!extension.is_object() || !extension.contains("fallback") || extension["fallback"] != true) {
+			continue;
+		}
+
+		/// A single zero byte as data uri, which both .gltf and .glb files may use.
+		/// A fallback file next to the model, written by gltfpack -cf, isn't read either
+		buffer["uri"] = "data:application/octet-stream;base64,AA==";
+		buffer["byteLength"] = 1;
+		++replaced;
+	}
+
+	if (replaced == 0) {
+		return std::nullopt;
+	}
+
+	spdlog::debug("Replaced {} {} fallback buffers in '{}'", replaced, MeshoptDecoder::ExtensionName, filePath);
+	return document.dump();
+}
+
+} /// namespace
+
+void MeshoptDecoder::replaceFallbackBuffers(std::vector<unsigned char>& fileData, bool isBinary,
+	const std::string& filePath) {
+	if (!isBinary) {
+		const std::string_view json(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+		const auto rewritten = replaceFallbackBuffersInJson(json, filePath);
+		if (rewritten) {
+			fileData.assign(rewritten->begin(), rewritten->end());
+		}
+		return;
+	}
+
+	/// The JSON chunk comes first, right after the header, the BIN chunk follows it
+	if (fileData.size() < GlbHeaderSize + GlbChunkHeaderSize
+		|| readUint32(fileData.data()) != GlbMagic
+		|| readUint32(fileData.data() + GlbHeaderSize + 4) != GlbJsonChunkType) {
+		return;
+	}
+	const size_t jsonLength = readUint32(fileData.data() + GlbHeaderSize);
+	const size_t jsonOffset = GlbHeaderSize + GlbChunkHeaderSize;
+	if (jsonLength > fileData.size() - jsonOffset) {
+		return;
+	}
+
+	const std::string_view json(reinterpret_cast<const char*>(fileData.data() + jsonOffset), jsonLength);
+	auto rewritten = replaceFallbackBuffersInJson(json, filePath);
+	if (!rewritten) {
+		return;
+	}
+
+	/// Chunks are aligned to 4 bytes, the JSON chunk is padded with spaces
+	rewritten->resize((rewritten->size() + 3) & ~size_t{3}, ' ');
+
+	std::vector<unsigned char> rebuilt;
+	rebuilt.reserve(fileData.size() - jsonLength + rewritten->size());
+	rebuilt.insert(rebuilt.end(), fileData.begin(), fileData.begin() + jsonOffset);
+	rebuilt.insert(rebuilt.end(), rewritten->begin(), rewritten->end());
+	rebuilt.insert(rebuilt.end(), fileData.begin() + jsonOffset + jsonLength, fileData.end());
+
+	writeUint32(rebuilt.data() + 8, static_cast<uint32_t>(rebuilt.size()));
+	writeUint32(rebuilt.data() + GlbHeaderSize, static_cast<uint32_t>(rewritten->size()));
+	fileData = std::move(rebuilt);
+}
+
+bool MeshoptDecoder::decodeBufferViews(tinygltf::Model& gltfModel, const std::string& filePath) {
+	/// Collect the compressed views first
+	/// Every job gets a buffer of its own, appended before any decoding starts, so the
+	/// workers never touch a vector another worker might be resizing
+	std::vector<DecodeJob> jobs;
+	size_t compressedSize = 0;
+	for (size_t i = 0; i < gltfModel.bufferViews.size(); ++i) {
+		const auto& bufferView = gltfModel.bufferViews[i];
+		const auto it = bufferView.extensions.find(ExtensionName);
+		if (it == bufferView.extensions.end()) {
+			continue;
+		}
+
+		const auto& extension = it->second;
+		const int bufferIndex = getInt(extension, "buffer", -1);
+		const size_t byteOffset = static_cast<size_t>(getInt(extension, "byteOffset", 0));
+		const size_t byteLength = static_cast<size_t>(getInt(extension, "byteLength", 0));
+		const int byteStride = getInt(extension, "byteStride", 0);
+		const int count = getInt(extension, "count", 0);
+
+		if (bufferIndex < 0 || bufferIndex >= static_cast<int>(gltfModel.buffers.size())
+			|| byteOffset + byteLength > gltfModel.buffers[bufferIndex].data.size()
+			|| byteStride <= 0 || count < 0) {
+			spdlog::error("Invalid {} on buffer view {} in '{}'", ExtensionName, i, filePath);
+			return false;
+		}
+
+		DecodeJob job;
+		job.bufferViewIndex = static_cast<int>(i);
+		job.source = gltfModel.buffers[bufferIndex].data.data() + byteOffset;
+		job.sourceSize = byteLength;
+		job.count = static_cast<size_t>(count);
+		job.stride = static_cast<size_t>(byteStride);
+		job.mode = getString(extension, "mode", "");
+		job.filter = getString(extension, "filter", "NONE");
+		jobs.push_back(std::move(job));
+		compressedSize += byteLength;
+	}
+
+	if (jobs.empty()) {
+		return true;
+	}
+
+	/// Appending buffers may move the source buffers' vectors, but not their data
+	gltfModel.buffers.reserve(gltfModel.buffers.size() + jobs.size());
+	const size_t firstDecodedBuffer = gltfModel.buffers.size();
+	for (auto& job : jobs) {
+		gltfModel.buffers.emplace_back();
+		job.destination = &gltfModel.buffers.back().data;
+	}
+
+	/// Views take turns from a shared counter, like faces in icosphere subdivision
+	std::atomic<size_t> nextJob{0};
+	const auto decodeJobs = [&jobs, &nextJob]() {
+		for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+			jobs[i].decoded = decode(jobs[i]);
+		}
+	};
+
+	if (compressedSize < ParallelDecodeThreshold || jobs.size() == 1) {
+		decodeJobs();
+	} else {
+		const size_t workerCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, jobs.size());
+		std::vector<std::future<void>> workers;
+		workers.reserve(workerCount);
+		for (size_t i = 0; i < workerCount; ++i) {
+			workers.push_back(std::async(std::launch::async, decodeJobs));
+		}
+		for (auto& worker : workers) {
+			worker.get();
+		}
+	}
+
+	/// Point every view at its decoded bytes
+	size_t decodedSize = 0;
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		const auto& job = jobs[i];
+		if (!job.decoded) {
+			spdlog::error("Failed to decode buffer view {} in '{}' (mode {}, filter {})",
+				job.bufferViewIndex, filePath, job.mode, job.filter);
+			return false;
+		}
+
+		auto& bufferView = gltfModel.bufferViews[job.bufferViewIndex];
+		bufferView.buffer = static_cast<int>(firstDecodedBuffer + i);
+		bufferView.byteOffset = 0;
+		bufferView.byteLength = job.destination->size();
+		/// Index views have no stride in glTF, vertex views keep theirs
+		bufferView.byteStride = job.mode == "ATTRIBUTES" ? job.stride : 0;
+		bufferView.extensions.erase(ExtensionName);
+		decodedSize += job.destination->size();
+	}
+
+	spdlog::info("Decoded {} compressed buffer views in '{}': {} KB to {} KB",
+		jobs.size(), filePath, compressedSize / 1024, decodedSize / 1024);
+	return true;
+}
+
+} /// namespace lillugsi::rendering::models
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tinygltf {
+	class Model;
+}
+
+namespace lillugsi::rendering::models {
+
+/// MeshoptDecoder unpacks buffer views compressed with EXT_meshopt_compression
+/// The extension stores vertex and index data in a form meshoptimizer decodes at
+/// several gigabytes per second, which makes files a fraction of their size on disk
+/// and in memory while reading. Everything downstream (mesh extraction, bounds,
+/// embedded images) reads accessors through buffer views, so instead of teaching each
+/// of them the extension we decode once, right after parsing:
+/// - every compressed view is decoded into a buffer of its own, in parallel;
+/// - the view is pointed at the decoded buffer, as if the file had never been compressed.
+///
+/// Files also carry an uncompressed fallback buffer for loaders without the extension.
+/// gltfpack -c writes it without a uri, with the byteLength of the uncompressed data,
+/// which tinygltf rejects in .gltf files and in .glb files whose BIN chunk is smaller.
+/// We never read it, so replaceFallbackBuffers swaps it for a one byte buffer before
+/// tinygltf sees the file.
+class MeshoptDecoder {
+public:
+	/// Name of the extension in the glTF file
+	static constexpr const char* ExtensionName = "EXT_meshopt_compression";
+
+	/// Decode all compressed buffer views of a model
+	/// @param gltfModel The parsed model, its compressed views are rewritten in place
+	/// @param filePath Path of the file, for log messages
+	/// @return False if a view could not be decoded, the model is unusable then
+	[[nodiscard]] static bool decodeBufferViews(tinygltf::Model& gltfModel, const std::string& filePath);
+
+	/// Replace the fallback buffers of a file before tinygltf parses it
+	/// Views on a fallback buffer are all compressed and repointed by decodeBufferViews,
+	/// so its size doesn't matter. Malformed files are left as they are, tinygltf
+	/// reports what is wrong with them
+	/// @param fileData Contents of the .gltf or .glb file, rewritten in place
+	/// @param isBinary True for a .glb file
+	/// @param filePath Path of the file, for log messages
+	static void replaceFallbackBuffers(std::vector<unsigned char>& fileData, bool isBinary,
+		const std::string& filePath);
+
+private:
+	/// Views smaller than this are decoded on the calling thread
+	/// Starting a worker takes longer than decoding a few kilobytes
+	static constexpr size_t ParallelDecodeThreshold = 256 * 1024;
+};
+
+} /// namespace lillugsi::rendering::models
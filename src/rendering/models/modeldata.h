@@ -15,6 +15,17 @@ namespace lillugsi::rendering {
 struct ModelMeshData {
 	std::vector<Vertex> vertices;    /// Vertex data for this mesh
 	std::vector<uint32_t> indices;   /// Index data defining triangles
+
+	/// Compact vertices for primitives stored quantized, empty otherwise
+	/// The float vertices above hold the same values dequantized
+	std::vector<QuantizedVertex> quantizedVertices;
+	VertexDequantization dequantization;
+
+	/// Joints and weights of each vertex for skinned primitives, empty otherwise
+	/// jointCount is one past the highest joint any vertex uses
+	std::vector<SkinInfluence> influences;
+	uint32_t jointCount{0};
+
 	std::string materialName;        /// Name of the material to apply
 	std::string name;                /// Name of this mesh for identification
 };
@@ -73,6 +84,10 @@ struct ModelData {
 		glm::vec3 scale{1.0f};                 /// Scale of this node
 		int meshIndex{-1};                     /// Index into meshes array, or -1 if no mesh
 		std::vector<int> children;             /// Indices of child nodes
+
+		/// Per-instance transforms from EXT_mesh_gpu_instancing, relative to the node
+		/// Empty if the mesh is drawn once
+		std::vector<glm::mat4> instanceTransforms;
 	};
 	
 	/// All nodes in the model
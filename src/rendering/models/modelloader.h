@@ -1,6 +1,8 @@
 #pragma once
 
+#include "progressivemodel.h"
 #include "scene/scene.h"
+#include "rendering/meshgeometry.h"
 #include <memory>
 #include <string>
 
@@ -13,6 +15,14 @@ struct ModelLoadOptions {
 	bool generateMips{true};        /// Whether to generate mipmaps for textures
 	bool loadAnimations{true};      /// Whether to load and process animations
 	float scale{1.0f};              /// Global scale factor for the loaded model
+
+	/// Loaded meshes aren't edited, so by default only their GPU buffers stay
+	GeometryResidency geometryResidency{GeometryResidency::GpuOnly};
+	bool keepPositions{false};      /// Keep compact positions of GpuOnly meshes, for picking
+
+	/// Draw primitives with quantized positions (KHR_mesh_quantization) from compact
+	/// vertices, instead of widening them to floats
+	bool keepQuantized{true};
 };
 
 /// Base interface for all model loaders
@@ -34,6 +44,22 @@ public:
 		scene::Scene& scene,
 		std::shared_ptr<scene::SceneNode> parentNode = nullptr,
 		const ModelLoadOptions& options = ModelLoadOptions()) = 0;
+
+	/// Begin loading a model progressively
+	/// The model's hierarchy is attached right away and filled in by streaming.
+	/// Loaders that can't stream return nullptr, the caller then loads in one go
+	/// @param filePath Path to the model file
+	/// @param scene Scene to load the model into
+	/// @param parentNode Parent node to attach the model to (optional)
+	/// @param options Options controlling loading behavior
+	/// @return The model to stream, or nullptr
+	[[nodiscard]] virtual std::shared_ptr<ProgressiveModel> beginProgressiveLoad(
+		const std::string& filePath,
+		scene::Scene& scene,
+		std::shared_ptr<scene::SceneNode> parentNode = nullptr,
+		const ModelLoadOptions& options = ModelLoadOptions()) {
+		return nullptr;
+	}
 		
 	/// Check if this loader supports the given file format
 	/// @param fileExtension The file extension to check
@@ -1,6 +1,7 @@
 #include "modelmanager.h"
 #include <spdlog/spdlog.h>
 #include <filesystem>
+#include <unordered_set>
 #include <thread>
 #include <chrono>
 
@@ -73,31 +74,29 @@ std::shared_ptr<scene::SceneNode> ModelManager::loadModel(
 	
 	/// Check if model is already in cache and loading is complete
 	{
-		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		std::unique_lock<std::mutex> lock(this->cacheMutex);
+		this->waitForPrefetch(lock, normalizedPath);
 		
 		auto it = this->modelCache.find(normalizedPath);
 		if (it != this->modelCache.end() && it->second.isComplete) {
-			/// If the cached model is still valid, we can use it
-			if (auto cachedNode = it->second.rootNode.lock()) {
-				spdlog::debug("Using cached model: {}", normalizedPath);
-				
-				/// If we want a separate instance with a different parent,
-				/// we need to clone the hierarchy
-				if (parentNode) {
-					/// Clone the cached model to create a new instance
-					auto newInstance = this->cloneNodeHierarchy(
-						cachedNode, scene, parentNode);
-					
-					return newInstance;
-				}
+			spdlog::debug("Using cached model: {}", normalizedPath);
+			++this->cacheStats.hits;
+			this->touchCachedModel(it->second);
+			const auto cachedNode = it->second.rootNode;
+			
+			/// If we want a separate instance with a different parent,
+			/// we need to clone the hierarchy. Released models aren't in the
+			/// scene anymore, they come back as a clone as well
+			if (parentNode || isReleased(it->second)) {
+				/// Clone the cached model to create a new instance
+				auto newInstance = this->cloneNodeHierarchy(
+					cachedNode, scene, parentNode ? parentNode : scene.getRoot());
 				
-				/// Otherwise, return the cached model directly
-				return cachedNode;
+				return newInstance;
 			}
 			
-			/// If the cached node is no longer valid, remove it from cache
-			spdlog::debug("Cached model node expired, removing from cache: {}", normalizedPath);
-			this->modelCache.erase(it);
+			/// Otherwise, return the cached model directly
+			return cachedNode;
 		}
 		
 		/// Also check if the model is currently being loaded asynchronously
@@ -106,7 +105,17 @@ std::shared_ptr<scene::SceneNode> ModelManager::loadModel(
 			spdlog::warn("Model '{}' is currently being loaded asynchronously", normalizedPath);
 			return nullptr;
 		}
+		++this->cacheStats.misses;
 	}
+
+	return this->loadModelFile(normalizedPath, scene, parentNode, options);
+}
+
+std::shared_ptr<scene::SceneNode> ModelManager::loadModelFile(
+	const std::string& normalizedPath,
+	scene::Scene& scene,
+	std::shared_ptr<scene::SceneNode> parentNode,
+	const ModelLoadOptions& options) {
 	
 	/// Find an appropriate loader for this file
 	auto loader = this->findLoader(normalizedPath);
@@ -122,19 +131,186 @@ std::shared_ptr<scene::SceneNode> ModelManager::loadModel(
 	/// Cache the loaded model if successful
 	if (modelNode) {
 		std::lock_guard<std::mutex> lock(this->cacheMutex);
-		
-		CachedModel cachedModel;
-		cachedModel.rootNode = modelNode;
-		cachedModel.filePath = normalizedPath;
-		cachedModel.isComplete = true;
-		
-		this->modelCache[normalizedPath] = std::move(cachedModel);
+		this->completeCachedModel(normalizedPath, modelNode);
 		spdlog::info("Model cached: {}", normalizedPath);
 	}
 	
 	return modelNode;
 }
 
+std::shared_ptr<scene::SceneNode> ModelManager::loadModelProgressive(
+	const std::string& filePath,
+	scene::Scene& scene,
+	std::shared_ptr<scene::SceneNode> parentNode,
+	const ModelLoadOptions& options) {
+
+	/// Resolve and normalize path for cache lookup
+	std::string resolvedPath = this->resolvePath(filePath);
+	std::string normalizedPath = this->normalizePath(resolvedPath);
+
+	/// A prefetch of the same model finishes first, like for loadModel. Instantiating
+	/// a cached model is faster than streaming it again. Otherwise an incomplete entry
+	/// keeps the prefetcher from loading the file a second time while it streams
+	{
+		std::unique_lock<std::mutex> lock(this->cacheMutex);
+		this->waitForPrefetch(lock, normalizedPath);
+
+		auto it = this->modelCache.find(normalizedPath);
+		if (it != this->modelCache.end() && it->second.isComplete) {
+			lock.unlock();
+			return this->loadModel(filePath, scene, parentNode, options);
+		}
+		if (it == this->modelCache.end()) {
+			CachedModel cachedModel;
+			cachedModel.filePath = normalizedPath;
+			cachedModel.isComplete = false;
+			this->modelCache.emplace(normalizedPath, std::move(cachedModel));
+		}
+	}
+
+	/// A model already streaming in is returned as it is, like a cached model.
+	/// Under a parent loadModel would clone it, but half of it isn't there yet.
+	/// The caller gets an empty node instead, the clone goes below it once complete
+	{
+		std::lock_guard<std::mutex> lock(this->progressiveMutex);
+		for (auto& load : this->progressiveLoads) {
+			if (load.filePath != normalizedPath) {
+				continue;
+			}
+			const auto rootNode = load.model->getRootNode();
+			if (!parentNode) {
+				spdlog::debug("Model '{}' is already streaming in", normalizedPath);
+				return rootNode;
+			}
+
+			auto instanceNode = scene.createNode(rootNode->getName(), parentNode);
+			load.pendingInstances.push_back(ProgressiveLoad::PendingInstance{&scene, instanceNode});
+			spdlog::debug("Model '{}' is already streaming in, instantiated once complete", normalizedPath);
+			return instanceNode;
+		}
+	}
+
+	/// Find an appropriate loader for this file
+	auto loader = this->findLoader(normalizedPath);
+	if (!loader) {
+		spdlog::error("No suitable loader found for model: {}", normalizedPath);
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		auto it = this->modelCache.find(normalizedPath);
+		if (it != this->modelCache.end() && !it->second.isComplete && !it->second.rootNode) {
+			this->eraseCachedModel(it);
+		}
+		return nullptr;
+	}
+
+	auto model = loader->beginProgressiveLoad(normalizedPath, scene, parentNode, options);
+	if (!model) {
+		spdlog::debug("Model '{}' can't be streamed, loading it in one go", normalizedPath);
+		return this->loadModel(filePath, scene, parentNode, options);
+	}
+	auto rootNode = model->getRootNode();
+
+	/// The cache entry stays incomplete until streaming is done, so the half loaded
+	/// hierarchy is never cloned, and measured once there is something to measure
+	{
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		++this->cacheStats.misses;
+
+		auto it = this->modelCache.find(normalizedPath);
+		if (it != this->modelCache.end()) {
+			this->eraseCachedModel(it);
+		}
+
+		CachedModel cachedModel;
+		cachedModel.rootNode = rootNode;
+		cachedModel.filePath = normalizedPath;
+		cachedModel.isComplete = false;
+
+		this->modelCache[normalizedPath] = std::move(cachedModel);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(this->progressiveMutex);
+		this->progressiveLoads.push_back(ProgressiveLoad{std::move(model), normalizedPath});
+	}
+
+	spdlog::info("Started progressive load of model: {}", normalizedPath);
+	return rootNode;
+}
+
+bool ModelManager::updateProgressiveLoads(
+	const ProgressiveModel::View& view,
+	std::chrono::microseconds budget) {
+
+	/// Stream from a copy of the list, new loads may be started meanwhile
+	std::vector<ProgressiveLoad> loads;
+	{
+		std::lock_guard<std::mutex> lock(this->progressiveMutex);
+		loads = this->progressiveLoads;
+	}
+	if (loads.empty()) {
+		return false;
+	}
+
+	/// One piece of every model per round, so several models appear side by side
+	/// instead of one after the other
+	const auto start = std::chrono::steady_clock::now();
+	bool streamed = false;
+	do {
+		bool anyPending = false;
+		for (const auto& load : loads) {
+			if (!load.model->isComplete()) {
+				load.model->streamNext(view);
+				anyPending = true;
+				streamed = true;
+			}
+		}
+		if (!anyPending) {
+			break;
+		}
+	} while (std::chrono::steady_clock::now() - start < budget);
+
+	/// Complete models become regular cached models
+	std::vector<ProgressiveLoad> completed;
+	{
+		std::lock_guard<std::mutex> lock(this->progressiveMutex);
+		for (auto it = this->progressiveLoads.begin(); it != this->progressiveLoads.end();) {
+			if (it->model->isComplete()) {
+				completed.push_back(std::move(*it));
+				it = this->progressiveLoads.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+	if (!completed.empty()) {
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		for (const auto& load : completed) {
+			auto it = this->modelCache.find(load.filePath);
+			if (it != this->modelCache.end() && !it->second.isComplete) {
+				this->completeCachedModel(load.filePath, it->second.rootNode);
+			}
+			spdlog::info("Progressive model load complete and cached: {}", load.filePath);
+		}
+	}
+
+	/// Requests made while streaming get their clone now that there is all of it
+	for (const auto& load : completed) {
+		const auto rootNode = load.model->getRootNode();
+		for (const auto& instance : load.pendingInstances) {
+			if (!this->cloneNodeHierarchy(rootNode, *instance.scene, instance.node)) {
+				spdlog::warn("Failed to instantiate streamed model: {}", load.filePath);
+			}
+		}
+	}
+
+	return streamed;
+}
+
+bool ModelManager::hasProgressiveLoads() const {
+	std::lock_guard<std::mutex> lock(this->progressiveMutex);
+	return !this->progressiveLoads.empty();
+}
+
 std::future<std::shared_ptr<scene::SceneNode>> ModelManager::loadModelAsync(
 	const std::string& filePath,
 	scene::Scene& scene,
@@ -151,30 +327,26 @@ std::future<std::shared_ptr<scene::SceneNode>> ModelManager::loadModelAsync(
 		
 		auto it = this->modelCache.find(normalizedPath);
 		if (it != this->modelCache.end() && it->second.isComplete) {
-			/// If the cached model is still valid, we can use it
-			if (auto cachedNode = it->second.rootNode.lock()) {
-				spdlog::debug("Using cached model for async request: {}", normalizedPath);
-				
-				/// If we want a separate instance with a different parent,
-				/// we need to clone the hierarchy
-				if (parentNode) {
-					/// Create an already-fulfilled future with a clone
-					/// This makes the API consistent even for cached models
-					std::promise<std::shared_ptr<scene::SceneNode>> promise;
-					promise.set_value(this->cloneNodeHierarchy(
-						cachedNode, scene, parentNode));
-					return promise.get_future();
-				}
-				
-				/// Return an already-fulfilled future with the cached node
+			spdlog::debug("Using cached model for async request: {}", normalizedPath);
+			++this->cacheStats.hits;
+			this->touchCachedModel(it->second);
+			const auto cachedNode = it->second.rootNode;
+			
+			/// If we want a separate instance with a different parent,
+			/// we need to clone the hierarchy. Released models come back as a clone
+			if (parentNode || isReleased(it->second)) {
+				/// Create an already-fulfilled future with a clone
+				/// This makes the API consistent even for cached models
 				std::promise<std::shared_ptr<scene::SceneNode>> promise;
-				promise.set_value(cachedNode);
+				promise.set_value(this->cloneNodeHierarchy(
+					cachedNode, scene, parentNode ? parentNode : scene.getRoot()));
 				return promise.get_future();
 			}
 			
-			/// If the cached node is no longer valid, remove it from cache
-			spdlog::debug("Cached model node expired, removing from cache: {}", normalizedPath);
-			this->modelCache.erase(it);
+			/// Return an already-fulfilled future with the cached node
+			std::promise<std::shared_ptr<scene::SceneNode>> promise;
+			promise.set_value(cachedNode);
+			return promise.get_future();
 		}
 		
 		/// Check if the model is already being loaded asynchronously
@@ -209,6 +381,7 @@ std::future<std::shared_ptr<scene::SceneNode>> ModelManager::loadModelAsync(
 	/// Add entry to model cache to indicate loading has started
 	{
 		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		++this->cacheStats.misses;
 		
 		CachedModel cachedModel;
 		cachedModel.filePath = normalizedPath;
@@ -221,6 +394,20 @@ std::future<std::shared_ptr<scene::SceneNode>> ModelManager::loadModelAsync(
 	/// We use std::async for automatic thread management
 	spdlog::info("Starting async load of model: {}", normalizedPath);
 	auto future = std::async(std::launch::async, [this, loader, normalizedPath, &scene, parentNode, options]() {
+		/// A prefetch started before us completes our cache entry, we clone its model then
+		std::shared_ptr<scene::SceneNode> prefetchedNode;
+		{
+			std::unique_lock<std::mutex> lock(this->cacheMutex);
+			this->waitForPrefetch(lock, normalizedPath);
+			auto it = this->modelCache.find(normalizedPath);
+			if (it != this->modelCache.end() && it->second.isComplete) {
+				prefetchedNode = it->second.rootNode;
+			}
+		}
+		if (prefetchedNode) {
+			return this->cloneNodeHierarchy(prefetchedNode, scene, parentNode ? parentNode : scene.getRoot());
+		}
+
 		/// Load the model on a background thread
 		auto modelNode = loader->loadModel(normalizedPath, scene, parentNode, options);
 		
@@ -229,15 +416,17 @@ std::future<std::shared_ptr<scene::SceneNode>> ModelManager::loadModelAsync(
 			std::lock_guard<std::mutex> lock(this->cacheMutex);
 			
 			auto it = this->modelCache.find(normalizedPath);
-			if (it != this->modelCache.end()) {
-				it->second.rootNode = modelNode;
-				it->second.isComplete = true;
+			if (it != this->modelCache.end() && !it->second.isComplete) {
+				this->completeCachedModel(normalizedPath, modelNode);
 				spdlog::info("Async model load complete and cached: {}", normalizedPath);
 			}
 		} else {
 			/// Remove failed loads from cache
 			std::lock_guard<std::mutex> lock(this->cacheMutex);
-			this->modelCache.erase(normalizedPath);
+			auto it = this->modelCache.find(normalizedPath);
+			if (it != this->modelCache.end() && !it->second.isComplete) {
+				this->eraseCachedModel(it);
+			}
 			spdlog::error("Async model load failed: {}", normalizedPath);
 		}
 		
@@ -300,12 +489,51 @@ bool ModelManager::isModelLoaded(const std::string& filePath) const {
 	std::lock_guard<std::mutex> lock(this->cacheMutex);
 	
 	auto it = this->modelCache.find(normalizedPath);
-	if (it != this->modelCache.end() && it->second.isComplete) {
-		/// Check if the weak pointer still points to a valid object
-		return !it->second.rootNode.expired();
+	return it != this->modelCache.end() && it->second.isComplete;
+}
+
+bool ModelManager::prefetchModel(const std::string& filePath, const ModelLoadOptions& options) {
+	std::string normalizedPath = this->normalizePath(this->resolvePath(filePath));
+
+	/// Incomplete entries are loading asynchronously or progressively already
+	{
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		if (this->modelCache.find(normalizedPath) != this->modelCache.end()
+			|| !this->prefetchingModels.insert(normalizedPath).second) {
+			return true;
+		}
+		++this->cacheStats.misses;
 	}
-	
-	return false;
+
+	/// The model is built into a scene nobody draws and detached from it,
+	/// which leaves the cache holding the only reference
+	std::shared_ptr<scene::SceneNode> modelNode;
+	{
+		std::lock_guard<std::mutex> stagingLock(this->stagingMutex);
+		try {
+			modelNode = this->loadModelFile(normalizedPath, this->stagingScene, nullptr, options);
+		} catch (const std::exception& e) {
+			spdlog::error("Failed to prefetch model '{}': {}", normalizedPath, e.what());
+		}
+		if (modelNode) {
+			this->stagingScene.removeNode(modelNode);
+		}
+	}
+	const bool loaded = modelNode != nullptr;
+	modelNode.reset();
+
+	{
+		std::lock_guard<std::mutex> lock(this->cacheMutex);
+		this->prefetchingModels.erase(normalizedPath);
+
+		/// Loading trimmed while the model was still attached, it counts as released only now
+		if (loaded) {
+			this->trimCacheLocked();
+			spdlog::debug("Prefetched model: {}", normalizedPath);
+		}
+	}
+	this->prefetchFinished.notify_all();
+	return loaded;
 }
 
 std::shared_ptr<scene::SceneNode> ModelManager::instantiateModel(
@@ -328,14 +556,9 @@ std::shared_ptr<scene::SceneNode> ModelManager::instantiateModel(
 		
 		auto it = this->modelCache.find(normalizedPath);
 		if (it != this->modelCache.end() && it->second.isComplete) {
-			sourceNode = it->second.rootNode.lock();
-			
-			if (!sourceNode) {
-				/// Model expired, remove from cache
-				this->modelCache.erase(it);
-				spdlog::debug("Cached model expired during instantiation: {}", normalizedPath);
-				return nullptr;
-			}
+			++this->cacheStats.hits;
+			this->touchCachedModel(it->second);
+			sourceNode = it->second.rootNode;
 		} else {
 			spdlog::warn("Attempted to instantiate model that isn't loaded: {}", normalizedPath);
 			return nullptr;
@@ -362,11 +585,10 @@ bool ModelManager::unloadModel(const std::string& filePath) {
 	auto it = this->modelCache.find(normalizedPath);
 	if (it != this->modelCache.end()) {
 		/// Log whether the model is still in use
-		bool expired = it->second.rootNode.expired();
 		spdlog::debug("Unloading model {}: {}", 
-			normalizedPath, expired ? "already expired" : "still in use");
+			normalizedPath, isReleased(it->second) ? "released" : "still in use");
 		
-		this->modelCache.erase(it);
+		this->eraseCachedModel(it);
 		return true;
 	}
 	
@@ -376,6 +598,12 @@ bool ModelManager::unloadModel(const std::string& filePath) {
 void ModelManager::clearCache() {
 	/// First, wait for any pending async operations
 	this->waitForAsyncOperations();
+
+	/// Streaming stops where it is, what was streamed so far stays in the scene
+	{
+		std::lock_guard<std::mutex> lock(this->progressiveMutex);
+		this->progressiveLoads.clear();
+	}
 	
 	std::lock_guard<std::mutex> lock(this->cacheMutex);
 	
@@ -384,18 +612,180 @@ void ModelManager::clearCache() {
 		spdlog::info("Clearing model cache with {} entries", count);
 		
 		/// Log details about each cached model
-		size_t expired = 0;
+		size_t released = 0;
 		for (const auto& [path, model] : this->modelCache) {
-			if (model.rootNode.expired()) {
-				expired++;
+			if (isReleased(model)) {
+				released++;
 			}
 		}
 		
-		spdlog::debug("Model cache contained {} expired entries", expired);
+		spdlog::debug("Model cache contained {} released entries", released);
 		this->modelCache.clear();
+		this->recentModels.clear();
+	}
+}
+
+void ModelManager::setCacheBudget(size_t bytes) {
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+	this->cacheBudget = bytes;
+	this->trimCacheLocked();
+}
+
+size_t ModelManager::getCacheBudget() const {
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+	return this->cacheBudget;
+}
+
+void ModelManager::trimCache() {
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+	this->trimCacheLocked();
+}
+
+ModelManager::CacheStats ModelManager::getCacheStats() const {
+	std::lock_guard<std::mutex> lock(this->cacheMutex);
+
+	CacheStats stats = this->cacheStats;
+	stats.modelCount = this->recentModels.size();
+	for (const auto& path : this->recentModels) {
+		const auto& model = this->modelCache.at(path);
+		stats.residentBytes += model.byteSize;
+		if (isReleased(model)) {
+			stats.releasedBytes += model.byteSize;
+		}
+	}
+	return stats;
+}
+
+void ModelManager::completeCachedModel(const std::string& filePath, std::shared_ptr<scene::SceneNode> rootNode) {
+	/// A model loaded twice at the same time replaces the earlier copy
+	auto it = this->modelCache.find(filePath);
+	if (it != this->modelCache.end() && it->second.isComplete) {
+		this->eraseCachedModel(it);
+		it = this->modelCache.end();
+	}
+	if (it == this->modelCache.end()) {
+		it = this->modelCache.emplace(filePath, CachedModel{}).first;
+		it->second.filePath = filePath;
+	}
+
+	auto& model = it->second;
+	model.rootNode = std::move(rootNode);
+	model.isComplete = true;
+	model.byteSize = measureModel(model.rootNode);
+	this->recentModels.push_front(filePath);
+	model.recentPosition = this->recentModels.begin();
+
+	spdlog::debug("Cached model '{}' holds {:.1f} MB of geometry",
+		filePath, static_cast<double>(model.byteSize) / (1024.0 * 1024.0));
+	this->trimCacheLocked();
+}
+
+void ModelManager::waitForPrefetch(std::unique_lock<std::mutex>& lock, const std::string& normalizedPath) {
+	this->prefetchFinished.wait(lock, [this, &normalizedPath]() {
+		return this->prefetchingModels.find(normalizedPath) == this->prefetchingModels.end();
+	});
+}
+
+void ModelManager::touchCachedModel(CachedModel& model) {
+	this->recentModels.splice(this->recentModels.begin(), this->recentModels, model.recentPosition);
+}
+
+void ModelManager::eraseCachedModel(std::unordered_map<std::string, CachedModel>::iterator it) {
+	if (it->second.isComplete) {
+		this->recentModels.erase(it->second.recentPosition);
+	}
+	this->modelCache.erase(it);
+}
+
+void ModelManager::trimCacheLocked() {
+	size_t releasedBytes = 0;
+	for (const auto& path : this->recentModels) {
+		auto& model = this->modelCache.at(path);
+		if (!isReleased(model)) {
+			continue;
+		}
+		releasedBytes += model.byteSize;
+
+		/// A released model can't come back into the scene, only clones of it can
+		if (!model.animationSuspended) {
+			suspendAnimators(model.rootNode);
+			model.animationSuspended = true;
+		}
+	}
+
+	/// Models in use stay, evicting them frees nothing while the scene holds them
+	for (auto it = this->recentModels.end(); it != this->recentModels.begin() && releasedBytes > this->cacheBudget;) {
+		--it;
+		const auto modelIt = this->modelCache.find(*it);
+		if (!isReleased(modelIt->second)) {
+			continue;
+		}
+
+		releasedBytes -= modelIt->second.byteSize;
+		spdlog::debug("Evicting released model from cache: {}", *it);
+		++this->cacheStats.evictions;
+
+		this->modelCache.erase(modelIt);
+		it = this->recentModels.erase(it);
+	}
+}
+
+bool ModelManager::isReleased(const CachedModel& model) {
+	return model.isComplete && model.rootNode && model.rootNode.use_count() == 1;
+}
+
+void ModelManager::suspendAnimators(const std::shared_ptr<scene::SceneNode>& rootNode) {
+	std::vector<std::shared_ptr<scene::SceneNode>> pending{rootNode};
+	while (!pending.empty()) {
+		const auto node = std::move(pending.back());
+		pending.pop_back();
+
+		if (const auto skinnedMesh = std::dynamic_pointer_cast<SkinnedMesh>(node->getMesh())) {
+			if (const auto& animator = skinnedMesh->getAnimator()) {
+				animator->setSuspended(true);
+			}
+		}
+		pending.insert(pending.end(), node->getChildren().begin(), node->getChildren().end());
 	}
 }
 
+size_t ModelManager::measureModel(const std::shared_ptr<scene::SceneNode>& rootNode) {
+	std::unordered_set<const vulkan::Buffer*> buffers;
+	size_t bytes = 0;
+	const auto addBuffer = [&](const vulkan::Buffer* buffer) {
+		if (buffer && buffers.insert(buffer).second) {
+			bytes += static_cast<size_t>(buffer->getSize());
+		}
+	};
+
+	/// Textures are owned by the texture manager's cache, they outlive the model anyway
+	std::vector<std::shared_ptr<scene::SceneNode>> pending{rootNode};
+	while (!pending.empty()) {
+		const auto node = std::move(pending.back());
+		pending.pop_back();
+		if (!node) {
+			continue;
+		}
+
+		if (const auto& mesh = node->getMesh()) {
+			addBuffer(mesh->getVertexBuffer().get());
+			addBuffer(mesh->getIndexBuffer().get());
+			bytes += mesh->getHostMemoryUsage();
+			if (const auto skinnedMesh = std::dynamic_pointer_cast<SkinnedMesh>(mesh)) {
+				const auto& geometry = skinnedMesh->getSkinGeometry();
+				addBuffer(geometry->restBuffer.get());
+				addBuffer(geometry->influenceBuffer.get());
+			}
+		}
+		if (const auto& instances = node->getInstances()) {
+			addBuffer(instances->getBuffer().get());
+		}
+
+		pending.insert(pending.end(), node->getChildren().begin(), node->getChildren().end());
+	}
+	return bytes;
+}
+
 void ModelManager::setResourceBaseDirectory(const std::string& directory) {
 	/// Store the base directory for resolving relative paths
 	this->resourceBaseDirectory = directory;
@@ -462,6 +852,15 @@ std::shared_ptr<scene::SceneNode> ModelManager::cloneNodeHierarchy(
 	const std::shared_ptr<scene::SceneNode>& sourceNode,
 	scene::Scene& scene,
 	std::shared_ptr<scene::SceneNode> parentNode) const {
+	std::unordered_map<const animation::Animator*, std::shared_ptr<animation::Animator>> animators;
+	return this->cloneNodeHierarchy(sourceNode, scene, std::move(parentNode), animators);
+}
+
+std::shared_ptr<scene::SceneNode> ModelManager::cloneNodeHierarchy(
+	const std::shared_ptr<scene::SceneNode>& sourceNode,
+	scene::Scene& scene,
+	std::shared_ptr<scene::SceneNode> parentNode,
+	std::unordered_map<const animation::Animator*, std::shared_ptr<animation::Animator>>& animators) const {
 	
 	if (!sourceNode) {
 		return nullptr;
@@ -475,13 +874,31 @@ std::shared_ptr<scene::SceneNode> ModelManager::cloneNodeHierarchy(
 	
 	/// Copy the mesh if any
 	/// Note: We reuse the same mesh instance, not clone it
+	/// Animated meshes are the exception, their vertex buffer holds their own pose
 	if (auto mesh = sourceNode->getMesh()) {
-		newNode->setMesh(mesh);
+		const auto skinnedMesh = std::dynamic_pointer_cast<SkinnedMesh>(mesh);
+		if (skinnedMesh && skinnedMesh->getAnimator()) {
+			const auto& sourceAnimator = skinnedMesh->getAnimator();
+			auto& animator = animators[sourceAnimator.get()];
+			if (!animator) {
+				animator = sourceAnimator->clone();
+			}
+			/// The clone plays the source's clips, so it moves within the same bounds
+			auto animatedMesh = this->meshManager->createSkinnedMesh(
+				skinnedMesh->getSkinGeometry(), animator, skinnedMesh->getBounds());
+			animatedMesh->setMaterial(skinnedMesh->getMaterial());
+			newNode->setMesh(std::move(animatedMesh));
+		} else {
+			newNode->setMesh(mesh);
+		}
 	}
+
+	/// Instances are immutable and shared like the mesh
+	newNode->setInstances(sourceNode->getInstances());
 	
 	/// Recursively clone children
 	for (const auto& child : sourceNode->getChildren()) {
-		auto childClone = this->cloneNodeHierarchy(child, scene, newNode);
+		auto childClone = this->cloneNodeHierarchy(child, scene, newNode, animators);
 	}
 	
 	return newNode;
@@ -5,12 +5,18 @@
 #include "rendering/meshmanager.h"
 #include "rendering/materialmanager.h"
 #include "rendering/texturemanager.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string>
 #include <mutex>
 #include <future>
+#include <chrono>
 
 namespace lillugsi::rendering {
 
@@ -30,9 +36,19 @@ namespace lillugsi::rendering {
  * 
  * Resource Management:
  * Loaded models are cached by their filepath to prevent redundant loading.
- * The cache uses weak pointers to allow unused models to be garbage collected
- * while retaining quick access to frequently used models. The cache can be
- * explicitly managed via unloadModel() and clearCache().
+ * The cache holds strong references, so a model stays resident after the scene
+ * releases it and coming back to it costs a clone instead of parsing and uploading
+ * the file again. Released models are evicted least recently used first once their
+ * geometry exceeds the cache budget, models still in the scene are never evicted.
+ * getCacheStats() reports hits, misses and evictions. The cache can be explicitly
+ * managed via unloadModel(), trimCache() and clearCache(). prefetchModel() fills the
+ * cache ahead of the first request.
+ * 
+ * Progressive Loading:
+ * loadModelProgressive() attaches a model's hierarchy with its bounds right away and
+ * returns its root node. updateProgressiveLoads(), called once per frame, then streams
+ * the meshes and textures in within a time budget, largest on screen first. Loaders
+ * that can't stream load the model in one go instead.
  * 
  * Model Instantiation:
  * Models can be instantiated (cloned) via instantiateModel(), which creates
@@ -50,6 +66,19 @@ namespace lillugsi::rendering {
  */
 class ModelManager {
 public:
+	/// Bytes of released models the cache keeps resident by default
+	static constexpr size_t DefaultCacheBudget = 256 * 1024 * 1024;
+
+	/// Counters and sizes of the model cache
+	struct CacheStats {
+		uint64_t hits{0};         /// Requests served from the cache
+		uint64_t misses{0};       /// Requests that loaded the file
+		uint64_t evictions{0};    /// Released models dropped to stay within the budget
+		size_t modelCount{0};     /// Models in the cache, loaded completely
+		size_t residentBytes{0};  /// Geometry of all cached models
+		size_t releasedBytes{0};  /// Geometry of cached models nothing but the cache uses
+	};
+
 	/// Create a model manager
 	/// @param meshManager Manager for creating and managing meshes
 	/// @param materialManager Manager for creating and managing materials
@@ -97,6 +126,32 @@ public:
 		std::shared_ptr<scene::SceneNode> parentNode = nullptr,
 		const ModelLoadOptions& options = ModelLoadOptions());
 		
+	/// Load a model progressively
+	/// The returned node is in the scene already, with the bounds of the whole model.
+	/// Meshes and textures fill in over the following calls to updateProgressiveLoads.
+	/// A model already streaming in is returned as it is without a parent. With one,
+	/// the returned node stays empty until streaming is done and then gets a clone
+	/// @param filePath Path to the model file
+	/// @param scene Scene to load the model into
+	/// @param parentNode Parent node to attach the model to (optional)
+	/// @param options Options controlling loading behavior
+	/// @return Root node of the model, or nullptr if loading failed
+	[[nodiscard]] std::shared_ptr<scene::SceneNode> loadModelProgressive(
+		const std::string& filePath,
+		scene::Scene& scene,
+		std::shared_ptr<scene::SceneNode> parentNode = nullptr,
+		const ModelLoadOptions& options = ModelLoadOptions());
+
+	/// Stream pieces of progressively loading models
+	/// Must be called on the thread that updates the scene
+	/// @param view The camera to prioritize for
+	/// @param budget Time to spend, at least one piece is streamed if any is pending
+	/// @return True if anything was streamed
+	bool updateProgressiveLoads(const ProgressiveModel::View& view, std::chrono::microseconds budget);
+
+	/// Check if any model is still streaming in
+	[[nodiscard]] bool hasProgressiveLoads() const;
+
 	/// Check if a model is currently being loaded asynchronously
 	/// @param filePath Path to the model file
 	/// @return True if the model is being loaded asynchronously
@@ -110,6 +165,15 @@ public:
 	/// @param filePath Path to the model file
 	/// @return True if the model is already loaded
 	[[nodiscard]] bool isModelLoaded(const std::string& filePath) const;
+
+	/// Load a model into the cache without adding it to a scene
+	/// The model is cached as released, so the next loadModel clones it instead of
+	/// reading the file, and it is evicted like any released model if never requested.
+	/// Blocks while loading, call it from a background thread
+	/// @param filePath Path to the model file
+	/// @param options Options controlling loading behavior
+	/// @return True if the model is cached or already being loaded
+	bool prefetchModel(const std::string& filePath, const ModelLoadOptions& options = ModelLoadOptions());
 	
 	/// Get a previously loaded model instance
 	/// This creates a new instance using the cached model data
@@ -132,6 +196,22 @@ public:
 	/// This releases all cached models that aren't referenced elsewhere
 	/// Useful for freeing memory between levels or during low-memory situations
 	void clearCache();
+
+	/// Set how many bytes of released models the cache keeps resident
+	/// Models are evicted right away if the cache is over the new budget
+	/// @param bytes The budget, 0 keeps no released model
+	void setCacheBudget(size_t bytes);
+
+	/// Get how many bytes of released models the cache keeps resident
+	[[nodiscard]] size_t getCacheBudget() const;
+
+	/// Evict released models until they fit the budget
+	/// The cache trims itself whenever a model is added. Models released since are
+	/// only noticed by the next trim, so the owner calls this periodically as well
+	void trimCache();
+
+	/// Get the cache's counters and current sizes
+	[[nodiscard]] CacheStats getCacheStats() const;
 	
 	/// Set the base directory for model resources
 	/// Relative paths will be resolved from this directory
@@ -168,6 +248,21 @@ private:
 		scene::Scene& scene,
 		std::shared_ptr<scene::SceneNode> parentNode) const;
 
+	/// Clone a scene node hierarchy, sharing animators between the clones' meshes
+	/// Skinned meshes are moved by an animator of their own in the clone, so each
+	/// instance of a model animates independently. Meshes that shared an animator in
+	/// the source share its clone
+	/// @param sourceNode Source node to clone
+	/// @param scene Scene to create new nodes in
+	/// @param parentNode Parent for the cloned hierarchy
+	/// @param animators Clones of the animators met so far, by source animator
+	/// @return Root of the cloned hierarchy
+	[[nodiscard]] std::shared_ptr<scene::SceneNode> cloneNodeHierarchy(
+		const std::shared_ptr<scene::SceneNode>& sourceNode,
+		scene::Scene& scene,
+		std::shared_ptr<scene::SceneNode> parentNode,
+		std::unordered_map<const animation::Animator*, std::shared_ptr<animation::Animator>>& animators) const;
+
 	std::shared_ptr<MeshManager> meshManager;         /// For creating mesh resources
 	std::shared_ptr<MaterialManager> materialManager; /// For creating materials
 	std::shared_ptr<TextureManager> textureManager;   /// For loading textures
@@ -180,11 +275,22 @@ private:
 	
 	/// Cache of loaded models
 	struct CachedModel {
-		std::weak_ptr<scene::SceneNode> rootNode; /// Weak reference to allow cleanup
-		std::string filePath;                     /// Original file path
-		bool isComplete{false};                   /// Whether loading is complete
+		std::shared_ptr<scene::SceneNode> rootNode; /// Keeps the model resident after the scene releases it
+		std::string filePath;                       /// Original file path
+		bool isComplete{false};                     /// Whether loading is complete
+		size_t byteSize{0};                         /// Geometry the model holds, measured when complete
+		bool animationSuspended{false};             /// Whether its animators were suspended on release
+
+		/// Position in the recency list, only valid for complete models
+		std::list<std::string>::iterator recentPosition;
 	};
 	std::unordered_map<std::string, CachedModel> modelCache;
+
+	/// Paths of complete models, most recently used first
+	std::list<std::string> recentModels;
+
+	size_t cacheBudget{DefaultCacheBudget};
+	CacheStats cacheStats;
 	
 	/// Active async loading operations
 	struct AsyncLoadOperation {
@@ -193,15 +299,88 @@ private:
 	};
 	std::vector<AsyncLoadOperation> asyncOperations;
 	
+	/// Models still streaming in, with the normalized path they are cached under
+	struct ProgressiveLoad {
+		/// A node returned for a further request, the model is cloned below it when complete
+		struct PendingInstance {
+			scene::Scene* scene;
+			std::shared_ptr<scene::SceneNode> node;
+		};
+
+		std::shared_ptr<ProgressiveModel> model;
+		std::string filePath;
+		std::vector<PendingInstance> pendingInstances;
+	};
+	std::vector<ProgressiveLoad> progressiveLoads;
+
 	/// Mutex for thread-safe model cache access
 	mutable std::mutex cacheMutex;
 	
 	/// Mutex for thread-safe async operations list
 	mutable std::mutex asyncMutex;
+
+	/// Mutex for the progressive loads, started and streamed on different threads
+	mutable std::mutex progressiveMutex;
+
+	/// Paths being prefetched, guarded by cacheMutex
+	/// Loads of the same path wait for the prefetch instead of reading the file again
+	std::unordered_set<std::string> prefetchingModels;
+	std::condition_variable prefetchFinished;
+
+	/// Scene prefetched models are built into and detached from, one prefetch at a time
+	scene::Scene stagingScene;
+	std::mutex stagingMutex;
+
+	/// Load a model file, cache it when loading succeeds
+	/// @param normalizedPath Normalized path of the model
+	/// @param scene Scene to load the model into
+	/// @param parentNode Parent node to attach the model to
+	/// @param options Options controlling loading behavior
+	/// @return Root node of the loaded model, or nullptr if loading failed
+	[[nodiscard]] std::shared_ptr<scene::SceneNode> loadModelFile(
+		const std::string& normalizedPath,
+		scene::Scene& scene,
+		std::shared_ptr<scene::SceneNode> parentNode,
+		const ModelLoadOptions& options);
 	
 	/// Clean up completed async operations
 	/// This removes futures that have completed from the tracking list
 	void cleanupCompletedAsyncOperations();
+
+	/// The following expect cacheMutex to be held
+
+	/// Wait until a prefetch of the model, if any, finished
+	/// @param lock The held lock on cacheMutex, released while waiting
+	/// @param normalizedPath Normalized path of the model
+	void waitForPrefetch(std::unique_lock<std::mutex>& lock, const std::string& normalizedPath);
+
+	/// Mark a complete model as loaded, measure it and trim the cache
+	/// @param filePath Normalized path of the model
+	/// @param rootNode Root of the loaded hierarchy
+	void completeCachedModel(const std::string& filePath, std::shared_ptr<scene::SceneNode> rootNode);
+
+	/// Move a complete model to the front of the recency list
+	void touchCachedModel(CachedModel& model);
+
+	/// Remove a model from the cache and the recency list
+	void eraseCachedModel(std::unordered_map<std::string, CachedModel>::iterator it);
+
+	/// Evict released models, least recently used first, until they fit the budget
+	void trimCacheLocked();
+
+	/// Check if anything but the cache uses a model
+	/// Clones share the model's meshes but not its nodes, so they don't count
+	[[nodiscard]] static bool isReleased(const CachedModel& model);
+
+	/// Measure the geometry of a model hierarchy
+	/// Buffers shared by several meshes are counted once
+	/// @param rootNode Root of the hierarchy
+	/// @return Bytes of GPU buffers and host side geometry
+	/// Suspend the animators of a model's skinned meshes
+	/// Nothing draws a released model, clones animate with animators of their own
+	static void suspendAnimators(const std::shared_ptr<scene::SceneNode>& rootNode);
+
+	[[nodiscard]] static size_t measureModel(const std::shared_ptr<scene::SceneNode>& rootNode);
 };
 
 } /// namespace lillugsi::rendering
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "scene/scenenode.h"
+#include <glm/glm.hpp>
+#include <memory>
+
+namespace lillugsi::rendering {
+
+/// ProgressiveModel is a model that appears in the scene before it is fully loaded
+/// Loading a large model in one go keeps it invisible until every mesh is uploaded
+/// and every texture decoded. A progressive model instead attaches its node hierarchy
+/// with the expected bounds right away, then fills it in one piece at a time:
+/// - coarse geometry first, so the whole model becomes visible quickly;
+/// - pieces covering more of the screen before smaller or distant ones;
+/// - textures replace untextured placeholder materials as they are decoded.
+///
+/// Streaming happens on the thread that updates the scene, in small steps, so the
+/// ModelManager can spread the work over frames within a time budget.
+class ProgressiveModel {
+public:
+	/// What the camera sees, streaming favours what covers most of the screen
+	struct View {
+		glm::vec3 cameraPosition{0.0f};  /// Camera position in world space
+		float projectionScale{1.0f};     /// projection[1][1], turns radius over distance into screen height
+	};
+
+	virtual ~ProgressiveModel() = default;
+
+	/// Load the most important piece still missing
+	/// @param view The camera to prioritize for
+	/// @return False once the model is complete
+	virtual bool streamNext(const View& view) = 0;
+
+	/// Check whether everything has been loaded
+	[[nodiscard]] virtual bool isComplete() const = 0;
+
+	/// Get the root node of the model
+	/// The node is part of the scene from the start, its children fill in while streaming
+	[[nodiscard]] virtual std::shared_ptr<scene::SceneNode> getRootNode() const = 0;
+
+	/// Get how much of the model has been loaded
+	/// @return Fraction of the streaming steps done, from 0 to 1
+	[[nodiscard]] virtual float getProgress() const = 0;
+};
+
+} /// namespace lillugsi::rendering
@@ -14,6 +14,18 @@ SceneGraphConstructor::SceneGraphConstructor(
 	, meshes(meshes) {
 }
 
+void SceneGraphConstructor::setNodeInstances(
+	std::unordered_map<int, std::shared_ptr<const MeshInstances>> nodeInstances) {
+	this->nodeInstances = std::move(nodeInstances);
+}
+
+void SceneGraphConstructor::setNodeAnimators(
+	std::unordered_map<int, std::shared_ptr<animation::Animator>> nodeAnimators,
+	std::shared_ptr<MeshManager> meshManager) {
+	this->nodeAnimators = std::move(nodeAnimators);
+	this->meshManager = std::move(meshManager);
+}
+
 std::shared_ptr<scene::SceneNode> SceneGraphConstructor::buildSceneGraph(
 	scene::Scene& scene,
 	std::shared_ptr<scene::SceneNode> parentNode,
@@ -93,10 +105,26 @@ std::shared_ptr<scene::SceneNode> SceneGraphConstructor::processNode(
 	
 	/// Handle node's mesh if it has one
 	bool hasMesh = this->assignNodeMesh(nodeInfo, sceneNode);
+
+	/// Instanced nodes draw their mesh once per instance instead
+	std::shared_ptr<const MeshInstances> instances;
+	const auto instancesIt = this->nodeInstances.find(nodeIndex);
+	if (hasMesh && instancesIt != this->nodeInstances.end()) {
+		instances = instancesIt->second;
+		sceneNode->setInstances(instances);
+	}
 	
+	/// Skinned nodes draw meshes moved by their animator
+	std::shared_ptr<animation::Animator> animator;
+	const auto animatorIt = this->nodeAnimators.find(nodeIndex);
+	if (hasMesh && animatorIt != this->nodeAnimators.end()) {
+		animator = animatorIt->second;
+		this->animateNodeMesh(sceneNode, animator);
+	}
+
 	/// If the node has a mesh with multiple primitives, create child nodes
 	if (hasMesh && nodeInfo.meshIndex >= 0) {
-		this->handlePrimitiveGroups(nodeInfo.meshIndex, nodeInfo.name, scene, sceneNode);
+		this->handlePrimitiveGroups(nodeInfo.meshIndex, nodeInfo.name, scene, sceneNode, instances, animator);
 	}
 	
 	/// Process child nodes recursively
@@ -152,12 +180,8 @@ bool SceneGraphConstructor::assignNodeMesh(
 
 	// Add debug bounds reporting for this node
 	auto mesh = this->meshes[nodeInfo.meshIndex];
-	auto& vertices = mesh->getVertices();
-	if (!vertices.empty()) {
-		scene::BoundingBox localBounds;
-		for (const auto& v : vertices) {
-			localBounds.addPoint(v.position);
-		}
+	if (const auto bounds = mesh->getBounds()) {
+		const scene::BoundingBox localBounds(bounds->min, bounds->max);
 
 		spdlog::info("Node '{}' mesh bounds: min=({},{},{}), max=({},{},{})",
 			nodeInfo.name,
@@ -172,7 +196,9 @@ bool SceneGraphConstructor::handlePrimitiveGroups(
 	int meshIndex,
 	const std::string& nodeName,
 	scene::Scene& scene,
-	std::shared_ptr<scene::SceneNode> parentNode) {
+	std::shared_ptr<scene::SceneNode> parentNode,
+	const std::shared_ptr<const MeshInstances>& instances,
+	const std::shared_ptr<animation::Animator>& animator) {
 	
 	/// Validate mesh index
 	if (meshIndex < 0 || meshIndex >= static_cast<int>(this->gltfModel.meshes.size())) {
@@ -209,6 +235,10 @@ bool SceneGraphConstructor::handlePrimitiveGroups(
 		/// Assign mesh if found
 		if (meshDataIndex >= 0 && meshDataIndex < static_cast<int>(this->meshes.size())) {
 			primitiveNode->setMesh(this->meshes[meshDataIndex]);
+			primitiveNode->setInstances(instances);
+			if (animator) {
+				this->animateNodeMesh(primitiveNode, animator);
+			}
 			spdlog::debug("Assigned mesh '{}' to primitive node '{}'", 
 				this->modelData.meshes[meshDataIndex].name, primitiveName);
 		} else {
@@ -220,4 +250,26 @@ bool SceneGraphConstructor::handlePrimitiveGroups(
 	return true;
 }
 
+void SceneGraphConstructor::animateNodeMesh(
+	const std::shared_ptr<scene::SceneNode>& sceneNode,
+	const std::shared_ptr<animation::Animator>& animator) {
+	const auto skinnedMesh = std::dynamic_pointer_cast<SkinnedMesh>(sceneNode->getMesh());
+	if (!skinnedMesh || !this->meshManager) {
+		return;
+	}
+
+	/// The skinning pass reads the palette at the vertices' joint indices, so every
+	/// index must be a joint of the animator's skeleton
+	const auto& geometry = skinnedMesh->getSkinGeometry();
+	if (geometry->jointBounds.size() > animator->getJointCount()) {
+		spdlog::warn("Node '{}' uses {} joints but its skin has {}, drawing it in the rest pose",
+			sceneNode->getName(), geometry->jointBounds.size(), animator->getJointCount());
+		return;
+	}
+
+	auto animatedMesh = this->meshManager->createSkinnedMesh(geometry, animator);
+	animatedMesh->setMaterial(skinnedMesh->getMaterial());
+	sceneNode->setMesh(std::move(animatedMesh));
+}
+
 } /// namespace lillugsi::rendering
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "modelloader.h"
 #include "scene/scene.h"
 #include "rendering/mesh.h"
+#include "rendering/meshinstances.h"
+#include "rendering/meshmanager.h"
+#include "rendering/animation/animator.h"
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -29,6 +32,19 @@ public:
 		const ModelData& modelData,
 		const std::vector<std::shared_ptr<Mesh>>& meshes);
 	
+	/// Set the instances of instanced nodes
+	/// The node and the child nodes of its further primitives all draw them
+	/// @param nodeInstances Instances by glTF node index
+	void setNodeInstances(std::unordered_map<int, std::shared_ptr<const MeshInstances>> nodeInstances);
+
+	/// Set the animators of skinned nodes
+	/// The node and the child nodes of its further primitives are moved by the same
+	/// animator, each of their skinned meshes is replaced by an animated one
+	/// @param nodeAnimators Animators by glTF node index
+	/// @param meshManager Manager to create the animated meshes with
+	void setNodeAnimators(std::unordered_map<int, std::shared_ptr<animation::Animator>> nodeAnimators,
+		std::shared_ptr<MeshManager> meshManager);
+
 	/// Build scene graph from the default or first scene in the glTF file
 	/// @param scene The scene to add nodes to
 	/// @param parentNode Parent node to attach the root nodes to
@@ -74,12 +90,25 @@ private:
 	/// @param nodeName The name of the current node
 	/// @param scene The scene to add child nodes to
 	/// @param parentNode Parent node to attach primitive nodes to
+	/// @param instances Instances of the parent node, nullptr if it isn't instanced
+	/// @param animator Animator of the parent node, nullptr if it isn't skinned
 	/// @return True if child nodes were created for primitives
 	bool handlePrimitiveGroups(
 		int meshIndex,
 		const std::string& nodeName,
 		scene::Scene& scene,
-		std::shared_ptr<scene::SceneNode> parentNode);
+		std::shared_ptr<scene::SceneNode> parentNode,
+		const std::shared_ptr<const MeshInstances>& instances,
+		const std::shared_ptr<animation::Animator>& animator);
+
+	/// Replace a node's skinned mesh with one its animator moves
+	/// Nodes without a skinned mesh, or with one using joints the skeleton doesn't
+	/// have, keep drawing what they draw
+	/// @param sceneNode The node drawing the mesh
+	/// @param animator The animator of the node's glTF node
+	void animateNodeMesh(
+		const std::shared_ptr<scene::SceneNode>& sceneNode,
+		const std::shared_ptr<animation::Animator>& animator);
 	
 	/// Reference to the glTF model being processed
 	const tinygltf::Model& gltfModel;
@@ -93,6 +122,13 @@ private:
 	/// Map to track which node corresponds to which modelData node index
 	/// This helps with scene construction and avoids duplicates
 	std::unordered_map<int, std::shared_ptr<scene::SceneNode>> nodeMap;
+
+	/// Instances of instanced nodes by node index
+	std::unordered_map<int, std::shared_ptr<const MeshInstances>> nodeInstances;
+
+	/// Animators of skinned nodes by node index, and the manager creating their meshes
+	std::unordered_map<int, std::shared_ptr<animation::Animator>> nodeAnimators;
+	std::shared_ptr<MeshManager> meshManager;
 };
 
 } /// namespace lillugsi::rendering
\ No newline at end of file
@@ -516,13 +516,17 @@ void PBRMaterial::createDescriptorSetLayout() {
 	/// and use channel masks in the shader to extract the correct values
 	std::array<VkDescriptorSetLayoutBinding, 6> bindings{};
 
+	/// The fragment shader shades forward draws, the compute shader of the
+	/// visibility buffer shades the same material per pixel bin
+	constexpr VkShaderStageFlags MaterialStageFlags =
+		VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+
 	/// Material properties uniform buffer (binding 0)
 	/// This is used for base colors, factors, and texture flags
 	bindings[0].binding = 0;
 	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	bindings[0].descriptorCount = 1;
-	/// Used in fragment shader for PBR calculations
-	bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[0].stageFlags = MaterialStageFlags;
 	bindings[0].pImmutableSamplers = nullptr;
 
 	/// Albedo texture (binding 1)
@@ -530,7 +534,7 @@ void PBRMaterial::createDescriptorSetLayout() {
 	bindings[1].binding = 1;
 	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	bindings[1].descriptorCount = 1;
-	bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[1].stageFlags = MaterialStageFlags;
 	bindings[1].pImmutableSamplers = nullptr;
 
 	/// Normal map texture (binding 2)
@@ -538,9 +542,7 @@ void PBRMaterial::createDescriptorSetLayout() {
 	bindings[2].binding = 2;
 	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	bindings[2].descriptorCount = 1;
-	/// We might use normal mapping in both vertex and fragment shaders in the future,
-	/// but for now we'll keep it in the fragment shader only
-	bindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[2].stageFlags = MaterialStageFlags;
 	bindings[2].pImmutableSamplers = nullptr;
 
 	/// Roughness map texture (binding 3)
@@ -548,7 +550,7 @@ void PBRMaterial::createDescriptorSetLayout() {
 	bindings[3].binding = 3;
 	bindings[3].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	bindings[3].descriptorCount = 1;
-	bindings[3].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[3].stageFlags = MaterialStageFlags;
 	bindings[3].pImmutableSamplers = nullptr;
 
 	/// Metallic map texture (binding 4)
@@ -556,7 +558,7 @@ void PBRMaterial::createDescriptorSetLayout() {
 	bindings[4].binding = 4;
 	bindings[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	bindings[4].descriptorCount = 1;
-	bindings[4].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[4].stageFlags = MaterialStageFlags;
 	bindings[4].pImmutableSamplers = nullptr;
 
 	/// Occlusion map texture (binding 5)
@@ -564,7 +566,7 @@ void PBRMaterial::createDescriptorSetLayout() {
 	bindings[5].binding = 5;
 	bindings[5].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
 	bindings[5].descriptorCount = 1;
-	bindings[5].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	bindings[5].stageFlags = MaterialStageFlags;
 	bindings[5].pImmutableSamplers = nullptr;
 
 	/// Create the descriptor set layout with all our bindings
@@ -30,6 +30,8 @@ public:
 	/// which can be overridden in the constructor if needed
 	static constexpr const char* DefaultVertexShaderPath = "shaders/pbr.vert.spv";
 	static constexpr const char* DefaultFragmentShaderPath = "shaders/pbr.frag.spv";
+	/// The default vertex shader compiled with per-instance transforms
+	static constexpr const char* InstancedVertexShaderPath = "shaders/pbrinstanced.vert.spv";
 
 	/// Create a new PBR material
 	/// @param device The logical device for creating GPU resources
@@ -50,6 +52,25 @@ public:
 	/// @return Shader paths configuration for PBR pipeline creation
 	[[nodiscard]] ShaderPaths getShaderPaths() const override;
 
+	/// The default PBR shader skips normal, occlusion and surface maps at lower LODs
+	/// Custom shaders may not know the LOD constant, so they keep a single level
+	/// @return MaterialLodCount for the default shader, 1 otherwise
+	[[nodiscard]] uint32_t getLodCount() const override {
+		return this->fragmentShaderPath == DefaultFragmentShaderPath ? MaterialLodCount : 1;
+	}
+
+	/// The default PBR vertex shader dequantizes QuantizedVertex meshes
+	/// @return True for the default vertex shader
+	[[nodiscard]] bool supportsQuantizedVertices() const override {
+		return this->vertexShaderPath == DefaultVertexShaderPath;
+	}
+
+	/// The default PBR vertex shader has an instanced build
+	/// @return The instanced shader for the default vertex shader, empty for custom shaders
+	[[nodiscard]] std::string getInstancedVertexShaderPath() const override {
+		return this->vertexShaderPath == DefaultVertexShaderPath ? InstancedVertexShaderPath : "";
+	}
+
 	/// Set the base color of the material
 	/// @param color RGB color with alpha
 	void setBaseColor(const glm::vec4& color);
@@ -1,16 +1,22 @@
 #include "renderer.h"
 #include "rendering/cubemesh.h"
 #include "rendering/icospheremesh.h"
+#include "vulkan/colortarget.h"
 #include "terrainmaterial.h"
 #include "vulkan/indexbuffer.h"
 #include "vulkan/vertexbuffer.h"
+#include "vulkan/vulkanformatters.h"
 #ifdef USE_PLANET
 #include <planet/datasettingvisitor.h>
 #include <planet/planetgenerator.h>
 #endif
 
 #include <SDL3/SDL_vulkan.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <fstream>
+#include <unordered_set>
 #include <glm/gtc/matrix_transform.hpp>
 #include <spdlog/spdlog.h>
 
@@ -35,6 +41,43 @@ static std::vector<char> readFile(const std::string& filename) {
 
 namespace lillugsi::rendering {
 
+namespace {
+/// Equirectangular HDR image lighting the scene, and where its baked form is stored
+constexpr const char* EnvironmentMapPath = "resources/environment/environment.hdr";
+constexpr const char* EnvironmentCacheDirectory = "cache/environment";
+
+/// Where generated terrain chunks are kept between runs
+constexpr const char* TerrainCacheDirectory = "cache/terrain";
+
+/// Detail of the noise displaced sphere, 655,362 vertices displaced on the GPU
+constexpr uint32_t DisplacedSphereSubdivisions = 8;
+
+/// Fraction of the screen height a draw's bounding sphere must cover for each material LOD
+/// Below ReducedLodCoverage normal maps no longer show, below MinimalLodCoverage an
+/// object is only a few dozen pixels tall and its surface maps blur into the base values
+constexpr float ReducedLodCoverage = 0.1f;
+constexpr float MinimalLodCoverage = 0.025f;
+
+/// Time per update spent streaming progressive models
+/// A mesh or a material's textures can take longer than this, at least one is always done
+constexpr std::chrono::microseconds ProgressiveLoadBudget{4000};
+
+/// Time between checks for models the scene released, which the model cache then trims
+/// Released models only free memory once a trim notices them, a trim is a pass over the cache
+constexpr std::chrono::milliseconds ModelCacheTrimInterval{500};
+
+/// Collect the names of the materials a subtree's meshes draw with
+void collectMaterialNames(const scene::SceneNode& node, std::unordered_set<std::string>& names) {
+	const auto mesh = node.getMesh();
+	if (mesh && mesh->getMaterial()) {
+		names.insert(mesh->getMaterial()->getName());
+	}
+	for (const auto& child : node.getChildren()) {
+		collectMaterialNames(*child, names);
+	}
+}
+}
+
 Renderer::Renderer()
 	: vulkanContext(std::make_unique<vulkan::VulkanContext>())
 	, width(0)
@@ -65,10 +108,19 @@ bool Renderer::initialize(SDL_Window* window) {
 		/// Get window size
 		SDL_GetWindowSizeInPixels(window, reinterpret_cast<int*>(&this->width),
 			reinterpret_cast<int*>(&this->height));
+		this->aspectRatio = static_cast<float>(this->width) / static_cast<float>(this->height);
+
+		/// Remember the surface's present modes for switching at runtime
+		/// The surface outlives every swap chain, so this list never changes
+		this->supportedPresentModes = this->vulkanContext->getSwapChain()->getSupportedPresentModes();
+		this->presentMode = this->vulkanContext->getSwapChain()->getPresentMode();
 
 		/// Initialize depth buffer
 		this->initializeDepthBuffer();
 
+		/// Initialize the offscreen target the scene is rendered into
+		this->initializeSceneColorTarget();
+
 		/// Create render pass
 		this->createRenderPass();
 
@@ -85,6 +137,12 @@ bool Renderer::initialize(SDL_Window* window) {
 			this->vulkanContext->getDevice()->getGraphicsQueueFamilyIndex(),
 			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
 
+		/// Create a separate pool for texture uploads
+		/// Frames are recorded on the render thread while textures upload elsewhere
+		this->uploadCommandPool = this->commandBufferManager->createCommandPool(
+			this->vulkanContext->getDevice()->getGraphicsQueueFamilyIndex(),
+			VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+
 		/// Initialize pipeline manager
 		/// This needs to happen before materials are created
 		/// as they depend on the global descriptor layouts
@@ -119,30 +177,17 @@ bool Renderer::initialize(SDL_Window* window) {
 		this->textureManager = std::make_unique<rendering::TextureManager>(
 			this->vulkanContext->getDevice()->getDevice(),
 			this->vulkanContext->getPhysicalDevice(),
-			this->commandPool,
+			this->uploadCommandPool,
 			this->vulkanContext->getDevice()->getGraphicsQueue(),
 			this->commandBufferManager
 		);
 
-		this->commandBufferManager = std::make_shared<vulkan::CommandBufferManager>(
-			this->vulkanContext->getDevice()->getDevice());
-		if (!this->commandBufferManager->initialize()) {
-			spdlog::error("Failed to initialize command buffer manager");
-			return false;
-		}
-
-		/// Create main command pool for rendering operations
-		/// The CommandBufferManager maintains ownership of the pool
-		this->commandPool = this->commandBufferManager->createCommandPool(
-			this->vulkanContext->getDevice()->getGraphicsQueueFamilyIndex(),
-			VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-
 		/// Create camera uniform buffer
 		this->createCameraUniformBuffer();
 
-		/// Initialize light management and buffer
+		/// Initialize light management and buffers
 		this->lightManager = std::make_unique<LightManager>();
-		this->createLightUniformBuffer();
+		this->createLightBuffers();
 
 		/// Create descriptor pool
 		this->createDescriptorPool();
@@ -175,17 +220,37 @@ bool Renderer::initialize(SDL_Window* window) {
 			return false;
 		}
 
+		/// Set up the pass that upscales the scene into the swap chain
+		this->upscalePass = std::make_unique<UpscalePass>(this->vulkanContext->getDevice()->getDevice());
+		this->upscalePass->initialize(this->vulkanContext->getSwapChain()->getSwapChainImageFormat());
+
 		/// Create framebuffers
-		this->framebufferManager->createSwapChainFramebuffers(
-			this->renderPass.get(),
-			this->vulkanContext->getSwapChain()->getSwapChainImageViews(),
-			this->depthBuffer->getImageView(),
-			this->vulkanContext->getSwapChain()->getSwapChainExtent().width,
-			this->vulkanContext->getSwapChain()->getSwapChainExtent().height
-		);
+		this->createFramebuffers();
+
+		/// The visibility buffer shares the depth buffer and global descriptor layouts with
+		/// the forward path. It is always created so it can be toggled at runtime
+		this->visibilityBuffer = std::make_unique<VisibilityBuffer>(
+			this->vulkanContext->getDevice()->getDevice(),
+			this->vulkanContext->getPhysicalDevice());
+		this->visibilityBuffer->initialize(
+			this->vulkanContext->getSwapChain()->getSwapChainImageFormat(),
+			this->depthBuffer->getFormat(),
+			this->pipelineManager->getCameraDescriptorLayout(),
+			this->pipelineManager->getLightDescriptorLayout());
+		this->visibilityBuffer->resize(this->width, this->height, this->depthBuffer->getImageView());
+
+		/// GPU timestamps drive the render scale
+		/// Without them we still render offscreen, just always at full scale
+		this->gpuTimer = std::make_unique<vulkan::GpuTimer>(
+			this->vulkanContext->getDevice()->getDevice(),
+			this->vulkanContext->getPhysicalDevice(),
+			this->vulkanContext->getDevice()->getGraphicsQueueFamilyIndex());
+		if (!this->gpuTimer->initialize()) {
+			spdlog::warn("Dynamic resolution disabled, GPU timing is not available");
+		}
 
-		/// Record command buffers
-		this->recordCommandBuffers();
+		/// Command buffers are recorded per frame from the published snapshots,
+		/// so there is nothing to record here yet
 
 		/// Create synchronization objects
 		this->createSyncObjects();
@@ -204,22 +269,41 @@ void Renderer::cleanup() {
 		return; /// Already cleaned up, do nothing
 	}
 
+	/// Stop the render thread first so nothing records or submits while we tear down
+	this->stopRenderThread();
+
 	/// Ensure all GPU operations are completed before cleanup
 	/// This prevents destroying resources that might still be in use by the GPU,
 	/// which could lead to crashes or undefined behavior. It's a critical
 	/// synchronization point between the CPU and GPU.
+	/// Loader threads may still submit until they are stopped below
 	if (this->vulkanContext) {
+		std::unique_lock<std::mutex> queueLock;
+		if (this->commandBufferManager) {
+			queueLock = this->commandBufferManager->lockQueue();
+		}
 		vkDeviceWaitIdle(this->vulkanContext->getDevice()->getDevice());
 	}
 
 	/// Clean up model loading components first
-	/// These need to be destroyed before the resources they depend on
+	/// These need to be destroyed before the resources they depend on.
+	/// The prefetcher's worker loads through the model and texture managers, it stops first
+	this->assetPrefetcher.reset();
 	this->pipelineFactory.reset();
 	this->materialMapper.reset();
 	this->textureLoader.reset();
 
+	this->sphereDisplacement.reset();
+	this->skinningPass.reset();
+
+	/// The terrain holds on to its material, the streamer's workers stop first
+	this->terrainStreamer.reset();
+	this->terrainQuadtree.reset();
+
 	/// Clean up light resources
-	this->lightBuffer.reset();
+	this->environmentLighting.reset();
+	this->shadowCascades.reset();
+	this->clusteredLighting.reset();
 	this->lightManager.reset();
 
 	/// Clean up materials before scene
@@ -230,6 +314,7 @@ void Renderer::cleanup() {
 	/// Clean up scene first as it might hold GPU resources
 	/// This ensures proper cleanup order and avoids dangling references
 	this->texturedCubeNode.reset();
+	this->displacedSphereNode.reset();
 	this->scene.reset();
 
 	/// Clean up synchronization objects
@@ -254,9 +339,8 @@ void Renderer::cleanup() {
 		this->descriptorPool = VK_NULL_HANDLE;
 	}
 
-	/// Clean up camera and light uniform buffers
+	/// Clean up camera uniform buffer
 	this->cameraBuffer.reset();
-	this->lightBuffer.reset();
 
 	/// Clean up buffer manager before mesh manager
 	/// This ensures proper resource cleanup order
@@ -277,13 +361,22 @@ void Renderer::cleanup() {
 		this->meshManager.reset();
 	}
 
-	/// Null the command pool
+	/// Null the command pools
 	this->commandPool = nullptr;
+	this->uploadCommandPool = nullptr;
 
 	/// Clean up framebuffers
 	this->cleanupFramebuffers();
 	this->framebufferManager.reset();
 
+	/// The visibility buffer references the depth buffer, so it goes first
+	this->visibilityBuffer.reset();
+
+	/// Clean up dynamic resolution resources
+	this->upscalePass.reset();
+	this->gpuTimer.reset();
+	this->sceneColorTarget.reset();
+
 	/// Clean up depth buffer
 	this->depthBuffer.reset();
 
@@ -300,12 +393,30 @@ void Renderer::cleanup() {
 }
 
 void Renderer::drawFrame() {
+	/// Apply resize and screenshot requests from other threads first
+	/// Swap chain recreation must not overlap with frame recording
+	this->processPendingRequests();
+
 	/// Wait for the previous frame to finish
-	/// This ensures that we're not using resources that may still be in use by the GPU
+	/// This ensures that we're not using resources that may still be in use by the GPU.
+	/// We wait before acquiring the next snapshot: acquiring releases the previous
+	/// snapshot slot to the update thread, and with it the last references to
+	/// buffers the GPU might otherwise still be reading
 	VK_CHECK(vkWaitForFences(this->vulkanContext->getDevice()->getDevice(), 1, &this->inFlightFence, VK_TRUE, UINT64_MAX));
 
-	/// Reset the fence to the unsignaled state for use in the current frame
-	VK_CHECK(vkResetFences(this->vulkanContext->getDevice()->getDevice(), 1, &this->inFlightFence));
+	/// The previous frame is done, so its GPU time is available now
+	this->updateRenderScale();
+
+	/// Its vertex buffer too, the first sphere displacement can be read back
+	this->sphereDisplacement->checkFirstDisplacement();
+
+	/// Take the latest simulation state
+	/// The timeout keeps the render thread responsive to shutdown and requests
+	/// when the update thread stalls or nothing new has been published
+	const FrameSnapshot* snapshot = this->snapshotBuffer.acquire(std::chrono::milliseconds(100));
+	if (!snapshot) {
+		return;
+	}
 
 	/// Acquire an image from the swap chain
 	uint32_t imageIndex;
@@ -327,13 +438,25 @@ void Renderer::drawFrame() {
 		throw vulkan::VulkanException(result, "Failed to acquire swap chain image", __FUNCTION__, __FILE__, __LINE__);
 	}
 
-	/// Update uniform buffer with current camera data
-	this->updateCameraUniformBuffer();
+	/// Reset the fence only once we know we will submit work that signals it
+	/// Resetting before an early return would leave the next wait hanging forever
+	VK_CHECK(vkResetFences(this->vulkanContext->getDevice()->getDevice(), 1, &this->inFlightFence));
 
-	this->updateLightUniformBuffer();
+	/// Update uniform buffers with the snapshot's camera and light data
+	this->updateCameraUniformBuffer(*snapshot);
+	this->updateLightBuffers(*snapshot);
+
+	/// Select the terrain nodes for the snapshot's camera
+	/// Chunks are prioritized for the camera in the planet's object space
+	if (this->terrainEnabled.load()) {
+		this->terrainQuadtree->update(*snapshot);
+		const glm::vec4 viewPoint = glm::inverse(this->terrainQuadtree->getTransform())
+			* glm::vec4(snapshot->cameraPosition, 1.0f);
+		this->terrainStreamer->update(glm::vec3(viewPoint));
+	}
 
-	/// Record command buffers with current scene state
-	this->recordCommandBuffers();
+	/// Record the command buffer for this image from the snapshot's draw packets
+	this->recordCommandBuffer(imageIndex, *snapshot);
 
 	/// Set up the submit info struct
 	VkSubmitInfo submitInfo{};
@@ -354,9 +477,6 @@ void Renderer::drawFrame() {
 	submitInfo.signalSemaphoreCount = 1;
 	submitInfo.pSignalSemaphores = &this->renderFinishedSemaphore;
 
-	/// Submit the command buffer
-	VK_CHECK(vkQueueSubmit(this->vulkanContext->getDevice()->getGraphicsQueue(), 1, &submitInfo, this->inFlightFence));
-
 	/// Set up the present info struct
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -368,8 +488,16 @@ void Renderer::drawFrame() {
 	presentInfo.pSwapchains = swapChains;
 	presentInfo.pImageIndices = &imageIndex;
 
-	/// Present the image to the screen
-	result = vkQueuePresentKHR(this->vulkanContext->getDevice()->getPresentQueue(), &presentInfo);
+	{
+		/// Other threads submit transfers to the same queue
+		auto queueLock = this->commandBufferManager->lockQueue();
+
+		/// Submit the command buffer
+		VK_CHECK(vkQueueSubmit(this->vulkanContext->getDevice()->getGraphicsQueue(), 1, &submitInfo, this->inFlightFence));
+
+		/// Present the image to the screen
+		result = vkQueuePresentKHR(this->vulkanContext->getDevice()->getPresentQueue(), &presentInfo);
+	}
 
 	/// Store the presented image index for screenshot use
 	if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
@@ -406,18 +534,242 @@ void Renderer::update(float deltaTime) {
 	/// Camera movement and transitions use game-scaled time
 	this->camera->update(deltaTime);
 
+	/// Pose the animated characters, spread over worker threads when there are many
+	this->meshManager->getAnimationSystem().update(deltaTime);
+
+	/// Stream progressive models for the updated camera, before buffer updates and
+	/// the snapshot pick up what was streamed. Streamed materials need pipelines
+	if (this->modelManager && this->modelManager->hasProgressiveLoads()) {
+		const glm::mat4 projection = this->camera->getProjectionMatrix(this->aspectRatio.load());
+		const ProgressiveModel::View view{this->camera->getPosition(), std::abs(projection[1][1])};
+		if (this->modelManager->updateProgressiveLoads(view, ProgressiveLoadBudget)) {
+			this->requestPipelines(this->scene->getRoot());
+		}
+	}
+
+	/// Queue the manifest assets around the updated camera
+	if (this->assetPrefetcher) {
+		this->assetPrefetcher->update(this->camera->getPosition());
+	}
+
+	/// Levels unload models without loading new ones, so we trim without waiting for a load
+	const auto now = std::chrono::steady_clock::now();
+	if (this->modelManager && now - this->lastModelCacheTrim >= ModelCacheTrimInterval) {
+		this->modelManager->trimCache();
+		this->lastModelCacheTrim = now;
+	}
+
 	/// Check for meshes that need buffer updates
 	/// We do this after scene update to catch any changes
+	/// Replaced buffers stay alive through the snapshot still being rendered,
+	/// so edits show up one frame later without stalling the render thread
 	this->scene->forEachMesh([this](const std::shared_ptr<Mesh>& mesh) {
 		if (mesh && mesh->needsBufferUpdate()) {
 			this->meshManager->updateBuffersIfNeeded(mesh);
 		}
 	});
+
+	/// Hand the finished simulation state to the render thread
+	FrameSnapshot& snapshot = this->snapshotBuffer.beginWrite();
+	snapshot.frameIndex = this->nextSnapshotIndex++;
+	snapshot.deltaTime = deltaTime;
+	this->buildFrameSnapshot(snapshot);
+	this->snapshotBuffer.publish();
+}
+
+void Renderer::buildFrameSnapshot(FrameSnapshot& snapshot) const {
+	/// Capture the camera with the aspect ratio of the current swap chain
+	snapshot.view = this->camera->getViewMatrix();
+	snapshot.projection = this->camera->getProjectionMatrix(this->aspectRatio.load());
+	snapshot.cameraPosition = this->camera->getPosition();
+	snapshot.nearPlane = this->camera->getNearPlane();
+	snapshot.farPlane = this->camera->getFarPlane();
+
+	/// Collect culled draw packets with baked world transforms
+	/// getRenderData clears the vector but keeps its capacity from earlier frames
+	this->scene->getRenderData(*this->camera, snapshot.drawPackets);
+
+	/// Pick each draw's material LOD from the height its bounds cover on screen
+	/// projection[1][1] is 1 / tan(fov / 2), so this is the sphere's projected radius
+	/// relative to half the screen height. Draws without bounds keep the full material
+	const float projectionScale = std::abs(snapshot.projection[1][1]);
+	for (auto& packet : snapshot.drawPackets) {
+		if (packet.boundsRadius <= 0.0f) {
+			continue;
+		}
+		const float distance = glm::length(packet.boundsCenter - snapshot.cameraPosition);
+		if (distance <= packet.boundsRadius) {
+			packet.materialLod = MaterialLod::Full;
+			continue;
+		}
+		const float coverage = packet.boundsRadius * projectionScale / distance;
+		if (coverage >= ReducedLodCoverage) {
+			packet.materialLod = MaterialLod::Full;
+		} else if (coverage >= MinimalLodCoverage) {
+			packet.materialLod = MaterialLod::Reduced;
+		} else {
+			packet.materialLod = MaterialLod::Minimal;
+		}
+	}
+
+	/// Copy the light data so later light edits don't affect this frame
+	this->lightManager->getLightData(snapshot.lights);
+	snapshot.directionalLightCount = this->lightManager->getDirectionalLightCount();
+
+	/// Take the palettes posed in this step along, the skinning pass uploads them
+	this->meshManager->getAnimationSystem().collectSkinning(
+		snapshot.jointPalettes, snapshot.skinning, SkinningPass::MaxPaletteJoints);
+
+	/// Collect the casters of the primary light, including those outside the view
+	snapshot.staticRevision = scene::SceneNode::getStaticRevision();
+	const scene::BoundingBox& sceneBounds = this->scene->getRoot()->getWorldBounds();
+	if (snapshot.directionalLightCount > 0 && sceneBounds.isValid()) {
+		const glm::mat4 casterVolume = ShadowCascades::computeCasterVolume(
+			snapshot.view,
+			snapshot.projection,
+			snapshot.nearPlane,
+			snapshot.farPlane,
+			glm::vec3(snapshot.lights[0].direction),
+			sceneBounds.getMin(),
+			sceneBounds.getMax());
+		this->scene->getShadowCasters(scene::Frustum::createFromMatrix(casterVolume), snapshot.shadowCasters);
+	} else {
+		snapshot.shadowCasters.clear();
+	}
+}
+
+void Renderer::startRenderThread() {
+	if (this->renderThreadRunning) {
+		spdlog::warn("Render thread is already running");
+		return;
+	}
+
+	this->snapshotBuffer.reset();
+	this->renderThreadRunning = true;
+	this->renderThread = std::thread(&Renderer::renderThreadMain, this);
+
+	spdlog::info("Render thread started");
+}
+
+void Renderer::stopRenderThread() {
+	this->renderThreadRunning = false;
+
+	/// Wake the render thread if it waits for a snapshot,
+	/// and the update thread if it waits for a frame slot
+	this->snapshotBuffer.stop();
+
+	if (this->renderThread.joinable()) {
+		this->renderThread.join();
+		spdlog::info("Render thread stopped");
+	}
+}
+
+void Renderer::waitForFrameSlot() {
+	this->snapshotBuffer.waitUntilConsumed();
+}
+
+void Renderer::renderThreadMain() {
+	try {
+		while (this->renderThreadRunning) {
+			this->drawFrame();
+		}
+	}
+	catch (const vulkan::VulkanException& e) {
+		spdlog::error("Vulkan error on render thread: {}", e.what());
+	}
+	catch (const std::exception& e) {
+		spdlog::error("Error on render thread: {}", e.what());
+	}
+
+	/// Make sure a failing render thread never leaves the update thread waiting
+	this->renderThreadRunning = false;
+	this->snapshotBuffer.stop();
+}
+
+void Renderer::requestSwapChainRecreation(uint32_t newWidth, uint32_t newHeight) {
+	std::lock_guard<std::mutex> lock(this->requestMutex);
+	this->swapChainRecreationRequested = true;
+	this->requestedWidth = newWidth;
+	this->requestedHeight = newHeight;
+}
+
+void Renderer::requestPresentMode(VkPresentModeKHR mode) {
+	if (!this->isPresentModeSupported(mode)) {
+		spdlog::warn("Present mode {} is not supported by the surface", mode);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(this->requestMutex);
+	this->presentModeChangeRequested = true;
+	this->requestedPresentMode = mode;
+}
+
+bool Renderer::isPresentModeSupported(VkPresentModeKHR mode) const {
+	return std::find(this->supportedPresentModes.begin(), this->supportedPresentModes.end(), mode)
+		!= this->supportedPresentModes.end();
+}
+
+void Renderer::requestScreenshot(const std::string& filename) {
+	std::lock_guard<std::mutex> lock(this->requestMutex);
+	this->pendingScreenshotFilename = filename;
+}
+
+void Renderer::processPendingRequests() {
+	bool recreate = false;
+	uint32_t newWidth = 0;
+	uint32_t newHeight = 0;
+	bool changePresentMode = false;
+	VkPresentModeKHR newPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+	std::string screenshotFilename;
+	std::unordered_set<std::string> pipelineMaterials;
+
+	/// Take the requests under the lock, but run them without holding it
+	{
+		std::lock_guard<std::mutex> lock(this->requestMutex);
+		recreate = this->swapChainRecreationRequested;
+		newWidth = this->requestedWidth;
+		newHeight = this->requestedHeight;
+		this->swapChainRecreationRequested = false;
+		changePresentMode = this->presentModeChangeRequested;
+		newPresentMode = this->requestedPresentMode;
+		this->presentModeChangeRequested = false;
+		screenshotFilename.swap(this->pendingScreenshotFilename);
+		pipelineMaterials.swap(this->pendingPipelineMaterials);
+	}
+
+	/// Pipelines for models loaded since the last frame
+	/// The snapshot drawn next may already contain them
+	if (!pipelineMaterials.empty() && !this->createMissingPipelines(pipelineMaterials)) {
+		spdlog::warn("Some pipelines could not be created");
+	}
+
+	/// The present mode is fixed at swap chain creation, so switching it means
+	/// recreating the swap chain at its current size
+	if (changePresentMode && newPresentMode != this->presentMode.load()) {
+		this->presentMode = newPresentMode;
+		if (!recreate) {
+			recreate = true;
+			newWidth = this->width;
+			newHeight = this->height;
+		}
+	}
+
+	/// A minimized window reports a zero extent, which is not a valid swap chain size
+	if (recreate && newWidth > 0 && newHeight > 0) {
+		this->recreateSwapChain(newWidth, newHeight);
+	}
+
+	if (!screenshotFilename.empty()) {
+		this->captureScreenshot(screenshotFilename);
+	}
 }
 
 bool Renderer::recreateSwapChain(uint32_t newWidth, uint32_t newHeight) {
 	try {
+		/// Loader threads submit to the graphics queue too, waiting for the device
+		/// needs it externally synchronized like a submit
 		if (this->vulkanContext->getDevice()) {
+			auto queueLock = this->commandBufferManager->lockQueue();
 			vkDeviceWaitIdle(this->vulkanContext->getDevice()->getDevice());
 		}
 
@@ -438,29 +790,44 @@ bool Renderer::recreateSwapChain(uint32_t newWidth, uint32_t newHeight) {
 		/// but if our render pass configuration depends on the swap chain format,
 		/// we might need to recreate it here.
 
-		this->vulkanContext->createSwapChain(this->width, this->height);
+		this->vulkanContext->createSwapChain(this->width, this->height, this->presentMode.load());
+
+		/// The surface may have refused the mode, so we report what we actually got
+		this->presentMode = this->vulkanContext->getSwapChain()->getPresentMode();
 
-		/// Recreate depth buffer with new dimensions
+		/// Recreate depth buffer and scene color target with new dimensions
 		this->depthBuffer->initialize(this->width, this->height);
+		this->sceneColorTarget->initialize(this->width, this->height,
+			this->vulkanContext->getSwapChain()->getSwapChainImageFormat());
 
 		/// Recreate framebuffers using the manager
 		this->framebufferManager->recreateSwapChainFramebuffers(
-			this->renderPass.get(),
+			this->upscalePass->getRenderPass(),
 			this->vulkanContext->getSwapChain()->getSwapChainImageViews(),
+			VK_NULL_HANDLE,
+			this->width,
+			this->height
+		);
+		this->framebufferManager->createOffscreenFramebuffer(
+			this->renderPass.get(),
+			this->sceneColorTarget->getImageView(),
 			this->depthBuffer->getImageView(),
 			this->width,
 			this->height
 		);
+		this->upscalePass->setSource(this->sceneColorTarget->getImageView());
+		this->visibilityBuffer->resize(this->width, this->height, this->depthBuffer->getImageView());
 
-		/// Recreate command buffers
-		this->recordCommandBuffers();
+		/// Recreate command buffers for the new swap chain images
+		/// They are recorded per frame, so allocating them is enough here
+		this->createCommandBuffers();
 
 		/// Update camera aspect ratio
-		/// This ensures proper projection after resize
-		float aspectRatio = static_cast<float>(this->width) / static_cast<float>(this->height);
-		glm::mat4 projection = this->camera->getProjectionMatrix(aspectRatio);
+		/// The update thread reads this for the projection of its next snapshot
+		this->aspectRatio = static_cast<float>(this->width) / static_cast<float>(this->height);
 
-		spdlog::info("Swap chain recreated with dimensions {}x{}", this->width, this->height);
+		spdlog::info("Swap chain recreated with dimensions {}x{} and present mode {}",
+			this->width, this->height, this->presentMode.load());
 		return true;
 	}
 	catch (const vulkan::VulkanException& e) {
@@ -496,12 +863,75 @@ std::shared_ptr<scene::SceneNode> Renderer::loadModel(
 	this->textureLoader->waitForAll();
 
 	/// Step 3: Create pipelines for all materials in the model
-	/// We iterate through all materials created during model loading
-	/// and ensure each has a corresponding pipeline
+	/// Once the render thread runs they are created there before its next frame,
+	/// missing pipelines are handled with fallbacks until then
+	this->requestPipelines(modelNode);
+
+	/// Step 4: Update bounds on the model node
+	/// This ensures proper frustum culling and visibility testing
+	modelNode->updateBoundsIfNeeded();
+
+	spdlog::info("Model loaded successfully: {}", filePath);
+	return modelNode;
+}
+
+std::shared_ptr<scene::SceneNode> Renderer::loadModelProgressive(
+	const std::string& filePath, std::shared_ptr<scene::SceneNode> parentNode) {
+	/// Default to scene root if no parent node specified
+	if (!parentNode) {
+		parentNode = this->scene->getRoot();
+	}
+
+	spdlog::info("Streaming model: {}", filePath);
+
+	/// Only the hierarchy and the placeholder materials exist at this point
+	auto modelNode = this->modelManager->loadModelProgressive(filePath, *this->scene, parentNode);
+	if (!modelNode) {
+		spdlog::error("Failed to load model: {}", filePath);
+		return nullptr;
+	}
+
+	this->requestPipelines(modelNode);
+	modelNode->updateBoundsIfNeeded();
+	return modelNode;
+}
+
+bool Renderer::loadAssetManifest(const std::string& filePath) {
+	/// Missing if the model manager failed to initialize
+	if (!this->assetPrefetcher) {
+		return false;
+	}
+
+	const auto manifest = AssetManifest::load(filePath);
+	if (!manifest) {
+		return false;
+	}
+
+	this->assetPrefetcher->addManifest(*manifest);
+	return true;
+}
+
+void Renderer::requestPipelines(const std::shared_ptr<scene::SceneNode>& root) {
+	std::unordered_set<std::string> materialNames;
+	collectMaterialNames(*root, materialNames);
+
+	/// Before the render thread starts, the calling thread is the only one drawing
+	if (!this->renderThreadRunning.load()) {
+		if (!this->createMissingPipelines(materialNames)) {
+			spdlog::warn("Some pipelines could not be created");
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(this->requestMutex);
+	this->pendingPipelineMaterials.insert(materialNames.begin(), materialNames.end());
+}
+
+bool Renderer::createMissingPipelines(const std::unordered_set<std::string>& materialNames) {
 	bool allPipelinesCreated = true;
 
 	/// For each newly loaded material, create a pipeline
-	for (const auto &[name, material] : this->materialManager->getMaterials()) {
+	for (const auto& name : materialNames) {
 		/// Skip materials that already have pipelines
 		if (this->pipelineFactory->hasPipeline(name)) {
 			continue;
@@ -514,17 +944,7 @@ std::shared_ptr<scene::SceneNode> Renderer::loadModel(
 		}
 	}
 
-	if (!allPipelinesCreated) {
-		spdlog::warn("Some pipelines could not be created for model: {}", filePath);
-		/// Continue anyway - missing pipelines will be handled with fallbacks
-	}
-
-	/// Step 4: Update bounds on the model node
-	/// This ensures proper frustum culling and visibility testing
-	modelNode->updateBoundsIfNeeded();
-
-	spdlog::info("Model loaded successfully: {}", filePath);
-	return modelNode;
+	return allPipelinesCreated;
 }
 
 std::future<std::shared_ptr<scene::SceneNode>> Renderer::loadModelAsync(
@@ -554,7 +974,9 @@ bool Renderer::captureScreenshot(const std::string& filename) {
 	}
 
 	/// Wait for the device to finish rendering before capturing
-	/// This ensures we have a complete frame
+	/// This ensures we have a complete frame. The capture submits a copy to the
+	/// graphics queue, the queue stays locked from the wait until it is done
+	auto queueLock = this->commandBufferManager->lockQueue();
 	vkDeviceWaitIdle(this->vulkanContext->getDevice()->getDevice());
 
 	/// We need to keep track of which image index was last presented
@@ -595,15 +1017,16 @@ void Renderer::createCommandBuffers() {
 void Renderer::createRenderPass() {
 	/// Color attachment description
 	/// This describes how the color buffer will be used throughout the render pass
+	/// The scene renders into the offscreen color target, which uses the swap chain format
 	VkAttachmentDescription colorAttachment{};
 	colorAttachment.format = this->vulkanContext->getSwapChain()->getSwapChainImageFormat();
 	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT; /// No multisampling
 	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR; /// Clear the color buffer at the start of the render pass
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; /// Store the result for later use (e.g., presentation)
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE; /// Store the result for the upscale pass
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; /// We're not using stencil buffer for color attachment
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED; /// We don't care about the initial layout
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; /// The image will be presented in the swap chain
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; /// The upscale pass samples the image
 
 	/// Depth attachment description
 	/// This describes how the depth buffer will be used throughout the render pass
@@ -649,13 +1072,13 @@ void Renderer::createRenderPass() {
 	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 	dependencies[0].dependencyFlags = 0; /// Not needed, we're doing straightforward rendering without any special case
 
-	/// Second dependency: Wait for rendering to finish before presenting
+	/// Second dependency: Wait for rendering to finish before the upscale pass samples the image
 	dependencies[1].srcSubpass = 0; /// Our subpass index
 	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL; /// Dependency on operations outside the render pass
 	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	dependencies[1].dstAccessMask = 0; /// No access in the destination subpass
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 	dependencies[1].dependencyFlags = 0; /// Not needed, we're doing straightforward rendering without any special case
 
 	/// Combine attachments
@@ -687,13 +1110,27 @@ void Renderer::createRenderPass() {
 void Renderer::createFramebuffers() {
 	/// Delegate framebuffer creation to the FramebufferManager
 	/// This centralizes framebuffer management and reduces Renderer's responsibilities
+	/// The scene renders into the offscreen framebuffer, the swap chain framebuffers
+	/// only receive the upscaled result and need no depth
+	const VkExtent2D extent = this->vulkanContext->getSwapChain()->getSwapChainExtent();
+
 	this->framebufferManager->createSwapChainFramebuffers(
-		this->renderPass.get(),
+		this->upscalePass->getRenderPass(),
 		this->vulkanContext->getSwapChain()->getSwapChainImageViews(),
+		VK_NULL_HANDLE,
+		extent.width,
+		extent.height
+	);
+
+	this->framebufferManager->createOffscreenFramebuffer(
+		this->renderPass.get(),
+		this->sceneColorTarget->getImageView(),
 		this->depthBuffer->getImageView(),
-		this->vulkanContext->getSwapChain()->getSwapChainExtent().width,
-		this->vulkanContext->getSwapChain()->getSwapChainExtent().height
+		extent.width,
+		extent.height
 	);
+
+	this->upscalePass->setSource(this->sceneColorTarget->getImageView());
 }
 
 void Renderer::cleanupFramebuffers() {
@@ -721,169 +1158,235 @@ vulkan::VulkanShaderModuleHandle Renderer::createShaderModule(const std::vector<
 	});
 }
 
-void Renderer::recordCommandBuffers() {
-	/// Resize command buffers vector to match the number of framebuffers
-	/// We need one command buffer for each swap chain image
-	/// Start with clean command buffers
-	/// Free existing command buffers if any exist
-	if (!this->commandBuffers.empty()) {
-		this->commandBufferManager->freeCommandBuffers(
-			this->commandPool,
-			this->commandBuffers);
+void Renderer::recordCommandBuffer(uint32_t imageIndex, const FrameSnapshot& snapshot) {
+	/// We only record the command buffer of the acquired image
+	/// The pool allows resetting individual buffers, and vkBeginCommandBuffer resets it implicitly.
+	/// The in-flight fence has been waited on, so the GPU no longer uses this buffer
+	VkCommandBuffer commandBuffer = this->commandBuffers[imageIndex];
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+	VK_CHECK(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+	/// Time the whole frame on the GPU, the render scale is derived from it
+	this->gpuTimer->begin(commandBuffer);
+
+	/// Mesh edits queued since the last frame land in their buffers before anything draws
+	this->meshManager->recordBufferUploads(commandBuffer);
+
+	/// Displace the sphere before the shadow maps and the scene draw it
+	this->sphereDisplacement->record(commandBuffer);
+
+	/// Skin the animated characters for the same reason
+	this->skinningPass->record(commandBuffer, snapshot);
+
+	/// The scene is rendered into the top-left part of the offscreen target
+	/// Scaling both axes equally keeps the aspect ratio and the projection unchanged
+	const VkExtent2D swapChainExtent = this->vulkanContext->getSwapChain()->getSwapChainExtent();
+	const VkExtent2D targetExtent = this->sceneColorTarget->getExtent();
+	const float scale = this->renderScale.load();
+	VkExtent2D renderExtent;
+	renderExtent.width = std::clamp(static_cast<uint32_t>(static_cast<float>(targetExtent.width) * scale),
+		1u, targetExtent.width);
+	renderExtent.height = std::clamp(static_cast<uint32_t>(static_cast<float>(targetExtent.height) * scale),
+		1u, targetExtent.height);
+
+	/// Bin the local lights into clusters and render the shadow cascades before anything is shaded
+	this->clusteredLighting->record(commandBuffer, this->lightDescriptorSets[imageIndex], renderExtent);
+	this->shadowCascades->record(commandBuffer, snapshot);
+
+	/// Terrain chunks keep streaming in while the terrain is hidden, so it is ready when shown
+	this->terrainStreamer->record(commandBuffer);
+
+	/// With the visibility buffer, opaque PBR geometry is rasterized and shaded before the
+	/// scene pass. The scene pass then continues on its depth in the compatible composite pass
+	const bool useVisibilityBuffer = this->visibilityBufferEnabled.load();
+	if (useVisibilityBuffer) {
+		this->visibilityBuffer->record(commandBuffer,
+			snapshot.drawPackets,
+			this->cameraDescriptorSets[imageIndex],
+			this->lightDescriptorSets[imageIndex],
+			renderExtent);
 	}
 
-	/// Resize for new recording - one command buffer per framebuffer
-	uint32_t swapChainImageCount = this->vulkanContext->getSwapChain()->getSwapChainImages().size();
-	this->commandBuffers.resize(swapChainImageCount);
+	/// Set up render pass begin info
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = useVisibilityBuffer
+		? this->visibilityBuffer->getCompositeRenderPass()
+		: this->renderPass.get();
+	renderPassInfo.framebuffer = this->framebufferManager->getOffscreenFramebuffer();
+	/// Only the scaled area is rendered, the rest of the target is never read
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = renderExtent;
+
+	/// Set clear values for color and depth attachments
+	std::array<VkClearValue, 2> clearValues{};
+	clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};  /// Black with 100% opacity
+	/// For Reverse-Z, we clear to 0.0f instead of 1.0f
+	/// This represents the furthest possible depth value in Reverse-Z
+	/// Objects closer to the camera will have depth values closer to 1.0
+	clearValues[1].depthStencil = {0.0f, 0};            /// Using 0.0f for Reverse-Z
+
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
+
+	/// Begin the render pass
+	/// VK_SUBPASS_CONTENTS_INLINE means the render pass commands will be embedded in the primary command buffer
+	/// and no secondary command buffers will be executed
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	/// The composite pass doesn't clear, the visibility buffer writes every pixel instead
+	if (useVisibilityBuffer) {
+		this->visibilityBuffer->recordComposite(commandBuffer, renderExtent, clearValues[0].color);
+	}
 
-	/// Allocate new command buffers through the manager
-	this->commandBuffers = this->commandBufferManager->allocateCommandBuffers(
-		this->commandPool,
-		static_cast<uint32_t>(this->commandBuffers.size()),
-		VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+	/// Track current material, LOD, vertex format and instancing to minimize pipeline switches
+	std::string currentMaterialName;
+	MaterialLod currentMaterialLod{MaterialLod::Full};
+	VertexFormat currentVertexFormat{VertexFormat::Standard};
+	bool currentInstanced{false};
 
-	/// Record commands for each framebuffer
-	for (size_t i = 0; i < this->commandBuffers.size(); i++) {
-		VkCommandBufferBeginInfo beginInfo{};
-		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-
-		VK_CHECK(vkBeginCommandBuffer(this->commandBuffers[i], &beginInfo));
-
-		/// Set up render pass begin info
-		VkRenderPassBeginInfo renderPassInfo{};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = this->renderPass.get();
-		renderPassInfo.framebuffer = this->framebufferManager->getFramebuffer(i);
-		/// Define the render area, typically the size of the framebuffer
-		renderPassInfo.renderArea.offset = {0, 0};
-		renderPassInfo.renderArea.extent = this->vulkanContext->getSwapChain()->getSwapChainExtent();
-
-		/// Set clear values for color and depth attachments
-		std::array<VkClearValue, 2> clearValues{};
-		clearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};  /// Black with 100% opacity
-		/// For Reverse-Z, we clear to 0.0f instead of 1.0f
-		/// This represents the furthest possible depth value in Reverse-Z
-		/// Objects closer to the camera will have depth values closer to 1.0
-		clearValues[1].depthStencil = {0.0f, 0};            /// Using 0.0f for Reverse-Z
-
-		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassInfo.pClearValues = clearValues.data();
-
-		/// Begin the render pass
-		/// VK_SUBPASS_CONTENTS_INLINE means the render pass commands will be embedded in the primary command buffer
-		/// and no secondary command buffers will be executed
-		vkCmdBeginRenderPass(this->commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-		/// Collect render data from visible objects in the scene
-		std::vector<Mesh::RenderData> renderData;
-		this->scene->getRenderData(*this->camera, renderData);
-
-		/// Track current material to minimize pipeline switches
-		std::string currentMaterialName;
-
-		/// Draw all visible objects
-		for (const auto& data : renderData) {
-			/// Skip objects without valid meshes or materials
-			if (!data.vertexBuffer || !data.indexBuffer || !data.material) {
-				continue;
-			}
+	/// Draw all visible objects captured in the snapshot
+	for (size_t i = 0; i < snapshot.drawPackets.size(); ++i) {
+		const auto& data = snapshot.drawPackets[i];
 
-			/// Get material name for pipeline lookup
-			const auto& materialName = data.material->getName();
+		/// Skip objects without valid meshes or materials
+		if (!data.vertexBuffer || !data.indexBuffer || !data.material) {
+			continue;
+		}
 
-			/// Switch pipeline only if material changes
-			if (materialName != currentMaterialName) {
-				/// Get pipeline from PipelineManager using material name
-				auto pipeline = this->pipelineManager->getPipeline(materialName);
-				if (!pipeline) {
-					spdlog::error("Failed to find pipeline for material '{}'", materialName);
-					continue;
-				}
+		/// Already shaded through the visibility buffer
+		if (useVisibilityBuffer && this->visibilityBuffer->isDrawHandled(i)) {
+			continue;
+		}
 
-				auto pipelineLayout = this->pipelineManager->getPipelineLayout(materialName);
-				if (!pipelineLayout) {
-					spdlog::error("Failed to find pipeline layout for material '{}'", materialName);
-					continue;
-				}
+		/// Get material name for pipeline lookup
+		const auto& materialName = data.material->getName();
+
+		/// Switch pipeline only if material, LOD, vertex format or instancing changes
+		const bool instanced = data.instanceBuffer != nullptr;
+		if (materialName != currentMaterialName || data.materialLod != currentMaterialLod
+			|| data.vertexFormat != currentVertexFormat || instanced != currentInstanced) {
+			/// Get the LOD variant from PipelineManager using material name
+			auto pipeline = this->pipelineManager->getPipeline(
+				materialName, data.materialLod, data.vertexFormat, instanced);
+			if (!pipeline) {
+				spdlog::error("Failed to find pipeline for material '{}'", materialName);
+				continue;
+			}
 
-				/// Bind the new pipeline
-				vkCmdBindPipeline(this->commandBuffers[i],
-					VK_PIPELINE_BIND_POINT_GRAPHICS,
-					pipeline->get());
-
-				/// Set dynamic viewport and scissor
-				/// These need to be set because we configured them as dynamic state
-				VkViewport viewport{};
-				viewport.x = 0.0f;
-				viewport.y = 0.0f;
-				viewport.width = static_cast<float>(this->vulkanContext->getSwapChain()->getSwapChainExtent().width);
-				viewport.height = static_cast<float>(this->vulkanContext->getSwapChain()->getSwapChainExtent().height);
-				viewport.minDepth = 0.0f;
-				viewport.maxDepth = 1.0f;
-
-				VkRect2D scissor{};
-				scissor.offset = {0, 0};
-				scissor.extent = this->vulkanContext->getSwapChain()->getSwapChainExtent();
-
-				vkCmdSetViewport(this->commandBuffers[i], 0, 1, &viewport);
-				vkCmdSetScissor(this->commandBuffers[i], 0, 1, &scissor);
-
-				/// Bind camera and light descriptor sets (sets 0 and 1)
-				std::array<VkDescriptorSet, 2> globalSets = {
-					this->cameraDescriptorSets[i],
-					this->lightDescriptorSets[i]
-				};
-				vkCmdBindDescriptorSets(
-					this->commandBuffers[i],
-					VK_PIPELINE_BIND_POINT_GRAPHICS,
-					pipelineLayout->get(),
-					0,  /// First set = 0 (camera)
-					2,  /// Bind both global sets at once
-					globalSets.data(),
-					0, nullptr
-				);
-
-				currentMaterialName = materialName;
+			auto pipelineLayout = this->pipelineManager->getPipelineLayout(materialName);
+			if (!pipelineLayout) {
+				spdlog::error("Failed to find pipeline layout for material '{}'", materialName);
+				continue;
 			}
 
-			/// Bind material-specific resources
-			/// This is where textures are bound through the material's bind method
-			/// Our updated Material::bind implementation handles both uniform buffers and textures
-			data.material->bind(this->commandBuffers[i],
-				this->pipelineManager->getPipelineLayout(materialName)->get());
-
-			/// Update push constants with model matrix
-			vkCmdPushConstants(
-				this->commandBuffers[i],
-				this->pipelineManager->getPipelineLayout(materialName)->get(),
-				VK_SHADER_STAGE_VERTEX_BIT,
-				0,
-				sizeof(glm::mat4),
-				&data.modelMatrix
+			/// Bind the new pipeline
+			vkCmdBindPipeline(commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				pipeline->get());
+
+			/// Set dynamic viewport and scissor
+			/// These need to be set because we configured them as dynamic state
+			VkViewport viewport{};
+			viewport.x = 0.0f;
+			viewport.y = 0.0f;
+			viewport.width = static_cast<float>(renderExtent.width);
+			viewport.height = static_cast<float>(renderExtent.height);
+			viewport.minDepth = 0.0f;
+			viewport.maxDepth = 1.0f;
+
+			VkRect2D scissor{};
+			scissor.offset = {0, 0};
+			scissor.extent = renderExtent;
+
+			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+			/// Bind camera and light descriptor sets (sets 0 and 1)
+			std::array<VkDescriptorSet, 2> globalSets = {
+				this->cameraDescriptorSets[imageIndex],
+				this->lightDescriptorSets[imageIndex]
+			};
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				pipelineLayout->get(),
+				0,  /// First set = 0 (camera)
+				2,  /// Bind both global sets at once
+				globalSets.data(),
+				0, nullptr
 			);
 
-			/// Bind vertex and index buffers
-			VkBuffer vertexBuffers[] = {data.vertexBuffer->get()};
-			VkDeviceSize offsets[] = {0};
-			vkCmdBindVertexBuffers(this->commandBuffers[i], 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(this->commandBuffers[i], data.indexBuffer->get(), 0,
-				VK_INDEX_TYPE_UINT32);
-
-			/// Draw the object
-			vkCmdDrawIndexed(this->commandBuffers[i],
-				data.indexBuffer->getIndexCount(),
-				1, 0, 0, 0);
+			currentMaterialName = materialName;
+			currentMaterialLod = data.materialLod;
+			currentVertexFormat = data.vertexFormat;
+			currentInstanced = instanced;
 		}
 
-		/// End the render pass
-		vkCmdEndRenderPass(this->commandBuffers[i]);
+		/// Bind material-specific resources
+		/// This is where textures are bound through the material's bind method
+		/// Our updated Material::bind implementation handles both uniform buffers and textures
+		data.material->bind(commandBuffer,
+			this->pipelineManager->getPipelineLayout(materialName)->get());
+
+		/// Update push constants with model matrix
+		/// Quantized meshes append their dequantization, standard ones stop after the matrix
+		const MaterialPushConstants pushConstants{data.modelMatrix, data.dequantization};
+		vkCmdPushConstants(
+			commandBuffer,
+			this->pipelineManager->getPipelineLayout(materialName)->get(),
+			VK_SHADER_STAGE_VERTEX_BIT,
+			0,
+			data.vertexFormat == VertexFormat::Quantized ? sizeof(MaterialPushConstants) : sizeof(glm::mat4),
+			&pushConstants
+		);
+
+		/// Bind vertex and index buffers
+		VkBuffer vertexBuffers[] = {data.vertexBuffer->get()};
+		VkDeviceSize offsets[] = {0};
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, data.indexBuffer->get(), 0,
+			VK_INDEX_TYPE_UINT32);
+
+		/// Instanced packets read their transforms from the second binding
+		if (instanced) {
+			VkBuffer instanceBuffers[] = {data.instanceBuffer->get()};
+			vkCmdBindVertexBuffers(commandBuffer, 1, 1, instanceBuffers, offsets);
+		}
+
+		/// Draw the object, or its visible range of instances
+		vkCmdDrawIndexed(commandBuffer,
+			data.indexBuffer->getIndexCount(),
+			data.instanceCount, 0, 0, data.firstInstance);
+	}
 
-		/// Finish recording the command buffer
-		VK_CHECK(vkEndCommandBuffer(this->commandBuffers[i]));
+	/// The planet terrain is drawn after the scene's draw packets with its own pipeline
+	if (this->terrainEnabled.load()) {
+		this->terrainQuadtree->record(commandBuffer,
+			this->cameraDescriptorSets[imageIndex],
+			this->lightDescriptorSets[imageIndex],
+			renderExtent);
 	}
 
-	// spdlog::debug("Command buffers recorded successfully");
+	/// End the render pass
+	vkCmdEndRenderPass(commandBuffer);
+
+	/// Upscale and sharpen the scene into the swap chain image
+	this->upscalePass->setSharpness(this->upscaleSharpness.load());
+	this->upscalePass->record(commandBuffer,
+		this->framebufferManager->getFramebuffer(imageIndex),
+		swapChainExtent,
+		targetExtent,
+		renderExtent);
+
+	this->gpuTimer->end(commandBuffer);
+
+	/// Finish recording the command buffer
+	VK_CHECK(vkEndCommandBuffer(commandBuffer));
 }
 
 void Renderer::createCameraUniformBuffer() {
@@ -902,21 +1405,16 @@ void Renderer::createCameraUniformBuffer() {
 	spdlog::info("Camera uniform buffer created successfully");
 }
 
-void Renderer::updateCameraUniformBuffer() const {
+void Renderer::updateCameraUniformBuffer(const FrameSnapshot& snapshot) const {
 	CameraUBO ubo{};
 
-	/// Get the current view matrix from the camera
-	ubo.view = this->camera->getViewMatrix();
-
-	/// Calculate current aspect ratio from window dimensions
-	float aspectRatio = static_cast<float>(this->width) /
-		static_cast<float>(this->height);
-
-	/// Get the projection matrix with current aspect ratio
-	ubo.projection = this->camera->getProjectionMatrix(aspectRatio);
+	/// Use the camera state captured by the update thread
+	/// Reading the live camera here would race with input handling and simulation
+	ubo.view = snapshot.view;
+	ubo.projection = snapshot.projection;
 
 	/// Get the camera position for view-dependent calculations
-	ubo.cameraPos = this->camera->getPosition();
+	ubo.cameraPos = snapshot.cameraPosition;
 
 	/// Padding for alignment
 	ubo.padding = 0.0f;
@@ -932,7 +1430,7 @@ void Renderer::updateCameraUniformBuffer() const {
 void Renderer::createDescriptorPool() {
 	/// Define pool sizes for our different descriptor types
 	/// Each type needs its own pool allocation
-	std::array<VkDescriptorPoolSize, 2> poolSizes{};
+	std::array<VkDescriptorPoolSize, 4> poolSizes{};
 
 	uint32_t swapChainImageCount = this->vulkanContext->getSwapChain()->getSwapChainImages().size();
 
@@ -941,10 +1439,20 @@ void Renderer::createDescriptorPool() {
 	poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 	poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChainImageCount);
 
-	/// Light buffer pool size
-	/// One descriptor per swap chain image
+	/// Cluster, shadow and environment parameters pool size
+	/// Three descriptors per swap chain image
 	poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImageCount);
+	poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImageCount * 3);
+
+	/// Lights, cluster light counts and cluster light indices
+	/// Three storage buffers per swap chain image
+	poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[2].descriptorCount = static_cast<uint32_t>(swapChainImageCount * 3);
+
+	/// Cascaded shadow map, prefiltered environment and BRDF lookup table
+	/// Three samplers per swap chain image
+	poolSizes[3].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[3].descriptorCount = static_cast<uint32_t>(swapChainImageCount * 3);
 
 	/// Create the descriptor pool
 	/// We need enough space for both camera and light descriptors per frame
@@ -1031,25 +1539,10 @@ void Renderer::createDescriptorSets() {
 				this->vulkanContext->getDevice()->getDevice(), 1, &descriptorWrite, 0, nullptr);
 		}
 
-		/// Update light descriptor
-		{
-			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = this->lightBuffer->get();
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(LightData) * LightManager::MaxLights;
-
-			VkWriteDescriptorSet descriptorWrite{};
-			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-			descriptorWrite.dstSet = this->lightDescriptorSets[i];
-			descriptorWrite.dstBinding = 0;
-			descriptorWrite.dstArrayElement = 0;
-			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			descriptorWrite.descriptorCount = 1;
-			descriptorWrite.pBufferInfo = &bufferInfo;
-
-			vkUpdateDescriptorSets(
-				this->vulkanContext->getDevice()->getDevice(), 1, &descriptorWrite, 0, nullptr);
-		}
+		/// Update light, shadow and environment descriptors
+		this->clusteredLighting->writeDescriptorSet(this->lightDescriptorSets[i]);
+		this->shadowCascades->writeDescriptorSet(this->lightDescriptorSets[i]);
+		this->environmentLighting->writeDescriptorSet(this->lightDescriptorSets[i]);
 	}
 
 	spdlog::info("Created and updated descriptor sets for {} frames", numFrames);
@@ -1121,6 +1614,72 @@ void Renderer::initializeDepthBuffer() {
 	spdlog::info("Depth buffer initialized successfully");
 }
 
+void Renderer::initializeSceneColorTarget() {
+	/// The scene color target gets the swap chain format, so the scene render pass
+	/// stays compatible with pipelines no matter where we render to
+	/// It's allocated at full size, lower render scales only use part of it
+	VkExtent2D swapChainExtent = this->vulkanContext->getSwapChain()->getSwapChainExtent();
+
+	this->sceneColorTarget = std::make_unique<vulkan::ColorTarget>(
+		this->vulkanContext->getDevice()->getDevice(),
+		this->vulkanContext->getPhysicalDevice()
+	);
+
+	this->sceneColorTarget->initialize(swapChainExtent.width, swapChainExtent.height,
+		this->vulkanContext->getSwapChain()->getSwapChainImageFormat());
+}
+
+void Renderer::updateRenderScale() {
+	/// Pick up settings changed from other threads
+	this->resolutionController.setEnabled(this->dynamicResolutionEnabled.load());
+	this->resolutionController.setTargetGpuTime(this->targetGpuTimeMs.load());
+
+	if (!this->gpuTimer->isSupported()) {
+		return;
+	}
+
+	if (auto gpuTime = this->gpuTimer->getElapsedMilliseconds()) {
+		this->gpuFrameTimeMs = *gpuTime;
+		this->renderScale = this->resolutionController.update(*gpuTime);
+	}
+}
+
+void Renderer::setDynamicResolutionEnabled(bool enabled) {
+	this->dynamicResolutionEnabled = enabled;
+	spdlog::info("Dynamic resolution {}", enabled ? "enabled" : "disabled");
+}
+
+void Renderer::setVisibilityBufferEnabled(bool enabled) {
+	this->visibilityBufferEnabled = enabled;
+	spdlog::info("Visibility buffer {}", enabled ? "enabled" : "disabled");
+}
+
+void Renderer::setTerrainEnabled(bool enabled) {
+	this->terrainEnabled = enabled;
+	spdlog::info("Terrain {}", enabled ? "enabled" : "disabled");
+}
+
+void Renderer::setSphereDisplacement(const SphereDisplacement::Parameters& parameters) {
+	this->sphereDisplacement->setParameters(parameters);
+
+	/// A larger amplitude reaches further out, culling and shadows go by the bounds
+	this->sphereDisplacement->updateBounds();
+	this->displacedSphereNode->refreshBounds();
+}
+
+SphereDisplacement::Parameters Renderer::getSphereDisplacement() const {
+	return this->sphereDisplacement->getParameters();
+}
+
+void Renderer::setTargetGpuTime(float milliseconds) {
+	this->targetGpuTimeMs = milliseconds;
+	spdlog::info("Dynamic resolution target GPU time set to {:.2f} ms", milliseconds);
+}
+
+void Renderer::setUpscaleSharpness(float sharpness) {
+	this->upscaleSharpness = std::clamp(sharpness, 0.0f, 1.0f);
+}
+
 void Renderer::initializeScene() {
 	/// Create main directional light (sun)
 	auto sunLight = std::make_shared<DirectionalLight>(glm::vec3(1.0f, 1.0f, -1.0f));
@@ -1191,6 +1750,28 @@ void Renderer::initializeScene() {
 	scene::Transform transform;
 	transform.position = glm::vec3(-1.0f, -1.0f, -1.0f);
 
+	/// A noise displaced sphere beside the model, generated on the GPU so its noise
+	/// can be changed while looking at it
+	this->displacedSphereNode = this->scene->createNode("DisplacedSphere", rootNode);
+	auto sphereMesh = this->meshManager->createMesh<IcosphereMesh>(1.0f, DisplacedSphereSubdivisions);
+	sphereMesh->setMaterial(metallicMaterial);
+
+	this->sphereDisplacement = std::make_unique<SphereDisplacement>(
+		this->vulkanContext->getDevice()->getDevice(),
+		this->bufferManager);
+	this->sphereDisplacement->initialize();
+
+	this->skinningPass = std::make_unique<SkinningPass>(
+		this->vulkanContext->getDevice()->getDevice(),
+		this->bufferManager);
+	this->skinningPass->initialize();
+	this->sphereDisplacement->attach(std::static_pointer_cast<IcosphereMesh>(sphereMesh));
+	this->displacedSphereNode->setMesh(std::move(sphereMesh));
+
+	scene::Transform sphereTransform;
+	sphereTransform.position = glm::vec3(3.0f, 0.0f, 0.0f);
+	this->displacedSphereNode->setLocalTransform(sphereTransform);
+
 
 	/// Load a sample model to demonstrate model loading
 	/// We place it at the center of the scene to showcase the loaded geometry
@@ -1214,6 +1795,8 @@ void Renderer::initializeScene() {
 		);
 
 		if (modelRootNode) {
+			/// The model doesn't move, so its shadows can be cached
+			modelParentNode->setStatic(true);
 			spdlog::info("Sample model loaded successfully");
 		} else {
 			spdlog::error("Failed to load sample model");
@@ -1225,38 +1808,70 @@ void Renderer::initializeScene() {
 	/// Update bounds after creating all objects
 	rootNode->updateBoundsIfNeeded();
 
+	this->logGeometryMemory();
+
 	spdlog::info("Scene initialized with test objects");
 }
 
-void Renderer::createLightUniformBuffer() {
-	/// Calculate required buffer size
-	VkDeviceSize bufferSize = sizeof(LightData) * LightManager::MaxLights;
+void Renderer::logGeometryMemory() const {
+	size_t bytes = 0;
+	size_t vertexCount = 0;
+	std::unordered_set<const SharedGeometry*> countedGeometry;
 
-	/// Initialize buffer with empty light data
-	std::vector<LightData> initialData(LightManager::MaxLights);
+	this->scene->forEachMesh([&](const std::shared_ptr<Mesh>& mesh) {
+		const auto geometry = mesh->getSharedGeometry();
+		if (!geometry) {
+			bytes += mesh->getHostMemoryUsage();
+			vertexCount += mesh->getVertexCount();
+		}
+		else if (countedGeometry.insert(geometry.get()).second) {
+			bytes += geometry->vertices.capacity() * sizeof(Vertex)
+				+ geometry->indices.capacity() * sizeof(uint32_t);
+			vertexCount += geometry->vertices.size();
+		}
+	});
 
-	/// Create the uniform buffer using buffer manager
-	this->lightBuffer = this->bufferManager->createUniformBuffer(bufferSize, initialData.data());
+	if (vertexCount == 0) {
+		return;
+	}
 
-	spdlog::info("Light uniform buffer created with size {} bytes", bufferSize);
+	const double megabytes = static_cast<double>(bytes) / (1024.0 * 1024.0);
+	spdlog::info("Mesh geometry in host memory: {:.1f} MB for {} vertices, {:.1f} MB per million vertices",
+		megabytes, vertexCount, megabytes * 1000000.0 / static_cast<double>(vertexCount));
 }
 
-void Renderer::updateLightUniformBuffer() const {
-	/// Get current light data from the manager
-	auto lightData = this->lightManager->getLightData();
+void Renderer::createLightBuffers() {
+	this->clusteredLighting = std::make_unique<ClusteredLighting>(
+		this->vulkanContext->getDevice()->getDevice(),
+		this->bufferManager);
+	this->clusteredLighting->initialize(
+		this->pipelineManager->getCameraDescriptorLayout(),
+		this->pipelineManager->getLightDescriptorLayout());
 
-	/// Calculate buffer size
-	VkDeviceSize bufferSize = sizeof(LightData) * LightManager::MaxLights;
+	/// Shadows are bound through the light descriptor set as well
+	this->shadowCascades = std::make_unique<ShadowCascades>(
+		this->vulkanContext->getDevice()->getDevice(),
+		this->vulkanContext->getPhysicalDevice(),
+		this->bufferManager);
+	this->shadowCascades->initialize();
 
-	/// Update buffer with new light data
-	this->bufferManager->updateBuffer(
-		this->lightBuffer,
-		lightData.data(),
-		bufferSize,
-		0);
+	/// Baked once per environment map, later starts load the cached result
+	this->environmentLighting = std::make_unique<EnvironmentLighting>(
+		this->vulkanContext->getDevice()->getDevice(),
+		this->vulkanContext->getPhysicalDevice(),
+		this->vulkanContext->getDevice()->getGraphicsQueue(),
+		this->uploadCommandPool,
+		this->commandBufferManager,
+		this->bufferManager);
+	this->environmentLighting->initialize(EnvironmentMapPath, EnvironmentCacheDirectory);
+}
+
+void Renderer::updateLightBuffers(const FrameSnapshot& snapshot) const {
+	/// Light data was captured by the update thread, directional lights first
+	this->clusteredLighting->update(snapshot);
+	this->shadowCascades->update(snapshot);
 
-	spdlog::trace("Updated light uniform buffer with {} lights",
-		this->lightManager->getLightCount());
+	spdlog::trace("Updated light buffers for snapshot {}", snapshot.frameIndex);
 }
 
 void Renderer::initializeMaterials() {
@@ -1356,6 +1971,12 @@ void Renderer::initializeMaterials() {
 
 	terrainMaterial->setDebugMode(TerrainMaterial::TerrainDebugMode::None);
 
+	/// Create the field textures, their contents are streamed in by the terrain streamer
+	terrainMaterial->updateFields(
+		this->uploadCommandPool,
+		this->vulkanContext->getDevice()->getGraphicsQueue(),
+		*this->commandBufferManager);
+
 	/// Create pipeline for terrain material
 	auto terrainPipeline = this->pipelineManager->createPipeline(*terrainMaterial);
 	if (!terrainPipeline) {
@@ -1366,6 +1987,20 @@ void Renderer::initializeMaterials() {
 		);
 	}
 
+	/// The planet is drawn through a quadtree of shared patches instead of a scene mesh
+	/// We place it behind the sample model so both can be looked at
+	this->terrainQuadtree = std::make_unique<TerrainQuadtree>(
+		this->vulkanContext->getDevice()->getDevice(),
+		this->bufferManager);
+	this->terrainQuadtree->initialize(terrainMaterial,
+		this->renderPass.get(),
+		this->pipelineManager->getPipelineLayout(terrainMaterial->getName())->get());
+	this->terrainQuadtree->setTransform(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -8.0f)));
+
+	/// Generate the fields in the background, chunks show up as they finish
+	this->terrainStreamer = std::make_unique<TerrainStreamer>(this->bufferManager);
+	this->terrainStreamer->initialize(terrainMaterial, TerrainCacheDirectory);
+
 	/// Load test textures
 	/// We load each texture type separately to have full control over parameters
 	std::shared_ptr<rendering::Texture> colorTexture = this->textureManager->getOrLoadTexture(
@@ -1504,6 +2139,9 @@ void Renderer::initializeModelManager() {
 	/// This enables loading models using relative paths
 	this->modelManager->setResourceBaseDirectory("resources/models/");
 
+	/// Idle until a manifest is loaded
+	this->assetPrefetcher = std::make_unique<AssetPrefetcher>(*this->modelManager, this->textureManager);
+
 	spdlog::info("Model manager initialized successfully");
 }
 
@@ -7,16 +7,30 @@
 #include "vulkan/commandbuffermanager.h"
 #include "vulkan/framebuffermanager.h"
 #include "vulkan/depthbuffer.h"
+#include "vulkan/colortarget.h"
+#include "vulkan/gputimer.h"
 #include "rendering/editorcamera.h"
 #include "rendering/orbitcamera.h"
 #include "rendering/meshmanager.h"
 #include "rendering/lightmanager.h"
 #include "rendering/texturemanager.h"
 #include "rendering/screenshot.h"
+#include "rendering/framesnapshot.h"
+#include "rendering/dynamicresolution.h"
+#include "rendering/upscalepass.h"
+#include "rendering/visibilitybuffer.h"
+#include "rendering/clusteredlighting.h"
+#include "rendering/shadowcascades.h"
+#include "rendering/environmentlighting.h"
+#include "rendering/terrainquadtree.h"
+#include "rendering/terrainstreamer.h"
+#include "rendering/spheredisplacement.h"
+#include "rendering/skinningpass.h"
 #include "scene/scene.h"
 #include "materialmanager.h"
 #include "buffermanager.h"
 #include "models/modelmanager.h"
+#include "models/assetprefetcher.h"
 #include "pipelinefactory.h"
 #include "models/materialparametermapper.h"
 #include "models/textureloadingpipeline.h"
@@ -28,7 +42,12 @@
 
 
 #include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 namespace lillugsi::rendering {
@@ -70,19 +89,121 @@ public:
 	/// Clean up all Vulkan resources
 	void cleanup();
 
-	/// Draw a frame
+	/// Draw a frame from the most recent published snapshot
+	/// This is the render-thread side of the pipeline. It can also be called
+	/// directly after update() when running single-threaded.
+	/// Returns without drawing if no new snapshot arrives within a short timeout
 	void drawFrame();
 
 	/// Update the renderer state
+	/// This is the simulation side of the pipeline: it advances the scene and camera,
+	/// then publishes an immutable frame snapshot for the render thread
 	/// @param deltaTime Time elapsed since last frame, scaled by game time settings
 	void update(float deltaTime);
 
 	/// Recreate the swap chain (e.g., after window resize)
+	/// Must be called from the thread that draws frames
 	/// @param newWidth New width of the window
 	/// @param newHeight New height of the window
 	/// @return True if swap chain recreation was successful, false otherwise
 	bool recreateSwapChain(uint32_t newWidth, uint32_t newHeight);
 
+	/// Request a swap chain recreation from any thread
+	/// The drawing thread picks this up before its next frame
+	/// @param newWidth New width of the window
+	/// @param newHeight New height of the window
+	void requestSwapChainRecreation(uint32_t newWidth, uint32_t newHeight);
+
+	/// Request a different present mode from any thread
+	/// The drawing thread recreates the swap chain with this mode before its next frame.
+	/// Modes the surface doesn't support are rejected with a warning
+	/// @param mode FIFO, FIFO_RELAXED, MAILBOX or IMMEDIATE
+	void requestPresentMode(VkPresentModeKHR mode);
+
+	/// Get the present mode of the current swap chain
+	/// @return The active present mode
+	[[nodiscard]] VkPresentModeKHR getPresentMode() const { return this->presentMode.load(); }
+
+	/// Get the present modes the window surface supports
+	/// @return List of modes accepted by requestPresentMode
+	[[nodiscard]] const std::vector<VkPresentModeKHR>& getSupportedPresentModes() const {
+		return this->supportedPresentModes;
+	}
+
+	/// Check if the window surface supports a present mode
+	/// @param mode The present mode to check
+	/// @return True if the mode can be requested
+	[[nodiscard]] bool isPresentModeSupported(VkPresentModeKHR mode) const;
+
+	/// Enable or disable dynamic resolution
+	/// When disabled, the scene is rendered at full resolution
+	/// @param enabled True to adapt the render scale to the GPU time
+	void setDynamicResolutionEnabled(bool enabled);
+
+	/// Check if dynamic resolution is enabled
+	/// @return True if the render scale adapts to the GPU time
+	[[nodiscard]] bool isDynamicResolutionEnabled() const { return this->dynamicResolutionEnabled.load(); }
+
+	/// Set the GPU frame time the dynamic resolution controller aims for
+	/// @param milliseconds Target GPU time per frame
+	void setTargetGpuTime(float milliseconds);
+
+	/// Set how strongly the upscaled image is sharpened
+	/// @param sharpness 0 for plain bilinear upscaling, 1 for maximum sharpening
+	void setUpscaleSharpness(float sharpness);
+
+	/// Get the current render scale
+	/// @return Fraction of the swap chain resolution the scene is rendered at
+	[[nodiscard]] float getRenderScale() const { return this->renderScale.load(); }
+
+	/// Get the last measured GPU frame time
+	/// @return GPU time of the last finished frame in milliseconds, 0 if unknown
+	[[nodiscard]] float getGpuFrameTime() const { return this->gpuFrameTimeMs.load(); }
+
+	/// Enable or disable the visibility buffer path
+	/// When enabled, opaque PBR geometry is rasterized into a visibility buffer and
+	/// shaded in compute, everything else is still drawn forward
+	/// @param enabled True to use the visibility buffer
+	void setVisibilityBufferEnabled(bool enabled);
+
+	/// Check if the visibility buffer path is enabled
+	/// @return True if opaque PBR geometry is shaded through the visibility buffer
+	[[nodiscard]] bool isVisibilityBufferEnabled() const { return this->visibilityBufferEnabled.load(); }
+
+	/// Enable or disable the quadtree terrain planet
+	/// @param enabled True to draw the planet
+	void setTerrainEnabled(bool enabled);
+
+	/// Check if the quadtree terrain planet is drawn
+	/// @return True if the planet is drawn
+	[[nodiscard]] bool isTerrainEnabled() const { return this->terrainEnabled.load(); }
+
+	/// Set the noise of the displaced sphere, it is displaced again in the next frame
+	/// @param parameters The new noise parameters
+	void setSphereDisplacement(const SphereDisplacement::Parameters& parameters);
+
+	/// Get the noise of the displaced sphere
+	/// @return The current noise parameters
+	[[nodiscard]] SphereDisplacement::Parameters getSphereDisplacement() const;
+
+	/// Start the dedicated render thread
+	/// From now on, frames are recorded and presented on that thread while the
+	/// caller keeps running input and simulation and publishes snapshots via update()
+	void startRenderThread();
+
+	/// Stop the render thread and wait for it to finish its current frame
+	void stopRenderThread();
+
+	/// Check if the render thread is running
+	/// The thread stops by itself if a frame fails with an exception
+	/// @return True while the render thread is alive
+	[[nodiscard]] bool isRenderThreadRunning() const { return this->renderThreadRunning.load(); }
+
+	/// Block until the render thread has picked up the last published snapshot
+	/// The simulation calls this after update() so it runs at most one frame ahead,
+	/// which lets frame N render while frame N+1 simulates without unbounded latency
+	void waitForFrameSlot();
+
 	/// Get a pointer to the camera
 	/// This allows other parts of the application to interact with the camera
 	/// @return A pointer to the EditorCamera
@@ -124,6 +245,24 @@ public:
 		const std::string& filePath,
 		std::shared_ptr<scene::SceneNode> parentNode);
 
+	/// Start streaming a model in progressively
+	/// The model's hierarchy appears right away, its meshes and textures are filled
+	/// in by update within a time budget per frame, coarse geometry first and what
+	/// covers most of the screen before the rest. Pipelines are created as materials appear
+	/// @param filePath Path to the model file
+	/// @param parentNode Parent node to attach the model to (optional)
+	/// @return Root node of the model, or nullptr if the file can't be loaded
+	[[nodiscard]] std::shared_ptr<scene::SceneNode> loadModelProgressive(
+		const std::string& filePath,
+		std::shared_ptr<scene::SceneNode> parentNode = nullptr);
+
+	/// Prefetch the assets a manifest lists
+	/// From now on, update loads the level wide assets and those of regions near the
+	/// camera in the background, so loadModel and texture requests find them resident
+	/// @param filePath Path to the manifest, see AssetManifest for the format
+	/// @return True if the manifest was read
+	bool loadAssetManifest(const std::string& filePath);
+
 	/// Load a model asynchronously from file
 	/// This starts a background task to load the model without blocking the main thread
 	/// @param filePath Path to the model file
@@ -134,10 +273,17 @@ public:
 		std::shared_ptr<scene::SceneNode> parentNode = nullptr);
 
 	/// Capture the current frame as a screenshot
+	/// Must be called from the thread that draws frames
 	/// @param filename The name of the file to save (PNG format)
 	/// @return True if the screenshot was saved successfully
 	bool captureScreenshot(const std::string& filename);
 
+	/// Request a screenshot from any thread
+	/// The drawing thread captures the last frame it presented, at the start of its
+	/// next frame and before drawing anything new
+	/// @param filename The name of the file to save (PNG format)
+	void requestScreenshot(const std::string& filename);
+
 private:
 	/// Struct to hold camera data for GPU
 	struct CameraUBO {
@@ -153,19 +299,55 @@ private:
 	void cleanupFramebuffers();
 	vulkan::VulkanShaderModuleHandle createShaderModule(const std::vector<char>& code);
 	void createGraphicsPipeline();
-	void recordCommandBuffers();
+	void recordCommandBuffer(uint32_t imageIndex, const FrameSnapshot& snapshot);
 	void createCameraUniformBuffer();
-	void updateCameraUniformBuffer() const;
+	void updateCameraUniformBuffer(const FrameSnapshot& snapshot) const;
 	void createDescriptorPool();
 	void createDescriptorSets();
 	void createSyncObjects();
 	void cleanupSyncObjects();
 	void initializeDepthBuffer();
+
+	/// Create the offscreen color target the scene is rendered into
+	void initializeSceneColorTarget();
+
+	/// Read the GPU time of the finished frame and pick the next render scale
+	/// Runs on the drawing thread right after the in-flight fence has signaled
+	void updateRenderScale();
 	void initializeScene();
-	void createLightUniformBuffer();
-	void updateLightUniformBuffer() const;
+
+	/// Log the host memory held by the scene's mesh geometry
+	/// Shared geometry is counted once, however many meshes draw it
+	void logGeometryMemory() const;
+
+	void createLightBuffers();
+	void updateLightBuffers(const FrameSnapshot& snapshot) const;
+
+	/// Capture the current simulation state into a snapshot
+	/// Runs on the update thread after the scene and camera have been advanced
+	/// @param snapshot The producer-owned snapshot slot to fill
+	void buildFrameSnapshot(FrameSnapshot& snapshot) const;
+
+	/// Apply swap chain and screenshot requests made from other threads
+	/// Runs on the drawing thread between frames
+	void processPendingRequests();
+
+	/// Entry point of the render thread
+	void renderThreadMain();
 	void initializeMaterials();
 	void initializeModelManager();
+
+	/// Create pipelines for the materials of a subtree's meshes
+	/// The pipeline manager isn't shared between threads, so once the render thread
+	/// runs the pipelines are created there, before its next frame. Going by meshes
+	/// skips materials a loader thread is still setting up, they aren't assigned yet
+	/// @param root Root of the subtree
+	void requestPipelines(const std::shared_ptr<scene::SceneNode>& root);
+
+	/// Create pipelines for materials that don't have one yet
+	/// @param materialNames Names of the materials
+	/// @return False if some pipeline could not be created
+	bool createMissingPipelines(const std::unordered_set<std::string>& materialNames);
 	/// Sets up the material mapper, texture loader, and pipeline factory
 	void initializeModelLoadingComponents();
 
@@ -177,8 +359,15 @@ private:
 
 	/// Command pool for rendering operations
 	/// Raw handle owned by CommandBufferManager
+	/// Only the drawing thread records from this pool
 	VkCommandPool commandPool = VK_NULL_HANDLE;
 
+	/// Command pool for texture uploads
+	/// Texture uploads happen on the update and loader threads, which share this pool.
+	/// One-time commands are recorded in a pool of the calling thread's own, created by
+	/// the CommandBufferManager for this one, so no pool is used from two threads at once
+	VkCommandPool uploadCommandPool = VK_NULL_HANDLE;
+
 	/// Handle for the render pass
 	vulkan::VulkanRenderPassHandle renderPass;
 
@@ -212,6 +401,26 @@ private:
 	/// This allows for proper rendering of 3D scenes by ensuring objects are drawn in the correct order
 	std::unique_ptr<vulkan::DepthBuffer> depthBuffer;
 
+	/// Dynamic resolution
+	/// The scene is rendered into sceneColorTarget at renderScale of its size,
+	/// then upscalePass scales it into the swap chain image
+	std::unique_ptr<vulkan::ColorTarget> sceneColorTarget;
+	std::unique_ptr<UpscalePass> upscalePass;
+	std::unique_ptr<vulkan::GpuTimer> gpuTimer;
+	DynamicResolutionController resolutionController;  /// Only used by the drawing thread
+
+	/// Visibility buffer path for opaque PBR geometry, see VisibilityBuffer
+	std::unique_ptr<VisibilityBuffer> visibilityBuffer;
+
+	/// Settings and results shared with other threads
+	std::atomic<bool> dynamicResolutionEnabled{true};
+	std::atomic<float> targetGpuTimeMs{DynamicResolutionController::DefaultTargetGpuTimeMs};
+	std::atomic<float> upscaleSharpness{UpscalePass::DefaultSharpness};
+	std::atomic<float> renderScale{1.0f};
+	std::atomic<float> gpuFrameTimeMs{0.0f};
+	std::atomic<bool> visibilityBufferEnabled{false};
+	std::atomic<bool> terrainEnabled{false};
+
 	/// Window dimensions
 	uint32_t width;
 	uint32_t height;
@@ -227,6 +436,9 @@ private:
 	/// Tracks time since last frame for animations and effects
 	float currentFrameTime{0.0f};
 
+	/// When update last trimmed the model cache
+	std::chrono::steady_clock::time_point lastModelCacheTrim{};
+
 	/// Light management
 	std::unique_ptr<LightManager> lightManager;
 
@@ -238,6 +450,7 @@ private:
 #endif
 
 	std::shared_ptr<scene::SceneNode> texturedCubeNode;
+	std::shared_ptr<scene::SceneNode> displacedSphereNode;
 
 	/// Screenshot manager variables
 	std::unique_ptr<Screenshot> screenshotManager;
@@ -254,8 +467,15 @@ private:
 
 	std::shared_ptr<BufferManager> bufferManager;
 	std::shared_ptr<vulkan::Buffer> cameraBuffer;
-	std::shared_ptr<vulkan::Buffer> lightBuffer;
+	std::unique_ptr<ClusteredLighting> clusteredLighting;  /// Light buffers and light culling pass
+	std::unique_ptr<ShadowCascades> shadowCascades;        /// Shadow maps of the primary directional light
+	std::unique_ptr<EnvironmentLighting> environmentLighting;  /// Image based ambient light
+	std::unique_ptr<TerrainQuadtree> terrainQuadtree;  /// Planet terrain with distance based LOD
+	std::unique_ptr<TerrainStreamer> terrainStreamer;  /// Generates the terrain fields in the background
+	std::unique_ptr<SphereDisplacement> sphereDisplacement;  /// Displaces the noise sphere on the GPU
+	std::unique_ptr<SkinningPass> skinningPass;  /// Moves the vertices of animated characters on the GPU
 	std::unique_ptr<ModelManager> modelManager;
+	std::unique_ptr<AssetPrefetcher> assetPrefetcher;  /// Loads manifest assets before the camera gets to them
 
 	/// Pipeline factory for model material pipelines
 	/// This centralizes the creation of specialized rendering pipelines
@@ -272,6 +492,36 @@ private:
 	/// to prevent blocking the main thread during model loading
 	std::unique_ptr<TextureLoadingPipeline> textureLoader;
 
+	/// Snapshots handed from the update thread to the render thread
+	FrameSnapshotBuffer snapshotBuffer;
+
+	/// Index of the next snapshot the update thread publishes
+	uint64_t nextSnapshotIndex{0};
+
+	/// Aspect ratio of the current swap chain
+	/// Written by the drawing thread on resize, read by the update thread for the projection
+	std::atomic<float> aspectRatio{1.0f};
+
+	/// Dedicated render thread and its run flag
+	std::thread renderThread;
+	std::atomic<bool> renderThreadRunning{false};
+
+	/// Requests from other threads, applied by the drawing thread between frames
+	std::mutex requestMutex;
+	bool swapChainRecreationRequested{false};
+	uint32_t requestedWidth{0};
+	uint32_t requestedHeight{0};
+	bool presentModeChangeRequested{false};
+	VkPresentModeKHR requestedPresentMode{VK_PRESENT_MODE_FIFO_KHR};
+	std::string pendingScreenshotFilename;
+	std::unordered_set<std::string> pendingPipelineMaterials;
+
+	/// Present mode of the current swap chain
+	/// Written by the drawing thread, read by the application for display and cycling
+	std::atomic<VkPresentModeKHR> presentMode{VK_PRESENT_MODE_FIFO_KHR};
+
+	/// Present modes offered by the window surface, filled once during initialization
+	std::vector<VkPresentModeKHR> supportedPresentModes;
 };
 
 } /// namespace lillugsi::rendering
\ No newline at end of file
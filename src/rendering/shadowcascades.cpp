@@ -0,0 +1,852 @@
+#include "shadowcascades.h"
+#include "vertex.h"
+#include "vulkan/pipelineconfig.h"
+#include "vulkan/vertexbuffer.h"
+#include "vulkan/indexbuffer.h"
+#include "vulkan/vulkanutils.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lillugsi::rendering {
+
+namespace {
+/// Depth bias of the shadow pass, in depth units and per unit of depth slope
+constexpr float DepthBiasConstant = 1.25f;
+constexpr float DepthBiasSlope = 1.75f;
+
+/// Shading offsets the lookup along the normal by this many texels
+/// Together with the depth bias this removes acne on surfaces facing away from the light
+constexpr float NormalOffsetTexels = 1.5f;
+
+/// Shadows fade out over the last part of the last cascade instead of ending at a hard line
+constexpr float FadeStart = 0.9f;
+
+/// Cascade radii are rounded up to this step
+/// The radius only depends on the projection and splits, but recomputing it every frame
+/// gives slightly different floats, and a changing radius changes the texel size
+constexpr float RadiusStep = 1.0f / 16.0f;
+}
+
+ShadowCascades::ShadowCascades(VkDevice device,
+	VkPhysicalDevice physicalDevice,
+	std::shared_ptr<BufferManager> bufferManager)
+	: device(device)
+	, physicalDevice(physicalDevice)
+	, bufferManager(std::move(bufferManager)) {
+}
+
+ShadowCascades::~ShadowCascades() {
+	this->cleanup();
+}
+
+void ShadowCascades::initialize() {
+	this->createShadowImages();
+	this->createRenderPasses();
+	this->createFramebuffers();
+	this->createPipeline();
+	this->createSampler();
+
+	ShadowParams initialParams{};
+	for (auto& matrix : initialParams.cascadeViewProjections) {
+		matrix = glm::mat4(1.0f);
+	}
+	this->paramsBuffer = this->bufferManager->createUniformBuffer(sizeof(ShadowParams), &initialParams);
+
+	/// Rewritten every frame, mapping once saves a map/unmap pair per update
+	this->mappedParams = static_cast<ShadowParams*>(this->paramsBuffer->map(0, sizeof(ShadowParams)));
+
+	spdlog::info("Cascaded shadow maps initialized with {} cascades of {}x{}, {} cached",
+		CascadeCount, Resolution, Resolution, CachedCascadeCount);
+}
+
+void ShadowCascades::cleanup() {
+	if (this->mappedParams) {
+		this->paramsBuffer->unmap();
+		this->mappedParams = nullptr;
+	}
+	this->paramsBuffer.reset();
+
+	this->sampler.reset();
+	this->pipeline.reset();
+	this->quantizedPipeline.reset();
+	this->instancedPipeline.reset();
+	this->quantizedInstancedPipeline.reset();
+	this->pipelineLayout.reset();
+
+	/// Framebuffers before the views they use, views before their images
+	for (auto& framebuffer : this->cacheFramebuffers) {
+		framebuffer.reset();
+	}
+	for (auto& framebuffer : this->shadowFramebuffers) {
+		framebuffer.reset();
+	}
+	for (auto& view : this->cacheLayerViews) {
+		view.reset();
+	}
+	for (auto& view : this->shadowLayerViews) {
+		view.reset();
+	}
+	this->shadowArrayView.reset();
+
+	this->loadRenderPass.reset();
+	this->clearRenderPass.reset();
+
+	this->cacheImage.reset();
+	this->cacheMemory.reset();
+	this->shadowImage.reset();
+	this->shadowMemory.reset();
+
+	this->shadowImageReady = false;
+	this->cacheValid.fill(false);
+}
+
+void ShadowCascades::createShadowImages() {
+	auto createImage = [this](uint32_t layers, VkImageUsageFlags usage) {
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent = {Resolution, Resolution, 1};
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = layers;
+		imageInfo.format = DepthFormat;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | usage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		VkImage image;
+		VK_CHECK(vkCreateImage(this->device, &imageInfo, nullptr, &image));
+
+		return vulkan::VulkanImageHandle(image, [device = this->device](VkImage i) {
+			vkDestroyImage(device, i, nullptr);
+		});
+	};
+
+	/// The shadow maps receive the cached static depth by copy and are sampled by shading
+	this->shadowImage = createImage(CascadeCount, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+	this->shadowMemory = this->allocateImageMemory(this->shadowImage.get());
+
+	/// The cache is only ever rendered into and copied from
+	this->cacheImage = createImage(CachedCascadeCount, VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+	this->cacheMemory = this->allocateImageMemory(this->cacheImage.get());
+
+	this->shadowArrayView = this->createLayerView(this->shadowImage.get(),
+		VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0, CascadeCount);
+	for (uint32_t i = 0; i < CascadeCount; ++i) {
+		this->shadowLayerViews[i] = this->createLayerView(this->shadowImage.get(),
+			VK_IMAGE_VIEW_TYPE_2D, i, 1);
+	}
+	for (uint32_t i = 0; i < CachedCascadeCount; ++i) {
+		this->cacheLayerViews[i] = this->createLayerView(this->cacheImage.get(),
+			VK_IMAGE_VIEW_TYPE_2D, i, 1);
+	}
+}
+
+vulkan::VulkanDeviceMemoryHandle ShadowCascades::allocateImageMemory(VkImage image) const {
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(this->device, image, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = vulkan::utils::findMemoryType(
+		this->physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDeviceMemory memory;
+	VK_CHECK(vkAllocateMemory(this->device, &allocInfo, nullptr, &memory));
+	VK_CHECK(vkBindImageMemory(this->device, image, memory, 0));
+
+	return vulkan::VulkanDeviceMemoryHandle(memory, [device = this->device](VkDeviceMemory m) {
+		vkFreeMemory(device, m, nullptr);
+	});
+}
+
+vulkan::VulkanImageViewHandle ShadowCascades::createLayerView(VkImage image,
+	VkImageViewType viewType,
+	uint32_t baseLayer,
+	uint32_t layerCount) const {
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = image;
+	viewInfo.viewType = viewType;
+	viewInfo.format = DepthFormat;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = baseLayer;
+	viewInfo.subresourceRange.layerCount = layerCount;
+
+	VkImageView view;
+	VK_CHECK(vkCreateImageView(this->device, &viewInfo, nullptr, &view));
+
+	return vulkan::VulkanImageViewHandle(view, [device = this->device](VkImageView v) {
+		vkDestroyImageView(device, v, nullptr);
+	});
+}
+
+void ShadowCascades::createRenderPasses() {
+	auto createRenderPass = [this](VkAttachmentLoadOp loadOp, VkImageLayout initialLayout) {
+		VkAttachmentDescription depthAttachment{};
+		depthAttachment.format = DepthFormat;
+		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		depthAttachment.loadOp = loadOp;
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		depthAttachment.initialLayout = initialLayout;
+		/// Transitions for sampling and copying are recorded explicitly after the passes
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference depthReference{};
+		depthReference.attachment = 0;
+		depthReference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 0;
+		subpass.pDepthStencilAttachment = &depthReference;
+
+		/// The previous frame sampled the shadow maps and copied from the cache
+		/// We must not overwrite them before those reads are done
+		VkSubpassDependency dependency{};
+		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependency.dstSubpass = 0;
+		dependency.srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+			| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+			| VK_PIPELINE_STAGE_TRANSFER_BIT;
+		dependency.srcAccessMask = 0;
+		dependency.dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT
+			| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependency.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = 1;
+		renderPassInfo.pAttachments = &depthAttachment;
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = 1;
+		renderPassInfo.pDependencies = &dependency;
+
+		VkRenderPass renderPass;
+		VK_CHECK(vkCreateRenderPass(this->device, &renderPassInfo, nullptr, &renderPass));
+
+		return vulkan::VulkanRenderPassHandle(renderPass, [device = this->device](VkRenderPass rp) {
+			vkDestroyRenderPass(device, rp, nullptr);
+		});
+	};
+
+	this->clearRenderPass = createRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR, VK_IMAGE_LAYOUT_UNDEFINED);
+	this->loadRenderPass = createRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD,
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+}
+
+void ShadowCascades::createFramebuffers() {
+	/// Both passes are compatible, so one framebuffer per layer serves both
+	auto createFramebuffer = [this](VkImageView view) {
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = this->clearRenderPass.get();
+		framebufferInfo.attachmentCount = 1;
+		framebufferInfo.pAttachments = &view;
+		framebufferInfo.width = Resolution;
+		framebufferInfo.height = Resolution;
+		framebufferInfo.layers = 1;
+
+		VkFramebuffer framebuffer;
+		VK_CHECK(vkCreateFramebuffer(this->device, &framebufferInfo, nullptr, &framebuffer));
+
+		return vulkan::VulkanFramebufferHandle(framebuffer, [device = this->device](VkFramebuffer fb) {
+			vkDestroyFramebuffer(device, fb, nullptr);
+		});
+	};
+
+	for (uint32_t i = 0; i < CascadeCount; ++i) {
+		this->shadowFramebuffers[i] = createFramebuffer(this->shadowLayerViews[i].get());
+	}
+	for (uint32_t i = 0; i < CachedCascadeCount; ++i) {
+		this->cacheFramebuffers[i] = createFramebuffer(this->cacheLayerViews[i].get());
+	}
+}
+
+void ShadowCascades::createPipeline() {
+	/// The light's view-projection is premultiplied with the model matrix per draw,
+	/// so the shadow pass needs no descriptor sets at all
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout layout;
+	VK_CHECK(vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &layout));
+
+	this->pipelineLayout = vulkan::VulkanPipelineLayoutHandle(layout, [device = this->device](VkPipelineLayout l) {
+		vkDestroyPipelineLayout(device, l, nullptr);
+	});
+
+	/// Only positions are read, but we keep the full vertex stride
+	/// so the regular vertex buffers can be bound without conversion
+	const auto allAttributes = Vertex::getAttributeDescriptions();
+	const std::vector<VkVertexInputAttributeDescription> positionAttribute = {allAttributes[0]};
+
+	vulkan::PipelineConfig config;
+	config.addShaderStage(VK_SHADER_STAGE_VERTEX_BIT, VertexShaderPath);
+	config.setVertexInput(Vertex::getBindingDescription(), positionAttribute);
+	/// No culling: terrain and open meshes have no back faces to cast from
+	config.setRasterization(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	/// Orthographic depth is linear, so shadow maps use regular depth instead of Reverse-Z
+	config.setDepthState(true, true, VK_COMPARE_OP_LESS);
+	config.setDepthBias(true, DepthBiasConstant, DepthBiasSlope);
+	config.setColorAttachmentCount(0);
+
+	auto createInfo = config.getCreateInfo(this->device, this->clearRenderPass.get(), layout);
+
+	VkPipeline rawPipeline;
+	VK_CHECK(vkCreateGraphicsPipelines(this->device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &rawPipeline));
+
+	this->pipeline = vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+
+	/// The variants only differ in vertex input and the vertex shader build
+	const auto createVariant = [this, layout](vulkan::PipelineConfig& variantConfig) {
+		auto variantCreateInfo = variantConfig.getCreateInfo(this->device, this->clearRenderPass.get(), layout);
+
+		VkPipeline rawVariantPipeline;
+		VK_CHECK(vkCreateGraphicsPipelines(
+			this->device, VK_NULL_HANDLE, 1, &variantCreateInfo, nullptr, &rawVariantPipeline));
+
+		return vulkan::VulkanPipelineHandle(rawVariantPipeline, [device = this->device](VkPipeline p) {
+			vkDestroyPipeline(device, p, nullptr);
+		});
+	};
+
+	/// Quantized meshes bind their compact vertices, the shader dequantizes the positions
+	const auto quantizedAttributes = QuantizedVertex::getAttributeDescriptions();
+	config.setVertexInput(QuantizedVertex::getBindingDescription(), {quantizedAttributes[0]});
+	config.setSpecializationConstant(VertexFormatConstantId, static_cast<uint32_t>(VertexFormat::Quantized));
+	this->quantizedPipeline = createVariant(config);
+
+	/// Instanced meshes read their transforms from a second binding, in both layouts
+	config.addShaderStage(VK_SHADER_STAGE_VERTEX_BIT, InstancedVertexShaderPath);
+	config.setInstanceInput(InstanceTransform::getBindingDescription(), InstanceTransform::getAttributeDescriptions());
+	this->quantizedInstancedPipeline = createVariant(config);
+
+	config.setVertexInput(Vertex::getBindingDescription(), positionAttribute);
+	config.setSpecializationConstant(VertexFormatConstantId, static_cast<uint32_t>(VertexFormat::Standard));
+	this->instancedPipeline = createVariant(config);
+}
+
+VkPipeline ShadowCascades::getPipeline(VertexFormat format, bool instanced) const {
+	if (format == VertexFormat::Quantized) {
+		return instanced ? this->quantizedInstancedPipeline.get() : this->quantizedPipeline.get();
+	}
+	return instanced ? this->instancedPipeline.get() : this->pipeline.get();
+}
+
+void ShadowCascades::createSampler() {
+	/// Comparison sampler: with linear filtering every fetch already returns
+	/// a bilinear blend of four depth tests, which smooths the PCF kernel
+	/// Outside the shadow map everything counts as lit
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+
+	VkSampler rawSampler;
+	VK_CHECK(vkCreateSampler(this->device, &samplerInfo, nullptr, &rawSampler));
+
+	this->sampler = vulkan::VulkanSamplerHandle(rawSampler, [device = this->device](VkSampler s) {
+		vkDestroySampler(device, s, nullptr);
+	});
+}
+
+void ShadowCascades::writeDescriptorSet(VkDescriptorSet descriptorSet) const {
+	VkDescriptorBufferInfo bufferInfo{this->paramsBuffer->get(), 0, sizeof(ShadowParams)};
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.sampler = this->sampler.get();
+	imageInfo.imageView = this->shadowArrayView.get();
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+	std::array<VkWriteDescriptorSet, 2> writes{};
+	writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[0].dstSet = descriptorSet;
+	writes[0].dstBinding = 4;
+	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	writes[0].descriptorCount = 1;
+	writes[0].pBufferInfo = &bufferInfo;
+
+	writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writes[1].dstSet = descriptorSet;
+	writes[1].dstBinding = 5;
+	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	writes[1].descriptorCount = 1;
+	writes[1].pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+std::array<float, ShadowCascades::CascadeCount + 1> ShadowCascades::computeSplits(
+	float nearPlane, float shadowDistance) {
+	std::array<float, CascadeCount + 1> splits{};
+	for (uint32_t i = 0; i <= CascadeCount; ++i) {
+		const float fraction = static_cast<float>(i) / static_cast<float>(CascadeCount);
+		const float logarithmic = nearPlane * std::pow(shadowDistance / nearPlane, fraction);
+		const float uniform = nearPlane + (shadowDistance - nearPlane) * fraction;
+		splits[i] = SplitLambda * logarithmic + (1.0f - SplitLambda) * uniform;
+	}
+	return splits;
+}
+
+std::array<ShadowCascades::CascadeSphere, ShadowCascades::CascadeCount> ShadowCascades::computeCascadeSpheres(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	const std::array<float, CascadeCount + 1>& splits) {
+	/// View space rays through the frustum corners, scaled to a view depth of 1
+	/// Any depth on the ray works for unprojecting, we only need its direction
+	const glm::mat4 inverseProjection = glm::inverse(projection);
+	std::array<glm::vec3, 4> rays;
+	const std::array<glm::vec2, 4> corners = {
+		glm::vec2(-1.0f, -1.0f), glm::vec2(1.0f, -1.0f),
+		glm::vec2(-1.0f, 1.0f), glm::vec2(1.0f, 1.0f)
+	};
+	for (size_t i = 0; i < corners.size(); ++i) {
+		glm::vec4 point = inverseProjection * glm::vec4(corners[i], 0.5f, 1.0f);
+		point /= point.w;
+		rays[i] = glm::vec3(point) / -point.z;
+	}
+
+	const glm::mat4 inverseView = glm::inverse(view);
+
+	std::array<CascadeSphere, CascadeCount> spheres{};
+	for (uint32_t cascade = 0; cascade < CascadeCount; ++cascade) {
+		std::array<glm::vec3, 8> points;
+		glm::vec3 centroid(0.0f);
+		for (size_t i = 0; i < rays.size(); ++i) {
+			points[i] = rays[i] * splits[cascade];
+			points[i + 4] = rays[i] * splits[cascade + 1];
+			centroid += points[i] + points[i + 4];
+		}
+		centroid /= 8.0f;
+
+		/// The slice is rigid relative to the camera, so this radius doesn't change
+		/// when the camera turns. A box fitted to the slice in light space would,
+		/// and every size change moves the texel grid
+		float radius = 0.0f;
+		for (const auto& point : points) {
+			radius = std::max(radius, glm::length(point - centroid));
+		}
+
+		spheres[cascade].center = glm::vec3(inverseView * glm::vec4(centroid, 1.0f));
+		spheres[cascade].radius = std::ceil(radius / RadiusStep) * RadiusStep;
+	}
+	return spheres;
+}
+
+glm::mat4 ShadowCascades::computeLightRotation(const glm::vec3& lightDirection) {
+	const glm::vec3 direction = glm::normalize(lightDirection);
+	const glm::vec3 up = std::abs(direction.y) > 0.99f
+		? glm::vec3(0.0f, 0.0f, 1.0f)
+		: glm::vec3(0.0f, 1.0f, 0.0f);
+	return glm::lookAt(glm::vec3(0.0f), direction, up);
+}
+
+glm::mat4 ShadowCascades::computeCasterVolume(const glm::mat4& view,
+	const glm::mat4& projection,
+	float nearPlane,
+	float farPlane,
+	const glm::vec3& lightDirection,
+	const glm::vec3& sceneMin,
+	const glm::vec3& sceneMax) {
+	const float shadowDistance = std::max(std::min(farPlane, MaxShadowDistance), nearPlane * 1.001f);
+	const auto spheres = computeCascadeSpheres(view, projection, computeSplits(nearPlane, shadowDistance));
+
+	/// One sphere around all cascades
+	const glm::vec3 center = (spheres.front().center + spheres.back().center) * 0.5f;
+	float radius = 0.0f;
+	for (const auto& sphere : spheres) {
+		radius = std::max(radius, glm::length(sphere.center - center) + sphere.radius);
+	}
+
+	/// A cached window may lie up to twice its margin off the current cascade
+	radius *= 1.0f + 2.0f * CacheMargin;
+
+	/// Casters between the light and the view throw shadows into it,
+	/// so the volume reaches back to the end of the scene towards the light
+	const glm::mat4 lightRotation = computeLightRotation(lightDirection);
+	const glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+	float nearDepth = -lightCenter.z - radius;
+	const float farDepth = -lightCenter.z + radius;
+	for (int i = 0; i < 8; ++i) {
+		const glm::vec3 corner(
+			(i & 1) ? sceneMax.x : sceneMin.x,
+			(i & 2) ? sceneMax.y : sceneMin.y,
+			(i & 4) ? sceneMax.z : sceneMin.z);
+		nearDepth = std::min(nearDepth, -(lightRotation * glm::vec4(corner, 1.0f)).z);
+	}
+
+	return glm::orthoRH_ZO(lightCenter.x - radius, lightCenter.x + radius,
+		lightCenter.y - radius, lightCenter.y + radius,
+		nearDepth, farDepth) * lightRotation;
+}
+
+ShadowCascades::CascadeWindow ShadowCascades::fitWindow(const CascadeWindow& required, float padding) const {
+	CascadeWindow window;
+	window.radius = required.radius * (1.0f + padding);
+
+	/// Snap to whole texels, so the texel grid doesn't move with the camera
+	const float texelSize = 2.0f * window.radius / static_cast<float>(Resolution);
+	window.center = glm::floor(required.center / texelSize) * texelSize;
+
+	const float depthPadding = required.radius * padding;
+	window.nearDepth = required.nearDepth - depthPadding;
+	window.farDepth = required.farDepth + depthPadding;
+	return window;
+}
+
+glm::mat4 ShadowCascades::computeWindowMatrix(const CascadeWindow& window) const {
+	return glm::orthoRH_ZO(window.center.x - window.radius, window.center.x + window.radius,
+		window.center.y - window.radius, window.center.y + window.radius,
+		window.nearDepth, window.farDepth) * this->lightRotation;
+}
+
+bool ShadowCascades::isCacheUsable(uint32_t cascade, const CascadeWindow& required) const {
+	const uint32_t cacheIndex = cascade - FirstCachedCascade;
+	if (!this->cacheValid[cacheIndex]) {
+		return false;
+	}
+
+	/// The padded radius only changes with the projection, which moves every texel
+	const CascadeWindow& cached = this->windows[cascade];
+	if (cached.radius != required.radius * (1.0f + CacheMargin)) {
+		return false;
+	}
+
+	const glm::vec2 offset = glm::abs(required.center - cached.center) + required.radius;
+	return offset.x <= cached.radius && offset.y <= cached.radius
+		&& required.nearDepth >= cached.nearDepth
+		&& required.farDepth <= cached.farDepth;
+}
+
+void ShadowCascades::update(const FrameSnapshot& snapshot) {
+	for (auto& casters : this->cascadeCasters) {
+		casters.clear();
+	}
+	for (auto& casters : this->staticCasters) {
+		casters.clear();
+	}
+
+	/// The first directional light is the primary one, see LightManager::getLightData
+	this->enabled = snapshot.directionalLightCount > 0
+		&& !snapshot.lights.empty()
+		&& snapshot.lights[0].colorAndIntensity.w > 0.0f;
+	if (!this->enabled) {
+		this->mappedParams->settings.w = 0.0f;
+		return;
+	}
+
+	const glm::vec3 lightDirection = glm::normalize(glm::vec3(snapshot.lights[0].direction));
+	this->lightRotation = computeLightRotation(lightDirection);
+
+	/// A different light or static set invalidates all cached static depth
+	if (glm::dot(lightDirection, this->cachedLightDirection) < 0.99999f
+		|| snapshot.staticRevision != this->cachedStaticRevision) {
+		this->cacheValid.fill(false);
+		this->cachedLightDirection = lightDirection;
+		this->cachedStaticRevision = snapshot.staticRevision;
+	}
+
+	/// Light space bounds of every caster, shared by all cascades
+	/// The absolute rotation transforms the box extent, which gives the exact
+	/// bounds of the rotated box without touching its corners
+	const glm::mat3 rotation(this->lightRotation);
+	glm::mat3 absoluteRotation;
+	for (int column = 0; column < 3; ++column) {
+		absoluteRotation[column] = glm::abs(rotation[column]);
+	}
+
+	float casterNearDepth = std::numeric_limits<float>::max();
+	this->casterBounds.clear();
+	this->casterBounds.reserve(snapshot.shadowCasters.size());
+	for (const auto& caster : snapshot.shadowCasters) {
+		const glm::vec3 center = rotation * ((caster.boundsMin + caster.boundsMax) * 0.5f);
+		const glm::vec3 extent = absoluteRotation * ((caster.boundsMax - caster.boundsMin) * 0.5f);
+
+		LightSpaceBounds bounds{};
+		bounds.min = glm::vec2(center) - glm::vec2(extent);
+		bounds.max = glm::vec2(center) + glm::vec2(extent);
+		bounds.nearDepth = -(center.z + extent.z);
+		bounds.farDepth = -(center.z - extent.z);
+		casterNearDepth = std::min(casterNearDepth, bounds.nearDepth);
+		this->casterBounds.push_back(bounds);
+	}
+
+	const float shadowDistance = std::max(std::min(snapshot.farPlane, MaxShadowDistance),
+		snapshot.nearPlane * 1.001f);
+	const auto splits = computeSplits(snapshot.nearPlane, shadowDistance);
+	const auto spheres = computeCascadeSpheres(snapshot.view, snapshot.projection, splits);
+
+	for (uint32_t cascade = 0; cascade < CascadeCount; ++cascade) {
+		const glm::vec3 lightCenter = rotation * spheres[cascade].center;
+
+		/// The area the cascade must cover, reaching back to the casters nearest the light
+		CascadeWindow required;
+		required.center = glm::vec2(lightCenter);
+		required.radius = spheres[cascade].radius;
+		required.nearDepth = std::min(-lightCenter.z - required.radius, casterNearDepth);
+		required.farDepth = -lightCenter.z + required.radius;
+
+		/// Cached windows keep the matrix their static depth was rendered with
+		const bool cached = cascade >= FirstCachedCascade;
+		if (!cached) {
+			this->windows[cascade] = this->fitWindow(required, 0.0f);
+			this->windows[cascade].viewProjection = this->computeWindowMatrix(this->windows[cascade]);
+		} else if (!this->isCacheUsable(cascade, required)) {
+			/// Refit with a margin so the camera can move a while before the next refit
+			this->windows[cascade] = this->fitWindow(required, CacheMargin);
+			this->windows[cascade].viewProjection = this->computeWindowMatrix(this->windows[cascade]);
+			this->cacheValid[cascade - FirstCachedCascade] = true;
+			this->cacheNeedsRender[cascade - FirstCachedCascade] = true;
+		}
+
+		const CascadeWindow& window = this->windows[cascade];
+
+		/// Pick the casters overlapping the window
+		/// Static casters of cached cascades are only needed when the cache is rendered
+		const bool collectStatic = !cached || this->cacheNeedsRender[cascade - FirstCachedCascade];
+		const glm::vec2 windowMin = window.center - window.radius;
+		const glm::vec2 windowMax = window.center + window.radius;
+		for (uint32_t i = 0; i < this->casterBounds.size(); ++i) {
+			const LightSpaceBounds& bounds = this->casterBounds[i];
+			if (bounds.max.x < windowMin.x || bounds.min.x > windowMax.x
+				|| bounds.max.y < windowMin.y || bounds.min.y > windowMax.y
+				|| bounds.farDepth < window.nearDepth || bounds.nearDepth > window.farDepth) {
+				continue;
+			}
+
+			if (!cached || !snapshot.shadowCasters[i].isStatic) {
+				this->cascadeCasters[cascade].push_back(i);
+			} else if (collectStatic) {
+				this->staticCasters[cascade - FirstCachedCascade].push_back(i);
+			}
+		}
+	}
+
+	ShadowParams& params = *this->mappedParams;
+	for (uint32_t cascade = 0; cascade < CascadeCount; ++cascade) {
+		params.cascadeViewProjections[cascade] = this->windows[cascade].viewProjection;
+		params.cascadeSplits[cascade] = splits[cascade + 1];
+		params.cascadeTexelSizes[cascade] = 2.0f * this->windows[cascade].radius / static_cast<float>(Resolution);
+	}
+	params.settings = glm::vec4(1.0f / static_cast<float>(Resolution), NormalOffsetTexels, FadeStart, 1.0f);
+}
+
+void ShadowCascades::record(VkCommandBuffer commandBuffer, const FrameSnapshot& snapshot) {
+	const VkImage shadowImage = this->shadowImage.get();
+
+	if (!this->enabled) {
+		/// Shading still samples the map, so it needs a valid layout once
+		if (!this->shadowImageReady) {
+			transitionLayers(commandBuffer, shadowImage, 0, CascadeCount,
+				VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+				VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT);
+			this->shadowImageReady = true;
+		}
+		return;
+	}
+
+	for (uint32_t cascade = 0; cascade < CascadeCount; ++cascade) {
+		const CascadeWindow& window = this->windows[cascade];
+
+		if (cascade < FirstCachedCascade) {
+			this->recordPass(commandBuffer, this->clearRenderPass.get(), this->shadowFramebuffers[cascade].get(),
+				window.viewProjection, snapshot, this->cascadeCasters[cascade]);
+			continue;
+		}
+
+		const uint32_t cacheIndex = cascade - FirstCachedCascade;
+		if (this->cacheNeedsRender[cacheIndex]) {
+			this->recordPass(commandBuffer, this->clearRenderPass.get(), this->cacheFramebuffers[cacheIndex].get(),
+				window.viewProjection, snapshot, this->staticCasters[cacheIndex]);
+
+			transitionLayers(commandBuffer, this->cacheImage.get(), cacheIndex, 1,
+				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+			this->cacheNeedsRender[cacheIndex] = false;
+			spdlog::debug("Rendered {} static shadow casters into cached cascade {}",
+				this->staticCasters[cacheIndex].size(), cascade);
+		}
+
+		/// Start from the static depth, then add what moves
+		transitionLayers(commandBuffer, shadowImage, cascade, 1,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+		VkImageCopy copyRegion{};
+		copyRegion.srcSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, cacheIndex, 1};
+		copyRegion.dstSubresource = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, cascade, 1};
+		copyRegion.extent = {Resolution, Resolution, 1};
+		vkCmdCopyImage(commandBuffer,
+			this->cacheImage.get(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			shadowImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &copyRegion);
+
+		transitionLayers(commandBuffer, shadowImage, cascade, 1,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+		this->recordPass(commandBuffer, this->loadRenderPass.get(), this->shadowFramebuffers[cascade].get(),
+			window.viewProjection, snapshot, this->cascadeCasters[cascade]);
+	}
+
+	/// All cascades are sampled by the forward and visibility buffer shading
+	transitionLayers(commandBuffer, shadowImage, 0, CascadeCount,
+		VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+		VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT);
+	this->shadowImageReady = true;
+}
+
+void ShadowCascades::recordPass(VkCommandBuffer commandBuffer,
+	VkRenderPass renderPass,
+	VkFramebuffer framebuffer,
+	const glm::mat4& viewProjection,
+	const FrameSnapshot& snapshot,
+	const std::vector<uint32_t>& casters) const {
+	VkClearValue clearValue{};
+	clearValue.depthStencil = {1.0f, 0};
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = {Resolution, Resolution};
+	renderPassInfo.clearValueCount = 1;
+	renderPassInfo.pClearValues = &clearValue;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	if (!casters.empty()) {
+		VertexFormat boundFormat = VertexFormat::Standard;
+		bool boundInstanced = false;
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.get());
+
+		VkViewport viewport{};
+		viewport.width = static_cast<float>(Resolution);
+		viewport.height = static_cast<float>(Resolution);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor{};
+		scissor.extent = {Resolution, Resolution};
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		for (const uint32_t index : casters) {
+			const auto& data = snapshot.shadowCasters[index].data;
+			if (!data.vertexBuffer || !data.indexBuffer) {
+				continue;
+			}
+
+			/// All pipelines share the layout, so the viewport and scissor stay set
+			const bool instanced = data.instanceBuffer != nullptr;
+			if (data.vertexFormat != boundFormat || instanced != boundInstanced) {
+				boundFormat = data.vertexFormat;
+				boundInstanced = instanced;
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+					this->getPipeline(boundFormat, boundInstanced));
+			}
+
+			PushConstants constants;
+			constants.lightModelViewProj = viewProjection * data.modelMatrix;
+			constants.positionScale = data.dequantization.positionScale;
+			constants.positionOffset = data.dequantization.positionOffset;
+			vkCmdPushConstants(commandBuffer,
+				this->pipelineLayout.get(),
+				VK_SHADER_STAGE_VERTEX_BIT,
+				0,
+				boundFormat == VertexFormat::Quantized ? sizeof(PushConstants) : sizeof(glm::mat4),
+				&constants);
+
+			VkBuffer vertexBuffers[] = {data.vertexBuffer->get()};
+			VkDeviceSize offsets[] = {0};
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, data.indexBuffer->get(), 0, VK_INDEX_TYPE_UINT32);
+			if (instanced) {
+				VkBuffer instanceBuffers[] = {data.instanceBuffer->get()};
+				vkCmdBindVertexBuffers(commandBuffer, 1, 1, instanceBuffers, offsets);
+			}
+
+			vkCmdDrawIndexed(commandBuffer, data.indexBuffer->getIndexCount(),
+				data.instanceCount, 0, 0, data.firstInstance);
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+void ShadowCascades::transitionLayers(VkCommandBuffer commandBuffer,
+	VkImage image,
+	uint32_t baseLayer,
+	uint32_t layerCount,
+	VkImageLayout oldLayout,
+	VkImageLayout newLayout,
+	VkPipelineStageFlags srcStage,
+	VkAccessFlags srcAccess,
+	VkPipelineStageFlags dstStage,
+	VkAccessFlags dstAccess) {
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = 1;
+	barrier.subresourceRange.baseArrayLayer = baseLayer;
+	barrier.subresourceRange.layerCount = layerCount;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		srcStage, dstStage,
+		0,
+		0, nullptr,
+		0, nullptr,
+		1, &barrier);
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include "vulkan/buffer.h"
+#include "buffermanager.h"
+#include "framesnapshot.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// ShadowCascades renders cascaded shadow maps for the primary directional light
+/// The first directional light in the light buffer casts shadows, all others don't.
+///
+/// The view range up to the shadow distance is split into cascades that grow with
+/// distance, each with its own orthographic shadow map in one layer of a depth array.
+/// Cascades are fitted to the bounding sphere of their part of the view frustum and
+/// snapped to whole shadow map texels in a light space without translation. The sphere
+/// doesn't change size when the camera turns, and snapping keeps the texel grid fixed
+/// in the world when it moves, so shadow edges don't shimmer.
+///
+/// Far cascades cover a lot of ground, and most of what is in them doesn't move.
+/// We render the static casters of those cascades into a cache once and only copy it
+/// each frame before adding the dynamic casters. The cache is rebuilt when the light
+/// turns, the static geometry changes, or the camera leaves a padded window around
+/// the cascade. The per frame cost is then the near cascades plus the dynamic casters.
+///
+/// Sampling parameters and the shadow map are bound through the global light
+/// descriptor set (set = 1) at bindings 4 and 5, see shadows.glsl
+class ShadowCascades {
+public:
+	static constexpr const char* VertexShaderPath = "shaders/shadow.vert.spv";
+	static constexpr const char* InstancedVertexShaderPath = "shaders/shadowinstanced.vert.spv";
+
+	/// Number of cascades, matches shadows.glsl
+	static constexpr uint32_t CascadeCount = 4;
+
+	/// Cascades from this index on keep their static casters cached
+	static constexpr uint32_t FirstCachedCascade = 2;
+	static constexpr uint32_t CachedCascadeCount = CascadeCount - FirstCachedCascade;
+
+	/// Size of every cascade's shadow map in texels
+	static constexpr uint32_t Resolution = 2048;
+
+	/// 32 bit float depth, orthographic depth is linear so we need the precision
+	static constexpr VkFormat DepthFormat = VK_FORMAT_D32_SFLOAT;
+
+	/// Shadows end at this view distance, or at the far plane if it is closer
+	static constexpr float MaxShadowDistance = 80.0f;
+
+	/// Blend between logarithmic (1) and uniform (0) cascade splits
+	/// Logarithmic splits match the perspective texel density, but make the first
+	/// cascade tiny, so we lean towards it without going all the way
+	static constexpr float SplitLambda = 0.75f;
+
+	/// Extra radius of cached cascades as a fraction of their fitted radius
+	/// The camera can move this far before a cached cascade has to be refitted
+	static constexpr float CacheMargin = 0.25f;
+
+	/// Constructor
+	/// @param device The logical device to create resources on
+	/// @param physicalDevice The physical device for memory allocation
+	/// @param bufferManager Buffer manager to allocate the parameter buffer from
+	ShadowCascades(VkDevice device, VkPhysicalDevice physicalDevice, std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor
+	~ShadowCascades();
+
+	/// Create the shadow maps, render passes and pipeline
+	void initialize();
+
+	/// Release all Vulkan resources
+	void cleanup();
+
+	/// Point a light descriptor set at the shadow parameters and shadow map
+	/// @param descriptorSet Descriptor set allocated with the global light layout
+	void writeDescriptorSet(VkDescriptorSet descriptorSet) const;
+
+	/// Fit the cascades to a frame and pick the casters of each cascade
+	/// The GPU must no longer read the parameters, which the in-flight fence guarantees
+	/// @param snapshot The frame's snapshot
+	void update(const FrameSnapshot& snapshot);
+
+	/// Record the shadow passes of the cascades fitted in update
+	/// Must be recorded outside of a render pass, before anything samples the shadows
+	/// @param commandBuffer The command buffer being recorded
+	/// @param snapshot The frame's snapshot, the same one passed to update
+	void record(VkCommandBuffer commandBuffer, const FrameSnapshot& snapshot);
+
+	/// Compute the volume that shadow casters of a frame must intersect
+	/// This runs on the update thread before the snapshot is published, so casters outside
+	/// the view are collected too. The volume covers every cascade including the cache margin
+	/// @param view Camera view matrix
+	/// @param projection Camera projection matrix
+	/// @param nearPlane Camera near plane distance
+	/// @param farPlane Camera far plane distance
+	/// @param lightDirection Direction the light shines in
+	/// @param sceneMin Minimum of the scene's world bounds
+	/// @param sceneMax Maximum of the scene's world bounds
+	/// @return View-projection matrix of the volume, for building a culling frustum
+	[[nodiscard]] static glm::mat4 computeCasterVolume(const glm::mat4& view,
+		const glm::mat4& projection,
+		float nearPlane,
+		float farPlane,
+		const glm::vec3& lightDirection,
+		const glm::vec3& sceneMin,
+		const glm::vec3& sceneMax);
+
+private:
+	/// Shadow sampling parameters
+	/// Layout matches ShadowParams in shadows.glsl (std140)
+	struct ShadowParams {
+		std::array<glm::mat4, CascadeCount> cascadeViewProjections;
+		glm::vec4 cascadeSplits;      /// View depth where each cascade ends
+		glm::vec4 cascadeTexelSizes;  /// World size of one shadow map texel per cascade
+		glm::vec4 settings;           /// 1 / resolution, normal offset in texels, fade start, enabled
+	};
+
+	/// Layout matches PushConstants in shadow.glsl.vert
+	/// Standard meshes only push the matrix, the dequantization is read by the quantized pipeline
+	struct PushConstants {
+		glm::mat4 lightModelViewProj;
+		glm::vec4 positionScale;
+		glm::vec4 positionOffset;
+	};
+
+	/// Placement of one cascade in light space
+	struct CascadeWindow {
+		glm::vec2 center{0.0f};  /// Snapped center in light space
+		float radius{0.0f};      /// Half the width of the covered square
+		float nearDepth{0.0f};   /// Depth range along the light direction
+		float farDepth{0.0f};
+		glm::mat4 viewProjection{1.0f};
+	};
+
+	/// Caster bounds in light space, computed once per frame for all cascades
+	struct LightSpaceBounds {
+		glm::vec2 min;
+		glm::vec2 max;
+		float nearDepth;
+		float farDepth;
+	};
+
+	/// Bounding sphere of one cascade's part of the view frustum
+	struct CascadeSphere {
+		glm::vec3 center;
+		float radius;
+	};
+
+	void createShadowImages();
+	void createRenderPasses();
+	void createFramebuffers();
+	void createPipeline();
+	void createSampler();
+
+	/// Get the shadow pipeline for a caster's vertex layout
+	[[nodiscard]] VkPipeline getPipeline(VertexFormat format, bool instanced) const;
+
+	/// Create an image view on one layer, or on all layers for sampling
+	[[nodiscard]] vulkan::VulkanImageViewHandle createLayerView(VkImage image,
+		VkImageViewType viewType,
+		uint32_t baseLayer,
+		uint32_t layerCount) const;
+
+	/// Allocate and bind device local memory for a depth image
+	[[nodiscard]] vulkan::VulkanDeviceMemoryHandle allocateImageMemory(VkImage image) const;
+
+	/// Split distances along the view direction, CascadeCount + 1 values from near to shadow distance
+	[[nodiscard]] static std::array<float, CascadeCount + 1> computeSplits(float nearPlane, float shadowDistance);
+
+	/// Fit spheres around the view frustum between the splits
+	[[nodiscard]] static std::array<CascadeSphere, CascadeCount> computeCascadeSpheres(const glm::mat4& view,
+		const glm::mat4& projection,
+		const std::array<float, CascadeCount + 1>& splits);
+
+	/// Rotation into light space
+	/// We leave out any translation so the texel grid stays put while the camera moves
+	[[nodiscard]] static glm::mat4 computeLightRotation(const glm::vec3& lightDirection);
+
+	/// Build a window around the area a cascade must cover, snapped to whole texels
+	/// @param required Unsnapped area the cascade must cover
+	/// @param padding Extra radius and depth as a fraction of the required radius
+	[[nodiscard]] CascadeWindow fitWindow(const CascadeWindow& required, float padding) const;
+
+	/// Build the orthographic view-projection of a window
+	[[nodiscard]] glm::mat4 computeWindowMatrix(const CascadeWindow& window) const;
+
+	/// Check if a cached window still covers a cascade and its casters
+	[[nodiscard]] bool isCacheUsable(uint32_t cascade, const CascadeWindow& required) const;
+
+	/// Record one depth pass into a framebuffer
+	void recordPass(VkCommandBuffer commandBuffer,
+		VkRenderPass renderPass,
+		VkFramebuffer framebuffer,
+		const glm::mat4& viewProjection,
+		const FrameSnapshot& snapshot,
+		const std::vector<uint32_t>& casters) const;
+
+	/// Change the layout of layers of a shadow image
+	static void transitionLayers(VkCommandBuffer commandBuffer,
+		VkImage image,
+		uint32_t baseLayer,
+		uint32_t layerCount,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		VkPipelineStageFlags srcStage,
+		VkAccessFlags srcAccess,
+		VkPipelineStageFlags dstStage,
+		VkAccessFlags dstAccess);
+
+	VkDevice device;
+	VkPhysicalDevice physicalDevice;
+	std::shared_ptr<BufferManager> bufferManager;
+
+	/// Shadow maps sampled by shading, one layer per cascade
+	vulkan::VulkanImageHandle shadowImage;
+	vulkan::VulkanDeviceMemoryHandle shadowMemory;
+	vulkan::VulkanImageViewHandle shadowArrayView;
+	std::array<vulkan::VulkanImageViewHandle, CascadeCount> shadowLayerViews;
+	std::array<vulkan::VulkanFramebufferHandle, CascadeCount> shadowFramebuffers;
+
+	/// Static casters of the cached cascades, copied into the shadow maps every frame
+	vulkan::VulkanImageHandle cacheImage;
+	vulkan::VulkanDeviceMemoryHandle cacheMemory;
+	std::array<vulkan::VulkanImageViewHandle, CachedCascadeCount> cacheLayerViews;
+	std::array<vulkan::VulkanFramebufferHandle, CachedCascadeCount> cacheFramebuffers;
+
+	/// Two compatible passes: one clears the depth, one keeps the copied static depth
+	vulkan::VulkanRenderPassHandle clearRenderPass;
+	vulkan::VulkanRenderPassHandle loadRenderPass;
+
+	vulkan::VulkanPipelineLayoutHandle pipelineLayout;
+	vulkan::VulkanPipelineHandle pipeline;
+	vulkan::VulkanPipelineHandle quantizedPipeline;  /// For QuantizedVertex meshes
+	vulkan::VulkanPipelineHandle instancedPipeline;  /// For MeshInstances
+	vulkan::VulkanPipelineHandle quantizedInstancedPipeline;
+	vulkan::VulkanSamplerHandle sampler;
+
+	/// Host visible, persistently mapped and rewritten every frame
+	std::shared_ptr<vulkan::Buffer> paramsBuffer;
+	ShadowParams* mappedParams{nullptr};
+
+	/// State of the current frame, filled by update
+	bool enabled{false};
+	glm::mat4 lightRotation{1.0f};
+	std::array<CascadeWindow, CascadeCount> windows;
+	std::vector<LightSpaceBounds> casterBounds;
+	std::array<std::vector<uint32_t>, CascadeCount> cascadeCasters;  /// Indices into the snapshot's casters
+	std::array<std::vector<uint32_t>, CachedCascadeCount> staticCasters;
+
+	/// Cache state of the cached cascades
+	std::array<bool, CachedCascadeCount> cacheValid{};
+	std::array<bool, CachedCascadeCount> cacheNeedsRender{};
+	glm::vec3 cachedLightDirection{0.0f};
+	uint64_t cachedStaticRevision{0};
+
+	/// The shadow maps have been rendered at least once and are in their sampling layout
+	bool shadowImageReady{false};
+};
+
+} /// namespace lillugsi::rendering
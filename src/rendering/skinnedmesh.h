@@ -0,0 +1,87 @@
+#pragma once
+
+#include "mesh.h"
+#include "animation/animator.h"
+#include "scene/boundingbox.h"
+#include "vulkan/buffer.h"
+#include "vulkan/indexbuffer.h"
+#include "vulkan/vertexbuffer.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// Rest pose geometry of a skinned primitive, shared by every character drawing it
+/// Everything here lives on the GPU: the skinning pass reads the rest vertices and
+/// their influences, and writes each character's animated vertices into a buffer of
+/// that character's own
+struct SkinGeometry {
+	std::shared_ptr<vulkan::VertexBuffer> restBuffer;  /// Rest pose vertices, storage usage
+	std::shared_ptr<vulkan::Buffer> influenceBuffer;   /// One SkinInfluence per vertex
+	std::shared_ptr<vulkan::IndexBuffer> indexBuffer;
+	uint32_t vertexCount{0};
+
+	/// Bounds of the rest vertices, and of those each joint influences
+	Mesh::Bounds restBounds{};
+	std::vector<scene::BoundingBox> jointBounds;
+};
+
+/// SkinnedMesh draws a skinned primitive moved by an animator
+/// The mesh draws from a vertex buffer of its own that the skinning pass rewrites every
+/// frame, everything else comes from the shared SkinGeometry. Without an animator it
+/// draws the rest pose straight from the shared geometry, which is what a loader hands
+/// out before it knows which node, and so which skeleton, the primitive belongs to.
+///
+/// Bounds enclose the mesh in every pose its animator can play, see
+/// Animator::computeBounds, so scene nodes never update bounds for animation
+class SkinnedMesh : public Mesh {
+public:
+	/// Create a skinned mesh, buffers are set by the MeshManager
+	/// @param geometry The rest pose geometry
+	/// @param animator Animator moving the mesh, nullptr for the rest pose
+	SkinnedMesh(std::shared_ptr<const SkinGeometry> geometry, std::shared_ptr<animation::Animator> animator)
+		: geometry(std::move(geometry))
+		, animator(std::move(animator)) {
+		this->releasedBounds = this->geometry->restBounds;
+		this->releasedVertexCount = this->geometry->vertexCount;
+	}
+
+	~SkinnedMesh() override = default;
+
+	/// The geometry is on the GPU already, there is nothing to generate
+	void generateGeometry() override {}
+
+	/// Prepare render data, marking animated meshes as skinned
+	void prepareRenderData(RenderData& data) const override {
+		Mesh::prepareRenderData(data);
+		data.skinned = this->animator != nullptr;
+	}
+
+	/// Get the rest pose geometry
+	[[nodiscard]] const std::shared_ptr<const SkinGeometry>& getSkinGeometry() const { return this->geometry; }
+
+	/// Get the animator moving the mesh, nullptr for the rest pose
+	[[nodiscard]] const std::shared_ptr<animation::Animator>& getAnimator() const { return this->animator; }
+
+	/// Set the bounds of the mesh over all its poses
+	void setAnimatedBounds(const scene::BoundingBox& bounds) {
+		if (bounds.isValid()) {
+			this->releasedBounds = Bounds{bounds.getMin(), bounds.getMax()};
+		}
+	}
+
+private:
+	std::shared_ptr<const SkinGeometry> geometry;
+	std::shared_ptr<animation::Animator> animator;
+};
+
+/// One skinned mesh to update in the skinning pass
+/// The shared references keep the buffers alive while the frame using them is recorded
+struct SkinningDispatch {
+	std::shared_ptr<const SkinGeometry> geometry;
+	std::shared_ptr<vulkan::VertexBuffer> output;  /// The mesh's own vertex buffer
+	uint32_t paletteOffset{0};                     /// First joint of the mesh's animator in the palette buffer
+};
+
+} /// namespace lillugsi::rendering
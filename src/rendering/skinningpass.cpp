@@ -0,0 +1,241 @@
+#include "skinningpass.h"
+#include "vulkan/shadermodule.h"
+#include <spdlog/spdlog.h>
+#include <array>
+#include <cstring>
+
+namespace lillugsi::rendering {
+
+SkinningPass::SkinningPass(VkDevice device, std::shared_ptr<BufferManager> bufferManager)
+	: device(device)
+	, bufferManager(std::move(bufferManager)) {
+}
+
+SkinningPass::~SkinningPass() {
+	this->cleanup();
+}
+
+void SkinningPass::initialize() {
+	this->createPipeline();
+	this->createDescriptorPool();
+
+	const VkDeviceSize paletteSize = static_cast<VkDeviceSize>(MaxPaletteJoints) * sizeof(InstanceTransform);
+	this->paletteBuffer = this->bufferManager->createStorageBuffer(paletteSize);
+
+	/// Rewritten every frame, mapping once saves a map/unmap pair per frame
+	this->mappedPalette = static_cast<InstanceTransform*>(this->paletteBuffer->map(0, paletteSize));
+
+	spdlog::info("Skinning pass initialized with room for {} joints", MaxPaletteJoints);
+}
+
+void SkinningPass::cleanup() {
+	if (this->mappedPalette) {
+		this->paletteBuffer->unmap();
+		this->mappedPalette = nullptr;
+	}
+	this->paletteBuffer.reset();
+
+	/// Sets go with their pool
+	this->descriptorSets.clear();
+	this->descriptorPool.reset();
+	this->pipeline.reset();
+	this->pipelineLayout.reset();
+	this->setLayout.reset();
+}
+
+void SkinningPass::createPipeline() {
+	/// 0 rest vertices, 1 influences, 2 joint palettes, 3 the mesh's vertex buffer
+	std::array<VkDescriptorSetLayoutBinding, 4> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); ++i) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	setLayoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout rawSetLayout;
+	VK_CHECK(vkCreateDescriptorSetLayout(this->device, &setLayoutInfo, nullptr, &rawSetLayout));
+	this->setLayout = vulkan::VulkanDescriptorSetLayoutHandle(rawSetLayout,
+		[device = this->device](VkDescriptorSetLayout l) {
+			vkDestroyDescriptorSetLayout(device, l, nullptr);
+		});
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &rawSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout layout;
+	VK_CHECK(vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &layout));
+	this->pipelineLayout = vulkan::VulkanPipelineLayoutHandle(layout, [device = this->device](VkPipelineLayout l) {
+		vkDestroyPipelineLayout(device, l, nullptr);
+	});
+
+	auto shaderModule = vulkan::ShaderModule::fromSpirV(this->device, ShaderPath, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shaderModule.getStageCreateInfo();
+	pipelineInfo.layout = layout;
+
+	VkPipeline rawPipeline;
+	VK_CHECK(vkCreateComputePipelines(this->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &rawPipeline));
+	this->pipeline = vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+}
+
+void SkinningPass::createDescriptorPool() {
+	VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MaxSkinnedMeshes * 4};
+
+	/// Characters come and go, so their sets are freed one by one
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = MaxSkinnedMeshes;
+
+	VkDescriptorPool rawPool;
+	VK_CHECK(vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &rawPool));
+	this->descriptorPool = vulkan::VulkanDescriptorPoolHandle(rawPool, [device = this->device](VkDescriptorPool p) {
+		vkDestroyDescriptorPool(device, p, nullptr);
+	});
+}
+
+VkDescriptorSet SkinningPass::getDescriptorSet(const SkinningDispatch& dispatch) {
+	const auto it = this->descriptorSets.find(dispatch.output.get());
+	if (it != this->descriptorSets.end()) {
+		return it->second.set;
+	}
+
+	VkDescriptorSetLayout rawSetLayout = this->setLayout.get();
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = this->descriptorPool.get();
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &rawSetLayout;
+
+	VkDescriptorSet set = VK_NULL_HANDLE;
+	const VkResult result = vkAllocateDescriptorSets(this->device, &allocInfo, &set);
+	if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+		return VK_NULL_HANDLE;
+	}
+	VK_CHECK(result);
+
+	const auto& geometry = *dispatch.geometry;
+	std::array<VkDescriptorBufferInfo, 4> bufferInfos{};
+	bufferInfos[0] = {geometry.restBuffer->get(), 0, geometry.restBuffer->getSize()};
+	bufferInfos[1] = {geometry.influenceBuffer->get(), 0, geometry.influenceBuffer->getSize()};
+	bufferInfos[2] = {this->paletteBuffer->get(), 0, this->paletteBuffer->getSize()};
+	bufferInfos[3] = {dispatch.output->get(), 0, dispatch.output->getSize()};
+
+	std::array<VkWriteDescriptorSet, 4> writes{};
+	for (uint32_t i = 0; i < writes.size(); ++i) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = set;
+		writes[i].dstBinding = i;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].descriptorCount = 1;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	this->descriptorSets.emplace(dispatch.output.get(), MeshDescriptorSet{set, dispatch.geometry, dispatch.output});
+	return set;
+}
+
+void SkinningPass::releaseUnusedSets() {
+	/// The previous frame is done on the GPU, so a set held only by us isn't in use.
+	/// Its mesh is gone, and the output buffer can't come back under the same address
+	/// while we still hold it
+	for (auto it = this->descriptorSets.begin(); it != this->descriptorSets.end();) {
+		if (it->second.output.use_count() > 1) {
+			++it;
+			continue;
+		}
+		VK_CHECK(vkFreeDescriptorSets(this->device, this->descriptorPool.get(), 1, &it->second.set));
+		it = this->descriptorSets.erase(it);
+	}
+}
+
+void SkinningPass::record(VkCommandBuffer commandBuffer, const FrameSnapshot& snapshot) {
+	this->releaseUnusedSets();
+	if (snapshot.skinning.empty()) {
+		return;
+	}
+
+	/// The collector never hands out more than the buffer holds. Host writes are visible
+	/// to the GPU once the command buffer is submitted, no barrier needed
+	std::memcpy(this->mappedPalette, snapshot.jointPalettes.data(),
+		snapshot.jointPalettes.size() * sizeof(InstanceTransform));
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline.get());
+
+	uint32_t skinnedVertices = 0;
+	uint32_t skippedMeshes = 0;
+	for (const auto& dispatch : snapshot.skinning) {
+		const VkDescriptorSet set = this->getDescriptorSet(dispatch);
+		if (set == VK_NULL_HANDLE) {
+			++skippedMeshes;
+			continue;
+		}
+
+		PushConstants pushConstants{};
+		pushConstants.vertexCount = dispatch.geometry->vertexCount;
+		pushConstants.paletteOffset = dispatch.paletteOffset;
+
+		vkCmdBindDescriptorSets(commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			this->pipelineLayout.get(),
+			0, 1, &set,
+			0, nullptr);
+		vkCmdPushConstants(commandBuffer,
+			this->pipelineLayout.get(),
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0, sizeof(PushConstants), &pushConstants);
+
+		vkCmdDispatch(commandBuffer, (pushConstants.vertexCount + WorkgroupSize - 1) / WorkgroupSize, 1, 1);
+		skinnedVertices += pushConstants.vertexCount;
+	}
+
+	/// Vertices are read as geometry, by the visibility buffer passes and by copies of the buffer
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+		| VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+			| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+
+	for (const auto& dispatch : snapshot.skinning) {
+		dispatch.output->markContentChanged();
+	}
+
+	if (skippedMeshes > 0 && !this->poolFull) {
+		spdlog::warn("Skinning descriptor pool is full, {} meshes keep their last pose", skippedMeshes);
+	}
+	this->poolFull = skippedMeshes > 0;
+	spdlog::trace("Recorded skinning of {} meshes with {} vertices", snapshot.skinning.size(), skinnedVertices);
+}
+
+} /// namespace lillugsi::rendering
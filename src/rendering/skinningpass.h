@@ -0,0 +1,108 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include "vulkan/buffer.h"
+#include "vulkan/vertexbuffer.h"
+#include "buffermanager.h"
+#include "framesnapshot.h"
+#include "skinnedmesh.h"
+#include "vertex.h"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+namespace lillugsi::rendering {
+
+/// SkinningPass moves the vertices of skinned meshes on the GPU
+/// Animators evaluate joint palettes on the CPU, a few dozen matrices per character.
+/// Moving the vertices with them is the expensive part, thousands per character, so a
+/// compute pass does it:
+/// - The palettes of all characters are copied into one persistently mapped buffer.
+/// - Each skinned mesh is one dispatch reading its rest pose and influences from the
+///   shared SkinGeometry and writing positions and directions into its own vertex buffer.
+/// - Everything drawing the meshes afterwards, shadows included, sees the animated
+///   vertices as plain geometry.
+///
+/// One frame is in flight, so the palette buffer is rewritten only after the GPU is done
+/// with the previous frame, a single buffer is enough
+class SkinningPass {
+public:
+	static constexpr const char* ShaderPath = "shaders/skinning.comp.spv";
+
+	/// Invocations per workgroup, matches local_size_x in skinning.glsl.comp
+	static constexpr uint32_t WorkgroupSize = 64;
+
+	/// Joints the palette buffer holds for all characters together
+	/// A thousand characters with a hundred joints each, 6 MB of palette
+	static constexpr uint32_t MaxPaletteJoints = 131072;
+
+	/// Skinned meshes that can have a descriptor set at the same time
+	static constexpr uint32_t MaxSkinnedMeshes = 4096;
+
+	/// Constructor
+	/// @param device The logical device to create the pipeline on
+	/// @param bufferManager Buffer manager to allocate the palette buffer from
+	SkinningPass(VkDevice device, std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor
+	~SkinningPass();
+
+	/// Create the pipeline, the descriptor pool and the palette buffer
+	void initialize();
+
+	/// Release all Vulkan resources
+	void cleanup();
+
+	/// Record the skinning of the snapshot's skinned meshes
+	/// Must be recorded outside of a render pass, before anything draws the meshes.
+	/// The GPU must be done with the previous frame, the palette buffer is rewritten
+	/// @param commandBuffer The command buffer being recorded
+	/// @param snapshot The frame's palettes and skinned meshes
+	void record(VkCommandBuffer commandBuffer, const FrameSnapshot& snapshot);
+
+private:
+	/// Layout matches SkinningParams in skinning.glsl.comp
+	struct PushConstants {
+		uint32_t vertexCount;
+		uint32_t paletteOffset;
+	};
+
+	/// Descriptor set of a skinned mesh, with the buffers it refers to
+	/// The references keep the buffers alive for as long as the set may be used
+	struct MeshDescriptorSet {
+		VkDescriptorSet set{VK_NULL_HANDLE};
+		std::shared_ptr<const SkinGeometry> geometry;
+		std::shared_ptr<vulkan::VertexBuffer> output;
+	};
+
+	void createPipeline();
+	void createDescriptorPool();
+
+	/// Get the descriptor set of a mesh, writing a new one the first time
+	/// @return The set, or VK_NULL_HANDLE if the pool is exhausted
+	[[nodiscard]] VkDescriptorSet getDescriptorSet(const SkinningDispatch& dispatch);
+
+	/// Free the sets of meshes nothing else refers to anymore
+	void releaseUnusedSets();
+
+	VkDevice device;
+	std::shared_ptr<BufferManager> bufferManager;
+
+	vulkan::VulkanDescriptorSetLayoutHandle setLayout;
+	vulkan::VulkanPipelineLayoutHandle pipelineLayout;
+	vulkan::VulkanPipelineHandle pipeline;
+	vulkan::VulkanDescriptorPoolHandle descriptorPool;
+
+	std::shared_ptr<vulkan::Buffer> paletteBuffer;
+	InstanceTransform* mappedPalette{nullptr};
+
+	/// Sets by the output buffer of their mesh
+	std::unordered_map<const vulkan::VertexBuffer*, MeshDescriptorSet> descriptorSets;
+
+	/// Whether meshes were skipped in the last frame, to warn once
+	bool poolFull{false};
+};
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,370 @@
+#include "spheredisplacement.h"
+#include "vulkan/shadermodule.h"
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/noise.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace lillugsi::rendering {
+
+namespace {
+
+/// CPU versions of the functions in spheredisplace.glsl.comp, kept step by step the same
+
+float fbm(const SphereDisplacement::Parameters& parameters, const glm::vec3& p) {
+	float value = 0.0f;
+	float amplitude = 1.0f;
+	float frequency = parameters.frequency;
+	float maxValue = 0.0f;
+
+	for (uint32_t i = 0; i < parameters.octaves; ++i) {
+		value += glm::simplex(p * frequency) * amplitude;
+		maxValue += amplitude;
+		amplitude *= parameters.persistence;
+		frequency *= parameters.lacunarity;
+	}
+
+	return maxValue > 0.0f ? value / maxValue : 0.0f;
+}
+
+glm::vec3 displace(const SphereDisplacement::Parameters& parameters, float radius, const glm::vec3& direction) {
+	const glm::vec3 dir = glm::normalize(direction);
+	const float height = 1.0f + parameters.amplitude * fbm(parameters, dir + parameters.offset);
+	return dir * radius * height;
+}
+
+} /// namespace
+
+SphereDisplacement::SphereDisplacement(VkDevice device, std::shared_ptr<BufferManager> bufferManager)
+	: device(device)
+	, bufferManager(std::move(bufferManager)) {
+}
+
+SphereDisplacement::~SphereDisplacement() {
+	this->cleanup();
+}
+
+void SphereDisplacement::initialize() {
+	this->createPipeline();
+	this->createDescriptorSet();
+
+	spdlog::info("Sphere displacement initialized");
+}
+
+void SphereDisplacement::cleanup() {
+	this->descriptorSet = VK_NULL_HANDLE;
+	this->descriptorPool.reset();
+	this->pipeline.reset();
+	this->pipelineLayout.reset();
+	this->setLayout.reset();
+
+	this->directionBuffer.reset();
+	this->vertexBuffer.reset();
+	this->directions.clear();
+	this->mesh.reset();
+}
+
+void SphereDisplacement::createPipeline() {
+	/// 0 base directions, 1 the vertex buffer
+	std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); ++i) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	setLayoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout rawSetLayout;
+	VK_CHECK(vkCreateDescriptorSetLayout(this->device, &setLayoutInfo, nullptr, &rawSetLayout));
+	this->setLayout = vulkan::VulkanDescriptorSetLayoutHandle(rawSetLayout,
+		[device = this->device](VkDescriptorSetLayout l) {
+			vkDestroyDescriptorSetLayout(device, l, nullptr);
+		});
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &rawSetLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout layout;
+	VK_CHECK(vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &layout));
+	this->pipelineLayout = vulkan::VulkanPipelineLayoutHandle(layout, [device = this->device](VkPipelineLayout l) {
+		vkDestroyPipelineLayout(device, l, nullptr);
+	});
+
+	auto shaderModule = vulkan::ShaderModule::fromSpirV(this->device, ShaderPath, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shaderModule.getStageCreateInfo();
+	pipelineInfo.layout = layout;
+
+	VkPipeline rawPipeline;
+	VK_CHECK(vkCreateComputePipelines(this->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &rawPipeline));
+	this->pipeline = vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+}
+
+void SphereDisplacement::createDescriptorSet() {
+	VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2};
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = 1;
+
+	VkDescriptorPool rawPool;
+	VK_CHECK(vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &rawPool));
+	this->descriptorPool = vulkan::VulkanDescriptorPoolHandle(rawPool, [device = this->device](VkDescriptorPool p) {
+		vkDestroyDescriptorPool(device, p, nullptr);
+	});
+
+	VkDescriptorSetLayout rawSetLayout = this->setLayout.get();
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = rawPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &rawSetLayout;
+	VK_CHECK(vkAllocateDescriptorSets(this->device, &allocInfo, &this->descriptorSet));
+}
+
+void SphereDisplacement::attach(std::shared_ptr<IcosphereMesh> mesh) {
+	if (!mesh || !mesh->getIndexBuffer() || mesh->getVertices().empty()) {
+		throw vulkan::VulkanException(
+			VK_ERROR_VALIDATION_FAILED_EXT,
+			"Displaced sphere needs generated geometry and buffers",
+			__FUNCTION__, __FILE__, __LINE__
+		);
+	}
+
+	const auto& vertices = mesh->getVertices();
+
+	/// Directions are padded to vec4, which std430 arrays of vec3 would do anyway
+	this->directions.clear();
+	this->directions.reserve(vertices.size());
+	std::vector<glm::vec4> paddedDirections;
+	paddedDirections.reserve(vertices.size());
+	for (const auto& vertex : vertices) {
+		const glm::vec3 direction = glm::normalize(vertex.position);
+		this->directions.push_back(direction);
+		paddedDirections.emplace_back(direction, 0.0f);
+	}
+
+	const VkDeviceSize directionSize = paddedDirections.size() * sizeof(glm::vec4);
+	this->directionBuffer = this->bufferManager->createDeviceStorageBuffer(directionSize, paddedDirections.data());
+
+	/// Cached or shared vertex buffers may be drawn by other meshes, so the sphere
+	/// gets one of its own. The index buffer stays shared
+	this->vertexBuffer = this->bufferManager->createStorageVertexBuffer(vertices);
+	mesh->setBuffers(this->vertexBuffer, mesh->getIndexBuffer());
+	this->mesh = std::move(mesh);
+	this->updateBounds();
+
+	std::array<VkDescriptorBufferInfo, 2> bufferInfos{};
+	bufferInfos[0] = {this->directionBuffer->get(), 0, directionSize};
+	bufferInfos[1] = {this->vertexBuffer->get(), 0, this->vertexBuffer->getSize()};
+
+	std::array<VkWriteDescriptorSet, 2> writes{};
+	for (uint32_t i = 0; i < writes.size(); ++i) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = this->descriptorSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].descriptorCount = 1;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->dirty = true;
+
+	spdlog::info("Displacing sphere with {} vertices on the GPU", this->directions.size());
+}
+
+void SphereDisplacement::setParameters(const Parameters& parameters) {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->parameters = parameters;
+	this->dirty = true;
+}
+
+SphereDisplacement::Parameters SphereDisplacement::getParameters() const {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	return this->parameters;
+}
+
+void SphereDisplacement::updateBounds() {
+	if (!this->mesh) {
+		return;
+	}
+	this->mesh->setDisplacedBounds(getDisplacedBounds(this->getParameters(), this->mesh->getRadius()));
+}
+
+Mesh::Bounds SphereDisplacement::getDisplacedBounds(const Parameters& parameters, float radius) {
+	const float extent = radius * (1.0f + std::abs(parameters.amplitude));
+	return Mesh::Bounds{glm::vec3(-extent), glm::vec3(extent)};
+}
+
+void SphereDisplacement::record(VkCommandBuffer commandBuffer) {
+	if (!this->mesh) {
+		return;
+	}
+
+	Parameters current;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (!this->dirty) {
+			return;
+		}
+		current = this->parameters;
+		this->dirty = false;
+	}
+	this->recordedParameters = current;
+
+	const auto vertexCount = static_cast<uint32_t>(this->directions.size());
+
+	PushConstants pushConstants{};
+	pushConstants.offsetRadius = glm::vec4(current.offset, this->mesh->getRadius());
+	pushConstants.frequency = current.frequency;
+	pushConstants.amplitude = current.amplitude;
+	pushConstants.persistence = current.persistence;
+	pushConstants.lacunarity = current.lacunarity;
+	pushConstants.octaves = current.octaves;
+	pushConstants.vertexCount = vertexCount;
+	pushConstants.normalOffset = getNormalOffset(vertexCount);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->pipeline.get());
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		this->pipelineLayout.get(),
+		0, 1, &this->descriptorSet,
+		0, nullptr);
+	vkCmdPushConstants(commandBuffer,
+		this->pipelineLayout.get(),
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0, sizeof(PushConstants), &pushConstants);
+
+	vkCmdDispatch(commandBuffer, (vertexCount + WorkgroupSize - 1) / WorkgroupSize, 1, 1);
+
+	/// Vertices are read as geometry, by the visibility buffer passes and by copies of the buffer
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+		| VK_ACCESS_TRANSFER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+			| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+
+	this->vertexBuffer->markContentChanged();
+
+	if (!this->parityChecked) {
+		this->parityCheckPending = true;
+	}
+
+	spdlog::trace("Recorded displacement of {} sphere vertices", vertexCount);
+}
+
+void SphereDisplacement::displaceOnCpu(const Parameters& parameters,
+	float radius,
+	const std::vector<glm::vec3>& directions,
+	std::vector<Vertex>& vertices) {
+	if (vertices.size() != directions.size()) {
+		throw vulkan::VulkanException(
+			VK_ERROR_VALIDATION_FAILED_EXT,
+			"Vertex count doesn't match direction count",
+			__FUNCTION__, __FILE__, __LINE__
+		);
+	}
+
+	const float normalOffset = getNormalOffset(directions.size());
+	for (size_t i = 0; i < directions.size(); ++i) {
+		const glm::vec3& dir = directions[i];
+		const glm::vec3 position = displace(parameters, radius, dir);
+
+		const glm::vec3 helper = std::abs(dir.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+		const glm::vec3 t1 = glm::normalize(glm::cross(helper, dir));
+		const glm::vec3 t2 = glm::cross(dir, t1);
+		const glm::vec3 p1 = displace(parameters, radius, dir + t1 * normalOffset);
+		const glm::vec3 p2 = displace(parameters, radius, dir + t2 * normalOffset);
+
+		vertices[i].position = position;
+		vertices[i].normal = glm::normalize(glm::cross(p1 - position, p2 - position));
+	}
+}
+
+float SphereDisplacement::checkParity() {
+	if (!this->mesh) {
+		return 0.0f;
+	}
+
+	const VkDeviceSize size = this->directions.size() * sizeof(Vertex);
+	auto readbackBuffer = this->bufferManager->createReadbackBuffer(size);
+	this->bufferManager->copyBuffer(this->vertexBuffer->get(), readbackBuffer->get(), size);
+
+	std::vector<Vertex> gpuVertices(this->directions.size());
+	const void* mapped = readbackBuffer->map(0, size);
+	std::memcpy(gpuVertices.data(), mapped, size);
+	readbackBuffer->unmap();
+
+	std::vector<Vertex> cpuVertices = this->mesh->getVertices();
+	const float radius = this->mesh->getRadius();
+	displaceOnCpu(this->recordedParameters, radius, this->directions, cpuVertices);
+
+	float maxPositionError = 0.0f;
+	float maxNormalError = 0.0f;
+	for (size_t i = 0; i < cpuVertices.size(); ++i) {
+		maxPositionError = std::max(maxPositionError,
+			glm::length(gpuVertices[i].position - cpuVertices[i].position));
+		maxNormalError = std::max(maxNormalError,
+			glm::length(gpuVertices[i].normal - cpuVertices[i].normal));
+	}
+
+	const float relativeError = maxPositionError / radius;
+	spdlog::info("Sphere displacement parity: max position error {:.2e} of the radius, max normal error {:.2e}",
+		relativeError, maxNormalError);
+	return relativeError;
+}
+
+void SphereDisplacement::checkFirstDisplacement() {
+	if (!this->parityCheckPending) {
+		return;
+	}
+	this->parityCheckPending = false;
+	this->parityChecked = true;
+
+	const float relativeError = this->checkParity();
+	if (relativeError > ParityTolerance) {
+		spdlog::warn("Sphere displacement on the GPU differs from the CPU reference by {:.2e} of the radius",
+			relativeError);
+	}
+}
+
+float SphereDisplacement::getNormalOffset(size_t vertexCount) {
+	/// Vertices cover the unit sphere evenly, each one about 4 pi / count of it
+	return std::sqrt(4.0f * glm::pi<float>() / static_cast<float>(std::max<size_t>(vertexCount, 1)));
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include "vulkan/buffer.h"
+#include "vulkan/vertexbuffer.h"
+#include "buffermanager.h"
+#include "icospheremesh.h"
+#include "vertex.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// SphereDisplacement turns a sphere mesh into noise displaced terrain on the GPU
+/// Displacing on the CPU means evaluating several octaves of noise three times per
+/// vertex (the position and two neighbours for the normal) and uploading the whole
+/// vertex buffer afterwards. At high subdivision levels that takes seconds, far too
+/// long to tweak noise parameters and look at the result. Instead:
+/// - The undisplaced unit directions are uploaded once and stay in a GPU buffer.
+/// - A compute pass writes displaced positions and normals straight into the
+///   mesh's vertex buffer, only in frames after the parameters changed.
+/// - Tangents, colors and texture coordinates keep the values of the base sphere.
+///
+/// The mesh's CPU vertices stay those of the undisplaced sphere. Its bounds are set to
+/// the largest radius the noise can reach instead, so culling keeps the whole surface.
+/// displaceOnCpu computes the same result on the CPU as a reference, checkParity
+/// compares both. The first displacement is checked once
+/// through checkFirstDisplacement, so a shader that drifted from the CPU port shows
+/// up in the log without a debug build.
+class SphereDisplacement {
+public:
+	static constexpr const char* ShaderPath = "shaders/spheredisplace.comp.spv";
+
+	/// Invocations per workgroup, matches local_size_x in spheredisplace.glsl.comp
+	static constexpr uint32_t WorkgroupSize = 64;
+
+	/// Noise the sphere is displaced with
+	struct Parameters {
+		float frequency{1.5f};     /// Frequency of the first octave on the unit sphere
+		float amplitude{0.1f};     /// Largest displacement relative to the radius
+		uint32_t octaves{6};       /// Number of noise layers to combine
+		float persistence{0.5f};   /// How quickly amplitude decreases per octave
+		float lacunarity{2.0f};    /// How quickly frequency increases per octave
+		glm::vec3 offset{0.0f};    /// Moves the sphere through the noise, acts as a seed
+	};
+
+	/// Constructor
+	/// @param device The logical device to create the pipeline on
+	/// @param bufferManager Buffer manager to allocate the buffers from
+	SphereDisplacement(VkDevice device, std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor
+	~SphereDisplacement();
+
+	/// Create the pipeline and the descriptor set
+	void initialize();
+
+	/// Release all Vulkan resources
+	/// The attached mesh keeps drawing from its displaced vertex buffer
+	void cleanup();
+
+	/// Displace a sphere from now on
+	/// The mesh gets a vertex buffer of its own that the compute pass can write.
+	/// Must not be called while a frame using the mesh is being recorded
+	/// @param mesh Sphere whose buffers were created by the MeshManager
+	void attach(std::shared_ptr<IcosphereMesh> mesh);
+
+	/// Set the noise, the sphere is displaced again in the next frame
+	/// Safe to call from any thread
+	/// @param parameters The new noise parameters
+	void setParameters(const Parameters& parameters);
+
+	/// Get the current noise parameters
+	[[nodiscard]] Parameters getParameters() const;
+
+	/// Give the mesh the bounds of the current noise
+	/// Must be called on the thread owning the scene, after setParameters changed the
+	/// amplitude. Nodes drawing the mesh then need their bounds refreshed
+	void updateBounds();
+
+	/// Get the bounds of a sphere displaced with some noise
+	/// The noise is normalized to [-1, 1], so no vertex gets further out than this
+	/// @param parameters The noise parameters
+	/// @param radius Base radius of the sphere
+	/// @return Bounds enclosing every displaced vertex
+	[[nodiscard]] static Mesh::Bounds getDisplacedBounds(const Parameters& parameters, float radius);
+
+	/// Record the displacement pass if the parameters changed
+	/// Must be recorded outside of a render pass, before the mesh is drawn
+	/// @param commandBuffer The command buffer being recorded
+	void record(VkCommandBuffer commandBuffer);
+
+	/// Compute displaced positions and normals on the CPU
+	/// Runs the same steps as the compute shader, with glm::simplex being a port of the
+	/// same noise. Results agree up to floating point differences between CPU and GPU
+	/// @param parameters The noise parameters
+	/// @param radius Base radius of the sphere
+	/// @param directions Unit direction of each vertex
+	/// @param vertices Vertices to write positions and normals into, one per direction
+	static void displaceOnCpu(const Parameters& parameters,
+		float radius,
+		const std::vector<glm::vec3>& directions,
+		std::vector<Vertex>& vertices);
+
+	/// Compare the GPU result with the CPU reference
+	/// Reads the vertex buffer back, so the GPU must be done with the last displacement.
+	/// Meant for tests and debugging, it waits for the transfer to finish
+	/// @return Largest distance between GPU and CPU positions, relative to the radius
+	[[nodiscard]] float checkParity();
+
+	/// Compare the first recorded displacement with the CPU reference, once
+	/// Does nothing before the first displacement and after the check ran.
+	/// Must be called once the GPU finished the frame the displacement was recorded in
+	void checkFirstDisplacement();
+
+private:
+	/// Largest position error relative to the radius we accept without a warning
+	/// Simplex noise in float differs between CPU and GPU in the last bits per octave
+	static constexpr float ParityTolerance = 1e-3f;
+
+	/// Layout matches DisplacementParams in spheredisplace.glsl.comp
+	struct PushConstants {
+		glm::vec4 offsetRadius;
+		float frequency;
+		float amplitude;
+		float persistence;
+		float lacunarity;
+		uint32_t octaves;
+		uint32_t vertexCount;
+		float normalOffset;
+		float padding;
+	};
+
+	/// Angle between the samples taken for a normal
+	/// We use the average vertex spacing, so normals follow the detail the mesh can show
+	[[nodiscard]] static float getNormalOffset(size_t vertexCount);
+
+	void createPipeline();
+	void createDescriptorSet();
+
+	VkDevice device;
+	std::shared_ptr<BufferManager> bufferManager;
+
+	vulkan::VulkanDescriptorSetLayoutHandle setLayout;
+	vulkan::VulkanPipelineLayoutHandle pipelineLayout;
+	vulkan::VulkanPipelineHandle pipeline;
+	vulkan::VulkanDescriptorPoolHandle descriptorPool;
+	VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+
+	std::shared_ptr<IcosphereMesh> mesh;
+	std::vector<glm::vec3> directions;
+	std::shared_ptr<vulkan::Buffer> directionBuffer;
+	std::shared_ptr<vulkan::VertexBuffer> vertexBuffer;
+
+	/// Parameters of the last recorded displacement, what checkParity compares against
+	Parameters recordedParameters;
+
+	/// Set when the first displacement is recorded, cleared once it was checked
+	bool parityCheckPending{false};
+	bool parityChecked{false};
+
+	/// Shared with setParameters, guarded by mutex
+	mutable std::mutex mutex;
+	Parameters parameters;
+	bool dirty{false};
+};
+
+} /// namespace lillugsi::rendering
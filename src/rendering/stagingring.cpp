@@ -0,0 +1,170 @@
+#include "stagingring.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+
+namespace lillugsi::rendering {
+
+StagingRing::StagingRing(std::shared_ptr<BufferManager> bufferManager)
+	: bufferManager(std::move(bufferManager)) {
+}
+
+StagingRing::~StagingRing() {
+	this->cleanup();
+}
+
+void StagingRing::initialize(VkDeviceSize segmentSize) {
+	this->segmentSize = segmentSize;
+	this->stagingBuffer = this->bufferManager->createStagingBuffer(segmentSize * SegmentCount);
+	this->mappedStaging = static_cast<uint8_t*>(this->stagingBuffer->map(0, segmentSize * SegmentCount));
+
+	spdlog::info("Staging ring created with {} segments of {} KB", SegmentCount, segmentSize / 1024);
+}
+
+void StagingRing::cleanup() {
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->pendingCopies.clear();
+	this->inFlightDestinations.clear();
+	if (this->mappedStaging) {
+		this->stagingBuffer->unmap();
+		this->mappedStaging = nullptr;
+	}
+	this->stagingBuffer.reset();
+}
+
+bool StagingRing::enqueue(const std::shared_ptr<vulkan::Buffer>& destination,
+	VkDeviceSize offset,
+	const void* data,
+	VkDeviceSize size) {
+	if (size == 0) {
+		return true;
+	}
+	if (!destination || offset + size > destination->getSize()) {
+		throw vulkan::VulkanException(
+			VK_ERROR_VALIDATION_FAILED_EXT,
+			"Staged update exceeds destination buffer size",
+			__FUNCTION__, __FILE__, __LINE__
+		);
+	}
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	if (!this->mappedStaging || this->openSegmentUsed + size > this->segmentSize) {
+		return false;
+	}
+
+	const VkDeviceSize stagingOffset = this->openSegment * this->segmentSize + this->openSegmentUsed;
+	std::memcpy(this->mappedStaging + stagingOffset, data, size);
+	this->openSegmentUsed += size;
+
+	/// Data is appended to the segment, so a copy continuing the previous one in the
+	/// destination is contiguous on both sides and simply extends it
+	if (!this->pendingCopies.empty()) {
+		VkBufferCopy& last = this->pendingCopies.back().region;
+		if (this->pendingCopies.back().destination == destination
+			&& last.srcOffset + last.size == stagingOffset
+			&& last.dstOffset + last.size == offset) {
+			last.size += size;
+			return true;
+		}
+	}
+
+	VkBufferCopy region{};
+	region.srcOffset = stagingOffset;
+	region.dstOffset = offset;
+	region.size = size;
+	this->pendingCopies.push_back(PendingCopy{destination, region});
+	return true;
+}
+
+void StagingRing::record(VkCommandBuffer commandBuffer) {
+	std::vector<PendingCopy> copies;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->inFlightDestinations.clear();
+		if (this->pendingCopies.empty()) {
+			return;
+		}
+		copies.swap(this->pendingCopies);
+		this->openSegment = (this->openSegment + 1) % SegmentCount;
+		this->openSegmentUsed = 0;
+	}
+
+	/// Regions of one copy command land in no particular order, so a copy overlapping
+	/// an earlier one in the same destination starts a new batch after a barrier
+	std::vector<PendingCopy> batch;
+	for (const auto& copy : copies) {
+		const bool overlaps = std::any_of(batch.begin(), batch.end(), [&copy](const PendingCopy& other) {
+			return other.destination == copy.destination
+				&& other.region.dstOffset < copy.region.dstOffset + copy.region.size
+				&& copy.region.dstOffset < other.region.dstOffset + other.region.size;
+		});
+		if (overlaps) {
+			this->recordBatch(commandBuffer, batch);
+			batch.clear();
+
+			VkMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			vkCmdPipelineBarrier(commandBuffer,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				0, 1, &barrier, 0, nullptr, 0, nullptr);
+		}
+		batch.push_back(copy);
+	}
+	this->recordBatch(commandBuffer, batch);
+
+	/// Destinations are read as geometry, by compute passes and as the source of other copies
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT
+		| VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
+			| VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+	/// Copies of the destinations made elsewhere compare content versions to refresh
+	std::vector<std::shared_ptr<vulkan::Buffer>> destinations;
+	for (const auto& copy : copies) {
+		if (std::find(destinations.begin(), destinations.end(), copy.destination) == destinations.end()) {
+			copy.destination->markContentChanged();
+			destinations.push_back(copy.destination);
+		}
+	}
+
+	spdlog::trace("Recorded {} staged copies into {} buffers", copies.size(), destinations.size());
+
+	std::lock_guard<std::mutex> lock(this->mutex);
+	this->inFlightDestinations = std::move(destinations);
+}
+
+void StagingRing::recordBatch(VkCommandBuffer commandBuffer, const std::vector<PendingCopy>& batch) {
+	/// One copy command per destination with all of its regions
+	std::vector<bool> recorded(batch.size(), false);
+	std::vector<VkBufferCopy> regions;
+	for (size_t i = 0; i < batch.size(); ++i) {
+		if (recorded[i]) {
+			continue;
+		}
+
+		regions.clear();
+		for (size_t j = i; j < batch.size(); ++j) {
+			if (!recorded[j] && batch[j].destination == batch[i].destination) {
+				regions.push_back(batch[j].region);
+				recorded[j] = true;
+			}
+		}
+
+		vkCmdCopyBuffer(commandBuffer,
+			this->stagingBuffer->get(),
+			batch[i].destination->get(),
+			static_cast<uint32_t>(regions.size()),
+			regions.data());
+	}
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "vulkan/buffer.h"
+#include "buffermanager.h"
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// StagingRing uploads small changes into existing device buffers
+/// BufferManager::updateBuffer creates a staging buffer per call and waits for the
+/// copy to finish, and replacing a buffer means allocating and uploading all of it.
+/// Both are far too slow for edits that touch a few vertices per frame. We keep one
+/// persistently mapped staging buffer instead, split into segments used in turns:
+/// - Changes are copied into the open segment as soon as they are queued, so the
+///   caller's data can change again right away.
+/// - The render thread records all queued copies into its frame's command buffer,
+///   then the other segment opens. With one frame in flight, its copies finished
+///   when the frame's fence was waited on.
+/// - Queued copies that continue each other in the same destination are merged into
+///   one region, so runs of edits become one copy.
+///
+/// Changes that don't fit into the open segment are refused, the caller falls back
+/// to uploading the whole buffer.
+class StagingRing {
+public:
+	/// Segments of the ring, one more than there are frames in flight
+	static constexpr uint32_t SegmentCount = 2;
+
+	/// Constructor
+	/// @param bufferManager Buffer manager to allocate the staging buffer from
+	explicit StagingRing(std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor
+	~StagingRing();
+
+	/// Create and map the staging buffer
+	/// @param segmentSize Bytes that can be queued per frame
+	void initialize(VkDeviceSize segmentSize);
+
+	/// Release the staging buffer, queued copies are dropped
+	void cleanup();
+
+	/// Queue a copy of data into a device buffer
+	/// Safe to call from any thread. The data is copied before this returns
+	/// @param destination Buffer to write, must have been created with TRANSFER_DST usage
+	/// @param offset Byte offset in the destination
+	/// @param data Data to write
+	/// @param size Number of bytes to write
+	/// @return False if the change doesn't fit into this frame's segment
+	[[nodiscard]] bool enqueue(const std::shared_ptr<vulkan::Buffer>& destination,
+		VkDeviceSize offset,
+		const void* data,
+		VkDeviceSize size);
+
+	/// Record the queued copies and open the next segment
+	/// Must be recorded outside of a render pass, before the destinations are read.
+	/// The GPU must be done with the previous frame, which the in-flight fence guarantees
+	/// @param commandBuffer The command buffer being recorded
+	void record(VkCommandBuffer commandBuffer);
+
+	/// Get the number of bytes that can be queued per frame
+	[[nodiscard]] VkDeviceSize getSegmentSize() const { return this->segmentSize; }
+
+private:
+	/// A copy waiting to be recorded
+	struct PendingCopy {
+		std::shared_ptr<vulkan::Buffer> destination;
+		VkBufferCopy region;
+	};
+
+	/// Record one batch of copies with non-overlapping destination ranges
+	void recordBatch(VkCommandBuffer commandBuffer, const std::vector<PendingCopy>& batch);
+
+	std::shared_ptr<BufferManager> bufferManager;
+
+	/// SegmentCount segments of segmentSize bytes, mapped for the lifetime of the ring
+	std::shared_ptr<vulkan::Buffer> stagingBuffer;
+	uint8_t* mappedStaging{nullptr};
+	VkDeviceSize segmentSize{0};
+
+	/// Guards everything below, copies are queued from the update thread
+	std::mutex mutex;
+	uint32_t openSegment{0};
+	VkDeviceSize openSegmentUsed{0};
+	std::vector<PendingCopy> pendingCopies;
+
+	/// Destinations of the copies recorded last frame, kept alive until they finished
+	std::vector<std::shared_ptr<vulkan::Buffer>> inFlightDestinations;
+};
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,303 @@
+#include "terrainbaker.h"
+#include "vulkan/vulkanexception.h"
+#include <FastNoise/FastNoise.h>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <array>
+#include <limits>
+
+namespace lillugsi::rendering {
+
+namespace {
+/// Texels of a chunk including its one texel border
+constexpr uint32_t GridSize = TerrainBaker::ChunkSize + 2;
+constexpr uint32_t GridCount = GridSize * GridSize;
+
+/// Maximum number of biomes, matches the fixed array in TerrainMaterial::Properties
+constexpr uint32_t MaxBiomes = 4;
+
+/// Fold bytes into an FNV-1a hash
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+	const auto* bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint64_t hashNoise(uint64_t hash, const TerrainMaterial::NoiseParameters& noise) {
+	hash = hashBytes(hash, &noise.baseFrequency, sizeof(float));
+	hash = hashBytes(hash, &noise.amplitude, sizeof(float));
+	hash = hashBytes(hash, &noise.octaves, sizeof(uint32_t));
+	hash = hashBytes(hash, &noise.persistence, sizeof(float));
+	hash = hashBytes(hash, &noise.lacunarity, sizeof(float));
+	return hash;
+}
+
+/// Build a fractal matching the shader's fbm for a parameter set
+/// Frequency isn't part of the node, positions are scaled by it before generating
+FastNoise::SmartNode<FastNoise::FractalFBm> createFractal(const TerrainMaterial::NoiseParameters& params,
+	TerrainMaterial::TransitionType type) {
+	auto fractal = FastNoise::New<FastNoise::FractalFBm>();
+	if (type == TerrainMaterial::TransitionType::Worley) {
+		fractal->SetSource(FastNoise::New<FastNoise::CellularDistance>());
+	} else {
+		fractal->SetSource(FastNoise::New<FastNoise::Simplex>());
+	}
+	fractal->SetOctaveCount(static_cast<int>(std::max(params.octaves, 1u)));
+	fractal->SetGain(params.persistence);
+	fractal->SetLacunarity(params.lacunarity);
+	return fractal;
+}
+}
+
+TerrainChunk TerrainBaker::bakeChunk(const TerrainMaterial::Properties& properties,
+	const TerrainMaterial::NoiseParameters& elevation,
+	int32_t seed,
+	uint32_t faceSize,
+	uint32_t chunkId) {
+	if (faceSize == 0 || faceSize % ChunkSize != 0) {
+		throw vulkan::VulkanException(
+			VK_ERROR_VALIDATION_FAILED_EXT,
+			"Terrain face size must be a multiple of " + std::to_string(ChunkSize),
+			__FUNCTION__, __FILE__, __LINE__);
+	}
+	if (chunkId >= getChunkCount(faceSize)) {
+		throw vulkan::VulkanException(
+			VK_ERROR_VALIDATION_FAILED_EXT,
+			"Terrain chunk " + std::to_string(chunkId) + " is out of range",
+			__FUNCTION__, __FILE__, __LINE__);
+	}
+
+	const TerrainChunkLocation location = getChunkLocation(faceSize, chunkId);
+	const int32_t originX = static_cast<int32_t>(location.chunkX * ChunkSize) - 1;
+	const int32_t originY = static_cast<int32_t>(location.chunkY * ChunkSize) - 1;
+
+	/// Directions of the chunk's texel centers, the border reaches slightly past the face
+	/// edge, which still gives valid directions into the neighbouring face's area
+	std::vector<glm::vec3> directions(GridCount);
+	for (uint32_t y = 0; y < GridSize; ++y) {
+		for (uint32_t x = 0; x < GridSize; ++x) {
+			const float u = (static_cast<float>(originX + static_cast<int32_t>(x)) + 0.5f)
+				/ static_cast<float>(faceSize) * 2.0f - 1.0f;
+			const float v = (static_cast<float>(originY + static_cast<int32_t>(y)) + 0.5f)
+				/ static_cast<float>(faceSize) * 2.0f - 1.0f;
+			directions[y * GridSize + x] = glm::normalize(cubeFaceDirection(location.face, u, v));
+		}
+	}
+
+	/// Building the node trees is cheap next to evaluating a chunk,
+	/// so every chunk gets its own and workers share nothing
+	const auto elevationNoise = createFractal(elevation, TerrainMaterial::TransitionType::Simplex);
+
+	const uint32_t biomeCount = std::min(properties.numBiomes, MaxBiomes);
+	const uint32_t transitionCount = biomeCount > 0 ? biomeCount - 1 : 0;
+
+	/// FastNoise2 evaluates position arrays in SIMD batches
+	std::vector<float> positionsX(GridCount);
+	std::vector<float> positionsY(GridCount);
+	std::vector<float> positionsZ(GridCount);
+	auto generate = [&](const FastNoise::SmartNode<FastNoise::FractalFBm>& generator,
+		float frequency,
+		std::vector<float>& output) {
+		for (uint32_t i = 0; i < GridCount; ++i) {
+			positionsX[i] = directions[i].x * frequency;
+			positionsY[i] = directions[i].y * frequency;
+			positionsZ[i] = directions[i].z * frequency;
+		}
+		output.resize(GridCount);
+		generator->GenPositionArray3D(output.data(), static_cast<int>(GridCount),
+			positionsX.data(), positionsY.data(), positionsZ.data(),
+			0.0f, 0.0f, 0.0f, seed);
+	};
+
+	/// Elevation is remapped from the noise range to the biomes' 0 to 1 height range
+	std::vector<float> heights;
+	generate(elevationNoise, elevation.baseFrequency, heights);
+	for (float& height : heights) {
+		height = std::clamp(0.5f + 0.5f * elevation.amplitude * height, 0.0f, 1.0f);
+	}
+
+	/// Transition of biome i into biome i + 1
+	std::array<std::vector<float>, MaxBiomes> transitionNoise;
+	for (uint32_t i = 0; i < transitionCount; ++i) {
+		const auto& transition = properties.biomes[i].transition;
+		const auto generator = createFractal(transition.noise,
+			static_cast<TerrainMaterial::TransitionType>(transition.type));
+		generate(generator, transition.scale * transition.noise.baseFrequency, transitionNoise[i]);
+	}
+
+	TerrainChunk chunk;
+	chunk.id = chunkId;
+	chunk.surface.resize(ChunkSize * ChunkSize * 4);
+	chunk.biomeWeights.resize(ChunkSize * ChunkSize * 4);
+
+	for (uint32_t y = 1; y <= ChunkSize; ++y) {
+		for (uint32_t x = 1; x <= ChunkSize; ++x) {
+			const uint32_t i = y * GridSize + x;
+			const glm::vec3& direction = directions[i];
+			const float height = heights[i];
+
+			/// Normal of the displaced surface from central differences
+			auto surfacePoint = [&](uint32_t index) {
+				return directions[index] * (1.0f + heights[index] * properties.heightScale);
+			};
+			glm::vec3 normal = glm::cross(
+				surfacePoint(i + 1) - surfacePoint(i - 1),
+				surfacePoint(i + GridSize) - surfacePoint(i - GridSize));
+			normal = glm::length(normal) > 0.0f ? glm::normalize(normal) : direction;
+			if (glm::dot(normal, direction) < 0.0f) {
+				normal = -normal;
+			}
+
+			/// Inside the overlap of two biomes, the transition noise of the lower one
+			/// moves the height the blend sees, so the border between them meanders
+			float blendHeight = height;
+			for (uint32_t b = 0; b < transitionCount; ++b) {
+				const auto& lower = properties.biomes[b];
+				const auto& upper = properties.biomes[b + 1];
+				const float overlapStart = std::max(lower.minHeight, upper.minHeight);
+				const float overlapEnd = std::min(lower.maxHeight, upper.maxHeight);
+				if (overlapEnd > overlapStart && height >= overlapStart && height <= overlapEnd) {
+					blendHeight += transitionNoise[b][i] * lower.transition.noise.amplitude
+						* (overlapEnd - overlapStart) * 0.5f;
+					break;
+				}
+			}
+
+			std::array<float, MaxBiomes> weights{};
+			float totalWeight = 0.0f;
+			for (uint32_t b = 0; b < biomeCount; ++b) {
+				weights[b] = calculateHeightInfluence(properties, b, blendHeight);
+				totalWeight += weights[b];
+			}
+
+			/// Heights outside every range take the closest biome instead of no color
+			if (totalWeight <= 0.0f && biomeCount > 0) {
+				uint32_t closest = 0;
+				float closestDistance = std::numeric_limits<float>::max();
+				for (uint32_t b = 0; b < biomeCount; ++b) {
+					const auto& biome = properties.biomes[b];
+					const float distance = std::max(biome.minHeight - blendHeight, blendHeight - biome.maxHeight);
+					if (distance < closestDistance) {
+						closestDistance = distance;
+						closest = b;
+					}
+				}
+				weights[closest] = 1.0f;
+				totalWeight = 1.0f;
+			}
+
+			const size_t texel = (static_cast<size_t>(y - 1) * ChunkSize + (x - 1)) * 4;
+
+			chunk.surface[texel + 0] = glm::packHalf1x16(normal.x);
+			chunk.surface[texel + 1] = glm::packHalf1x16(normal.y);
+			chunk.surface[texel + 2] = glm::packHalf1x16(normal.z);
+			chunk.surface[texel + 3] = glm::packHalf1x16(height);
+
+			for (uint32_t b = 0; b < MaxBiomes; ++b) {
+				const float weight = totalWeight > 0.0f ? weights[b] / totalWeight : 0.0f;
+				chunk.biomeWeights[texel + b] = static_cast<uint8_t>(weight * 255.0f + 0.5f);
+			}
+		}
+	}
+
+	return chunk;
+}
+
+uint32_t TerrainBaker::getChunkCount(uint32_t faceSize) {
+	const uint32_t chunksPerEdge = faceSize / ChunkSize;
+	return chunksPerEdge * chunksPerEdge * 6;
+}
+
+TerrainChunkLocation TerrainBaker::getChunkLocation(uint32_t faceSize, uint32_t chunkId) {
+	const uint32_t chunksPerEdge = faceSize / ChunkSize;
+	const uint32_t chunksPerFace = chunksPerEdge * chunksPerEdge;
+	const uint32_t faceChunk = chunkId % chunksPerFace;
+	return TerrainChunkLocation{chunkId / chunksPerFace, faceChunk % chunksPerEdge, faceChunk / chunksPerEdge};
+}
+
+float TerrainBaker::calculateHeightInfluence(const TerrainMaterial::Properties& properties,
+	uint32_t biome,
+	float height) {
+	const auto& current = properties.biomes[biome];
+	if (height < current.minHeight || height > current.maxHeight) {
+		return 0.0f;
+	}
+
+	float influence = 1.0f;
+	const uint32_t biomeCount = std::min(properties.numBiomes, MaxBiomes);
+	for (uint32_t other = 0; other < biomeCount; ++other) {
+		if (other == biome) {
+			continue;
+		}
+
+		const auto& neighbour = properties.biomes[other];
+		const float overlapStart = std::max(current.minHeight, neighbour.minHeight);
+		const float overlapEnd = std::min(current.maxHeight, neighbour.maxHeight);
+		if (overlapStart > overlapEnd || height < neighbour.minHeight || height > neighbour.maxHeight) {
+			continue;
+		}
+		if (height >= current.maxHeight || height <= neighbour.minHeight) {
+			continue;
+		}
+
+		const float range = overlapEnd - overlapStart;
+		float t = range < 0.0001f ? 0.5f : (height - overlapStart) / range;
+
+		/// Sharp transitions narrow the blend towards the middle of the overlap
+		const float sharpness = std::clamp(
+			properties.biomes[std::min(biome, other)].transition.transitionSharpness, 0.0f, 0.99f);
+		const float edge = 0.5f * sharpness;
+		t = std::clamp((t - edge) / (1.0f - 2.0f * edge), 0.0f, 1.0f);
+		t = t * t * (3.0f - 2.0f * t);
+
+		/// Invert the blend direction when the neighbour lies above
+		if (neighbour.minHeight > current.minHeight) {
+			t = 1.0f - t;
+		}
+
+		influence = std::min(influence, t);
+	}
+
+	return influence;
+}
+
+uint64_t TerrainBaker::computeInputHash(const TerrainMaterial::Properties& properties,
+	const TerrainMaterial::NoiseParameters& elevation,
+	int32_t seed,
+	uint32_t faceSize) {
+	uint64_t hash = 0xcbf29ce484222325ull;
+	hash = hashBytes(hash, &faceSize, sizeof(faceSize));
+	hash = hashBytes(hash, &seed, sizeof(seed));
+	hash = hashBytes(hash, &properties.heightScale, sizeof(float));
+	hash = hashBytes(hash, &properties.numBiomes, sizeof(uint32_t));
+	hash = hashNoise(hash, elevation);
+
+	const uint32_t biomeCount = std::min(properties.numBiomes, MaxBiomes);
+	for (uint32_t i = 0; i < biomeCount; ++i) {
+		const auto& biome = properties.biomes[i];
+		hash = hashBytes(hash, &biome.minHeight, sizeof(float));
+		hash = hashBytes(hash, &biome.maxHeight, sizeof(float));
+		hash = hashBytes(hash, &biome.transition.type, sizeof(uint32_t));
+		hash = hashBytes(hash, &biome.transition.scale, sizeof(float));
+		hash = hashBytes(hash, &biome.transition.transitionSharpness, sizeof(float));
+		hash = hashNoise(hash, biome.transition.noise);
+	}
+
+	return hash;
+}
+
+glm::vec3 TerrainBaker::cubeFaceDirection(uint32_t face, float u, float v) {
+	switch (face) {
+	case 0: return {1.0f, -v, -u};
+	case 1: return {-1.0f, -v, u};
+	case 2: return {u, 1.0f, v};
+	case 3: return {u, -1.0f, -v};
+	case 4: return {u, -v, 1.0f};
+	default: return {-u, -v, -1.0f};
+	}
+}
+
+} /// namespace lillugsi::rendering
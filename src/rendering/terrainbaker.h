@@ -0,0 +1,91 @@
+#pragma once
+
+#include "terrainmaterial.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// Surface fields of one chunk, a square tile of a cube map face
+/// Texels are stored row by row, ChunkSize x ChunkSize of them
+struct TerrainChunk {
+	uint32_t id{0};
+
+	/// RGBA16F texels: object space normal in rgb, normalized elevation in a
+	std::vector<uint16_t> surface;
+
+	/// RGBA8 texels: weight of biome 0 to 3, summing to one
+	std::vector<uint8_t> biomeWeights;
+};
+
+/// Position of a chunk in the cube map
+struct TerrainChunkLocation {
+	uint32_t face;    /// Face index in Vulkan cube map order +X, -X, +Y, -Y, +Z, -Z
+	uint32_t chunkX;  /// Column of the chunk within its face
+	uint32_t chunkY;  /// Row of the chunk within its face
+};
+
+/// TerrainBaker generates the surface fields of a terrain material on the CPU
+/// Planet terrain doesn't change while it is viewed, so evaluating noise and biome
+/// blending for every pixel of every frame repeats the same work. We evaluate it
+/// once per cube map texel instead and let the shaders sample the result.
+///
+/// Faces are split into chunks that are baked independently, so a planet can be
+/// generated piece by piece on worker threads and cached per chunk. Each chunk fills
+/// position arrays and lets FastNoise2 evaluate them with SIMD, one fractal per noise
+/// parameter set. Chunks carry a one texel border so normals can use central
+/// differences without looking into neighbouring chunks or faces.
+class TerrainBaker {
+public:
+	/// Edge length of a chunk in texels, without its border
+	static constexpr uint32_t ChunkSize = 64;
+
+	/// Bake the fields of one chunk
+	/// Only reads its arguments, so any number of chunks can be baked in parallel
+	/// @param properties Biome parameters, only height ranges and transitions are used
+	/// @param elevation Noise shaping the planet's elevation
+	/// @param seed Seed of all noise generators
+	/// @param faceSize Edge length of a cube face in texels, a multiple of ChunkSize
+	/// @param chunkId Chunk to bake, below getChunkCount(faceSize)
+	/// @return The baked chunk
+	[[nodiscard]] static TerrainChunk bakeChunk(const TerrainMaterial::Properties& properties,
+		const TerrainMaterial::NoiseParameters& elevation,
+		int32_t seed,
+		uint32_t faceSize,
+		uint32_t chunkId);
+
+	/// Get the number of chunks of all six faces
+	/// @param faceSize Edge length of a cube face in texels, a multiple of ChunkSize
+	[[nodiscard]] static uint32_t getChunkCount(uint32_t faceSize);
+
+	/// Get where a chunk lies in the cube map
+	/// Chunks are numbered face by face, row by row
+	[[nodiscard]] static TerrainChunkLocation getChunkLocation(uint32_t faceSize, uint32_t chunkId);
+
+	/// Hash everything bakeChunk reads
+	/// Colors and surface parameters are shaded from the uniform buffer, so changing
+	/// them keeps the hash and with it the baked fields
+	/// @return Hash identifying the bake inputs
+	[[nodiscard]] static uint64_t computeInputHash(const TerrainMaterial::Properties& properties,
+		const TerrainMaterial::NoiseParameters& elevation,
+		int32_t seed,
+		uint32_t faceSize);
+
+	/// Direction through a point of a cube face
+	/// @param face Face index in Vulkan cube map order
+	/// @param u Horizontal face coordinate, -1 to 1 across the face
+	/// @param v Vertical face coordinate, -1 to 1 across the face
+	/// @return Unnormalized direction, matches cube map sampling
+	[[nodiscard]] static glm::vec3 cubeFaceDirection(uint32_t face, float u, float v);
+
+private:
+	/// Influence of a biome at a height, with smooth transitions through overlapping ranges
+	/// Follows the height blending the terrain shader used before baking, with each
+	/// overlap sharpened by the transition of its lower biome
+	[[nodiscard]] static float calculateHeightInfluence(const TerrainMaterial::Properties& properties,
+		uint32_t biome,
+		float height);
+};
+
+} /// namespace lillugsi::rendering
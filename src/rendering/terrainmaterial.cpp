@@ -1,7 +1,9 @@
 #include "terrainmaterial.h"
+#include "terrainbaker.h"
 #include "vulkan/vulkanexception.h"
 #include "vulkan/vulkanutils.h"
 #include <spdlog/spdlog.h>
+#include <array>
 
 namespace lillugsi::rendering {
 
@@ -198,6 +200,16 @@ TerrainMaterial::TerrainMaterial(
 	/// This can be adjusted later based on actual planet size
 	this->properties.planetRadius = 1.0f;
 
+	/// Broad continents with some detail, elevation stays within 5% of the radius
+	this->elevationNoise = {
+		1.5f,  /// Low frequency for continent sized features
+		1.0f,  /// Use the full height range
+		6,     /// Enough octaves for coastlines and ridges
+		0.5f,  /// Standard persistence
+		2.0f   /// Standard lacunarity
+	};
+	this->properties.heightScale = 0.05f;
+
 	/// Start with normal rendering mode
 	this->properties.debugMode = static_cast<uint32_t>(TerrainDebugMode::None);
 
@@ -319,6 +331,102 @@ void TerrainMaterial::setNoiseParameters(const uint32_t index, const NoiseParame
 		index, this->name);
 }
 
+void TerrainMaterial::setElevation(const NoiseParameters& params, float heightScale) {
+	if (heightScale < 0.0f) {
+		throw vulkan::VulkanException(
+			VK_ERROR_VALIDATION_FAILED_EXT,
+			"Invalid height scale in terrain material '" + this->name + "'",
+			__FUNCTION__, __FILE__, __LINE__
+		);
+	}
+
+	this->elevationNoise = params;
+	this->properties.heightScale = heightScale;
+	this->updateUniformBuffer();
+
+	spdlog::debug("Updated elevation of material '{}', height scale {}", this->name, heightScale);
+}
+
+void TerrainMaterial::setSeed(int32_t seed) {
+	this->seed = seed;
+	spdlog::debug("Updated noise seed of material '{}' to {}", this->name, seed);
+}
+
+bool TerrainMaterial::updateFields(VkCommandPool commandPool,
+	VkQueue queue,
+	vulkan::CommandBufferManager& commandBufferManager) {
+	/// Setters only change parameters, resetting only happens if something the fields depend on changed
+	const uint64_t hash = TerrainBaker::computeInputHash(
+		this->properties, this->elevationNoise, this->seed, FieldFaceSize);
+	if (this->fieldsCreated && hash == this->fieldHash) {
+		return false;
+	}
+
+	if (!this->surfaceTexture) {
+		/// A single level, streamed chunks are written in place and would leave
+		/// the lower mips stale. The shaders sample these at the top level anyway
+		this->surfaceTexture = std::make_shared<Texture>(this->device, this->physicalDevice,
+			FieldFaceSize, FieldFaceSize, VK_FORMAT_R16G16B16A16_SFLOAT, 1, 6, this->name + " surface");
+		this->biomeWeightTexture = std::make_shared<Texture>(this->device, this->physicalDevice,
+			FieldFaceSize, FieldFaceSize, VK_FORMAT_R8G8B8A8_UNORM, 1, 6, this->name + " biome weights");
+
+		/// Faces meet at their edges, clamping keeps filtering from wrapping across a face
+		this->surfaceTexture->configureSampler(Texture::FilterMode::Linear, Texture::FilterMode::Linear,
+			Texture::WrapMode::ClampToEdge, Texture::WrapMode::ClampToEdge, false);
+		this->biomeWeightTexture->configureSampler(Texture::FilterMode::Linear, Texture::FilterMode::Linear,
+			Texture::WrapMode::ClampToEdge, Texture::WrapMode::ClampToEdge, false);
+	} else {
+		/// The images are rewritten in place, earlier frames must be done sampling them
+		VK_CHECK(vkQueueWaitIdle(queue));
+	}
+
+	/// Zero elevation and normals, and everything in the first biome
+	const size_t texelCount = static_cast<size_t>(FieldFaceSize) * FieldFaceSize * 6;
+	const std::vector<uint16_t> emptySurface(texelCount * 4, 0);
+	std::vector<uint8_t> emptyWeights(texelCount * 4, 0);
+	for (size_t i = 0; i < texelCount; ++i) {
+		emptyWeights[i * 4] = 255;
+	}
+
+	this->surfaceTexture->uploadData(emptySurface.data(), emptySurface.size() * sizeof(uint16_t),
+		commandPool, queue, commandBufferManager);
+	this->biomeWeightTexture->uploadData(emptyWeights.data(), emptyWeights.size(),
+		commandPool, queue, commandBufferManager);
+
+	if (!this->fieldsCreated) {
+		this->writeFieldDescriptors();
+	}
+
+	this->fieldHash = hash;
+	this->fieldsCreated = true;
+
+	spdlog::info("Reset terrain fields of material '{}' for streaming", this->name);
+	return true;
+}
+
+void TerrainMaterial::writeFieldDescriptors() {
+	std::array<VkDescriptorImageInfo, 2> imageInfos{};
+	imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfos[0].imageView = this->surfaceTexture->getImageView();
+	imageInfos[0].sampler = this->surfaceTexture->getSampler();
+	imageInfos[1].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfos[1].imageView = this->biomeWeightTexture->getImageView();
+	imageInfos[1].sampler = this->biomeWeightTexture->getSampler();
+
+	std::array<VkWriteDescriptorSet, 2> writes{};
+	for (uint32_t i = 0; i < writes.size(); ++i) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = this->descriptorSet;
+		writes[i].dstBinding = i + 1;
+		writes[i].dstArrayElement = 0;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		writes[i].descriptorCount = 1;
+		writes[i].pImageInfo = &imageInfos[i];
+	}
+
+	vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
 void TerrainMaterial::setDebugMode(const TerrainDebugMode mode) {
 	/// Update debug mode and sync to GPU
 	this->properties.debugMode = static_cast<uint32_t>(mode);
@@ -329,18 +437,30 @@ void TerrainMaterial::setDebugMode(const TerrainDebugMode mode) {
 }
 
 void TerrainMaterial::createDescriptorSetLayout() {
-	/// Create the descriptor layout for our uniform buffer
-	VkDescriptorSetLayoutBinding binding{};
-	binding.binding = 0;
-	binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	binding.descriptorCount = 1;
-	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;  /// Used in fragment shader for biome coloring
-	binding.pImmutableSamplers = nullptr;
+	/// Create the descriptor layout for our uniform buffer and the baked fields
+	/// The vertex shader reads the radius and displaces by the baked elevation
+	std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+	bindings[0].binding = 0;
+	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+	bindings[0].descriptorCount = 1;
+	bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	/// Normal and elevation cube map
+	bindings[1].binding = 1;
+	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[1].descriptorCount = 1;
+	bindings[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	/// Biome weight cube map
+	bindings[2].binding = 2;
+	bindings[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	bindings[2].descriptorCount = 1;
+	bindings[2].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 	VkDescriptorSetLayoutCreateInfo layoutInfo{};
 	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo.bindingCount = 1;
-	layoutInfo.pBindings = &binding;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
 
 	VkDescriptorSetLayout layout;
 	VK_CHECK(vkCreateDescriptorSetLayout(this->device, &layoutInfo, nullptr, &layout));
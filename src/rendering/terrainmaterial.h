@@ -1,15 +1,23 @@
 #pragma once
 
 #include "material.h"
+#include "texture.h"
 #include "vulkan/vulkanwrappers.h"
+#include "vulkan/commandbuffermanager.h"
 #include <glm/glm.hpp>
+#include <memory>
 
 namespace lillugsi::rendering {
 
 /// TerrainMaterial implements height-based biome visualization for planetary surfaces
 /// We extend from the base Material class to leverage the existing material system.
-/// This first version focuses on interpreting vertex height data (stored in vertex colors)
-/// to create basic biome visualization as a foundation for more complex features.
+///
+/// Elevation, surface normals and biome weights don't change while the planet is viewed,
+/// so TerrainBaker evaluates them once into cube maps instead of every pixel every frame.
+/// The vertex shader displaces a sphere by the baked elevation and the fragment shader
+/// blends the biome colors with the baked weights. Fields are baked again only when a
+/// parameter they depend on changes, colors and surface parameters stay uniforms.
+/// updateFields must have baked the fields once before the material is drawn.
 class TerrainMaterial : public Material {
 public:
 	/// NoiseParameters defines how noise is generated and applied for each biome
@@ -80,7 +88,7 @@ public:
 			float planetRadius{1.0f};           /// Used to calculate proper height ranges
 			uint32_t numBiomes{0};              /// Actual number of biomes in use
 			uint32_t debugMode{0};              /// Current debug visualization mode
-			float padding{0.0f};                /// Pad to 16 bytes
+			float heightScale{0.05f};           /// Highest elevation as a fraction of the radius
 		};
 	};
 
@@ -116,6 +124,10 @@ public:
 	/// @return Shader paths configuration for pipeline creation
 	[[nodiscard]] ShaderPaths getShaderPaths() const override;
 
+	/// Lower LODs evaluate fewer noise octaves in the terrain debug views
+	/// @return MaterialLodCount, every level is a specialization of the terrain shader
+	[[nodiscard]] uint32_t getLodCount() const override { return MaterialLodCount; }
+
 	/// Set parameters for a specific biome
 	/// Height values should match the normalized range used in vertex colors
 	/// @param index Which biome to modify (0-3 in initial implementation)
@@ -143,6 +155,47 @@ public:
 	/// @param params New noise parameters for the biome
 	void setNoiseParameters(uint32_t index, const NoiseParameters& params);
 
+	/// Set the noise shaping the planet's elevation
+	/// @param params Elevation noise, the amplitude scales it around half height
+	/// @param heightScale Highest elevation as a fraction of the planet radius
+	void setElevation(const NoiseParameters& params, float heightScale);
+
+	/// Set the seed of all terrain noise
+	/// @param seed Noise seed
+	void setSeed(int32_t seed);
+
+	/// Edge length of the baked cube map faces in texels
+	static constexpr uint32_t FieldFaceSize = 512;
+
+	/// Reset the surface fields if their inputs changed since the last call
+	/// The fields are generated chunk by chunk in the background by a TerrainStreamer.
+	/// Until a chunk arrives, its texels hold no elevation and a zero normal, which the
+	/// shaders show as the bare sphere. A reset waits for the queue to go idle because
+	/// frames in flight may still sample the previous fields
+	/// @param commandPool Command pool for the upload commands
+	/// @param queue Queue to submit the upload commands to
+	/// @param commandBufferManager Command buffer manager for one-time submissions
+	/// @return True if the fields were reset
+	bool updateFields(VkCommandPool commandPool,
+		VkQueue queue,
+		vulkan::CommandBufferManager& commandBufferManager);
+
+	/// Get the noise shaping the planet's elevation
+	[[nodiscard]] const NoiseParameters& getElevation() const { return this->elevationNoise; }
+
+	/// Get the seed of all terrain noise
+	[[nodiscard]] int32_t getSeed() const { return this->seed; }
+
+	/// Get the input hash the fields were last reset for
+	/// Chunks baked for a different hash don't belong into the current fields
+	[[nodiscard]] uint64_t getFieldHash() const { return this->fieldHash; }
+
+	/// Get the surface field, RGBA16F normal and elevation, one layer per cube face
+	[[nodiscard]] std::shared_ptr<Texture> getSurfaceTexture() const { return this->surfaceTexture; }
+
+	/// Get the biome weight field, RGBA8, one layer per cube face
+	[[nodiscard]] std::shared_ptr<Texture> getBiomeWeightTexture() const { return this->biomeWeightTexture; }
+
 	/// Set the debug visualization mode
 	/// We use this for development and tuning of the terrain system
 	/// @param mode The debug mode to enable
@@ -181,6 +234,21 @@ private:
 	/// This holds our CPU-side copy of the shader parameters
 	Properties properties;
 
+	/// Bake inputs that only the CPU needs
+	NoiseParameters elevationNoise;
+	int32_t seed{1337};
+
+	/// Baked fields, sampled through bindings 1 and 2
+	std::shared_ptr<Texture> surfaceTexture;
+	std::shared_ptr<Texture> biomeWeightTexture;
+
+	/// Input hash of the current fields, resetting is skipped while it matches
+	uint64_t fieldHash{0};
+	bool fieldsCreated{false};
+
+	/// Point bindings 1 and 2 at the baked fields
+	void writeFieldDescriptors();
+
 	/// Shader paths stored for pipeline creation
 	std::string vertexShaderPath;
 	std::string fragmentShaderPath;
@@ -0,0 +1,293 @@
+#include "terrainquadtree.h"
+#include "terrainbaker.h"
+#include "vertex.h"
+#include "vulkan/pipelineconfig.h"
+#include <glm/gtc/constants.hpp>
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace lillugsi::rendering {
+
+namespace {
+/// Samples per node edge for bounds
+/// The surface between samples bulges out, which the bounds are padded for
+constexpr uint32_t BoundsSamples = 3;
+}
+
+TerrainQuadtree::TerrainQuadtree(VkDevice device, std::shared_ptr<BufferManager> bufferManager)
+	: device(device)
+	, bufferManager(std::move(bufferManager)) {
+}
+
+TerrainQuadtree::~TerrainQuadtree() {
+	this->cleanup();
+}
+
+void TerrainQuadtree::initialize(std::shared_ptr<TerrainMaterial> material,
+	VkRenderPass renderPass,
+	VkPipelineLayout pipelineLayout) {
+	this->material = std::move(material);
+	this->pipelineLayout = pipelineLayout;
+
+	this->createPatch();
+	this->createPipeline(renderPass, pipelineLayout);
+
+	this->instanceBuffer = this->bufferManager->createInstanceBuffer(MaxNodes * sizeof(NodeInstance));
+	this->mappedInstances = static_cast<NodeInstance*>(
+		this->instanceBuffer->map(0, MaxNodes * sizeof(NodeInstance)));
+	this->selectedNodes.reserve(MaxNodes);
+
+	spdlog::info("Terrain quadtree initialized with {}x{} patches, {} levels, {} triangles per node",
+		GridResolution, GridResolution, MaxDepth + 1, GridResolution * GridResolution * 2);
+}
+
+void TerrainQuadtree::cleanup() {
+	if (this->mappedInstances) {
+		this->instanceBuffer->unmap();
+		this->mappedInstances = nullptr;
+	}
+	this->instanceBuffer.reset();
+	this->pipeline.reset();
+	this->patchIndexBuffer.reset();
+	this->patchVertexBuffer.reset();
+	this->material.reset();
+	this->nodeCount = 0;
+}
+
+void TerrainQuadtree::createPatch() {
+	constexpr uint32_t rowLength = GridResolution + 1;
+
+	/// Only the position is read, the grid coordinate goes into its xy
+	std::vector<Vertex> vertices(rowLength * rowLength, Vertex{});
+	for (uint32_t y = 0; y < rowLength; ++y) {
+		for (uint32_t x = 0; x < rowLength; ++x) {
+			vertices[y * rowLength + x].position = glm::vec3(
+				static_cast<float>(x) / static_cast<float>(GridResolution),
+				static_cast<float>(y) / static_cast<float>(GridResolution),
+				0.0f);
+		}
+	}
+
+	/// Face coordinates run against the outward normal on every cube face,
+	/// so going up in y before x keeps the triangles counter-clockwise from outside
+	std::vector<uint32_t> indices;
+	indices.reserve(GridResolution * GridResolution * 6);
+	for (uint32_t y = 0; y < GridResolution; ++y) {
+		for (uint32_t x = 0; x < GridResolution; ++x) {
+			const uint32_t topLeft = y * rowLength + x;
+			const uint32_t topRight = topLeft + 1;
+			const uint32_t bottomLeft = topLeft + rowLength;
+			const uint32_t bottomRight = bottomLeft + 1;
+
+			indices.push_back(topLeft);
+			indices.push_back(bottomLeft);
+			indices.push_back(topRight);
+
+			indices.push_back(topRight);
+			indices.push_back(bottomLeft);
+			indices.push_back(bottomRight);
+		}
+	}
+
+	this->patchVertexBuffer = this->bufferManager->createVertexBuffer(vertices);
+	this->patchIndexBuffer = this->bufferManager->createIndexBuffer(indices);
+}
+
+void TerrainQuadtree::createPipeline(VkRenderPass renderPass, VkPipelineLayout pipelineLayout) {
+	/// Same states as the material's regular pipeline, only the vertex stage and input differ
+	const auto shaderPaths = this->material->getShaderPaths();
+
+	vulkan::PipelineConfig config;
+	config.setBlendState(false,
+		VK_BLEND_FACTOR_ONE,
+		VK_BLEND_FACTOR_ZERO,
+		VK_BLEND_OP_ADD,
+		VK_BLEND_FACTOR_ONE,
+		VK_BLEND_FACTOR_ZERO,
+		VK_BLEND_OP_ADD);
+	/// Reverse-Z like every other scene pipeline
+	config.setDepthState(true, true, VK_COMPARE_OP_GREATER);
+	config.setRasterization(VK_POLYGON_MODE_FILL, VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	config.addShaderStage(VK_SHADER_STAGE_VERTEX_BIT, VertexShaderPath);
+	config.addShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, shaderPaths.fragmentPath);
+
+	/// The patch only needs positions, we keep the full stride like the shadow pass
+	const auto allAttributes = Vertex::getAttributeDescriptions();
+	config.setVertexInput(Vertex::getBindingDescription(), {allAttributes[0]});
+
+	VkVertexInputBindingDescription instanceBinding{};
+	instanceBinding.binding = 1;
+	instanceBinding.stride = sizeof(NodeInstance);
+	instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+	std::vector<VkVertexInputAttributeDescription> instanceAttributes(2);
+	instanceAttributes[0].binding = 1;
+	instanceAttributes[0].location = 1;
+	instanceAttributes[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	instanceAttributes[0].offset = offsetof(NodeInstance, node);
+	instanceAttributes[1].binding = 1;
+	instanceAttributes[1].location = 2;
+	instanceAttributes[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+	instanceAttributes[1].offset = offsetof(NodeInstance, morph);
+	config.setInstanceInput(instanceBinding, instanceAttributes);
+
+	auto createInfo = config.getCreateInfo(this->device, renderPass, pipelineLayout);
+
+	VkPipeline rawPipeline;
+	VK_CHECK(vkCreateGraphicsPipelines(this->device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &rawPipeline));
+
+	this->pipeline = vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+}
+
+void TerrainQuadtree::computeLodRanges(float worldRadius) {
+	/// A root spans a quarter of a great circle, every level halves it
+	const float rootArcLength = worldRadius * glm::half_pi<float>();
+	for (uint32_t depth = 0; depth <= MaxDepth; ++depth) {
+		this->lodRanges[depth] = LodRangeFactor * rootArcLength / static_cast<float>(1u << depth);
+	}
+}
+
+void TerrainQuadtree::update(const FrameSnapshot& snapshot) {
+	this->selectedNodes.clear();
+	this->nodeCount = 0;
+	if (!this->material || !this->mappedInstances) {
+		return;
+	}
+
+	const auto& properties = this->material->getProperties();
+	this->minRadius = properties.planetRadius;
+	this->maxRadius = properties.planetRadius * (1.0f + properties.heightScale);
+
+	/// Selection and morphing both measure in world units
+	const float scale = glm::length(glm::vec3(this->transform[0]));
+	this->computeLodRanges(this->maxRadius * scale);
+
+	const auto frustum = scene::Frustum::createFromMatrix(snapshot.projection * snapshot.view);
+	for (uint32_t face = 0; face < 6; ++face) {
+		this->selectNode(Node{face, glm::vec2(-1.0f), 2.0f, 0}, snapshot.cameraPosition, frustum);
+	}
+
+	this->nodeCount = static_cast<uint32_t>(this->selectedNodes.size());
+	if (this->nodeCount > 0) {
+		std::memcpy(this->mappedInstances, this->selectedNodes.data(), this->nodeCount * sizeof(NodeInstance));
+	}
+}
+
+void TerrainQuadtree::selectNode(const Node& node, const glm::vec3& cameraPosition, const scene::Frustum& frustum) {
+	const auto bounds = this->computeNodeBounds(node);
+	if (!frustum.intersectsBox(bounds)) {
+		return;
+	}
+
+	/// Split while the camera is within the range of the children
+	/// Children are visited on their own, so the culled ones cost nothing further down
+	if (node.depth < MaxDepth && distanceToBox(bounds, cameraPosition) < this->lodRanges[node.depth + 1]) {
+		const float childSize = node.size * 0.5f;
+		for (uint32_t child = 0; child < 4; ++child) {
+			const glm::vec2 offset(static_cast<float>(child & 1u), static_cast<float>(child >> 1u));
+			this->selectNode(Node{node.face, node.origin + offset * childSize, childSize, node.depth + 1},
+				cameraPosition, frustum);
+		}
+		return;
+	}
+
+	if (this->selectedNodes.size() >= MaxNodes) {
+		if (!this->overflowReported) {
+			spdlog::warn("Terrain quadtree selected more than {} nodes, dropping the rest", MaxNodes);
+			this->overflowReported = true;
+		}
+		return;
+	}
+
+	/// Vertices are fully morphed at the end of the range, where the parent takes over
+	const float morphEnd = this->lodRanges[node.depth];
+	const float morphStart = morphEnd * (1.0f - MorphFraction);
+
+	NodeInstance instance;
+	instance.node = glm::vec4(node.origin, node.size, static_cast<float>(node.face));
+	instance.morph = glm::vec4(morphStart, morphEnd, 0.0f, 0.0f);
+	this->selectedNodes.push_back(instance);
+}
+
+scene::BoundingBox TerrainQuadtree::computeNodeBounds(const Node& node) const {
+	scene::BoundingBox bounds;
+	for (uint32_t y = 0; y < BoundsSamples; ++y) {
+		for (uint32_t x = 0; x < BoundsSamples; ++x) {
+			const glm::vec2 uv = node.origin + glm::vec2(
+				static_cast<float>(x),
+				static_cast<float>(y)) * (node.size / static_cast<float>(BoundsSamples - 1));
+			const glm::vec3 direction = glm::normalize(TerrainBaker::cubeFaceDirection(node.face, uv.x, uv.y));
+			bounds.addPoint(direction * this->minRadius);
+			bounds.addPoint(direction * this->maxRadius);
+		}
+	}
+
+	/// Between two samples the sphere bulges out by the sagitta of their arc
+	/// A root spans about a quarter circle, so neighbouring samples are at most
+	/// size * pi / 4 / (samples - 1) apart
+	const float halfAngle = node.size * glm::pi<float>() / (8.0f * static_cast<float>(BoundsSamples - 1));
+	const float bulge = this->maxRadius * (1.0f - std::cos(halfAngle));
+	bounds = scene::BoundingBox(bounds.getMin() - glm::vec3(bulge), bounds.getMax() + glm::vec3(bulge));
+
+	return bounds.transform(this->transform);
+}
+
+float TerrainQuadtree::distanceToBox(const scene::BoundingBox& box, const glm::vec3& point) {
+	const glm::vec3 closest = glm::clamp(point, box.getMin(), box.getMax());
+	return glm::length(point - closest);
+}
+
+void TerrainQuadtree::record(VkCommandBuffer commandBuffer,
+	VkDescriptorSet cameraDescriptorSet,
+	VkDescriptorSet lightDescriptorSet,
+	VkExtent2D extent) const {
+	if (this->nodeCount == 0) {
+		return;
+	}
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.get());
+
+	VkViewport viewport{};
+	viewport.width = static_cast<float>(extent.width);
+	viewport.height = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	const std::array<VkDescriptorSet, 2> globalSets = {cameraDescriptorSet, lightDescriptorSet};
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		this->pipelineLayout,
+		0,
+		static_cast<uint32_t>(globalSets.size()),
+		globalSets.data(),
+		0, nullptr);
+	this->material->bind(commandBuffer, this->pipelineLayout);
+
+	vkCmdPushConstants(commandBuffer,
+		this->pipelineLayout,
+		VK_SHADER_STAGE_VERTEX_BIT,
+		0,
+		sizeof(glm::mat4),
+		&this->transform);
+
+	const std::array<VkBuffer, 2> vertexBuffers = {this->patchVertexBuffer->get(), this->instanceBuffer->get()};
+	const std::array<VkDeviceSize, 2> offsets = {0, 0};
+	vkCmdBindVertexBuffers(commandBuffer, 0, 2, vertexBuffers.data(), offsets.data());
+	vkCmdBindIndexBuffer(commandBuffer, this->patchIndexBuffer->get(), 0, VK_INDEX_TYPE_UINT32);
+
+	/// Every node is the same patch, one draw covers the whole planet
+	vkCmdDrawIndexed(commandBuffer, this->patchIndexBuffer->getIndexCount(), this->nodeCount, 0, 0, 0);
+}
+
+} /// namespace lillugsi::rendering
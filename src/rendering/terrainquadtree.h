@@ -0,0 +1,170 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include "vulkan/buffer.h"
+#include "vulkan/vertexbuffer.h"
+#include "vulkan/indexbuffer.h"
+#include "buffermanager.h"
+#include "framesnapshot.h"
+#include "terrainmaterial.h"
+#include "scene/boundingbox.h"
+#include "scene/frustum.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// TerrainQuadtree draws a terrain material's planet with continuous distance-dependent LOD (CDLOD)
+/// A single sphere mesh has the same density everywhere: fine enough to look good up close,
+/// it spends most of its triangles where they cover less than a pixel. We split each of the
+/// six cube faces into a quadtree instead and draw every selected node with the same small
+/// grid patch, so detail follows the camera and the triangle count doesn't grow with the
+/// planet's size.
+///
+/// Nodes are selected on the render thread from the frame's camera:
+/// - A node is split while the camera is closer to its bounds than the range of its children.
+///   Ranges double from level to level, so every level covers a band of constant screen density.
+/// - Nodes outside the view frustum are skipped together with their whole subtree.
+///
+/// Near the end of its range, the vertex shader morphs a node's odd grid vertices onto
+/// their even neighbours, so a node has its parent's resolution by the time the parent
+/// takes over. Neighbouring nodes differ by at most one level and agree on every shared
+/// vertex, which avoids both cracks and popping without stitching meshes.
+///
+/// Selected nodes are written to a per-instance vertex buffer and drawn with one
+/// instanced draw. Elevation and normals come from the material's baked surface,
+/// shading uses the regular terrain fragment shader.
+class TerrainQuadtree {
+public:
+	static constexpr const char* VertexShaderPath = "shaders/terraincdlod.vert.spv";
+
+	/// Quads along each edge of the shared patch, matches terraincdlod.glsl.vert
+	/// Must be even, morphing pairs up grid vertices
+	static constexpr uint32_t GridResolution = 32;
+
+	/// Deepest level below the face roots
+	/// At this level a patch quad is finer than a texel of the baked surface
+	static constexpr uint32_t MaxDepth = 6;
+
+	/// Highest number of nodes drawn per frame, sizes the instance buffer
+	static constexpr uint32_t MaxNodes = 1024;
+
+	/// Range of a level in multiples of its node's arc length
+	/// Must stay above 2, otherwise a node can border one two levels coarser
+	static constexpr float LodRangeFactor = 3.0f;
+
+	/// Fraction at the end of each range in which vertices morph towards the coarser grid
+	static constexpr float MorphFraction = 0.3f;
+
+	/// Constructor
+	/// @param device The logical device to create resources on
+	/// @param bufferManager Buffer manager to allocate the patch and instance buffers from
+	TerrainQuadtree(VkDevice device, std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor
+	~TerrainQuadtree();
+
+	/// Create the shared patch, the instance buffer and the pipeline
+	/// @param material Terrain material providing the baked surface and shading
+	/// @param renderPass Scene render pass the terrain is drawn in
+	/// @param pipelineLayout Layout of the material's regular pipeline, the sets and push constants match
+	void initialize(std::shared_ptr<TerrainMaterial> material,
+		VkRenderPass renderPass,
+		VkPipelineLayout pipelineLayout);
+
+	/// Release all Vulkan resources
+	void cleanup();
+
+	/// Place the planet in the world
+	/// @param transform World transform, scaling must be uniform
+	void setTransform(const glm::mat4& transform) { this->transform = transform; }
+
+	/// Get the planet's world transform
+	[[nodiscard]] const glm::mat4& getTransform() const { return this->transform; }
+
+	/// Select the nodes drawn in a frame
+	/// The GPU must no longer read the instance buffer, which the in-flight fence guarantees
+	/// @param snapshot The frame's snapshot
+	void update(const FrameSnapshot& snapshot);
+
+	/// Draw the nodes selected in update
+	/// Must be recorded inside the scene render pass
+	/// @param commandBuffer The command buffer being recorded
+	/// @param cameraDescriptorSet Camera descriptor set (set 0)
+	/// @param lightDescriptorSet Light descriptor set (set 1)
+	/// @param extent Rendered area of the scene target
+	void record(VkCommandBuffer commandBuffer,
+		VkDescriptorSet cameraDescriptorSet,
+		VkDescriptorSet lightDescriptorSet,
+		VkExtent2D extent) const;
+
+	/// Get the number of nodes selected in the last update
+	[[nodiscard]] uint32_t getNodeCount() const { return this->nodeCount; }
+
+private:
+	/// A square of a cube face
+	struct Node {
+		uint32_t face;
+		glm::vec2 origin;  /// Corner with the lowest face coordinates, -1 to 1
+		float size;        /// Edge length in face coordinates, 2 for a root
+		uint32_t depth;
+	};
+
+	/// Per-instance vertex attributes, matches terraincdlod.glsl.vert
+	struct NodeInstance {
+		glm::vec4 node;   /// Origin, size, face
+		glm::vec4 morph;  /// Distance where morphing starts and ends, unused, unused
+	};
+
+	void createPatch();
+	void createPipeline(VkRenderPass renderPass, VkPipelineLayout pipelineLayout);
+
+	/// Recompute the range of every level for the planet's current world radius
+	void computeLodRanges(float worldRadius);
+
+	/// Visit a node and either draw it or descend into its children
+	void selectNode(const Node& node, const glm::vec3& cameraPosition, const scene::Frustum& frustum);
+
+	/// World space bounds of a node between the lowest and highest elevation
+	[[nodiscard]] scene::BoundingBox computeNodeBounds(const Node& node) const;
+
+	/// Distance from a point to the closest point of a box, 0 inside
+	[[nodiscard]] static float distanceToBox(const scene::BoundingBox& box, const glm::vec3& point);
+
+	VkDevice device;
+	std::shared_ptr<BufferManager> bufferManager;
+	std::shared_ptr<TerrainMaterial> material;
+
+	glm::mat4 transform{1.0f};
+
+	/// Grid patch shared by all nodes, grid coordinates from 0 to 1 in the position's xy
+	std::shared_ptr<vulkan::VertexBuffer> patchVertexBuffer;
+	std::shared_ptr<vulkan::IndexBuffer> patchIndexBuffer;
+
+	/// Rewritten every frame, mapped for the lifetime of the quadtree
+	std::shared_ptr<vulkan::Buffer> instanceBuffer;
+	NodeInstance* mappedInstances{nullptr};
+
+	/// The regular terrain pipeline layout, owned by the pipeline manager
+	VkPipelineLayout pipelineLayout{VK_NULL_HANDLE};
+	vulkan::VulkanPipelineHandle pipeline;
+
+	/// Distance up to which each level is drawn, indexed by depth
+	std::array<float, MaxDepth + 1> lodRanges{};
+
+	/// Radii of the lowest and highest elevation in object space
+	float minRadius{0.0f};
+	float maxRadius{0.0f};
+
+	/// Nodes selected in the current frame
+	std::vector<NodeInstance> selectedNodes;
+	uint32_t nodeCount{0};
+	bool overflowReported{false};
+};
+
+} /// namespace lillugsi::rendering
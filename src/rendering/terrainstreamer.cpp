@@ -0,0 +1,354 @@
+#include "terrainstreamer.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+
+namespace lillugsi::rendering {
+
+namespace {
+constexpr char CacheMagic[4] = {'L', 'T', 'C', 'K'};
+
+constexpr uint32_t FaceSize = TerrainMaterial::FieldFaceSize;
+constexpr uint32_t ChunkTexels = TerrainBaker::ChunkSize * TerrainBaker::ChunkSize;
+
+/// Bytes of one chunk of each field
+constexpr VkDeviceSize SurfaceBytes = ChunkTexels * 4 * sizeof(uint16_t);
+constexpr VkDeviceSize WeightBytes = ChunkTexels * 4;
+constexpr VkDeviceSize ChunkBytes = SurfaceBytes + WeightBytes;
+}
+
+TerrainStreamer::TerrainStreamer(std::shared_ptr<BufferManager> bufferManager)
+	: bufferManager(std::move(bufferManager)) {
+}
+
+TerrainStreamer::~TerrainStreamer() {
+	this->cleanup();
+}
+
+void TerrainStreamer::initialize(std::shared_ptr<TerrainMaterial> material, const std::string& cacheDirectory) {
+	this->material = std::move(material);
+	this->cacheDirectory = cacheDirectory;
+
+	this->chunkCount = TerrainBaker::getChunkCount(FaceSize);
+	this->chunkDirections.resize(this->chunkCount);
+	for (uint32_t chunkId = 0; chunkId < this->chunkCount; ++chunkId) {
+		const auto location = TerrainBaker::getChunkLocation(FaceSize, chunkId);
+		const float scale = static_cast<float>(TerrainBaker::ChunkSize) / static_cast<float>(FaceSize) * 2.0f;
+		const float u = (static_cast<float>(location.chunkX) + 0.5f) * scale - 1.0f;
+		const float v = (static_cast<float>(location.chunkY) + 0.5f) * scale - 1.0f;
+		this->chunkDirections[chunkId] = glm::normalize(TerrainBaker::cubeFaceDirection(location.face, u, v));
+	}
+
+	this->stagingBuffer = this->bufferManager->createStagingBuffer(ChunksPerFrame * ChunkBytes);
+	this->mappedStaging = static_cast<uint8_t*>(this->stagingBuffer->map(0, ChunksPerFrame * ChunkBytes));
+
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = false;
+		this->restart();
+	}
+
+	/// Half the cores, the update and render threads keep running next to the workers
+	const uint32_t workerCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+	this->workers.reserve(workerCount);
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		this->workers.emplace_back(&TerrainStreamer::workerLoop, this);
+	}
+
+	spdlog::info("Terrain streamer started {} workers for {} chunks of {}x{} texels",
+		workerCount, this->chunkCount, TerrainBaker::ChunkSize, TerrainBaker::ChunkSize);
+}
+
+void TerrainStreamer::cleanup() {
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->stopping = true;
+		this->pendingChunks.clear();
+		this->finishedChunks.clear();
+	}
+	this->workAvailable.notify_all();
+	for (auto& worker : this->workers) {
+		worker.join();
+	}
+	this->workers.clear();
+
+	if (this->mappedStaging) {
+		this->stagingBuffer->unmap();
+		this->mappedStaging = nullptr;
+	}
+	this->stagingBuffer.reset();
+	this->material.reset();
+}
+
+void TerrainStreamer::restart() {
+	auto next = std::make_shared<BakeInputs>();
+	next->properties = this->material->getProperties();
+	next->elevation = this->material->getElevation();
+	next->seed = this->material->getSeed();
+	next->hash = this->material->getFieldHash();
+	this->inputs = std::move(next);
+
+	this->pendingChunks.resize(this->chunkCount);
+	std::iota(this->pendingChunks.begin(), this->pendingChunks.end(), 0u);
+	this->finishedChunks.clear();
+	this->residentCount = 0;
+}
+
+void TerrainStreamer::update(const glm::vec3& viewPoint) {
+	if (!this->material) {
+		return;
+	}
+
+	bool restarted = false;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		if (glm::dot(viewPoint, viewPoint) > 0.0f) {
+			this->viewDirection = glm::normalize(viewPoint);
+		}
+		if (this->inputs && this->inputs->hash != this->material->getFieldHash()) {
+			this->restart();
+			restarted = true;
+		}
+	}
+
+	if (restarted) {
+		this->workAvailable.notify_all();
+		spdlog::info("Terrain inputs changed, streaming {} chunks again", this->chunkCount);
+	}
+}
+
+uint32_t TerrainStreamer::takeNextChunk() {
+	/// A linear scan over a few hundred directions is cheaper than keeping a heap
+	/// sorted while the view direction changes every frame
+	size_t best = 0;
+	float bestAlignment = -2.0f;
+	for (size_t i = 0; i < this->pendingChunks.size(); ++i) {
+		const float alignment = glm::dot(this->chunkDirections[this->pendingChunks[i]], this->viewDirection);
+		if (alignment > bestAlignment) {
+			bestAlignment = alignment;
+			best = i;
+		}
+	}
+
+	const uint32_t chunkId = this->pendingChunks[best];
+	this->pendingChunks[best] = this->pendingChunks.back();
+	this->pendingChunks.pop_back();
+	return chunkId;
+}
+
+void TerrainStreamer::workerLoop() {
+	for (;;) {
+		std::shared_ptr<const BakeInputs> jobInputs;
+		uint32_t chunkId;
+		{
+			std::unique_lock<std::mutex> lock(this->mutex);
+			this->workAvailable.wait(lock, [this]() {
+				return this->stopping || !this->pendingChunks.empty();
+			});
+			if (this->stopping) {
+				return;
+			}
+			chunkId = this->takeNextChunk();
+			jobInputs = this->inputs;
+		}
+
+		FinishedChunk finished;
+		finished.inputHash = jobInputs->hash;
+		try {
+			if (!this->loadChunk(jobInputs->hash, chunkId, finished.chunk)) {
+				finished.chunk = TerrainBaker::bakeChunk(jobInputs->properties,
+					jobInputs->elevation, jobInputs->seed, FaceSize, chunkId);
+				this->storeChunk(jobInputs->hash, finished.chunk);
+			}
+		} catch (const std::exception& e) {
+			spdlog::error("Failed to generate terrain chunk {}: {}", chunkId, e.what());
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(this->mutex);
+		/// Inputs changed while this chunk was baking, it doesn't belong into the new fields
+		if (this->inputs && this->inputs->hash == finished.inputHash) {
+			this->finishedChunks.push_back(std::move(finished));
+		}
+	}
+}
+
+std::string TerrainStreamer::getCachePath(uint64_t inputHash, uint32_t chunkId) const {
+	char directoryName[32];
+	std::snprintf(directoryName, sizeof(directoryName), "%016llx", static_cast<unsigned long long>(inputHash));
+	char fileName[32];
+	std::snprintf(fileName, sizeof(fileName), "%05u.chunk", chunkId);
+	return (std::filesystem::path(this->cacheDirectory) / directoryName / fileName).string();
+}
+
+bool TerrainStreamer::loadChunk(uint64_t inputHash, uint32_t chunkId, TerrainChunk& chunk) const {
+	const std::string cachePath = this->getCachePath(inputHash, chunkId);
+	std::ifstream file(cachePath, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	CacheHeader header{};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+	/// The path already contains the key, but a mismatch in here means the file
+	/// was truncated or written by a different build, so we bake again
+	const bool matches = file
+		&& std::memcmp(header.magic, CacheMagic, sizeof(CacheMagic)) == 0
+		&& header.version == CacheVersion
+		&& header.inputHash == inputHash
+		&& header.chunkId == chunkId
+		&& header.faceSize == FaceSize
+		&& header.chunkSize == TerrainBaker::ChunkSize
+		&& header.surfaceBytes == SurfaceBytes
+		&& header.weightBytes == WeightBytes;
+	if (!matches) {
+		spdlog::warn("Ignoring stale terrain chunk cache '{}'", cachePath);
+		return false;
+	}
+
+	chunk.id = chunkId;
+	chunk.surface.resize(ChunkTexels * 4);
+	chunk.biomeWeights.resize(ChunkTexels * 4);
+	file.read(reinterpret_cast<char*>(chunk.surface.data()), static_cast<std::streamsize>(SurfaceBytes));
+	file.read(reinterpret_cast<char*>(chunk.biomeWeights.data()), static_cast<std::streamsize>(WeightBytes));
+	if (!file) {
+		spdlog::warn("Terrain chunk cache '{}' is truncated", cachePath);
+		return false;
+	}
+
+	return true;
+}
+
+void TerrainStreamer::storeChunk(uint64_t inputHash, const TerrainChunk& chunk) const {
+	const std::filesystem::path path(this->getCachePath(inputHash, chunk.id));
+	std::error_code error;
+	std::filesystem::create_directories(path.parent_path(), error);
+
+	CacheHeader header{};
+	std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+	header.version = CacheVersion;
+	header.inputHash = inputHash;
+	header.chunkId = chunk.id;
+	header.faceSize = FaceSize;
+	header.chunkSize = TerrainBaker::ChunkSize;
+	header.surfaceBytes = SurfaceBytes;
+	header.weightBytes = WeightBytes;
+
+	/// Write to a temporary file first, so an interrupted write never leaves a
+	/// cache file behind that looks valid
+	const std::filesystem::path temporaryPath = path.string() + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(chunk.surface.data()), static_cast<std::streamsize>(SurfaceBytes));
+		file.write(reinterpret_cast<const char*>(chunk.biomeWeights.data()), static_cast<std::streamsize>(WeightBytes));
+		if (!file) {
+			spdlog::warn("Could not write terrain chunk cache '{}', it will be baked again next time", path.string());
+			return;
+		}
+	}
+
+	std::filesystem::rename(temporaryPath, path, error);
+	if (error) {
+		spdlog::warn("Could not write terrain chunk cache '{}': {}", path.string(), error.message());
+	}
+}
+
+void TerrainStreamer::record(VkCommandBuffer commandBuffer) {
+	if (!this->mappedStaging) {
+		return;
+	}
+
+	std::vector<FinishedChunk> batch;
+	{
+		std::lock_guard<std::mutex> lock(this->mutex);
+		const size_t count = std::min<size_t>(this->finishedChunks.size(), ChunksPerFrame);
+		batch.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			batch.push_back(std::move(this->finishedChunks.back()));
+			this->finishedChunks.pop_back();
+		}
+	}
+	if (batch.empty()) {
+		return;
+	}
+
+	const auto surfaceTexture = this->material->getSurfaceTexture();
+	const auto weightTexture = this->material->getBiomeWeightTexture();
+
+	/// Chunks sit side by side in the staging buffer, the surface before the weights
+	std::vector<VkBufferImageCopy> surfaceRegions(batch.size());
+	std::vector<VkBufferImageCopy> weightRegions(batch.size());
+	for (size_t i = 0; i < batch.size(); ++i) {
+		const TerrainChunk& chunk = batch[i].chunk;
+		const VkDeviceSize offset = i * ChunkBytes;
+		std::memcpy(this->mappedStaging + offset, chunk.surface.data(), SurfaceBytes);
+		std::memcpy(this->mappedStaging + offset + SurfaceBytes, chunk.biomeWeights.data(), WeightBytes);
+
+		const auto location = TerrainBaker::getChunkLocation(FaceSize, chunk.id);
+		VkBufferImageCopy region{};
+		region.bufferOffset = offset;
+		region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, location.face, 1};
+		region.imageOffset = {
+			static_cast<int32_t>(location.chunkX * TerrainBaker::ChunkSize),
+			static_cast<int32_t>(location.chunkY * TerrainBaker::ChunkSize),
+			0};
+		region.imageExtent = {TerrainBaker::ChunkSize, TerrainBaker::ChunkSize, 1};
+		surfaceRegions[i] = region;
+
+		region.bufferOffset = offset + SurfaceBytes;
+		weightRegions[i] = region;
+	}
+
+	/// The previous frame is done sampling thanks to the fence, the layout change keeps the contents
+	std::array<VkImageMemoryBarrier, 2> barriers{};
+	const std::array<VkImage, 2> images = {surfaceTexture->getImage(), weightTexture->getImage()};
+	for (size_t i = 0; i < barriers.size(); ++i) {
+		barriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barriers[i].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barriers[i].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barriers[i].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barriers[i].image = images[i];
+		barriers[i].subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 6};
+		barriers[i].srcAccessMask = 0;
+		barriers[i].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	}
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nullptr, 0, nullptr,
+		static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	vkCmdCopyBufferToImage(commandBuffer, this->stagingBuffer->get(), images[0],
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(surfaceRegions.size()), surfaceRegions.data());
+	vkCmdCopyBufferToImage(commandBuffer, this->stagingBuffer->get(), images[1],
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(weightRegions.size()), weightRegions.data());
+
+	for (auto& barrier : barriers) {
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	}
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0, 0, nullptr, 0, nullptr,
+		static_cast<uint32_t>(barriers.size()), barriers.data());
+
+	this->residentCount += static_cast<uint32_t>(batch.size());
+	if (this->isComplete()) {
+		spdlog::info("Terrain streaming complete, {} chunks resident", this->residentCount);
+	}
+}
+
+} /// namespace lillugsi::rendering
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "vulkan/buffer.h"
+#include "buffermanager.h"
+#include "terrainbaker.h"
+#include "terrainmaterial.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// TerrainStreamer fills a terrain material's surface fields in the background
+/// Baking a whole planet at once blocks for as long as the slowest part of it takes.
+/// We split the fields into the chunks TerrainBaker works on and generate them on
+/// worker threads instead, most important first, while frames keep rendering:
+/// - Chunks facing the viewer are taken before those on the far side of the planet.
+///   The order is re-evaluated whenever a worker takes the next chunk, so turning
+///   around changes what is generated next, not what was already queued.
+/// - Every finished chunk is stored in a cache file keyed by the bake input hash,
+///   which covers the seed and all parameters, and the chunk ID. Chunks found there
+///   are only read, so a planet that was seen before streams in as fast as the disk.
+/// - The render thread uploads a few finished chunks per frame with copies recorded
+///   into the frame's command buffer, so uploading never waits on the GPU.
+///
+/// A change of the material's inputs is picked up through its field hash: queued
+/// chunks are dropped and the ones still baking are discarded when they finish.
+class TerrainStreamer {
+public:
+	/// Chunks uploaded per frame at most, sizes the staging buffer
+	static constexpr uint32_t ChunksPerFrame = 8;
+
+	/// Bumped whenever the chunk data or its file layout changes, invalidating old caches
+	static constexpr uint32_t CacheVersion = 1;
+
+	/// Constructor
+	/// @param bufferManager Buffer manager to allocate the staging buffer from
+	explicit TerrainStreamer(std::shared_ptr<BufferManager> bufferManager);
+
+	/// Destructor, stops the workers
+	~TerrainStreamer();
+
+	/// Start generating the fields of a material
+	/// The material's fields must have been created with updateFields
+	/// @param material Terrain material whose fields are streamed
+	/// @param cacheDirectory Directory for cached chunks
+	void initialize(std::shared_ptr<TerrainMaterial> material, const std::string& cacheDirectory);
+
+	/// Stop the workers and release the staging buffer
+	/// Chunks still baking are finished first, which takes a few milliseconds at most
+	void cleanup();
+
+	/// Set the point chunks are prioritized for, and restart if the material's inputs changed
+	/// @param viewPoint Viewer position in the planet's object space
+	void update(const glm::vec3& viewPoint);
+
+	/// Record the uploads of finished chunks
+	/// Must be recorded outside of a render pass, before anything samples the fields.
+	/// The GPU must no longer read the staging buffer, which the in-flight fence guarantees
+	/// @param commandBuffer The command buffer being recorded
+	void record(VkCommandBuffer commandBuffer);
+
+	/// Get the number of chunks in the fields so far
+	[[nodiscard]] uint32_t getResidentChunkCount() const { return this->residentCount; }
+
+	/// Check if every chunk is in the fields
+	[[nodiscard]] bool isComplete() const { return this->residentCount == this->chunkCount; }
+
+private:
+	/// Everything a bake reads, copied so workers never touch the material
+	struct BakeInputs {
+		TerrainMaterial::Properties properties;
+		TerrainMaterial::NoiseParameters elevation;
+		int32_t seed;
+		uint64_t hash;
+	};
+
+	/// Start of a cache file, followed by the surface and the biome weights
+	struct CacheHeader {
+		char magic[4];
+		uint32_t version;
+		uint64_t inputHash;
+		uint32_t chunkId;
+		uint32_t faceSize;
+		uint32_t chunkSize;
+		uint32_t reserved;
+		uint64_t surfaceBytes;
+		uint64_t weightBytes;
+	};
+
+	/// A chunk waiting for upload
+	struct FinishedChunk {
+		uint64_t inputHash;
+		TerrainChunk chunk;
+	};
+
+	/// Restart with the material's current inputs, called with the mutex held
+	void restart();
+
+	void workerLoop();
+
+	/// Take the pending chunk closest to the view point, called with the mutex held
+	[[nodiscard]] uint32_t takeNextChunk();
+
+	/// Path of a chunk's cache file
+	[[nodiscard]] std::string getCachePath(uint64_t inputHash, uint32_t chunkId) const;
+
+	/// Read a chunk from the cache
+	/// @return True if the chunk was found and matches
+	[[nodiscard]] bool loadChunk(uint64_t inputHash, uint32_t chunkId, TerrainChunk& chunk) const;
+
+	/// Write a chunk to the cache
+	void storeChunk(uint64_t inputHash, const TerrainChunk& chunk) const;
+
+	std::shared_ptr<BufferManager> bufferManager;
+	std::shared_ptr<TerrainMaterial> material;
+	std::string cacheDirectory;
+
+	uint32_t chunkCount{0};
+	uint32_t residentCount{0};
+
+	/// Object space direction through each chunk's center, for prioritizing
+	std::vector<glm::vec3> chunkDirections;
+
+	/// Shared with the workers, guarded by mutex
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::shared_ptr<const BakeInputs> inputs;
+	std::vector<uint32_t> pendingChunks;
+	std::vector<FinishedChunk> finishedChunks;
+	glm::vec3 viewDirection{0.0f, 0.0f, 1.0f};
+	bool stopping{false};
+
+	std::vector<std::thread> workers;
+
+	/// Persistently mapped, room for ChunksPerFrame chunks of both fields
+	std::shared_ptr<vulkan::Buffer> stagingBuffer;
+	uint8_t* mappedStaging{nullptr};
+};
+
+} /// namespace lillugsi::rendering
@@ -171,6 +171,9 @@ void Texture::uploadData(const void* data, size_t size, VkCommandPool commandPoo
 			imageSize = static_cast<VkDeviceSize>(this->width * this->height * 4); // Default to 4 bytes
 		break;
 	}
+
+	/// Layers follow each other in the data, like the copy region below expects
+	imageSize *= this->layerCount;
 	
 	/// Create a staging buffer to transfer data from CPU to GPU
 	/// For optimal performance, we use a staging buffer rather than directly mapping image memory
@@ -95,6 +95,11 @@ public:
 	/// @return Handle to the image view
 	[[nodiscard]] VkImageView getImageView() const { return this->imageView.get(); }
 
+	/// Get the texture's image
+	/// Needed by code that records its own copies into the texture
+	/// @return Handle to the image
+	[[nodiscard]] VkImage getImage() const { return this->image.get(); }
+
 	/// Get the texture's sampler
 	/// This is needed for binding the texture to descriptors
 	/// @return Handle to the sampler
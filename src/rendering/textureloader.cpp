@@ -1,6 +1,7 @@
 #include "textureloader.h"
 
 #include <spdlog/spdlog.h>
+#include <new>
 
 /// We define STB_IMAGE_IMPLEMENTATION in only one .cpp file
 /// This is required to include the actual implementation, not just the header
@@ -9,6 +10,16 @@
 
 namespace lillugsi::rendering {
 
+TextureLoader::PixelBuffer::PixelBuffer(uint8_t* pixels, size_t size)
+	: pixels(pixels)
+	, byteCount(pixels ? size : 0) {
+}
+
+void TextureLoader::PixelBuffer::Deleter::operator()(uint8_t* pixels) const {
+	/// stb_image allocates with its own allocator, so it must free as well
+	stbi_image_free(pixels);
+}
+
 TextureLoader::TextureData TextureLoader::loadFromFile(
 	const std::string& filename,
 	Format format,
@@ -48,13 +59,11 @@ TextureLoader::TextureData TextureLoader::loadFromFile(
 
 	/// Calculate total size of the pixel data
 	/// This accounts for the image dimensions and channel count
-	size_t dataSize = width * height * actualChannels;
+	size_t dataSize = static_cast<size_t>(width) * height * actualChannels;
 
-	/// Copy the loaded data into our result vector
-	/// We copy the data instead of using it directly because stbi_load
-	/// allocates with malloc, and we want to use RAII with std::vector
-	result.pixels.resize(dataSize);
-	std::memcpy(result.pixels.data(), data, dataSize);
+	/// Keep the decoded data where stb put it
+	/// The pixel buffer frees it with stbi_image_free, so we get RAII without a copy
+	result.pixels = PixelBuffer(data, dataSize);
 
 	/// Populate metadata in the result
 	result.width = width;
@@ -62,10 +71,6 @@ TextureLoader::TextureData TextureLoader::loadFromFile(
 	result.channels = actualChannels;
 	result.success = true;
 
-	/// Free the original stb-allocated memory
-	/// This prevents memory leaks, as stb_image uses malloc/free
-	stbi_image_free(data);
-
 	spdlog::debug("Loaded texture '{}': {}x{}, {} channels, {} bytes",
 		filename, width, height, actualChannels, dataSize);
 
@@ -113,10 +118,9 @@ TextureLoader::TextureData TextureLoader::loadFromMemory(
 	/// Determine the actual channel count based on request
 	int actualChannels = (reqChannels != 0) ? reqChannels : channels;
 
-	/// Calculate and allocate memory for the result
-	size_t dataSize = width * height * actualChannels;
-	result.pixels.resize(dataSize);
-	std::memcpy(result.pixels.data(), imgData, dataSize);
+	/// Take over the decoded data, the pixel buffer frees it with stbi_image_free
+	size_t dataSize = static_cast<size_t>(width) * height * actualChannels;
+	result.pixels = PixelBuffer(imgData, dataSize);
 
 	/// Populate metadata
 	result.width = width;
@@ -124,9 +128,6 @@ TextureLoader::TextureData TextureLoader::loadFromMemory(
 	result.channels = actualChannels;
 	result.success = true;
 
-	/// Free the original stb-allocated memory
-	stbi_image_free(imgData);
-
 	spdlog::debug("Loaded texture from memory: {}x{}, {} channels, {} bytes",
 		width, height, actualChannels, dataSize);
 
@@ -162,6 +163,34 @@ TextureLoader::TextureData TextureLoader::loadFromBufferView(
 	return loadFromMemory(bufferData, bufferSize, format, flipVertically);
 }
 
+void TextureLoader::expandToRgba(TextureData& textureData) {
+	if (textureData.channels != 3) {
+		return;
+	}
+
+	/// Allocate with stb's allocator, the pixel buffer frees with stbi_image_free
+	const size_t pixelCount = static_cast<size_t>(textureData.width) * textureData.height;
+	auto* rgba = static_cast<uint8_t*>(STBI_MALLOC(pixelCount * 4));
+	if (!rgba) {
+		throw std::bad_alloc();
+	}
+
+	const uint8_t* rgb = textureData.pixels.data();
+	for (size_t i = 0; i < pixelCount; i++) {
+		rgba[i * 4 + 0] = rgb[i * 3 + 0]; /// R
+		rgba[i * 4 + 1] = rgb[i * 3 + 1]; /// G
+		rgba[i * 4 + 2] = rgb[i * 3 + 2]; /// B
+		rgba[i * 4 + 3] = 255;            /// A (fully opaque)
+	}
+
+	textureData.pixels = PixelBuffer(rgba, pixelCount * 4);
+	textureData.channels = 4;
+}
+
+TextureLoader::Format TextureLoader::getUploadFormat(Format format) {
+	return format == Format::RGB ? Format::RGBA : format;
+}
+
 int TextureLoader::formatToChannels(Format format) {
 	/// Convert our format enum to the number of channels parameter used by stb_image
 	/// stb_image uses 0 to mean "keep original format"
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <memory>
@@ -11,10 +13,39 @@ namespace lillugsi::rendering {
 /// for working with various image formats and sources
 class TextureLoader {
 public:
+	/// Decoded pixels, owned in the allocation stb_image decoded them into
+	/// Copying them into a std::vector would touch every byte once more and briefly
+	/// hold the image twice. The buffer is move-only, so it travels from the decoder
+	/// to the staging upload without ever being duplicated.
+	class PixelBuffer {
+	public:
+		PixelBuffer() = default;
+
+		/// Take ownership of memory allocated by stb_image
+		/// @param pixels The decoded pixels
+		/// @param size Size of the pixels in bytes
+		PixelBuffer(uint8_t* pixels, size_t size);
+
+		[[nodiscard]] const uint8_t* data() const { return this->pixels.get(); }
+		[[nodiscard]] uint8_t* data() { return this->pixels.get(); }
+		[[nodiscard]] size_t size() const { return this->byteCount; }
+		[[nodiscard]] bool empty() const { return this->byteCount == 0; }
+
+		[[nodiscard]] uint8_t operator[](size_t index) const { return this->pixels.get()[index]; }
+
+	private:
+		struct Deleter {
+			void operator()(uint8_t* pixels) const;
+		};
+
+		std::unique_ptr<uint8_t, Deleter> pixels;
+		size_t byteCount{0};
+	};
+
 	/// Contains the result of loading a texture
 	/// This struct bundles all the data and metadata from an image load operation
 	struct TextureData {
-		std::vector<uint8_t> pixels;  /// Raw pixel data in requested format
+		PixelBuffer pixels;           /// Raw pixel data in requested format
 		int width{0};                 /// Width of the image in pixels
 		int height{0};                /// Height of the image in pixels
 		int channels{0};              /// Number of color channels (e.g., 3 for RGB, 4 for RGBA)
@@ -77,6 +108,20 @@ public:
 		bool flipVertically = true
 	);
 
+	/// Widen RGB pixels to RGBA in place of the loaded data
+	/// Vulkan implementations rarely sample three channel formats. Where the channel
+	/// count is known up front, requesting RGBA from the decoder is cheaper, since stb
+	/// converts while decoding; this covers images loaded with Format::Keep.
+	/// @param textureData Loaded texture with three channels, has four afterwards
+	static void expandToRgba(TextureData& textureData);
+
+	/// Get the format to decode with for a format that will be uploaded
+	/// RGB images are widened to RGBA for upload anyway, so the decoder produces
+	/// RGBA right away instead of a three channel image we would copy again
+	/// @param format The format the caller asked for
+	/// @return The format to pass to the load functions
+	[[nodiscard]] static Format getUploadFormat(Format format);
+
 private:
 	/// Convert our format enum to stb's desired channels parameter
 	/// @param format The format to convert
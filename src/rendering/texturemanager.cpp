@@ -52,7 +52,8 @@ std::shared_ptr<Texture> TextureManager::getOrLoadTexture(
 	spdlog::debug("Loading texture: {}", normalizedPath);
 
 	/// Use TextureLoader to load the pixel data from file
-	auto textureData = TextureLoader::loadFromFile(normalizedPath, format);
+	/// RGB is decoded as RGBA directly, since we would widen it for the upload anyway
+	auto textureData = TextureLoader::loadFromFile(normalizedPath, TextureLoader::getUploadFormat(format));
 
 	/// If loading failed, return the default texture as a fallback
 	if (!textureData.success) {
@@ -69,16 +70,7 @@ std::shared_ptr<Texture> TextureManager::getOrLoadTexture(
 		if (textureData.channels == 3) {
 			/// Convert RGB to RGBA by adding alpha channel
 			spdlog::debug("Converting RGB to RGBA for normal map");
-			std::vector<uint8_t> rgbaData(textureData.width * textureData.height * 4);
-			for (int i = 0; i < textureData.width * textureData.height; i++) {
-				rgbaData[i * 4 + 0] = textureData.pixels[i * 3 + 0]; /// R
-				rgbaData[i * 4 + 1] = textureData.pixels[i * 3 + 1]; /// G
-				rgbaData[i * 4 + 2] = textureData.pixels[i * 3 + 2]; /// B
-				rgbaData[i * 4 + 3] = 255;                           /// A (fully opaque)
-			}
-			/// Swap the pixel data
-			textureData.pixels = std::move(rgbaData);
-			textureData.channels = 4;
+			TextureLoader::expandToRgba(textureData);
 		}
 		/// By using VK_FORMAT_R8G8B8A8_UNORM, we ensure the values are read exactly as they are
 		/// stored, without any gamma correction. This preserves the linear relationship needed for
@@ -95,16 +87,7 @@ std::shared_ptr<Texture> TextureManager::getOrLoadTexture(
 		case 3: {
 			// Convert RGB to RGBA for better compatibility
 			spdlog::debug("Converting RGB to RGBA for better compatibility");
-			std::vector<uint8_t> rgbaData(textureData.width * textureData.height * 4);
-			for (int i = 0; i < textureData.width * textureData.height; i++) {
-				rgbaData[i * 4 + 0] = textureData.pixels[i * 3 + 0]; /// R
-				rgbaData[i * 4 + 1] = textureData.pixels[i * 3 + 1]; /// G
-				rgbaData[i * 4 + 2] = textureData.pixels[i * 3 + 2]; /// B
-				rgbaData[i * 4 + 3] = 255;                           /// A (fully opaque)
-			}
-			/// Swap the pixel data
-			textureData.pixels = std::move(rgbaData);
-			textureData.channels = 4;
+			TextureLoader::expandToRgba(textureData);
 			vulkanFormat = VK_FORMAT_R8G8B8A8_SRGB;
 			break;
 		}
@@ -294,7 +277,7 @@ std::shared_ptr<Texture> TextureManager::createTextureFromBufferView(
 		bufferData,
 		bufferSize,
 		mimeType,
-		format
+		TextureLoader::getUploadFormat(format)
 	);
 
 	/// If loading failed, return the default texture as a fallback
@@ -315,16 +298,7 @@ std::shared_ptr<Texture> TextureManager::createTextureFromBufferView(
 		if (textureData.channels == 3) {
 			/// Convert RGB to RGBA by adding alpha channel
 			spdlog::debug("Converting RGB to RGBA for embedded normal map");
-			std::vector<uint8_t> rgbaData(textureData.width * textureData.height * 4);
-			for (int i = 0; i < textureData.width * textureData.height; i++) {
-				rgbaData[i * 4 + 0] = textureData.pixels[i * 3 + 0]; /// R
-				rgbaData[i * 4 + 1] = textureData.pixels[i * 3 + 1]; /// G
-				rgbaData[i * 4 + 2] = textureData.pixels[i * 3 + 2]; /// B
-				rgbaData[i * 4 + 3] = 255;                           /// A (fully opaque)
-			}
-			/// Swap the pixel data
-			textureData.pixels = std::move(rgbaData);
-			textureData.channels = 4;
+			TextureLoader::expandToRgba(textureData);
 		}
 	} else {
 		/// For standard textures, select format based on channel count
@@ -338,16 +312,7 @@ std::shared_ptr<Texture> TextureManager::createTextureFromBufferView(
 		case 3: {
 			/// Convert RGB to RGBA for better compatibility with Vulkan
 			spdlog::debug("Converting RGB to RGBA for embedded texture");
-			std::vector<uint8_t> rgbaData(textureData.width * textureData.height * 4);
-			for (int i = 0; i < textureData.width * textureData.height; i++) {
-				rgbaData[i * 4 + 0] = textureData.pixels[i * 3 + 0]; /// R
-				rgbaData[i * 4 + 1] = textureData.pixels[i * 3 + 1]; /// G
-				rgbaData[i * 4 + 2] = textureData.pixels[i * 3 + 2]; /// B
-				rgbaData[i * 4 + 3] = 255;                           /// A (fully opaque)
-			}
-			/// Swap the pixel data
-			textureData.pixels = std::move(rgbaData);
-			textureData.channels = 4;
+			TextureLoader::expandToRgba(textureData);
 			vulkanFormat = VK_FORMAT_R8G8B8A8_SRGB;
 			break;
 		}
@@ -0,0 +1,291 @@
+#include "upscalepass.h"
+#include "vulkan/pipelineconfig.h"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+
+namespace lillugsi::rendering {
+
+UpscalePass::UpscalePass(VkDevice device)
+	: device(device) {
+}
+
+UpscalePass::~UpscalePass() {
+	this->cleanup();
+}
+
+void UpscalePass::initialize(VkFormat swapChainFormat) {
+	this->createRenderPass(swapChainFormat);
+	this->createSampler();
+	this->createDescriptorResources();
+	this->createPipeline();
+
+	spdlog::info("Upscale pass initialized");
+}
+
+void UpscalePass::cleanup() {
+	/// Destroy in reverse order of creation
+	/// The descriptor set is freed together with its pool
+	this->pipeline.reset();
+	this->pipelineLayout.reset();
+	this->descriptorSet = VK_NULL_HANDLE;
+	this->descriptorPool.reset();
+	this->descriptorSetLayout.reset();
+	this->sampler.reset();
+	this->renderPass.reset();
+}
+
+void UpscalePass::createRenderPass(VkFormat swapChainFormat) {
+	/// Every pixel gets overwritten by the fullscreen triangle,
+	/// so the previous content doesn't need to be loaded or cleared
+	VkAttachmentDescription colorAttachment{};
+	colorAttachment.format = swapChainFormat;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; /// Ready for presentation afterwards
+
+	VkAttachmentReference colorAttachmentRef{};
+	colorAttachmentRef.attachment = 0;
+	colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentRef;
+
+	/// The swap chain image becomes available at the color output stage,
+	/// which is where the acquire semaphore is waited on
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcAccessMask = 0;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dependencyFlags = 0;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &colorAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+
+	VkRenderPass pass;
+	VK_CHECK(vkCreateRenderPass(this->device, &renderPassInfo, nullptr, &pass));
+
+	this->renderPass = vulkan::VulkanRenderPassHandle(pass, [device = this->device](VkRenderPass rp) {
+		vkDestroyRenderPass(device, rp, nullptr);
+	});
+}
+
+void UpscalePass::createSampler() {
+	/// Bilinear filtering does the actual upscaling
+	/// Clamping keeps the border texels from wrapping around
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+	VkSampler rawSampler;
+	VK_CHECK(vkCreateSampler(this->device, &samplerInfo, nullptr, &rawSampler));
+
+	this->sampler = vulkan::VulkanSamplerHandle(rawSampler, [device = this->device](VkSampler s) {
+		vkDestroySampler(device, s, nullptr);
+	});
+}
+
+void UpscalePass::createDescriptorResources() {
+	/// A single combined image sampler for the scene image
+	VkDescriptorSetLayoutBinding binding{};
+	binding.binding = 0;
+	binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	binding.descriptorCount = 1;
+	binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = 1;
+	layoutInfo.pBindings = &binding;
+
+	VkDescriptorSetLayout layout;
+	VK_CHECK(vkCreateDescriptorSetLayout(this->device, &layoutInfo, nullptr, &layout));
+
+	this->descriptorSetLayout = vulkan::VulkanDescriptorSetLayoutHandle(layout,
+		[device = this->device](VkDescriptorSetLayout l) {
+			vkDestroyDescriptorSetLayout(device, l, nullptr);
+		});
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount = 1;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+	poolInfo.maxSets = 1;
+
+	VkDescriptorPool pool;
+	VK_CHECK(vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &pool));
+
+	this->descriptorPool = vulkan::VulkanDescriptorPoolHandle(pool, [device = this->device](VkDescriptorPool p) {
+		vkDestroyDescriptorPool(device, p, nullptr);
+	});
+
+	VkDescriptorSetLayout setLayout = this->descriptorSetLayout.get();
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = this->descriptorPool.get();
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+
+	VK_CHECK(vkAllocateDescriptorSets(this->device, &allocInfo, &this->descriptorSet));
+}
+
+void UpscalePass::createPipeline() {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(PushConstants);
+
+	VkDescriptorSetLayout setLayout = this->descriptorSetLayout.get();
+	VkPipelineLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.setLayoutCount = 1;
+	layoutInfo.pSetLayouts = &setLayout;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkPipelineLayout layout;
+	VK_CHECK(vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &layout));
+
+	this->pipelineLayout = vulkan::VulkanPipelineLayoutHandle(layout, [device = this->device](VkPipelineLayout l) {
+		vkDestroyPipelineLayout(device, l, nullptr);
+	});
+
+	/// The fullscreen triangle is generated in the vertex shader,
+	/// so there is no vertex input, no culling and no depth
+	vulkan::PipelineConfig config;
+	config.addShaderStage(VK_SHADER_STAGE_VERTEX_BIT, VertexShaderPath);
+	config.addShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, FragmentShaderPath);
+	config.setRasterization(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	config.setDepthState(false, false, VK_COMPARE_OP_ALWAYS);
+
+	auto createInfo = config.getCreateInfo(this->device, this->renderPass.get(), layout);
+
+	VkPipeline rawPipeline;
+	VK_CHECK(vkCreateGraphicsPipelines(this->device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &rawPipeline));
+
+	this->pipeline = vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+}
+
+void UpscalePass::setSource(VkImageView sourceImageView) {
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView = sourceImageView;
+	imageInfo.sampler = this->sampler.get();
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = this->descriptorSet;
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.dstArrayElement = 0;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(this->device, 1, &descriptorWrite, 0, nullptr);
+}
+
+void UpscalePass::record(VkCommandBuffer commandBuffer,
+	VkFramebuffer framebuffer,
+	VkExtent2D targetExtent,
+	VkExtent2D sourceExtent,
+	VkExtent2D renderExtent) const {
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = this->renderPass.get();
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = targetExtent;
+	renderPassInfo.clearValueCount = 0;
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->pipeline.get());
+
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(targetExtent.width);
+	viewport.height = static_cast<float>(targetExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = {0, 0};
+	scissor.extent = targetExtent;
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		this->pipelineLayout.get(),
+		0, 1, &this->descriptorSet,
+		0, nullptr);
+
+	/// Map the swap chain UVs onto the rendered part of the source image
+	/// The clamp stops half a texel inside that part, so bilinear filtering and
+	/// the sharpening taps never pick up stale pixels from earlier, larger frames
+	const glm::vec2 sourceSize(
+		static_cast<float>(sourceExtent.width),
+		static_cast<float>(sourceExtent.height));
+	const glm::vec2 renderSize(
+		static_cast<float>(renderExtent.width),
+		static_cast<float>(renderExtent.height));
+
+	PushConstants constants{};
+	constants.uvScale = renderSize / sourceSize;
+	constants.sourceTexelSize = 1.0f / sourceSize;
+	constants.maxUv = (renderSize - 0.5f) / sourceSize;
+	constants.sharpness = this->sharpness;
+	constants.padding = 0.0f;
+
+	vkCmdPushConstants(commandBuffer,
+		this->pipelineLayout.get(),
+		VK_SHADER_STAGE_FRAGMENT_BIT,
+		0,
+		sizeof(PushConstants),
+		&constants);
+
+	/// One triangle covering the whole screen
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+	vkCmdEndRenderPass(commandBuffer);
+}
+
+void UpscalePass::setSharpness(float value) {
+	this->sharpness = std::clamp(value, 0.0f, 1.0f);
+}
+
+} /// namespace lillugsi::rendering
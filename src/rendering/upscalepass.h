@@ -0,0 +1,99 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+
+namespace lillugsi::rendering {
+
+/// UpscalePass scales the offscreen scene image up into the swap chain image
+/// The scene is rendered at a reduced resolution when the GPU is over budget.
+/// This pass draws a single fullscreen triangle that samples the rendered part of the
+/// offscreen image with bilinear filtering, then applies contrast-adaptive sharpening:
+/// flat areas get sharpened to recover detail lost to upscaling, while strong edges
+/// get little sharpening so they don't ring or grow halos.
+///
+/// The pass renders at full swap chain resolution, so anything that should stay crisp
+/// regardless of the render scale, like UI, belongs into this pass after the upscale
+class UpscalePass {
+public:
+	static constexpr const char* VertexShaderPath = "shaders/upscale.vert.spv";
+	static constexpr const char* FragmentShaderPath = "shaders/upscale.frag.spv";
+
+	/// Default sharpening strength in [0, 1]
+	static constexpr float DefaultSharpness = 0.5f;
+
+	/// Constructor
+	/// @param device The logical device to create resources on
+	explicit UpscalePass(VkDevice device);
+
+	/// Destructor
+	~UpscalePass();
+
+	/// Create the render pass, sampler, descriptors and pipeline
+	/// @param swapChainFormat Format of the swap chain images we render into
+	void initialize(VkFormat swapChainFormat);
+
+	/// Release all Vulkan resources
+	void cleanup();
+
+	/// Point the pass at the image to upscale
+	/// Must be called again whenever the source image is recreated
+	/// @param sourceImageView The offscreen scene color image
+	void setSource(VkImageView sourceImageView);
+
+	/// Record the upscale pass
+	/// @param commandBuffer The command buffer being recorded
+	/// @param framebuffer Swap chain framebuffer to render into
+	/// @param targetExtent Size of the swap chain image
+	/// @param sourceExtent Full size of the source image
+	/// @param renderExtent Part of the source image the scene was rendered into
+	void record(VkCommandBuffer commandBuffer,
+		VkFramebuffer framebuffer,
+		VkExtent2D targetExtent,
+		VkExtent2D sourceExtent,
+		VkExtent2D renderExtent) const;
+
+	/// Get the render pass targeting the swap chain images
+	/// @return Render pass handle, framebuffers must be compatible with it
+	[[nodiscard]] VkRenderPass getRenderPass() const { return this->renderPass.get(); }
+
+	/// Set the sharpening strength
+	/// @param value 0 for plain bilinear upscaling, 1 for maximum sharpening
+	void setSharpness(float value);
+
+	/// Get the sharpening strength
+	/// @return Sharpness in [0, 1]
+	[[nodiscard]] float getSharpness() const { return this->sharpness; }
+
+private:
+	/// Push constants for the fragment shader
+	/// Layout matches the PushConstants block in upscale.glsl.frag
+	struct PushConstants {
+		glm::vec2 uvScale;          /// Rendered part of the source relative to its full size
+		glm::vec2 sourceTexelSize;  /// Size of one source texel in UV units
+		glm::vec2 maxUv;            /// Clamp so we never filter in texels outside the rendered part
+		float sharpness;            /// Sharpening strength
+		float padding;              /// Keep the block a multiple of 8 bytes
+	};
+
+	void createRenderPass(VkFormat swapChainFormat);
+	void createSampler();
+	void createDescriptorResources();
+	void createPipeline();
+
+	VkDevice device;
+
+	vulkan::VulkanRenderPassHandle renderPass;
+	vulkan::VulkanSamplerHandle sampler;
+	vulkan::VulkanDescriptorSetLayoutHandle descriptorSetLayout;
+	vulkan::VulkanDescriptorPoolHandle descriptorPool;
+	VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+	vulkan::VulkanPipelineLayoutHandle pipelineLayout;
+	vulkan::VulkanPipelineHandle pipeline;
+
+	float sharpness{DefaultSharpness};
+};
+
+} /// namespace lillugsi::rendering
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <vulkan/vulkan.h>
+#include <cstdint>
 #include <vector>
 
 namespace lillugsi::rendering {
@@ -99,4 +101,153 @@ struct Vertex {
 	}
 };
 
+/// Layout of the vertices in a mesh's vertex buffer
+enum class VertexFormat : uint32_t {
+	Standard,   /// Vertex, 32 bit floats
+	Quantized   /// QuantizedVertex, dequantized in the vertex shader
+};
+
+/// Specialization constant selecting the vertex format in vertex shaders
+/// Matches constant_id = 1 in vertex shaders supporting quantized vertices
+inline constexpr uint32_t VertexFormatConstantId = 1;
+
+/// Turns the integers of a QuantizedVertex back into object space values
+/// KHR_mesh_quantization stores positions and texture coordinates as 8 or 16 bit
+/// integers, relative to a range only the exporter knows. We convert every source
+/// type to 16 bit integers and describe the rest of the mapping per mesh, so all
+/// quantized meshes share one vertex layout: value = integer * scale + offset.
+/// The layout matches the members after the model matrix in the vertex shaders' push constants
+struct VertexDequantization {
+	glm::vec4 positionScale{1.0f};          /// xyz used
+	glm::vec4 positionOffset{0.0f};         /// xyz used
+	glm::vec4 texCoordScaleOffset{1.0f, 1.0f, 0.0f, 0.0f};  /// Scale in xy, offset in zw
+};
+
+/// Compact vertex of meshes imported with quantized attributes
+/// 24 bytes instead of the 56 of Vertex. The GPU converts the integers to floats while
+/// fetching them: positions and texture coordinates arrive as whole numbers that the
+/// vertex shader maps with the mesh's VertexDequantization, directions and colors
+/// arrive already normalized. Attribute locations match Vertex, so the same vertex
+/// shader handles both layouts with a specialization constant.
+struct QuantizedVertex {
+	glm::i16vec4 position;   /// xyz, w is padding
+	glm::i8vec4 normal;      /// xyz as signed normalized, w is padding
+	glm::i8vec4 tangent;     /// xyz as signed normalized, w is padding
+	glm::u8vec4 color;       /// rgb as unsigned normalized, a is padding
+	glm::i16vec2 texCoord;
+
+	/// Get the binding description for this vertex format
+	/// @return The vertex binding description
+	static VkVertexInputBindingDescription getBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 0;
+		bindingDescription.stride = sizeof(QuantizedVertex);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDescription;
+	}
+
+	/// Get attribute descriptions for this vertex format
+	/// The formats are all mandatory for vertex buffers, 3 component 16 and 8 bit
+	/// formats are not, which is why every attribute has a padding component
+	/// @return Vector of attribute descriptions
+	static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions(5);
+
+		/// Scaled formats convert the integers to floats without normalizing them
+		attributeDescriptions[0].binding = 0;
+		attributeDescriptions[0].location = 0;
+		attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SSCALED;
+		attributeDescriptions[0].offset = offsetof(QuantizedVertex, position);
+
+		attributeDescriptions[1].binding = 0;
+		attributeDescriptions[1].location = 1;
+		attributeDescriptions[1].format = VK_FORMAT_R8G8B8A8_SNORM;
+		attributeDescriptions[1].offset = offsetof(QuantizedVertex, normal);
+
+		attributeDescriptions[2].binding = 0;
+		attributeDescriptions[2].location = 2;
+		attributeDescriptions[2].format = VK_FORMAT_R8G8B8A8_SNORM;
+		attributeDescriptions[2].offset = offsetof(QuantizedVertex, tangent);
+
+		attributeDescriptions[3].binding = 0;
+		attributeDescriptions[3].location = 3;
+		attributeDescriptions[3].format = VK_FORMAT_R8G8B8A8_UNORM;
+		attributeDescriptions[3].offset = offsetof(QuantizedVertex, color);
+
+		attributeDescriptions[4].binding = 0;
+		attributeDescriptions[4].location = 4;
+		attributeDescriptions[4].format = VK_FORMAT_R16G16_SSCALED;
+		attributeDescriptions[4].offset = offsetof(QuantizedVertex, texCoord);
+
+		return attributeDescriptions;
+	}
+};
+
+static_assert(sizeof(QuantizedVertex) == 24, "QuantizedVertex must stay tightly packed");
+
+/// Per-instance attributes of instanced meshes, read from a second vertex buffer
+/// The transform places an instance relative to the draw's model matrix. Its last row
+/// is always (0, 0, 0, 1), so we only store the first three: 48 bytes per instance
+/// instead of 64 add up with hundreds of thousands of instances.
+/// Locations follow those of Vertex and QuantizedVertex, both can be instanced
+struct InstanceTransform {
+	glm::vec4 rows[3];
+
+	/// Create the instance attributes of a transform
+	/// @param transform Affine transform of the instance
+	static InstanceTransform fromMatrix(const glm::mat4& transform) {
+		const glm::mat4 transposed = glm::transpose(transform);
+		return InstanceTransform{{transposed[0], transposed[1], transposed[2]}};
+	}
+
+	/// Get the binding description of the instance buffer
+	/// @return The binding description, advancing once per instance
+	static VkVertexInputBindingDescription getBindingDescription() {
+		VkVertexInputBindingDescription bindingDescription{};
+		bindingDescription.binding = 1;
+		bindingDescription.stride = sizeof(InstanceTransform);
+		bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+		return bindingDescription;
+	}
+
+	/// Get attribute descriptions of the instance buffer
+	/// @return One attribute per row, at locations 5 to 7
+	static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions(3);
+		for (uint32_t row = 0; row < 3; ++row) {
+			attributeDescriptions[row].binding = 1;
+			attributeDescriptions[row].location = 5 + row;
+			attributeDescriptions[row].format = VK_FORMAT_R32G32B32A32_SFLOAT;
+			attributeDescriptions[row].offset = row * sizeof(glm::vec4);
+		}
+
+		return attributeDescriptions;
+	}
+};
+
+static_assert(sizeof(InstanceTransform) == 48, "InstanceTransform must stay tightly packed");
+
+/// Joints and weights moving a vertex of a skinned mesh
+/// Never bound as vertex attributes, the skinning pass reads them from a storage buffer
+/// next to the rest pose vertices. Four 16 bit joint indices and four 16 bit normalized
+/// weights, two per 32 bit word so the shader unpacks them without 16 bit storage
+struct SkinInfluence {
+	uint32_t joints[2];   /// Joint 0 and 1, joint 2 and 3, lower half first
+	uint32_t weights[2];  /// Weights in the same order, summing up to 1
+
+	/// Pack the influences of a vertex
+	/// @param jointIndices Index of each joint in the skin
+	/// @param jointWeights Weight of each joint, normalized to a sum of 1
+	static SkinInfluence pack(const glm::uvec4& jointIndices, const glm::vec4& jointWeights) {
+		const glm::uvec4 weights = glm::uvec4(glm::round(glm::clamp(jointWeights, 0.0f, 1.0f) * 65535.0f));
+		return SkinInfluence{
+			{(jointIndices.x & 0xffff) | (jointIndices.y << 16), (jointIndices.z & 0xffff) | (jointIndices.w << 16)},
+			{weights.x | (weights.y << 16), weights.z | (weights.w << 16)}};
+	}
+};
+
+static_assert(sizeof(SkinInfluence) == 16, "SkinInfluence must match the skinning shader");
+
 } /// namespace lillugsi::rendering
\ No newline at end of file
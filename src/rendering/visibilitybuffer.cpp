@@ -0,0 +1,1000 @@
+#include "visibilitybuffer.h"
+#include "pbrmaterial.h"
+#include "vulkan/pipelineconfig.h"
+#include "vulkan/shadermodule.h"
+#include "vulkan/vertexbuffer.h"
+#include "vulkan/indexbuffer.h"
+#include "vulkan/vulkanutils.h"
+#include <spdlog/spdlog.h>
+#include <array>
+
+namespace lillugsi::rendering {
+
+namespace {
+/// Workgroup size of the classify and scatter passes, matches their local_size
+constexpr uint32_t PixelGroupSize = 8;
+}
+
+VisibilityBuffer::VisibilityBuffer(VkDevice device, VkPhysicalDevice physicalDevice)
+	: device(device)
+	, physicalDevice(physicalDevice) {
+}
+
+VisibilityBuffer::~VisibilityBuffer() {
+	this->cleanup();
+}
+
+void VisibilityBuffer::initialize(VkFormat sceneColorFormat,
+	VkFormat depthFormat,
+	VkDescriptorSetLayout cameraLayout,
+	VkDescriptorSetLayout lightLayout) {
+	this->createRenderPasses(sceneColorFormat, depthFormat);
+	this->createDescriptorResources();
+	this->createMaterialDescriptorLayout();
+	this->createPipelines(cameraLayout, lightLayout);
+	this->createFixedBuffers();
+
+	this->visibilityTarget = std::make_unique<vulkan::ColorTarget>(this->device, this->physicalDevice);
+	this->shadedTarget = std::make_unique<vulkan::ColorTarget>(this->device, this->physicalDevice);
+
+	spdlog::info("Visibility buffer initialized");
+}
+
+void VisibilityBuffer::resize(uint32_t width, uint32_t height, VkImageView depthImageView) {
+	/// The ID target is written as an attachment and read as a storage image,
+	/// the shaded target is only ever touched by shaders
+	this->visibilityTarget->initialize(width, height, VisibilityFormat, VK_IMAGE_USAGE_STORAGE_BIT);
+	this->shadedTarget->initialize(width, height, ShadedFormat, VK_IMAGE_USAGE_STORAGE_BIT);
+
+	std::array<VkImageView, 2> attachments = {
+		this->visibilityTarget->getImageView(),
+		depthImageView
+	};
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = this->visibilityRenderPass.get();
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments = attachments.data();
+	framebufferInfo.width = width;
+	framebufferInfo.height = height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+	VK_CHECK(vkCreateFramebuffer(this->device, &framebufferInfo, nullptr, &framebuffer));
+
+	this->visibilityFramebuffer = vulkan::VulkanFramebufferHandle(framebuffer,
+		[device = this->device](VkFramebuffer fb) {
+			vkDestroyFramebuffer(device, fb, nullptr);
+		});
+
+	/// Worst case every pixel is covered, one packed coordinate each
+	this->pixelListBuffer.buffer.reset();
+	this->pixelListBuffer.memory.reset();
+	this->pixelListBuffer = this->createBuffer(
+		static_cast<VkDeviceSize>(width) * height * sizeof(uint32_t),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	this->updateDescriptorSet();
+
+	spdlog::debug("Visibility buffer resized to {}x{}", width, height);
+}
+
+void VisibilityBuffer::cleanup() {
+	/// Destroy in reverse order of creation
+	/// The descriptor set is freed together with its pool
+	this->handledDraws.clear();
+	this->handledPacketIndices.clear();
+	this->binMaterials.clear();
+	this->binByMaterial.clear();
+	this->vertexPoolEntries.clear();
+	this->indexPoolEntries.clear();
+
+	if (this->mappedDrawTable) {
+		vkUnmapMemory(this->device, this->drawTableBuffer.memory.get());
+		this->mappedDrawTable = nullptr;
+	}
+
+	this->pixelListBuffer = DeviceBuffer{};
+	this->indexPool = DeviceBuffer{};
+	this->vertexPool = DeviceBuffer{};
+	this->dispatchBuffer = DeviceBuffer{};
+	this->binBuffer = DeviceBuffer{};
+	this->drawTableBuffer = DeviceBuffer{};
+
+	this->visibilityFramebuffer.reset();
+	this->shadedTarget.reset();
+	this->visibilityTarget.reset();
+
+	this->compositePipeline.reset();
+	this->compositePipelineLayout.reset();
+	this->shadePipeline.reset();
+	this->shadePipelineLayout.reset();
+	this->scatterPipeline.reset();
+	this->prefixPipeline.reset();
+	this->classifyPipeline.reset();
+	this->computePipelineLayout.reset();
+	this->rasterPipelineDoubleSided.reset();
+	this->rasterPipeline.reset();
+	this->rasterPipelineLayout.reset();
+
+	this->descriptorSet = VK_NULL_HANDLE;
+	this->descriptorPool.reset();
+	this->materialDescriptorLayout.reset();
+	this->descriptorSetLayout.reset();
+
+	this->compositeRenderPass.reset();
+	this->visibilityRenderPass.reset();
+}
+
+void VisibilityBuffer::createRenderPasses(VkFormat sceneColorFormat, VkFormat depthFormat) {
+	/// Visibility pass: IDs and depth are both cleared and stored for the later passes
+	/// 0 in the ID target means "no geometry", matching the clear value
+	{
+		std::array<VkAttachmentDescription, 2> attachments{};
+
+		attachments[0].format = VisibilityFormat;
+		attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_GENERAL; /// Read as storage image afterwards
+
+		attachments[1].format = depthFormat;
+		attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_STORE; /// Forward draws test against it later
+		attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+		VkAttachmentReference depthRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorRef;
+		subpass.pDepthStencilAttachment = &depthRef;
+
+		std::array<VkSubpassDependency, 2> dependencies{};
+
+		/// The previous frame's compute and composite passes read these targets
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+			| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[0].srcAccessMask = 0;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+			| VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		/// The compute passes read the IDs, the composite pass continues on the depth
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+			| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+			| VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		VkRenderPass pass;
+		VK_CHECK(vkCreateRenderPass(this->device, &renderPassInfo, nullptr, &pass));
+
+		this->visibilityRenderPass = vulkan::VulkanRenderPassHandle(pass, [device = this->device](VkRenderPass rp) {
+			vkDestroyRenderPass(device, rp, nullptr);
+		});
+	}
+
+	/// Composite pass: same attachments as the scene render pass, so it is compatible
+	/// with the offscreen framebuffer and the forward pipelines.
+	/// The composite covers every pixel, so color needn't be loaded; depth comes from the visibility pass
+	{
+		std::array<VkAttachmentDescription, 2> attachments{};
+
+		attachments[0].format = sceneColorFormat;
+		attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		attachments[0].finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL; /// The upscale pass samples it
+
+		attachments[1].format = depthFormat;
+		attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[1].initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+		VkAttachmentReference colorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+		VkAttachmentReference depthRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+		VkSubpassDescription subpass{};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = 1;
+		subpass.pColorAttachments = &colorRef;
+		subpass.pDepthStencilAttachment = &depthRef;
+
+		std::array<VkSubpassDependency, 2> dependencies{};
+
+		/// Wait for the shading pass output and the visibility pass depth
+		dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass = 0;
+		dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+			| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT
+			| VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+		/// Same as the scene render pass: the upscale pass samples the result
+		dependencies[1].srcSubpass = 0;
+		dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+			| VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+			| VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		dependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		VkRenderPassCreateInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
+
+		VkRenderPass pass;
+		VK_CHECK(vkCreateRenderPass(this->device, &renderPassInfo, nullptr, &pass));
+
+		this->compositeRenderPass = vulkan::VulkanRenderPassHandle(pass, [device = this->device](VkRenderPass rp) {
+			vkDestroyRenderPass(device, rp, nullptr);
+		});
+	}
+}
+
+void VisibilityBuffer::createDescriptorResources() {
+	/// One set holds everything the compute passes and the composite share
+	/// Bindings match visibilitycommon.glsl
+	std::array<VkDescriptorSetLayoutBinding, 8> bindings{};
+	const std::array<VkDescriptorType, 8> types = {
+		VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,   /// 0: visibility IDs
+		VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,   /// 1: shaded image
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  /// 2: draw table
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  /// 3: vertex pool
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  /// 4: index pool
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  /// 5: bin counters
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,  /// 6: indirect dispatch arguments
+		VK_DESCRIPTOR_TYPE_STORAGE_BUFFER   /// 7: pixel list
+	};
+
+	for (uint32_t i = 0; i < bindings.size(); ++i) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = types[i];
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		bindings[i].pImmutableSamplers = nullptr;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	VK_CHECK(vkCreateDescriptorSetLayout(this->device, &layoutInfo, nullptr, &layout));
+
+	this->descriptorSetLayout = vulkan::VulkanDescriptorSetLayoutHandle(layout,
+		[device = this->device](VkDescriptorSetLayout l) {
+			vkDestroyDescriptorSetLayout(device, l, nullptr);
+		});
+
+	std::array<VkDescriptorPoolSize, 2> poolSizes{};
+	poolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	poolSizes[0].descriptorCount = 2;
+	poolSizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[1].descriptorCount = 6;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes = poolSizes.data();
+	poolInfo.maxSets = 1;
+
+	VkDescriptorPool pool;
+	VK_CHECK(vkCreateDescriptorPool(this->device, &poolInfo, nullptr, &pool));
+
+	this->descriptorPool = vulkan::VulkanDescriptorPoolHandle(pool, [device = this->device](VkDescriptorPool p) {
+		vkDestroyDescriptorPool(device, p, nullptr);
+	});
+
+	VkDescriptorSetLayout setLayout = this->descriptorSetLayout.get();
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = this->descriptorPool.get();
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &setLayout;
+
+	VK_CHECK(vkAllocateDescriptorSets(this->device, &allocInfo, &this->descriptorSet));
+}
+
+void VisibilityBuffer::createMaterialDescriptorLayout() {
+	/// The shading pipeline binds the descriptor sets of PBR materials at set 2
+	/// Sets may be bound with any identically defined layout, so instead of depending
+	/// on a material instance we create our own copy of PBRMaterial's layout.
+	/// It must stay in sync with PBRMaterial::createDescriptorSetLayout
+	std::array<VkDescriptorSetLayoutBinding, 6> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); ++i) {
+		bindings[i].binding = i;
+		bindings[i].descriptorType = i == 0
+			? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER
+			: VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
+		bindings[i].pImmutableSamplers = nullptr;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings = bindings.data();
+
+	VkDescriptorSetLayout layout;
+	VK_CHECK(vkCreateDescriptorSetLayout(this->device, &layoutInfo, nullptr, &layout));
+
+	this->materialDescriptorLayout = vulkan::VulkanDescriptorSetLayoutHandle(layout,
+		[device = this->device](VkDescriptorSetLayout l) {
+			vkDestroyDescriptorSetLayout(device, l, nullptr);
+		});
+}
+
+void VisibilityBuffer::createPipelines(VkDescriptorSetLayout cameraLayout, VkDescriptorSetLayout lightLayout) {
+	auto createLayout = [this](const std::vector<VkDescriptorSetLayout>& setLayouts,
+		VkShaderStageFlags pushStages, uint32_t pushSize) {
+		VkPushConstantRange pushConstantRange{};
+		pushConstantRange.stageFlags = pushStages;
+		pushConstantRange.offset = 0;
+		pushConstantRange.size = pushSize;
+
+		VkPipelineLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		layoutInfo.pSetLayouts = setLayouts.data();
+		layoutInfo.pushConstantRangeCount = 1;
+		layoutInfo.pPushConstantRanges = &pushConstantRange;
+
+		VkPipelineLayout layout;
+		VK_CHECK(vkCreatePipelineLayout(this->device, &layoutInfo, nullptr, &layout));
+
+		return vulkan::VulkanPipelineLayoutHandle(layout, [device = this->device](VkPipelineLayout l) {
+			vkDestroyPipelineLayout(device, l, nullptr);
+		});
+	};
+
+	/// Raster pass: camera at set 0, model matrix and draw index as push constants
+	this->rasterPipelineLayout = createLayout({cameraLayout},
+		VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+		sizeof(RasterPushConstants));
+
+	/// Classify, prefix and scatter only need the visibility set
+	this->computePipelineLayout = createLayout({this->descriptorSetLayout.get()},
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		sizeof(ComputePushConstants));
+
+	/// Shading uses the same sets 0 to 2 as the forward PBR pipeline, plus the visibility set
+	this->shadePipelineLayout = createLayout({
+			cameraLayout,
+			lightLayout,
+			this->materialDescriptorLayout.get(),
+			this->descriptorSetLayout.get()
+		},
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		sizeof(ComputePushConstants));
+
+	this->compositePipelineLayout = createLayout({this->descriptorSetLayout.get()},
+		VK_SHADER_STAGE_FRAGMENT_BIT,
+		sizeof(glm::vec4));
+
+	/// Raster pipelines only read positions, but keep the full vertex stride
+	/// so the regular vertex buffers can be bound without conversion
+	const auto allAttributes = Vertex::getAttributeDescriptions();
+	const std::vector<VkVertexInputAttributeDescription> positionAttribute = {allAttributes[0]};
+
+	auto createRasterPipeline = [this, &positionAttribute](VkCullModeFlags cullMode) {
+		vulkan::PipelineConfig config;
+		config.addShaderStage(VK_SHADER_STAGE_VERTEX_BIT, VertexShaderPath);
+		config.addShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, FragmentShaderPath);
+		config.setVertexInput(Vertex::getBindingDescription(), positionAttribute);
+		config.setRasterization(VK_POLYGON_MODE_FILL, cullMode, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+		config.setDepthState(true, true, VK_COMPARE_OP_GREATER); /// Reverse-Z
+
+		auto createInfo = config.getCreateInfo(this->device, this->visibilityRenderPass.get(),
+			this->rasterPipelineLayout.get());
+
+		VkPipeline rawPipeline;
+		VK_CHECK(vkCreateGraphicsPipelines(this->device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &rawPipeline));
+
+		return vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+			vkDestroyPipeline(device, p, nullptr);
+		});
+	};
+
+	this->rasterPipeline = createRasterPipeline(VK_CULL_MODE_BACK_BIT);
+	this->rasterPipelineDoubleSided = createRasterPipeline(VK_CULL_MODE_NONE);
+
+	this->classifyPipeline = this->createComputePipeline(ClassifyShaderPath, this->computePipelineLayout.get());
+	this->prefixPipeline = this->createComputePipeline(PrefixShaderPath, this->computePipelineLayout.get());
+	this->scatterPipeline = this->createComputePipeline(ScatterShaderPath, this->computePipelineLayout.get());
+	this->shadePipeline = this->createComputePipeline(ShadeShaderPath, this->shadePipelineLayout.get());
+
+	/// Composite: fullscreen triangle, no depth test so the loaded depth stays untouched
+	{
+		vulkan::PipelineConfig config;
+		config.addShaderStage(VK_SHADER_STAGE_VERTEX_BIT, CompositeVertexShaderPath);
+		config.addShaderStage(VK_SHADER_STAGE_FRAGMENT_BIT, CompositeFragmentShaderPath);
+		config.setRasterization(VK_POLYGON_MODE_FILL, VK_CULL_MODE_NONE, VK_FRONT_FACE_COUNTER_CLOCKWISE);
+		config.setDepthState(false, false, VK_COMPARE_OP_ALWAYS);
+
+		auto createInfo = config.getCreateInfo(this->device, this->compositeRenderPass.get(),
+			this->compositePipelineLayout.get());
+
+		VkPipeline rawPipeline;
+		VK_CHECK(vkCreateGraphicsPipelines(this->device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &rawPipeline));
+
+		this->compositePipeline = vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+			vkDestroyPipeline(device, p, nullptr);
+		});
+	}
+}
+
+vulkan::VulkanPipelineHandle VisibilityBuffer::createComputePipeline(
+	const char* shaderPath, VkPipelineLayout layout) const {
+	auto shaderModule = vulkan::ShaderModule::fromSpirV(this->device, shaderPath, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage = shaderModule.getStageCreateInfo();
+	pipelineInfo.layout = layout;
+
+	VkPipeline rawPipeline;
+	VK_CHECK(vkCreateComputePipelines(this->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &rawPipeline));
+
+	return vulkan::VulkanPipelineHandle(rawPipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+}
+
+VisibilityBuffer::DeviceBuffer VisibilityBuffer::createBuffer(VkDeviceSize size,
+	VkBufferUsageFlags usage,
+	VkMemoryPropertyFlags properties) const {
+	DeviceBuffer result;
+	result.size = size;
+
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = size;
+	bufferInfo.usage = usage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkBuffer buffer;
+	VK_CHECK(vkCreateBuffer(this->device, &bufferInfo, nullptr, &buffer));
+
+	result.buffer = vulkan::VulkanBufferHandle(buffer, [device = this->device](VkBuffer b) {
+		vkDestroyBuffer(device, b, nullptr);
+	});
+
+	VkMemoryRequirements memRequirements;
+	vkGetBufferMemoryRequirements(this->device, buffer, &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = vulkan::utils::findMemoryType(
+		this->physicalDevice, memRequirements.memoryTypeBits, properties);
+
+	VkDeviceMemory memory;
+	VK_CHECK(vkAllocateMemory(this->device, &allocInfo, nullptr, &memory));
+
+	result.memory = vulkan::VulkanDeviceMemoryHandle(memory, [device = this->device](VkDeviceMemory m) {
+		vkFreeMemory(device, m, nullptr);
+	});
+
+	VK_CHECK(vkBindBufferMemory(this->device, buffer, memory, 0));
+
+	return result;
+}
+
+void VisibilityBuffer::createFixedBuffers() {
+	/// The draw table is rewritten every frame, so it lives in host visible memory
+	/// and stays mapped. With one frame in flight the GPU is done with it when we write
+	this->drawTableBuffer = this->createBuffer(
+		MaxDraws * sizeof(DrawData),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+	void* mapped;
+	VK_CHECK(vkMapMemory(this->device, this->drawTableBuffer.memory.get(), 0, VK_WHOLE_SIZE, 0, &mapped));
+	this->mappedDrawTable = static_cast<DrawData*>(mapped);
+
+	/// Counters are cleared with vkCmdFillBuffer at the start of every frame
+	this->binBuffer = this->createBuffer(
+		MaxMaterialBins * sizeof(BinData),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	this->dispatchBuffer = this->createBuffer(
+		MaxMaterialBins * sizeof(VkDispatchIndirectCommand),
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	this->vertexPool = this->createBuffer(
+		VertexPoolSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	this->indexPool = this->createBuffer(
+		IndexPoolSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+void VisibilityBuffer::updateDescriptorSet() {
+	std::array<VkDescriptorImageInfo, 2> imageInfos{};
+	imageInfos[0].imageView = this->visibilityTarget->getImageView();
+	imageInfos[0].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageInfos[1].imageView = this->shadedTarget->getImageView();
+	imageInfos[1].imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	const std::array<const DeviceBuffer*, 6> buffers = {
+		&this->drawTableBuffer,
+		&this->vertexPool,
+		&this->indexPool,
+		&this->binBuffer,
+		&this->dispatchBuffer,
+		&this->pixelListBuffer
+	};
+
+	std::array<VkDescriptorBufferInfo, 6> bufferInfos{};
+	std::array<VkWriteDescriptorSet, 8> writes{};
+
+	for (uint32_t i = 0; i < writes.size(); ++i) {
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = this->descriptorSet;
+		writes[i].dstBinding = i;
+		writes[i].dstArrayElement = 0;
+		writes[i].descriptorCount = 1;
+
+		if (i < imageInfos.size()) {
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+			writes[i].pImageInfo = &imageInfos[i];
+		} else {
+			const size_t bufferIndex = i - imageInfos.size();
+			bufferInfos[bufferIndex].buffer = buffers[bufferIndex]->buffer.get();
+			bufferInfos[bufferIndex].offset = 0;
+			bufferInfos[bufferIndex].range = VK_WHOLE_SIZE;
+			writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			writes[i].pBufferInfo = &bufferInfos[bufferIndex];
+		}
+	}
+
+	vkUpdateDescriptorSets(this->device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+
+bool VisibilityBuffer::isSupportedMaterial(const Material& material) {
+	if (material.getType() != MaterialType::PBR
+		|| material.hasFeature(MaterialFeatureFlags::Transparent)) {
+		return false;
+	}
+
+	/// The shading pass mirrors the standard PBR shaders,
+	/// materials with their own shaders have to be drawn forward
+	const auto* pbrMaterial = dynamic_cast<const PBRMaterial*>(&material);
+	if (!pbrMaterial) {
+		return false;
+	}
+
+	const auto paths = pbrMaterial->getShaderPaths();
+	return paths.vertexPath == PBRMaterial::DefaultVertexShaderPath
+		&& paths.fragmentPath == PBRMaterial::DefaultFragmentShaderPath;
+}
+
+int64_t VisibilityBuffer::acquirePoolRange(VkCommandBuffer commandBuffer,
+	const std::shared_ptr<vulkan::Buffer>& source,
+	VkDeviceSize copySize,
+	VkDeviceSize alignment,
+	const DeviceBuffer& pool,
+	std::unordered_map<const vulkan::Buffer*, PoolEntry>& entries,
+	VkDeviceSize& used) {
+	/// Meshes are usually drawn for many frames, so after the first copy this is a lookup
+	auto it = entries.find(source.get());
+	if (it != entries.end() && it->second.source.lock() == source) {
+		/// Buffers updated in place keep their size, so the copy is refreshed where it is
+		if (it->second.contentVersion != source->getContentVersion()) {
+			VkBufferCopy region{};
+			region.srcOffset = 0;
+			region.dstOffset = it->second.offset;
+			region.size = copySize;
+			vkCmdCopyBuffer(commandBuffer, source->get(), pool.buffer.get(), 1, &region);
+			it->second.contentVersion = source->getContentVersion();
+		}
+		return static_cast<int64_t>(it->second.offset);
+	}
+
+	const VkDeviceSize offset = (used + alignment - 1) / alignment * alignment;
+	if (offset + copySize > pool.size) {
+		return -1;
+	}
+
+	VkBufferCopy region{};
+	region.srcOffset = 0;
+	region.dstOffset = offset;
+	region.size = copySize;
+	vkCmdCopyBuffer(commandBuffer, source->get(), pool.buffer.get(), 1, &region);
+
+	entries[source.get()] = PoolEntry{source, offset, source->getContentVersion()};
+	used = offset + copySize;
+
+	return static_cast<int64_t>(offset);
+}
+
+void VisibilityBuffer::computeBarrier(VkCommandBuffer commandBuffer,
+	VkPipelineStageFlags dstStage,
+	VkAccessFlags dstAccess) {
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = dstAccess;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		dstStage,
+		0,
+		1, &barrier,
+		0, nullptr,
+		0, nullptr);
+}
+
+void VisibilityBuffer::record(VkCommandBuffer commandBuffer,
+	const std::vector<Mesh::RenderData>& drawPackets,
+	VkDescriptorSet cameraSet,
+	VkDescriptorSet lightSet,
+	VkExtent2D renderExtent) {
+	this->handledDraws.assign(drawPackets.size(), 0);
+	this->handledPacketIndices.clear();
+	this->binMaterials.clear();
+	this->binByMaterial.clear();
+	this->drawCount = 0;
+
+	/// Start the pools over if they ran full last frame
+	if (this->poolResetPending) {
+		this->vertexPoolEntries.clear();
+		this->indexPoolEntries.clear();
+		this->vertexPoolUsed = 0;
+		this->indexPoolUsed = 0;
+		this->poolResetPending = false;
+		spdlog::debug("Visibility buffer geometry pools reset");
+	}
+
+	/// Build the draw table and copy new geometry into the pools
+	for (size_t i = 0; i < drawPackets.size(); ++i) {
+		const auto& data = drawPackets[i];
+		if (!data.vertexBuffer || !data.indexBuffer || !data.material
+			|| !isSupportedMaterial(*data.material)) {
+			continue;
+		}
+
+		/// The shading pass reads vertices as floats from the pool, quantized meshes are
+		/// drawn forward, where the vertex fetch dequantizes them
+		if (data.vertexFormat != VertexFormat::Standard) {
+			continue;
+		}
+
+		/// The pools hold one copy of each mesh per draw, instances stay forward
+		if (data.instanceBuffer) {
+			continue;
+		}
+
+		/// Skinned vertices change every frame and would be copied into the pools every frame
+		if (data.skinned) {
+			continue;
+		}
+
+		if (this->drawCount >= MaxDraws) {
+			break;
+		}
+
+		/// Vertex offsets are stored in vertices, so the pool offset must be a whole vertex
+		const int64_t vertexOffset = this->acquirePoolRange(commandBuffer,
+			data.vertexBuffer,
+			static_cast<VkDeviceSize>(data.vertexBuffer->getVertexCount()) * data.vertexBuffer->getStride(),
+			sizeof(Vertex),
+			this->vertexPool,
+			this->vertexPoolEntries,
+			this->vertexPoolUsed);
+		const int64_t indexOffset = this->acquirePoolRange(commandBuffer,
+			data.indexBuffer,
+			static_cast<VkDeviceSize>(data.indexBuffer->getIndexCount()) * sizeof(uint32_t),
+			sizeof(uint32_t),
+			this->indexPool,
+			this->indexPoolEntries,
+			this->indexPoolUsed);
+
+		if (vertexOffset < 0 || indexOffset < 0) {
+			/// Draw it forward this frame and compact the pools next frame
+			this->poolResetPending = true;
+			continue;
+		}
+
+		uint32_t bin;
+		auto binIt = this->binByMaterial.find(data.material.get());
+		if (binIt != this->binByMaterial.end()) {
+			bin = binIt->second;
+		} else if (this->binMaterials.size() < MaxMaterialBins) {
+			bin = static_cast<uint32_t>(this->binMaterials.size());
+			this->binByMaterial.emplace(data.material.get(), bin);
+			this->binMaterials.push_back(data.material.get());
+		} else {
+			continue;
+		}
+
+		DrawData& draw = this->mappedDrawTable[this->drawCount];
+		draw.model = data.modelMatrix;
+		draw.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(data.modelMatrix))));
+		draw.vertexOffset = static_cast<uint32_t>(vertexOffset / sizeof(Vertex));
+		draw.firstIndex = static_cast<uint32_t>(indexOffset / sizeof(uint32_t));
+		draw.materialBin = bin;
+		draw.padding = 0;
+
+		this->handledDraws[i] = 1;
+		this->handledPacketIndices.push_back(i);
+		++this->drawCount;
+	}
+
+	/// Clear the bin counters and make the copies visible to the compute passes
+	/// The shaded image gets its GENERAL layout here; its old content is never read
+	vkCmdFillBuffer(commandBuffer, this->binBuffer.buffer.get(), 0, VK_WHOLE_SIZE, 0);
+
+	VkMemoryBarrier transferBarrier{};
+	transferBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	transferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	transferBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	VkImageMemoryBarrier shadedBarrier{};
+	shadedBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	shadedBarrier.srcAccessMask = 0;
+	shadedBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	shadedBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	shadedBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	shadedBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	shadedBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	shadedBarrier.image = this->shadedTarget->getImage();
+	shadedBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		1, &transferBarrier,
+		0, nullptr,
+		1, &shadedBarrier);
+
+	/// Visibility pass
+	/// It always runs, even without draws, because it clears the depth the forward draws use
+	std::array<VkClearValue, 2> clearValues{};
+	clearValues[0].color.uint32[0] = 0;  /// No geometry
+	clearValues[0].color.uint32[1] = 0;
+	clearValues[1].depthStencil = {0.0f, 0};  /// Reverse-Z
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = this->visibilityRenderPass.get();
+	renderPassInfo.framebuffer = this->visibilityFramebuffer.get();
+	renderPassInfo.renderArea.offset = {0, 0};
+	renderPassInfo.renderArea.extent = renderExtent;
+	renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+	renderPassInfo.pClearValues = clearValues.data();
+
+	vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+	if (this->drawCount > 0) {
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(renderExtent.width);
+		viewport.height = static_cast<float>(renderExtent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor{};
+		scissor.offset = {0, 0};
+		scissor.extent = renderExtent;
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		vkCmdBindDescriptorSets(commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			this->rasterPipelineLayout.get(),
+			0, 1, &cameraSet,
+			0, nullptr);
+
+		VkPipeline boundPipeline = VK_NULL_HANDLE;
+		for (uint32_t drawIndex = 0; drawIndex < this->drawCount; ++drawIndex) {
+			const auto& data = drawPackets[this->handledPacketIndices[drawIndex]];
+
+			/// Only culling differs between materials here, so at most two pipelines are used
+			VkPipeline pipeline = data.material->hasFeature(MaterialFeatureFlags::DoubleSided)
+				? this->rasterPipelineDoubleSided.get()
+				: this->rasterPipeline.get();
+			if (pipeline != boundPipeline) {
+				vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+				boundPipeline = pipeline;
+			}
+
+			RasterPushConstants constants{};
+			constants.model = data.modelMatrix;
+			constants.drawIndex = drawIndex;
+			vkCmdPushConstants(commandBuffer,
+				this->rasterPipelineLayout.get(),
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+				0,
+				sizeof(RasterPushConstants),
+				&constants);
+
+			VkBuffer vertexBuffers[] = {data.vertexBuffer->get()};
+			VkDeviceSize offsets[] = {0};
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+			vkCmdBindIndexBuffer(commandBuffer, data.indexBuffer->get(), 0, VK_INDEX_TYPE_UINT32);
+
+			vkCmdDrawIndexed(commandBuffer, data.indexBuffer->getIndexCount(), 1, 0, 0, 0);
+		}
+	}
+
+	vkCmdEndRenderPass(commandBuffer);
+
+	if (this->drawCount == 0) {
+		return;
+	}
+
+	ComputePushConstants constants{};
+	constants.renderExtent = glm::uvec2(renderExtent.width, renderExtent.height);
+	constants.binIndex = 0;
+	constants.binCount = static_cast<uint32_t>(this->binMaterials.size());
+
+	const uint32_t groupsX = (renderExtent.width + PixelGroupSize - 1) / PixelGroupSize;
+	const uint32_t groupsY = (renderExtent.height + PixelGroupSize - 1) / PixelGroupSize;
+
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		this->computePipelineLayout.get(),
+		0, 1, &this->descriptorSet,
+		0, nullptr);
+	vkCmdPushConstants(commandBuffer,
+		this->computePipelineLayout.get(),
+		VK_SHADER_STAGE_COMPUTE_BIT,
+		0,
+		sizeof(ComputePushConstants),
+		&constants);
+
+	/// Count pixels per material bin
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->classifyPipeline.get());
+	vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+	computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+	/// Turn counts into offsets and dispatch sizes
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->prefixPipeline.get());
+	vkCmdDispatch(commandBuffer, 1, 1, 1);
+	computeBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+
+	/// Sort the pixels into their bins
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->scatterPipeline.get());
+	vkCmdDispatch(commandBuffer, groupsX, groupsY, 1);
+	computeBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+	/// Shade every bin with its material
+	/// The dispatch size comes from the GPU, so bins without visible pixels cost nothing
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, this->shadePipeline.get());
+
+	std::array<VkDescriptorSet, 2> globalSets = {cameraSet, lightSet};
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		this->shadePipelineLayout.get(),
+		0, static_cast<uint32_t>(globalSets.size()), globalSets.data(),
+		0, nullptr);
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_COMPUTE,
+		this->shadePipelineLayout.get(),
+		3, 1, &this->descriptorSet,
+		0, nullptr);
+
+	for (uint32_t bin = 0; bin < this->binMaterials.size(); ++bin) {
+		VkDescriptorSet materialSet = this->binMaterials[bin]->getDescriptorSet();
+		vkCmdBindDescriptorSets(commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			this->shadePipelineLayout.get(),
+			2, 1, &materialSet,
+			0, nullptr);
+
+		constants.binIndex = bin;
+		vkCmdPushConstants(commandBuffer,
+			this->shadePipelineLayout.get(),
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(ComputePushConstants),
+			&constants);
+
+		vkCmdDispatchIndirect(commandBuffer,
+			this->dispatchBuffer.buffer.get(),
+			bin * sizeof(VkDispatchIndirectCommand));
+	}
+
+	/// The composite render pass dependency makes the shaded image visible to its fragment shader
+}
+
+void VisibilityBuffer::recordComposite(VkCommandBuffer commandBuffer,
+	VkExtent2D renderExtent,
+	const VkClearColorValue& clearColor) const {
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, this->compositePipeline.get());
+
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(renderExtent.width);
+	viewport.height = static_cast<float>(renderExtent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+
+	VkRect2D scissor{};
+	scissor.offset = {0, 0};
+	scissor.extent = renderExtent;
+
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	vkCmdBindDescriptorSets(commandBuffer,
+		VK_PIPELINE_BIND_POINT_GRAPHICS,
+		this->compositePipelineLayout.get(),
+		0, 1, &this->descriptorSet,
+		0, nullptr);
+
+	const glm::vec4 color(clearColor.float32[0], clearColor.float32[1],
+		clearColor.float32[2], clearColor.float32[3]);
+	vkCmdPushConstants(commandBuffer,
+		this->compositePipelineLayout.get(),
+		VK_SHADER_STAGE_FRAGMENT_BIT,
+		0,
+		sizeof(glm::vec4),
+		&color);
+
+	/// One triangle covering the render area
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
+
+} /// namespace lillugsi::rendering
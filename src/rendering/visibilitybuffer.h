@@ -0,0 +1,289 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include "vulkan/buffer.h"
+#include "vulkan/colortarget.h"
+#include "mesh.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lillugsi::rendering {
+
+/// VisibilityBuffer is an alternative to drawing opaque PBR geometry forward
+/// Forward shading runs the full material shader for every fragment that passes the
+/// depth test, so overdraw multiplies the shading cost, and every material pipeline
+/// switch costs a bind. With a visibility buffer we split this up:
+/// 1. Rasterize only draw and triangle IDs into an R32G32_UINT target.
+///    Overdraw now only costs a depth test and an 8 byte write
+/// 2. Classify the visible pixels by material and build one pixel list per material bin
+/// 3. Shade each bin in a compute dispatch sized indirectly from the pixel count.
+///    Attributes are reconstructed from the triangle, with analytic derivatives for texturing
+/// 4. Composite the shaded image into the scene color target, keeping the depth
+///
+/// Every visible pixel is shaded exactly once, and all PBR materials share one
+/// compute pipeline; switching materials only rebinds the material descriptor set.
+///
+/// Only opaque materials using the standard PBR shaders take this path. Everything else
+/// (transparent, custom shaders, other material types) is drawn forward afterwards into the
+/// same render pass, which loads the depth of the visibility pass.
+///
+/// To reconstruct attributes, the compute shader needs the geometry of every draw
+/// in one place. We keep a geometry pool that vertex and index buffers are copied into
+/// on the GPU the first time they are drawn through this path
+class VisibilityBuffer {
+public:
+	static constexpr const char* VertexShaderPath = "shaders/visibility.vert.spv";
+	static constexpr const char* FragmentShaderPath = "shaders/visibility.frag.spv";
+	static constexpr const char* ClassifyShaderPath = "shaders/visclassify.comp.spv";
+	static constexpr const char* PrefixShaderPath = "shaders/visprefix.comp.spv";
+	static constexpr const char* ScatterShaderPath = "shaders/visscatter.comp.spv";
+	static constexpr const char* ShadeShaderPath = "shaders/visshade.comp.spv";
+	/// The composite draws the same fullscreen triangle as the upscale pass
+	static constexpr const char* CompositeVertexShaderPath = "shaders/upscale.vert.spv";
+	static constexpr const char* CompositeFragmentShaderPath = "shaders/viscomposite.frag.spv";
+
+	/// Draw and triangle ID per pixel
+	/// 32 bits each, so neither the draw count nor the triangle count of a mesh is a concern
+	static constexpr VkFormat VisibilityFormat = VK_FORMAT_R32G32_UINT;
+
+	/// Output of the shading pass, half floats are plenty before the composite
+	static constexpr VkFormat ShadedFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+	/// Limits per frame, draws and materials beyond these fall back to forward rendering
+	/// MaxMaterialBins must match visibilitycommon.glsl and the prefix pass workgroup size
+	static constexpr uint32_t MaxDraws = 16384;
+	static constexpr uint32_t MaxMaterialBins = 256;
+
+	/// Invocations per shading workgroup, matches visibilitycommon.glsl
+	static constexpr uint32_t ShadeGroupSize = 64;
+
+	/// Geometry pool sizes
+	static constexpr VkDeviceSize VertexPoolSize = 128ull * 1024 * 1024;
+	static constexpr VkDeviceSize IndexPoolSize = 64ull * 1024 * 1024;
+
+	/// Constructor
+	/// @param device The logical device to create resources on
+	/// @param physicalDevice The physical device for memory allocation
+	VisibilityBuffer(VkDevice device, VkPhysicalDevice physicalDevice);
+
+	/// Destructor
+	~VisibilityBuffer();
+
+	/// Create render passes, pipelines, descriptors and the fixed size buffers
+	/// @param sceneColorFormat Format of the scene color target the composite writes to
+	/// @param depthFormat Format of the shared depth buffer
+	/// @param cameraLayout Global camera descriptor set layout (set = 0)
+	/// @param lightLayout Global light descriptor set layout (set = 1)
+	void initialize(VkFormat sceneColorFormat,
+		VkFormat depthFormat,
+		VkDescriptorSetLayout cameraLayout,
+		VkDescriptorSetLayout lightLayout);
+
+	/// Create the size dependent targets
+	/// Must be called after initialize and whenever the depth buffer is recreated
+	/// @param width Width of the scene targets
+	/// @param height Height of the scene targets
+	/// @param depthImageView The shared depth buffer
+	void resize(uint32_t width, uint32_t height, VkImageView depthImageView);
+
+	/// Release all Vulkan resources
+	void cleanup();
+
+	/// Record the visibility, classification and shading passes
+	/// Decides per draw packet whether it goes through this path; query the result
+	/// with isDrawHandled when drawing the rest forward
+	/// @param commandBuffer The command buffer being recorded, outside of any render pass
+	/// @param drawPackets The frame's draw packets
+	/// @param cameraSet Camera descriptor set of this frame
+	/// @param lightSet Light descriptor set of this frame
+	/// @param renderExtent Part of the targets rendered this frame
+	void record(VkCommandBuffer commandBuffer,
+		const std::vector<Mesh::RenderData>& drawPackets,
+		VkDescriptorSet cameraSet,
+		VkDescriptorSet lightSet,
+		VkExtent2D renderExtent);
+
+	/// Write the shaded image into the scene color target
+	/// Must be recorded as the first draw inside the composite render pass
+	/// @param commandBuffer The command buffer being recorded
+	/// @param renderExtent Part of the targets rendered this frame
+	/// @param clearColor Color of pixels without visibility buffer geometry
+	void recordComposite(VkCommandBuffer commandBuffer,
+		VkExtent2D renderExtent,
+		const VkClearColorValue& clearColor) const;
+
+	/// Check if the last record call took care of a draw packet
+	/// @param drawPacketIndex Index into the draw packets passed to record
+	/// @return True if the packet must not be drawn forward
+	[[nodiscard]] bool isDrawHandled(size_t drawPacketIndex) const {
+		return drawPacketIndex < this->handledDraws.size() && this->handledDraws[drawPacketIndex] != 0;
+	}
+
+	/// Get the render pass the scene continues in after the visibility passes
+	/// It is compatible with the scene render pass but loads depth instead of clearing it,
+	/// so the offscreen framebuffer and all forward pipelines can be used with it
+	/// @return The composite render pass
+	[[nodiscard]] VkRenderPass getCompositeRenderPass() const { return this->compositeRenderPass.get(); }
+
+	/// Get the number of draws shaded through the visibility buffer in the last frame
+	[[nodiscard]] uint32_t getDrawCount() const { return this->drawCount; }
+
+	/// Get the number of material bins used in the last frame
+	[[nodiscard]] uint32_t getBinCount() const { return static_cast<uint32_t>(this->binMaterials.size()); }
+
+private:
+	/// Per draw data for the compute passes
+	/// Layout matches DrawData in visibilitycommon.glsl (std430)
+	struct DrawData {
+		glm::mat4 model;
+		glm::mat4 normalMatrix;
+		uint32_t vertexOffset;
+		uint32_t firstIndex;
+		uint32_t materialBin;
+		uint32_t padding;
+	};
+
+	/// Per bin counters, matches BinData in visibilitycommon.glsl
+	struct BinData {
+		uint32_t count;
+		uint32_t offset;
+		uint32_t cursor;
+		uint32_t padding;
+	};
+
+	/// Push constants of the visibility raster pass
+	/// Layout matches the PushConstants block in visibility.glsl.vert/frag
+	struct RasterPushConstants {
+		glm::mat4 model;
+		uint32_t drawIndex;
+		uint32_t padding[3];
+	};
+
+	/// Push constants of the compute passes, matches visibilitycommon.glsl
+	struct ComputePushConstants {
+		glm::uvec2 renderExtent;
+		uint32_t binIndex;
+		uint32_t binCount;
+	};
+
+	/// A buffer copied into one of the geometry pools
+	/// We hold a weak reference to notice when the source is released and its
+	/// address gets reused by a different buffer, and its content version to notice
+	/// when it was changed in place
+	struct PoolEntry {
+		std::weak_ptr<vulkan::Buffer> source;
+		VkDeviceSize offset;
+		uint64_t contentVersion;
+	};
+
+	/// A device buffer together with its memory
+	/// Memory is declared first so the buffer is destroyed before its memory is freed
+	struct DeviceBuffer {
+		vulkan::VulkanDeviceMemoryHandle memory;
+		vulkan::VulkanBufferHandle buffer;
+		VkDeviceSize size{0};
+	};
+
+	void createRenderPasses(VkFormat sceneColorFormat, VkFormat depthFormat);
+	void createDescriptorResources();
+	void createMaterialDescriptorLayout();
+	void createPipelines(VkDescriptorSetLayout cameraLayout, VkDescriptorSetLayout lightLayout);
+	void createFixedBuffers();
+	void updateDescriptorSet();
+
+	/// Create a buffer with its own memory allocation
+	[[nodiscard]] DeviceBuffer createBuffer(VkDeviceSize size,
+		VkBufferUsageFlags usage,
+		VkMemoryPropertyFlags properties) const;
+
+	/// Create a compute pipeline from a SPIR-V file
+	[[nodiscard]] vulkan::VulkanPipelineHandle createComputePipeline(
+		const char* shaderPath, VkPipelineLayout layout) const;
+
+	/// Find or copy a buffer into a geometry pool
+	/// @param commandBuffer Command buffer to record the copy into
+	/// @param source Buffer the draw uses
+	/// @param copySize Number of bytes in use in the source
+	/// @param alignment Alignment of the pool offset
+	/// @param pool Pool buffer to copy into
+	/// @param entries Pool entries by source buffer
+	/// @param used Bytes used in the pool so far
+	/// @return Byte offset in the pool, or -1 if the pool is full
+	[[nodiscard]] int64_t acquirePoolRange(VkCommandBuffer commandBuffer,
+		const std::shared_ptr<vulkan::Buffer>& source,
+		VkDeviceSize copySize,
+		VkDeviceSize alignment,
+		const DeviceBuffer& pool,
+		std::unordered_map<const vulkan::Buffer*, PoolEntry>& entries,
+		VkDeviceSize& used);
+
+	/// Check if a material can be shaded by the visibility buffer shading pass
+	[[nodiscard]] static bool isSupportedMaterial(const Material& material);
+
+	/// Record a barrier between two compute dispatches
+	static void computeBarrier(VkCommandBuffer commandBuffer,
+		VkPipelineStageFlags dstStage,
+		VkAccessFlags dstAccess);
+
+	VkDevice device;
+	VkPhysicalDevice physicalDevice;
+
+	/// Render passes
+	vulkan::VulkanRenderPassHandle visibilityRenderPass;  /// IDs and depth, both cleared
+	vulkan::VulkanRenderPassHandle compositeRenderPass;   /// Scene color and loaded depth
+
+	/// Size dependent targets
+	std::unique_ptr<vulkan::ColorTarget> visibilityTarget;
+	std::unique_ptr<vulkan::ColorTarget> shadedTarget;
+	vulkan::VulkanFramebufferHandle visibilityFramebuffer;
+	DeviceBuffer pixelListBuffer;
+
+	/// Descriptors
+	vulkan::VulkanDescriptorSetLayoutHandle descriptorSetLayout;
+	vulkan::VulkanDescriptorSetLayoutHandle materialDescriptorLayout;  /// Identical to the PBR material layout
+	vulkan::VulkanDescriptorPoolHandle descriptorPool;
+	VkDescriptorSet descriptorSet{VK_NULL_HANDLE};
+
+	/// Pipelines
+	vulkan::VulkanPipelineLayoutHandle rasterPipelineLayout;
+	vulkan::VulkanPipelineHandle rasterPipeline;            /// Back face culling
+	vulkan::VulkanPipelineHandle rasterPipelineDoubleSided; /// No culling
+	vulkan::VulkanPipelineLayoutHandle computePipelineLayout;
+	vulkan::VulkanPipelineHandle classifyPipeline;
+	vulkan::VulkanPipelineHandle prefixPipeline;
+	vulkan::VulkanPipelineHandle scatterPipeline;
+	vulkan::VulkanPipelineLayoutHandle shadePipelineLayout;
+	vulkan::VulkanPipelineHandle shadePipeline;
+	vulkan::VulkanPipelineLayoutHandle compositePipelineLayout;
+	vulkan::VulkanPipelineHandle compositePipeline;
+
+	/// Fixed size buffers
+	DeviceBuffer drawTableBuffer;  /// Host visible, persistently mapped
+	DrawData* mappedDrawTable{nullptr};
+	DeviceBuffer binBuffer;
+	DeviceBuffer dispatchBuffer;
+	DeviceBuffer vertexPool;
+	DeviceBuffer indexPool;
+
+	/// Geometry pool bookkeeping
+	/// Pools only grow; once full we start over in the next frame and copy
+	/// what is still drawn, which drops buffers that were released in between
+	std::unordered_map<const vulkan::Buffer*, PoolEntry> vertexPoolEntries;
+	std::unordered_map<const vulkan::Buffer*, PoolEntry> indexPoolEntries;
+	VkDeviceSize vertexPoolUsed{0};
+	VkDeviceSize indexPoolUsed{0};
+	bool poolResetPending{false};
+
+	/// Per frame state of the last record call
+	std::vector<uint8_t> handledDraws;
+	std::vector<size_t> handledPacketIndices;  /// Draw packet of each draw table entry
+	std::vector<const Material*> binMaterials;
+	std::unordered_map<const Material*, uint32_t> binByMaterial;
+	uint32_t drawCount{0};
+};
+
+} /// namespace lillugsi::rendering
@@ -155,6 +155,15 @@ void Scene::getRenderData(const rendering::Camera& camera,
 	spdlog::trace("Collected render data for {} visible objects", outRenderData.size());
 }
 
+void Scene::getShadowCasters(const Frustum& volume,
+	std::vector<rendering::ShadowCaster>& outCasters) const {
+	/// Keeps the capacity from earlier frames, like getRenderData
+	outCasters.clear();
+	this->root->getShadowCasters(volume, outCasters);
+
+	spdlog::trace("Collected {} shadow casters", outCasters.size());
+}
+
 Frustum Scene::createFrustumFromCamera(const rendering::Camera& camera) const {
 	/// Create view-projection matrix
 	glm::mat4 projection = camera.getProjectionMatrix(
@@ -43,6 +43,12 @@ public:
 	void getRenderData(const rendering::Camera& camera,
 		std::vector<rendering::Mesh::RenderData>& outRenderData) const;
 
+	/// Get shadow casters for a light
+	/// @param volume Volume the light sweeps through on its way into the view
+	/// @param outCasters Vector to store the casters, cleared first
+	void getShadowCasters(const Frustum& volume,
+		std::vector<rendering::ShadowCaster>& outCasters) const;
+
 	/// Get the root node of the scene
 	/// @return Shared pointer to the root node
 	std::shared_ptr<SceneNode> getRoot() const { return this->root; }
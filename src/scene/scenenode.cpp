@@ -5,6 +5,8 @@
 
 namespace lillugsi::scene {
 
+std::atomic<uint64_t> SceneNode::staticRevision{0};
+
 SceneNode::SceneNode(const std::string& name)
 	: name(name)
 	, localTransform()  /// Initialize with identity transform
@@ -42,6 +44,10 @@ void SceneNode::addChild(std::shared_ptr<SceneNode> child) {
 	/// Mark bounds as dirty since adding a child affects the combined bounds
 	this->boundsDirty = true;
 
+	if (child->containsStatic()) {
+		++staticRevision;
+	}
+
 	spdlog::debug("Added child '{}' to SceneNode '{}'", child->name, this->name);
 }
 
@@ -52,6 +58,10 @@ void SceneNode::removeChild(const std::shared_ptr<SceneNode>& child) {
 		/// Clear the parent relationship
 		(*it)->parent.reset();
 
+		if ((*it)->containsStatic()) {
+			++staticRevision;
+		}
+
 		/// Remove from children vector
 		this->children.erase(it);
 
@@ -69,10 +79,30 @@ void SceneNode::removeChild(const std::shared_ptr<SceneNode>& child) {
 void SceneNode::setMesh(std::shared_ptr<rendering::Mesh> mesh) {
 	this->mesh = mesh;
 	this->boundsDirty = true;  /// Mark bounds as dirty
+	if (this->staticNode) {
+		++staticRevision;
+	}
 	this->updateBounds();      /// Update bounds immediately
 	spdlog::debug("Set mesh for SceneNode '{}'", this->name);
 }
 
+void SceneNode::setInstances(std::shared_ptr<const rendering::MeshInstances> instances) {
+	this->instances = std::move(instances);
+	this->boundsDirty = true;
+	if (this->staticNode) {
+		++staticRevision;
+	}
+	this->updateBounds();
+	spdlog::debug("Set {} instances for SceneNode '{}'",
+		this->instances ? this->instances->getCount() : 0, this->name);
+}
+
+void SceneNode::setPendingBounds(const BoundingBox& bounds) {
+	this->pendingBounds = bounds;
+	this->boundsDirty = true;
+	this->updateBounds();
+}
+
 void SceneNode::setLocalTransform(const Transform& transform) {
 	this->localTransform = transform;
 	this->markTransformDirty();
@@ -148,12 +178,34 @@ void SceneNode::getRenderData(const Frustum& frustum,
 	}
 
 	/// If we have a mesh, add its render data
-	if (this->mesh) {
+	if (this->mesh && this->instances) {
+		rendering::Mesh::RenderData data;
+		this->mesh->prepareRenderData(data);
+		data.modelMatrix = this->worldTransform;
+		data.instanceBuffer = this->instances->getBuffer();
+
+		/// One packet per run of visible instances, each drawn with one instanced draw
+		std::vector<rendering::MeshInstances::Range> ranges;
+		this->instances->cull(frustum, this->worldTransform, ranges);
+		for (const auto& range : ranges) {
+			rendering::Mesh::RenderData packet = data;
+			packet.firstInstance = range.first;
+			packet.instanceCount = range.count;
+			packet.boundsCenter = range.bounds.getCenter();
+			packet.boundsRadius = glm::length(range.bounds.getSize()) * 0.5f;
+			outRenderData.push_back(std::move(packet));
+		}
+	} else if (this->mesh) {
 		rendering::Mesh::RenderData data;
 		this->mesh->prepareRenderData(data);
 		/// Use the node's world transform for the model matrix
 		/// This matrix will be passed via push constants for efficient updates
 		data.modelMatrix = this->worldTransform;
+		if (this->meshBounds.isValid()) {
+			const BoundingBox bounds = this->meshBounds.transform(this->worldTransform);
+			data.boundsCenter = bounds.getCenter();
+			data.boundsRadius = glm::length(bounds.getSize()) * 0.5f;
+		}
 		outRenderData.push_back(std::move(data));
 
 		/// Log transform data for debugging
@@ -171,20 +223,76 @@ void SceneNode::getRenderData(const Frustum& frustum,
 	}
 }
 
+void SceneNode::getShadowCasters(const Frustum& volume,
+	std::vector<rendering::ShadowCaster>& outCasters) const {
+	if (!this->isVisible(volume)) {
+		return;
+	}
+
+	if (this->mesh && this->instances) {
+		rendering::ShadowCaster caster;
+		this->mesh->prepareRenderData(caster.data);
+		caster.data.modelMatrix = this->worldTransform;
+		caster.data.instanceBuffer = this->instances->getBuffer();
+
+		/// Skinned meshes move without their node moving, cached cascades can't keep them
+		caster.isStatic = this->staticNode && !caster.data.skinned;
+
+		/// Instances outside the view still cast into it, so they are culled against the volume
+		std::vector<rendering::MeshInstances::Range> ranges;
+		this->instances->cull(volume, this->worldTransform, ranges);
+		for (const auto& range : ranges) {
+			rendering::ShadowCaster rangeCaster = caster;
+			rangeCaster.data.firstInstance = range.first;
+			rangeCaster.data.instanceCount = range.count;
+			rangeCaster.boundsMin = range.bounds.getMin();
+			rangeCaster.boundsMax = range.bounds.getMax();
+			outCasters.push_back(std::move(rangeCaster));
+		}
+	} else if (this->mesh && this->meshBounds.isValid()) {
+		rendering::ShadowCaster caster;
+		this->mesh->prepareRenderData(caster.data);
+		caster.data.modelMatrix = this->worldTransform;
+
+		/// World bounds include the children, so we rebuild the mesh's own bounds
+		/// Cascades cull casters with these, tighter bounds mean fewer shadow draws
+		const BoundingBox meshBounds = this->meshBounds.transform(this->worldTransform);
+		caster.boundsMin = meshBounds.getMin();
+		caster.boundsMax = meshBounds.getMax();
+
+		/// Skinned meshes move without their node moving, cached cascades can't keep them
+		caster.isStatic = this->staticNode && !caster.data.skinned;
+		outCasters.push_back(std::move(caster));
+	}
+
+	for (const auto& child : this->children) {
+		child->getShadowCasters(volume, outCasters);
+	}
+}
+
 void SceneNode::updateBounds() {
 	/// Start with an empty bounding box
 	this->localBounds.reset();
 
 	/// Add mesh bounds if we have a mesh
-	if (this->mesh) {
-		/// For now, we'll compute a simple bounds from vertices
-		/// This could be optimized by caching bounds in the Mesh class
-		const auto& vertices = this->mesh->getVertices();
-		for (const auto& vertex : vertices) {
-			this->localBounds.addPoint(vertex.position);
-		}
+	/// The mesh knows its bounds even after releasing its vertices
+	const auto bounds = this->mesh ? this->mesh->getBounds() : std::nullopt;
+	if (this->instances && this->instances->getBounds().isValid()) {
+		/// Instanced meshes cover the area of all their instances
+		this->localBounds.addPoint(this->instances->getBounds().getMin());
+		this->localBounds.addPoint(this->instances->getBounds().getMax());
+	} else if (bounds) {
+		this->localBounds.addPoint(bounds->min);
+		this->localBounds.addPoint(bounds->max);
+	} else if (this->pendingBounds.isValid()) {
+		/// The mesh is still loading, its expected bounds keep the node in view
+		this->localBounds.addPoint(this->pendingBounds.getMin());
+		this->localBounds.addPoint(this->pendingBounds.getMax());
 	}
 
+	/// Keep the mesh's own bounds for shadow caster culling
+	this->meshBounds = this->localBounds;
+
 	/// Add transformed bounds of all children
 	for (const auto& child : this->children) {
 		/// Ensure child bounds are up to date
@@ -216,10 +324,43 @@ void SceneNode::updateBoundsIfNeeded() {
 	}
 }
 
+void SceneNode::refreshBounds() {
+	auto current = shared_from_this();
+	while (current) {
+		current->updateBounds();
+		current = current->getParent().lock();
+	}
+}
+
+void SceneNode::setStatic(bool isStatic) {
+	if (this->staticNode != isStatic) {
+		this->staticNode = isStatic;
+		++staticRevision;
+	}
+
+	/// A moving child under a static parent makes little sense, so the flag covers the subtree
+	for (const auto& child : this->children) {
+		child->setStatic(isStatic);
+	}
+}
+
+bool SceneNode::containsStatic() const {
+	if (this->staticNode) {
+		return true;
+	}
+	return std::any_of(this->children.begin(), this->children.end(),
+		[](const std::shared_ptr<SceneNode>& child) { return child->containsStatic(); });
+}
+
 void SceneNode::markTransformDirty() {
 	this->transformDirty = true;
 	this->boundsDirty = true;  /// Transform changes affect world bounds
 
+	/// Moving static geometry invalidates everything cached from it
+	if (this->staticNode) {
+		++staticRevision;
+	}
+
 	/// Recursively mark all children as dirty
 	/// Children's world transforms depend on our transform
 	for (const auto& child : this->children) {
@@ -1,9 +1,11 @@
 #pragma once
 
 #include "rendering/mesh.h"
+#include "rendering/meshinstances.h"
 #include "scene/boundingbox.h"
 #include "scene/scenetypes.h"
 #include "scene/frustum.h"
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -41,6 +43,29 @@ public:
 	/// @param mesh The mesh to associate with this node
 	void setMesh(std::shared_ptr<rendering::Mesh> mesh);
 
+	/// Draw the node's mesh once per instance
+	/// Instances replace per-copy nodes for meshes repeated many times. The node's
+	/// bounds enclose all instances, culling tests them in clusters
+	/// @param instances Instances placed relative to the node, nullptr to draw the mesh once
+	void setInstances(std::shared_ptr<const rendering::MeshInstances> instances);
+
+	/// Get the instances of the node's mesh
+	/// @return The instances, or nullptr if the mesh is drawn once
+	[[nodiscard]] const std::shared_ptr<const rendering::MeshInstances>& getInstances() const {
+		return this->instances;
+	}
+
+	/// Set bounds for a mesh that isn't loaded yet
+	/// Progressively loaded models know the extent of their meshes before the geometry
+	/// arrives, so culling and framing the camera work from the first frame.
+	/// A mesh with bounds takes precedence once it is set
+	/// @param bounds Expected bounds of the mesh in local space
+	void setPendingBounds(const BoundingBox& bounds);
+
+	/// Get the bounds of the mesh this node is waiting for
+	/// @return The pending bounds, invalid if the node doesn't wait for a mesh
+	[[nodiscard]] const BoundingBox& getPendingBounds() const { return this->pendingBounds; }
+
 	/// Set the local transform for this node
 	/// @param transform The new local transform
 	/// This triggers an update of world transforms for this node and its children
@@ -89,10 +114,36 @@ public:
 	void getRenderData(const Frustum& frustum,
 		std::vector<rendering::Mesh::RenderData>& outRenderData) const;
 
+	/// Get shadow casters for this node and its children
+	/// @param volume The volume that can cast shadows into the view
+	/// @param outCasters Vector to store the casters
+	void getShadowCasters(const Frustum& volume,
+		std::vector<rendering::ShadowCaster>& outCasters) const;
+
+	/// Mark this node and its current children as static
+	/// Static nodes are not expected to move, so the renderer caches their shadows
+	/// and only renders them again when the static set changes
+	/// @param isStatic True if the meshes of the subtree don't move
+	void setStatic(bool isStatic);
+
+	/// Check if this node is static
+	/// @return True if the node was marked as static
+	[[nodiscard]] bool isStatic() const { return this->staticNode; }
+
+	/// Get the revision of the static geometry
+	/// The revision changes whenever a static node is added, removed, moved or gets a
+	/// different mesh, so cached data derived from static geometry can be validated cheaply
+	/// @return Revision counter shared by all nodes
+	[[nodiscard]] static uint64_t getStaticRevision() { return staticRevision.load(); }
+
 	/// Update bounds if they are marked as dirty
 	/// @return true if bounds were updated
 	void updateBoundsIfNeeded();
 
+	/// Recompute the bounds of this node and its ancestors
+	/// Needed when the mesh's bounds change while the node keeps the mesh
+	void refreshBounds();
+
 private:
 	std::string name;                   /// Node identifier
 	Transform localTransform;           /// Transform relative to parent
@@ -100,8 +151,11 @@ private:
 	std::weak_ptr<SceneNode> parent;   /// Parent node (weak to avoid cycles)
 	std::vector<std::shared_ptr<SceneNode>> children;  /// Child nodes
 	std::shared_ptr<rendering::Mesh> mesh;  /// Associated mesh
+	std::shared_ptr<const rendering::MeshInstances> instances;  /// Copies of the mesh, if instanced
 	BoundingBox localBounds;           /// Bounds in local space
 	BoundingBox worldBounds;           /// Bounds in world space
+	BoundingBox meshBounds;            /// Bounds of the node's own mesh in local space
+	BoundingBox pendingBounds;         /// Expected bounds of a mesh still loading
 	bool transformDirty;               /// Flag for transform updates
 
 	/// Mark this node's transform as dirty
@@ -112,6 +166,15 @@ private:
 	/// This combines mesh bounds with child bounds
 	void updateBounds();
 	bool boundsDirty;                  /// Flag for bounds updates
+
+	/// Check if this node or any descendant is static
+	[[nodiscard]] bool containsStatic() const;
+
+	bool staticNode{false};            /// Mesh doesn't move, see setStatic
+
+	/// Bumped on every change to static geometry
+	/// A single counter keeps the check cheap and needs no link from nodes to their scene
+	static std::atomic<uint64_t> staticRevision;
 };
 
 } /// namespace lillugsi::scene
\ No newline at end of file
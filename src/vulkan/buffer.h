@@ -62,6 +62,15 @@ public:
 	/// @return The Vulkan buffer usage flags
 	VkBufferUsageFlags getUsage() const { return this->usage; }
 
+	/// Get the number of in-place content changes recorded so far
+	/// Copies of the buffer compare it to notice they are out of date
+	/// @return The content version, 0 until the buffer is changed in place
+	uint64_t getContentVersion() const { return this->contentVersion; }
+
+	/// Note that a change of the buffer's contents has been recorded
+	/// Called on the render thread together with the recording of the change
+	void markContentChanged() { ++this->contentVersion; }
+
 	/// Map the buffer memory for CPU access
 	/// @param offset Offset into the buffer memory
 	/// @param size Size of the region to map
@@ -119,6 +128,9 @@ protected:
 	/// Buffer usage flags
 	/// Defines how the buffer can be used in the pipeline
 	VkBufferUsageFlags usage;
+
+	/// Incremented with every in-place content change, see markContentChanged
+	uint64_t contentVersion{0};
 };
 
 } /// namespace lillugsi::vulkan
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "colortarget.h"
+#include "vulkan/vulkanutils.h"
+#include "vulkan/vulkanformatters.h"
+#include <spdlog/spdlog.h>
+
+namespace lillugsi::vulkan {
+
+ColorTarget::ColorTarget(VkDevice device, VkPhysicalDevice physicalDevice)
+	: device(device)
+	, physicalDevice(physicalDevice)
+	, format(VK_FORMAT_UNDEFINED)
+	, extent{0, 0} {
+}
+
+ColorTarget::~ColorTarget() {
+	this->cleanup();
+}
+
+void ColorTarget::cleanup() {
+	/// The view must go before the image, and the image before its memory
+	this->imageView.reset();
+	this->image.reset();
+	this->imageMemory.reset();
+}
+
+void ColorTarget::initialize(uint32_t width, uint32_t height, VkFormat format,
+	VkImageUsageFlags additionalUsage) {
+	this->cleanup();
+
+	this->format = format;
+	this->extent = {width, height};
+
+	/// The image is written as a color attachment by the scene pass
+	/// and read by the upscale pass through a sampler.
+	/// Targets written or read by compute shaders add storage usage on top
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width = width;
+	imageInfo.extent.height = height;
+	imageInfo.extent.depth = 1;
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.format = format;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | additionalUsage;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	VkImage colorImage;
+	VK_CHECK(vkCreateImage(this->device, &imageInfo, nullptr, &colorImage));
+
+	this->image = vulkan::VulkanImageHandle(colorImage, [this](VkImage image) {
+		vkDestroyImage(this->device, image, nullptr);
+	});
+
+	/// Allocate device local memory, the CPU never touches this image
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(this->device, this->image.get(), &memRequirements);
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memRequirements.size;
+	allocInfo.memoryTypeIndex = utils::findMemoryType(
+		this->physicalDevice, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	VkDeviceMemory colorImageMemory;
+	VK_CHECK(vkAllocateMemory(this->device, &allocInfo, nullptr, &colorImageMemory));
+
+	this->imageMemory = vulkan::VulkanDeviceMemoryHandle(colorImageMemory, [this](VkDeviceMemory memory) {
+		vkFreeMemory(this->device, memory, nullptr);
+	});
+
+	VK_CHECK(vkBindImageMemory(this->device, this->image.get(), this->imageMemory.get(), 0));
+
+	/// One view serves both as attachment and as sampled image
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = this->image.get();
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel = 0;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.baseArrayLayer = 0;
+	viewInfo.subresourceRange.layerCount = 1;
+
+	VkImageView colorImageView;
+	VK_CHECK(vkCreateImageView(this->device, &viewInfo, nullptr, &colorImageView));
+
+	this->imageView = vulkan::VulkanImageViewHandle(colorImageView, [this](VkImageView view) {
+		vkDestroyImageView(this->device, view, nullptr);
+	});
+
+	spdlog::info("Color target {}x{} with format {} created", width, height, format);
+}
+
+} /// namespace lillugsi::vulkan
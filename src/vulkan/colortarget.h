@@ -0,0 +1,61 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include <vulkan/vulkan.h>
+
+namespace lillugsi::vulkan {
+
+/// ColorTarget is an offscreen color image that can be rendered to and sampled afterwards
+/// We use it to render the scene at a lower resolution than the swap chain,
+/// so a later pass can upscale it into the swap chain image.
+/// The image is allocated at the maximum size we render at; smaller resolutions
+/// only use its top-left part, so changing the scale never reallocates
+class ColorTarget {
+public:
+	/// Constructor
+	/// @param device The logical device used for creating Vulkan resources
+	/// @param physicalDevice The physical device used for memory allocation
+	ColorTarget(VkDevice device, VkPhysicalDevice physicalDevice);
+
+	/// Destructor
+	~ColorTarget();
+
+	/// Create the image, its memory and view
+	/// Calling this again replaces the previous image, e.g. after a resize
+	/// @param width The width of the color target
+	/// @param height The height of the color target
+	/// @param format The color format, usually the swap chain format so pipelines stay compatible
+	/// @param additionalUsage Usage on top of color attachment and sampling, e.g. storage for compute passes
+	void initialize(uint32_t width, uint32_t height, VkFormat format,
+		VkImageUsageFlags additionalUsage = 0);
+
+	/// Get the image of the color target
+	/// @return The image handle
+	[[nodiscard]] VkImage getImage() const { return this->image.get(); }
+
+	/// Get the image view of the color target
+	/// @return The image view handle
+	[[nodiscard]] VkImageView getImageView() const { return this->imageView.get(); }
+
+	/// Get the format of the color target
+	/// @return The color format
+	[[nodiscard]] VkFormat getFormat() const { return this->format; }
+
+	/// Get the full allocated size of the color target
+	/// @return The extent of the image
+	[[nodiscard]] VkExtent2D getExtent() const { return this->extent; }
+
+private:
+	VkDevice device;
+	VkPhysicalDevice physicalDevice;
+	VkFormat format;
+	VkExtent2D extent;
+	vulkan::VulkanImageHandle image;
+	vulkan::VulkanDeviceMemoryHandle imageMemory;
+	vulkan::VulkanImageViewHandle imageView;
+
+	void cleanup();
+};
+
+} /// namespace lillugsi::vulkan
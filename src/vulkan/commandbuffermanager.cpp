@@ -48,6 +48,14 @@ void CommandBufferManager::cleanup() {
 	}
 	this->allocatedCommandBuffers.clear();
 	this->poolIndices.clear();
+	this->poolInfos.clear();
+
+	/// One-time command buffers are freed after each submission, only the pools remain
+	{
+		std::lock_guard<std::mutex> lock(this->threadPoolMutex);
+		this->threadPools.clear();
+		this->threadPoolHandles.clear();
+	}
 
 	/// Command pools are automatically destroyed by their RAII handles
 	/// We just need to clear the vector to trigger destruction
@@ -93,6 +101,7 @@ VkCommandPool CommandBufferManager::createCommandPool(
 	/// We use the index in our vector to reference this pool later
 	this->commandPools.push_back(std::move(poolHandle));
 	this->poolIndices[commandPool] = this->commandPools.size() - 1;
+	this->poolInfos[commandPool] = PoolInfo{queueFamilyIndex, flags};
 
 	/// Initialize the tracking entry for this pool's command buffers
 	this->allocatedCommandBuffers[commandPool] = {};
@@ -163,7 +172,7 @@ VkCommandBuffer CommandBufferManager::beginSingleTimeCommands(
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandPool = commandPool;
+	allocInfo.commandPool = this->getThreadPool(commandPool);
 	allocInfo.commandBufferCount = 1;
 
 	VkCommandBuffer commandBuffer;
@@ -216,12 +225,46 @@ void CommandBufferManager::endSingleTimeCommands(
 	VK_CHECK(vkCreateFence(this->device, &fenceInfo, nullptr, &fence));
 
 	/// Submit and wait for completion
-	VK_CHECK(vkQueueSubmit(queue, 1, &submitInfo, fence));
+	/// The queue lock is only held for the submission itself
+	{
+		auto queueLock = this->lockQueue();
+		VK_CHECK(vkQueueSubmit(queue, 1, &submitInfo, fence));
+	}
 	VK_CHECK(vkWaitForFences(this->device, 1, &fence, VK_TRUE, UINT64_MAX));
 
 	/// Clean up resources
 	vkDestroyFence(this->device, fence, nullptr);
-	vkFreeCommandBuffers(this->device, commandPool, 1, &commandBuffer);
+	vkFreeCommandBuffers(this->device, this->getThreadPool(commandPool), 1, &commandBuffer);
+}
+
+VkCommandPool CommandBufferManager::getThreadPool(VkCommandPool commandPool) {
+	std::lock_guard<std::mutex> lock(this->threadPoolMutex);
+
+	auto& pools = this->threadPools[commandPool];
+	const auto it = pools.find(std::this_thread::get_id());
+	if (it != pools.end()) {
+		return it->second;
+	}
+
+	/// Only ever used for one-time commands, so always transient
+	const PoolInfo& info = this->poolInfos.at(commandPool);
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = info.queueFamilyIndex;
+	poolInfo.flags = info.flags | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	VkCommandPool threadPool;
+	VK_CHECK(vkCreateCommandPool(this->device, &poolInfo, nullptr, &threadPool));
+	this->threadPoolHandles.push_back(VulkanCommandPoolHandle(
+		threadPool,
+		[this](VkCommandPool pool) {
+			vkDestroyCommandPool(this->device, pool, nullptr);
+		}));
+	pools.emplace(std::this_thread::get_id(), threadPool);
+
+	spdlog::debug("Created one-time command pool {} for pool {} on a new thread",
+		(void*)threadPool, (void*)commandPool);
+	return threadPool;
 }
 
 void CommandBufferManager::resetCommandPool(
@@ -2,6 +2,8 @@
 
 #include "vulkan/vulkanwrappers.h"
 #include "vulkan/vulkanexception.h"
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <unordered_map>
 
@@ -59,8 +61,11 @@ public:
 		VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
 	/// Begin a command buffer for one-time submission
-	/// This is useful for transfer operations and other short-lived commands
-	/// @param commandPool The pool to allocate the temporary command buffer from
+	/// This is useful for transfer operations and other short-lived commands.
+	/// The buffer comes from a transient pool the calling thread has for the given pool,
+	/// so uploads from the update, render and loader threads never share a pool.
+	/// End it on the same thread
+	/// @param commandPool The pool the temporary command buffer is recorded for
 	/// @return Command buffer ready for recording
 	[[nodiscard]] VkCommandBuffer beginSingleTimeCommands(
 		VkCommandPool commandPool);
@@ -94,6 +99,15 @@ public:
 	/// @return True if initialized, false otherwise
 	[[nodiscard]] bool isInitialized() const { return this->initialized; }
 
+	/// Lock queue access for a submission or present
+	/// Vulkan requires external synchronization of VkQueue, and we submit from
+	/// both the render thread and the update/loader threads (one-time transfers).
+	/// Everyone submitting to the graphics queue goes through this lock
+	/// @return Lock that releases queue access when destroyed
+	[[nodiscard]] std::unique_lock<std::mutex> lockQueue() {
+		return std::unique_lock<std::mutex>(this->queueMutex);
+	}
+
 private:
 	/// The logical device used for command buffer operations
 	VkDevice device;
@@ -113,6 +127,30 @@ private:
 	/// This helps with proper cleanup and validation
 	std::unordered_map<VkCommandPool, std::vector<VkCommandBuffer>> allocatedCommandBuffers;
 
+	/// Serializes queue submissions across threads
+	std::mutex queueMutex;
+
+	/// Queue family and flags of the pools we created, to create thread pools like them
+	struct PoolInfo {
+		uint32_t queueFamilyIndex;
+		VkCommandPoolCreateFlags flags;
+	};
+	std::unordered_map<VkCommandPool, PoolInfo> poolInfos;
+
+	/// Pools of one-time commands, per pool and thread
+	/// Allocating, recording and freeing all need the pool externally synchronized.
+	/// A pool per thread needs no lock held while recording, and a thread id is never
+	/// shared by two live threads. Pools of ended threads stay until cleanup, or until
+	/// a new thread gets the same id and takes them over
+	std::unordered_map<VkCommandPool, std::unordered_map<std::thread::id, VkCommandPool>> threadPools;
+	std::vector<VulkanCommandPoolHandle> threadPoolHandles;
+	std::mutex threadPoolMutex;
+
+	/// Get the calling thread's pool for one-time commands of a pool, creating it on first use
+	/// @param commandPool A pool created by this manager
+	/// @return The thread's pool, with the same queue family
+	[[nodiscard]] VkCommandPool getThreadPool(VkCommandPool commandPool);
+
 	/// Validate that a command pool was created by this manager
 	/// @param commandPool The command pool to check
 	/// @throws VulkanException if the pool was not created by this manager
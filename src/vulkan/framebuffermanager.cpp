@@ -1,5 +1,6 @@
 #include "framebuffermanager.h"
 #include <spdlog/spdlog.h>
+#include <array>
 
 namespace lillugsi::vulkan {
 
@@ -35,6 +36,7 @@ void FramebufferManager::cleanup() {
 	/// This triggers the destruction of all framebuffers through RAII
 	size_t count = this->swapChainFramebuffers.size();
 	this->swapChainFramebuffers.clear();
+	this->offscreenFramebuffer.reset();
 
 	spdlog::info("Cleaned up {} framebuffers", count);
 	this->initialized = false;
@@ -64,14 +66,6 @@ void FramebufferManager::createSwapChainFramebuffers(
 		);
 	}
 
-	if (!depthImageView) {
-		throw VulkanException(
-			VK_ERROR_INITIALIZATION_FAILED,
-			"Cannot create framebuffers with null depth image view",
-			__FUNCTION__, __FILE__, __LINE__
-		);
-	}
-
 	/// Clean up any existing framebuffers first
 	/// This ensures we don't leak resources when recreating framebuffers
 	if (!this->swapChainFramebuffers.empty()) {
@@ -84,18 +78,18 @@ void FramebufferManager::createSwapChainFramebuffers(
 
 	/// Iterate through each swap chain image view and create a framebuffer for it
 	for (size_t i = 0; i < swapChainImageViews.size(); i++) {
-		/// We'll use two attachments for each framebuffer: color and depth
 		/// The color attachment comes from the swap chain, while the depth attachment is shared
-		std::array<VkImageView, 2> attachments = {
-			swapChainImageViews[i].get(),
-			depthImageView
-		};
+		/// Passes that only composite into the swap chain have no depth attachment
+		std::vector<VkImageView> attachments = {swapChainImageViews[i].get()};
+		if (depthImageView) {
+			attachments.push_back(depthImageView);
+		}
 
 		/// Create the framebuffer create info structure
 		VkFramebufferCreateInfo framebufferInfo{};
 		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 		framebufferInfo.renderPass = renderPass; /// The render pass this framebuffer is compatible with
-		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size()); /// Number of attachments (color and depth)
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size()); /// Number of attachments (color and optional depth)
 		framebufferInfo.pAttachments = attachments.data(); /// Pointer to the attachments array
 		framebufferInfo.width = width;
 		framebufferInfo.height = height;
@@ -111,8 +105,60 @@ void FramebufferManager::createSwapChainFramebuffers(
 		});
 	}
 
-	spdlog::info("Created {} framebuffers with color and depth attachments successfully",
-		this->swapChainFramebuffers.size());
+	spdlog::info("Created {} framebuffers with color{} attachments successfully",
+		this->swapChainFramebuffers.size(), depthImageView ? " and depth" : "");
+}
+
+void FramebufferManager::createOffscreenFramebuffer(
+	VkRenderPass renderPass,
+	VkImageView colorImageView,
+	VkImageView depthImageView,
+	uint32_t width,
+	uint32_t height) {
+
+	if (!renderPass || !colorImageView || !depthImageView) {
+		throw VulkanException(
+			VK_ERROR_INITIALIZATION_FAILED,
+			"Cannot create offscreen framebuffer with null render pass or attachments",
+			__FUNCTION__, __FILE__, __LINE__
+		);
+	}
+
+	std::array<VkImageView, 2> attachments = {
+		colorImageView,
+		depthImageView
+	};
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = renderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments = attachments.data();
+	framebufferInfo.width = width;
+	framebufferInfo.height = height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer;
+	VK_CHECK(vkCreateFramebuffer(this->device, &framebufferInfo, nullptr, &framebuffer));
+
+	/// Assigning releases the previous framebuffer, if any
+	this->offscreenFramebuffer = VulkanFramebufferHandle(framebuffer, [this](VkFramebuffer fb) {
+		vkDestroyFramebuffer(this->device, fb, nullptr);
+	});
+
+	spdlog::info("Created offscreen framebuffer with dimensions {}x{}", width, height);
+}
+
+VkFramebuffer FramebufferManager::getOffscreenFramebuffer() const {
+	if (!this->offscreenFramebuffer.isValid()) {
+		throw VulkanException(
+			VK_ERROR_INITIALIZATION_FAILED,
+			"No offscreen framebuffer has been created yet",
+			__FUNCTION__, __FILE__, __LINE__
+		);
+	}
+
+	return this->offscreenFramebuffer.get();
 }
 
 void FramebufferManager::recreateSwapChainFramebuffers(
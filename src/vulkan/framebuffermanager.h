@@ -34,7 +34,7 @@ public:
 	/// but a different color attachment from the swap chain
 	/// @param renderPass The render pass that these framebuffers will be compatible with
 	/// @param swapChainImageViews The image views to use as color attachments
-	/// @param depthImageView The image view to use as depth attachment
+	/// @param depthImageView The image view to use as depth attachment, or VK_NULL_HANDLE for color only
 	/// @param width Width of the framebuffers
 	/// @param height Height of the framebuffers
 	void createSwapChainFramebuffers(
@@ -58,6 +58,26 @@ public:
 		uint32_t width,
 		uint32_t height);
 
+	/// Create the framebuffer for offscreen scene rendering
+	/// The scene is rendered into this framebuffer and upscaled into the swap chain afterwards.
+	/// A single framebuffer is enough because we only have one frame in flight
+	/// @param renderPass The render pass this framebuffer will be compatible with
+	/// @param colorImageView The offscreen color target
+	/// @param depthImageView The depth buffer
+	/// @param width Width of the framebuffer
+	/// @param height Height of the framebuffer
+	void createOffscreenFramebuffer(
+		VkRenderPass renderPass,
+		VkImageView colorImageView,
+		VkImageView depthImageView,
+		uint32_t width,
+		uint32_t height);
+
+	/// Get the offscreen scene framebuffer
+	/// @return Handle to the offscreen framebuffer
+	/// @throws VulkanException if it hasn't been created
+	[[nodiscard]] VkFramebuffer getOffscreenFramebuffer() const;
+
 	/// Get a framebuffer by index
 	/// This provides access to framebuffers for command buffer recording
 	/// @param index The index of the framebuffer to retrieve
@@ -83,6 +103,9 @@ private:
 	/// We use VulkanFramebufferHandle for automatic resource management
 	std::vector<VulkanFramebufferHandle> swapChainFramebuffers;
 
+	/// Framebuffer for the offscreen scene pass
+	VulkanFramebufferHandle offscreenFramebuffer;
+
 	/// Track initialization state to prevent duplicate initialization
 	bool initialized{false};
 
@@ -0,0 +1,104 @@
+#include "gputimer.h"
+#include <spdlog/spdlog.h>
+#include <array>
+#include <vector>
+
+namespace lillugsi::vulkan {
+
+GpuTimer::GpuTimer(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex)
+	: device(device)
+	, physicalDevice(physicalDevice)
+	, queueFamilyIndex(queueFamilyIndex) {
+}
+
+bool GpuTimer::initialize() {
+	/// Not every queue family supports timestamps, a valid bit count of 0 means none
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(this->physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+	if (this->queueFamilyIndex >= queueFamilyCount
+		|| queueFamilies[this->queueFamilyIndex].timestampValidBits == 0) {
+		spdlog::warn("GPU timestamps are not supported on this queue, GPU timing disabled");
+		this->supported = false;
+		return false;
+	}
+
+	const uint32_t validBits = queueFamilies[this->queueFamilyIndex].timestampValidBits;
+	this->timestampMask = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(this->physicalDevice, &properties);
+	this->timestampPeriod = properties.limits.timestampPeriod;
+
+	VkQueryPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = 2; /// Start and end of the timed range
+
+	VkQueryPool pool;
+	VK_CHECK(vkCreateQueryPool(this->device, &poolInfo, nullptr, &pool));
+
+	this->queryPool = VulkanQueryPoolHandle(pool, [device = this->device](VkQueryPool qp) {
+		vkDestroyQueryPool(device, qp, nullptr);
+	});
+
+	this->supported = true;
+	spdlog::info("GPU timer initialized with {:.2f} ns per tick", this->timestampPeriod);
+	return true;
+}
+
+void GpuTimer::begin(VkCommandBuffer commandBuffer) {
+	if (!this->supported) {
+		return;
+	}
+
+	/// Queries must be reset before they can be written again
+	vkCmdResetQueryPool(commandBuffer, this->queryPool.get(), 0, 2);
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, this->queryPool.get(), 0);
+}
+
+void GpuTimer::end(VkCommandBuffer commandBuffer) {
+	if (!this->supported) {
+		return;
+	}
+
+	/// BOTTOM_OF_PIPE makes the timestamp wait for all earlier work to finish
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, this->queryPool.get(), 1);
+	this->hasPendingQuery = true;
+}
+
+std::optional<float> GpuTimer::getElapsedMilliseconds() {
+	if (!this->supported || !this->hasPendingQuery) {
+		return std::nullopt;
+	}
+
+	std::array<uint64_t, 2> timestamps{};
+	VkResult result = vkGetQueryPoolResults(
+		this->device,
+		this->queryPool.get(),
+		0, 2,
+		sizeof(timestamps),
+		timestamps.data(),
+		sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT);
+
+	/// VK_NOT_READY means the GPU hasn't reached the end timestamp yet
+	if (result != VK_SUCCESS) {
+		return std::nullopt;
+	}
+
+	this->hasPendingQuery = false;
+
+	const uint64_t start = timestamps[0] & this->timestampMask;
+	const uint64_t end = timestamps[1] & this->timestampMask;
+	if (end < start) {
+		return std::nullopt;
+	}
+
+	const double nanoseconds = static_cast<double>(end - start) * this->timestampPeriod;
+	return static_cast<float>(nanoseconds / 1.0e6);
+}
+
+} /// namespace lillugsi::vulkan
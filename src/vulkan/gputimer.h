@@ -0,0 +1,68 @@
+#pragma once
+
+#include "vulkan/vulkanwrappers.h"
+#include "vulkan/vulkanexception.h"
+#include <vulkan/vulkan.h>
+#include <optional>
+
+namespace lillugsi::vulkan {
+
+/// GpuTimer measures how long the GPU spends on a range of commands
+/// It writes a timestamp query at the start and end of the range and converts
+/// the difference to milliseconds once the GPU has finished.
+/// CPU-side frame times include vsync waits and present blocking, so they can't
+/// tell us if the GPU is the bottleneck; these timestamps can
+class GpuTimer {
+public:
+	/// Constructor
+	/// @param device The logical device to create the query pool on
+	/// @param physicalDevice The physical device, used for timestamp precision
+	/// @param queueFamilyIndex Queue family the timed commands are submitted to
+	GpuTimer(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamilyIndex);
+
+	/// Destructor
+	~GpuTimer() = default;
+
+	/// Create the query pool
+	/// @return True if the queue family supports timestamps, false otherwise
+	[[nodiscard]] bool initialize();
+
+	/// Check if GPU timing is available
+	/// @return True if timestamps can be written on this queue family
+	[[nodiscard]] bool isSupported() const { return this->supported; }
+
+	/// Reset the queries and write the start timestamp
+	/// Must be recorded outside of a render pass
+	/// @param commandBuffer The command buffer being recorded
+	void begin(VkCommandBuffer commandBuffer);
+
+	/// Write the end timestamp once all previous commands have completed
+	/// @param commandBuffer The command buffer being recorded
+	void end(VkCommandBuffer commandBuffer);
+
+	/// Read the duration of the last begin/end range
+	/// This doesn't wait; call it after the frame's fence has signaled
+	/// @return GPU time in milliseconds, or nothing if no result is available
+	[[nodiscard]] std::optional<float> getElapsedMilliseconds();
+
+private:
+	VkDevice device;
+	VkPhysicalDevice physicalDevice;
+	uint32_t queueFamilyIndex;
+
+	/// Pool with the start and end query
+	VulkanQueryPoolHandle queryPool;
+
+	/// Nanoseconds per timestamp tick
+	float timestampPeriod{1.0f};
+
+	/// Mask of the valid timestamp bits, the rest may hold garbage
+	uint64_t timestampMask{0};
+
+	bool supported{false};
+
+	/// True while a written range hasn't been read back yet
+	bool hasPendingQuery{false};
+};
+
+} /// namespace lillugsi::vulkan
@@ -26,7 +26,8 @@ public:
 	            uint32_t indexCount,
 	            VkIndexType indexType)
 		: Buffer(device, memory, std::move(buffer), size,
-		         VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		         VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		         | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
 		  , indexCount(indexCount)
 		  , indexType(indexType)
 	{
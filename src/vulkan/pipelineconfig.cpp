@@ -3,6 +3,7 @@
 #include "vulkan/vulkanwrappers.h"
 #include "vulkan/vulkanformatters.h"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <functional>
 #include <vulkan/shadermodule.h>
 
@@ -98,6 +99,15 @@ void PipelineConfig::addShaderStage(VkShaderStageFlagBits stage,
 		);
 	}
 
+	/// A stage that is already set is replaced
+	/// Variants start from a material's configuration and swap single stages
+	for (auto& shaderStage : this->shaderStages) {
+		if (shaderStage.stage == stage) {
+			shaderStage = {stage, shaderPath, entryPoint};
+			return;
+		}
+	}
+
 	/// Add shader stage to configuration
 	this->shaderStages.push_back({stage, shaderPath, entryPoint});
 	spdlog::debug("Added shader stage {} with path: {}", stage, shaderPath);
@@ -114,6 +124,15 @@ void PipelineConfig::setVertexInput(
 	spdlog::debug("Set vertex input with {} attributes", attributeDescriptions.size());
 }
 
+void PipelineConfig::setInstanceInput(
+	const VkVertexInputBindingDescription& bindingDescription,
+	const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions) {
+	this->instanceBindingDescription = bindingDescription;
+	this->instanceAttributeDescriptions = attributeDescriptions;
+
+	spdlog::debug("Set instance input with {} attributes", attributeDescriptions.size());
+}
+
 void PipelineConfig::setInputAssembly(VkPrimitiveTopology topology, bool primitiveRestart) {
 	/// Update input assembly configuration
 	this->inputAssembly.topology = topology;
@@ -146,6 +165,43 @@ void PipelineConfig::setDepthState(bool enableDepthTest,
 		enableDepthTest, enableDepthWrite, compareOp);
 }
 
+void PipelineConfig::setDepthBias(bool enableDepthBias,
+	float constantFactor, float slopeFactor) {
+	this->rasterization.depthBiasEnable = enableDepthBias ? VK_TRUE : VK_FALSE;
+	this->rasterization.depthBiasConstantFactor = constantFactor;
+	this->rasterization.depthBiasSlopeFactor = slopeFactor;
+	this->rasterization.depthBiasClamp = 0.0f;
+
+	spdlog::debug("Set depth bias - enabled: {}, constant: {}, slope: {}",
+		enableDepthBias, constantFactor, slopeFactor);
+}
+
+void PipelineConfig::setColorAttachmentCount(uint32_t count) {
+	/// The blend state must describe exactly the color attachments of the subpass
+	this->colorBlend.attachmentCount = std::min(count, 1u);
+
+	spdlog::debug("Set color attachment count: {}", this->colorBlend.attachmentCount);
+}
+
+void PipelineConfig::setSpecializationConstant(uint32_t constantId, uint32_t value) {
+	/// Setting a constant again replaces its value
+	for (const auto& entry : this->specializationEntries) {
+		if (entry.constantID == constantId) {
+			this->specializationData[entry.offset / sizeof(uint32_t)] = value;
+			return;
+		}
+	}
+
+	VkSpecializationMapEntry entry{};
+	entry.constantID = constantId;
+	entry.offset = static_cast<uint32_t>(this->specializationData.size() * sizeof(uint32_t));
+	entry.size = sizeof(uint32_t);
+	this->specializationEntries.push_back(entry);
+	this->specializationData.push_back(value);
+
+	spdlog::debug("Set specialization constant {} to {}", constantId, value);
+}
+
 void PipelineConfig::setBlendState(bool enableBlending,
 	VkBlendFactor srcColorBlendFactor,
 	VkBlendFactor dstColorBlendFactor,
@@ -180,6 +236,8 @@ size_t PipelineConfig::hash() const {
 	/// Hash vertex input state
 	hash ^= std::hash<uint32_t>{}(this->vertexBindingDescription.binding);
 	hash ^= std::hash<uint32_t>{}(this->vertexBindingDescription.stride);
+	hash ^= std::hash<uint32_t>{}(this->instanceBindingDescription.stride);
+	hash ^= std::hash<size_t>{}(this->instanceAttributeDescriptions.size());
 
 	/// Hash other pipeline states
 	hash ^= std::hash<uint32_t>{}(static_cast<uint32_t>(this->inputAssembly.topology));
@@ -187,6 +245,14 @@ size_t PipelineConfig::hash() const {
 	hash ^= std::hash<uint32_t>{}(static_cast<uint32_t>(this->rasterization.cullMode));
 	hash ^= std::hash<uint32_t>{}(static_cast<uint32_t>(this->depthStencil.depthCompareOp));
 	hash ^= std::hash<uint32_t>{}(this->colorBlendAttachment.blendEnable);
+	hash ^= std::hash<uint32_t>{}(this->colorBlend.attachmentCount);
+	hash ^= std::hash<uint32_t>{}(this->rasterization.depthBiasEnable);
+
+	/// Every specialized variant is a pipeline of its own
+	for (size_t i = 0; i < this->specializationEntries.size(); ++i) {
+		hash ^= std::hash<uint32_t>{}(this->specializationEntries[i].constantID);
+		hash = hash * 0x01000193 ^ std::hash<uint32_t>{}(this->specializationData[i]);
+	}
 
 	return hash;
 }
@@ -194,13 +260,10 @@ size_t PipelineConfig::hash() const {
 VkGraphicsPipelineCreateInfo PipelineConfig::getCreateInfo(
 	VkDevice device, VkRenderPass renderPass, VkPipelineLayout layout) {
 
-	/// Update vertex input configuration
-	/// We need to update this here because the descriptions might have changed
-	this->vertexInputInfo.vertexBindingDescriptionCount = 1;
-	this->vertexInputInfo.pVertexBindingDescriptions = &this->vertexBindingDescription;
-	this->vertexInputInfo.vertexAttributeDescriptionCount =
-		static_cast<uint32_t>(this->vertexAttributeDescriptions.size());
-	this->vertexInputInfo.pVertexAttributeDescriptions = this->vertexAttributeDescriptions.data();
+	this->specializationInfo.mapEntryCount = static_cast<uint32_t>(this->specializationEntries.size());
+	this->specializationInfo.pMapEntries = this->specializationEntries.data();
+	this->specializationInfo.dataSize = this->specializationData.size() * sizeof(uint32_t);
+	this->specializationInfo.pData = this->specializationData.data();
 
 	/// Convert shader stages to Vulkan format
 	this->shaderStageInfos.reserve(this->shaderStages.size());
@@ -230,6 +293,9 @@ VkGraphicsPipelineCreateInfo PipelineConfig::getCreateInfo(
 		shaderStageInfo.stage = stage.stage;
 		shaderStageInfo.module = shaderModule;
 		shaderStageInfo.pName = stage.entryPoint;
+		shaderStageInfo.pSpecializationInfo = this->specializationEntries.empty()
+			? nullptr
+			: &this->specializationInfo;
 		this->shaderStageInfos.push_back(shaderStageInfo);
 
 		spdlog::trace("Created shader stage for {}", stage.shaderPath);
@@ -249,12 +315,29 @@ VkGraphicsPipelineCreateInfo PipelineConfig::getCreateInfo(
 	dynamicState.pDynamicStates = dynamicStates.data();
 
 	/// Set up vertex input state
+	/// Pipelines without attributes, like fullscreen passes that build their vertices
+	/// from gl_VertexIndex, don't get a vertex buffer binding at all
+	/// The descriptions are assembled here because they might have changed since the last call
+	this->bindingDescriptions.clear();
+	this->attributeDescriptions = this->vertexAttributeDescriptions;
+	if (!this->vertexAttributeDescriptions.empty()) {
+		this->bindingDescriptions.push_back(this->vertexBindingDescription);
+	}
+	if (!this->instanceAttributeDescriptions.empty()) {
+		this->bindingDescriptions.push_back(this->instanceBindingDescription);
+		this->attributeDescriptions.insert(this->attributeDescriptions.end(),
+			this->instanceAttributeDescriptions.begin(),
+			this->instanceAttributeDescriptions.end());
+	}
+
 	this->vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	this->vertexInputInfo.vertexBindingDescriptionCount = 1;
-	this->vertexInputInfo.pVertexBindingDescriptions = &this->vertexBindingDescription;
+	this->vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(this->bindingDescriptions.size());
+	this->vertexInputInfo.pVertexBindingDescriptions = this->bindingDescriptions.empty()
+		? nullptr
+		: this->bindingDescriptions.data();
 	this->vertexInputInfo.vertexAttributeDescriptionCount =
-		static_cast<uint32_t>(this->vertexAttributeDescriptions.size());
-	this->vertexInputInfo.pVertexAttributeDescriptions = this->vertexAttributeDescriptions.data();
+		static_cast<uint32_t>(this->attributeDescriptions.size());
+	this->vertexInputInfo.pVertexAttributeDescriptions = this->attributeDescriptions.data();
 
 	/// Create viewport state
 	/// We use dynamic viewport and scissor, so we only need to specify the count
@@ -48,7 +48,7 @@ public:
 	/// Create a new pipeline configuration with default settings
 	PipelineConfig();
 
-	/// Add a shader stage to the pipeline
+	/// Add a shader stage to the pipeline, replacing a stage of the same type
 	/// @param stage The type of shader stage (vertex, fragment, etc.)
 	/// @param shaderPath Path to the shader file
 	/// @param entryPoint Name of the entry point function
@@ -61,6 +61,14 @@ public:
 	void setVertexInput(const VkVertexInputBindingDescription& bindingDescription,
 		const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
 
+	/// Set a second vertex buffer binding that advances per instance
+	/// Instanced draws read these attributes once per instance, which lets one
+	/// shared mesh be drawn many times with different per-instance parameters
+	/// @param bindingDescription Binding with VK_VERTEX_INPUT_RATE_INSTANCE, after the vertex binding
+	/// @param attributeDescriptions Attributes of the binding, at locations after the vertex attributes
+	void setInstanceInput(const VkVertexInputBindingDescription& bindingDescription,
+		const std::vector<VkVertexInputAttributeDescription>& attributeDescriptions);
+
 	/// Set input assembly state
 	/// @param topology The primitive topology to use
 	/// @param primitiveRestart Whether to enable primitive restart
@@ -85,6 +93,27 @@ public:
 		bool enableDepthWrite,
 		VkCompareOp compareOp);
 
+	/// Set depth bias
+	/// Shadow map passes push their depth away from the light to avoid self shadowing
+	/// @param enableDepthBias Whether to enable depth bias
+	/// @param constantFactor Constant depth offset in units of the depth format's precision
+	/// @param slopeFactor Offset scaled by the polygon's depth slope
+	void setDepthBias(bool enableDepthBias,
+		float constantFactor,
+		float slopeFactor);
+
+	/// Set the number of color attachments the pipeline writes
+	/// Depth-only passes have no color attachments and set this to 0
+	/// @param count Number of color attachments in the subpass, 0 or 1
+	void setColorAttachmentCount(uint32_t count);
+
+	/// Set a specialization constant of all shader stages
+	/// Specialized pipelines let the shader compiler drop branches that are known per variant,
+	/// instead of branching on uniforms at runtime. Stages without the constant ignore it
+	/// @param constantId The constant_id of the constant in the shaders
+	/// @param value Value of the constant, 32 bit scalar constants only
+	void setSpecializationConstant(uint32_t constantId, uint32_t value);
+
 	/// Set blend state
 	/// @param enableBlending Whether to enable blending
 	/// @param srcColorBlendFactor Source color blend factor
@@ -122,6 +151,12 @@ private:
 	/// References shader modules and must stay alive until pipeline creation
 	std::vector<VkPipelineShaderStageCreateInfo> shaderStageInfos;
 
+	/// Specialization constants shared by all shader stages
+	/// The info points into the entries and data and is refreshed in getCreateInfo
+	std::vector<VkSpecializationMapEntry> specializationEntries;
+	std::vector<uint32_t> specializationData;
+	VkSpecializationInfo specializationInfo{};
+
 	/// Shader modules for pipeline creation
 	/// These must stay alive until pipeline creation is complete
 	/// as they are referenced by shaderStageInfos
@@ -135,6 +170,15 @@ private:
 	std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions;
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 
+	/// Optional per-instance binding
+	VkVertexInputBindingDescription instanceBindingDescription{};
+	std::vector<VkVertexInputAttributeDescription> instanceAttributeDescriptions;
+
+	/// Bindings and attributes of both inputs, assembled in getCreateInfo
+	/// The vertex input info points into these
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+
 	/// Dynamic state for viewport and scissor
 	/// These need to be dynamic for window resizing
 	std::array<VkDynamicState, 2> dynamicStates;
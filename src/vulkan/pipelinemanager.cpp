@@ -1,6 +1,8 @@
 #include "pipelinemanager.h"
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
 
 namespace lillugsi::vulkan {
 
@@ -25,9 +27,103 @@ std::shared_ptr<VulkanPipelineHandle> PipelineManager::createPipeline(
 	/// Get or create pipeline using configuration
 	auto cacheEntry = this->getOrCreatePipeline(config, material);
 
+	/// Build the reduced LODs as specializations of the same configuration
+	/// Levels the material doesn't provide fall back to its cheapest variant
+	auto& materialPipeline = this->materialPipelines[material.getName()];
+	const uint32_t lodCount = std::clamp(material.getLodCount(), 1u, rendering::MaterialLodCount);
+	materialPipeline.lodPipelines[0] = cacheEntry.pipeline;
+	for (uint32_t lod = 1; lod < rendering::MaterialLodCount; ++lod) {
+		if (lod < lodCount) {
+			auto lodConfig = material.getPipelineConfig();
+			lodConfig.setSpecializationConstant(rendering::MaterialLodConstantId, lod);
+			materialPipeline.lodPipelines[lod] = this->getOrCreateVariantPipeline(
+				lodConfig, cacheEntry.layout->get());
+		} else {
+			materialPipeline.lodPipelines[lod] = materialPipeline.lodPipelines[lod - 1];
+		}
+	}
+
+	/// Quantized meshes get the same levels with their vertex layout
+	/// The vertex shader dequantizes when the format constant says so
+	if (material.supportsQuantizedVertices()) {
+		for (uint32_t lod = 0; lod < rendering::MaterialLodCount; ++lod) {
+			if (lod < lodCount) {
+				auto quantizedConfig = material.getPipelineConfig();
+				quantizedConfig.setVertexInput(
+					rendering::QuantizedVertex::getBindingDescription(),
+					rendering::QuantizedVertex::getAttributeDescriptions());
+				quantizedConfig.setSpecializationConstant(rendering::MaterialLodConstantId, lod);
+				quantizedConfig.setSpecializationConstant(rendering::VertexFormatConstantId,
+					static_cast<uint32_t>(rendering::VertexFormat::Quantized));
+				materialPipeline.quantizedPipelines[lod] = this->getOrCreateVariantPipeline(
+					quantizedConfig, cacheEntry.layout->get());
+			} else {
+				materialPipeline.quantizedPipelines[lod] = materialPipeline.quantizedPipelines[lod - 1];
+			}
+		}
+	}
+
+	/// Instanced meshes swap in the instanced vertex shader and read the transforms
+	/// from a second binding, for both vertex layouts the material draws
+	const std::string instancedVertexShaderPath = material.getInstancedVertexShaderPath();
+	if (!instancedVertexShaderPath.empty()) {
+		for (uint32_t lod = 0; lod < rendering::MaterialLodCount; ++lod) {
+			if (lod >= lodCount) {
+				materialPipeline.instancedPipelines[lod] = materialPipeline.instancedPipelines[lod - 1];
+				materialPipeline.quantizedInstancedPipelines[lod] =
+					materialPipeline.quantizedInstancedPipelines[lod - 1];
+				continue;
+			}
+
+			auto instancedConfig = material.getPipelineConfig();
+			instancedConfig.addShaderStage(VK_SHADER_STAGE_VERTEX_BIT, instancedVertexShaderPath);
+			instancedConfig.setInstanceInput(
+				rendering::InstanceTransform::getBindingDescription(),
+				rendering::InstanceTransform::getAttributeDescriptions());
+			instancedConfig.setSpecializationConstant(rendering::MaterialLodConstantId, lod);
+			materialPipeline.instancedPipelines[lod] = this->getOrCreateVariantPipeline(
+				instancedConfig, cacheEntry.layout->get());
+
+			if (material.supportsQuantizedVertices()) {
+				instancedConfig.setVertexInput(
+					rendering::QuantizedVertex::getBindingDescription(),
+					rendering::QuantizedVertex::getAttributeDescriptions());
+				instancedConfig.setSpecializationConstant(rendering::VertexFormatConstantId,
+					static_cast<uint32_t>(rendering::VertexFormat::Quantized));
+				materialPipeline.quantizedInstancedPipelines[lod] = this->getOrCreateVariantPipeline(
+					instancedConfig, cacheEntry.layout->get());
+			}
+		}
+	}
+
 	return cacheEntry.pipeline;
 }
 
+std::shared_ptr<VulkanPipelineHandle> PipelineManager::getOrCreateVariantPipeline(
+	PipelineConfig& config, VkPipelineLayout layout) {
+	const size_t configHash = config.hash();
+	auto it = this->variantPipelinesByConfig.find(configHash);
+	if (it != this->variantPipelinesByConfig.end()) {
+		return it->second;
+	}
+
+	/// Pipeline layouts with identically defined set layouts are compatible,
+	/// so the first material's layout serves every material sharing the variant
+	auto createInfo = config.getCreateInfo(this->device, this->renderPass, layout);
+
+	VkPipeline pipeline;
+	VK_CHECK(vkCreateGraphicsPipelines(
+		this->device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &pipeline));
+
+	auto handle = std::make_shared<VulkanPipelineHandle>(pipeline, [device = this->device](VkPipeline p) {
+		vkDestroyPipeline(device, p, nullptr);
+	});
+	this->variantPipelinesByConfig[configHash] = handle;
+
+	spdlog::debug("Created material variant pipeline with hash {:#x}", configHash);
+	return handle;
+}
+
 std::shared_ptr<ShaderProgram> PipelineManager::createShaderProgram(
 	const rendering::ShaderPaths& paths) {
 	/// Create a new shader program from the given paths
@@ -92,6 +188,29 @@ std::shared_ptr<VulkanPipelineHandle> PipelineManager::getPipeline(
 	// return this->fallbackPipeline; /// TODO
 }
 
+std::shared_ptr<VulkanPipelineHandle> PipelineManager::getPipeline(
+	const std::string& name, rendering::MaterialLod lod, rendering::VertexFormat format, bool instanced) {
+	auto it = this->materialPipelines.find(name);
+	if (it == this->materialPipelines.end()) {
+		return instanced ? nullptr : this->getPipeline(name);
+	}
+
+	/// Instanced draws need the instance binding, no other pipeline reads it
+	if (instanced) {
+		return format == rendering::VertexFormat::Quantized
+			? it->second.quantizedInstancedPipelines[static_cast<uint32_t>(lod)]
+			: it->second.instancedPipelines[static_cast<uint32_t>(lod)];
+	}
+
+	/// There is nothing to fall back to, a standard pipeline would misread the vertices
+	if (format == rendering::VertexFormat::Quantized) {
+		return it->second.quantizedPipelines[static_cast<uint32_t>(lod)];
+	}
+
+	const auto& variant = it->second.lodPipelines[static_cast<uint32_t>(lod)];
+	return variant ? variant : it->second.pipeline;
+}
+
 std::shared_ptr<VulkanPipelineLayoutHandle> PipelineManager::getPipelineLayout(
 	const std::string& name) const {
 	auto it = this->materialPipelines.find(name);
@@ -111,7 +230,8 @@ void PipelineManager::createGlobalDescriptorLayouts() {
 		cameraBinding.binding = 0;
 		cameraBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
 		cameraBinding.descriptorCount = 1;
-		cameraBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		/// Compute passes reconstruct positions with the camera matrices
+		cameraBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 		cameraBinding.pImmutableSamplers = nullptr;
 
 		VkDescriptorSetLayoutCreateInfo layoutInfo{};
@@ -138,19 +258,32 @@ void PipelineManager::createGlobalDescriptorLayouts() {
 	}
 
 	/// Create light descriptor set layout (set = 1)
-	/// This layout describes the bindings for light data
+	/// This layout describes the bindings for clustered light data:
+	/// cluster parameters, all lights, light count per cluster and light indices per cluster,
+	/// the shadow parameters and the cascaded shadow map, then the environment parameters,
+	/// the prefiltered environment and the BRDF lookup table
+	/// The culling compute pass writes the cluster lists, shading reads everything
 	{
-		VkDescriptorSetLayoutBinding lightBinding{};
-		lightBinding.binding = 0;
-		lightBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		lightBinding.descriptorCount = 1;
-		lightBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-		lightBinding.pImmutableSamplers = nullptr;
+		std::array<VkDescriptorSetLayoutBinding, 9> lightBindings{};
+		for (uint32_t i = 0; i < lightBindings.size(); ++i) {
+			lightBindings[i].binding = i;
+			if (i == 0 || i == 4 || i == 6) {
+				lightBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			} else if (i == 5 || i == 7 || i == 8) {
+				lightBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+			} else {
+				lightBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			}
+			lightBindings[i].descriptorCount = 1;
+			lightBindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT
+				| VK_SHADER_STAGE_COMPUTE_BIT;
+			lightBindings[i].pImmutableSamplers = nullptr;
+		}
 
 		VkDescriptorSetLayoutCreateInfo layoutInfo{};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = 1;
-		layoutInfo.pBindings = &lightBinding;
+		layoutInfo.bindingCount = static_cast<uint32_t>(lightBindings.size());
+		layoutInfo.pBindings = lightBindings.data();
 
 		VkDescriptorSetLayout layout;
 		VK_CHECK(vkCreateDescriptorSetLayout(
@@ -200,10 +333,11 @@ PipelineManager::MaterialPipeline PipelineManager::getOrCreatePipeline(
 		layoutInfo.pSetLayouts = descriptorSetLayouts.data();
 
 		/// Configure push constant for model matrix
+		/// The range also covers the dequantization, the quantized variants share the layout
 		VkPushConstantRange pushConstantRange{};
 		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 		pushConstantRange.offset = 0;
-		pushConstantRange.size = sizeof(glm::mat4); /// Model matrix size
+		pushConstantRange.size = sizeof(rendering::MaterialPushConstants);
 		layoutInfo.pushConstantRangeCount = 1;
 		layoutInfo.pPushConstantRanges = &pushConstantRange;
 
@@ -276,6 +410,7 @@ void PipelineManager::cleanup() {
 	/// Clean up in reverse order of creation
 	/// Clean up material-specific handles first
 	this->materialPipelines.clear();
+	this->variantPipelinesByConfig.clear();
 
 	/// Clean up shared pipeline resources
 	for (const auto& [hash, cache] : this->pipelinesByConfig)
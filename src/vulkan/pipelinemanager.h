@@ -5,6 +5,7 @@
 #include "vulkan/shaderprogram.h"
 #include "rendering/material.h"
 
+#include <array>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -66,6 +67,21 @@ class PipelineManager {
 	[[nodiscard]] std::shared_ptr<VulkanPipelineHandle> getPipeline(
 		const std::string& name);
 
+	/// Get the pipeline of a material LOD
+	/// Materials with fewer levels return their closest available variant
+	/// All variants of a material are compatible with its pipeline layout
+	/// @param name The name of the material
+	/// @param lod The requested level
+	/// @param format Layout of the vertices to draw
+	/// @param instanced Whether the draw reads per-instance transforms
+	/// @return A shared pointer to the pipeline handle, or nullptr if not found
+	///         or if the material can't draw the vertex format or instances
+	[[nodiscard]] std::shared_ptr<VulkanPipelineHandle> getPipeline(
+		const std::string& name,
+		rendering::MaterialLod lod,
+		rendering::VertexFormat format = rendering::VertexFormat::Standard,
+		bool instanced = false);
+
 	/// Get a pipeline layout by material name
 	/// @param name The name of the pipeline layout to retrieve
 	/// @return A shared pointer to the requested pipeline layout handle
@@ -134,6 +150,16 @@ private:
 	struct MaterialPipeline {
 		std::shared_ptr<VulkanPipelineHandle> pipeline;
 		std::shared_ptr<VulkanPipelineLayoutHandle> layout;
+
+		/// One pipeline per material LOD, the first is the pipeline above
+		std::array<std::shared_ptr<VulkanPipelineHandle>, rendering::MaterialLodCount> lodPipelines;
+
+		/// The same levels for QuantizedVertex meshes, empty if the material doesn't support them
+		std::array<std::shared_ptr<VulkanPipelineHandle>, rendering::MaterialLodCount> quantizedPipelines;
+
+		/// Both sets again for instanced draws, empty if the material has no instanced vertex shader
+		std::array<std::shared_ptr<VulkanPipelineHandle>, rendering::MaterialLodCount> instancedPipelines;
+		std::array<std::shared_ptr<VulkanPipelineHandle>, rendering::MaterialLodCount> quantizedInstancedPipelines;
 	};
 
 	/// Get or create pipeline for a material
@@ -144,6 +170,15 @@ private:
 		PipelineConfig& config,
 		const rendering::Material& material);
 
+	/// Get or create a variant of a material's pipeline
+	/// Variants are reduced material LODs and the pipelines for quantized vertices
+	/// @param config Pipeline configuration with the variant's specialization applied
+	/// @param layout Layout of the material's full pipeline, the variants share it
+	/// @return The variant pipeline, shared with all materials of the same configuration
+	[[nodiscard]] std::shared_ptr<VulkanPipelineHandle> getOrCreateVariantPipeline(
+		PipelineConfig& config,
+		VkPipelineLayout layout);
+
 	VkDevice device;
 	VkRenderPass renderPass;
 
@@ -151,6 +186,11 @@ private:
 	/// Multiple materials with the same configuration share these pipelines
 	std::unordered_map<size_t, PipelineCache> pipelinesByConfig;
 
+	/// Variant pipelines by configuration
+	/// Variants only differ in specialization constants and vertex input, so materials
+	/// sharing shaders and states share their variants too
+	std::unordered_map<size_t, std::shared_ptr<VulkanPipelineHandle>> variantPipelinesByConfig;
+
 	/// Material-specific pipeline handles
 	/// Each material gets its own entry even when sharing pipelines
 	std::unordered_map<std::string, MaterialPipeline> materialPipelines;
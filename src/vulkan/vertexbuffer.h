@@ -26,7 +26,8 @@ public:
 	             uint32_t vertexCount,
 	             uint32_t stride)
 		: Buffer(device, memory, std::move(buffer), size,
-		         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		         VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+		         | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
 		  , vertexCount(vertexCount)
 		  , stride(stride)
 	{
@@ -144,12 +144,12 @@ void VulkanContext::createLogicalDevice() {
 
 }
 
-void VulkanContext::createSwapChain(uint32_t width, uint32_t height) {
+void VulkanContext::createSwapChain(uint32_t width, uint32_t height, VkPresentModeKHR presentMode) {
 	this->vulkanSwapchain = std::make_unique<VulkanSwapchain>();
 
 	/// Initialize the swap chain with the current window dimensions
 	/// The swap chain is crucial for presenting rendered images to the screen
-	this->vulkanSwapchain->initialize(this->physicalDevice, this->vulkanDevice->getDevice(), this->surface, width, height);
+	this->vulkanSwapchain->initialize(this->physicalDevice, this->vulkanDevice->getDevice(), this->surface, width, height, presentMode);
 
 	spdlog::info("Swap chain created successfully");
 }
@@ -51,7 +51,9 @@ public:
 	VkPhysicalDevice getPhysicalDevice() const { return this->physicalDevice; }
 
 	/// This method initializes the swap chain for rendering
-	void createSwapChain(uint32_t width, uint32_t height);
+	/// @param presentMode Preferred present mode, FIFO is used if the surface lacks it
+	void createSwapChain(uint32_t width, uint32_t height,
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR);
 
 
 private:
@@ -240,4 +240,23 @@ struct fmt::formatter<lillugsi::rendering::Texture::WrapMode> : formatter<string
 		}
 		return formatter<string_view>::format(name, ctx);
 	}
-};
\ No newline at end of file
+};
+/// Custom formatter for VkPresentModeKHR
+template <>
+struct fmt::formatter<VkPresentModeKHR> : formatter<string_view>
+{
+	template <typename FormatContext>
+	auto format(VkPresentModeKHR mode, FormatContext& ctx)
+	{
+		string_view name = "Unknown";
+		switch (mode)
+		{
+		case VK_PRESENT_MODE_IMMEDIATE_KHR: name = "IMMEDIATE"; break;
+		case VK_PRESENT_MODE_MAILBOX_KHR: name = "MAILBOX"; break;
+		case VK_PRESENT_MODE_FIFO_KHR: name = "FIFO"; break;
+		case VK_PRESENT_MODE_FIFO_RELAXED_KHR: name = "FIFO_RELAXED"; break;
+		default: break;
+		}
+		return formatter<string_view>::format(name, ctx);
+	}
+};
@@ -1,14 +1,17 @@
 #include "vulkanswapchain.h"
+#include "vulkanformatters.h"
 #include <spdlog/spdlog.h>
 #include <algorithm>
 
 namespace lillugsi::vulkan {
 VulkanSwapchain::VulkanSwapchain()
 	: swapChainImageFormat(VK_FORMAT_UNDEFINED)
-	  , swapChainExtent{0, 0} {
+	  , swapChainExtent{0, 0}
+	  , presentMode(VK_PRESENT_MODE_FIFO_KHR) {
 }
 
-void VulkanSwapchain::initialize(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, uint32_t width, uint32_t height) {
+void VulkanSwapchain::initialize(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, uint32_t width, uint32_t height,
+	VkPresentModeKHR preferredPresentMode) {
 	/// Query swap chain support
 	VkSurfaceCapabilitiesKHR capabilities;
 	VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities));
@@ -31,7 +34,7 @@ void VulkanSwapchain::initialize(VkPhysicalDevice physicalDevice, VkDevice devic
 
 	/// Choose swap chain settings
 	VkSurfaceFormatKHR surfaceFormat = this->chooseSurfaceFormat(formats);
-	VkPresentModeKHR presentMode = this->choosePresentMode(presentModes);
+	VkPresentModeKHR presentMode = this->choosePresentMode(presentModes, preferredPresentMode);
 	VkExtent2D extent = this->chooseSwapExtent(capabilities, width, height);
 
 	/// Determine the number of images in the swap chain
@@ -69,11 +72,13 @@ void VulkanSwapchain::initialize(VkPhysicalDevice physicalDevice, VkDevice devic
 
 	this->swapChainImageFormat = surfaceFormat.format;
 	this->swapChainExtent = extent;
+	this->presentMode = presentMode;
+	this->supportedPresentModes = std::move(presentModes);
 
 	/// Create image views
 	this->createImageViews(device);
 
-	spdlog::info("Swap chain initialized successfully");
+	spdlog::info("Swap chain initialized successfully with present mode {}", this->presentMode);
 }
 
 VkSurfaceFormatKHR VulkanSwapchain::chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
@@ -88,14 +93,21 @@ VkSurfaceFormatKHR VulkanSwapchain::chooseSurfaceFormat(const std::vector<VkSurf
 	return availableFormats[0];
 }
 
-VkPresentModeKHR VulkanSwapchain::choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
-	/// Prefer VK_PRESENT_MODE_MAILBOX_KHR for triple buffering
+VkPresentModeKHR VulkanSwapchain::choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes,
+	VkPresentModeKHR preferredPresentMode) {
+	/// Use the requested mode if the surface offers it
+	/// MAILBOX gives low latency without tearing, IMMEDIATE the lowest latency with tearing,
+	/// FIFO_RELAXED tears only when a frame misses vblank
 	for (const auto& availablePresentMode : availablePresentModes) {
-		if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+		if (availablePresentMode == preferredPresentMode) {
 			return availablePresentMode;
 		}
 	}
 
+	if (preferredPresentMode != VK_PRESENT_MODE_FIFO_KHR) {
+		spdlog::warn("Present mode {} not supported, falling back to FIFO", preferredPresentMode);
+	}
+
 	/// VK_PRESENT_MODE_FIFO_KHR is always available
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
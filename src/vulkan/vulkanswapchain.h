@@ -11,7 +11,11 @@ public:
 	~VulkanSwapchain() = default;
 
 	/// Initialize the swap chain
-	void initialize(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, uint32_t width, uint32_t height);
+	/// The preferred present mode is used when the surface supports it,
+	/// otherwise we fall back to FIFO, which every Vulkan implementation must support
+	/// @param preferredPresentMode Present mode to use if available
+	void initialize(VkPhysicalDevice physicalDevice, VkDevice device, VkSurfaceKHR surface, uint32_t width, uint32_t height,
+		VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR);
 
 	/// Get the swap chain handle
 	VkSwapchainKHR getSwapChain() const { return this->swapChainHandle.get(); }
@@ -28,6 +32,13 @@ public:
 	/// Get the swap chain extent
 	VkExtent2D getSwapChainExtent() const { return this->swapChainExtent; }
 
+	/// Get the present mode the swap chain was actually created with
+	VkPresentModeKHR getPresentMode() const { return this->presentMode; }
+
+	/// Get all present modes the surface supports
+	/// We keep these so present mode switches can be validated without querying the surface again
+	const std::vector<VkPresentModeKHR>& getSupportedPresentModes() const { return this->supportedPresentModes; }
+
 private:
 	/// Wrapper for the Vulkan swap chain
 	VulkanSwapchainHandle swapChainHandle;
@@ -44,11 +55,16 @@ private:
 	/// Swap chain extent
 	VkExtent2D swapChainExtent;
 
+	/// Present mode in use and all modes the surface offers
+	VkPresentModeKHR presentMode;
+	std::vector<VkPresentModeKHR> supportedPresentModes;
+
 	/// Choose the surface format for the swap chain
 	VkSurfaceFormatKHR chooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 
 	/// Choose the presentation mode for the swap chain
-	VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+	VkPresentModeKHR choosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes,
+		VkPresentModeKHR preferredPresentMode);
 
 	/// Choose the swap extent (resolution) of the swap chain
 	VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, uint32_t width, uint32_t height);
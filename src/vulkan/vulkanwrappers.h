@@ -62,6 +62,9 @@ using VulkanDescriptorPoolHandle = VulkanHandle<VkDescriptorPool, std::function<
 /// Type alias for VkDeviceMemory wrapper
 using VulkanDeviceMemoryHandle = VulkanHandle<VkDeviceMemory, std::function<void(VkDeviceMemory)>>;
 
+/// Type alias for VkQueryPool wrapper
+using VulkanQueryPoolHandle = VulkanHandle<VkQueryPool, std::function<void(VkQueryPool)>>;
+
 /// Function to create a VkInstance with proper error handling
 VkResult createVulkanInstance(const VkInstanceCreateInfo* pCreateInfo, const VkAllocationCallbacks* pAllocator, VulkanInstanceHandle& instance);
 